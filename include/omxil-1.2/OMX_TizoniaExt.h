@@ -74,6 +74,8 @@
 #define OMX_TizoniaIndexParamAudioYoutubePlaylist    OMX_IndexVendorStartUnused + 18 /**< reference: OMX_TIZONIA_AUDIO_PARAM_YOUTUBEPLAYLISTTYPE */
 #define OMX_TizoniaIndexParamAudioDeezerSession      OMX_IndexVendorStartUnused + 19 /**< reference: OMX_TIZONIA_AUDIO_PARAM_DEEZERSESSIONTYPE */
 #define OMX_TizoniaIndexParamAudioDeezerPlaylist     OMX_IndexVendorStartUnused + 20 /**< reference: OMX_TIZONIA_AUDIO_PARAM_DEEZERPLAYLISTTYPE */
+#define OMX_TizoniaIndexConfigPerfCounters           OMX_IndexVendorStartUnused + 21 /**< reference: OMX_TIZONIA_CONFIG_PERFCOUNTERSTYPE */
+#define OMX_TizoniaIndexConfigNextContentURI         OMX_IndexVendorStartUnused + 22 /**< reference: OMX_PARAM_CONTENTURITYPE */
 
 /**
  * OMX_AUDIO_CODINGTYPE extensions
@@ -106,6 +108,57 @@ typedef struct OMX_TIZONIA_PARAM_BUFFER_PREANNOUNCEMENTSMODETYPE
   OMX_BOOL bEnabled;
 } OMX_TIZONIA_PARAM_BUFFER_PREANNOUNCEMENTSMODETYPE;
 
+/**
+ * The name of the performance counters extension.
+ */
+#define OMX_TIZONIA_INDEX_CONFIG_PERFCOUNTERS     \
+  "OMX.Tizonia.index.config.perfcounters"
+
+/**
+ * OMX_TizoniaIndexConfigNextContentURI
+ *
+ * Extension index used to queue, on a source component that is playing a
+ * URI, the URI that follows it (gapless playback). When the current URI is
+ * exhausted, the source carries on with the queued one instead of signalling
+ * the end of the stream, and issues an OMX_EventIndexSettingChanged event
+ * with this index on its output port. An empty URI cancels the queued one.
+ */
+
+/**
+ * The servants that make up a Tizonia component.
+ */
+typedef enum OMX_TIZONIA_SERVANTTYPE {
+    OMX_TIZONIA_ServantFsm = 0,    /**< The state machine */
+    OMX_TIZONIA_ServantKernel,     /**< The port and buffer manager */
+    OMX_TIZONIA_ServantProcessor,  /**< The component-specific processor */
+    OMX_TIZONIA_ServantMax
+} OMX_TIZONIA_SERVANTTYPE;
+
+typedef struct OMX_TIZONIA_SERVANTCOUNTERSTYPE {
+    OMX_U64 nMessages;       /**< Messages dispatched */
+    OMX_U64 nTimeUs;         /**< Time spent dispatching messages */
+    OMX_U32 nQueueHighWater; /**< Maximum number of messages ever queued */
+} OMX_TIZONIA_SERVANTCOUNTERSTYPE;
+
+/**
+ * Extension to retrieve a component's performance counters (read-only,
+ * available in any state). Counters are cumulative since the component was
+ * instantiated.
+ */
+typedef struct OMX_TIZONIA_CONFIG_PERFCOUNTERSTYPE {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;           /**< Port whose buffer counters are wanted,
+                                       or OMX_ALL for the totals of all ports */
+    OMX_U64 nBuffersIn;           /**< Buffers received (ETB/FTB) */
+    OMX_U64 nBuffersOut;          /**< Buffers returned (EBD/FBD) */
+    OMX_U64 nBytesIn;             /**< Bytes received on input ports */
+    OMX_U64 nBytesOut;            /**< Bytes produced on output ports */
+    OMX_U64 nBuffersReadyCalls;   /**< Calls to the processor's buffers_ready */
+    OMX_U64 nBuffersReadyTimeUs;  /**< Time spent in buffers_ready */
+    OMX_TIZONIA_SERVANTCOUNTERSTYPE sServants[OMX_TIZONIA_ServantMax];
+} OMX_TIZONIA_CONFIG_PERFCOUNTERSTYPE;
+
 /**
  * Icecast-like audio renderer components
  */
@@ -31,6 +31,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <assert.h>
 #include <sys/types.h>
 #include <dirent.h>
@@ -68,6 +69,8 @@
 #define TIZ_IL_CORE_RM_NAME "OMX.Aratelia.ilcore"
 #define TIZ_DEFAULT_COMP_ENTRY_POINT_NAME "OMX_ComponentInit"
 #define TIZ_CORE_QUEUE_MAX_ITEMS 30
+#define TIZ_CORE_REGISTRY_CACHE_MAGIC "tizonia-registry-cache 1"
+#define TIZ_CORE_REGISTRY_CACHE_FILE "/tizonia/registry.cache"
 
 typedef struct role_list_item role_list_item_t;
 typedef role_list_item_t * role_list_t;
@@ -228,6 +231,32 @@ struct tiz_core_registry_item
   tiz_core_registry_item_t * p_next;
 };
 
+/* An entry of the registry cache file. One per plugin library that was
+   successfully registered; the library's inode, size and modification time
+   tell whether the entry is still valid */
+typedef struct tiz_core_cache_item tiz_core_cache_item_t;
+struct tiz_core_cache_item
+{
+  OMX_STRING p_dl_path;
+  OMX_STRING p_dl_name;
+  OMX_STRING p_comp_name;
+  unsigned long long ino;
+  long long size;
+  long long mtime_ns;
+  role_list_t p_roles;
+  bool used; /* the library was found during the current scan */
+  tiz_core_cache_item_t * p_next;
+};
+
+typedef struct tiz_core_cache tiz_core_cache_t;
+struct tiz_core_cache
+{
+  char file[PATH_MAX];
+  tiz_core_cache_item_t * p_items;
+  bool enabled;
+  bool dirty;
+};
+
 typedef struct tizcore tiz_core_t;
 struct tizcore
 {
@@ -434,6 +463,62 @@ get_component_roles (OMX_COMPONENTTYPE * ap_hdl, role_list_t * app_role_list)
   return rc;
 }
 
+static role_list_t
+dup_roles (const role_list_item_t * ap_role_lst)
+{
+  role_list_item_t * p_first = NULL;
+  role_list_item_t * p_last = NULL;
+
+  for (; ap_role_lst; ap_role_lst = ap_role_lst->p_next)
+    {
+      role_list_item_t * p_role
+        = (role_list_item_t *) tiz_mem_calloc (1, sizeof (role_list_item_t));
+      if (NULL == p_role)
+        {
+          free_roles (p_first);
+          return NULL;
+        }
+      memcpy (p_role->role, ap_role_lst->role, OMX_MAX_STRINGNAME_SIZE);
+      if (p_last)
+        {
+          p_last->p_next = p_role;
+        }
+      else
+        {
+          p_first = p_role;
+        }
+      p_last = p_role;
+    }
+
+  return p_first;
+}
+
+static void
+append_to_registry (tiz_core_registry_item_t * ap_reg_item)
+{
+  tiz_core_t * p_core = get_core ();
+  tiz_core_registry_item_t * p_registry_last = NULL;
+
+  assert (p_core);
+  assert (ap_reg_item);
+
+  if (NULL == (p_core->p_registry))
+    {
+      /* First entry in the registry */
+      p_core->p_registry = ap_reg_item;
+    }
+  else
+    {
+      /* Find the last entry in the registry */
+      p_registry_last = p_core->p_registry;
+      while (p_registry_last->p_next)
+        {
+          p_registry_last = p_registry_last->p_next;
+        }
+      p_registry_last->p_next = ap_reg_item;
+    }
+}
+
 static OMX_ERRORTYPE
 add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
                       OMX_PTR ap_entry_point, OMX_PTR ap_dl_hdl,
@@ -529,31 +614,7 @@ add_to_comp_registry (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
     {
 
       /* Add to registry */
-      if (NULL == (p_core->p_registry))
-        {
-          /* First entry in the registry */
-          TIZ_LOG (TIZ_PRIORITY_TRACE, "Component added (first component) [%s]",
-                   comp_name);
-
-          p_core->p_registry = p_registry_new;
-        }
-      else
-        {
-          /* Find the last entry in the registry */
-          p_registry_last = p_core->p_registry;
-          while (true)
-            {
-              if (p_registry_last->p_next)
-                {
-                  p_registry_last = p_registry_last->p_next;
-                }
-              else
-                {
-                  break;
-                }
-            }
-          p_registry_last->p_next = p_registry_new;
-        }
+      append_to_registry (p_registry_new);
 
       /* Finish filling the registry entry... */
       p_registry_new->p_comp_name
@@ -671,7 +732,8 @@ instantiate_comp_lib (const OMX_STRING ap_path, const OMX_STRING ap_name,
 }
 
 static OMX_ERRORTYPE
-cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
+cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name,
+                 tiz_core_registry_item_t ** app_reg_item)
 {
   OMX_PTR p_dl_hdl = NULL;
   OMX_PTR p_entry_point = NULL;
@@ -679,6 +741,9 @@ cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
   OMX_COMPONENTTYPE * p_hdl = NULL;
   tiz_core_registry_item_t * p_reg_item = NULL;
 
+  assert (app_reg_item);
+  *app_reg_item = NULL;
+
   TIZ_LOG (TIZ_PRIORITY_TRACE, "dl_name [%s]", ap_dl_name);
 
   rc = instantiate_comp_lib (
@@ -707,6 +772,7 @@ cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
               TIZ_LOG (TIZ_PRIORITY_TRACE, "component [%s] : info cached",
                        p_reg_item->p_comp_name);
               p_reg_item->p_hdl = NULL;
+              *app_reg_item = p_reg_item;
             }
 
           /* delete the comp hadle */
@@ -725,6 +791,418 @@ cache_comp_info (const OMX_STRING ap_dl_path, const OMX_STRING ap_dl_name)
   return rc;
 }
 
+/*
+ * Registry cache. Finding out the name and roles of a component requires
+ * loading its plugin library (and all the libraries it depends on) and
+ * instantiating it. The results are kept in a cache file, so that this is
+ * only done for the plugins that have been added or modified since the
+ * last OMX_Init. The libraries are then only loaded on OMX_GetHandle.
+ */
+
+static void
+free_cache_items (tiz_core_cache_item_t * ap_item)
+{
+  while (ap_item)
+    {
+      tiz_core_cache_item_t * p_next = ap_item->p_next;
+      tiz_mem_free (ap_item->p_dl_path);
+      tiz_mem_free (ap_item->p_dl_name);
+      tiz_mem_free (ap_item->p_comp_name);
+      free_roles (ap_item->p_roles);
+      tiz_mem_free (ap_item);
+      ap_item = p_next;
+    }
+}
+
+static bool
+get_cache_file_path (char * ap_file, size_t a_len)
+{
+  const char * p_file = tiz_rcfile_get_value ("ilcore", "registry-cache-file");
+  const char * p_xdg = getenv ("XDG_CACHE_HOME");
+  const char * p_home = getenv ("HOME");
+  int len = -1;
+
+  if (p_file && strlen (p_file) > 0)
+    {
+      len = snprintf (ap_file, a_len, "%s", p_file);
+    }
+  else if (p_xdg && strlen (p_xdg) > 0)
+    {
+      len = snprintf (ap_file, a_len, "%s%s", p_xdg,
+                      TIZ_CORE_REGISTRY_CACHE_FILE);
+    }
+  else if (p_home && strlen (p_home) > 0)
+    {
+      len = snprintf (ap_file, a_len, "%s/.cache%s", p_home,
+                      TIZ_CORE_REGISTRY_CACHE_FILE);
+    }
+
+  return (len > 0 && (size_t) len < a_len);
+}
+
+static tiz_core_cache_item_t *
+parse_cache_line (char * ap_line)
+{
+  tiz_core_cache_item_t * p_item = NULL;
+  role_list_item_t * p_last = NULL;
+  char * p_save = NULL;
+  char * p_tok[6];
+  char * p_role = NULL;
+  int i = 0;
+
+  for (i = 0; i < 6; ++i)
+    {
+      if (NULL == (p_tok[i] = strtok_r (i ? NULL : ap_line, "\t", &p_save)))
+        {
+          return NULL;
+        }
+    }
+
+  if (NULL == (p_item = (tiz_core_cache_item_t *) tiz_mem_calloc (
+                 1, sizeof (tiz_core_cache_item_t))))
+    {
+      return NULL;
+    }
+
+  p_item->p_dl_path = strndup (p_tok[0], PATH_MAX);
+  p_item->p_dl_name = strndup (p_tok[1], NAME_MAX);
+  p_item->ino = strtoull (p_tok[2], NULL, 10);
+  p_item->size = strtoll (p_tok[3], NULL, 10);
+  p_item->mtime_ns = strtoll (p_tok[4], NULL, 10);
+  p_item->p_comp_name = strndup (p_tok[5], OMX_MAX_STRINGNAME_SIZE);
+
+  while ((p_role = strtok_r (NULL, "\t", &p_save)))
+    {
+      role_list_item_t * p_rli
+        = (role_list_item_t *) tiz_mem_calloc (1, sizeof (role_list_item_t));
+      if (NULL == p_rli)
+        {
+          break;
+        }
+      strncpy ((char *) p_rli->role, p_role, OMX_MAX_STRINGNAME_SIZE - 1);
+      if (p_last)
+        {
+          p_last->p_next = p_rli;
+        }
+      else
+        {
+          p_item->p_roles = p_rli;
+        }
+      p_last = p_rli;
+    }
+
+  if (!p_item->p_dl_path || !p_item->p_dl_name || !p_item->p_comp_name
+      || !p_item->p_roles || p_role)
+    {
+      free_cache_items (p_item);
+      p_item = NULL;
+    }
+
+  return p_item;
+}
+
+static void
+load_registry_cache (tiz_core_cache_t * ap_cache)
+{
+  FILE * p_file = NULL;
+  char * p_line = NULL;
+  size_t line_len = 0;
+  ssize_t nread = 0;
+  tiz_core_cache_item_t * p_last = NULL;
+
+  assert (ap_cache);
+
+  ap_cache->enabled
+    = (0 != tiz_rcfile_compare_value ("ilcore", "registry-cache", "false"))
+      && get_cache_file_path (ap_cache->file, sizeof (ap_cache->file));
+
+  if (!ap_cache->enabled)
+    {
+      return;
+    }
+
+  if (NULL == (p_file = fopen (ap_cache->file, "r")))
+    {
+      TIZ_LOG (TIZ_PRIORITY_DEBUG, "No registry cache at [%s]",
+               ap_cache->file);
+      ap_cache->dirty = true;
+      return;
+    }
+
+  /* The first line identifies the format */
+  nread = getline (&p_line, &line_len, p_file);
+  if (nread <= 0
+      || 0 != strncmp (p_line, TIZ_CORE_REGISTRY_CACHE_MAGIC,
+                       strlen (TIZ_CORE_REGISTRY_CACHE_MAGIC)))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Ignoring registry cache [%s]",
+               ap_cache->file);
+      ap_cache->dirty = true;
+    }
+  else
+    {
+      while ((nread = getline (&p_line, &line_len, p_file)) > 0)
+        {
+          tiz_core_cache_item_t * p_item = NULL;
+          if ('\n' == p_line[nread - 1])
+            {
+              p_line[nread - 1] = '\0';
+            }
+          if (NULL == (p_item = parse_cache_line (p_line)))
+            {
+              /* A corrupt entry; it will be re-written */
+              ap_cache->dirty = true;
+              continue;
+            }
+          if (p_last)
+            {
+              p_last->p_next = p_item;
+            }
+          else
+            {
+              ap_cache->p_items = p_item;
+            }
+          p_last = p_item;
+        }
+    }
+
+  free (p_line);
+  (void) fclose (p_file);
+}
+
+static bool
+make_parent_dirs (const char * ap_file)
+{
+  char * p_dir = strndup (ap_file, PATH_MAX);
+  char * p = NULL;
+  bool rc = (NULL != p_dir);
+
+  for (p = p_dir ? strchr (p_dir + 1, '/') : NULL; p && rc;
+       p = strchr (p + 1, '/'))
+    {
+      *p = '\0';
+      rc = (0 == mkdir (p_dir, 0755) || EEXIST == errno);
+      *p = '/';
+    }
+
+  tiz_mem_free (p_dir);
+  return rc;
+}
+
+static void
+save_registry_cache (tiz_core_cache_t * ap_cache)
+{
+  char * p_tmp_file = NULL;
+  size_t tmp_len = 0;
+  tiz_core_cache_item_t * p_item = NULL;
+  FILE * p_file = NULL;
+  bool failed = false;
+
+  assert (ap_cache);
+
+  for (p_item = ap_cache->p_items; p_item; p_item = p_item->p_next)
+    {
+      /* The library has been removed or renamed */
+      ap_cache->dirty |= !p_item->used;
+    }
+
+  if (!ap_cache->enabled || !ap_cache->dirty)
+    {
+      return;
+    }
+
+  /* Write to a temporary file, then move it over the old cache, so that
+     other processes never see a partially written file. NOTE: this runs on
+     the IL Core thread, which has a small stack */
+  tmp_len = strlen (ap_cache->file) + 16;
+  if (NULL == (p_tmp_file = tiz_mem_alloc (tmp_len)))
+    {
+      return;
+    }
+  snprintf (p_tmp_file, tmp_len, "%s.%d", ap_cache->file, (int) getpid ());
+  if (!make_parent_dirs (ap_cache->file)
+      || NULL == (p_file = fopen (p_tmp_file, "w")))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Unable to write registry cache [%s] - %s",
+               ap_cache->file, strerror (errno));
+      tiz_mem_free (p_tmp_file);
+      return;
+    }
+
+  failed = (fprintf (p_file, "%s\n", TIZ_CORE_REGISTRY_CACHE_MAGIC) < 0);
+  for (p_item = ap_cache->p_items; p_item && !failed; p_item = p_item->p_next)
+    {
+      role_list_item_t * p_role = NULL;
+      if (!p_item->used)
+        {
+          continue;
+        }
+      failed = (fprintf (p_file, "%s\t%s\t%llu\t%lld\t%lld\t%s",
+                         p_item->p_dl_path, p_item->p_dl_name, p_item->ino,
+                         p_item->size, p_item->mtime_ns, p_item->p_comp_name)
+                < 0);
+      for (p_role = p_item->p_roles; p_role && !failed;
+           p_role = p_role->p_next)
+        {
+          failed = (fprintf (p_file, "\t%s", (char *) p_role->role) < 0);
+        }
+      failed = failed || (fputc ('\n', p_file) < 0);
+    }
+
+  failed = (0 != fclose (p_file)) || failed;
+  if (failed || 0 != rename (p_tmp_file, ap_cache->file))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Unable to write registry cache [%s] - %s",
+               ap_cache->file, strerror (errno));
+      (void) unlink (p_tmp_file);
+    }
+  else
+    {
+      TIZ_LOG (TIZ_PRIORITY_DEBUG, "Registry cache [%s] updated",
+               ap_cache->file);
+    }
+
+  tiz_mem_free (p_tmp_file);
+}
+
+static bool
+is_cacheable (const char * ap_str)
+{
+  return (NULL == strpbrk (ap_str, "\t\n"));
+}
+
+static tiz_core_cache_item_t *
+find_cache_item (tiz_core_cache_t * ap_cache, const char * ap_dl_path,
+                 const char * ap_dl_name)
+{
+  tiz_core_cache_item_t * p_item = NULL;
+
+  for (p_item = ap_cache->p_items; p_item; p_item = p_item->p_next)
+    {
+      if (0 == strcmp (p_item->p_dl_name, ap_dl_name)
+          && 0 == strcmp (p_item->p_dl_path, ap_dl_path))
+        {
+          break;
+        }
+    }
+
+  return p_item;
+}
+
+static OMX_ERRORTYPE
+add_cached_comp_to_registry (const tiz_core_cache_item_t * ap_item)
+{
+  tiz_core_registry_item_t * p_reg_item = NULL;
+
+  assert (ap_item);
+
+  if (find_comp_in_registry (ap_item->p_comp_name))
+    {
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "Component already in registry [%s]",
+               ap_item->p_comp_name);
+      return OMX_ErrorNone;
+    }
+
+  if (NULL == (p_reg_item = (tiz_core_registry_item_t *) tiz_mem_calloc (
+                 1, sizeof (tiz_core_registry_item_t))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_reg_item->p_comp_name
+    = strndup (ap_item->p_comp_name, OMX_MAX_STRINGNAME_SIZE);
+  p_reg_item->p_dl_name = strndup (ap_item->p_dl_name, NAME_MAX);
+  p_reg_item->p_dl_path = strndup (ap_item->p_dl_path, PATH_MAX);
+  p_reg_item->p_roles = dup_roles (ap_item->p_roles);
+
+  if (!p_reg_item->p_comp_name || !p_reg_item->p_dl_name
+      || !p_reg_item->p_dl_path || !p_reg_item->p_roles)
+    {
+      tiz_mem_free (p_reg_item->p_comp_name);
+      tiz_mem_free (p_reg_item->p_dl_name);
+      tiz_mem_free (p_reg_item->p_dl_path);
+      free_roles (p_reg_item->p_roles);
+      tiz_mem_free (p_reg_item);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  append_to_registry (p_reg_item);
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "component [%s] : info from cache",
+           p_reg_item->p_comp_name);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+register_comp_lib (tiz_core_cache_t * ap_cache, const OMX_STRING ap_dl_path,
+                   const OMX_STRING ap_dl_name, const struct stat * ap_st)
+{
+  tiz_core_cache_item_t * p_item = NULL;
+  tiz_core_registry_item_t * p_reg_item = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_cache);
+
+  if (ap_cache->enabled && ap_st)
+    {
+      p_item = find_cache_item (ap_cache, ap_dl_path, ap_dl_name);
+    }
+
+  if (p_item && p_item->ino == (unsigned long long) ap_st->st_ino
+      && p_item->size == (long long) ap_st->st_size
+      && p_item->mtime_ns == (long long) ap_st->st_mtim.tv_sec * 1000000000LL
+                               + ap_st->st_mtim.tv_nsec)
+    {
+      p_item->used = true;
+      return add_cached_comp_to_registry (p_item);
+    }
+
+  if (OMX_ErrorNone != (rc = cache_comp_info (ap_dl_path, ap_dl_name,
+                                              &p_reg_item))
+      || NULL == p_reg_item || !ap_cache->enabled || !ap_st
+      || !is_cacheable (ap_dl_path)
+      || !is_cacheable (ap_dl_name))
+    {
+      /* Libraries that could not be registered are not cached; they are
+         tried again on the next OMX_Init */
+      return rc;
+    }
+
+  /* Record the new or updated library */
+  if (NULL == p_item)
+    {
+      if (NULL == (p_item = (tiz_core_cache_item_t *) tiz_mem_calloc (
+                     1, sizeof (tiz_core_cache_item_t))))
+        {
+          return OMX_ErrorNone;
+        }
+      p_item->p_next = ap_cache->p_items;
+      ap_cache->p_items = p_item;
+    }
+  else
+    {
+      tiz_mem_free (p_item->p_dl_path);
+      tiz_mem_free (p_item->p_dl_name);
+      tiz_mem_free (p_item->p_comp_name);
+      free_roles (p_item->p_roles);
+    }
+
+  p_item->p_dl_path = strndup (ap_dl_path, PATH_MAX);
+  p_item->p_dl_name = strndup (ap_dl_name, NAME_MAX);
+  p_item->p_comp_name = strndup (p_reg_item->p_comp_name,
+                                 OMX_MAX_STRINGNAME_SIZE);
+  p_item->p_roles = dup_roles (p_reg_item->p_roles);
+  p_item->ino = ap_st->st_ino;
+  p_item->size = ap_st->st_size;
+  p_item->mtime_ns = (long long) ap_st->st_mtim.tv_sec * 1000000000LL
+                     + ap_st->st_mtim.tv_nsec;
+  /* An incomplete item is simply left out of the file */
+  p_item->used = (p_item->p_dl_path && p_item->p_dl_name
+                  && p_item->p_comp_name && p_item->p_roles);
+  ap_cache->dirty = true;
+
+  return OMX_ErrorNone;
+}
+
 static char **
 find_component_paths (unsigned long * ap_npaths)
 {
@@ -775,6 +1253,8 @@ scan_component_folders (void)
   char ** pp_paths;
   unsigned long npaths = 0;
   struct dirent * p_dir_entry = NULL;
+  tiz_core_cache_t * p_cache = NULL;
+  struct stat st;
 
   if (NULL == (pp_paths = find_component_paths (&npaths)))
     {
@@ -782,6 +1262,15 @@ scan_component_folders (void)
       return OMX_ErrorInsufficientResources;
     }
 
+  /* NOTE: Not on the stack; the IL Core thread has a small one */
+  if (NULL == (p_cache = (tiz_core_cache_t *) tiz_mem_calloc (
+                 1, sizeof (tiz_core_cache_t))))
+    {
+      free_paths (pp_paths, npaths);
+      return OMX_ErrorInsufficientResources;
+    }
+  load_registry_cache (p_cache);
+
   for (i = 0; i < (int) npaths; i++)
     {
       TIZ_LOG (TIZ_PRIORITY_TRACE, "Looking for component plugins : %s",
@@ -805,11 +1294,18 @@ scan_component_folders (void)
                   TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s]", p_dir_entry->d_name);
                   if (p_dir_entry->d_type == DT_REG)
                     {
+                      const bool have_stat
+                        = (0 == fstatat (dirfd (p_dir), p_dir_entry->d_name,
+                                         &st, 0));
                       if (OMX_ErrorInsufficientResources
-                          == cache_comp_info (pp_paths[i], p_dir_entry->d_name))
+                          == register_comp_lib (p_cache, pp_paths[i],
+                                                p_dir_entry->d_name,
+                                                have_stat ? &st : NULL))
                         {
                           (void) closedir (p_dir);
                           free_paths (pp_paths, npaths);
+                          free_cache_items (p_cache->p_items);
+                          tiz_mem_free (p_cache);
                           return OMX_ErrorInsufficientResources;
                         }
                     }
@@ -820,6 +1316,9 @@ scan_component_folders (void)
         }
     }
 
+  save_registry_cache (p_cache);
+  free_cache_items (p_cache->p_items);
+  tiz_mem_free (p_cache);
   free_paths (pp_paths, npaths);
 
   return OMX_ErrorNone;
@@ -284,6 +284,54 @@ START_TEST (test_ilcore_role_of_comp_enum)
   fail_if (error != OMX_ErrorNone);
 }
 
+END_TEST
+START_TEST (test_ilcore_registry_cache)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = NULL;
+  OMX_U32 appData;
+  OMX_CALLBACKTYPE callBacks;
+  OMX_U32 index = 0;
+  OMX_S8 comp_name[OMX_MAX_STRINGNAME_SIZE];
+  const char *p_cache_file = NULL;
+
+  p_cache_file = tiz_rcfile_get_value ("ilcore", "registry-cache-file");
+  fail_if (NULL == p_cache_file);
+  (void) unlink (p_cache_file);
+
+  /* The first OMX_Init builds the cache... */
+  error = OMX_Init ();
+  fail_if (error != OMX_ErrorNone);
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+  fail_if (0 != access (p_cache_file, R_OK));
+
+  /* ...and the second one registers the components from it */
+  error = OMX_Init ();
+  fail_if (error != OMX_ErrorNone);
+
+  do
+    {
+      error = OMX_ComponentOfRoleEnum ((OMX_STRING) comp_name,
+                                       TIZ_CORE_TEST_COMPONENT_ROLE, index++);
+    } while (OMX_ErrorNone == error);
+
+  fail_if (OMX_ErrorNoMore != error);
+  fail_if (index != 2);
+
+  /* The plugin is loaded on demand */
+  error = OMX_GetHandle (&p_hdl,
+                         TIZ_CORE_TEST_COMPONENT_NAME,
+                         (OMX_PTR *) (&appData), &callBacks);
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (error != OMX_ErrorNone);
+
+  error = OMX_Deinit ();
+  fail_if (error != OMX_ErrorNone);
+}
+
 END_TEST Suite * tizcore_suite (void)
 {
   TCase *tc_ilcore;
@@ -302,6 +350,7 @@ END_TEST Suite * tizcore_suite (void)
   /*   tcase_add_test (tc_ilcore, test_ilcore_setup_tunnel_tear_down_tunnel); */
   tcase_add_test (tc_ilcore, test_ilcore_comp_of_role_enum);
   tcase_add_test (tc_ilcore, test_ilcore_role_of_comp_enum);
+  tcase_add_test (tc_ilcore, test_ilcore_registry_cache);
 
   /* TODO: Negative case for OMX_ErrorPortsNotConnected error */
 
@@ -160,6 +160,10 @@ filter_prc_get_header (tiz_filter_prc_t * ap_prc, const OMX_U32 a_pid)
       OMX_BUFFERHEADERTYPE ** pp_hdr
         = tiz_filter_prc_get_header_ptr (ap_prc, a_pid);
       p_hdr = *pp_hdr;
+      /* One header per port at a time, on purpose: subclasses flush and
+         disable ports through tiz_filter_prc_release_header, which only knows
+         about this one, so headers claimed ahead with tiz_krn_claim_buffers
+         would never be returned */
       if (!p_hdr && (OMX_ErrorNone
                      == tiz_krn_claim_buffer (tiz_get_krn (handleOf (ap_prc)),
                                               a_pid, 0, pp_hdr)))
@@ -573,3 +577,230 @@ tiz_filter_prc_init (void * ap_tos, void * ap_hdl)
 
   return filterprc;
 }
+
+/*
+ * carry-over store
+ */
+
+struct tiz_filter_spill
+{
+  tiz_buffer_t * p_buf;
+  size_t capacity;
+  size_t unit;
+  tiz_filter_spill_stats_t stats;
+};
+
+static OMX_ERRORTYPE
+spill_init (tiz_filter_spill_t ** app_spill, const size_t a_capacity,
+            const size_t a_unit, const bool a_ring)
+{
+  tiz_filter_spill_t * p_spill = NULL;
+  assert (app_spill);
+  assert (a_capacity > 0);
+
+  p_spill = tiz_mem_calloc (1, sizeof (tiz_filter_spill_t));
+  tiz_check_null_ret_oom (p_spill);
+
+  if ((!a_ring
+       || OMX_ErrorNone != tiz_buffer_ring_init (&(p_spill->p_buf), a_capacity))
+      && OMX_ErrorNone != tiz_buffer_init (&(p_spill->p_buf), a_capacity))
+    {
+      tiz_mem_free (p_spill);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_spill->capacity = a_capacity;
+  p_spill->unit = a_unit > 0 ? a_unit : 1;
+  p_spill->stats.capacity = a_capacity;
+  *app_spill = p_spill;
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_filter_spill_init (tiz_filter_spill_t ** app_spill, const size_t a_capacity,
+                       const size_t a_unit)
+{
+  /* Prefer the mirrored ring; fall back to a plain (bounded) dynamic buffer
+     where the platform does not allow the double mapping */
+  return spill_init (app_spill, a_capacity, a_unit, true);
+}
+
+OMX_ERRORTYPE
+tiz_filter_spill_init_plain (tiz_filter_spill_t ** app_spill,
+                             const size_t a_capacity, const size_t a_unit)
+{
+  return spill_init (app_spill, a_capacity, a_unit, false);
+}
+
+void
+tiz_filter_spill_destroy (tiz_filter_spill_t * ap_spill)
+{
+  if (ap_spill)
+    {
+      tiz_buffer_destroy (ap_spill->p_buf);
+      tiz_mem_free (ap_spill);
+    }
+}
+
+void
+tiz_filter_spill_clear (tiz_filter_spill_t * ap_spill)
+{
+  assert (ap_spill);
+  tiz_buffer_clear (ap_spill->p_buf);
+}
+
+void
+tiz_filter_spill_set_unit (tiz_filter_spill_t * ap_spill, const size_t a_unit)
+{
+  assert (ap_spill);
+  ap_spill->unit = a_unit > 0 ? a_unit : 1;
+}
+
+size_t
+tiz_filter_spill_available (const tiz_filter_spill_t * ap_spill)
+{
+  assert (ap_spill);
+  return tiz_buffer_available (ap_spill->p_buf);
+}
+
+size_t
+tiz_filter_spill_push (tiz_filter_spill_t * ap_spill, const void * ap_data,
+                       const size_t a_nbytes)
+{
+  size_t avail = 0;
+  size_t nbytes = 0;
+  assert (ap_spill);
+
+  if (a_nbytes > 0)
+    {
+      assert (ap_data);
+      avail = tiz_buffer_available (ap_spill->p_buf);
+      nbytes = MIN (a_nbytes, ap_spill->capacity - avail);
+      nbytes -= nbytes % ap_spill->unit;
+      if (nbytes > 0)
+        {
+          nbytes = tiz_buffer_push (ap_spill->p_buf, ap_data, nbytes);
+        }
+      ap_spill->stats.nbytes_spilled += nbytes;
+      ap_spill->stats.nbytes_dropped += a_nbytes - nbytes;
+      ap_spill->stats.nspills++;
+      ap_spill->stats.high_water
+        = MAX (ap_spill->stats.high_water, avail + nbytes);
+      if (nbytes < a_nbytes)
+        {
+          TIZ_LOG (TIZ_PRIORITY_WARN,
+                   "Carry-over store full (capacity %zu) : dropped %zu bytes",
+                   ap_spill->capacity, a_nbytes - nbytes);
+        }
+    }
+  return nbytes;
+}
+
+void *
+tiz_filter_spill_reserve (tiz_filter_spill_t * ap_spill, const size_t a_nbytes,
+                          size_t * ap_avail)
+{
+  void * p_span = NULL;
+  size_t avail = 0;
+  assert (ap_spill);
+  assert (ap_avail);
+
+  avail = MIN (a_nbytes, ap_spill->capacity
+                           - tiz_buffer_available (ap_spill->p_buf));
+  avail -= avail % ap_spill->unit;
+  if (avail > 0)
+    {
+      size_t span = 0;
+      p_span = tiz_buffer_write_span (ap_spill->p_buf, avail, &span);
+      avail = p_span ? MIN (avail, span) : 0;
+      avail -= avail % ap_spill->unit;
+    }
+  if (avail < a_nbytes)
+    {
+      ap_spill->stats.nbytes_dropped += a_nbytes - avail;
+      TIZ_LOG (TIZ_PRIORITY_WARN,
+               "Carry-over store full (capacity %zu) : dropped %zu bytes",
+               ap_spill->capacity, a_nbytes - avail);
+    }
+  *ap_avail = avail;
+  return avail > 0 ? p_span : NULL;
+}
+
+size_t
+tiz_filter_spill_commit (tiz_filter_spill_t * ap_spill, const size_t a_nbytes)
+{
+  size_t nbytes = 0;
+  assert (ap_spill);
+  if (a_nbytes > 0)
+    {
+      nbytes = tiz_buffer_commit (ap_spill->p_buf, a_nbytes);
+      ap_spill->stats.nbytes_spilled += nbytes;
+      ap_spill->stats.nspills++;
+      ap_spill->stats.high_water
+        = MAX (ap_spill->stats.high_water,
+               (size_t) tiz_buffer_available (ap_spill->p_buf));
+    }
+  return nbytes;
+}
+
+size_t
+tiz_filter_spill_scatter (tiz_filter_spill_t * ap_spill,
+                          OMX_BUFFERHEADERTYPE ** app_hdrs,
+                          const OMX_U32 a_nhdrs, const void * ap_data,
+                          const size_t a_nbytes)
+{
+  const OMX_U8 * p_data = ap_data;
+  size_t consumed = 0;
+  OMX_U32 i = 0;
+
+  assert (ap_spill);
+  assert (app_hdrs || 0 == a_nhdrs);
+  assert (ap_data || 0 == a_nbytes);
+
+  for (i = 0; i < a_nhdrs; ++i)
+    {
+      OMX_BUFFERHEADERTYPE * p_hdr = app_hdrs[i];
+      size_t room = 0;
+      size_t nbytes = 0;
+
+      assert (p_hdr);
+      room = p_hdr->nAllocLen - p_hdr->nOffset - p_hdr->nFilledLen;
+      room -= room % ap_spill->unit;
+
+      /* Carried-over bytes go out first */
+      nbytes = MIN ((size_t) tiz_buffer_available (ap_spill->p_buf), room);
+      if (nbytes > 0)
+        {
+          memcpy (TIZ_OMX_BUF_PTR (p_hdr) + p_hdr->nFilledLen,
+                  tiz_buffer_get (ap_spill->p_buf), nbytes);
+          (void) tiz_buffer_advance (ap_spill->p_buf, nbytes);
+          p_hdr->nFilledLen += nbytes;
+          room -= nbytes;
+          ap_spill->stats.nbytes_drained += nbytes;
+        }
+
+      /* New data may only follow once the store is empty, to keep the
+         byte order */
+      if (0 == tiz_buffer_available (ap_spill->p_buf))
+        {
+          nbytes = MIN (a_nbytes - consumed, room);
+          if (nbytes > 0)
+            {
+              memcpy (TIZ_OMX_BUF_PTR (p_hdr) + p_hdr->nFilledLen,
+                      p_data + consumed, nbytes);
+              p_hdr->nFilledLen += nbytes;
+              consumed += nbytes;
+            }
+        }
+    }
+  return consumed;
+}
+
+void
+tiz_filter_spill_get_stats (const tiz_filter_spill_t * ap_spill,
+                            tiz_filter_spill_stats_t * ap_stats)
+{
+  assert (ap_spill);
+  assert (ap_stats);
+  *ap_stats = ap_spill->stats;
+}
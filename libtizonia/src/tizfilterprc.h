@@ -67,6 +67,100 @@ void
 tiz_filter_prc_update_port_disabled_flag (void * ap_obj, const OMX_U32 a_pid,
                                           const bool flag);
 
+/**
+ * Carry-over store for the bytes that a processor produces (e.g. decoded
+ * PCM or demuxed packets) but can't place in the output headers it holds at
+ * the moment. The store is a fixed-capacity ring: it is never re-allocated,
+ * and its contents are always contiguous, so they go out to the next header
+ * with a single copy.
+ */
+typedef struct tiz_filter_spill tiz_filter_spill_t;
+
+typedef struct tiz_filter_spill_stats tiz_filter_spill_stats_t;
+struct tiz_filter_spill_stats
+{
+  OMX_U64 nbytes_spilled; /* bytes carried over */
+  OMX_U64 nbytes_drained; /* carried-over bytes written into headers */
+  OMX_U64 nbytes_dropped; /* bytes that did not fit in the store */
+  OMX_U32 nspills;        /* number of carry-overs */
+  size_t high_water;      /* largest number of bytes held at once */
+  size_t capacity;
+};
+
+/**
+ * Create a carry-over store.
+ *
+ * @param app_spill The new store (output).
+ * @param a_capacity The maximum number of bytes held at once (it may be
+ * rounded up to a multiple of the page size).
+ * @param a_unit Headers are only filled with whole multiples of this many
+ * bytes (e.g. the size of a PCM frame), or 1.
+ * @return OMX_ErrorNone or OMX_ErrorInsufficientResources.
+ */
+OMX_ERRORTYPE
+tiz_filter_spill_init (tiz_filter_spill_t ** app_spill, const size_t a_capacity,
+                       const size_t a_unit);
+/**
+ * Same as tiz_filter_spill_init, but the store is always the plain (bounded)
+ * dynamic buffer that tiz_filter_spill_init falls back to when the mirrored
+ * ring can't be mapped.
+ */
+OMX_ERRORTYPE
+tiz_filter_spill_init_plain (tiz_filter_spill_t ** app_spill,
+                             const size_t a_capacity, const size_t a_unit);
+void
+tiz_filter_spill_destroy (tiz_filter_spill_t * ap_spill);
+void
+tiz_filter_spill_clear (tiz_filter_spill_t * ap_spill);
+void
+tiz_filter_spill_set_unit (tiz_filter_spill_t * ap_spill, const size_t a_unit);
+size_t
+tiz_filter_spill_available (const tiz_filter_spill_t * ap_spill);
+/**
+ * Carry over some data. Whatever does not fit in the store is dropped (and
+ * accounted for in the statistics).
+ *
+ * @return The number of bytes stored.
+ */
+size_t
+tiz_filter_spill_push (tiz_filter_spill_t * ap_spill, const void * ap_data,
+                       const size_t a_nbytes);
+/**
+ * Retrieve contiguous free space at the back of the store, so that data can
+ * be produced in place (e.g. interleaved straight into the store) instead of
+ * being pushed from an intermediate buffer. The bytes written must then be
+ * made available with tiz_filter_spill_commit.
+ *
+ * @param a_nbytes The number of bytes the caller would like to write.
+ * @param ap_avail On return, the number of bytes that can be written, a
+ * multiple of the store's unit. The shortfall, if any, is accounted for as
+ * dropped.
+ * @return The position where data can be written, or NULL if the store is
+ * full.
+ */
+void *
+tiz_filter_spill_reserve (tiz_filter_spill_t * ap_spill, const size_t a_nbytes,
+                          size_t * ap_avail);
+size_t
+tiz_filter_spill_commit (tiz_filter_spill_t * ap_spill, const size_t a_nbytes);
+/**
+ * Write the carried-over bytes first, and then as much of ap_data as fits,
+ * into the free space of one or more headers, in order. Each header's data
+ * is appended at pBuffer + nOffset + nFilledLen, and nFilledLen is updated.
+ * The part of ap_data that does not fit is not carried over automatically;
+ * pass it to tiz_filter_spill_push, or to the next call with fresh headers.
+ *
+ * @return The number of bytes of ap_data that were written.
+ */
+size_t
+tiz_filter_spill_scatter (tiz_filter_spill_t * ap_spill,
+                          OMX_BUFFERHEADERTYPE ** app_hdrs,
+                          const OMX_U32 a_nhdrs, const void * ap_data,
+                          const size_t a_nbytes);
+void
+tiz_filter_spill_get_stats (const tiz_filter_spill_t * ap_spill,
+                            tiz_filter_spill_stats_t * ap_stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,6 +40,7 @@
 #include "tizport.h"
 #include "tizconfigport.h"
 #include "tizport-macros.h"
+#include "tizprc.h"
 #include "tizutils.h"
 
 #include "tizkernel.h"
@@ -127,9 +128,11 @@ init_ports_and_lists (void * ap_obj)
   tiz_check_omx_ret_oom (
     tiz_vector_init (&(p_obj->p_ports_), sizeof (OMX_PTR)));
   tiz_check_omx_ret_oom (
-    tiz_vector_init (&(p_obj->p_ingress_), sizeof (tiz_vector_t *)));
+    tiz_vector_init (&(p_obj->p_ingress_), sizeof (tiz_krn_hdr_ring_t)));
   tiz_check_omx_ret_oom (
-    tiz_vector_init (&(p_obj->p_egress_), sizeof (tiz_vector_t *)));
+    tiz_vector_init (&(p_obj->p_egress_), sizeof (tiz_krn_hdr_ring_t)));
+  tiz_check_omx_ret_oom (tiz_vector_init (&(p_obj->p_counters_),
+                                          sizeof (tiz_krn_port_counters_t)));
 
   p_obj->p_cport_ = NULL;
   p_obj->p_proc_ = NULL;
@@ -156,7 +159,6 @@ deinit_ports_and_lists (void * ap_obj)
 {
   tiz_krn_t * p_obj = ap_obj;
   OMX_PTR * pp_port = NULL;
-  tiz_vector_t * p_list = NULL;
 
   /* delete the config port */
   factory_delete (p_obj->p_cport_);
@@ -176,9 +178,7 @@ deinit_ports_and_lists (void * ap_obj)
   /* delete the ingress and egress lists */
   while (tiz_vector_length (p_obj->p_ingress_) > 0)
     {
-      p_list = *(tiz_vector_t **) tiz_vector_back (p_obj->p_ingress_);
-      tiz_vector_clear (p_list);
-      tiz_vector_destroy (p_list);
+      hdr_ring_destroy (tiz_vector_back (p_obj->p_ingress_));
       tiz_vector_pop_back (p_obj->p_ingress_);
     }
   tiz_vector_destroy (p_obj->p_ingress_);
@@ -186,13 +186,15 @@ deinit_ports_and_lists (void * ap_obj)
 
   while (tiz_vector_length (p_obj->p_egress_) > 0)
     {
-      p_list = *(tiz_vector_t **) tiz_vector_back (p_obj->p_egress_);
-      tiz_vector_clear (p_list);
-      tiz_vector_destroy (p_list);
+      hdr_ring_destroy (tiz_vector_back (p_obj->p_egress_));
       tiz_vector_pop_back (p_obj->p_egress_);
     }
   tiz_vector_destroy (p_obj->p_egress_);
   p_obj->p_egress_ = NULL;
+
+  tiz_vector_clear (p_obj->p_counters_);
+  tiz_vector_destroy (p_obj->p_counters_);
+  p_obj->p_counters_ = NULL;
 }
 
 static OMX_ERRORTYPE
@@ -413,6 +415,64 @@ krn_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
   return rc;
 }
 
+static OMX_ERRORTYPE
+get_perf_counters (const tiz_krn_t * ap_obj, OMX_HANDLETYPE ap_hdl,
+                   OMX_TIZONIA_CONFIG_PERFCOUNTERSTYPE * ap_perf)
+{
+  const void * servants[OMX_TIZONIA_ServantMax];
+  const OMX_U32 nports = tiz_vector_length (ap_obj->p_ports_);
+  uint64_t br_ns = 0;
+  OMX_U32 i = 0;
+
+  assert (ap_obj);
+  assert (ap_perf);
+
+  if (ap_perf->nSize < sizeof (OMX_TIZONIA_CONFIG_PERFCOUNTERSTYPE))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (OMX_ALL != ap_perf->nPortIndex && ap_perf->nPortIndex >= nports)
+    {
+      return OMX_ErrorBadPortIndex;
+    }
+
+  ap_perf->nBuffersIn = 0;
+  ap_perf->nBuffersOut = 0;
+  ap_perf->nBytesIn = 0;
+  ap_perf->nBytesOut = 0;
+  for (i = 0; i < nports; ++i)
+    {
+      if (OMX_ALL == ap_perf->nPortIndex || i == ap_perf->nPortIndex)
+        {
+          const tiz_krn_port_counters_t * p_counters
+            = get_counters (ap_obj, i);
+          ap_perf->nBuffersIn += p_counters->nbufs_in;
+          ap_perf->nBuffersOut += p_counters->nbufs_out;
+          ap_perf->nBytesIn += p_counters->nbytes_in;
+          ap_perf->nBytesOut += p_counters->nbytes_out;
+        }
+    }
+
+  tiz_prc_get_counters (tiz_get_prc (ap_hdl), &ap_perf->nBuffersReadyCalls,
+                        &br_ns);
+  ap_perf->nBuffersReadyTimeUs = br_ns / 1000;
+
+  servants[OMX_TIZONIA_ServantFsm] = tiz_get_fsm (ap_hdl);
+  servants[OMX_TIZONIA_ServantKernel] = ap_obj;
+  servants[OMX_TIZONIA_ServantProcessor] = tiz_get_prc (ap_hdl);
+  for (i = 0; i < OMX_TIZONIA_ServantMax; ++i)
+    {
+      tiz_srv_counters_t counters;
+      tiz_srv_get_counters (servants[i], &counters);
+      ap_perf->sServants[i].nMessages = counters.nmsgs;
+      ap_perf->sServants[i].nTimeUs = counters.time_ns / 1000;
+      ap_perf->sServants[i].nQueueHighWater = counters.queue_hwm;
+    }
+
+  return OMX_ErrorNone;
+}
+
 static OMX_ERRORTYPE
 krn_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
                OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
@@ -425,6 +485,13 @@ krn_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
 
   TIZ_TRACE (ap_hdl, "[%s]...", tiz_idx_to_str (a_index));
 
+  /* The performance counters are kept by the servants themselves, not by
+     any port */
+  if (OMX_TizoniaIndexConfigPerfCounters == a_index)
+    {
+      return get_perf_counters (p_obj, ap_hdl, ap_struct);
+    }
+
   /* Find the port that holds the data */
   if (OMX_ErrorNone
       == (rc = tiz_krn_find_managing_port (p_obj, a_index, ap_struct, &p_port)))
@@ -554,6 +621,15 @@ krn_GetExtensionIndex (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
                                       ap_index_type);
     }
 
+  if (OMX_ErrorUnsupportedIndex == rc
+      && 0 == strncmp (ap_param_name, OMX_TIZONIA_INDEX_CONFIG_PERFCOUNTERS,
+                       strlen (OMX_TIZONIA_INDEX_CONFIG_PERFCOUNTERS) + 1))
+    {
+      /* Supported by every component */
+      *ap_index_type = OMX_TizoniaIndexConfigPerfCounters;
+      rc = OMX_ErrorNone;
+    }
+
   return rc;
 }
 
@@ -1292,18 +1368,14 @@ krn_register_port (void * ap_obj, OMX_PTR ap_port, const bool ais_config)
     }
 
   {
-    /* Create the corresponding ingress and egress lists */
-    tiz_vector_t * p_in_list = NULL;
-    tiz_vector_t * p_out_list = NULL;
+    /* Create the corresponding ingress and egress lists; they are sized
+     * when the port is populated */
+    tiz_krn_hdr_ring_t empty_list = {NULL, 0, 0, 0};
+    tiz_krn_port_counters_t counters = {0, 0, 0, 0};
     OMX_U32 pid = 0;
-    tiz_check_omx (
-      tiz_vector_init (&(p_in_list), sizeof (OMX_BUFFERHEADERTYPE *)));
-    assert (p_in_list);
-    tiz_check_omx (
-      tiz_vector_init (&(p_out_list), sizeof (OMX_BUFFERHEADERTYPE *)));
-    assert (p_out_list);
-    tiz_check_omx (tiz_vector_push_back (p_obj->p_ingress_, &p_in_list));
-    tiz_check_omx (tiz_vector_push_back (p_obj->p_egress_, &p_out_list));
+    tiz_check_omx (tiz_vector_push_back (p_obj->p_ingress_, &empty_list));
+    tiz_check_omx (tiz_vector_push_back (p_obj->p_egress_, &empty_list));
+    tiz_check_omx (tiz_vector_push_back (p_obj->p_counters_, &counters));
 
     pid = tiz_vector_length (p_obj->p_ports_);
     tiz_port_set_index (ap_port, pid);
@@ -1589,7 +1661,7 @@ krn_select (const void * ap_obj, const OMX_U32 a_nports, tiz_pd_set_t * ap_set)
   const tiz_krn_t * p_obj = ap_obj;
   OMX_S32 i = 0;
   OMX_S32 nports = 0;
-  tiz_vector_t * p_list = NULL;
+  tiz_krn_hdr_ring_t * p_list = NULL;
 
   assert (ap_obj);
   assert (ap_set);
@@ -1605,7 +1677,7 @@ krn_select (const void * ap_obj, const OMX_U32 a_nports, tiz_pd_set_t * ap_set)
   for (i = 0; i < nports; ++i)
     {
       p_list = get_ingress_lst (p_obj, i);
-      if (tiz_vector_length (p_list) > 0)
+      if (hdr_ring_length (p_list) > 0)
         {
           TIZ_PD_SET (i, ap_set);
         }
@@ -1633,42 +1705,23 @@ tiz_krn_super_select (const void * a_class, const void * ap_obj,
 }
 
 static OMX_ERRORTYPE
-krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
-                  OMX_BUFFERHEADERTYPE ** app_hdr)
+claim_header (tiz_krn_t * ap_obj, OMX_PTR ap_port, tiz_krn_hdr_ring_t * ap_list,
+              const OMX_U32 a_pid, const OMX_U32 a_pos,
+              OMX_BUFFERHEADERTYPE ** app_hdr)
 {
-  tiz_krn_t * p_obj = (tiz_krn_t *) ap_obj;
+  tiz_krn_t * p_obj = ap_obj;
+  OMX_PTR p_port = ap_port;
+  tiz_krn_hdr_ring_t * p_list = ap_list;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-  tiz_vector_t * p_list = NULL;
-  OMX_PTR p_port = NULL;
 
   assert (ap_obj);
-  assert (check_pid (p_obj, a_pid) == OMX_ErrorNone);
+  assert (ap_port);
+  assert (ap_list);
   assert (app_hdr);
 
-  /* Find the port.. */
-  p_port = get_port (p_obj, a_pid);
-
-  TIZ_TRACE (handleOf (p_obj), "port's [%d] a_pos [%d] buf count [%d]...",
-             a_pid, a_pos, tiz_port_buffer_count (p_port));
-
-  /* Buffers can't be claimed in OMX_StatePause state */
-  assert (EStatePause != tiz_fsm_get_substate (tiz_get_fsm (handleOf (p_obj))));
-
-  /* Buffers can't be claimed on an disabled port */
-  assert (TIZ_PORT_IS_ENABLED (p_port));
-
-  /* Buffer position shall not be larger or equal than the buffer count */
-  assert (a_pos < tiz_port_buffer_count (p_port));
-
-  /* Grab the port's ingress list  */
-  p_list = get_ingress_lst (p_obj, a_pid);
-
-  /* Ingress list's size shall not be larger than the port's buffer count */
-  assert (tiz_vector_length (p_list) <= tiz_port_buffer_count (p_port));
-
   /* Only try to retrieve the buffer if that position exists in the list */
-  if (a_pos < tiz_vector_length (p_list))
+  if (a_pos < hdr_ring_length (p_list))
     {
       OMX_DIRTYPE pdir = OMX_DirMax;
 
@@ -1679,7 +1732,7 @@ krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
       TIZ_TRACE (handleOf (p_obj),
                  "port's [%d] HEADER [%p] BUFFER [%p] ingress "
                  "list length [%d]...",
-                 a_pid, p_hdr, p_hdr->pBuffer, tiz_vector_length (p_list));
+                 a_pid, p_hdr, p_hdr->pBuffer, hdr_ring_length (p_list));
 
       pdir = tiz_port_dir (p_port);
 
@@ -1700,7 +1753,7 @@ krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
         }
 
       /* ... and delete it from the list */
-      tiz_vector_erase (p_list, a_pos, 1);
+      hdr_ring_erase (p_list, a_pos);
 
       /* Now increment by one the claimed buffers count on this port */
       (void) TIZ_PORT_INC_CLAIMED_COUNT (p_port);
@@ -1731,6 +1784,45 @@ krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
 
   *app_hdr = p_hdr;
 
+  return rc;
+}
+
+static OMX_ERRORTYPE
+krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid, const OMX_U32 a_pos,
+                  OMX_BUFFERHEADERTYPE ** app_hdr)
+{
+  tiz_krn_t * p_obj = (tiz_krn_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  tiz_krn_hdr_ring_t * p_list = NULL;
+  OMX_PTR p_port = NULL;
+
+  assert (ap_obj);
+  assert (check_pid (p_obj, a_pid) == OMX_ErrorNone);
+  assert (app_hdr);
+
+  /* Find the port.. */
+  p_port = get_port (p_obj, a_pid);
+
+  TIZ_TRACE (handleOf (p_obj), "port's [%d] a_pos [%d] buf count [%d]...",
+             a_pid, a_pos, tiz_port_buffer_count (p_port));
+
+  /* Buffers can't be claimed in OMX_StatePause state */
+  assert (EStatePause != tiz_fsm_get_substate (tiz_get_fsm (handleOf (p_obj))));
+
+  /* Buffers can't be claimed on an disabled port */
+  assert (TIZ_PORT_IS_ENABLED (p_port));
+
+  /* Buffer position shall not be larger or equal than the buffer count */
+  assert (a_pos < tiz_port_buffer_count (p_port));
+
+  /* Grab the port's ingress list  */
+  p_list = get_ingress_lst (p_obj, a_pid);
+
+  /* Ingress list's size shall not be larger than the port's buffer count */
+  assert (hdr_ring_length (p_list) <= tiz_port_buffer_count (p_port));
+
+  rc = claim_header (p_obj, p_port, p_list, a_pid, a_pos, app_hdr);
+
   if (OMX_ErrorNone != rc)
     {
       TIZ_ERROR (handleOf (p_obj), "[%s]", tiz_err_to_str (rc));
@@ -1763,7 +1855,7 @@ krn_release_buffer (const void * ap_obj, const OMX_U32 a_pid,
                     OMX_BUFFERHEADERTYPE * ap_hdr)
 {
   tiz_krn_t * p_obj = (tiz_krn_t *) ap_obj;
-  tiz_vector_t * p_list = NULL;
+  tiz_krn_hdr_ring_t * p_list = NULL;
   OMX_PTR p_port = NULL;
 
   assert (ap_obj);
@@ -1786,11 +1878,12 @@ krn_release_buffer (const void * ap_obj, const OMX_U32 a_pid,
   p_list = get_egress_lst (p_obj, a_pid);
 
   TIZ_TRACE (handleOf (p_obj), "HEADER [%p] pid [%d] egress length [%d]...",
-             ap_hdr, a_pid, tiz_vector_length (p_list));
+             ap_hdr, a_pid, hdr_ring_length (p_list));
 
-  assert (tiz_vector_length (p_list) < tiz_port_buffer_count (p_port));
+  assert (hdr_ring_length (p_list) < tiz_port_buffer_count (p_port));
 
-  return enqueue_callback_msg (p_obj, ap_hdr, a_pid, tiz_port_dir (p_port));
+  return enqueue_callback_msg (p_obj, ap_hdr, a_pid, tiz_port_dir (p_port),
+                               true);
 }
 
 OMX_ERRORTYPE
@@ -1812,6 +1905,143 @@ tiz_krn_super_release_buffer (const void * a_class, const void * ap_obj,
   return superclass->release_buffer (ap_obj, a_pid, ap_hdr);
 }
 
+static OMX_ERRORTYPE
+krn_claim_buffers (const void * ap_obj, const OMX_U32 a_pid,
+                   OMX_BUFFERHEADERTYPE ** app_hdrs, const OMX_U32 a_max,
+                   OMX_U32 * ap_nclaimed)
+{
+  tiz_krn_t * p_obj = (tiz_krn_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  tiz_krn_hdr_ring_t * p_list = NULL;
+  OMX_PTR p_port = NULL;
+  OMX_U32 nclaimed = 0;
+
+  assert (ap_obj);
+  assert (check_pid (p_obj, a_pid) == OMX_ErrorNone);
+  assert (app_hdrs);
+  assert (ap_nclaimed);
+
+  /* Find the port.. */
+  p_port = get_port (p_obj, a_pid);
+
+  /* Buffers can't be claimed in OMX_StatePause state */
+  assert (EStatePause != tiz_fsm_get_substate (tiz_get_fsm (handleOf (p_obj))));
+
+  /* Buffers can't be claimed on an disabled port */
+  assert (TIZ_PORT_IS_ENABLED (p_port));
+
+  /* Grab the port's ingress list  */
+  p_list = get_ingress_lst (p_obj, a_pid);
+
+  TIZ_TRACE (handleOf (p_obj), "port's [%d] max [%d] ingress length [%d]...",
+             a_pid, a_max, hdr_ring_length (p_list));
+
+  while (nclaimed < a_max && hdr_ring_length (p_list) > 0
+         && OMX_ErrorNone == rc)
+    {
+      rc = claim_header (p_obj, p_port, p_list, a_pid, 0, &app_hdrs[nclaimed]);
+      if (OMX_ErrorNone == rc)
+        {
+          assert (app_hdrs[nclaimed]);
+          ++nclaimed;
+        }
+    }
+
+  *ap_nclaimed = nclaimed;
+
+  if (OMX_ErrorNone != rc)
+    {
+      TIZ_ERROR (handleOf (p_obj), "[%s]", tiz_err_to_str (rc));
+    }
+
+  return rc;
+}
+
+OMX_ERRORTYPE
+tiz_krn_claim_buffers (const void * ap_obj, const OMX_U32 a_pid,
+                       OMX_BUFFERHEADERTYPE ** app_hdrs, const OMX_U32 a_max,
+                       OMX_U32 * ap_nclaimed)
+{
+  const tiz_krn_class_t * class = classOf (ap_obj);
+  assert (class->claim_buffers);
+  return class->claim_buffers (ap_obj, a_pid, app_hdrs, a_max, ap_nclaimed);
+}
+
+OMX_ERRORTYPE
+tiz_krn_super_claim_buffers (const void * a_class, const void * ap_obj,
+                             const OMX_U32 a_pid,
+                             OMX_BUFFERHEADERTYPE ** app_hdrs,
+                             const OMX_U32 a_max, OMX_U32 * ap_nclaimed)
+{
+  const tiz_krn_class_t * superclass = super (a_class);
+  assert (ap_obj && superclass->claim_buffers);
+  return superclass->claim_buffers (ap_obj, a_pid, app_hdrs, a_max,
+                                    ap_nclaimed);
+}
+
+static OMX_ERRORTYPE
+krn_release_buffers (const void * ap_obj, const OMX_U32 a_pid,
+                     OMX_BUFFERHEADERTYPE ** app_hdrs, const OMX_U32 a_nhdrs)
+{
+  tiz_krn_t * p_obj = (tiz_krn_t *) ap_obj;
+  OMX_PTR p_port = NULL;
+  OMX_DIRTYPE pdir = OMX_DirMax;
+  OMX_U32 i = 0;
+
+  assert (ap_obj);
+  assert (app_hdrs || 0 == a_nhdrs);
+  assert (check_pid (p_obj, a_pid) == OMX_ErrorNone);
+
+  /* Find the port.. */
+  p_port = get_port (p_obj, a_pid);
+  pdir = tiz_port_dir (p_port);
+
+  TIZ_TRACE (handleOf (p_obj), "pid [%d] nhdrs [%d] egress length [%d]...",
+             a_pid, a_nhdrs, hdr_ring_length (get_egress_lst (p_obj, a_pid)));
+
+  assert (hdr_ring_length (get_egress_lst (p_obj, a_pid)) + a_nhdrs
+          <= tiz_port_buffer_count (p_port));
+
+  /* Only the last header's callback message flushes the egress lists, so
+   * that the whole batch leaves the component in one go */
+  for (i = 0; i < a_nhdrs; ++i)
+    {
+      OMX_BUFFERHEADERTYPE * p_hdr = app_hdrs[i];
+      assert (p_hdr);
+      /* Buffer headers associated to EGLImages don't have an associated
+       * buffer */
+      if (p_hdr->pBuffer)
+        {
+          assert ((p_hdr->nOffset + p_hdr->nFilledLen) <= p_hdr->nAllocLen);
+        }
+      tiz_check_omx (
+        enqueue_callback_msg (p_obj, p_hdr, a_pid, pdir, i + 1 == a_nhdrs));
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_krn_release_buffers (const void * ap_obj, const OMX_U32 a_pid,
+                         OMX_BUFFERHEADERTYPE ** app_hdrs,
+                         const OMX_U32 a_nhdrs)
+{
+  const tiz_krn_class_t * class = classOf (ap_obj);
+  assert (class->release_buffers);
+  return class->release_buffers (ap_obj, a_pid, app_hdrs, a_nhdrs);
+}
+
+OMX_ERRORTYPE
+tiz_krn_super_release_buffers (const void * a_class, const void * ap_obj,
+                               const OMX_U32 a_pid,
+                               OMX_BUFFERHEADERTYPE ** app_hdrs,
+                               const OMX_U32 a_nhdrs)
+{
+  const tiz_krn_class_t * superclass = super (a_class);
+  assert (ap_obj && superclass->release_buffers);
+  return superclass->release_buffers (ap_obj, a_pid, app_hdrs, a_nhdrs);
+}
+
 static OMX_ERRORTYPE
 krn_claim_eglimage (const void * ap_obj, const OMX_U32 a_pid,
                     const OMX_BUFFERHEADERTYPE * ap_hdr, OMX_PTR * app_eglimage)
@@ -2251,6 +2481,14 @@ krn_class_ctor (void * ap_obj, va_list * app)
         {
           *(voidf *) &p_obj->release_buffer = method;
         }
+      else if (selector == (voidf) tiz_krn_claim_buffers)
+        {
+          *(voidf *) &p_obj->claim_buffers = method;
+        }
+      else if (selector == (voidf) tiz_krn_release_buffers)
+        {
+          *(voidf *) &p_obj->release_buffers = method;
+        }
       else if (selector == (voidf) tiz_krn_claim_eglimage)
         {
           *(voidf *) &p_obj->claim_eglimage = method;
@@ -2383,6 +2621,10 @@ tiz_krn_init (void * ap_tos, void * ap_hdl)
      tiz_krn_claim_buffer, krn_claim_buffer,
      /* TIZ_CLASS_COMMENT: release_buffer */
      tiz_krn_release_buffer, krn_release_buffer,
+     /* TIZ_CLASS_COMMENT: claim_buffers */
+     tiz_krn_claim_buffers, krn_claim_buffers,
+     /* TIZ_CLASS_COMMENT: release_buffers */
+     tiz_krn_release_buffers, krn_release_buffers,
      /* TIZ_CLASS_COMMENT: claim_eglimage */
      tiz_krn_claim_eglimage, krn_claim_eglimage,
      /* TIZ_CLASS_COMMENT: deregister_all_ports */
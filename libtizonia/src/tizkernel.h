@@ -106,6 +106,42 @@ tiz_krn_claim_buffer (const void * ap_obj, const OMX_U32 a_pid,
 OMX_ERRORTYPE
 tiz_krn_release_buffer (const void * ap_obj, const OMX_U32 a_pid,
                         OMX_BUFFERHEADERTYPE * ap_hdr);
+/**
+ * Claim up to a_max headers from the front of a port's ingress list, in
+ * arrival order. This is equivalent to calling tiz_krn_claim_buffer with
+ * position 0 until it yields no header, or a_max headers have been claimed.
+ *
+ * @ingroup tizkernel
+ *
+ * @param ap_obj The 'kernel' servant object.
+ * @param a_pid The port index.
+ * @param[out] app_hdrs An array of at least a_max elements.
+ * @param a_max The maximum number of headers to claim.
+ * @param[out] ap_nclaimed The number of headers actually claimed.
+ * @return OMX_ErrorNone on success, other OMX_ERRORTYPE on error.
+ */
+OMX_ERRORTYPE
+tiz_krn_claim_buffers (const void * ap_obj, const OMX_U32 a_pid,
+                       OMX_BUFFERHEADERTYPE ** app_hdrs, const OMX_U32 a_max,
+                       OMX_U32 * ap_nclaimed);
+/**
+ * Release a number of headers of the same port, in order. The headers are
+ * returned to the tunneled component or the IL client as with
+ * tiz_krn_release_buffer, but the port's egress list is flushed only once,
+ * after the last header of the batch.
+ *
+ * @ingroup tizkernel
+ *
+ * @param ap_obj The 'kernel' servant object.
+ * @param a_pid The port index.
+ * @param app_hdrs The headers to release.
+ * @param a_nhdrs The number of headers in app_hdrs.
+ * @return OMX_ErrorNone on success, other OMX_ERRORTYPE on error.
+ */
+OMX_ERRORTYPE
+tiz_krn_release_buffers (const void * ap_obj, const OMX_U32 a_pid,
+                         OMX_BUFFERHEADERTYPE ** app_hdrs,
+                         const OMX_U32 a_nhdrs);
 /**
  * Retrieve the EGL image associated to a particular OpenMAX IL header.
  *
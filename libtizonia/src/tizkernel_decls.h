@@ -76,6 +76,7 @@ struct tiz_krn_msg_callback
   OMX_BUFFERHEADERTYPE * p_hdr;
   OMX_U32 pid;
   OMX_DIRTYPE dir;
+  bool flush; /* false for all but the last header of a batch release */
 };
 
 typedef struct tiz_krn_msg_plg_event tiz_krn_msg_plg_event_t;
@@ -105,14 +106,37 @@ struct tiz_krn_msg_str
   OMX_STRING str;
 };
 
+typedef struct tiz_krn_port_counters tiz_krn_port_counters_t;
+struct tiz_krn_port_counters
+{
+  uint64_t nbufs_in;
+  uint64_t nbufs_out;
+  uint64_t nbytes_in;
+  uint64_t nbytes_out;
+};
+
+/* A port's ingress or egress list. Headers are appended at the back and
+ * claimed from the front, so most insertions and removals are O(1). The
+ * capacity grows to the port's buffer count the first time the port is
+ * populated, and stays fixed after that. */
+typedef struct tiz_krn_hdr_ring tiz_krn_hdr_ring_t;
+struct tiz_krn_hdr_ring
+{
+  OMX_BUFFERHEADERTYPE ** pp_hdrs;
+  OMX_U32 cap;
+  OMX_U32 head;
+  OMX_U32 len;
+};
+
 typedef struct tiz_krn tiz_krn_t;
 struct tiz_krn
 {
   /* Object */
   const tiz_srv_t _;
   tiz_vector_t * p_ports_;
-  tiz_vector_t * p_ingress_;
-  tiz_vector_t * p_egress_;
+  tiz_vector_t * p_ingress_; /* tiz_krn_hdr_ring_t, one per port */
+  tiz_vector_t * p_egress_;  /* tiz_krn_hdr_ring_t, one per port */
+  tiz_vector_t * p_counters_; /* tiz_krn_port_counters_t, one per port */
   OMX_PTR p_cport_;
   OMX_PTR p_proc_;
   bool eos_;
@@ -148,6 +172,16 @@ tiz_krn_super_release_buffer (const void * a_class, const void * ap_obj,
                               const OMX_U32 a_pid,
                               OMX_BUFFERHEADERTYPE * ap_hdr);
 OMX_ERRORTYPE
+tiz_krn_super_claim_buffers (const void * a_class, const void * ap_obj,
+                             const OMX_U32 a_pid,
+                             OMX_BUFFERHEADERTYPE ** app_hdrs,
+                             const OMX_U32 a_max, OMX_U32 * ap_nclaimed);
+OMX_ERRORTYPE
+tiz_krn_super_release_buffers (const void * a_class, const void * ap_obj,
+                               const OMX_U32 a_pid,
+                               OMX_BUFFERHEADERTYPE ** app_hdrs,
+                               const OMX_U32 a_nhdrs);
+OMX_ERRORTYPE
 tiz_krn_super_claim_eglimage (const void * a_class, const void * ap_obj,
                               const OMX_U32 a_pid,
                               const OMX_BUFFERHEADERTYPE * p_hdr,
@@ -181,6 +215,12 @@ struct tiz_krn_class
    OMX_BUFFERHEADERTYPE ** p_hdr);
   OMX_ERRORTYPE (*release_buffer)
   (const void * ap_obj, const OMX_U32 a_pid, OMX_BUFFERHEADERTYPE * p_hdr);
+  OMX_ERRORTYPE (*claim_buffers)
+  (const void * ap_obj, const OMX_U32 a_pid, OMX_BUFFERHEADERTYPE ** app_hdrs,
+   const OMX_U32 a_max, OMX_U32 * ap_nclaimed);
+  OMX_ERRORTYPE (*release_buffers)
+  (const void * ap_obj, const OMX_U32 a_pid, OMX_BUFFERHEADERTYPE ** app_hdrs,
+   const OMX_U32 a_nhdrs);
   OMX_ERRORTYPE (*claim_eglimage)
   (const void * ap_obj, const OMX_U32 a_pid, const OMX_BUFFERHEADERTYPE * p_hdr,
    OMX_PTR * app_eglimage);
@@ -538,7 +538,7 @@ static OMX_ERRORTYPE dispatch_cb (void *ap_obj, OMX_PTR ap_msg)
   tiz_krn_msg_t *p_msg = ap_msg;
   tiz_krn_msg_callback_t *p_msg_cb = NULL;
   tiz_fsm_state_id_t now = (tiz_fsm_state_id_t)OMX_StateMax;
-  tiz_vector_t *p_egress_lst = NULL;
+  tiz_krn_hdr_ring_t *p_egress_lst = NULL;
   OMX_PTR p_port = NULL;
   OMX_S32 claimed_count = 0;
   OMX_HANDLETYPE p_hdl = NULL;
@@ -579,13 +579,14 @@ static OMX_ERRORTYPE dispatch_cb (void *ap_obj, OMX_PTR ap_msg)
       if (NULL == p_hdr && OMX_DirMax == p_msg_cb->dir)
         {
           TIZ_TRACE (p_hdl, "Enqueueing another dummy callback...");
-          rc = enqueue_callback_msg (p_obj, NULL, 0, OMX_DirMax);
+          rc = enqueue_callback_msg (p_obj, NULL, 0, OMX_DirMax, true);
         }
       else
         {
           /* ...add the header to the egress list... */
           if (OMX_ErrorNone
-              != (rc = tiz_vector_push_back (p_egress_lst, &p_hdr)))
+              != (rc = hdr_ring_push_back (p_egress_lst, p_hdr,
+                                           tiz_port_buffer_count (p_port))))
             {
               TIZ_ERROR (p_hdl,
                          "[%s] : Could not add HEADER [%p] "
@@ -611,7 +612,9 @@ static OMX_ERRORTYPE dispatch_cb (void *ap_obj, OMX_PTR ap_msg)
     }
 
   /* ...add the header to the egress list... */
-  if (OMX_ErrorNone != (rc = tiz_vector_push_back (p_egress_lst, &p_hdr)))
+  if (OMX_ErrorNone
+      != (rc = hdr_ring_push_back (p_egress_lst, p_hdr,
+                                   tiz_port_buffer_count (p_port))))
     {
       TIZ_ERROR (p_hdl,
                  "[%s] : Could not add header [%p] to "
@@ -623,7 +626,12 @@ static OMX_ERRORTYPE dispatch_cb (void *ap_obj, OMX_PTR ap_msg)
     {
       /* Now decrement by one the port's claimed buffers count */
       claimed_count = TIZ_PORT_DEC_CLAIMED_COUNT (p_port);
+    }
 
+  /* The headers of a batch release stay in the egress list until the last
+   * one of the batch arrives */
+  if (OMX_ErrorNone == rc && (p_msg_cb->flush || 0 == claimed_count))
+    {
       if ((ESubStateExecutingToIdle == now || ESubStatePauseToIdle == now)
           && TIZ_PORT_IS_ENABLED_TUNNELED_AND_SUPPLIER (p_port))
         {
@@ -801,6 +809,15 @@ static OMX_ERRORTYPE dispatch_efb (void *ap_obj, OMX_PTR ap_msg,
   /* Retrieve the port... */
   p_port = get_port (p_obj, pid);
 
+  {
+    tiz_krn_port_counters_t *p_counters = get_counters (p_obj, pid);
+    p_counters->nbufs_in++;
+    if (OMX_DirInput == dir)
+      {
+        p_counters->nbytes_in += p_hdr->nFilledLen;
+      }
+  }
+
   /* Add this buffer to the port's ingress hdr list */
   if (0 > (nbufs = add_to_buflst (p_obj, p_obj->p_ingress_, p_hdr, p_port)))
     {
@@ -990,7 +1007,7 @@ static OMX_ERRORTYPE dispatch_pause_to_exe (tiz_krn_t *ap_krn,
   *ap_done = true;
   /* Enqueue a dummy callback msg to be processed ...   */
   /* ...in case there are headers present in the egress lists... */
-  return enqueue_callback_msg (ap_krn, NULL, 0, OMX_DirMax);
+  return enqueue_callback_msg (ap_krn, NULL, 0, OMX_DirMax, true);
 }
 
 static OMX_ERRORTYPE dispatch_exe_to_exe (tiz_krn_t *ap_krn,
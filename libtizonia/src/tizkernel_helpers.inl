@@ -94,26 +94,33 @@ static void preemption_complete (OMX_U32 rid, OMX_PTR ap_data)
   deliver_pluggable_event (rid, ap_data);
 }
 
-static inline tiz_vector_t *get_ingress_lst (const tiz_krn_t *ap_obj,
-                                             OMX_U32 a_pid)
+#include "tizkernel_ring.inl"
+
+static inline tiz_krn_hdr_ring_t *get_hdr_lst (const tiz_vector_t *ap_lists,
+                                              OMX_U32 a_pid)
+{
+  tiz_krn_hdr_ring_t *p_list = NULL;
+  assert (ap_lists);
+  assert (a_pid < tiz_vector_length (ap_lists));
+  p_list = tiz_vector_at (ap_lists, a_pid);
+  assert (p_list);
+  return p_list;
+}
+
+static inline tiz_krn_hdr_ring_t *get_ingress_lst (const tiz_krn_t *ap_obj,
+                                                   OMX_U32 a_pid)
 {
-  tiz_vector_t *p_list = NULL;
   assert (ap_obj);
   /* Grab the port's ingress list */
-  p_list = tiz_vector_at (ap_obj->p_ingress_, a_pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  return (*(tiz_vector_t **)p_list);
+  return get_hdr_lst (ap_obj->p_ingress_, a_pid);
 }
 
-static inline tiz_vector_t *get_egress_lst (const tiz_krn_t *ap_obj,
-                                            OMX_U32 a_pid)
+static inline tiz_krn_hdr_ring_t *get_egress_lst (const tiz_krn_t *ap_obj,
+                                                  OMX_U32 a_pid)
 {
-  tiz_vector_t *p_list = NULL;
   assert (ap_obj);
   /* Grab the port's egress list */
-  p_list = tiz_vector_at (ap_obj->p_egress_, a_pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  return (*(tiz_vector_t **)p_list);
+  return get_hdr_lst (ap_obj->p_egress_, a_pid);
 }
 
 static inline OMX_PTR get_port (const tiz_krn_t *ap_obj, const OMX_U32 a_pid)
@@ -126,71 +133,48 @@ static inline OMX_PTR get_port (const tiz_krn_t *ap_obj, const OMX_U32 a_pid)
   return *pp_port;
 }
 
-static inline OMX_BUFFERHEADERTYPE *get_header (const tiz_vector_t *ap_list,
-                                                OMX_U32 a_index)
+static inline tiz_krn_port_counters_t *get_counters (const tiz_krn_t *ap_obj,
+                                                     const OMX_U32 a_pid)
 {
-  OMX_BUFFERHEADERTYPE **pp_hdr = NULL;
+  tiz_krn_port_counters_t *p_counters = NULL;
+  assert (ap_obj);
+  p_counters = tiz_vector_at (ap_obj->p_counters_, a_pid);
+  assert (p_counters);
+  return p_counters;
+}
+
+static inline OMX_BUFFERHEADERTYPE *get_header (
+    const tiz_krn_hdr_ring_t *ap_list, OMX_U32 a_index)
+{
+  OMX_BUFFERHEADERTYPE *p_hdr = NULL;
   assert (ap_list);
-  assert (a_index < tiz_vector_length (ap_list));
+  assert (a_index < hdr_ring_length (ap_list));
   /* Retrieve the header... */
-  pp_hdr = tiz_vector_at (ap_list, a_index);
-  assert (pp_hdr && *pp_hdr);
-  return *pp_hdr;
+  p_hdr = *hdr_ring_slot (ap_list, a_index);
+  assert (p_hdr);
+  return p_hdr;
 }
 
 static OMX_S32 move_to_ingress (void *ap_obj, OMX_U32 a_pid)
 {
-
   tiz_krn_t *p_obj = ap_obj;
-  tiz_vector_t *p_elist = NULL;
-  tiz_vector_t *p_ilist = NULL;
   const OMX_S32 nports = tiz_vector_length (p_obj->p_ports_);
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
 
   assert (a_pid < nports);
 
-  p_elist = tiz_vector_at (p_obj->p_egress_, a_pid);
-  p_ilist = tiz_vector_at (p_obj->p_ingress_, a_pid);
-  assert (p_elist && *(tiz_vector_t **)p_elist);
-  p_elist = *(tiz_vector_t **)p_elist;
-  assert (p_ilist && *(tiz_vector_t **)p_elist);
-  p_ilist = *(tiz_vector_t **)p_ilist;
-  rc = tiz_vector_append (p_ilist, p_elist);
-  tiz_vector_clear (p_elist);
-
-  if (OMX_ErrorNone != rc)
-    {
-      return -1;
-    }
-
-  return tiz_vector_length (p_ilist);
+  return hdr_ring_splice (get_ingress_lst (p_obj, a_pid),
+                          get_egress_lst (p_obj, a_pid));
 }
 
 static OMX_S32 move_to_egress (void *ap_obj, OMX_U32 a_pid)
 {
   tiz_krn_t *p_obj = ap_obj;
   const OMX_S32 nports = tiz_vector_length (p_obj->p_ports_);
-  tiz_vector_t *p_elist = NULL;
-  tiz_vector_t *p_ilist = NULL;
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
 
   assert (a_pid < nports);
 
-  p_elist = tiz_vector_at (p_obj->p_egress_, a_pid);
-  p_ilist = tiz_vector_at (p_obj->p_ingress_, a_pid);
-  assert (p_elist && *(tiz_vector_t **)p_elist);
-  p_elist = *(tiz_vector_t **)p_elist;
-  assert (p_ilist && *(tiz_vector_t **)p_ilist);
-  p_ilist = *(tiz_vector_t **)p_ilist;
-  rc = tiz_vector_append (p_elist, p_ilist);
-  tiz_vector_clear (p_ilist);
-
-  if (OMX_ErrorNone != rc)
-    {
-      return -1;
-    }
-
-  return tiz_vector_length (p_elist);
+  return hdr_ring_splice (get_egress_lst (p_obj, a_pid),
+                          get_ingress_lst (p_obj, a_pid));
 }
 
 static OMX_S32 add_to_buflst (void *ap_obj, tiz_vector_t *ap_dst2darr,
@@ -198,55 +182,49 @@ static OMX_S32 add_to_buflst (void *ap_obj, tiz_vector_t *ap_dst2darr,
                               const void *ap_port)
 {
   const tiz_krn_t *p_obj = ap_obj;
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdr_ring_t *p_list = NULL;
   const OMX_U32 pid = tiz_port_index (ap_port);
 
   assert (ap_obj);
   assert (ap_dst2darr);
   assert (ap_hdr);
-  assert (tiz_vector_length (ap_dst2darr) >= pid);
 
-  p_list = tiz_vector_at (ap_dst2darr, pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  p_list = *(tiz_vector_t **)p_list;
+  p_list = get_hdr_lst (ap_dst2darr, pid);
 
   TIZ_TRACE (handleOf (p_obj),
              "HEADER [%p] BUFFER [%p] PID [%d] "
              "list size [%d] buf count [%d]",
-             ap_hdr, ap_hdr->pBuffer, pid, tiz_vector_length (p_list),
+             ap_hdr, ap_hdr->pBuffer, pid, hdr_ring_length (p_list),
              tiz_port_buffer_count (ap_port));
 
-  assert (tiz_vector_length (p_list) < tiz_port_buffer_count (ap_port));
+  assert (hdr_ring_length (p_list) < tiz_port_buffer_count (ap_port));
 
-  if (OMX_ErrorNone != tiz_vector_push_back (p_list, &ap_hdr))
+  if (OMX_ErrorNone
+      != hdr_ring_push_back (p_list, (OMX_BUFFERHEADERTYPE *)ap_hdr,
+                             tiz_port_buffer_count (ap_port)))
     {
       return -1;
     }
   else
     {
-      assert (tiz_vector_length (p_list) <= tiz_port_buffer_count (ap_port));
-      return tiz_vector_length (p_list);
+      assert (hdr_ring_length (p_list) <= tiz_port_buffer_count (ap_port));
+      return hdr_ring_length (p_list);
     }
 }
 
 static OMX_S32 clear_hdr_contents (tiz_vector_t *ap_hdr_lst, OMX_U32 a_pid)
 {
-  tiz_vector_t *p_list = NULL;
-  OMX_BUFFERHEADERTYPE *p_hdr = NULL;
+  tiz_krn_hdr_ring_t *p_list = NULL;
   OMX_S32 i, hdr_count = 0;
 
   assert (ap_hdr_lst);
-  assert (tiz_vector_length (ap_hdr_lst) >= a_pid);
 
-  p_list = tiz_vector_at (ap_hdr_lst, a_pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  p_list = *(tiz_vector_t **)p_list;
+  p_list = get_hdr_lst (ap_hdr_lst, a_pid);
 
-  hdr_count = tiz_vector_length (p_list);
+  hdr_count = hdr_ring_length (p_list);
   for (i = 0; i < hdr_count; ++i)
     {
-      p_hdr = get_header (p_list, i);
-      tiz_clear_header (p_hdr);
+      tiz_clear_header (get_header (p_list, i));
     }
 
   return hdr_count;
@@ -256,25 +234,31 @@ static OMX_ERRORTYPE append_buflsts (tiz_vector_t *ap_dst2darr,
                                      const tiz_vector_t *ap_srclst,
                                      OMX_U32 a_pid)
 {
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdr_ring_t *p_list = NULL;
+  const OMX_S32 nhdrs = tiz_vector_length (ap_srclst);
+  OMX_S32 i = 0;
+
   assert (ap_dst2darr);
   assert (ap_srclst);
-  assert (tiz_vector_length (ap_dst2darr) >= a_pid);
 
-  p_list = tiz_vector_at (ap_dst2darr, a_pid);
-  assert (p_list && *(tiz_vector_t **)p_list);
-  p_list = *(tiz_vector_t **)p_list;
+  p_list = get_hdr_lst (ap_dst2darr, a_pid);
 
   /* Make sure the list is empty, before appending anything */
-  tiz_vector_clear (p_list);
+  hdr_ring_clear (p_list);
+
+  for (i = 0; i < nhdrs; ++i)
+    {
+      OMX_BUFFERHEADERTYPE **pp_hdr = tiz_vector_at (ap_srclst, i);
+      assert (pp_hdr && *pp_hdr);
+      tiz_check_omx (hdr_ring_push_back (p_list, *pp_hdr, nhdrs));
+    }
 
-  return tiz_vector_append (p_list, ap_srclst);
+  return OMX_ErrorNone;
 }
 
 static void clear_hdr_lsts (void *ap_obj, const OMX_U32 a_pid)
 {
   tiz_krn_t *p_obj = ap_obj;
-  tiz_vector_t *p_list = NULL;
   OMX_S32 i = 0;
   OMX_U32 pid = 0;
   OMX_S32 nports = 0;
@@ -285,17 +269,8 @@ static void clear_hdr_lsts (void *ap_obj, const OMX_U32 a_pid)
   do
     {
       pid = ((OMX_ALL != a_pid) ? a_pid : i);
-
-      p_list = tiz_vector_at (p_obj->p_ingress_, pid);
-      assert (p_list && *(tiz_vector_t **)p_list);
-      p_list = *(tiz_vector_t **)p_list;
-      tiz_vector_clear (p_list);
-
-      p_list = tiz_vector_at (p_obj->p_egress_, pid);
-      assert (p_list && *(tiz_vector_t **)p_list);
-      p_list = *(tiz_vector_t **)p_list;
-      tiz_vector_clear (p_list);
-
+      hdr_ring_clear (get_ingress_lst (p_obj, pid));
+      hdr_ring_clear (get_egress_lst (p_obj, pid));
       ++i;
     }
   while (OMX_ALL == pid && i < nports);
@@ -343,7 +318,7 @@ static OMX_ERRORTYPE propagate_ingress (void *ap_obj, OMX_U32 a_pid)
 {
   tiz_krn_t *p_obj = ap_obj;
   void *p_prc = NULL;
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdr_ring_t *p_list = NULL;
   OMX_PTR p_port = NULL;
   OMX_BUFFERHEADERTYPE *p_hdr = NULL;
   OMX_S32 i = 0;
@@ -370,9 +345,9 @@ static OMX_ERRORTYPE propagate_ingress (void *ap_obj, OMX_U32 a_pid)
       /* Grab the port's ingress list */
       p_list = get_ingress_lst (p_obj, pid);
       TIZ_TRACE (handleOf (p_obj), "port [%d]'s ingress list length [%d]...",
-                 pid, tiz_vector_length (p_list));
+                 pid, hdr_ring_length (p_list));
 
-      nbufs = tiz_vector_length (p_list);
+      nbufs = hdr_ring_length (p_list);
       for (j = 0; j < nbufs; ++j)
         {
           /* Retrieve the header... */
@@ -579,7 +554,7 @@ static OMX_ERRORTYPE flush_egress (void *ap_obj, const OMX_U32 a_pid,
                                    const OMX_BOOL a_clear)
 {
   tiz_krn_t *p_obj = ap_obj;
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdr_ring_t *p_list = NULL;
   OMX_PTR p_port = NULL;
   OMX_BUFFERHEADERTYPE *p_hdr = NULL;
   OMX_S32 i = 0;
@@ -609,9 +584,9 @@ static OMX_ERRORTYPE flush_egress (void *ap_obj, const OMX_U32 a_pid,
       TIZ_TRACE (p_hdl,
                  "pid [%d] loop index=[%d] egress length [%d] "
                  "- p_thdl [%p]...",
-                 pid, i, tiz_vector_length (p_list), p_thdl);
+                 pid, i, hdr_ring_length (p_list), p_thdl);
 
-      while (tiz_vector_length (p_list) > 0)
+      while (hdr_ring_length (p_list) > 0)
         {
           /* Retrieve the header... */
           p_hdr = get_header (p_list, 0);
@@ -672,10 +647,18 @@ static OMX_ERRORTYPE flush_egress (void *ap_obj, const OMX_U32 a_pid,
               }
 
             /* get rid of the buffer */
+            {
+              tiz_krn_port_counters_t *p_counters = get_counters (p_obj, pid);
+              p_counters->nbufs_out++;
+              if (OMX_DirOutput == pdir)
+                {
+                  p_counters->nbytes_out += p_hdr->nFilledLen;
+                }
+            }
             tiz_srv_issue_buf_callback ((OMX_PTR)ap_obj, p_hdr, pid, pdir,
                                         p_thdl);
             /* ... and delete it from the list. */
-            tiz_vector_erase (p_list, 0, 1);
+            hdr_ring_erase (p_list, 0);
           }
         }
       ++i;
@@ -1004,7 +987,7 @@ static inline tiz_krn_msg_t *init_krn_message (
 static OMX_ERRORTYPE enqueue_callback_msg (
     const void *ap_obj,
     /*@null@*/ OMX_BUFFERHEADERTYPE *ap_hdr, const OMX_U32 a_pid,
-    const OMX_DIRTYPE a_dir)
+    const OMX_DIRTYPE a_dir, const bool a_flush)
 {
   tiz_krn_t *p_obj = (tiz_krn_t *)ap_obj;
   tiz_krn_msg_t *p_msg = NULL;
@@ -1029,6 +1012,7 @@ static OMX_ERRORTYPE enqueue_callback_msg (
   p_msg_cb->p_hdr = ap_hdr;
   p_msg_cb->pid = a_pid;
   p_msg_cb->dir = a_dir;
+  p_msg_cb->flush = a_flush;
   return tiz_srv_enqueue (ap_obj, p_msg, 1);
 }
 
@@ -1238,7 +1222,7 @@ static bool all_buffers_returned (void *ap_obj)
   tiz_krn_t *p_obj = ap_obj;
   OMX_S32 nports = 0;
   OMX_PTR p_port = NULL;
-  tiz_vector_t *p_list = NULL;
+  tiz_krn_hdr_ring_t *p_list = NULL;
   OMX_U32 i;
   OMX_S32 nbuf = 0, nbufin = 0;
 
@@ -1260,7 +1244,7 @@ static bool all_buffers_returned (void *ap_obj)
         {
           p_list = get_ingress_lst (p_obj, i);
 
-          if ((nbufin = tiz_vector_length (p_list)) != nbuf)
+          if ((nbufin = hdr_ring_length (p_list)) != nbuf)
             {
               int j = 0;
               OMX_BUFFERHEADERTYPE *p_hdr = NULL;
@@ -0,0 +1,165 @@
+/* -*-Mode: c; -*- */
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizkernel_ring.inl
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia OpenMAX IL - kernel's header lists
+ *
+ * @remark This file is meant to be included in the main tizkernel.c module to
+ * create a single compilation unit (the unit tests include it too).
+ *
+ */
+
+#ifndef TIZKERNEL_RING_INL
+#define TIZKERNEL_RING_INL
+
+static inline OMX_BUFFERHEADERTYPE **hdr_ring_slot (
+    const tiz_krn_hdr_ring_t *ap_ring, const OMX_U32 a_index)
+{
+  OMX_U32 idx = 0;
+  assert (ap_ring);
+  assert (a_index < ap_ring->cap);
+  idx = ap_ring->head + a_index;
+  if (idx >= ap_ring->cap)
+    {
+      idx -= ap_ring->cap;
+    }
+  return &(ap_ring->pp_hdrs[idx]);
+}
+
+static OMX_ERRORTYPE hdr_ring_reserve (tiz_krn_hdr_ring_t *ap_ring,
+                                       const OMX_U32 a_cap)
+{
+  OMX_BUFFERHEADERTYPE **pp_hdrs = NULL;
+  OMX_U32 i = 0;
+
+  assert (ap_ring);
+
+  if (a_cap <= ap_ring->cap)
+    {
+      return OMX_ErrorNone;
+    }
+
+  /* Only happens the first time the port is populated, or after its buffer
+   * count has been increased; the headers are moved to the start of the new
+   * array */
+  tiz_check_null_ret_oom (
+      pp_hdrs = tiz_mem_calloc (a_cap, sizeof(OMX_BUFFERHEADERTYPE *)));
+  for (i = 0; i < ap_ring->len; ++i)
+    {
+      pp_hdrs[i] = *hdr_ring_slot (ap_ring, i);
+    }
+  tiz_mem_free (ap_ring->pp_hdrs);
+  ap_ring->pp_hdrs = pp_hdrs;
+  ap_ring->cap = a_cap;
+  ap_ring->head = 0;
+  return OMX_ErrorNone;
+}
+
+static void hdr_ring_destroy (tiz_krn_hdr_ring_t *ap_ring)
+{
+  assert (ap_ring);
+  tiz_mem_free (ap_ring->pp_hdrs);
+  ap_ring->pp_hdrs = NULL;
+  ap_ring->cap = 0;
+  ap_ring->head = 0;
+  ap_ring->len = 0;
+}
+
+static inline OMX_S32 hdr_ring_length (const tiz_krn_hdr_ring_t *ap_ring)
+{
+  assert (ap_ring);
+  return ap_ring->len;
+}
+
+static inline void hdr_ring_clear (tiz_krn_hdr_ring_t *ap_ring)
+{
+  assert (ap_ring);
+  ap_ring->head = 0;
+  ap_ring->len = 0;
+}
+
+static OMX_ERRORTYPE hdr_ring_push_back (tiz_krn_hdr_ring_t *ap_ring,
+                                         OMX_BUFFERHEADERTYPE *ap_hdr,
+                                         const OMX_U32 a_cap)
+{
+  assert (ap_ring);
+  assert (ap_hdr);
+  tiz_check_omx (hdr_ring_reserve (ap_ring, MAX (a_cap, ap_ring->len + 1)));
+  ap_ring->len++;
+  *hdr_ring_slot (ap_ring, ap_ring->len - 1) = ap_hdr;
+  return OMX_ErrorNone;
+}
+
+static void hdr_ring_erase (tiz_krn_hdr_ring_t *ap_ring, const OMX_U32 a_index)
+{
+  OMX_U32 i = 0;
+
+  assert (ap_ring);
+  assert (a_index < ap_ring->len);
+
+  /* Close the gap from whichever end is nearer; removing the front header,
+   * which is by far the most common case, is O(1) */
+  if (2 * a_index < ap_ring->len)
+    {
+      for (i = a_index; i > 0; --i)
+        {
+          *hdr_ring_slot (ap_ring, i) = *hdr_ring_slot (ap_ring, i - 1);
+        }
+      ap_ring->head = (ap_ring->head + 1 == ap_ring->cap) ? 0
+                                                          : ap_ring->head + 1;
+    }
+  else
+    {
+      for (i = a_index; i + 1 < ap_ring->len; ++i)
+        {
+          *hdr_ring_slot (ap_ring, i) = *hdr_ring_slot (ap_ring, i + 1);
+        }
+    }
+  ap_ring->len--;
+}
+
+/* Appends all of ap_src's headers to ap_dst, and empties ap_src */
+static OMX_S32 hdr_ring_splice (tiz_krn_hdr_ring_t *ap_dst,
+                                tiz_krn_hdr_ring_t *ap_src)
+{
+  OMX_U32 i = 0;
+
+  assert (ap_dst);
+  assert (ap_src);
+
+  if (OMX_ErrorNone != hdr_ring_reserve (ap_dst, ap_dst->len + ap_src->len))
+    {
+      return -1;
+    }
+
+  for (i = 0; i < ap_src->len; ++i)
+    {
+      ap_dst->len++;
+      *hdr_ring_slot (ap_dst, ap_dst->len - 1) = *hdr_ring_slot (ap_src, i);
+    }
+  hdr_ring_clear (ap_src);
+
+  return ap_dst->len;
+}
+
+#endif /* TIZKERNEL_RING_INL */
@@ -31,6 +31,7 @@
 #endif
 
 #include <assert.h>
+#include <pthread.h>
 #include <string.h>
 
 #include <tizplatform.h>
@@ -85,13 +86,6 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.tizonia.objsys"
 #endif
 
-struct tiz_os
-{
-  tiz_map_t * p_map;
-  OMX_HANDLETYPE p_hdl;
-  tiz_soa_t * p_soa;
-};
-
 typedef enum tiz_os_type tiz_os_type_t;
 enum tiz_os_type
 {
@@ -177,10 +171,15 @@ enum tiz_os_type
   ETIZUricfgport,
   ETIZDemuxercfgport_class,
   ETIZDemuxercfgport,
+  ETIZTypeCount
 };
 
 #define TIZ_OS_BASE_TYPE_END ETIZConfigport
 
+/* Size of the process-wide name-to-id table (a power of two, and at least
+   twice the number of built-in types) */
+#define TIZ_OS_TYPE_HASH_SIZE 256
+
 static const tiz_os_type_init_f tiz_os_type_to_fnt_tbl[] = {
   tiz_class_init,
   tiz_object_init,
@@ -358,6 +357,91 @@ static tiz_os_type_str_t tiz_os_type_to_str_tbl[] = {
   {ETIZDemuxercfgport, "tizdemuxercfgport"},
 };
 
+/* A type registered by the component itself (see tiz_os_register_type) */
+typedef struct tiz_os_ext_type tiz_os_ext_type_t;
+struct tiz_os_ext_type
+{
+  char * p_name;
+  void * p_obj;
+};
+
+struct tiz_os
+{
+  OMX_HANDLETYPE p_hdl;
+  tiz_soa_t * p_soa;
+  /* The component's instances of the built-in types, indexed by type id. The
+     classes hold the component handle (see handleOf), so they can't be shared
+     with other components; they are created on first use */
+  void * p_types[ETIZTypeCount];
+  tiz_os_ext_type_t * p_ext_types;
+  OMX_S32 n_ext_types;
+  OMX_S32 max_ext_types;
+};
+
+/* Process-wide, read-only once built: maps the names of the built-in types
+   to their ids (the slots hold id + 1; 0 means empty) */
+static OMX_S16 g_type_hash[TIZ_OS_TYPE_HASH_SIZE];
+static pthread_once_t g_type_hash_once = PTHREAD_ONCE_INIT;
+
+static inline OMX_U32
+type_name_hash (const char * ap_name)
+{
+  /* FNV-1a */
+  OMX_U32 h = 2166136261u;
+  for (; *ap_name; ++ap_name)
+    {
+      h = (h ^ (unsigned char) *ap_name) * 16777619u;
+    }
+  return h;
+}
+
+static void
+build_type_hash (void)
+{
+  OMX_S32 type_id = 0;
+  OMX_U32 h = 0;
+
+  assert (sizeof (tiz_os_type_to_str_tbl) / sizeof (tiz_os_type_str_t)
+          == ETIZTypeCount);
+  assert (sizeof (tiz_os_type_to_fnt_tbl) / sizeof (tiz_os_type_init_f)
+          == ETIZTypeCount);
+  assert (2 * ETIZTypeCount <= TIZ_OS_TYPE_HASH_SIZE);
+
+  for (type_id = 0; type_id < ETIZTypeCount; ++type_id)
+    {
+      assert (tiz_os_type_to_str_tbl[type_id].type == type_id);
+      h = type_name_hash (tiz_os_type_to_str_tbl[type_id].str)
+          & (TIZ_OS_TYPE_HASH_SIZE - 1);
+      while (g_type_hash[h])
+        {
+          h = (h + 1) & (TIZ_OS_TYPE_HASH_SIZE - 1);
+        }
+      g_type_hash[h] = type_id + 1;
+    }
+}
+
+/* Returns the id of a built-in type, or -1 */
+static OMX_S32
+builtin_type_id (const char * ap_name)
+{
+  OMX_U32 h = 0;
+  OMX_S16 slot = 0;
+
+  (void) pthread_once (&g_type_hash_once, build_type_hash);
+
+  h = type_name_hash (ap_name) & (TIZ_OS_TYPE_HASH_SIZE - 1);
+  while ((slot = g_type_hash[h]))
+    {
+      if (0 == strncmp (ap_name, tiz_os_type_to_str_tbl[slot - 1].str,
+                        OMX_MAX_STRINGNAME_SIZE))
+        {
+          return slot - 1;
+        }
+      h = (h + 1) & (TIZ_OS_TYPE_HASH_SIZE - 1);
+    }
+  return -1;
+}
+
 static /*@null@ */ void *
 os_calloc (/*@null@ */ tiz_soa_t * p_soa, size_t a_size)
 {
@@ -376,8 +460,6 @@ os_strndup (tiz_soa_t * p_soa, const char * s, size_t n)
   char * result;
   size_t len = strlen (s);
 
-  assert (p_soa);
-
   if (n < len)
     {
       len = n;
@@ -392,41 +474,72 @@ os_strndup (tiz_soa_t * p_soa, const char * s, size_t n)
   return (char *) memcpy (result, s, len);
 }
 
-static OMX_S32
-os_map_compare_func (OMX_PTR ap_key1, OMX_PTR ap_key2)
+static tiz_os_ext_type_t *
+find_ext_type (const tiz_os_t * ap_os, const char * ap_name)
 {
-  return strncmp ((const char *) ap_key1, (const char *) ap_key2,
-                  OMX_MAX_STRINGNAME_SIZE);
+  OMX_S32 i = 0;
+  assert (ap_os);
+  for (i = 0; i < ap_os->n_ext_types; ++i)
+    {
+      if (0 == strncmp (ap_name, ap_os->p_ext_types[i].p_name,
+                        OMX_MAX_STRINGNAME_SIZE))
+        {
+          return &(ap_os->p_ext_types[i]);
+        }
+    }
+  return NULL;
 }
 
 static void
-os_map_free_func (OMX_PTR ap_key, OMX_PTR ap_value)
+print_types (const tiz_os_t * ap_os)
 {
-  /* Don't bother deleting the keys here as they are allocated from the chunk
-     of memory provided by the small object allocator, which gets released when
-     the component is deinited. */
-  tiz_mem_free (ap_value);
-}
-
 #ifdef _DEBUG
-static OMX_S32
-print_function (OMX_PTR ap_key, OMX_PTR ap_value, OMX_PTR ap_arg)
-{
-  const char * name = ap_key;
-  tiz_os_t * p_os = ap_arg;
-  TIZ_TRACE (p_os->p_hdl, "type [%s]->[%p]", name, ap_value);
-  return 0;
-}
+  OMX_S32 i = 0;
+  assert (ap_os);
+  for (i = 0; i < ETIZTypeCount; ++i)
+    {
+      if (ap_os->p_types[i])
+        {
+          TIZ_TRACE (ap_os->p_hdl, "type [%s]->[%p]",
+                     tiz_os_type_to_str_tbl[i].str, ap_os->p_types[i]);
+        }
+    }
+  for (i = 0; i < ap_os->n_ext_types; ++i)
+    {
+      TIZ_TRACE (ap_os->p_hdl, "type [%s]->[%p]", ap_os->p_ext_types[i].p_name,
+                 ap_os->p_ext_types[i].p_obj);
+    }
 #endif
+}
 
-static void
-print_types (const tiz_os_t * ap_os)
+static OMX_ERRORTYPE
+add_ext_type (tiz_os_t * ap_os, const char * a_type_name, void * ap_obj)
 {
-#ifdef _DEBUG
+  tiz_os_ext_type_t * p_ext = NULL;
+
   assert (ap_os);
-  assert (ap_os->p_map);
-  tiz_map_for_each (ap_os->p_map, print_function, (tiz_os_t *) ap_os);
-#endif
+
+  if (ap_os->n_ext_types == ap_os->max_ext_types)
+    {
+      const OMX_S32 max = ap_os->max_ext_types ? 2 * ap_os->max_ext_types : 4;
+      if (NULL == (p_ext = tiz_mem_realloc (
+                     ap_os->p_ext_types, max * sizeof (tiz_os_ext_type_t))))
+        {
+          return OMX_ErrorInsufficientResources;
+        }
+      ap_os->p_ext_types = p_ext;
+      ap_os->max_ext_types = max;
+    }
+
+  p_ext = &(ap_os->p_ext_types[ap_os->n_ext_types]);
+  if (NULL == (p_ext->p_name = os_strndup (ap_os->p_soa, a_type_name,
+                                           OMX_MAX_STRINGNAME_SIZE)))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+  p_ext->p_obj = ap_obj;
+  ap_os->n_ext_types++;
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
@@ -437,12 +550,11 @@ os_register_type (tiz_os_t * ap_os, const tiz_os_type_init_f a_type_init_f,
   void * p_obj = NULL;
 
   assert (ap_os);
-  assert (ap_os->p_map);
   assert (a_type_init_f);
   assert (a_type_name);
   assert (strnlen (a_type_name, OMX_MAX_STRINGNAME_SIZE)
           < OMX_MAX_STRINGNAME_SIZE);
-  assert (a_type_id >= 0);
+  assert (a_type_id < ETIZTypeCount);
 
   /* Call the type init function */
   p_obj = a_type_init_f (ap_os, ap_os->p_hdl);
@@ -454,9 +566,16 @@ os_register_type (tiz_os_t * ap_os, const tiz_os_type_init_f a_type_init_f,
                  "Registering type #[%d] : [%s] -> [%p] "
                  "nameOf [%s]",
                  a_type_id, a_type_name, p_obj, nameOf (p_obj));
-      rc = tiz_map_insert (ap_os->p_map, os_strndup (ap_os->p_soa, a_type_name,
-                                                     OMX_MAX_STRINGNAME_SIZE),
-                           p_obj, (OMX_U32 *) (&a_type_id));
+      if (a_type_id >= 0)
+        {
+          assert (!ap_os->p_types[a_type_id]);
+          ap_os->p_types[a_type_id] = p_obj;
+          rc = OMX_ErrorNone;
+        }
+      else if (OMX_ErrorNone != (rc = add_ext_type (ap_os, a_type_name, p_obj)))
+        {
+          tiz_mem_free (p_obj);
+        }
     }
 
   /*   print_types (ap_os); */
@@ -464,25 +583,34 @@ os_register_type (tiz_os_t * ap_os, const tiz_os_type_init_f a_type_init_f,
   return rc;
 }
 
+static inline OMX_ERRORTYPE
+register_builtin_type (tiz_os_t * ap_os, const OMX_S32 a_type_id)
+{
+  assert (ap_os);
+  assert (a_type_id >= 0 && a_type_id < ETIZTypeCount);
+  return os_register_type (ap_os, tiz_os_type_to_fnt_tbl[a_type_id],
+                           tiz_os_type_to_str_tbl[a_type_id].str, a_type_id);
+}
+
 static OMX_ERRORTYPE
 register_base_types (tiz_os_t * ap_os)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  const OMX_S32 count
-    = sizeof (tiz_os_type_to_str_tbl) / sizeof (tiz_os_type_str_t);
   OMX_S32 type_id = 0;
-  OMX_S32 last_element = 0;
 
   assert (ap_os);
-  assert (count >= TIZ_OS_BASE_TYPE_END);
-  last_element = TIZ_OS_BASE_TYPE_END;
 
-  for (type_id = 0; type_id <= last_element && OMX_ErrorNone == rc; ++type_id)
+  for (type_id = 0; type_id <= TIZ_OS_BASE_TYPE_END && OMX_ErrorNone == rc;
+       ++type_id)
     {
-      TIZ_TRACE (ap_os->p_hdl, "Registering type [%s]...",
-                 tiz_os_type_to_str_tbl[type_id].str);
-      rc = os_register_type (ap_os, tiz_os_type_to_fnt_tbl[type_id],
-                             tiz_os_type_to_str_tbl[type_id].str, type_id);
+      /* NOTE: A type may already have been registered on demand by one of the
+         previous types */
+      if (!ap_os->p_types[type_id])
+        {
+          TIZ_TRACE (ap_os->p_hdl, "Registering type [%s]...",
+                     tiz_os_type_to_str_tbl[type_id].str);
+          rc = register_builtin_type (ap_os, type_id);
+        }
     }
   return rc;
 }
@@ -505,14 +633,6 @@ tiz_os_init (tiz_os_t ** app_os, const OMX_HANDLETYPE ap_hdl,
 
   assert (p_os);
 
-  if (OMX_ErrorNone != tiz_map_init (&(p_os->p_map), os_map_compare_func,
-                                     os_map_free_func, NULL))
-    {
-      os_free (ap_soa, p_os);
-      p_os = NULL;
-      return OMX_ErrorInsufficientResources;
-    }
-
   p_os->p_hdl = ap_hdl;
   p_os->p_soa = ap_soa;
 
@@ -526,11 +646,17 @@ tiz_os_destroy (tiz_os_t * ap_os)
 {
   if (ap_os)
     {
-      while (!tiz_map_empty (ap_os->p_map))
+      OMX_S32 i = 0;
+      for (i = 0; i < ETIZTypeCount; ++i)
+        {
+          tiz_mem_free (ap_os->p_types[i]);
+        }
+      for (i = 0; i < ap_os->n_ext_types; ++i)
         {
-          tiz_map_erase_at (ap_os->p_map, 0);
-        };
-      tiz_map_destroy (ap_os->p_map);
+          os_free (ap_os->p_soa, ap_os->p_ext_types[i].p_name);
+          tiz_mem_free (ap_os->p_ext_types[i].p_obj);
+        }
+      tiz_mem_free (ap_os->p_ext_types);
       os_free (ap_os->p_soa, ap_os);
     }
 }
@@ -539,9 +665,20 @@ OMX_ERRORTYPE
 tiz_os_register_type (tiz_os_t * ap_os, const tiz_os_type_init_f a_type_init_f,
                       const OMX_STRING a_type_name)
 {
+  OMX_S32 type_id = -1;
+
   assert (ap_os);
-  return os_register_type (ap_os, a_type_init_f, a_type_name,
-                           tiz_map_size (ap_os->p_map));
+  assert (a_type_name);
+
+  /* Type names are unique */
+  type_id = builtin_type_id (a_type_name);
+  if ((type_id >= 0 && ap_os->p_types[type_id])
+      || find_ext_type (ap_os, a_type_name))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  return os_register_type (ap_os, a_type_init_f, a_type_name, type_id);
 }
 
 OMX_ERRORTYPE
@@ -551,50 +688,36 @@ tiz_os_register_base_types (tiz_os_t * ap_os)
   return register_base_types (ap_os);
 }
 
-static OMX_ERRORTYPE
-register_additional_type (tiz_os_t * ap_os, const char * a_type_name)
+void *
+tiz_os_get_type (const tiz_os_t * ap_os, const char * a_type_name)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  const OMX_S32 count
-    = sizeof (tiz_os_type_to_str_tbl) / sizeof (tiz_os_type_str_t);
-  OMX_S32 type_id = TIZ_OS_BASE_TYPE_END + 1;
+  tiz_os_t * p_os = (tiz_os_t *) ap_os;
+  void * res = NULL;
+  OMX_S32 type_id = -1;
 
   assert (ap_os);
+  assert (a_type_name);
 
-  for (; type_id < count && OMX_ErrorNone == rc; ++type_id)
+  if ((type_id = builtin_type_id (a_type_name)) >= 0)
     {
-      if (0 == strncmp (a_type_name, tiz_os_type_to_str_tbl[type_id].str,
-                        OMX_MAX_STRINGNAME_SIZE))
+      if (!(res = p_os->p_types[type_id]))
         {
           TIZ_TRACE (ap_os->p_hdl, "Registering additional type [%s]...",
                      a_type_name);
-          rc = os_register_type (ap_os, tiz_os_type_to_fnt_tbl[type_id],
-                                 a_type_name, type_id);
-          break;
+          if (OMX_ErrorNone == register_builtin_type (p_os, type_id))
+            {
+              print_types (ap_os);
+              res = p_os->p_types[type_id];
+            }
         }
     }
-  return rc;
-}
-
-void *
-tiz_os_get_type (const tiz_os_t * ap_os, const char * a_type_name)
-{
-  void * res = NULL;
-  assert (ap_os);
-  assert (ap_os->p_map);
-  assert (a_type_name);
-  res = tiz_map_find (ap_os->p_map, (OMX_PTR) a_type_name);
-  TIZ_TRACE (ap_os->p_hdl, "Get type [%s]->[%p] - total types [%d]",
-             a_type_name, res, tiz_map_size (ap_os->p_map));
-  if (!res)
+  else
     {
-      if (OMX_ErrorNone
-          == register_additional_type ((tiz_os_t *) ap_os, a_type_name))
-        {
-          print_types (ap_os);
-          res = tiz_map_find (ap_os->p_map, (OMX_PTR) a_type_name);
-        }
+      tiz_os_ext_type_t * p_ext = find_ext_type (ap_os, a_type_name);
+      res = p_ext ? p_ext->p_obj : NULL;
     }
+
+  TIZ_TRACE (ap_os->p_hdl, "Get type [%s]->[%p]", a_type_name, res);
   assert (res);
   return res;
 }
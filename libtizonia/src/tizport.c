@@ -181,6 +181,88 @@ default_free_hook (OMX_PTR ap_buf, OMX_PTR ap_port_priv, void * ap_args)
   tiz_mem_free (ap_buf);
 }
 
+static OMX_U32
+buffer_pool_flags (void)
+{
+  OMX_U32 flags = ETIZBufPoolFlagNone;
+  if (0 != tiz_rcfile_compare_value ("ilcore", "buffer-pool-prefault",
+                                     "false"))
+    {
+      flags |= ETIZBufPoolFlagPrefault;
+    }
+  if (0 == tiz_rcfile_compare_value ("ilcore", "buffer-pool-huge-pages",
+                                     "true"))
+    {
+      flags |= ETIZBufPoolFlagHugePages;
+    }
+  if (0 == tiz_rcfile_compare_value ("ilcore", "buffer-pool-numa-local",
+                                     "true"))
+    {
+      flags |= ETIZBufPoolFlagNumaLocal;
+    }
+  return flags;
+}
+
+static void
+release_buffer_pool (tiz_port_t * ap_obj)
+{
+  assert (ap_obj);
+  if (ap_obj->p_bufpool_
+      && tiz_bufpool_available (ap_obj->p_bufpool_)
+           == tiz_bufpool_count (ap_obj->p_bufpool_))
+    {
+      tiz_bufpool_destroy (ap_obj->p_bufpool_);
+      ap_obj->p_bufpool_ = NULL;
+    }
+}
+
+/* Buffers that would otherwise come from the default allocation hook are
+ * carved out of a single arena sized for all of the port's buffers, when
+ * the 'buffer-pool' option is enabled. The arena is created when the first
+ * buffer is allocated, and released when the port is depopulated. */
+/*@null@*/
+static OMX_U8 *
+alloc_pool_buffer (tiz_port_t * ap_obj, const OMX_U32 a_size)
+{
+  assert (ap_obj);
+
+  if (default_alloc_hook != ap_obj->opts_.mem_hooks.pf_alloc)
+    {
+      return NULL;
+    }
+
+  if (ap_obj->p_bufpool_
+      && (a_size > tiz_bufpool_buf_size (ap_obj->p_bufpool_)
+          || ap_obj->portdef_.nBufferCountActual
+               > tiz_bufpool_count (ap_obj->p_bufpool_)))
+    {
+      /* The port's requirements have changed since the arena was created */
+      release_buffer_pool (ap_obj);
+    }
+
+  if (!ap_obj->p_bufpool_)
+    {
+      if (0 != tiz_rcfile_compare_value ("ilcore", "buffer-pool", "true")
+          || OMX_ErrorNone
+               != tiz_bufpool_init (&(ap_obj->p_bufpool_),
+                                    ap_obj->portdef_.nBufferCountActual, a_size,
+                                    ap_obj->portdef_.nBufferAlignment,
+                                    buffer_pool_flags ()))
+        {
+          ap_obj->p_bufpool_ = NULL;
+          return NULL;
+        }
+      TIZ_DEBUG (handleOf (ap_obj),
+                 "PORT [%d] buffer pool : nbufs [%d] size [%d] huge [%s]",
+                 ap_obj->pid_, ap_obj->portdef_.nBufferCountActual, a_size,
+                 tiz_bufpool_is_huge (ap_obj->p_bufpool_) ? "YES" : "NO");
+    }
+
+  return a_size <= tiz_bufpool_buf_size (ap_obj->p_bufpool_)
+           ? tiz_bufpool_get (ap_obj->p_bufpool_)
+           : NULL;
+}
+
 static OMX_ERRORTYPE
 alloc_buffer (void * ap_obj, OMX_U32 * ap_size, OMX_U8 ** app_buf,
               OMX_PTR * app_portPrivate)
@@ -194,8 +276,9 @@ alloc_buffer (void * ap_obj, OMX_U32 * ap_size, OMX_U8 ** app_buf,
 
   alloc_size = *ap_size;
 
-  if (!(p_buf = p_obj->opts_.mem_hooks.pf_alloc (
-          &alloc_size, app_portPrivate, p_obj->opts_.mem_hooks.p_args)))
+  if (!(p_buf = alloc_pool_buffer (p_obj, alloc_size))
+      && !(p_buf = p_obj->opts_.mem_hooks.pf_alloc (
+             &alloc_size, app_portPrivate, p_obj->opts_.mem_hooks.p_args)))
     {
       TIZ_ERROR (handleOf (p_obj),
                  "[OMX_ErrorInsufficientResources] : "
@@ -224,6 +307,11 @@ free_buffer (void * ap_obj, OMX_PTR ap_buf, OMX_PTR /*@null@*/ ap_portPrivate)
   tiz_port_t * p_obj = ap_obj;
   TIZ_TRACE (handleOf (ap_obj), "ap_buf[%p]", ap_buf);
   assert (ap_buf);
+  if (p_obj->p_bufpool_ && tiz_bufpool_owns (p_obj->p_bufpool_, ap_buf))
+    {
+      tiz_bufpool_put (p_obj->p_bufpool_, ap_buf);
+      return;
+    }
   p_obj->opts_.mem_hooks.pf_free (ap_buf, ap_portPrivate,
                                   p_obj->opts_.mem_hooks.p_args);
 }
@@ -398,6 +486,7 @@ port_ctor (void * ap_obj, va_list * app)
   p_obj->claimed_count_ = 0;
 
   p_obj->announce_bufs_ = OMX_TRUE; /* Default to 1.1.2 behaviour */
+  p_obj->p_bufpool_ = NULL;
 
   p_obj->peer_port_status_.nSize
     = (OMX_U32) sizeof (OMX_CONFIG_TUNNELEDPORTSTATUSTYPE);
@@ -434,6 +523,9 @@ port_dtor (void * ap_obj)
   tiz_vector_clear (p_obj->p_marks_);
   tiz_vector_destroy (p_obj->p_marks_);
 
+  tiz_bufpool_destroy (p_obj->p_bufpool_);
+  p_obj->p_bufpool_ = NULL;
+
   return super_dtor (typeOf (ap_obj, "tizport"), ap_obj);
 }
 
@@ -1192,6 +1284,11 @@ port_FreeBuffer (const void * ap_obj, OMX_HANDLETYPE ap_hdl, OMX_U32 a_pid,
       tiz_port_clear_flags (p_obj, 1, EFlagPopulated);
     }
 
+  if (0 == hdr_count)
+    {
+      release_buffer_pool (p_obj);
+    }
+
   if (0 == hdr_count && TIZ_PD_ISSET (EFlagBeingDisabled, &p_obj->flags_))
     {
       tiz_port_clear_flags (p_obj, 1, EFlagBeingDisabled);
@@ -1813,6 +1910,7 @@ port_depopulate (const void * ap_obj)
     }
 
   assert (tiz_vector_length (p_obj->p_hdrs_info_) == 0);
+  release_buffer_pool (p_obj);
 
   tiz_port_clear_flags (p_obj, 1, EFlagPopulated);
   tiz_port_clear_flags (p_obj, 1, EFlagBeingDisabled);
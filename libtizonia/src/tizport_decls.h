@@ -60,6 +60,7 @@ struct tiz_port
   OMX_BOOL announce_bufs_;
   OMX_CONFIG_TUNNELEDPORTSTATUSTYPE peer_port_status_;
   tiz_eglimage_hook_t eglimage_hook_; /* EGL image validation hook */
+  tiz_bufpool_t * p_bufpool_; /* arena for buffers allocated by default */
 };
 
 OMX_ERRORTYPE
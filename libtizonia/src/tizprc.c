@@ -299,8 +299,11 @@ dispatch_br (void * ap_obj, OMX_PTR ap_msg)
       && ESubStatePauseToIdle != now && !TIZ_PORT_IS_DISABLED (p_port)
       && !TIZ_PORT_IS_BEING_DISABLED (p_port))
     {
+      const uint64_t start = tiz_monotonic_ns ();
       TIZ_TRACE (p_msg->p_hdl, "p_msg_br->p_buffer [%p] ", p_msg_br->p_buffer);
       rc = tiz_prc_buffers_ready (p_obj);
+      p_obj->br_ns_ += tiz_monotonic_ns () - start;
+      p_obj->br_calls_++;
     }
 
   return rc;
@@ -537,7 +540,10 @@ remove_buffer_from_servant_queue (OMX_PTR ap_elem, OMX_S32 a_data1,
 static void *
 prc_ctor (void * ap_obj, va_list * app)
 {
-  return super_ctor (typeOf (ap_obj, "tizprc"), ap_obj, app);
+  tiz_prc_t * p_obj = super_ctor (typeOf (ap_obj, "tizprc"), ap_obj, app);
+  p_obj->br_calls_ = 0;
+  p_obj->br_ns_ = 0;
+  return p_obj;
 }
 
 static void *
@@ -816,6 +822,18 @@ tiz_prc_config_change (const void * ap_obj, OMX_U32 a_pid,
   return class->config_change (ap_obj, a_pid, a_config_idx);
 }
 
+void
+tiz_prc_get_counters (const void * ap_obj, uint64_t * ap_calls,
+                      uint64_t * ap_time_ns)
+{
+  const tiz_prc_t * p_obj = ap_obj;
+  assert (p_obj);
+  assert (ap_calls);
+  assert (ap_time_ns);
+  *ap_calls = p_obj->br_calls_;
+  *ap_time_ns = p_obj->br_ns_;
+}
+
 /*
  * tizprc_class
  */
@@ -61,6 +61,9 @@ tiz_prc_port_enable (const void * ap_obj, OMX_U32 a_pid);
 OMX_ERRORTYPE
 tiz_prc_config_change (const void * ap_obj, OMX_U32 a_pid,
                        OMX_INDEXTYPE a_config_idx);
+void
+tiz_prc_get_counters (const void * ap_obj, uint64_t * ap_calls,
+                      uint64_t * ap_time_ns);
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,9 @@ struct tiz_prc
 {
   /* Object */
   const tiz_srv_t _;
+  /* Performance counters */
+  uint64_t br_calls_;
+  uint64_t br_ns_;
 };
 
 OMX_ERRORTYPE
@@ -31,7 +31,10 @@
 #endif
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include <OMX_Core.h>
 #include <OMX_Component.h>
@@ -54,7 +57,16 @@
 #endif
 
 #define SCHED_OMX_DEFAULT_ROLE "default"
-#define SCHED_QUEUE_MAX_ITEMS 30
+#define SCHED_QUEUE_MAX_ITEMS 32
+/* Maximum number of messages a pooled scheduler dispatches each time it is
+   run by a worker, before its servants are given a chance to run */
+#define SCHED_POOL_MAX_MSGS_PER_RUN SCHED_QUEUE_MAX_ITEMS
+/* The pool may grow up to this many times the configured number of workers,
+   to compensate for workers blocked in inter-component calls */
+#define SCHED_POOL_MAX_THREADS_FACTOR 4
+/* Maximum nesting of fast tunnel deliveries on the same worker (A delivers to
+   B, whose processor delivers to C, ...) */
+#define SCHED_FAST_TUNNEL_MAX_DEPTH 4
 
 #ifndef S_SPLINT_S
 #define TIZ_COMP_INIT_MSG(hdl, msg, msgtype)         \
@@ -85,6 +97,18 @@ enum tiz_sched_state
   ETIZSchedStateRolesRegistered,
 };
 
+/* Execution state of a scheduler in pool mode. A scheduler is in the
+   'queued' state exactly while a task for it sits in one of the pool's run
+   queues; only the worker that moves it to 'running' may dispatch its
+   messages, which preserves the serial execution guarantee. */
+typedef enum tiz_sched_run_state tiz_sched_run_state_t;
+enum tiz_sched_run_state
+{
+  ETIZSchedRunStateIdle = 0,
+  ETIZSchedRunStateQueued,
+  ETIZSchedRunStateRunning,
+};
+
 typedef struct tiz_srv_group tiz_srv_group_t;
 struct tiz_srv_group
 {
@@ -106,12 +130,17 @@ struct tiz_scheduler
   OMX_S32 thread_id;
   tiz_mutex_t mutex;
   tiz_sem_t sem;
-  tiz_queue_t * p_queue;
+  tiz_lfqueue_t * p_queue;
   tiz_soa_t * p_soa;
   tiz_os_t * p_objsys;
   OMX_S32 error;
   tiz_srv_group_t child;
   tiz_sched_state_t state;
+  OMX_BOOL pooled;   /* OMX_TRUE if this scheduler runs on the worker pool */
+  tiz_wpool_task_t task;
+  uint32_t run_state; /* a tiz_sched_run_state_t, only used in pool mode */
+  OMX_U32 direct_bufs; /* buffers delivered without going through the queue */
+  OMX_U32 queued_bufs; /* buffers delivered through the queue */
   OMX_PTR
   appdata; /* For use during setting of the component callbacks, not owned */
   OMX_CALLBACKTYPE *
@@ -416,6 +445,8 @@ static OMX_ERRORTYPE
 start_scheduler (tiz_scheduler_t *);
 static void
 delete_scheduler (tiz_scheduler_t *);
+static void
+pool_sched_task (void *);
 
 typedef OMX_ERRORTYPE (*tiz_sched_msg_dispatch_f) (tiz_scheduler_t * ap_sched,
                                                    tiz_sched_state_t * ap_state,
@@ -430,6 +461,9 @@ static const tiz_sched_msg_dispatch_f tiz_sched_msg_to_fnt_tbl[] = {
 static OMX_BOOL
 dispatch_msg (tiz_scheduler_t * ap_sched, tiz_sched_state_t * ap_state,
               tiz_sched_msg_t * ap_msg);
+static void
+schedule_servants (tiz_scheduler_t * ap_sched,
+                   const tiz_sched_state_t ap_state);
 
 typedef struct tiz_sched_msg_str tiz_sched_msg_str_t;
 struct tiz_sched_msg_str
@@ -602,14 +636,149 @@ store_roles (tiz_scheduler_t * ap_sched,
   return rc;
 }
 
+static pthread_once_t g_sched_pool_once = PTHREAD_ONCE_INIT;
+static tiz_wpool_t * gp_sched_pool = NULL;
+static bool g_sched_fast_tunnel = false;
+/* Messages are allocated by one thread (the IL client's, or a worker's) and
+   freed by another (the component's, or another worker's), in both scheduler
+   modes; this allocator keeps them off the heap */
+static tiz_soa_t * gp_sched_msg_soa = NULL;
+
+/* The pooled scheduler currently run by this thread, if any */
+static __thread tiz_scheduler_t * tp_running_sched = NULL;
+static __thread OMX_S32 t_fast_tunnel_depth = 0;
+
+static void
+init_sched_pool (void)
+{
+  const char * p_mode = getenv ("TIZONIA_SCHEDULER_MODE");
+  const char * p_size
+    = tiz_rcfile_get_value ("ilcore", "scheduler-pool-size");
+  OMX_S32 nthreads = 0;
+
+  if (OMX_ErrorNone != tiz_soa_init_shared (&gp_sched_msg_soa))
+    {
+      gp_sched_msg_soa = NULL;
+    }
+
+  if (!p_mode)
+    {
+      p_mode = tiz_rcfile_get_value ("ilcore", "scheduler-mode");
+    }
+
+  if (!p_mode || 0 != strncmp (p_mode, "pool", strlen ("pool") + 1))
+    {
+      /* Default: one thread per component */
+      return;
+    }
+
+  nthreads = p_size ? strtol (p_size, NULL, 10) : 0;
+  if (nthreads <= 0)
+    {
+      nthreads = sysconf (_SC_NPROCESSORS_ONLN);
+      nthreads = nthreads > 0 ? nthreads : 1;
+    }
+
+  if (OMX_ErrorNone
+      != tiz_wpool_init (&gp_sched_pool, nthreads,
+                         nthreads * SCHED_POOL_MAX_THREADS_FACTOR))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "Unable to create the scheduler worker pool; "
+               "falling back to one thread per component");
+      gp_sched_pool = NULL;
+    }
+  else
+    {
+      /* Fast tunnel deliveries are on by default in pool mode */
+      g_sched_fast_tunnel
+        = (0 != tiz_rcfile_compare_value ("ilcore", "scheduler-fast-tunnel",
+                                          "false"));
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "Scheduler pool mode - [%ld] workers - fast tunnel [%s]",
+               (long) nthreads, g_sched_fast_tunnel ? "YES" : "NO");
+    }
+}
+
+static inline tiz_wpool_t *
+get_sched_pool (void)
+{
+  (void) pthread_once (&g_sched_pool_once, init_sched_pool);
+  return gp_sched_pool;
+}
+
+/* get_sched_pool makes sure that the shared allocator is created before the
+   first message is allocated; if that failed, the heap is used throughout */
+static inline void *
+sched_msg_calloc (size_t a_size)
+{
+  (void) get_sched_pool ();
+  return gp_sched_msg_soa ? tiz_soa_calloc (gp_sched_msg_soa, a_size)
+                          : tiz_mem_calloc (1, a_size);
+}
+
+static inline void
+sched_msg_free (void * ap_addr)
+{
+  gp_sched_msg_soa ? tiz_soa_free (gp_sched_msg_soa, ap_addr)
+                   : tiz_mem_free (ap_addr);
+}
+
+/* Make sure a pooled scheduler gets to run after a message has been added to
+   its queue */
+static inline void
+kick_scheduler (tiz_scheduler_t * ap_sched)
+{
+  uint32_t expected = ETIZSchedRunStateIdle;
+  assert (ap_sched);
+
+  /* Pairs with the fence in pool_sched_task. Either the worker sees our
+     message after releasing the scheduler, or we see it idle here */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (__atomic_compare_exchange_n (
+        &(ap_sched->run_state), &expected, ETIZSchedRunStateQueued, false,
+        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+      (void) tiz_wpool_submit (gp_sched_pool, &(ap_sched->task));
+    }
+}
+
+/* Give a pooled scheduler back to the pool after a worker has run it */
+static inline void
+release_scheduler (tiz_scheduler_t * ap_sched)
+{
+  assert (ap_sched);
+  __atomic_store_n (&(ap_sched->run_state), ETIZSchedRunStateIdle,
+                    __ATOMIC_RELEASE);
+
+  /* Pairs with the fence in kick_scheduler */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (tiz_lfqueue_length (ap_sched->p_queue) > 0)
+    {
+      kick_scheduler (ap_sched);
+    }
+}
+
 static inline OMX_ERRORTYPE
 send_msg_blocking (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
 {
   assert (ap_msg);
   assert (ap_sched);
   ap_msg->will_block = OMX_TRUE;
-  tiz_check_omx_ret_oom (tiz_queue_send (ap_sched->p_queue, ap_msg));
-  tiz_check_omx_ret_oom (tiz_sem_wait (&(ap_sched->sem)));
+  tiz_check_omx_ret_oom (tiz_lfqueue_send (ap_sched->p_queue, ap_msg));
+  if (ap_sched->pooled)
+    {
+      kick_scheduler (ap_sched);
+      /* If we are a worker ourselves, the pool may need a spare thread to
+         run the target while we wait */
+      tiz_wpool_block_begin (gp_sched_pool);
+      tiz_check_omx_ret_oom (tiz_sem_wait (&(ap_sched->sem)));
+      tiz_wpool_block_end (gp_sched_pool);
+    }
+  else
+    {
+      tiz_check_omx_ret_oom (tiz_sem_wait (&(ap_sched->sem)));
+    }
   return ap_sched->error;
 }
 
@@ -619,19 +788,104 @@ send_msg_non_blocking (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
   assert (ap_msg);
   assert (ap_sched);
   ap_msg->will_block = OMX_FALSE;
-  return tiz_queue_send (ap_sched->p_queue, ap_msg);
+  tiz_check_omx_ret_oom (tiz_lfqueue_send (ap_sched->p_queue, ap_msg));
+  if (ap_sched->pooled)
+    {
+      kick_scheduler (ap_sched);
+    }
+  return OMX_ErrorNone;
+}
+
+/* Fast tunnel path. When a pooled component hands a buffer to its tunneled
+   peer and the peer is idle, the calling worker takes the peer over and
+   delivers the buffer straight to the peer's kernel, then runs the peer's
+   servants. This saves a queue round-trip and a worker wake-up per buffer.
+   Returns OMX_FALSE if the message must be sent the usual way. */
+static OMX_BOOL
+try_fast_tunnel (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg,
+                 OMX_ERRORTYPE * ap_rc)
+{
+  tiz_scheduler_t * p_caller = tp_running_sched;
+  uint32_t expected = ETIZSchedRunStateIdle;
+
+  assert (ap_sched);
+  assert (ap_msg);
+  assert (ap_rc);
+
+  /* Only buffers exchanged between two pooled components qualify. Messages
+     already in the peer's queue must be dispatched first. */
+  if (!g_sched_fast_tunnel || !ap_sched->pooled || !p_caller
+      || p_caller == ap_sched
+      || t_fast_tunnel_depth >= SCHED_FAST_TUNNEL_MAX_DEPTH
+      || tiz_lfqueue_length (ap_sched->p_queue) > 0
+      || !__atomic_compare_exchange_n (
+           &(ap_sched->run_state), &expected, ETIZSchedRunStateRunning, false,
+           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+      return OMX_FALSE;
+    }
+
+  if (tiz_lfqueue_length (ap_sched->p_queue) > 0)
+    {
+      /* Lost the race with another sender */
+      release_scheduler (ap_sched);
+      return OMX_FALSE;
+    }
+
+  /* The caller keeps its thread id while the peer runs on this worker, so
+     that calls back into the caller are recognised as such (see
+     dispatch_inline) */
+  ap_sched->thread_id = tiz_thread_id ();
+  tp_running_sched = ap_sched;
+  ++t_fast_tunnel_depth;
+
+  ap_msg->will_block = OMX_FALSE;
+  (void) dispatch_msg (ap_sched, &(ap_sched->state), ap_msg);
+  *ap_rc = ap_sched->error;
+  schedule_servants (ap_sched, ap_sched->state);
+
+  --t_fast_tunnel_depth;
+  tp_running_sched = p_caller;
+  ap_sched->thread_id = 0;
+
+  release_scheduler (ap_sched);
+  return OMX_TRUE;
+}
+
+/* Whether a message must be dispatched on the calling thread, i.e. the
+   target scheduler is running on this thread and the API is being called from
+   the IL callback context. When a pooled scheduler has been re-entered
+   through a fast tunnel delivery (another scheduler is now running on top of
+   it), it is in the middle of a tick: only blocking calls are dispatched
+   there and then, as nobody else could dispatch them while the caller
+   waits. Non-blocking ones are queued, and dispatched once the tick is over
+   (see release_scheduler). */
+static inline bool
+dispatch_inline (const tiz_scheduler_t * ap_sched,
+                 const tiz_sched_msg_t * ap_msg)
+{
+  assert (ap_sched);
+  assert (ap_msg);
+
+  if (tiz_thread_id () != ap_sched->thread_id
+      || ETIZSchedMsgPluggableEvent == ap_msg->class)
+    {
+      return false;
+    }
+
+  return (OMX_TRUE == ap_msg->will_block || !tp_running_sched
+          || tp_running_sched == ap_sched);
 }
 
 static inline OMX_ERRORTYPE
 send_msg (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
 {
-  const OMX_S32 tid = tiz_thread_id ();
   OMX_ERRORTYPE rc = OMX_ErrorNone;
 
   assert (ap_sched);
   assert (ap_msg);
 
-  if (tid == ap_sched->thread_id && ap_msg->class != ETIZSchedMsgPluggableEvent)
+  if (dispatch_inline (ap_sched, ap_msg))
     {
       TIZ_WARN (ap_sched->child.p_hdl,
                 "WARNING: (API %s called from IL callback context...)",
@@ -872,7 +1126,7 @@ do_sconfig (tiz_scheduler_t * ap_sched, tiz_sched_state_t * ap_state,
      non-blocking */
   if (OMX_FALSE == tiz_sched_blocking_apis_tbl[ETIZSchedMsgSetConfig])
     {
-      tiz_mem_free (p_msg_sconfig->p_struct);
+      sched_msg_free (p_msg_sconfig->p_struct);
       p_msg_sconfig->p_struct = NULL;
     }
 
@@ -1392,7 +1646,7 @@ init_scheduler_message (OMX_HANDLETYPE ap_hdl,
   assert (a_msg_class < ETIZSchedMsgMax);
 
   if (!(p_msg
-        = (tiz_sched_msg_t *) tiz_mem_calloc (1, sizeof (tiz_sched_msg_t))))
+        = (tiz_sched_msg_t *) sched_msg_calloc (sizeof (tiz_sched_msg_t))))
     {
       TIZ_ERROR (ap_hdl,
                  "[OMX_ErrorInsufficientResources] : "
@@ -1669,9 +1923,9 @@ sched_SetConfig (OMX_HANDLETYPE ap_hdl, OMX_INDEXTYPE a_index,
   if (OMX_FALSE == tiz_sched_blocking_apis_tbl[ETIZSchedMsgSetConfig])
     {
       if (!(p_msg_sconf->p_struct
-            = tiz_mem_calloc (1, (*(OMX_U32 *) ap_struct))))
+            = sched_msg_calloc ((*(OMX_U32 *) ap_struct))))
         {
-          tiz_mem_free (p_msg);
+          sched_msg_free (p_msg);
           TIZ_ERROR (ap_hdl,
                      "[OMX_ErrorInsufficientResources] : "
                      "(While allocating memory for config struct)");
@@ -1878,6 +2132,36 @@ sched_FreeBuffer (OMX_HANDLETYPE ap_hdl, OMX_U32 a_pid,
   return send_msg (p_sched, p_msg);
 }
 
+static OMX_ERRORTYPE
+send_buffer_msg (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  int hops = 0;
+
+  assert (ap_sched);
+  assert (ap_msg);
+
+  p_hdr = ap_msg->efb.p_hdr;
+
+  if (!try_fast_tunnel (ap_sched, ap_msg, &rc))
+    {
+      hops = dispatch_inline (ap_sched, ap_msg) ? 0 : 1;
+      rc = send_msg (ap_sched, ap_msg);
+    }
+
+  /* Hop count: number of scheduler queues the buffer went through. The
+     counters are updated from the senders' threads. */
+  (void) __atomic_add_fetch (
+    (0 == hops ? &(ap_sched->direct_bufs) : &(ap_sched->queued_bufs)), 1,
+    __ATOMIC_RELAXED);
+  TIZ_TRACE (ap_sched->child.p_hdl,
+             "HEADER [%p] hops [%d] - direct [%lu] queued [%lu]", p_hdr, hops,
+             ap_sched->direct_bufs, ap_sched->queued_bufs);
+
+  return rc;
+}
+
 static OMX_ERRORTYPE
 sched_EmptyThisBuffer (OMX_HANDLETYPE ap_hdl, OMX_BUFFERHEADERTYPE * ap_hdr)
 {
@@ -1902,7 +2186,7 @@ sched_EmptyThisBuffer (OMX_HANDLETYPE ap_hdl, OMX_BUFFERHEADERTYPE * ap_hdr)
   assert (p_msg_efb);
   p_msg_efb->p_hdr = ap_hdr;
 
-  return send_msg (p_sched, p_msg);
+  return send_buffer_msg (p_sched, p_msg);
 }
 
 static OMX_ERRORTYPE
@@ -1929,7 +2213,7 @@ sched_FillThisBuffer (OMX_HANDLETYPE ap_hdl, OMX_BUFFERHEADERTYPE * ap_hdr)
   assert (p_msg_efb);
   p_msg_efb->p_hdr = ap_hdr;
 
-  return send_msg (p_sched, p_msg);
+  return send_buffer_msg (p_sched, p_msg);
 }
 
 static OMX_ERRORTYPE
@@ -2047,7 +2331,7 @@ dispatch_msg (tiz_scheduler_t * ap_sched, tiz_sched_state_t * ap_state,
   /* Return error to client */
   ap_sched->error = rc;
 
-  tiz_mem_free (ap_msg);
+  sched_msg_free (ap_msg);
 
   return signal_client;
 }
@@ -2097,7 +2381,7 @@ schedule_servants (tiz_scheduler_t * ap_sched, const tiz_sched_state_t ap_state)
           rc = tiz_srv_tick (p_ready);
         }
 
-      if (tiz_queue_length (ap_sched->p_queue) > 0)
+      if (tiz_lfqueue_length (ap_sched->p_queue) > 0)
         {
           break;
         }
@@ -2126,7 +2410,7 @@ il_sched_thread_func (void * p_arg)
 
   for (;;)
     {
-      tiz_check_omx_ret_null (tiz_queue_receive (p_sched->p_queue, &p_data));
+      tiz_check_omx_ret_null (tiz_lfqueue_receive (p_sched->p_queue, &p_data));
 
       assert (p_data);
       signal_client
@@ -2148,11 +2432,75 @@ il_sched_thread_func (void * p_arg)
   return NULL;
 }
 
+/* Worker pool task: runs a pooled scheduler for a bounded number of messages,
+   then gives its servants a chance to run */
+static void
+pool_sched_task (void * ap_arg)
+{
+  tiz_scheduler_t * p_sched = (tiz_scheduler_t *) (ap_arg);
+  OMX_PTR p_data = NULL;
+  OMX_BOOL signal_client = OMX_FALSE;
+  OMX_S32 nmsgs = 0;
+
+  assert (p_sched);
+  assert (ETIZSchedRunStateQueued == p_sched->run_state);
+
+  __atomic_store_n (&(p_sched->run_state), ETIZSchedRunStateRunning,
+                    __ATOMIC_RELAXED);
+  p_sched->thread_id = tiz_thread_id ();
+  tp_running_sched = p_sched;
+
+  while (nmsgs++ < SCHED_POOL_MAX_MSGS_PER_RUN
+         && OMX_ErrorNone
+              == tiz_lfqueue_try_receive (p_sched->p_queue, &p_data))
+    {
+      assert (p_data);
+      signal_client
+        = dispatch_msg (p_sched, &(p_sched->state), (tiz_sched_msg_t *) p_data);
+
+      if (ETIZSchedStateStopped == p_sched->state)
+        {
+          /* The component is being destroyed. The client may delete the
+             scheduler as soon as the semaphore is posted, so this must be the
+             last access to it. The scheduler is left in the 'running' state
+             so that it is never queued again. */
+          p_sched->thread_id = 0;
+          tp_running_sched = NULL;
+          if (OMX_TRUE == signal_client)
+            {
+              (void) tiz_sem_post (&(p_sched->sem));
+            }
+          return;
+        }
+
+      if (OMX_TRUE == signal_client)
+        {
+          (void) tiz_sem_post (&(p_sched->sem));
+        }
+    }
+
+  schedule_servants (p_sched, p_sched->state);
+
+  p_sched->thread_id = 0;
+  tp_running_sched = NULL;
+  release_scheduler (p_sched);
+}
+
 static OMX_ERRORTYPE
 start_scheduler (tiz_scheduler_t * ap_sched)
 {
   assert (ap_sched);
 
+  if (ap_sched->pooled)
+    {
+      /* No dedicated thread; the scheduler will be run by the pool workers
+         whenever there are messages in its queue */
+      ap_sched->task.pf_run = pool_sched_task;
+      ap_sched->task.p_arg = ap_sched;
+      ap_sched->run_state = ETIZSchedRunStateIdle;
+      return OMX_ErrorNone;
+    }
+
   /* Create scheduler thread */
   tiz_check_omx_ret_oom (tiz_mutex_lock (&(ap_sched->mutex)));
   tiz_check_omx_ret_oom (tiz_thread_create (&(ap_sched->thread), 0, 0,
@@ -2169,11 +2517,14 @@ delete_scheduler (tiz_scheduler_t * ap_sched)
 {
   OMX_PTR p_result = NULL;
   assert (ap_sched);
-  (void) tiz_thread_join (&(ap_sched->thread), &p_result);
+  if (!ap_sched->pooled)
+    {
+      (void) tiz_thread_join (&(ap_sched->thread), &p_result);
+    }
   delete_roles (ap_sched);
   (void) tiz_mutex_destroy (&(ap_sched->mutex));
   (void) tiz_sem_destroy (&(ap_sched->sem));
-  tiz_queue_destroy (ap_sched->p_queue);
+  tiz_lfqueue_destroy (ap_sched->p_queue);
   ap_sched->p_queue = NULL;
   tiz_mem_free (ap_sched);
 }
@@ -2197,7 +2548,7 @@ instantiate_scheduler (OMX_HANDLETYPE ap_hdl, const char * ap_cname)
   tiz_check_omx_ret_null (tiz_mutex_init (&(p_sched->mutex)));
   tiz_check_omx_ret_null (tiz_sem_init (&(p_sched->sem), 0));
   tiz_check_omx_ret_null (
-    tiz_queue_init (&(p_sched->p_queue), SCHED_QUEUE_MAX_ITEMS));
+    tiz_lfqueue_init (&(p_sched->p_queue), SCHED_QUEUE_MAX_ITEMS));
 
   p_sched->child.p_fsm = NULL;
   p_sched->child.p_ker = NULL;
@@ -2209,6 +2560,7 @@ instantiate_scheduler (OMX_HANDLETYPE ap_hdl, const char * ap_cname)
   p_sched->state = ETIZSchedStateStarting;
   p_sched->appdata = NULL;
   p_sched->cbacks = NULL;
+  p_sched->pooled = get_sched_pool () ? OMX_TRUE : OMX_FALSE;
 
   len = strnlen (ap_cname, OMX_MAX_STRINGNAME_SIZE - 1);
   strncpy (p_sched->cname, ap_cname, len);
@@ -2247,7 +2599,11 @@ init_servants (tiz_scheduler_t * ap_sched, tiz_sched_msg_t * ap_msg)
   assert (ap_sched);
   assert (ap_msg);
 
-  set_thread_name (ap_sched);
+  if (!ap_sched->pooled)
+    {
+      /* Pool workers are shared; leave their names alone */
+      set_thread_name (ap_sched);
+    }
 
   p_hdl = ap_sched->child.p_hdl;
 
@@ -2623,7 +2979,8 @@ tiz_comp_event_queue_unused_spaces (const OMX_HANDLETYPE ap_hdl)
 {
   tiz_scheduler_t * p_sched = get_sched (ap_hdl);
   assert (p_sched);
-  return SCHED_QUEUE_MAX_ITEMS - tiz_queue_length (p_sched->p_queue);
+  return tiz_lfqueue_capacity (p_sched->p_queue)
+         - tiz_lfqueue_length (p_sched->p_queue);
 }
 
 void *
@@ -140,6 +140,9 @@ srv_ctor (void * ap_obj, va_list * app)
   p_srv->watcher_id_ = 0;
   p_srv->p_appdata_ = NULL;
   p_srv->p_cbacks_ = NULL;
+  p_srv->nmsgs_ = 0;
+  p_srv->time_ns_ = 0;
+  p_srv->queue_hwm_ = 0;
   return p_srv;
 }
 
@@ -256,8 +259,14 @@ OMX_ERRORTYPE
 tiz_srv_tick (const void * ap_obj)
 {
   const tiz_srv_class_t * class = classOf (ap_obj);
+  tiz_srv_t * p_srv = (tiz_srv_t *) ap_obj;
+  const uint64_t start = tiz_monotonic_ns ();
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (class->tick);
-  return class->tick (ap_obj);
+  rc = class->tick (ap_obj);
+  p_srv->time_ns_ += tiz_monotonic_ns () - start;
+  p_srv->nmsgs_++;
+  return rc;
 }
 
 OMX_ERRORTYPE
@@ -268,6 +277,17 @@ tiz_srv_super_tick (const void * a_class, const void * ap_obj)
   return superclass->tick (ap_obj);
 }
 
+void
+tiz_srv_get_counters (const void * ap_obj, tiz_srv_counters_t * ap_counters)
+{
+  const tiz_srv_t * p_srv = ap_obj;
+  assert (p_srv);
+  assert (ap_counters);
+  ap_counters->nmsgs = p_srv->nmsgs_;
+  ap_counters->time_ns = p_srv->time_ns_;
+  ap_counters->queue_hwm = p_srv->queue_hwm_;
+}
+
 static OMX_PTR
 srv_init_msg (void * ap_obj, size_t msg_sz)
 {
@@ -290,8 +310,15 @@ static OMX_ERRORTYPE
 srv_enqueue (const void * ap_obj, OMX_PTR ap_data, OMX_U32 a_priority)
 {
   tiz_srv_t * p_srv = (tiz_srv_t *) ap_obj;
+  OMX_S32 len = 0;
   assert (p_srv);
-  return tiz_pqueue_send (p_srv->p_pq_, ap_data, a_priority);
+  tiz_check_omx (tiz_pqueue_send (p_srv->p_pq_, ap_data, a_priority));
+  len = tiz_pqueue_length (p_srv->p_pq_);
+  if (len > (OMX_S32) p_srv->queue_hwm_)
+    {
+      p_srv->queue_hwm_ = (OMX_U32) len;
+    }
+  return OMX_ErrorNone;
 }
 
 OMX_ERRORTYPE
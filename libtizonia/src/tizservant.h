@@ -55,6 +55,17 @@ tiz_srv_set_callbacks (void * ap_obj, OMX_PTR ap_appdata,
 OMX_ERRORTYPE
 tiz_srv_tick (const void * ap_obj);
 
+typedef struct tiz_srv_counters tiz_srv_counters_t;
+struct tiz_srv_counters
+{
+  uint64_t nmsgs;    /* messages dispatched */
+  uint64_t time_ns;  /* time spent dispatching them */
+  OMX_U32 queue_hwm; /* maximum queue length seen */
+};
+
+void
+tiz_srv_get_counters (const void * ap_obj, tiz_srv_counters_t * ap_counters);
+
 OMX_PTR
 tiz_srv_init_msg (void * ap_obj, size_t msg_sz);
 
@@ -47,6 +47,10 @@ struct tiz_srv
   uint32_t watcher_id_;
   OMX_PTR p_appdata_;
   OMX_CALLBACKTYPE * p_cbacks_;
+  /* Performance counters */
+  uint64_t nmsgs_;
+  uint64_t time_ns_;
+  OMX_U32 queue_hwm_;
 };
 
 OMX_ERRORTYPE
@@ -76,6 +76,36 @@ retrieve_default_uri_from_config (tiz_uricfgport_t * ap_obj)
   return p_rv;
 }
 
+static OMX_ERRORTYPE
+copy_uri_to_struct (OMX_HANDLETYPE ap_hdl, const char * ap_src,
+                    OMX_PARAM_CONTENTURITYPE * ap_uri)
+{
+  const OMX_U32 uri_len = ap_src ? strlen (ap_src) : 0;
+  const OMX_U32 uri_buf_offset = sizeof (OMX_U32) + sizeof (OMX_VERSIONTYPE);
+  OMX_U32 uri_buf_size = 0;
+  char * p_dest = NULL;
+
+  assert (ap_uri);
+
+  uri_buf_size
+    = (ap_uri->nSize >= uri_buf_offset ? ap_uri->nSize - uri_buf_offset : 0);
+  TIZ_TRACE (ap_hdl, "uri_buf_size [%d]...", uri_buf_size);
+
+  if (uri_buf_size < (uri_len + 1))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  p_dest = (char *) ap_uri->contentURI;
+  ap_uri->nVersion.nVersion = OMX_VERSION;
+  if (uri_len > 0)
+    {
+      strncpy (p_dest, ap_src, uri_len);
+    }
+  p_dest[uri_len] = '\0';
+  return OMX_ErrorNone;
+}
+
 /*
  * tizuricfgport class
  */
@@ -86,11 +116,14 @@ uri_cfgport_ctor (void * ap_obj, va_list * app)
   tiz_uricfgport_t * p_obj
     = super_ctor (typeOf (ap_obj, "tizuricfgport"), ap_obj, app);
   p_obj->p_uri_ = retrieve_default_uri_from_config (p_obj);
+  p_obj->p_next_uri_ = NULL;
 
   /* In addition to the indexes registered by the parent class, register here
      this port's specific ones */
   tiz_check_omx_ret_null (
     tiz_port_register_index (p_obj, OMX_IndexParamContentURI)); /* r/w */
+  tiz_check_omx_ret_null (tiz_port_register_index (
+    p_obj, OMX_TizoniaIndexConfigNextContentURI)); /* r/w */
 
   return p_obj;
 }
@@ -100,6 +133,7 @@ uri_cfgport_dtor (void * ap_obj)
 {
   tiz_uricfgport_t * p_obj = ap_obj;
   tiz_mem_free (p_obj->p_uri_);
+  tiz_mem_free (p_obj->p_next_uri_);
   return super_dtor (typeOf (ap_obj, "tizuricfgport"), ap_obj);
 }
 
@@ -121,36 +155,11 @@ uri_cfgport_GetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
     {
       case OMX_IndexParamContentURI:
         {
-          if (p_obj->p_uri_)
+          OMX_PARAM_CONTENTURITYPE * p_uri
+            = (OMX_PARAM_CONTENTURITYPE *) ap_struct;
+          if (p_obj->p_uri_ && p_uri && strlen (p_obj->p_uri_) > 0)
             {
-              OMX_PARAM_CONTENTURITYPE * p_uri
-                = (OMX_PARAM_CONTENTURITYPE *) ap_struct;
-              const OMX_U32 uri_len = strlen (p_obj->p_uri_);
-
-              if (p_uri && uri_len > 0)
-                {
-                  OMX_U32 uri_buf_offset
-                    = sizeof (OMX_U32) + sizeof (OMX_VERSIONTYPE);
-                  OMX_U32 uri_buf_size = (p_uri->nSize >= uri_buf_offset
-                                            ? p_uri->nSize - uri_buf_offset
-                                            : 0);
-
-                  TIZ_TRACE (ap_hdl, "uri_buf_size [%d]...", uri_buf_size);
-
-                  if (uri_buf_size < (uri_len + 1))
-                    {
-                      rc = OMX_ErrorBadParameter;
-                    }
-                  else
-                    {
-                      char * p_dest = (char *) p_uri->contentURI;
-                      assert (p_dest);
-                      assert (uri_len > 0);
-                      p_uri->nVersion.nVersion = OMX_VERSION;
-                      strncpy (p_dest, p_obj->p_uri_, uri_len);
-                      p_dest[uri_len] = '\0';
-                    }
-                }
+              rc = copy_uri_to_struct (ap_hdl, p_obj->p_uri_, p_uri);
             }
         }
         break;
@@ -215,6 +224,86 @@ uri_cfgport_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
   return rc;
 }
 
+static OMX_ERRORTYPE
+uri_cfgport_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                       OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  const tiz_uricfgport_t * p_obj = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "GetConfig [%s]...", tiz_idx_to_str (a_index));
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigNextContentURI == a_index)
+    {
+      /* An empty string is returned when there is no URI queued */
+      rc = copy_uri_to_struct (ap_hdl, p_obj->p_next_uri_,
+                               (OMX_PARAM_CONTENTURITYPE *) ap_struct);
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_GetConfig (typeOf (ap_obj, "tizuricfgport"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+uri_cfgport_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                       OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  tiz_uricfgport_t * p_obj = (tiz_uricfgport_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "SetConfig [%s]...", tiz_idx_to_str (a_index));
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigNextContentURI == a_index)
+    {
+      const OMX_PARAM_CONTENTURITYPE * p_uri
+        = (const OMX_PARAM_CONTENTURITYPE *) ap_struct;
+      const OMX_U32 uri_buf_offset
+        = sizeof (OMX_U32) + sizeof (OMX_VERSIONTYPE);
+      long uri_size = 0;
+
+      if (!p_uri || p_uri->nSize <= uri_buf_offset)
+        {
+          return OMX_ErrorBadParameter;
+        }
+
+      uri_size = strnlen ((const char *) p_uri->contentURI,
+                          p_uri->nSize - uri_buf_offset);
+      tiz_mem_free (p_obj->p_next_uri_);
+      p_obj->p_next_uri_ = NULL;
+      /* An empty URI cancels the one currently queued */
+      if (uri_size > 0)
+        {
+          const long pathname_max
+            = tiz_pathname_max ((const char *) p_uri->contentURI);
+          if (pathname_max > 0 && uri_size > pathname_max)
+            {
+              uri_size = pathname_max;
+            }
+          p_obj->p_next_uri_
+            = strndup ((const char *) p_uri->contentURI, uri_size);
+          tiz_check_null_ret_oom (p_obj->p_next_uri_);
+        }
+
+      TIZ_TRACE (ap_hdl, "Next URI [%s]...",
+                 p_obj->p_next_uri_ ? p_obj->p_next_uri_ : "");
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_SetConfig (typeOf (ap_obj, "tizuricfgport"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
+    }
+
+  return rc;
+}
+
 /*
  * tizuricfgport_class
  */
@@ -267,6 +356,10 @@ tiz_uricfgport_init (void * ap_tos, void * ap_hdl)
      tiz_api_GetParameter, uri_cfgport_GetParameter,
      /* TIZ_CLASS_COMMENT: */
      tiz_api_SetParameter, uri_cfgport_SetParameter,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetConfig, uri_cfgport_GetConfig,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_SetConfig, uri_cfgport_SetConfig,
      /* TIZ_CLASS_COMMENT: stop value*/
      0);
 
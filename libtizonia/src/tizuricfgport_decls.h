@@ -41,6 +41,7 @@ struct tiz_uricfgport
   /* Object */
   const tiz_configport_t _;
   OMX_STRING p_uri_;
+  OMX_STRING p_next_uri_;
 };
 
 typedef struct tiz_uricfgport_class tiz_uricfgport_class_t;
@@ -31,6 +31,7 @@
 #endif
 
 #include <assert.h>
+#include <time.h>
 
 #include "tizutils.h"
 
@@ -92,3 +93,11 @@ tiz_fsm_state_to_str (tiz_fsm_state_id_t a_id)
 
   return "Unknown OpenMAX IL state";
 }
+
+uint64_t
+tiz_monotonic_ns (void)
+{
+  struct timespec ts;
+  (void) clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
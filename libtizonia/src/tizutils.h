@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
+
 #include <OMX_Types.h>
 #include <OMX_Core.h>
 
@@ -86,34 +88,23 @@ struct tiz_pd_set
 #define TIZ_CBUF(hdl) \
   (((OMX_COMPONENTTYPE *) hdl)->pComponentPrivate + OMX_MAX_STRINGNAME_SIZE)
 
-#define TIZ_LOGN(priority, hdl, format, args...)                              \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME, priority, \
-           TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, ##args);
+#define TIZ_LOGN(priority, hdl, format, args...) \
+  TIZ_LOG_IF (priority, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, ##args);
 
-#define TIZ_ERROR(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,     \
-           TIZ_PRIORITY_ERROR, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
+#define TIZ_ERROR(hdl, format, args...) \
+  TIZ_LOGN (TIZ_PRIORITY_ERROR, hdl, format, ##args)
 
-#define TIZ_WARN(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,    \
-           TIZ_PRIORITY_WARN, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
+#define TIZ_WARN(hdl, format, args...) \
+  TIZ_LOGN (TIZ_PRIORITY_WARN, hdl, format, ##args)
 
-#define TIZ_NOTICE(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,      \
-           TIZ_PRIORITY_NOTICE, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
+#define TIZ_NOTICE(hdl, format, args...) \
+  TIZ_LOGN (TIZ_PRIORITY_NOTICE, hdl, format, ##args)
 
-#define TIZ_DEBUG(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,     \
-           TIZ_PRIORITY_DEBUG, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
+#define TIZ_DEBUG(hdl, format, args...) \
+  TIZ_LOGN (TIZ_PRIORITY_DEBUG, hdl, format, ##args)
 
-#define TIZ_TRACE(hdl, format, args...)                                 \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,     \
-           TIZ_PRIORITY_TRACE, TIZ_CNAME (hdl), TIZ_CBUF (hdl), format, \
-           ##args);
+#define TIZ_TRACE(hdl, format, args...) \
+  TIZ_LOGN (TIZ_PRIORITY_TRACE, hdl, format, ##args)
 
 void
 tiz_clear_header (OMX_BUFFERHEADERTYPE * ap_hdr);
@@ -121,6 +112,10 @@ tiz_clear_header (OMX_BUFFERHEADERTYPE * ap_hdr);
 const OMX_STRING
 tiz_fsm_state_to_str (tiz_fsm_state_id_t a_id);
 
+/* Monotonic time in nanoseconds, for performance counters */
+uint64_t
+tiz_monotonic_ns (void);
+
 #ifdef __cplusplus
 }
 #endif
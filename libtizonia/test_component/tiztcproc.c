@@ -44,6 +44,8 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.tizonia.test_comp"
 #endif
 
+#define TC_MAX_BATCH 4
+
 /*
  * tiztcprc
  */
@@ -109,25 +111,33 @@ static OMX_ERRORTYPE
 tcprc_buffers_ready (const void *ap_obj)
 {
   void *p_krn = tiz_get_krn (handleOf (ap_obj));
-  OMX_BUFFERHEADERTYPE *p_hdr = NULL;
+  OMX_BUFFERHEADERTYPE *hdrs[TC_MAX_BATCH];
+  OMX_U32 nhdrs = 0;
+  OMX_U32 i = 0;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
 
-  rc = tiz_krn_claim_buffer (p_krn, 0, 0, &p_hdr);
-  if (OMX_ErrorNone == rc && p_hdr)
+  /* Exercise the kernel's batch APIs: claim all the headers available (up to
+     TC_MAX_BATCH), and return them in one go */
+  rc = tiz_krn_claim_buffers (p_krn, 0, hdrs, TC_MAX_BATCH, &nhdrs);
+  for (i = 0; i < nhdrs && OMX_ErrorNone == rc; ++i)
     {
+      OMX_BUFFERHEADERTYPE *p_hdr = hdrs[i];
       OMX_PTR p_eglimage = NULL;
-      tiz_check_omx (tiz_krn_claim_eglimage (p_krn, 0, p_hdr, &p_eglimage));
-      TIZ_PRINTF_DBG_MAG ("eglimage [%p]\n", p_eglimage);
-      tiz_check_omx (tiztc_proc_render_buffer (p_hdr));
-      if ((p_hdr->nFlags & OMX_BUFFERFLAG_EOS) != 0)
+      rc = tiz_krn_claim_eglimage (p_krn, 0, p_hdr, &p_eglimage);
+      if (OMX_ErrorNone == rc)
+        {
+          TIZ_PRINTF_DBG_MAG ("eglimage [%p]\n", p_eglimage);
+          rc = tiztc_proc_render_buffer (p_hdr);
+        }
+      if (OMX_ErrorNone == rc && (p_hdr->nFlags & OMX_BUFFERFLAG_EOS) != 0)
         {
           tiz_srv_issue_event ((OMX_PTR)ap_obj, OMX_EventBufferFlag, 0,
                                p_hdr->nFlags, NULL);
         }
-      (void)tiz_krn_release_buffer (p_krn, 0, p_hdr);
     }
+  (void)tiz_krn_release_buffers (p_krn, 0, hdrs, nhdrs);
 
-  return OMX_ErrorNone;
+  return rc;
 }
 
 /*
@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <check.h>
@@ -49,6 +50,9 @@
 #include "tizscheduler.h"
 #include "tizfsm.h"
 #include "tizkernel.h"
+#include "tizkernel_decls.h"
+#include "tizkernel_ring.inl"
+#include "tizfilterprc.h"
 
 #include "check_tizonia.h"
 
@@ -2021,10 +2025,774 @@ START_TEST (test_tizonia_command_cancellation_disabled_to_enabled_with_tunneled_
 }
 END_TEST
 
+static void
+_comp_to_state (OMX_HANDLETYPE ap_hdl, cc_ctx_t * ap_ctx,
+                OMX_STATETYPE a_state, OMX_BUFFERHEADERTYPE ** app_hdrs,
+                const OMX_PARAM_PORTDEFINITIONTYPE * ap_port_def)
+{
+  check_common_context_t *p_ctx = (check_common_context_t *) (*ap_ctx);
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_BOOL timedout = OMX_FALSE;
+  OMX_STATETYPE state = OMX_StateMax;
+  OMX_U32 i;
+
+  error = OMX_GetState (ap_hdl, &state);
+  fail_if (OMX_ErrorNone != error);
+
+  error = _ctx_reset (ap_ctx);
+  fail_if (OMX_ErrorNone != error);
+  error = OMX_SendCommand (ap_hdl, OMX_CommandStateSet, a_state, NULL);
+  fail_if (OMX_ErrorNone != error);
+
+  for (i = 0; i < ap_port_def->nBufferCountActual; ++i)
+    {
+      if (OMX_StateLoaded == state && OMX_StateIdle == a_state)
+        {
+          error = OMX_AllocateBuffer (ap_hdl, &app_hdrs[i], 0, /* input port */
+                                      0, ap_port_def->nBufferSize);
+          fail_if (OMX_ErrorNone != error);
+        }
+      else if (OMX_StateIdle == state && OMX_StateLoaded == a_state)
+        {
+          error = OMX_FreeBuffer (ap_hdl, 0, app_hdrs[i]); /* input port */
+          fail_if (OMX_ErrorNone != error);
+        }
+    }
+
+  error = _ctx_wait (ap_ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (a_state != p_ctx->state);
+}
+
+/*
+ * Pool mode: re-entering a component from the IL callback context of a
+ * component that has taken over its worker (fast tunnel delivery)
+ */
+
+typedef struct check_reentry_context check_reentry_context_t;
+struct check_reentry_context
+{
+  OMX_HANDLETYPE p_hdl_a;
+  OMX_HANDLETYPE p_hdl_b;
+  OMX_BUFFERHEADERTYPE *p_hdr_b;
+  OMX_ERRORTYPE etb_error;
+  OMX_ERRORTYPE getstate_error;
+  OMX_STATETYPE state_a;
+};
+
+static check_reentry_context_t g_reentry;
+
+/* Runs on the worker that runs component A. Hands a buffer to component B;
+   B is idle, so it is run on this same worker, before this returns */
+static OMX_ERRORTYPE
+check_reentry_EmptyBufferDone_a (OMX_HANDLETYPE ap_hdl, OMX_PTR ap_app_data,
+                                 OMX_BUFFERHEADERTYPE * ap_buf)
+{
+  g_reentry.etb_error
+    = OMX_EmptyThisBuffer (g_reentry.p_hdl_b, g_reentry.p_hdr_b);
+  return check_EmptyBufferDone (ap_hdl, ap_app_data, ap_buf);
+}
+
+/* Runs on B's behalf, while A is still in the middle of its tick. The
+   blocking call into A must not wait for A to be scheduled again. */
+static OMX_ERRORTYPE
+check_reentry_EmptyBufferDone_b (OMX_HANDLETYPE ap_hdl, OMX_PTR ap_app_data,
+                                 OMX_BUFFERHEADERTYPE * ap_buf)
+{
+  g_reentry.getstate_error
+    = OMX_GetState (g_reentry.p_hdl_a, &g_reentry.state_a);
+  return check_EmptyBufferDone (ap_hdl, ap_app_data, ap_buf);
+}
+
+static OMX_CALLBACKTYPE _check_reentry_cbacks_a = {
+  check_EventHandler,
+  check_reentry_EmptyBufferDone_a,
+  check_FillBufferDone
+};
+
+static OMX_CALLBACKTYPE _check_reentry_cbacks_b = {
+  check_EventHandler,
+  check_reentry_EmptyBufferDone_b,
+  check_FillBufferDone
+};
+
+START_TEST (test_tizonia_pool_reentrant_call_from_fast_tunnel_callback)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl_a = 0;
+  OMX_HANDLETYPE p_hdl_b = 0;
+  cc_ctx_t ctx_a;
+  cc_ctx_t ctx_b;
+  check_common_context_t *p_ctx_a = NULL;
+  check_common_context_t *p_ctx_b = NULL;
+  OMX_BOOL timedout = OMX_FALSE;
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_BUFFERHEADERTYPE **pp_hdrs_a = NULL;
+  OMX_BUFFERHEADERTYPE **pp_hdrs_b = NULL;
+
+  /* Each test runs in its own process: the scheduler mode is selected when
+     the first component is instantiated */
+  fail_if (0 != setenv ("TIZONIA_SCHEDULER_MODE", "pool", 1));
+
+  error = _ctx_init (&ctx_a);
+  fail_if (OMX_ErrorNone != error);
+  error = _ctx_init (&ctx_b);
+  fail_if (OMX_ErrorNone != error);
+  p_ctx_a = (check_common_context_t *) (ctx_a);
+  p_ctx_b = (check_common_context_t *) (ctx_b);
+
+  error = OMX_Init ();
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_GetHandle (&p_hdl_a, COMPONENT_NAME, (OMX_PTR *) (&ctx_a),
+                         &_check_reentry_cbacks_a);
+  fail_if (OMX_ErrorNone != error);
+  error = OMX_GetHandle (&p_hdl_b, COMPONENT_NAME, (OMX_PTR *) (&ctx_b),
+                         &_check_reentry_cbacks_b);
+  fail_if (OMX_ErrorNone != error);
+
+  /* Both instances have the same port configuration */
+  port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  error = OMX_GetParameter (p_hdl_a, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+  pp_hdrs_a = tiz_mem_calloc (port_def.nBufferCountActual,
+                              sizeof (OMX_BUFFERHEADERTYPE *));
+  pp_hdrs_b = tiz_mem_calloc (port_def.nBufferCountActual,
+                              sizeof (OMX_BUFFERHEADERTYPE *));
+  fail_if (!pp_hdrs_a || !pp_hdrs_b);
+
+  _comp_to_state (p_hdl_a, &ctx_a, OMX_StateIdle, pp_hdrs_a, &port_def);
+  _comp_to_state (p_hdl_b, &ctx_b, OMX_StateIdle, pp_hdrs_b, &port_def);
+  _comp_to_state (p_hdl_a, &ctx_a, OMX_StateExecuting, pp_hdrs_a, &port_def);
+  _comp_to_state (p_hdl_b, &ctx_b, OMX_StateExecuting, pp_hdrs_b, &port_def);
+
+  /* A's EmptyBufferDone hands a buffer to B, and B's EmptyBufferDone calls
+     back into A */
+  g_reentry.p_hdl_a = p_hdl_a;
+  g_reentry.p_hdl_b = p_hdl_b;
+  g_reentry.p_hdr_b = pp_hdrs_b[0];
+  g_reentry.p_hdr_b->nFilledLen = g_reentry.p_hdr_b->nAllocLen;
+  g_reentry.etb_error = OMX_ErrorMax;
+  g_reentry.getstate_error = OMX_ErrorMax;
+  g_reentry.state_a = OMX_StateMax;
+
+  error = _ctx_reset (&ctx_a);
+  error = _ctx_reset (&ctx_b);
+  pp_hdrs_a[0]->nFilledLen = pp_hdrs_a[0]->nAllocLen;
+  error = OMX_EmptyThisBuffer (p_hdl_a, pp_hdrs_a[0]);
+  fail_if (OMX_ErrorNone != error);
+
+  /* Await BufferDone callbacks; a deadlock in the call back into A would
+     keep B's from ever arriving */
+  error = _ctx_wait (&ctx_a, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (p_ctx_a->p_hdr != pp_hdrs_a[0]);
+  error = _ctx_wait (&ctx_b, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (OMX_TRUE == timedout);
+  fail_if (p_ctx_b->p_hdr != pp_hdrs_b[0]);
+
+  fail_if (OMX_ErrorNone != g_reentry.etb_error);
+  fail_if (OMX_ErrorNone != g_reentry.getstate_error);
+  fail_if (OMX_StateExecuting != g_reentry.state_a);
+
+  _comp_to_state (p_hdl_a, &ctx_a, OMX_StateIdle, pp_hdrs_a, &port_def);
+  _comp_to_state (p_hdl_b, &ctx_b, OMX_StateIdle, pp_hdrs_b, &port_def);
+  _comp_to_state (p_hdl_a, &ctx_a, OMX_StateLoaded, pp_hdrs_a, &port_def);
+  _comp_to_state (p_hdl_b, &ctx_b, OMX_StateLoaded, pp_hdrs_b, &port_def);
+
+  error = OMX_FreeHandle (p_hdl_a);
+  fail_if (OMX_ErrorNone != error);
+  error = OMX_FreeHandle (p_hdl_b);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Deinit ();
+  fail_if (OMX_ErrorNone != error);
+
+  tiz_mem_free (pp_hdrs_a);
+  tiz_mem_free (pp_hdrs_b);
+  _ctx_destroy (&ctx_a);
+  _ctx_destroy (&ctx_b);
+}
+END_TEST
+
+/*
+ * Batch claim/release: the test component claims up to four headers per
+ * buffers-ready event and returns them all together
+ */
+
+#define CHECK_BATCH_MAX_HDRS 64
+
+typedef struct check_batch_context check_batch_context_t;
+struct check_batch_context
+{
+  OMX_BUFFERHEADERTYPE *p_hdrs[CHECK_BATCH_MAX_HDRS];
+  OMX_U32 nhdrs;
+  OMX_U32 nexpected;
+};
+
+static check_batch_context_t g_batch;
+
+static OMX_ERRORTYPE
+check_batch_EmptyBufferDone (OMX_HANDLETYPE ap_hdl, OMX_PTR ap_app_data,
+                             OMX_BUFFERHEADERTYPE * ap_buf)
+{
+  assert (ap_app_data);
+  assert (ap_buf);
+  assert (g_batch.nhdrs < CHECK_BATCH_MAX_HDRS);
+
+  /* All callbacks arrive on the component's thread */
+  g_batch.p_hdrs[g_batch.nhdrs++] = ap_buf;
+  if (g_batch.nhdrs == g_batch.nexpected)
+    {
+      _ctx_signal ((cc_ctx_t *) ap_app_data);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_CALLBACKTYPE _check_batch_cbacks = {
+  check_EventHandler,
+  check_batch_EmptyBufferDone,
+  check_FillBufferDone
+};
+
+START_TEST (test_tizonia_transfer_buffer_batch)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  OMX_HANDLETYPE p_hdl = 0;
+  cc_ctx_t ctx;
+  OMX_BOOL timedout = OMX_FALSE;
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_BUFFERHEADERTYPE **pp_hdrs = NULL;
+  OMX_U32 i;
+  OMX_U32 round;
+
+  error = _ctx_init (&ctx);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Init ();
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_GetHandle (&p_hdl, COMPONENT_NAME, (OMX_PTR *) (&ctx),
+                         &_check_batch_cbacks);
+  fail_if (OMX_ErrorNone != error);
+
+  port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  error = OMX_GetParameter (p_hdl, OMX_IndexParamPortDefinition, &port_def);
+  fail_if (OMX_ErrorNone != error);
+  fail_if (port_def.nBufferCountActual > CHECK_BATCH_MAX_HDRS);
+  pp_hdrs = tiz_mem_calloc (port_def.nBufferCountActual,
+                            sizeof (OMX_BUFFERHEADERTYPE *));
+  fail_if (!pp_hdrs);
+
+  _comp_to_state (p_hdl, &ctx, OMX_StateIdle, pp_hdrs, &port_def);
+  _comp_to_state (p_hdl, &ctx, OMX_StateExecuting, pp_hdrs, &port_def);
+
+  /* Queue every buffer at once, a few times over; each one must come back
+     exactly once, and in the order it was queued */
+  for (round = 0; round < 3; ++round)
+    {
+      memset (&g_batch, 0, sizeof (g_batch));
+      g_batch.nexpected = port_def.nBufferCountActual;
+      error = _ctx_reset (&ctx);
+      fail_if (OMX_ErrorNone != error);
+
+      for (i = 0; i < port_def.nBufferCountActual; ++i)
+        {
+          pp_hdrs[i]->nFilledLen = pp_hdrs[i]->nAllocLen;
+          pp_hdrs[i]->nFlags = 0;
+          error = OMX_EmptyThisBuffer (p_hdl, pp_hdrs[i]);
+          fail_if (OMX_ErrorNone != error);
+        }
+
+      error = _ctx_wait (&ctx, TIMEOUT_EXPECTING_SUCCESS, &timedout);
+      fail_if (OMX_ErrorNone != error);
+      fail_if (OMX_TRUE == timedout);
+      fail_if (g_batch.nhdrs != port_def.nBufferCountActual);
+      for (i = 0; i < port_def.nBufferCountActual; ++i)
+        {
+          fail_if (g_batch.p_hdrs[i] != pp_hdrs[i]);
+        }
+    }
+
+  _comp_to_state (p_hdl, &ctx, OMX_StateIdle, pp_hdrs, &port_def);
+  _comp_to_state (p_hdl, &ctx, OMX_StateLoaded, pp_hdrs, &port_def);
+
+  error = OMX_FreeHandle (p_hdl);
+  fail_if (OMX_ErrorNone != error);
+
+  error = OMX_Deinit ();
+  fail_if (OMX_ErrorNone != error);
+
+  tiz_mem_free (pp_hdrs);
+  _ctx_destroy (&ctx);
+}
+END_TEST
+
+/*
+ * Kernel header lists
+ */
+
+#define CHECK_RING_MAX_HDRS 32
+
+static OMX_BUFFERHEADERTYPE g_ring_hdrs[CHECK_RING_MAX_HDRS];
+
+static void
+_ring_check_contents (const tiz_krn_hdr_ring_t * ap_ring,
+                      const OMX_U32 * ap_expected, const OMX_U32 a_len)
+{
+  OMX_U32 i;
+  fail_if (hdr_ring_length (ap_ring) != (OMX_S32) a_len);
+  for (i = 0; i < a_len; ++i)
+    {
+      fail_if (*hdr_ring_slot (ap_ring, i) != &g_ring_hdrs[ap_expected[i]]);
+    }
+}
+
+START_TEST (test_kernel_hdr_ring_erase)
+{
+  tiz_krn_hdr_ring_t ring;
+  OMX_U32 i;
+  const OMX_U32 after_push[] = { 2, 3, 4, 5, 6, 7 };
+  const OMX_U32 after_front_shift[] = { 2, 4, 5, 6, 7 };
+  const OMX_U32 after_back_shift[] = { 2, 4, 5, 7 };
+  const OMX_U32 after_last[] = { 2, 4, 5 };
+  const OMX_U32 after_first[] = { 4, 5 };
+
+  memset (&ring, 0, sizeof (ring));
+
+  for (i = 0; i < 6; ++i)
+    {
+      fail_if (OMX_ErrorNone != hdr_ring_push_back (&ring, &g_ring_hdrs[i], 6));
+    }
+  fail_if (6 != ring.cap);
+
+  /* Removing the front header only moves the head */
+  hdr_ring_erase (&ring, 0);
+  hdr_ring_erase (&ring, 0);
+  fail_if (2 != ring.head);
+
+  /* These two wrap around the end of the array */
+  fail_if (OMX_ErrorNone != hdr_ring_push_back (&ring, &g_ring_hdrs[6], 6));
+  fail_if (OMX_ErrorNone != hdr_ring_push_back (&ring, &g_ring_hdrs[7], 6));
+  fail_if (6 != ring.cap);
+  _ring_check_contents (&ring, after_push, 6);
+
+  /* Near the front: the preceding headers move up one slot */
+  hdr_ring_erase (&ring, 1);
+  fail_if (3 != ring.head);
+  _ring_check_contents (&ring, after_front_shift, 5);
+
+  /* Near the back, across the wrap: the following headers move down */
+  hdr_ring_erase (&ring, 3);
+  fail_if (3 != ring.head);
+  _ring_check_contents (&ring, after_back_shift, 4);
+
+  hdr_ring_erase (&ring, 3);
+  _ring_check_contents (&ring, after_last, 3);
+
+  hdr_ring_erase (&ring, 0);
+  _ring_check_contents (&ring, after_first, 2);
+
+  hdr_ring_erase (&ring, 0);
+  hdr_ring_erase (&ring, 0);
+  fail_if (0 != hdr_ring_length (&ring));
+
+  hdr_ring_destroy (&ring);
+  fail_if (NULL != ring.pp_hdrs);
+}
+END_TEST
+
+START_TEST (test_kernel_hdr_ring_erase_model)
+{
+  tiz_krn_hdr_ring_t ring;
+  OMX_U32 model[CHECK_RING_MAX_HDRS];
+  OMX_U32 len = 0;
+  OMX_U32 next = 0;
+  OMX_U32 seed = 12345;
+  OMX_U32 op, idx;
+
+  memset (&ring, 0, sizeof (ring));
+
+  /* Random pushes and erases at every position, checked against a plain
+     array; the ring never grows past its initial capacity, so the head
+     keeps wrapping */
+  for (op = 0; op < 20000; ++op)
+    {
+      seed = seed * 1664525u + 1013904223u;
+      if (len == 0 || (len < CHECK_RING_MAX_HDRS && (seed >> 28) < 8))
+        {
+          fail_if (OMX_ErrorNone
+                   != hdr_ring_push_back (&ring, &g_ring_hdrs[next],
+                                          CHECK_RING_MAX_HDRS));
+          model[len++] = next;
+          next = (next + 1) % CHECK_RING_MAX_HDRS;
+        }
+      else
+        {
+          idx = (seed >> 8) % len;
+          hdr_ring_erase (&ring, idx);
+          memmove (&model[idx], &model[idx + 1],
+                   (len - idx - 1) * sizeof (OMX_U32));
+          --len;
+        }
+      fail_if (CHECK_RING_MAX_HDRS != ring.cap);
+      fail_if (ring.head >= ring.cap);
+      _ring_check_contents (&ring, model, len);
+    }
+
+  hdr_ring_destroy (&ring);
+}
+END_TEST
+
+START_TEST (test_kernel_hdr_ring_reserve_and_splice)
+{
+  tiz_krn_hdr_ring_t dst;
+  tiz_krn_hdr_ring_t src;
+  OMX_U32 i;
+  const OMX_U32 spliced[] = { 3, 4, 5, 10, 11, 12, 13 };
+  const OMX_U32 grown[] = { 3, 4, 5, 10, 11, 12, 13, 14 };
+
+  memset (&dst, 0, sizeof (dst));
+  memset (&src, 0, sizeof (src));
+
+  /* Make both lists wrap around */
+  for (i = 0; i < 4; ++i)
+    {
+      fail_if (OMX_ErrorNone != hdr_ring_push_back (&dst, &g_ring_hdrs[i], 4));
+      fail_if (OMX_ErrorNone
+               != hdr_ring_push_back (&src, &g_ring_hdrs[8 + i], 4));
+    }
+  hdr_ring_erase (&dst, 0);
+  hdr_ring_erase (&dst, 0);
+  hdr_ring_erase (&dst, 0);
+  fail_if (OMX_ErrorNone != hdr_ring_push_back (&dst, &g_ring_hdrs[4], 4));
+  fail_if (OMX_ErrorNone != hdr_ring_push_back (&dst, &g_ring_hdrs[5], 4));
+  hdr_ring_erase (&src, 0);
+  hdr_ring_erase (&src, 0);
+  fail_if (OMX_ErrorNone != hdr_ring_push_back (&src, &g_ring_hdrs[12], 4));
+  fail_if (OMX_ErrorNone != hdr_ring_push_back (&src, &g_ring_hdrs[13], 4));
+  fail_if (0 == dst.head || 0 == src.head);
+
+  /* Splicing grows the destination, which unwraps it */
+  fail_if (7 != hdr_ring_splice (&dst, &src));
+  fail_if (0 != hdr_ring_length (&src));
+  fail_if (0 != dst.head);
+  _ring_check_contents (&dst, spliced, 7);
+
+  /* Reserving less than the current capacity is a no-op */
+  fail_if (OMX_ErrorNone != hdr_ring_reserve (&dst, 2));
+  fail_if (7 != dst.cap);
+  fail_if (OMX_ErrorNone != hdr_ring_push_back (&dst, &g_ring_hdrs[14], 0));
+  _ring_check_contents (&dst, grown, 8);
+
+  hdr_ring_clear (&dst);
+  fail_if (0 != hdr_ring_length (&dst));
+  fail_if (0 == dst.cap);
+
+  hdr_ring_destroy (&dst);
+  hdr_ring_destroy (&src);
+}
+END_TEST
+
+/*
+ * carry-over store
+ */
+
+static void
+_spill_init_hdr (OMX_BUFFERHEADERTYPE * ap_hdr, OMX_U8 * ap_buf,
+                 const OMX_U32 a_alloc_len, const OMX_U32 a_offset,
+                 const OMX_U32 a_filled_len)
+{
+  memset (ap_hdr, 0, sizeof (OMX_BUFFERHEADERTYPE));
+  ap_hdr->pBuffer = ap_buf;
+  ap_hdr->nAllocLen = a_alloc_len;
+  ap_hdr->nOffset = a_offset;
+  ap_hdr->nFilledLen = a_filled_len;
+}
+
+static void
+_spill_check_bytes (const OMX_U8 * ap_data, const OMX_U8 a_first,
+                    const size_t a_nbytes)
+{
+  size_t i;
+  for (i = 0; i < a_nbytes; ++i)
+    {
+      fail_if ((OMX_U8) (a_first + i) != ap_data[i]);
+    }
+}
+
+/* Leaves the read position of the store close to the end of its first
+   page, and then produces a few more bytes in place with reserve/commit, so
+   that, in the ring, the new bytes straddle the end of the storage */
+static void
+_spill_check_reserve_and_commit (tiz_filter_spill_t * ap_spill,
+                                 const size_t a_capacity)
+{
+  OMX_BUFFERHEADERTYPE hdr;
+  OMX_BUFFERHEADERTYPE * p_hdr = &hdr;
+  tiz_filter_spill_stats_t stats;
+  OMX_U8 * p_data = NULL;
+  OMX_U8 * p_out = NULL;
+  OMX_U8 * p_span = NULL;
+  size_t avail = 0;
+  size_t i;
+
+  p_data = malloc (a_capacity);
+  p_out = malloc (a_capacity);
+  fail_if (!p_data || !p_out);
+  for (i = 0; i < a_capacity; ++i)
+    {
+      p_data[i] = (OMX_U8) i;
+    }
+
+  fail_if (a_capacity - 8 != tiz_filter_spill_push (ap_spill, p_data,
+                                                    a_capacity - 8));
+  _spill_init_hdr (&hdr, p_out, a_capacity - 16, 0, 0);
+  fail_if (0 != tiz_filter_spill_scatter (ap_spill, &p_hdr, 1, NULL, 0));
+  fail_if (a_capacity - 16 != hdr.nFilledLen);
+  _spill_check_bytes (p_out, 0, a_capacity - 16);
+  fail_if (8 != tiz_filter_spill_available (ap_spill));
+
+  /* Contiguous room, even if it wraps around the end of the ring */
+  p_span = tiz_filter_spill_reserve (ap_spill, 32, &avail);
+  fail_if (NULL == p_span);
+  fail_if (32 != avail);
+  for (i = 0; i < 32; ++i)
+    {
+      p_span[i] = (OMX_U8) (a_capacity - 8 + i);
+    }
+  fail_if (32 != tiz_filter_spill_commit (ap_spill, 32));
+  fail_if (40 != tiz_filter_spill_available (ap_spill));
+
+  _spill_init_hdr (&hdr, p_out, a_capacity, 0, 0);
+  fail_if (0 != tiz_filter_spill_scatter (ap_spill, &p_hdr, 1, NULL, 0));
+  fail_if (40 != hdr.nFilledLen);
+  _spill_check_bytes (p_out, (OMX_U8) (a_capacity - 16), 40);
+  fail_if (0 != tiz_filter_spill_available (ap_spill));
+
+  /* A full store has no room; the whole request counts as dropped */
+  fail_if (a_capacity != tiz_filter_spill_push (ap_spill, p_data, a_capacity));
+  avail = 1;
+  fail_if (NULL != tiz_filter_spill_reserve (ap_spill, 16, &avail));
+  fail_if (0 != avail);
+
+  tiz_filter_spill_get_stats (ap_spill, &stats);
+  fail_if (2 * a_capacity + 24 != stats.nbytes_spilled);
+  fail_if (a_capacity + 24 != stats.nbytes_drained);
+  fail_if (16 != stats.nbytes_dropped);
+  fail_if (3 != stats.nspills);
+  fail_if (a_capacity != stats.high_water);
+  fail_if (a_capacity != stats.capacity);
+
+  free (p_out);
+  free (p_data);
+}
+
+START_TEST (test_filter_spill_push_at_capacity)
+{
+  tiz_filter_spill_t * p_spill = NULL;
+  tiz_filter_spill_stats_t stats;
+  OMX_BUFFERHEADERTYPE hdr;
+  OMX_BUFFERHEADERTYPE * p_hdr = &hdr;
+  OMX_U8 data[64];
+  OMX_U8 out[64];
+  size_t i;
+
+  for (i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = (OMX_U8) i;
+    }
+
+  fail_if (OMX_ErrorNone != tiz_filter_spill_init (&p_spill, 64, 1));
+  fail_if (48 != tiz_filter_spill_push (p_spill, data, 48));
+
+  /* Only what fits is stored; the rest is dropped */
+  fail_if (16 != tiz_filter_spill_push (p_spill, data + 48, 32));
+  fail_if (64 != tiz_filter_spill_available (p_spill));
+  fail_if (0 != tiz_filter_spill_push (p_spill, data, 8));
+  fail_if (64 != tiz_filter_spill_available (p_spill));
+
+  tiz_filter_spill_get_stats (p_spill, &stats);
+  fail_if (64 != stats.nbytes_spilled);
+  fail_if (0 != stats.nbytes_drained);
+  fail_if (16 + 8 != stats.nbytes_dropped);
+  fail_if (3 != stats.nspills);
+  fail_if (64 != stats.high_water);
+  fail_if (64 != stats.capacity);
+
+  /* What was stored comes out intact */
+  _spill_init_hdr (&hdr, out, sizeof (out), 0, 0);
+  fail_if (0 != tiz_filter_spill_scatter (p_spill, &p_hdr, 1, NULL, 0));
+  fail_if (64 != hdr.nFilledLen);
+  _spill_check_bytes (out, 0, 64);
+  fail_if (0 != tiz_filter_spill_available (p_spill));
+
+  tiz_filter_spill_destroy (p_spill);
+}
+END_TEST
+
+START_TEST (test_filter_spill_unit_rounding)
+{
+  tiz_filter_spill_t * p_spill = NULL;
+  tiz_filter_spill_stats_t stats;
+  OMX_BUFFERHEADERTYPE hdr;
+  OMX_BUFFERHEADERTYPE * p_hdr = &hdr;
+  OMX_U8 data[64];
+  OMX_U8 out[16];
+  OMX_U8 * p_span = NULL;
+  size_t avail = 0;
+  size_t i;
+
+  for (i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = (OMX_U8) i;
+    }
+
+  /* e.g. 16-bit stereo frames */
+  fail_if (OMX_ErrorNone != tiz_filter_spill_init (&p_spill, 64, 4));
+
+  /* Partial frames are not carried over */
+  fail_if (8 != tiz_filter_spill_push (p_spill, data, 10));
+  fail_if (8 != tiz_filter_spill_available (p_spill));
+
+  /* Nor reserved */
+  p_span = tiz_filter_spill_reserve (p_spill, 30, &avail);
+  fail_if (NULL == p_span);
+  fail_if (28 != avail);
+  memcpy (p_span, data + 8, avail);
+  fail_if (28 != tiz_filter_spill_commit (p_spill, avail));
+  fail_if (36 != tiz_filter_spill_available (p_spill));
+
+  /* Near the top, only the room for whole frames is reserved */
+  fail_if (24 != tiz_filter_spill_push (p_spill, data + 36, 26));
+  p_span = tiz_filter_spill_reserve (p_spill, 8, &avail);
+  fail_if (NULL == p_span);
+  fail_if (4 != avail);
+  memcpy (p_span, data + 60, avail);
+  fail_if (4 != tiz_filter_spill_commit (p_spill, avail));
+  fail_if (64 != tiz_filter_spill_available (p_spill));
+
+  tiz_filter_spill_get_stats (p_spill, &stats);
+  fail_if (64 != stats.nbytes_spilled);
+  fail_if (2 + 2 + 2 + 4 != stats.nbytes_dropped);
+
+  /* Headers only receive whole frames: 15 bytes of room take 12 */
+  _spill_init_hdr (&hdr, out, sizeof (out), 1, 0);
+  fail_if (0 != tiz_filter_spill_scatter (p_spill, &p_hdr, 1, NULL, 0));
+  fail_if (12 != hdr.nFilledLen);
+  _spill_check_bytes (out + 1, 0, 12);
+  fail_if (52 != tiz_filter_spill_available (p_spill));
+
+  /* A unit of zero means bytes */
+  tiz_filter_spill_set_unit (p_spill, 0);
+  _spill_init_hdr (&hdr, out, sizeof (out), 1, 0);
+  fail_if (0 != tiz_filter_spill_scatter (p_spill, &p_hdr, 1, NULL, 0));
+  fail_if (15 != hdr.nFilledLen);
+  _spill_check_bytes (out + 1, 12, 15);
+  fail_if (37 != tiz_filter_spill_available (p_spill));
+
+  tiz_filter_spill_destroy (p_spill);
+}
+END_TEST
+
+START_TEST (test_filter_spill_scatter_order)
+{
+  tiz_filter_spill_t * p_spill = NULL;
+  tiz_filter_spill_stats_t stats;
+  OMX_BUFFERHEADERTYPE hdrs[3];
+  OMX_BUFFERHEADERTYPE * p_hdrs[3];
+  OMX_U8 bufs[3][10];
+  OMX_U8 data[16];
+  size_t i;
+
+  for (i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = (OMX_U8) i;
+    }
+
+  fail_if (OMX_ErrorNone != tiz_filter_spill_init (&p_spill, 64, 1));
+
+  /* Bytes 0 to 11 are carried over; 12 to 15 are new */
+  fail_if (12 != tiz_filter_spill_push (p_spill, data, 12));
+
+  /* Headers with room for 5, 5 and (after some existing data) 7 bytes */
+  for (i = 0; i < 3; ++i)
+    {
+      memset (bufs[i], 0xEE, sizeof (bufs[i]));
+      p_hdrs[i] = &(hdrs[i]);
+    }
+  _spill_init_hdr (&(hdrs[0]), bufs[0], 5, 0, 0);
+  _spill_init_hdr (&(hdrs[1]), bufs[1], 5, 0, 0);
+  _spill_init_hdr (&(hdrs[2]), bufs[2], 10, 2, 1);
+
+  /* The first two headers take carried-over bytes only; the third one
+     gets the rest of them, and then the new data */
+  fail_if (4 != tiz_filter_spill_scatter (p_spill, p_hdrs, 3, data + 12, 4));
+  fail_if (5 != hdrs[0].nFilledLen);
+  fail_if (5 != hdrs[1].nFilledLen);
+  fail_if (1 + 6 != hdrs[2].nFilledLen);
+  _spill_check_bytes (bufs[0], 0, 5);
+  _spill_check_bytes (bufs[1], 5, 5);
+  fail_if (0xEE != bufs[2][2]);
+  _spill_check_bytes (bufs[2] + 3, 10, 6);
+  fail_if (0 != tiz_filter_spill_available (p_spill));
+
+  /* New data must wait while carried-over bytes remain */
+  fail_if (12 != tiz_filter_spill_push (p_spill, data, 12));
+  _spill_init_hdr (&(hdrs[0]), bufs[0], 5, 0, 0);
+  _spill_init_hdr (&(hdrs[1]), bufs[1], 5, 0, 0);
+  fail_if (0 != tiz_filter_spill_scatter (p_spill, p_hdrs, 2, data + 12, 4));
+  fail_if (5 != hdrs[0].nFilledLen);
+  fail_if (5 != hdrs[1].nFilledLen);
+  _spill_check_bytes (bufs[0], 0, 5);
+  _spill_check_bytes (bufs[1], 5, 5);
+  fail_if (2 != tiz_filter_spill_available (p_spill));
+
+  tiz_filter_spill_get_stats (p_spill, &stats);
+  fail_if (24 != stats.nbytes_spilled);
+  fail_if (22 != stats.nbytes_drained);
+  fail_if (0 != stats.nbytes_dropped);
+
+  tiz_filter_spill_destroy (p_spill);
+}
+END_TEST
+
+START_TEST (test_filter_spill_reserve_and_commit_ring)
+{
+  tiz_filter_spill_t * p_spill = NULL;
+  const size_t capacity = sysconf (_SC_PAGESIZE);
+
+  fail_if (OMX_ErrorNone != tiz_filter_spill_init (&p_spill, capacity, 1));
+  _spill_check_reserve_and_commit (p_spill, capacity);
+  tiz_filter_spill_destroy (p_spill);
+}
+END_TEST
+
+START_TEST (test_filter_spill_reserve_and_commit_plain)
+{
+  tiz_filter_spill_t * p_spill = NULL;
+  const size_t capacity = sysconf (_SC_PAGESIZE);
+
+  fail_if (OMX_ErrorNone
+           != tiz_filter_spill_init_plain (&p_spill, capacity, 1));
+  _spill_check_reserve_and_commit (p_spill, capacity);
+  tiz_filter_spill_destroy (p_spill);
+}
+END_TEST
+
 Suite *
 tiz_suite (void)
 {
   TCase *tc_tizonia;
+  TCase *tc_kernel;
+  TCase *tc_filter;
   Suite *s = suite_create ("libtizonia");
 
   putenv(TIZ_PLATFORM_RC_FILE_ENV);
@@ -2066,12 +2834,31 @@ tiz_suite (void)
   /*                   test_tizonia_command_cancellation_loaded_to_idle_with_buffers_port_disabled_cant_unblock_transition); */
   tcase_add_test (tc_tizonia,
                   test_tizonia_command_cancellation_disabled_to_enabled_no_buffers);
+  tcase_add_test (tc_tizonia,
+                  test_tizonia_pool_reentrant_call_from_fast_tunnel_callback);
+  tcase_add_test (tc_tizonia, test_tizonia_transfer_buffer_batch);
   /* TEST DISABLED */
   /*   tcase_add_test (tc_tizonia, */
   /*                   test_tizonia_command_cancellation_disabled_to_enabled_with_tunneled_supplied_buffers); */
 
   suite_add_tcase (s, tc_tizonia);
 
+  /* Kernel internals test cases */
+  tc_kernel = tcase_create ("kernel");
+  tcase_add_test (tc_kernel, test_kernel_hdr_ring_erase);
+  tcase_add_test (tc_kernel, test_kernel_hdr_ring_erase_model);
+  tcase_add_test (tc_kernel, test_kernel_hdr_ring_reserve_and_splice);
+  suite_add_tcase (s, tc_kernel);
+
+  /* Filter processor carry-over store test cases */
+  tc_filter = tcase_create ("filter");
+  tcase_add_test (tc_filter, test_filter_spill_push_at_capacity);
+  tcase_add_test (tc_filter, test_filter_spill_unit_rounding);
+  tcase_add_test (tc_filter, test_filter_spill_scatter_order);
+  tcase_add_test (tc_filter, test_filter_spill_reserve_and_commit_ring);
+  tcase_add_test (tc_filter, test_filter_spill_reserve_and_commit_plain);
+  suite_add_tcase (s, tc_filter);
+
   return s;
 }
 
@@ -0,0 +1,356 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizaio.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Asynchronous file I/O
+ *
+ * Requests in flight are kept in a singly-linked list, in submission
+ * order. I/O threads pick the next request that has not been started yet
+ * (the 'next' cursor), and the completion eventfd is only signalled when the
+ * head of the list is done, as that is the only request that tiz_aio_reap
+ * may return.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.aio"
+#endif
+
+#define AIO_MAX_THREADS 16
+
+struct tiz_aio
+{
+  tiz_thread_t threads[AIO_MAX_THREADS];
+  OMX_S32 nthreads;
+  OMX_S32 depth;
+  OMX_S32 pending;
+  OMX_S32 busy;
+  tiz_aio_req_t * p_head; /* oldest request in flight */
+  tiz_aio_req_t * p_tail; /* newest request in flight */
+  tiz_aio_req_t * p_next; /* oldest request not started yet */
+  tiz_mutex_t mutex;
+  tiz_cond_t cond;      /* signalled when there is work, or on stop */
+  tiz_cond_t idle_cond; /* signalled when a request completes */
+  int efd;
+  bool stopping;
+};
+
+static void
+do_io (tiz_aio_req_t * ap_req)
+{
+  char * p_buf = ap_req->p_buf;
+  size_t done = 0;
+
+  ap_req->error = 0;
+  while (done < ap_req->len)
+    {
+      const off_t offset = ap_req->offset + done;
+      ssize_t n = (ETIZAioOpRead == ap_req->op)
+                    ? pread (ap_req->fd, p_buf + done, ap_req->len - done,
+                             offset)
+                    : pwrite (ap_req->fd, p_buf + done, ap_req->len - done,
+                              offset);
+      if (n < 0)
+        {
+          if (EINTR == errno)
+            {
+              continue;
+            }
+          ap_req->error = errno;
+          break;
+        }
+      if (0 == n)
+        {
+          /* End of file */
+          break;
+        }
+      done += n;
+    }
+
+  ap_req->result = ap_req->error ? -1 : (ssize_t) done;
+}
+
+static void
+signal_completion (tiz_aio_t * ap_aio)
+{
+  const uint64_t one = 1;
+  if (write (ap_aio->efd, &one, sizeof (one)) < 0 && EAGAIN != errno)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "eventfd write failed [%s]",
+               strerror (errno));
+    }
+}
+
+static void
+clear_completion (tiz_aio_t * ap_aio)
+{
+  uint64_t count = 0;
+  (void) read (ap_aio->efd, &count, sizeof (count));
+}
+
+static void *
+io_thread_func (void * ap_arg)
+{
+  tiz_aio_t * p_aio = ap_arg;
+  tiz_aio_req_t * p_req = NULL;
+
+  assert (p_aio);
+
+  (void) tiz_mutex_lock (&(p_aio->mutex));
+  for (;;)
+    {
+      while (!p_aio->stopping && !p_aio->p_next)
+        {
+          (void) tiz_cond_wait (&(p_aio->cond), &(p_aio->mutex));
+        }
+
+      if (p_aio->stopping)
+        {
+          break;
+        }
+
+      p_req = p_aio->p_next;
+      p_aio->p_next = p_req->p_next;
+      p_aio->busy++;
+      (void) tiz_mutex_unlock (&(p_aio->mutex));
+
+      do_io (p_req);
+
+      (void) tiz_mutex_lock (&(p_aio->mutex));
+      p_aio->busy--;
+      p_req->done = 1;
+      if (p_req == p_aio->p_head)
+        {
+          signal_completion (p_aio);
+        }
+      (void) tiz_cond_broadcast (&(p_aio->idle_cond));
+    }
+  (void) tiz_mutex_unlock (&(p_aio->mutex));
+
+  return NULL;
+}
+
+OMX_ERRORTYPE
+tiz_aio_init (tiz_aio_ptr_t * app_aio, OMX_S32 a_nthreads, OMX_S32 a_depth)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  tiz_aio_t * p_aio = NULL;
+
+  assert (app_aio);
+  assert (a_depth > 0);
+
+  a_nthreads = a_nthreads > 0 ? a_nthreads : 1;
+  a_nthreads = MIN (a_nthreads, AIO_MAX_THREADS);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "aio threads [%ld] depth [%ld]",
+           (long) a_nthreads, (long) a_depth);
+
+  if (!(p_aio = tiz_mem_calloc (1, sizeof (tiz_aio_t))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_aio->depth = a_depth;
+  if ((p_aio->efd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "eventfd failed [%s]", strerror (errno));
+      tiz_mem_free (p_aio);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  if (OMX_ErrorNone != (rc = tiz_mutex_init (&(p_aio->mutex)))
+      || OMX_ErrorNone != (rc = tiz_cond_init (&(p_aio->cond)))
+      || OMX_ErrorNone != (rc = tiz_cond_init (&(p_aio->idle_cond))))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : while initialising the context",
+               tiz_err_to_str (rc));
+    }
+
+  while (OMX_ErrorNone == rc && p_aio->nthreads < a_nthreads)
+    {
+      if (OMX_ErrorNone
+          == (rc = tiz_thread_create (&(p_aio->threads[p_aio->nthreads]), 0,
+                                      0, io_thread_func, p_aio)))
+        {
+          p_aio->nthreads++;
+        }
+    }
+
+  if (OMX_ErrorNone != rc)
+    {
+      tiz_aio_destroy (p_aio);
+      p_aio = NULL;
+    }
+
+  *app_aio = p_aio;
+  return rc;
+}
+
+void
+tiz_aio_destroy (tiz_aio_t * ap_aio)
+{
+  if (ap_aio)
+    {
+      OMX_PTR p_result = NULL;
+      OMX_S32 i = 0;
+
+      (void) tiz_mutex_lock (&(ap_aio->mutex));
+      ap_aio->stopping = true;
+      (void) tiz_cond_broadcast (&(ap_aio->cond));
+      (void) tiz_mutex_unlock (&(ap_aio->mutex));
+
+      /* Threads finish the request they are carrying out before exiting */
+      for (i = 0; i < ap_aio->nthreads; ++i)
+        {
+          (void) tiz_thread_join (&(ap_aio->threads[i]), &p_result);
+        }
+
+      (void) tiz_cond_destroy (&(ap_aio->idle_cond));
+      (void) tiz_cond_destroy (&(ap_aio->cond));
+      (void) tiz_mutex_destroy (&(ap_aio->mutex));
+      (void) close (ap_aio->efd);
+      tiz_mem_free (ap_aio);
+    }
+}
+
+int
+tiz_aio_get_fd (const tiz_aio_t * ap_aio)
+{
+  assert (ap_aio);
+  return ap_aio->efd;
+}
+
+OMX_ERRORTYPE
+tiz_aio_submit (tiz_aio_t * ap_aio, tiz_aio_req_t * ap_req)
+{
+  assert (ap_aio);
+  assert (ap_req);
+  assert (ap_req->p_buf || 0 == ap_req->len);
+
+  tiz_check_omx (tiz_mutex_lock (&(ap_aio->mutex)));
+
+  if (ap_aio->pending >= ap_aio->depth)
+    {
+      (void) tiz_mutex_unlock (&(ap_aio->mutex));
+      return OMX_ErrorNoMore;
+    }
+
+  ap_req->p_next = NULL;
+  ap_req->done = 0;
+  ap_req->result = 0;
+  ap_req->error = 0;
+
+  if (ap_aio->p_tail)
+    {
+      ap_aio->p_tail->p_next = ap_req;
+    }
+  else
+    {
+      ap_aio->p_head = ap_req;
+    }
+  ap_aio->p_tail = ap_req;
+
+  if (!ap_aio->p_next)
+    {
+      ap_aio->p_next = ap_req;
+    }
+
+  __atomic_store_n (&(ap_aio->pending), ap_aio->pending + 1,
+                    __ATOMIC_RELEASE);
+  (void) tiz_cond_signal (&(ap_aio->cond));
+  tiz_check_omx (tiz_mutex_unlock (&(ap_aio->mutex)));
+
+  return OMX_ErrorNone;
+}
+
+tiz_aio_req_t *
+tiz_aio_reap (tiz_aio_t * ap_aio)
+{
+  tiz_aio_req_t * p_req = NULL;
+
+  assert (ap_aio);
+
+  (void) tiz_mutex_lock (&(ap_aio->mutex));
+  if (ap_aio->p_head && ap_aio->p_head->done)
+    {
+      p_req = ap_aio->p_head;
+      ap_aio->p_head = p_req->p_next;
+      if (!ap_aio->p_head)
+        {
+          ap_aio->p_tail = NULL;
+        }
+      p_req->p_next = NULL;
+      __atomic_store_n (&(ap_aio->pending), ap_aio->pending - 1,
+                        __ATOMIC_RELEASE);
+    }
+  else
+    {
+      /* Nothing to return; the fd becomes readable again when the new head
+         completes. The mutex makes this race-free with the I/O threads */
+      clear_completion (ap_aio);
+    }
+  (void) tiz_mutex_unlock (&(ap_aio->mutex));
+
+  return p_req;
+}
+
+void
+tiz_aio_drain (tiz_aio_t * ap_aio)
+{
+  assert (ap_aio);
+  (void) tiz_mutex_lock (&(ap_aio->mutex));
+  while (ap_aio->p_next || ap_aio->busy > 0)
+    {
+      (void) tiz_cond_wait (&(ap_aio->idle_cond), &(ap_aio->mutex));
+    }
+  (void) tiz_mutex_unlock (&(ap_aio->mutex));
+}
+
+OMX_S32
+tiz_aio_pending (const tiz_aio_t * ap_aio)
+{
+  assert (ap_aio);
+  return __atomic_load_n (&(ap_aio->pending), __ATOMIC_ACQUIRE);
+}
+
+OMX_BOOL
+tiz_aio_is_full (const tiz_aio_t * ap_aio)
+{
+  assert (ap_aio);
+  return tiz_aio_pending (ap_aio) >= ap_aio->depth ? OMX_TRUE : OMX_FALSE;
+}
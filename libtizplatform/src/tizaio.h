@@ -0,0 +1,183 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizaio.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Asynchronous file I/O
+ *
+ *
+ */
+#ifndef TIZAIO_H
+#define TIZAIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizaio Asynchronous file I/O
+ *
+ * Positioned reads and writes carried out by a small set of I/O threads, so
+ * that a component thread never blocks on a slow disk or network file
+ * system. Up to a fixed number of requests may be in flight at any time.
+ *
+ * Completions are signalled through a file descriptor that becomes readable
+ * when the oldest request in flight has finished; this descriptor is meant
+ * to be watched with a tiz_event_io watcher. Completed requests are
+ * retrieved with tiz_aio_reap, always in submission order.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * Asynchronous I/O context opaque structure.
+ * @ingroup tizaio
+ */
+typedef struct tiz_aio tiz_aio_t;
+typedef /*@null@ */ tiz_aio_t * tiz_aio_ptr_t;
+
+/**
+ * Request types.
+ * @ingroup tizaio
+ */
+typedef enum tiz_aio_op {
+  ETIZAioOpRead = 0,
+  ETIZAioOpWrite
+} tiz_aio_op_t;
+
+/**
+ * An I/O request. Requests are owned by the submitter, and must remain
+ * valid until they have been reaped. Reads and writes are carried out in
+ * full, unless end of file or an error is found.
+ * @ingroup tizaio
+ */
+typedef struct tiz_aio_req tiz_aio_req_t;
+struct tiz_aio_req
+{
+  /* Filled in by the submitter */
+  tiz_aio_op_t op;
+  int fd;
+  OMX_U64 offset;
+  void * p_buf;
+  size_t len;
+  void * p_data; /**< Opaque to the I/O context */
+  /* Filled in on completion */
+  ssize_t result; /**< Bytes transferred, or -1 on error */
+  int error;      /**< errno value when result is -1 */
+  /* Private */
+  tiz_aio_req_t * p_next;
+  int done;
+};
+
+/**
+ * Create an asynchronous I/O context.
+ *
+ * @ingroup tizaio
+ *
+ * @param app_aio The new context (output).
+ *
+ * @param a_nthreads Number of I/O threads. If zero or less, one thread is
+ * used.
+ *
+ * @param a_depth Maximum number of requests in flight.
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_aio_init (/*@out@*/ tiz_aio_ptr_t * app_aio, OMX_S32 a_nthreads,
+              OMX_S32 a_depth);
+
+/**
+ * Wait for the requests that are being carried out, stop and join the I/O
+ * threads and destroy the context. Requests that have not started yet are
+ * discarded.
+ *
+ * @ingroup tizaio
+ */
+void
+tiz_aio_destroy (/*@null@ */ tiz_aio_t * ap_aio);
+
+/**
+ * Retrieve the completion file descriptor. It becomes readable when
+ * tiz_aio_reap has a request to return.
+ *
+ * @ingroup tizaio
+ */
+int
+tiz_aio_get_fd (const tiz_aio_t * ap_aio);
+
+/**
+ * Submit a request.
+ *
+ * @ingroup tizaio
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorNoMore if the maximum number of
+ * requests are already in flight.
+ */
+OMX_ERRORTYPE
+tiz_aio_submit (tiz_aio_t * ap_aio, tiz_aio_req_t * ap_req);
+
+/**
+ * Retrieve the oldest request in flight, if it has completed.
+ *
+ * @ingroup tizaio
+ *
+ * @return The request, or NULL if there are no completed requests.
+ */
+tiz_aio_req_t *
+tiz_aio_reap (tiz_aio_t * ap_aio);
+
+/**
+ * Block until all requests in flight have completed. They still need to be
+ * reaped.
+ *
+ * @ingroup tizaio
+ */
+void
+tiz_aio_drain (tiz_aio_t * ap_aio);
+
+/**
+ * Retrieve the number of requests in flight (submitted and not reaped yet).
+ *
+ * @ingroup tizaio
+ */
+OMX_S32
+tiz_aio_pending (const tiz_aio_t * ap_aio);
+
+/**
+ * Whether another request can be submitted.
+ *
+ * @ingroup tizaio
+ */
+OMX_BOOL
+tiz_aio_is_full (const tiz_aio_t * ap_aio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZAIO_H */
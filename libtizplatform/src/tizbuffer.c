@@ -31,9 +31,16 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #include "tizmem.h"
 #include "tizlog.h"
@@ -45,6 +52,17 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.platform.buffer"
 #endif
 
+/* From linux/memfd.h */
+#ifndef TIZ_BUFFER_MFD_CLOEXEC
+#define TIZ_BUFFER_MFD_CLOEXEC 0x0001U
+#endif
+
+/* In ring mode, 'p_store' points to a mapping of 2 * 'alloc_len' bytes
+   where the second half is a mirror of the first one: the data that wraps
+   around the end of the ring can always be read (and the free space always
+   be written) as a single contiguous span starting at 'p_store + offset',
+   with no compaction. 'offset' is then the read index, always less than
+   'alloc_len'. */
 struct tiz_buffer
 {
   unsigned char * p_store;
@@ -52,8 +70,18 @@ struct tiz_buffer
   int filled_len;
   int offset;
   int seek_mode;
+  bool ring;
 };
 
+static inline bool
+is_consistent (const tiz_buffer_t * ap_buf)
+{
+  return ap_buf->ring
+           ? (ap_buf->offset < ap_buf->alloc_len
+              && ap_buf->filled_len <= ap_buf->alloc_len)
+           : (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+}
+
 static long
 abs_of (const long v)
 {
@@ -89,7 +117,18 @@ dealloc_data_store (
 {
   if (ap_buf)
     {
-      tiz_mem_free (ap_buf->p_store);
+      if (ap_buf->ring)
+        {
+          if (ap_buf->p_store)
+            {
+              (void) munmap (ap_buf->p_store, 2 * (size_t) ap_buf->alloc_len);
+            }
+          ap_buf->ring = false;
+        }
+      else
+        {
+          tiz_mem_free (ap_buf->p_store);
+        }
       ap_buf->p_store = NULL;
       ap_buf->alloc_len = 0;
       ap_buf->filled_len = 0;
@@ -98,6 +137,129 @@ dealloc_data_store (
     }
 }
 
+static int
+create_ring_fd (const size_t a_nbytes)
+{
+  int fd = -1;
+#ifdef SYS_memfd_create
+  fd = syscall (SYS_memfd_create, "tizbuffer", TIZ_BUFFER_MFD_CLOEXEC);
+#endif
+  if (fd < 0)
+    {
+      /* Pre-3.17 kernels; an unlinked temporary file will do */
+      char tmpl[] = P_tmpdir "/tizbuffer-XXXXXX";
+      if ((fd = mkstemp (tmpl)) >= 0)
+        {
+          (void) unlink (tmpl);
+          (void) fcntl (fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+  if (fd >= 0 && 0 != ftruncate (fd, a_nbytes))
+    {
+      (void) close (fd);
+      fd = -1;
+    }
+  return fd;
+}
+
+static inline void *
+alloc_ring_store (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  const long pg_sz = sysconf (_SC_PAGESIZE);
+  const size_t page = pg_sz > 0 ? (size_t) pg_sz : 4096;
+  const size_t len = ((a_nbytes + page - 1) / page) * page;
+  unsigned char * p_addr = MAP_FAILED;
+  int fd = -1;
+
+  assert (ap_buf);
+  assert (NULL == ap_buf->p_store);
+
+  if (0 == a_nbytes || len > INT_MAX || (fd = create_ring_fd (len)) < 0)
+    {
+      return NULL;
+    }
+
+  /* Reserve the address range first, then map the same pages at both
+     halves */
+  p_addr = mmap (NULL, 2 * len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED != p_addr)
+    {
+      if (MAP_FAILED == mmap (p_addr, len, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_FIXED, fd, 0)
+          || MAP_FAILED == mmap (p_addr + len, len, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_FIXED, fd, 0))
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR, "mmap (%zu bytes) failed : %s", len,
+                   strerror (errno));
+          (void) munmap (p_addr, 2 * len);
+          p_addr = MAP_FAILED;
+        }
+    }
+  (void) close (fd);
+
+  if (MAP_FAILED != p_addr)
+    {
+      ap_buf->p_store = p_addr;
+      ap_buf->alloc_len = len;
+      ap_buf->filled_len = 0;
+      ap_buf->offset = 0;
+      ap_buf->seek_mode = TIZ_BUFFER_NON_SEEKABLE;
+      ap_buf->ring = true;
+    }
+  return ap_buf->p_store;
+}
+
+/* Make room for (up to) a_nbytes at the back of the buffer and return the
+   number of bytes that can be written contiguously there */
+static size_t
+reserve (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  size_t avail = 0;
+
+  assert (ap_buf);
+  assert (is_consistent (ap_buf));
+
+  if (ap_buf->ring)
+    {
+      /* Fixed size; no compaction needed */
+      return ap_buf->alloc_len - ap_buf->filled_len;
+    }
+
+  if (ap_buf->seek_mode == TIZ_BUFFER_NON_SEEKABLE && ap_buf->offset > 0)
+    {
+      memmove (ap_buf->p_store, (ap_buf->p_store + ap_buf->offset),
+               ap_buf->filled_len);
+      ap_buf->offset = 0;
+    }
+
+  avail = ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
+
+  if (a_nbytes > avail)
+    {
+      /* need to re-alloc */
+      OMX_U8 * p_new_store = NULL;
+      size_t need = ap_buf->alloc_len * 2;
+      while (need - (ap_buf->offset + ap_buf->filled_len) < a_nbytes)
+        {
+          need *= 2;
+        }
+      p_new_store = tiz_mem_realloc (ap_buf->p_store, need);
+      if (p_new_store)
+        {
+          ap_buf->p_store = p_new_store;
+          ap_buf->alloc_len = need;
+          avail = ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
+        }
+    }
+  return avail;
+}
+
+static inline unsigned char *
+back_of (const tiz_buffer_t * ap_buf)
+{
+  return ap_buf->p_store + ap_buf->offset + ap_buf->filled_len;
+}
+
 OMX_ERRORTYPE
 tiz_buffer_init (/*@null@ */ tiz_buffer_ptr_t * app_buf, const size_t a_nbytes)
 {
@@ -135,6 +297,26 @@ end:
   return rc;
 }
 
+OMX_ERRORTYPE
+tiz_buffer_ring_init (/*@null@ */ tiz_buffer_ptr_t * app_buf,
+                      const size_t a_nbytes)
+{
+  tiz_buffer_t * p_buf = NULL;
+
+  assert (app_buf);
+
+  if ((p_buf = tiz_mem_calloc (1, sizeof (tiz_buffer_t)))
+      && !alloc_ring_store (p_buf, a_nbytes))
+    {
+      tiz_mem_free (p_buf);
+      p_buf = NULL;
+    }
+
+  *app_buf = p_buf;
+
+  return p_buf ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+}
+
 void
 tiz_buffer_destroy (tiz_buffer_t * ap_buf)
 {
@@ -149,10 +331,15 @@ int
 tiz_buffer_seek_mode (tiz_buffer_t * ap_buf, const int a_seek_mode)
 {
   int old_val = -1;
+  assert (ap_buf);
+  if (ap_buf->ring && a_seek_mode == TIZ_BUFFER_SEEKABLE)
+    {
+      /* Ring buffers discard data as soon as it is consumed */
+      return -1;
+    }
   if (a_seek_mode == TIZ_BUFFER_SEEKABLE
       || a_seek_mode == TIZ_BUFFER_NON_SEEKABLE)
     {
-      assert (ap_buf);
       old_val = ap_buf->seek_mode;
       ap_buf->seek_mode = a_seek_mode;
     }
@@ -166,47 +353,49 @@ tiz_buffer_push (tiz_buffer_t * ap_buf, const void * ap_data,
   OMX_U32 nbytes_to_copy = 0;
 
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
 
   if (ap_data && a_nbytes > 0)
     {
-      size_t avail = 0;
-
-      if (ap_buf->seek_mode == TIZ_BUFFER_NON_SEEKABLE
-          && ap_buf->offset > 0)
-        {
-          memmove (ap_buf->p_store, (ap_buf->p_store + ap_buf->offset),
-                   ap_buf->filled_len);
-          ap_buf->offset = 0;
-        }
-
-      avail = ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
-
-      if (a_nbytes > avail)
-        {
-          /* need to re-alloc */
-          OMX_U8 * p_new_store = NULL;
-          size_t need = ap_buf->alloc_len * 2;
-          p_new_store = tiz_mem_realloc (ap_buf->p_store, need);
-          if (p_new_store)
-            {
-              ap_buf->p_store = p_new_store;
-              ap_buf->alloc_len = need;
-              avail = ap_buf->alloc_len - (ap_buf->offset + ap_buf->filled_len);
-            }
-        }
-      nbytes_to_copy = MIN (avail, a_nbytes);
-      memcpy (ap_buf->p_store + ap_buf->offset + ap_buf->filled_len, ap_data, nbytes_to_copy);
+      nbytes_to_copy = MIN (reserve (ap_buf, a_nbytes), a_nbytes);
+      memcpy (back_of (ap_buf), ap_data, nbytes_to_copy);
       ap_buf->filled_len += nbytes_to_copy;
     }
   return nbytes_to_copy;
 }
 
+void *
+tiz_buffer_write_span (tiz_buffer_t * ap_buf, const size_t a_nbytes,
+                       size_t * ap_avail)
+{
+  size_t avail = 0;
+  assert (ap_buf);
+  assert (ap_avail);
+  avail = reserve (ap_buf, a_nbytes);
+  *ap_avail = avail;
+  return avail > 0 ? back_of (ap_buf) : NULL;
+}
+
+int
+tiz_buffer_commit (tiz_buffer_t * ap_buf, const size_t a_nbytes)
+{
+  size_t nbytes = 0;
+  assert (ap_buf);
+  assert (is_consistent (ap_buf));
+  nbytes = MIN (a_nbytes,
+                (size_t) (ap_buf->ring
+                            ? ap_buf->alloc_len - ap_buf->filled_len
+                            : ap_buf->alloc_len
+                                - (ap_buf->offset + ap_buf->filled_len)));
+  ap_buf->filled_len += nbytes;
+  return nbytes;
+}
+
 int
 tiz_buffer_available (const tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
   return ap_buf->filled_len;
 }
 
@@ -214,7 +403,7 @@ int
 tiz_buffer_offset (const tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
   return ap_buf->offset;
 }
 
@@ -222,7 +411,7 @@ void *
 tiz_buffer_get (const tiz_buffer_t * ap_buf)
 {
   assert (ap_buf);
-  assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
+  assert (is_consistent (ap_buf));
   return (ap_buf->p_store + ap_buf->offset);
 }
 
@@ -236,6 +425,10 @@ tiz_buffer_advance (tiz_buffer_t * ap_buf, const int nbytes)
       min_nbytes = MIN (nbytes, tiz_buffer_available (ap_buf));
       ap_buf->offset += min_nbytes;
       ap_buf->filled_len -= min_nbytes;
+      if (ap_buf->ring && ap_buf->offset >= ap_buf->alloc_len)
+        {
+          ap_buf->offset -= ap_buf->alloc_len;
+        }
     }
   return min_nbytes;
 }
@@ -245,6 +438,13 @@ tiz_buffer_seek (tiz_buffer_t * ap_buf, const long offset, const int whence)
 {
   int rc = -1;
   assert (ap_buf);
+
+  if (ap_buf->ring)
+    {
+      /* Not supported; data behind the position marker is gone */
+      return -1;
+    }
+
   assert (ap_buf->alloc_len >= (ap_buf->offset + ap_buf->filled_len));
 
   int total = ap_buf->offset + ap_buf->filled_len;
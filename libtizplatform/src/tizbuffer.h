@@ -77,6 +77,26 @@ typedef /*@null@ */ tiz_buffer_t * tiz_buffer_ptr_t;
 OMX_ERRORTYPE
 tiz_buffer_init (/*@null@ */ tiz_buffer_ptr_t * app_buf, const size_t a_nbytes);
 
+/**
+ * Create a new fixed-size ring buffer object.
+ *
+ * The data store is mapped twice in consecutive virtual memory, so the
+ * data available is always contiguous in memory (see tiz_buffer_get), even
+ * when it wraps around the end of the ring, and pushes never need to
+ * compact or re-allocate the store. Ring buffers do not grow: pushes
+ * beyond the capacity are truncated. They are always non-seekable.
+ *
+ * @ingroup tizbuffer
+ * @param app_buf A buffer handle to be initialised.
+ * @param a_nbytes Minimum capacity of the ring; rounded up to a multiple of
+ * the page size.
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources
+ * otherwise (e.g. if the platform does not allow the double mapping).
+ */
+OMX_ERRORTYPE
+tiz_buffer_ring_init (/*@null@ */ tiz_buffer_ptr_t * app_buf,
+                      const size_t a_nbytes);
+
 /**
  * Destroy a dynamic buffer object.
  *
@@ -93,7 +113,8 @@ tiz_buffer_destroy (tiz_buffer_t * ap_buf);
  * @param ap_buf The dynamic buffer handle.
  * @param a_seek_mode TIZ_BUFFER_NON_SEEKABLE (default) or
  * TIZ_BUFFER_SEEKABLE.
- * @return The old seek mode, or -1 on error.
+ * @return The old seek mode, or -1 on error (this includes requesting
+ * TIZ_BUFFER_SEEKABLE on a ring buffer).
  */
 int
 tiz_buffer_seek_mode (tiz_buffer_t * ap_buf, const int a_seek_mode);
@@ -111,6 +132,39 @@ int
 tiz_buffer_push (tiz_buffer_t * ap_buf, const void * ap_data,
                  const size_t a_nbytes);
 
+/**
+ * @brief Retrieve the contiguous free space at the back of the buffer.
+ *
+ * This allows data to be produced in place (e.g. with read or recv),
+ * instead of going through an intermediate buffer and tiz_buffer_push. The
+ * bytes written must then be made available with tiz_buffer_commit. Any
+ * other operation on the buffer invalidates the span.
+ *
+ * @ingroup tizbuffer
+ * @param ap_buf The dynamic buffer handle.
+ * @param a_nbytes The number of bytes the caller would like to write. A
+ * dynamic buffer grows if needed; a ring buffer never does.
+ * @param ap_avail On return, the number of bytes that can be written at the
+ * returned position (may be less than a_nbytes).
+ * @return The position where data can be written, or NULL if the buffer is
+ * full.
+ */
+void *
+tiz_buffer_write_span (tiz_buffer_t * ap_buf, const size_t a_nbytes,
+                       size_t * ap_avail);
+
+/**
+ * @brief Make available the bytes written in the span returned by
+ * tiz_buffer_write_span.
+ *
+ * @ingroup tizbuffer
+ * @param ap_buf The dynamic buffer handle.
+ * @param a_nbytes The number of bytes written.
+ * @return The number of bytes actually committed.
+ */
+int
+tiz_buffer_commit (tiz_buffer_t * ap_buf, const size_t a_nbytes);
+
 /**
  * @brief Reset the position marker.
  *
@@ -146,8 +200,10 @@ tiz_buffer_offset (const tiz_buffer_t * ap_buf);
  * @brief Retrieve the current position in the buffer where data can be read
  * from.
  *
- * If the buffer is empty, i.e. tiz_buffer_available returns zero, the
- * pointer returned is the position of the start of the buffer.
+ * The tiz_buffer_available bytes starting at this position are always
+ * contiguous in memory. If the buffer is empty, i.e. tiz_buffer_available
+ * returns zero, the pointer returned is the position of the start of the
+ * buffer (or, for ring buffers, the current read position).
  *
  * @ingroup tizbuffer
  * @param ap_buf The dynamic buffer handle.
@@ -184,7 +240,8 @@ tiz_buffer_advance (tiz_buffer_t * ap_buf, const int nbytes);
  * TIZ_BUFFER_SEEK_END.
  * @return 0 on success, -1 on error (e.g. the whence argument was not
  * TIZ_BUFFER_SEEK_SET, TIZ_BUFFER_SEEK_END, or TIZ_BUFFER_SEEK_CUR.  Or the
- * resulting buffer offset would be negative).
+ * resulting buffer offset would be negative, or the buffer is a ring
+ * buffer).
  */
 int
 tiz_buffer_seek (tiz_buffer_t * ap_buf, const long a_offset,
@@ -0,0 +1,366 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file   tizbufpool.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Pre-allocated buffer pools
+ *
+ * The pool is a single anonymous mapping, divided in slots of 'stride'
+ * bytes. Free slots are kept in a stack of slot indexes, so that the most
+ * recently returned (and therefore the most likely to be cache-hot) buffer is
+ * handed out first.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.bufpool"
+#endif
+
+#define BUFPOOL_CACHE_LINE_SIZE 64
+#define BUFPOOL_DEFAULT_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+/* From linux/mempolicy.h; libnuma is not a dependency */
+#define BUFPOOL_MPOL_PREFERRED 1
+
+struct tiz_bufpool
+{
+  OMX_U8 * p_base;
+  size_t map_len;
+  size_t buf_size;
+  size_t stride;
+  OMX_U32 nbufs;
+  OMX_U32 navail;
+  OMX_U32 * p_free; /* stack of free slot indexes */
+  bool * p_dirty;   /* whether a slot has been handed out before */
+  bool huge;
+};
+
+static inline size_t
+round_up (const size_t a_size, const size_t a_align)
+{
+  return (a_size + a_align - 1) & ~(a_align - 1);
+}
+
+static size_t
+page_size (void)
+{
+  const long sz = sysconf (_SC_PAGESIZE);
+  return sz > 0 ? (size_t) sz : 4096;
+}
+
+static size_t
+huge_page_size (void)
+{
+  size_t sz = BUFPOOL_DEFAULT_HUGE_PAGE_SIZE;
+  FILE * p_file = fopen ("/proc/meminfo", "r");
+  if (p_file)
+    {
+      char line[128];
+      unsigned long kb = 0;
+      while (fgets (line, sizeof (line), p_file))
+        {
+          if (1 == sscanf (line, "Hugepagesize: %lu kB", &kb) && kb > 0)
+            {
+              sz = (size_t) kb * 1024;
+              break;
+            }
+        }
+      fclose (p_file);
+    }
+  return sz;
+}
+
+static void
+bind_to_local_node (void * ap_addr, const size_t a_len)
+{
+#if defined(SYS_getcpu) && defined(SYS_mbind)
+  unsigned int cpu = 0;
+  unsigned int node = 0;
+  unsigned long mask = 0;
+
+  if (0 != syscall (SYS_getcpu, &cpu, &node, NULL)
+      || node >= sizeof (mask) * CHAR_BIT - 1)
+    {
+      return;
+    }
+
+  mask = 1UL << node;
+  if (0 != syscall (SYS_mbind, ap_addr, a_len, BUFPOOL_MPOL_PREFERRED, &mask,
+                    sizeof (mask) * CHAR_BIT, 0))
+    {
+      TIZ_LOG (TIZ_PRIORITY_DEBUG, "mbind (node %u) failed : %s", node,
+               strerror (errno));
+    }
+#endif
+}
+
+static void
+prefault (OMX_U8 * ap_addr, const size_t a_len, const size_t a_page_size)
+{
+  volatile OMX_U8 * p = ap_addr;
+  size_t i = 0;
+  for (i = 0; i < a_len; i += a_page_size)
+    {
+      p[i] = 0;
+    }
+}
+
+static OMX_ERRORTYPE
+map_pool (tiz_bufpool_t * ap_pool, const size_t a_len, const OMX_U32 a_flags)
+{
+  const size_t pg_sz = page_size ();
+  const size_t huge_sz
+    = (a_flags & ETIZBufPoolFlagHugePages) ? huge_page_size () : 0;
+  const bool want_huge = (huge_sz > 0 && a_len >= huge_sz);
+  const bool numa = (a_flags & ETIZBufPoolFlagNumaLocal);
+  bool populated = false;
+  void * p_addr = MAP_FAILED;
+  size_t len = 0;
+
+  assert (ap_pool);
+
+#ifdef MAP_HUGETLB
+  if (want_huge)
+    {
+      /* Explicit huge pages; these are only available when reserved by the
+         administrator */
+      const bool populate = (a_flags & ETIZBufPoolFlagPrefault) && !numa;
+      len = round_up (a_len, huge_sz);
+      p_addr = mmap (NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB
+                       | (populate ? MAP_POPULATE : 0),
+                     -1, 0);
+      if (MAP_FAILED != p_addr)
+        {
+          ap_pool->huge = true;
+          populated = populate;
+        }
+    }
+#endif
+
+  if (MAP_FAILED == p_addr)
+    {
+      /* The memory policy and the transparent huge page hint must be in
+         place before the pages are faulted in, so MAP_POPULATE is only
+         usable when neither is needed */
+      const bool populate
+        = (a_flags & ETIZBufPoolFlagPrefault) && !numa && !want_huge;
+      len = round_up (a_len, pg_sz);
+      p_addr = mmap (NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS
+                       | (populate ? MAP_POPULATE : 0),
+                     -1, 0);
+      if (MAP_FAILED == p_addr)
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR, "mmap (%zu bytes) failed : %s", len,
+                   strerror (errno));
+          return OMX_ErrorInsufficientResources;
+        }
+      populated = populate;
+#ifdef MADV_HUGEPAGE
+      if (want_huge && 0 == madvise (p_addr, len, MADV_HUGEPAGE))
+        {
+          ap_pool->huge = true;
+        }
+#endif
+    }
+
+  if (numa)
+    {
+      bind_to_local_node (p_addr, len);
+    }
+
+  if ((a_flags & ETIZBufPoolFlagPrefault) && !populated)
+    {
+      prefault (p_addr, len, pg_sz);
+    }
+
+  ap_pool->p_base = p_addr;
+  ap_pool->map_len = len;
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_bufpool_init (tiz_bufpool_ptr_t * app_pool, OMX_U32 a_nbufs,
+                  size_t a_buf_size, size_t a_alignment, OMX_U32 a_flags)
+{
+  tiz_bufpool_t * p_pool = NULL;
+  size_t align = BUFPOOL_CACHE_LINE_SIZE;
+  OMX_U32 i = 0;
+
+  assert (app_pool);
+
+  if (0 == a_nbufs || 0 == a_buf_size
+      || (a_alignment & (a_alignment - 1)) != 0
+      || a_alignment > page_size ())
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (a_alignment > align)
+    {
+      align = a_alignment;
+    }
+
+  p_pool = tiz_mem_calloc (1, sizeof (tiz_bufpool_t));
+  tiz_check_null_ret_oom (p_pool);
+
+  p_pool->buf_size = a_buf_size;
+  p_pool->stride = round_up (a_buf_size, align);
+  p_pool->nbufs = a_nbufs;
+  p_pool->navail = a_nbufs;
+  p_pool->p_free = tiz_mem_calloc (a_nbufs, sizeof (OMX_U32));
+  p_pool->p_dirty = tiz_mem_calloc (a_nbufs, sizeof (bool));
+
+  if (!p_pool->p_free || !p_pool->p_dirty
+      || p_pool->stride > ((size_t) -1) / a_nbufs
+      || OMX_ErrorNone
+           != map_pool (p_pool, p_pool->stride * a_nbufs, a_flags))
+    {
+      tiz_mem_free (p_pool->p_free);
+      tiz_mem_free (p_pool->p_dirty);
+      tiz_mem_free (p_pool);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  /* Hand out the lowest addresses first */
+  for (i = 0; i < a_nbufs; ++i)
+    {
+      p_pool->p_free[i] = a_nbufs - 1 - i;
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE,
+           "nbufs [%u] buf_size [%zu] stride [%zu] map_len [%zu] huge [%s]",
+           a_nbufs, a_buf_size, p_pool->stride, p_pool->map_len,
+           p_pool->huge ? "YES" : "NO");
+
+  *app_pool = p_pool;
+  return OMX_ErrorNone;
+}
+
+void
+tiz_bufpool_destroy (tiz_bufpool_t * ap_pool)
+{
+  if (ap_pool)
+    {
+      if (ap_pool->p_base)
+        {
+          (void) munmap (ap_pool->p_base, ap_pool->map_len);
+        }
+      tiz_mem_free (ap_pool->p_free);
+      tiz_mem_free (ap_pool->p_dirty);
+      tiz_mem_free (ap_pool);
+    }
+}
+
+OMX_U8 *
+tiz_bufpool_get (tiz_bufpool_t * ap_pool)
+{
+  OMX_U32 slot = 0;
+  OMX_U8 * p_buf = NULL;
+
+  assert (ap_pool);
+
+  if (0 == ap_pool->navail)
+    {
+      return NULL;
+    }
+
+  slot = ap_pool->p_free[--ap_pool->navail];
+  p_buf = ap_pool->p_base + (size_t) slot * ap_pool->stride;
+
+  /* Fresh pages are already zero-filled */
+  if (ap_pool->p_dirty[slot])
+    {
+      (void) tiz_mem_set (p_buf, 0, ap_pool->buf_size);
+    }
+  ap_pool->p_dirty[slot] = true;
+
+  return p_buf;
+}
+
+void
+tiz_bufpool_put (tiz_bufpool_t * ap_pool, OMX_U8 * ap_buf)
+{
+  size_t slot = 0;
+
+  assert (ap_pool);
+  assert (tiz_bufpool_owns (ap_pool, ap_buf));
+  assert (ap_pool->navail < ap_pool->nbufs);
+
+  slot = (size_t) (ap_buf - ap_pool->p_base) / ap_pool->stride;
+  assert (ap_buf == ap_pool->p_base + slot * ap_pool->stride);
+  ap_pool->p_free[ap_pool->navail++] = (OMX_U32) slot;
+}
+
+OMX_BOOL
+tiz_bufpool_owns (const tiz_bufpool_t * ap_pool, const void * ap_buf)
+{
+  const OMX_U8 * p = ap_buf;
+  assert (ap_pool);
+  return (p >= ap_pool->p_base
+          && p < ap_pool->p_base + ap_pool->stride * ap_pool->nbufs)
+           ? OMX_TRUE
+           : OMX_FALSE;
+}
+
+size_t
+tiz_bufpool_buf_size (const tiz_bufpool_t * ap_pool)
+{
+  assert (ap_pool);
+  return ap_pool->buf_size;
+}
+
+OMX_U32
+tiz_bufpool_count (const tiz_bufpool_t * ap_pool)
+{
+  assert (ap_pool);
+  return ap_pool->nbufs;
+}
+
+OMX_U32
+tiz_bufpool_available (const tiz_bufpool_t * ap_pool)
+{
+  assert (ap_pool);
+  return ap_pool->navail;
+}
+
+OMX_BOOL
+tiz_bufpool_is_huge (const tiz_bufpool_t * ap_pool)
+{
+  assert (ap_pool);
+  return ap_pool->huge ? OMX_TRUE : OMX_FALSE;
+}
@@ -0,0 +1,172 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file   tizbufpool.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Pre-allocated buffer pools
+ *
+ *
+ */
+#ifndef TIZBUFPOOL_H
+#define TIZBUFPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizbufpool Pre-allocated buffer pools
+ *
+ * A fixed number of equally-sized buffers carved out of a single anonymous
+ * memory mapping. Buffers are aligned to (at least) a cache line, and the
+ * mapping may optionally be backed by huge pages, pre-faulted at creation
+ * time and bound to the NUMA node of the creating thread.
+ *
+ * Buffers are zero-filled when handed out, as with calloc. Pools are not
+ * thread-safe.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <stddef.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * Buffer pool opaque structure.
+ * @ingroup tizbufpool
+ */
+typedef struct tiz_bufpool tiz_bufpool_t;
+typedef /*@null@ */ tiz_bufpool_t * tiz_bufpool_ptr_t;
+
+/**
+ * Pool creation flags.
+ * @ingroup tizbufpool
+ */
+typedef enum tiz_bufpool_flags {
+  ETIZBufPoolFlagNone = 0,
+  ETIZBufPoolFlagPrefault = 1 << 0,  /**< Fault in all pages at creation */
+  ETIZBufPoolFlagHugePages = 1 << 1, /**< Back the pool with huge pages */
+  ETIZBufPoolFlagNumaLocal = 1 << 2  /**< Bind to the caller's NUMA node */
+} tiz_bufpool_flags_t;
+
+/**
+ * Create a buffer pool.
+ *
+ * Huge pages are only used when the pool is at least one huge page in
+ * size. Explicit huge pages (hugetlbfs) are tried first, and transparent
+ * huge pages are requested when none are available. In both cases, failing
+ * to obtain huge pages is not an error.
+ *
+ * @ingroup tizbufpool
+ *
+ * @param app_pool The new pool (output).
+ *
+ * @param a_nbufs The number of buffers in the pool.
+ *
+ * @param a_buf_size The size of each buffer.
+ *
+ * @param a_alignment The alignment of each buffer. Must be zero or a power of
+ * two. Buffers are always aligned to a cache line, at least.
+ *
+ * @param a_flags A bitwise OR of tiz_bufpool_flags_t values.
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorBadParameter or
+ * OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_bufpool_init (/*@out@*/ tiz_bufpool_ptr_t * app_pool, OMX_U32 a_nbufs,
+                  size_t a_buf_size, size_t a_alignment, OMX_U32 a_flags);
+
+/**
+ * Destroy the pool and release its memory. Any buffers still in use become
+ * invalid.
+ *
+ * @ingroup tizbufpool
+ */
+void
+tiz_bufpool_destroy (/*@null@ */ tiz_bufpool_t * ap_pool);
+
+/**
+ * Retrieve a buffer from the pool.
+ *
+ * @ingroup tizbufpool
+ *
+ * @return A zero-filled buffer, or NULL if all buffers are in use.
+ */
+/*@null@*/ OMX_U8 *
+tiz_bufpool_get (tiz_bufpool_t * ap_pool);
+
+/**
+ * Return a buffer to the pool.
+ *
+ * @ingroup tizbufpool
+ *
+ * @param ap_buf A buffer previously obtained with tiz_bufpool_get.
+ */
+void
+tiz_bufpool_put (tiz_bufpool_t * ap_pool, OMX_U8 * ap_buf);
+
+/**
+ * Whether a pointer belongs to one of the pool's buffers.
+ *
+ * @ingroup tizbufpool
+ */
+OMX_BOOL
+tiz_bufpool_owns (const tiz_bufpool_t * ap_pool, const void * ap_buf);
+
+/**
+ * Retrieve the size of the pool's buffers.
+ *
+ * @ingroup tizbufpool
+ */
+size_t
+tiz_bufpool_buf_size (const tiz_bufpool_t * ap_pool);
+
+/**
+ * Retrieve the total number of buffers in the pool.
+ *
+ * @ingroup tizbufpool
+ */
+OMX_U32
+tiz_bufpool_count (const tiz_bufpool_t * ap_pool);
+
+/**
+ * Retrieve the number of buffers not in use.
+ *
+ * @ingroup tizbufpool
+ */
+OMX_U32
+tiz_bufpool_available (const tiz_bufpool_t * ap_pool);
+
+/**
+ * Whether the pool ended up backed by huge pages (explicit or transparent).
+ *
+ * @ingroup tizbufpool
+ */
+OMX_BOOL
+tiz_bufpool_is_huge (const tiz_bufpool_t * ap_pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZBUFPOOL_H */
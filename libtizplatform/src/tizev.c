@@ -35,6 +35,7 @@
 #include <string.h>
 #include <assert.h>
 #include <pthread.h>
+#include <unistd.h>
 
 #include "tizplatform.h"
 #include "tizplatform_internal.h"
@@ -63,6 +64,9 @@
 #endif
 
 #define TIZ_EVENT_LOOP_THREAD_NAME "evloop"
+#define TIZ_EVENT_LOOP_MAX_SHARDS 16
+
+typedef struct tiz_event_loop tiz_event_loop_t;
 
 struct tiz_event_io
 {
@@ -74,6 +78,7 @@ struct tiz_event_io
   uint32_t id;
   int fd;
   bool started;
+  tiz_event_loop_t * p_lp;
 };
 
 struct tiz_event_timer
@@ -85,6 +90,7 @@ struct tiz_event_timer
   bool once;
   uint32_t id;
   bool started;
+  tiz_event_loop_t * p_lp;
 };
 
 struct tiz_event_stat
@@ -95,6 +101,7 @@ struct tiz_event_stat
   void * p_arg1;
   uint32_t id;
   bool started;
+  tiz_event_loop_t * p_lp;
 };
 
 typedef enum tiz_event_loop_state tiz_event_loop_state_t;
@@ -107,7 +114,8 @@ enum tiz_event_loop_state
   ETIZEventLoopStateStopped
 };
 
-typedef struct tiz_event_loop tiz_event_loop_t;
+/* One event loop shard: an ev_loop, the thread that runs it and the queue of
+   watcher start/stop requests addressed to it. */
 struct tiz_event_loop
 {
   tiz_thread_t thread;
@@ -118,11 +126,20 @@ struct tiz_event_loop
   ev_async * p_async_watcher;
   struct ev_loop * p_loop;
   tiz_event_loop_state_t state;
+  bool signalled;
+  uint32_t index;
+};
+
+typedef struct tiz_event_loops tiz_event_loops_t;
+struct tiz_event_loops
+{
+  tiz_event_loop_t * p_shards;
+  uint32_t nshards;
   tiz_rcfile_t * p_rcfile;
 };
 
 static pthread_once_t g_event_loop_once = PTHREAD_ONCE_INIT;
-static tiz_event_loop_t * gp_event_loop = NULL;
+static tiz_event_loops_t * gp_event_loops = NULL;
 
 typedef enum tiz_event_loop_msg_class tiz_event_loop_msg_class_t;
 enum tiz_event_loop_msg_class
@@ -179,28 +196,28 @@ struct tiz_event_loop_msg
 
 /* Forward declarations */
 static OMX_ERRORTYPE
-do_io_start (tiz_event_loop_msg_t *);
+do_io_start (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_io_stop (tiz_event_loop_msg_t *);
+do_io_stop (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_io_destroy (tiz_event_loop_msg_t *);
+do_io_destroy (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_timer_start (tiz_event_loop_msg_t *);
+do_timer_start (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_timer_restart (tiz_event_loop_msg_t *);
+do_timer_restart (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_timer_stop (tiz_event_loop_msg_t *);
+do_timer_stop (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_timer_destroy (tiz_event_loop_msg_t *);
+do_timer_destroy (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_stat_start (tiz_event_loop_msg_t *);
+do_stat_start (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_stat_stop (tiz_event_loop_msg_t *);
+do_stat_stop (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 static OMX_ERRORTYPE
-do_stat_destroy (tiz_event_loop_msg_t *);
+do_stat_destroy (tiz_event_loop_t *, tiz_event_loop_msg_t *);
 
 typedef OMX_ERRORTYPE (*tiz_event_loop_msg_dispatch_f) (
-  tiz_event_loop_msg_t * ap_msg);
+  tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg);
 static const tiz_event_loop_msg_dispatch_f tiz_event_loop_msg_to_fnt_tbl[] = {
   do_io_start,
   do_io_stop,
@@ -218,7 +235,7 @@ static const tiz_event_loop_msg_dispatch_f tiz_event_loop_msg_to_fnt_tbl[] = {
 };
 
 static void
-dispatch_msg (tiz_event_loop_msg_t * ap_msg);
+dispatch_msg (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg);
 
 typedef struct tiz_event_loop_msg_str tiz_event_loop_msg_str_t;
 struct tiz_event_loop_msg_str
@@ -324,6 +341,17 @@ init_event_loop_msg (tiz_event_loop_t * ap_event_loop,
 /*@end@*/
 /* NOTE: Stop ignoring splint warnings in this section  */
 
+/* Called with the shard's mutex held. Only the first request queued since
+   the loop thread last drained the queue needs to wake the thread up; the
+   ones that follow are dispatched in the same batch. */
+static inline bool
+mark_pending (tiz_event_loop_t * ap_lp)
+{
+  const bool wake_up = !ap_lp->signalled;
+  ap_lp->signalled = true;
+  return wake_up;
+}
+
 static OMX_ERRORTYPE
 enqueue_io_msg (tiz_event_io_t * ap_ev_io, const uint32_t a_id,
                 const tiz_event_loop_msg_class_t a_class)
@@ -331,15 +359,20 @@ enqueue_io_msg (tiz_event_io_t * ap_ev_io, const uint32_t a_id,
   OMX_ERRORTYPE rc = OMX_ErrorUndefined;
   tiz_event_loop_msg_t * p_msg = NULL;
   tiz_event_loop_msg_io_t * p_msg_io = NULL;
+  tiz_event_loop_t * p_lp = NULL;
+  bool wake_up = false;
 
   assert (ap_ev_io);
   assert (ETIZEventLoopMsgIoStart == a_class
           || ETIZEventLoopMsgIoStop == a_class
           || ETIZEventLoopMsgIoDestroy == a_class);
 
-  tiz_check_omx (tiz_mutex_lock (&(gp_event_loop->mutex)));
+  p_lp = ap_ev_io->p_lp;
+  assert (p_lp);
+
+  tiz_check_omx (tiz_mutex_lock (&(p_lp->mutex)));
   tiz_goto_end_on_null (
-    (p_msg = init_event_loop_msg (gp_event_loop, (a_class))),
+    (p_msg = init_event_loop_msg (p_lp, (a_class))),
     "Failed to initialise the event loop");
 
   assert (p_msg);
@@ -347,10 +380,14 @@ enqueue_io_msg (tiz_event_io_t * ap_ev_io, const uint32_t a_id,
   p_msg_io->p_ev_io = ap_ev_io;
   p_msg_io->id = a_id;
   tiz_goto_end_on_omx_err (
-    (rc = tiz_pqueue_send (gp_event_loop->p_pq, p_msg, p_msg->priority)),
+    (rc = tiz_pqueue_send (p_lp->p_pq, p_msg, p_msg->priority)),
     "Failed to insert into the queue");
-  tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
-  ev_async_send (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
+  wake_up = mark_pending (p_lp);
+  tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
+  if (wake_up)
+    {
+      ev_async_send (p_lp->p_loop, p_lp->p_async_watcher);
+    }
 
   /* All good */
   rc = OMX_ErrorNone;
@@ -359,7 +396,7 @@ enqueue_io_msg (tiz_event_io_t * ap_ev_io, const uint32_t a_id,
 
   if (OMX_ErrorNone != rc)
     {
-      tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
+      tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
     }
 
   return OMX_ErrorNone;
@@ -372,6 +409,8 @@ enqueue_timer_msg (tiz_event_timer_t * ap_ev_timer, const uint32_t a_id,
   OMX_ERRORTYPE rc = OMX_ErrorUndefined;
   tiz_event_loop_msg_t * p_msg = NULL;
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
+  tiz_event_loop_t * p_lp = NULL;
+  bool wake_up = false;
 
   assert (ap_ev_timer);
   assert (ETIZEventLoopMsgTimerStart == a_class
@@ -379,9 +418,12 @@ enqueue_timer_msg (tiz_event_timer_t * ap_ev_timer, const uint32_t a_id,
           || ETIZEventLoopMsgTimerRestart == a_class
           || ETIZEventLoopMsgTimerDestroy == a_class);
 
-  tiz_check_omx (tiz_mutex_lock (&(gp_event_loop->mutex)));
+  p_lp = ap_ev_timer->p_lp;
+  assert (p_lp);
+
+  tiz_check_omx (tiz_mutex_lock (&(p_lp->mutex)));
   tiz_goto_end_on_null (
-    (p_msg = init_event_loop_msg (gp_event_loop, (a_class))),
+    (p_msg = init_event_loop_msg (p_lp, (a_class))),
     "Failed to initialise the event loop");
 
   assert (p_msg);
@@ -389,10 +431,14 @@ enqueue_timer_msg (tiz_event_timer_t * ap_ev_timer, const uint32_t a_id,
   p_msg_timer->p_ev_timer = ap_ev_timer;
   p_msg_timer->id = a_id;
   tiz_goto_end_on_omx_err (
-    (rc = tiz_pqueue_send (gp_event_loop->p_pq, p_msg, p_msg->priority)),
+    (rc = tiz_pqueue_send (p_lp->p_pq, p_msg, p_msg->priority)),
     "Failed to insert into the queue");
-  tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
-  ev_async_send (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
+  wake_up = mark_pending (p_lp);
+  tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
+  if (wake_up)
+    {
+      ev_async_send (p_lp->p_loop, p_lp->p_async_watcher);
+    }
 
   /* All good */
   rc = OMX_ErrorNone;
@@ -401,7 +447,7 @@ enqueue_timer_msg (tiz_event_timer_t * ap_ev_timer, const uint32_t a_id,
 
   if (OMX_ErrorNone != rc)
     {
-      tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
+      tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
     }
 
   return rc;
@@ -414,14 +460,19 @@ enqueue_stat_msg (tiz_event_stat_t * ap_ev_stat, const uint32_t a_id,
   OMX_ERRORTYPE rc = OMX_ErrorUndefined;
   tiz_event_loop_msg_t * p_msg = NULL;
   tiz_event_loop_msg_stat_t * p_msg_stat = NULL;
+  tiz_event_loop_t * p_lp = NULL;
+  bool wake_up = false;
 
   assert (ap_ev_stat);
   assert (ETIZEventLoopMsgStatStart == a_class
           || ETIZEventLoopMsgStatStop == a_class
           || ETIZEventLoopMsgStatDestroy == a_class);
 
-  tiz_check_omx (tiz_mutex_lock (&(gp_event_loop->mutex)));
-  tiz_goto_end_on_null ((p_msg = init_event_loop_msg (gp_event_loop, (a_class))),
+  p_lp = ap_ev_stat->p_lp;
+  assert (p_lp);
+
+  tiz_check_omx (tiz_mutex_lock (&(p_lp->mutex)));
+  tiz_goto_end_on_null ((p_msg = init_event_loop_msg (p_lp, (a_class))),
                         "Failed to initialise the event loop");
 
   assert (p_msg);
@@ -429,10 +480,14 @@ enqueue_stat_msg (tiz_event_stat_t * ap_ev_stat, const uint32_t a_id,
   p_msg_stat->p_ev_stat = ap_ev_stat;
   p_msg_stat->id = a_id;
   tiz_goto_end_on_omx_err (
-    (rc = tiz_pqueue_send (gp_event_loop->p_pq, p_msg, p_msg->priority)),
+    (rc = tiz_pqueue_send (p_lp->p_pq, p_msg, p_msg->priority)),
     "Failed to insert into the queue");
-  tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
-  ev_async_send (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
+  wake_up = mark_pending (p_lp);
+  tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
+  if (wake_up)
+    {
+      ev_async_send (p_lp->p_loop, p_lp->p_async_watcher);
+    }
 
   /* All good */
   rc = OMX_ErrorNone;
@@ -441,22 +496,23 @@ enqueue_stat_msg (tiz_event_stat_t * ap_ev_stat, const uint32_t a_id,
 
   if (OMX_ErrorNone != rc)
     {
-      tiz_check_omx (tiz_mutex_unlock (&(gp_event_loop->mutex)));
+      tiz_check_omx (tiz_mutex_unlock (&(p_lp->mutex)));
     }
 
   return OMX_ErrorNone;
 }
 
 static void
-dispatch_msg (tiz_event_loop_msg_t * ap_msg)
+dispatch_msg (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
+  assert (ap_lp);
   assert (ap_msg);
   assert (ap_msg->class < ETIZEventLoopMsgMax);
 
-  TIZ_LOG (TIZ_PRIORITY_TRACE, "msg [%p] class [%s]", ap_msg,
-           tiz_event_loop_msg_to_str (ap_msg->class));
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "shard [%u] msg [%p] class [%s]", ap_lp->index,
+           ap_msg, tiz_event_loop_msg_to_str (ap_msg->class));
 
-  (void) tiz_event_loop_msg_to_fnt_tbl[ap_msg->class](ap_msg);
+  (void) tiz_event_loop_msg_to_fnt_tbl[ap_msg->class](ap_lp, ap_msg);
 }
 
 static OMX_S32
@@ -499,7 +555,11 @@ ev_io_msg_dequeue (void * ap_elem, OMX_S32 a_data1, void * ap_data2)
       if (ap_data2 == p_ev_io)
         {
           tiz_event_io_t * p_ev_io_needle = ap_data2;
-          if (p_ev_io_needle->id == p_msg_io->id)
+          /* When the watcher is being destroyed, requests are removed
+             regardless of their id (e.g. a re-start requested from the
+             watcher's callback carries an id that is yet to be applied) */
+          if (ETIZEventLoopMsgIoAny == class_to_delete
+              || p_ev_io_needle->id == p_msg_io->id)
             {
               /* Found, return TRUE so that the msg will be removed from the
                  queue */
@@ -543,7 +603,11 @@ ev_timer_msg_dequeue (void * ap_elem, OMX_S32 a_data1, void * ap_data2)
       if (ap_data2 == p_ev_timer)
         {
           tiz_event_timer_t * p_ev_timer_needle = ap_data2;
-          if (p_ev_timer_needle->id == p_msg_timer->id)
+          /* When the watcher is being destroyed, requests are removed
+             regardless of their id (e.g. a re-start requested from the
+             watcher's callback carries an id that is yet to be applied) */
+          if (ETIZEventLoopMsgTimerAny == class_to_delete
+              || p_ev_timer_needle->id == p_msg_timer->id)
             {
               /* Found, return TRUE so that the msg will be removed from the
                  queue */
@@ -587,7 +651,11 @@ ev_stat_msg_dequeue (void * ap_elem, OMX_S32 a_data1, void * ap_data2)
       if (ap_data2 == p_ev_stat)
         {
           tiz_event_stat_t * p_ev_stat_needle = ap_data2;
-          if (p_ev_stat_needle->id == p_msg_stat->id)
+          /* When the watcher is being destroyed, requests are removed
+             regardless of their id (e.g. a re-start requested from the
+             watcher's callback carries an id that is yet to be applied) */
+          if (ETIZEventLoopMsgStatAny == class_to_delete
+              || p_ev_stat_needle->id == p_msg_stat->id)
             {
               /* Found, return TRUE so that the msg will be removed from the
                  queue */
@@ -599,14 +667,15 @@ ev_stat_msg_dequeue (void * ap_elem, OMX_S32 a_data1, void * ap_data2)
 }
 
 static OMX_ERRORTYPE
-do_io_start (tiz_event_loop_msg_t * ap_msg)
+do_io_start (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_io_t * p_msg_io = NULL;
   tiz_event_io_t * p_ev_io = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_io = &(ap_msg->io);
   assert (p_msg_io);
@@ -624,20 +693,21 @@ do_io_start (tiz_event_loop_msg_t * ap_msg)
       assert (!p_ev_io->started);
     }
   p_ev_io->started = true;
-  ev_io_start (gp_event_loop->p_loop, (ev_io *) (p_ev_io));
+  ev_io_start (ap_lp->p_loop, (ev_io *) (p_ev_io));
 
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_io_stop (tiz_event_loop_msg_t * ap_msg)
+do_io_stop (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_io_t * p_msg_io = NULL;
   tiz_event_io_t * p_ev_io = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_io = &(ap_msg->io);
   assert (p_msg_io);
@@ -646,7 +716,7 @@ do_io_stop (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_io->started)
     {
       /* The io watcher has been started, let's stop it */
-      ev_io_stop (gp_event_loop->p_loop, (ev_io *) (p_ev_io));
+      ev_io_stop (ap_lp->p_loop, (ev_io *) (p_ev_io));
       p_ev_io->started = false;
     }
   else
@@ -655,21 +725,22 @@ do_io_stop (tiz_event_loop_msg_t * ap_msg)
          start requests left behind in the queue */
       const tiz_event_loop_msg_class_t class_to_be_deleted
         = ETIZEventLoopMsgIoStart;
-      tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_io_msg_dequeue,
+      tiz_pqueue_remove_func (ap_lp->p_pq, ev_io_msg_dequeue,
                               (OMX_S32) class_to_be_deleted, p_ev_io);
     }
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_io_destroy (tiz_event_loop_msg_t * ap_msg)
+do_io_destroy (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_io_t * p_msg_io = NULL;
   tiz_event_io_t * p_ev_io = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_io = &(ap_msg->io);
   assert (p_msg_io);
@@ -678,14 +749,14 @@ do_io_destroy (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_io->started)
     {
       /* The io watcher has been started, let's stop it */
-      ev_io_stop (gp_event_loop->p_loop, (ev_io *) (p_ev_io));
+      ev_io_stop (ap_lp->p_loop, (ev_io *) (p_ev_io));
     }
 
   {
     /* Now remove any references to this watcher that might be present in the
        queue */
     tiz_event_loop_msg_class_t class_to_be_deleted = ETIZEventLoopMsgIoAny;
-    tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_io_msg_dequeue,
+    tiz_pqueue_remove_func (ap_lp->p_pq, ev_io_msg_dequeue,
                             (OMX_S32) class_to_be_deleted, p_ev_io);
   }
 
@@ -697,14 +768,15 @@ do_io_destroy (tiz_event_loop_msg_t * ap_msg)
 }
 
 static OMX_ERRORTYPE
-do_timer_start (tiz_event_loop_msg_t * ap_msg)
+do_timer_start (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
   tiz_event_timer_t * p_ev_timer = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_timer = &(ap_msg->timer);
   assert (p_msg_timer);
@@ -717,20 +789,21 @@ do_timer_start (tiz_event_loop_msg_t * ap_msg)
     }
   p_ev_timer->id = p_msg_timer->id;
   p_ev_timer->started = true;
-  ev_timer_start (gp_event_loop->p_loop, (ev_timer *) (p_ev_timer));
+  ev_timer_start (ap_lp->p_loop, (ev_timer *) (p_ev_timer));
 
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_timer_restart (tiz_event_loop_msg_t * ap_msg)
+do_timer_restart (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
   tiz_event_timer_t * p_ev_timer = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_timer = &(ap_msg->timer);
   assert (p_msg_timer);
@@ -743,20 +816,21 @@ do_timer_restart (tiz_event_loop_msg_t * ap_msg)
     }
   p_ev_timer->id = p_msg_timer->id;
   p_ev_timer->started = true;
-  ev_timer_again (gp_event_loop->p_loop, (ev_timer *) (p_ev_timer));
+  ev_timer_again (ap_lp->p_loop, (ev_timer *) (p_ev_timer));
 
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_timer_stop (tiz_event_loop_msg_t * ap_msg)
+do_timer_stop (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
   tiz_event_timer_t * p_ev_timer = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_timer = &(ap_msg->timer);
   assert (p_msg_timer);
@@ -765,7 +839,7 @@ do_timer_stop (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_timer->started)
     {
       /* The timer watcher has been started, let's stop it */
-      ev_timer_stop (gp_event_loop->p_loop, (ev_timer *) (p_ev_timer));
+      ev_timer_stop (ap_lp->p_loop, (ev_timer *) (p_ev_timer));
       p_ev_timer->started = false;
     }
   else
@@ -775,7 +849,7 @@ do_timer_stop (tiz_event_loop_msg_t * ap_msg)
          requests in the queue */
       const tiz_event_loop_msg_class_t class_to_be_deleted
         = ETIZEventLoopMsgTimerStart;
-      tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_timer_msg_dequeue,
+      tiz_pqueue_remove_func (ap_lp->p_pq, ev_timer_msg_dequeue,
                               (OMX_S32) class_to_be_deleted, p_ev_timer);
     }
 
@@ -783,14 +857,15 @@ do_timer_stop (tiz_event_loop_msg_t * ap_msg)
 }
 
 static OMX_ERRORTYPE
-do_timer_destroy (tiz_event_loop_msg_t * ap_msg)
+do_timer_destroy (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_timer_t * p_msg_timer = NULL;
   tiz_event_timer_t * p_ev_timer = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_timer = &(ap_msg->timer);
   assert (p_msg_timer);
@@ -799,13 +874,13 @@ do_timer_destroy (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_timer->started)
     {
       /* The timer watcher has been started, let's stop it */
-      ev_timer_stop (gp_event_loop->p_loop, (ev_timer *) (p_ev_timer));
+      ev_timer_stop (ap_lp->p_loop, (ev_timer *) (p_ev_timer));
     }
   {
     /* Now remove any references to this watcher that might be present in the
        queue */
     tiz_event_loop_msg_class_t class_to_be_deleted = ETIZEventLoopMsgTimerAny;
-    tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_timer_msg_dequeue,
+    tiz_pqueue_remove_func (ap_lp->p_pq, ev_timer_msg_dequeue,
                             (OMX_S32) class_to_be_deleted, p_ev_timer);
   }
 
@@ -817,14 +892,15 @@ do_timer_destroy (tiz_event_loop_msg_t * ap_msg)
 }
 
 static OMX_ERRORTYPE
-do_stat_start (tiz_event_loop_msg_t * ap_msg)
+do_stat_start (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_stat_t * p_msg_stat = NULL;
   tiz_event_stat_t * p_ev_stat = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_stat = &(ap_msg->stat);
   assert (p_msg_stat);
@@ -842,20 +918,21 @@ do_stat_start (tiz_event_loop_msg_t * ap_msg)
       assert (!p_ev_stat->started);
     }
   p_ev_stat->started = true;
-  ev_stat_start (gp_event_loop->p_loop, (ev_stat *) (p_ev_stat));
+  ev_stat_start (ap_lp->p_loop, (ev_stat *) (p_ev_stat));
 
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_stat_stop (tiz_event_loop_msg_t * ap_msg)
+do_stat_stop (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_stat_t * p_msg_stat = NULL;
   tiz_event_stat_t * p_ev_stat = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_stat = &(ap_msg->stat);
   assert (p_msg_stat);
@@ -864,7 +941,7 @@ do_stat_stop (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_stat->started)
     {
       /* The stat watcher has been started, let's stop it */
-      ev_stat_stop (gp_event_loop->p_loop, (ev_stat *) (p_ev_stat));
+      ev_stat_stop (ap_lp->p_loop, (ev_stat *) (p_ev_stat));
       p_ev_stat->started = false;
     }
   else
@@ -874,21 +951,22 @@ do_stat_stop (tiz_event_loop_msg_t * ap_msg)
          requests in the queue */
       const tiz_event_loop_msg_class_t class_to_be_deleted
         = ETIZEventLoopMsgStatStart;
-      tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_stat_msg_dequeue,
+      tiz_pqueue_remove_func (ap_lp->p_pq, ev_stat_msg_dequeue,
                               (OMX_S32) class_to_be_deleted, p_ev_stat);
     }
   return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
-do_stat_destroy (tiz_event_loop_msg_t * ap_msg)
+do_stat_destroy (tiz_event_loop_t * ap_lp, tiz_event_loop_msg_t * ap_msg)
 {
   tiz_event_loop_msg_stat_t * p_msg_stat = NULL;
   tiz_event_stat_t * p_ev_stat = NULL;
 
-  assert (gp_event_loop);
+  assert (ap_lp);
   assert (ap_msg);
-  assert (ETIZEventLoopStateStarted == gp_event_loop->state);
+  assert (ETIZEventLoopStateStarted == ap_lp->state
+          || ETIZEventLoopStateStopping == ap_lp->state);
 
   p_msg_stat = &(ap_msg->stat);
   assert (p_msg_stat);
@@ -897,14 +975,14 @@ do_stat_destroy (tiz_event_loop_msg_t * ap_msg)
   if (p_ev_stat->started)
     {
       /* The stat watcher has been started, let's stop it */
-      ev_stat_stop (gp_event_loop->p_loop, (ev_stat *) (p_ev_stat));
+      ev_stat_stop (ap_lp->p_loop, (ev_stat *) (p_ev_stat));
     }
 
   {
     /* Now remove any references to this watcher that might be present in the
        queue */
     tiz_event_loop_msg_class_t class_to_be_deleted = ETIZEventLoopMsgStatAny;
-    tiz_pqueue_remove_func (gp_event_loop->p_pq, ev_stat_msg_dequeue,
+    tiz_pqueue_remove_func (ap_lp->p_pq, ev_stat_msg_dequeue,
                             (OMX_S32) class_to_be_deleted, p_ev_stat);
   }
 
@@ -918,35 +996,40 @@ static void
 async_watcher_cback (struct ev_loop * ap_loop, ev_async * ap_watcher,
                      int a_revents)
 {
+  tiz_event_loop_t * p_lp = ap_watcher->data;
   (void) ap_loop;
-  (void) ap_watcher;
   (void) a_revents;
 
-  if (gp_event_loop)
+  if (gp_event_loops && p_lp)
     {
-      if (ETIZEventLoopStateStopping == gp_event_loop->state)
-        {
-          ev_break (gp_event_loop->p_loop, EVBREAK_ONE);
-        }
-      else if (ETIZEventLoopStateStarted == gp_event_loop->state)
+      /* When stopping, the pending requests are still dispatched so that the
+         watchers that were destroyed last get released */
+      if (ETIZEventLoopStateStarted == p_lp->state
+          || ETIZEventLoopStateStopping == p_lp->state)
         {
           void * p_msg = NULL;
 
           /* Process all items from the queue */
-          (void) tiz_mutex_lock (&(gp_event_loop->mutex));
-          while (0 < tiz_pqueue_length (gp_event_loop->p_pq))
+          (void) tiz_mutex_lock (&(p_lp->mutex));
+          while (0 < tiz_pqueue_length (p_lp->p_pq))
             {
-              if (OMX_ErrorNone
-                  != tiz_pqueue_receive (gp_event_loop->p_pq, &p_msg))
+              if (OMX_ErrorNone != tiz_pqueue_receive (p_lp->p_pq, &p_msg))
                 {
                   break;
                 }
               /* Process the message */
-              dispatch_msg (p_msg);
+              dispatch_msg (p_lp, p_msg);
               /* Delete the message */
-              tiz_soa_free (gp_event_loop->p_soa, p_msg);
+              tiz_soa_free (p_lp->p_soa, p_msg);
             }
-          (void) tiz_mutex_unlock (&(gp_event_loop->mutex));
+          /* Requests queued from now on need a new wake-up */
+          p_lp->signalled = false;
+          (void) tiz_mutex_unlock (&(p_lp->mutex));
+        }
+
+      if (ETIZEventLoopStateStopping == p_lp->state)
+        {
+          ev_break (p_lp->p_loop, EVBREAK_ONE);
         }
     }
 }
@@ -957,7 +1040,7 @@ io_watcher_cback (struct ev_loop * ap_loop, ev_io * ap_watcher, int a_revents)
   tiz_event_io_t * p_io_event = (tiz_event_io_t *) ap_watcher;
   (void) ap_loop;
 
-  if (gp_event_loop)
+  if (gp_event_loops)
     {
       assert (p_io_event);
       assert (p_io_event->pf_cback);
@@ -965,7 +1048,7 @@ io_watcher_cback (struct ev_loop * ap_loop, ev_io * ap_watcher, int a_revents)
       if (p_io_event->once)
         {
           p_io_event->started = false;
-          ev_io_stop (gp_event_loop->p_loop, (ev_io *) p_io_event);
+          ev_io_stop (p_io_event->p_lp->p_loop, (ev_io *) p_io_event);
         }
       p_io_event->pf_cback (p_io_event->p_arg0, p_io_event, p_io_event->p_arg1,
                             p_io_event->id, ((ev_io *) p_io_event)->fd,
@@ -980,7 +1063,7 @@ timer_watcher_cback (struct ev_loop * ap_loop, ev_timer * ap_watcher,
   (void) ap_loop;
   (void) a_revents;
 
-  if (gp_event_loop)
+  if (gp_event_loops)
     {
       tiz_event_timer_t * p_timer_event = (tiz_event_timer_t *) ap_watcher;
       assert (p_timer_event);
@@ -996,7 +1079,7 @@ stat_watcher_cback (struct ev_loop * ap_loop, ev_stat * ap_watcher,
 {
   (void) ap_loop;
 
-  if (gp_event_loop)
+  if (gp_event_loops)
     {
       tiz_event_stat_t * p_stat_event = (tiz_event_stat_t *) ap_watcher;
       assert (p_stat_event);
@@ -1012,14 +1095,23 @@ event_loop_thread_func (void * p_arg)
 {
   tiz_event_loop_t * p_event_loop = p_arg;
   struct ev_loop * p_loop = NULL;
+  char name[16];
 
   assert (p_event_loop);
 
   p_loop = p_event_loop->p_loop;
   assert (p_loop);
 
-  (void) tiz_thread_setname (&(p_event_loop->thread),
-                             (const OMX_STRING) TIZ_EVENT_LOOP_THREAD_NAME);
+  if (gp_event_loops->nshards > 1)
+    {
+      snprintf (name, sizeof (name), "%s%u", TIZ_EVENT_LOOP_THREAD_NAME,
+                p_event_loop->index);
+    }
+  else
+    {
+      snprintf (name, sizeof (name), "%s", TIZ_EVENT_LOOP_THREAD_NAME);
+    }
+  (void) tiz_thread_setname (&(p_event_loop->thread), (const OMX_STRING) name);
 
   TIZ_LOG (TIZ_PRIORITY_TRACE, "Entering the dispatcher...");
   tiz_sem_post (&(p_event_loop->sem));
@@ -1032,7 +1124,7 @@ event_loop_thread_func (void * p_arg)
 }
 
 static inline void
-clean_up_thread_data (tiz_event_loop_t * ap_lp)
+clean_up_shard (tiz_event_loop_t * ap_lp)
 {
   if (ap_lp)
     {
@@ -1071,9 +1163,36 @@ clean_up_thread_data (tiz_event_loop_t * ap_lp)
           tiz_soa_destroy (ap_lp->p_soa);
           ap_lp->p_soa = NULL;
         }
+    }
+}
+
+static void
+clean_up_thread_data (tiz_event_loops_t * ap_lps)
+{
+  if (ap_lps)
+    {
+      uint32_t i = 0;
+      if (ap_lps->p_shards)
+        {
+          for (i = 0; i < ap_lps->nshards; ++i)
+            {
+              clean_up_shard (&(ap_lps->p_shards[i]));
+            }
+          tiz_mem_free (ap_lps->p_shards);
+          ap_lps->p_shards = NULL;
+        }
 
-      tiz_mem_free (gp_event_loop);
-      gp_event_loop = NULL;
+      if (ap_lps->p_rcfile)
+        {
+          tiz_rcfile_destroy (ap_lps->p_rcfile);
+          ap_lps->p_rcfile = NULL;
+        }
+
+      tiz_mem_free (ap_lps);
+      if (gp_event_loops == ap_lps)
+        {
+          gp_event_loops = NULL;
+        }
     }
 }
 
@@ -1083,97 +1202,168 @@ child_event_loop_reset (void)
   /* Reset the once control */
   pthread_once_t once = PTHREAD_ONCE_INIT;
   memcpy (&g_event_loop_once, &once, sizeof (g_event_loop_once));
-  gp_event_loop = NULL;
+  gp_event_loops = NULL;
+}
+
+static uint32_t
+configured_shards (const tiz_rcfile_t * ap_rcfile)
+{
+  const char * p_value
+    = ap_rcfile ? tiz_rcfile_find_value (ap_rcfile, "event-loop-shards") : NULL;
+  long nshards = p_value ? strtol (p_value, NULL, 10) : 1;
+
+  if (nshards <= 0)
+    {
+      /* Zero means one shard per online processor */
+      nshards = sysconf (_SC_NPROCESSORS_ONLN);
+    }
+
+  return (uint32_t) (nshards < 1
+                       ? 1
+                       : (nshards > TIZ_EVENT_LOOP_MAX_SHARDS
+                            ? TIZ_EVENT_LOOP_MAX_SHARDS
+                            : nshards));
+}
+
+static OMX_ERRORTYPE
+init_shard (tiz_event_loop_t * ap_lp, const uint32_t a_index)
+{
+  assert (ap_lp);
+
+  ap_lp->index = a_index;
+  ap_lp->state = ETIZEventLoopStateStarting;
+  ap_lp->signalled = false;
+
+  ap_lp->p_loop = ev_loop_new (EVFLAG_AUTO);
+  tiz_check_null_ret_oom (ap_lp->p_loop != NULL);
+
+  ap_lp->p_async_watcher = (ev_async *) tiz_mem_calloc (1, sizeof (ev_async));
+  tiz_check_null_ret_oom (ap_lp->p_async_watcher != NULL);
+
+  tiz_check_omx (tiz_mutex_init (&(ap_lp->mutex)));
+
+  tiz_check_omx (tiz_sem_init (&(ap_lp->sem), 0));
+
+  /* Init the small object allocator */
+  tiz_check_omx (tiz_soa_init (&(ap_lp->p_soa)));
+
+  /* Init the priority queue */
+  tiz_check_omx (tiz_pqueue_init (&ap_lp->p_pq, 2, &pqueue_cmp, ap_lp->p_soa,
+                                  TIZ_EVENT_LOOP_THREAD_NAME));
+
+  ev_async_init (ap_lp->p_async_watcher, async_watcher_cback);
+  ap_lp->p_async_watcher->data = ap_lp;
+  ev_async_start (ap_lp->p_loop, ap_lp->p_async_watcher);
+
+  return OMX_ErrorNone;
+}
+
+static void
+start_shard (tiz_event_loop_t * ap_lp)
+{
+  assert (ap_lp);
+  ap_lp->state = ETIZEventLoopStateStarted;
+  /* Create event loop thread */
+  tiz_thread_create (&(ap_lp->thread), 0, 0, event_loop_thread_func, ap_lp);
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Shard [%u] now in ETIZEventLoopStateStarted",
+           ap_lp->index);
+
+  (void) tiz_mutex_lock (&(ap_lp->mutex));
+  /* This is to prevent the event loop from exiting when there are no
+   * more active events */
+  ev_ref (ap_lp->p_loop);
+  (void) tiz_mutex_unlock (&(ap_lp->mutex));
+  tiz_sem_wait (&(ap_lp->sem));
 }
 
 static void
 init_event_loop_thread (void)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
+  uint32_t i = 0;
 
-  if (!gp_event_loop)
+  if (!gp_event_loops)
     {
       /* Let's return OOM error if something goes wrong */
       rc = OMX_ErrorInsufficientResources;
 
       /* Register a handler to reset the pthread_once_t global variable to try
          to cope with the scenario of a process forking without exec. The idea
-         is to make sure that the loop thread is re-created in the child
+         is to make sure that the loop threads are re-created in the child
          process */
       pthread_atfork (NULL, NULL, child_event_loop_reset);
 
       tiz_goto_end_on_null (
-        (gp_event_loop
-         = (tiz_event_loop_t *) tiz_mem_calloc (1, sizeof (tiz_event_loop_t))),
+        (gp_event_loops = (tiz_event_loops_t *) tiz_mem_calloc (
+           1, sizeof (tiz_event_loops_t))),
         "Error allocating thread data struct.");
 
-      gp_event_loop->state = ETIZEventLoopStateStarting;
-
-      tiz_goto_end_on_omx_err (tiz_rcfile_init (&(gp_event_loop->p_rcfile)),
-                           "Error opening configuration file.");
+      tiz_goto_end_on_omx_err (tiz_rcfile_init (&(gp_event_loops->p_rcfile)),
+                               "Error opening configuration file.");
 
-      tiz_goto_end_on_null ((gp_event_loop->p_loop = ev_loop_new (EVFLAG_AUTO)),
-                            "Error instantiating ev_loop.");
+      gp_event_loops->nshards = configured_shards (gp_event_loops->p_rcfile);
 
-      tiz_goto_end_on_null ((gp_event_loop->p_async_watcher
-                            = (ev_async *) tiz_mem_calloc (1, sizeof (ev_async))),
-                           "Error initializing async watcher.");
-
-      tiz_goto_end_on_omx_err (tiz_mutex_init (&(gp_event_loop->mutex)),
-                           "Error initializing mutex.");
-
-      tiz_goto_end_on_omx_err (tiz_sem_init (&(gp_event_loop->sem), 0),
-                           "Error initializing sem.");
-
-      /* Init the small object allocator */
-      tiz_goto_end_on_omx_err (tiz_soa_init (&(gp_event_loop->p_soa)),
-                           "Error initializing the small object allocator.");
+      tiz_goto_end_on_null (
+        (gp_event_loops->p_shards = (tiz_event_loop_t *) tiz_mem_calloc (
+           gp_event_loops->nshards, sizeof (tiz_event_loop_t))),
+        "Error allocating the event loop shards.");
 
-      /* Init the priority queue */
-      tiz_goto_end_on_omx_err (
-        tiz_pqueue_init (&gp_event_loop->p_pq, 2, &pqueue_cmp,
-                         gp_event_loop->p_soa, TIZ_EVENT_LOOP_THREAD_NAME),
-        "Error initializing pqueue.");
+      for (i = 0; i < gp_event_loops->nshards; ++i)
+        {
+          tiz_goto_end_on_omx_err (
+            init_shard (&(gp_event_loops->p_shards[i]), i),
+            "Error initializing event loop shard.");
+        }
 
       /* All good */
       rc = OMX_ErrorNone;
 
-      ev_async_init (gp_event_loop->p_async_watcher, async_watcher_cback);
-      ev_async_start (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
-
-      assert (gp_event_loop);
+      assert (gp_event_loops);
     }
 
 end:
 
   if (OMX_ErrorNone == rc)
     {
-      tiz_event_loop_t * p_lp = gp_event_loop;
-      p_lp->state = ETIZEventLoopStateStarted;
-      /* Create event loop thread */
-      tiz_thread_create (&(p_lp->thread), 0, 0, event_loop_thread_func, p_lp);
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "Now in ETIZEventLoopStateStarted state...");
-
-      (void) tiz_mutex_lock (&(p_lp->mutex));
-      /* This is to prevent the event loop from exiting when there are no
-       * more active events */
-      ev_ref (p_lp->p_loop);
-      (void) tiz_mutex_unlock (&(p_lp->mutex));
-      tiz_sem_wait (&(p_lp->sem));
+      TIZ_LOG (TIZ_PRIORITY_DEBUG, "Starting [%u] event loop shard(s)...",
+               gp_event_loops->nshards);
+      for (i = 0; i < gp_event_loops->nshards; ++i)
+        {
+          start_shard (&(gp_event_loops->p_shards[i]));
+        }
     }
   else
     {
-      clean_up_thread_data (gp_event_loop);
-      tiz_mem_free (gp_event_loop);
-      gp_event_loop = NULL;
+      clean_up_thread_data (gp_event_loops);
     }
 }
 
-static inline tiz_event_loop_t *
+static inline tiz_event_loops_t *
 get_event_loop (void)
 {
   (void) pthread_once (&g_event_loop_once, init_event_loop_thread);
-  return gp_event_loop;
+  return gp_event_loops;
+}
+
+/* Watchers are pinned to a shard when they are created, using their first
+   argument as the key. For the watchers created by the component servants,
+   this is the component handle; hence all the events of a component are
+   delivered by the same loop thread. */
+static tiz_event_loop_t *
+pick_shard (const void * ap_key)
+{
+  tiz_event_loops_t * p_lps = get_event_loop ();
+  uint64_t hash = (uint64_t) (uintptr_t) ap_key;
+
+  if (!p_lps)
+    {
+      return NULL;
+    }
+
+  /* Fibonacci hashing; the low bits of heap addresses carry no
+     information */
+  hash = (hash >> 4) * 11400714819323198485ULL;
+  return &(p_lps->p_shards[(hash >> 32) % p_lps->nshards]);
 }
 
 OMX_ERRORTYPE
@@ -1185,29 +1375,44 @@ tiz_event_loop_init (void)
 void
 tiz_event_loop_destroy (void)
 {
-  /* NOTE: If the thread is destroyed, it can't be recreated in the same
-     process as it's been instantiated with pthread_once. */
+  /* NOTE: If the threads are destroyed, they can't be recreated in the same
+     process as they've been instantiated with pthread_once. */
 
-  if (gp_event_loop)
+  if (gp_event_loops)
     {
-      (void) tiz_mutex_lock (&(gp_event_loop->mutex));
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "destroying event loop thread [%p].",
-               gp_event_loop);
-      gp_event_loop->state = ETIZEventLoopStateStopping;
-      ev_unref (gp_event_loop->p_loop);
-      ev_async_send (gp_event_loop->p_loop, gp_event_loop->p_async_watcher);
-      (void) tiz_mutex_unlock (&(gp_event_loop->mutex));
-
-      {
-        OMX_PTR p_result = NULL;
-        tiz_thread_join (&(gp_event_loop->thread), &p_result);
-        clean_up_thread_data (gp_event_loop);
-        tiz_mem_free (gp_event_loop);
-        gp_event_loop = NULL;
-      }
+      tiz_event_loops_t * p_lps = gp_event_loops;
+      uint32_t i = 0;
+
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "destroying [%u] event loop thread(s).",
+               p_lps->nshards);
+
+      for (i = 0; i < p_lps->nshards; ++i)
+        {
+          tiz_event_loop_t * p_lp = &(p_lps->p_shards[i]);
+          (void) tiz_mutex_lock (&(p_lp->mutex));
+          p_lp->state = ETIZEventLoopStateStopping;
+          ev_unref (p_lp->p_loop);
+          ev_async_send (p_lp->p_loop, p_lp->p_async_watcher);
+          (void) tiz_mutex_unlock (&(p_lp->mutex));
+        }
+
+      for (i = 0; i < p_lps->nshards; ++i)
+        {
+          OMX_PTR p_result = NULL;
+          tiz_thread_join (&(p_lps->p_shards[i].thread), &p_result);
+        }
+
+      clean_up_thread_data (p_lps);
     }
 }
 
+uint32_t
+tiz_event_loop_shards (void)
+{
+  tiz_event_loops_t * p_lps = get_event_loop ();
+  return p_lps ? p_lps->nshards : 0;
+}
+
 /*
  * IO Event-related functions
  */
@@ -1218,10 +1423,11 @@ tiz_event_io_init (tiz_event_io_t ** app_ev_io, void * ap_arg0,
 {
   OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
   tiz_event_io_t * p_ev_io = NULL;
+  tiz_event_loop_t * p_lp = NULL;
 
   assert (app_ev_io);
   assert (ap_cback);
-  (void) get_event_loop ();
+  tiz_check_null_ret_oom ((p_lp = pick_shard (ap_arg0)) != NULL);
 
   if ((p_ev_io
        = (tiz_event_io_t *) tiz_mem_calloc (1, sizeof (tiz_event_io_t))))
@@ -1233,6 +1439,7 @@ tiz_event_io_init (tiz_event_io_t ** app_ev_io, void * ap_arg0,
       p_ev_io->id = 0;
       p_ev_io->fd = -1;
       p_ev_io->started = false;
+      p_ev_io->p_lp = p_lp;
       ev_init ((ev_io *) p_ev_io, io_watcher_cback);
       rc = OMX_ErrorNone;
     }
@@ -1298,10 +1505,11 @@ tiz_event_timer_init (tiz_event_timer_t ** app_ev_timer, void * ap_arg0,
 {
   OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
   tiz_event_timer_t * p_ev_timer = NULL;
+  tiz_event_loop_t * p_lp = NULL;
 
   assert (app_ev_timer);
   assert (ap_cback);
-  (void) get_event_loop ();
+  tiz_check_null_ret_oom ((p_lp = pick_shard (ap_arg0)) != NULL);
 
   if ((p_ev_timer
        = (tiz_event_timer_t *) tiz_mem_calloc (1, sizeof (tiz_event_timer_t))))
@@ -1312,6 +1520,7 @@ tiz_event_timer_init (tiz_event_timer_t ** app_ev_timer, void * ap_arg0,
       p_ev_timer->once = false;
       p_ev_timer->id = 0;
       p_ev_timer->started = false;
+      p_ev_timer->p_lp = p_lp;
       ev_init ((ev_timer *) p_ev_timer, timer_watcher_cback);
       rc = OMX_ErrorNone;
     }
@@ -1384,10 +1593,11 @@ tiz_event_stat_init (tiz_event_stat_t ** app_ev_stat, void * ap_arg0,
 {
   OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
   tiz_event_stat_t * p_ev_stat = NULL;
+  tiz_event_loop_t * p_lp = NULL;
 
   assert (app_ev_stat);
   assert (ap_cback);
-  (void) get_event_loop ();
+  tiz_check_null_ret_oom ((p_lp = pick_shard (ap_arg0)) != NULL);
 
   if ((p_ev_stat
        = (tiz_event_stat_t *) tiz_mem_calloc (1, sizeof (tiz_event_stat_t))))
@@ -1397,6 +1607,7 @@ tiz_event_stat_init (tiz_event_stat_t ** app_ev_stat, void * ap_arg0,
       p_ev_stat->p_arg1 = ap_arg1;
       p_ev_stat->id = 0;
       p_ev_stat->started = false;
+      p_ev_stat->p_lp = p_lp;
       ev_init ((ev_stat *) p_ev_stat, stat_watcher_cback);
       rc = OMX_ErrorNone;
     }
@@ -1445,7 +1656,7 @@ tiz_event_stat_destroy (tiz_event_stat_t * ap_ev_stat)
 tiz_rcfile_t *
 tiz_rcfile_get_handle (void)
 {
-  tiz_event_loop_t * p_event_loop = get_event_loop ();
-  return (p_event_loop && p_event_loop->p_rcfile) ? p_event_loop->p_rcfile
-                                                  : NULL;
+  tiz_event_loops_t * p_event_loops = get_event_loop ();
+  return (p_event_loops && p_event_loops->p_rcfile) ? p_event_loops->p_rcfile
+                                                    : NULL;
 }
@@ -36,7 +36,8 @@ extern "C" {
 /**
  * @defgroup tizevent Global event loop, async io and timers.
  *
- * Global event loop, async io and timers.
+ * Global event loop, async io and timers. The event loop may be split into
+ * several shards, each running in its own thread.
  *
  * @ingroup libtizplatform
  */
@@ -125,6 +126,23 @@ tiz_event_loop_init (void);
 void
 tiz_event_loop_destroy (void);
 
+/**
+ * Retrieve the number of event loop shards. Each shard is an event loop
+ * hosted in its own thread. Watchers are assigned to a shard when they are
+ * created, based on the value of their first argument (i.e. the component
+ * handle, in the case of watchers created by the component servants). The
+ * number of shards is read from the 'event-loop-shards' key of the
+ * [ilcore] section of tizonia.conf (0 means one per online processor); the
+ * default is a single shard.
+ *
+ * @ingroup tizevent
+ *
+ * @return The number of shards, or zero if the event loop could not be
+ * initialised.
+ */
+uint32_t
+tiz_event_loop_shards (void);
+
 OMX_ERRORTYPE
 tiz_event_io_init (tiz_event_io_t ** app_ev_io, void * ap_arg0,
                    tiz_event_io_cb_f ap_cback, void * ap_arg1);
@@ -0,0 +1,427 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizlfqueue.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free bounded message queue
+ *
+ * This is a bounded ring of sequenced slots (D. Vyukov's bounded queue). Each
+ * slot carries a sequence number that tells producers and consumers whether
+ * the slot is free to be written or ready to be read at a given position, so
+ * that claiming a position is a single CAS on the head or tail counter.
+ *
+ * Blocking is implemented with two futex words, one per direction. A thread
+ * that finds the queue empty (or full) announces itself in the corresponding
+ * 'waiters' counter, re-checks the queue and only then parks. The other side
+ * only issues a FUTEX_WAKE when that counter is non-zero, so the common case
+ * (nobody parked) costs no system calls at all.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.lfqueue"
+#endif
+
+#define LFQ_CACHE_LINE_SIZE 64
+/* Number of times a thread re-tries before parking in the kernel (only on
+   multi-core systems; on a single core spinning just delays the thread that
+   could make progress) */
+#define LFQ_SPIN_COUNT 64
+
+#define lfq_load(p) __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define lfq_load_relaxed(p) __atomic_load_n ((p), __ATOMIC_RELAXED)
+#define lfq_store(p, v) __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#define lfq_fence() __atomic_thread_fence (__ATOMIC_SEQ_CST)
+
+typedef struct tiz_lfqueue_cell tiz_lfqueue_cell_t;
+struct tiz_lfqueue_cell
+{
+  size_t seq;
+  OMX_PTR p_data;
+};
+
+typedef struct tiz_lfqueue_waitq tiz_lfqueue_waitq_t;
+struct tiz_lfqueue_waitq
+{
+  /* futex word; bumped every time a waiter needs to be woken up */
+  uint32_t futex;
+  /* number of threads that are about to park, or parked, on 'futex' */
+  uint32_t waiters;
+};
+
+struct tiz_lfqueue
+{
+  tiz_lfqueue_cell_t * p_cells;
+  OMX_S32 capacity;
+  size_t mask;
+  int spin_count;
+  char pad0[LFQ_CACHE_LINE_SIZE];
+  size_t enqueue_pos;
+  char pad1[LFQ_CACHE_LINE_SIZE - sizeof (size_t)];
+  size_t dequeue_pos;
+  char pad2[LFQ_CACHE_LINE_SIZE - sizeof (size_t)];
+  tiz_lfqueue_waitq_t not_empty; /* consumers park here */
+  char pad3[LFQ_CACHE_LINE_SIZE - sizeof (tiz_lfqueue_waitq_t)];
+  tiz_lfqueue_waitq_t not_full; /* producers park here */
+};
+
+static inline void
+cpu_relax (void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield" ::: "memory");
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+static inline void
+futex_wait (uint32_t * ap_addr, uint32_t a_val)
+{
+  /* EAGAIN (value changed) and EINTR are both fine; the caller re-checks */
+  (void) syscall (SYS_futex, ap_addr, FUTEX_WAIT_PRIVATE, a_val, NULL, NULL,
+                  0);
+}
+
+static inline void
+futex_wake (uint32_t * ap_addr, int a_nwaiters)
+{
+  (void) syscall (SYS_futex, ap_addr, FUTEX_WAKE_PRIVATE, a_nwaiters, NULL,
+                  NULL, 0);
+}
+
+static inline void
+wake_if_parked (tiz_lfqueue_waitq_t * ap_wq)
+{
+  /* Pairs with the fence in park (). Either the waiter sees our update of the
+     ring, or we see its registration in 'waiters' */
+  lfq_fence ();
+  if (lfq_load_relaxed (&(ap_wq->waiters)) > 0)
+    {
+      (void) __atomic_add_fetch (&(ap_wq->futex), 1, __ATOMIC_RELEASE);
+      futex_wake (&(ap_wq->futex), 1);
+    }
+}
+
+static bool
+try_enqueue (tiz_lfqueue_t * ap_q, OMX_PTR ap_data)
+{
+  tiz_lfqueue_cell_t * p_cell = NULL;
+  size_t pos = lfq_load_relaxed (&(ap_q->enqueue_pos));
+
+  for (;;)
+    {
+      ptrdiff_t diff = 0;
+      p_cell = &(ap_q->p_cells[pos & ap_q->mask]);
+      diff = (ptrdiff_t) lfq_load (&(p_cell->seq)) - (ptrdiff_t) pos;
+      if (diff == 0)
+        {
+          if (__atomic_compare_exchange_n (&(ap_q->enqueue_pos), &pos, pos + 1,
+                                           true, __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+            {
+              break;
+            }
+        }
+      else if (diff < 0)
+        {
+          /* full */
+          return false;
+        }
+      else
+        {
+          pos = lfq_load_relaxed (&(ap_q->enqueue_pos));
+        }
+    }
+
+  p_cell->p_data = ap_data;
+  lfq_store (&(p_cell->seq), pos + 1);
+  return true;
+}
+
+static bool
+try_dequeue (tiz_lfqueue_t * ap_q, OMX_PTR * app_data)
+{
+  tiz_lfqueue_cell_t * p_cell = NULL;
+  size_t pos = lfq_load_relaxed (&(ap_q->dequeue_pos));
+
+  for (;;)
+    {
+      ptrdiff_t diff = 0;
+      p_cell = &(ap_q->p_cells[pos & ap_q->mask]);
+      diff = (ptrdiff_t) lfq_load (&(p_cell->seq)) - (ptrdiff_t) (pos + 1);
+      if (diff == 0)
+        {
+          if (__atomic_compare_exchange_n (&(ap_q->dequeue_pos), &pos, pos + 1,
+                                           true, __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+            {
+              break;
+            }
+        }
+      else if (diff < 0)
+        {
+          /* empty */
+          return false;
+        }
+      else
+        {
+          pos = lfq_load_relaxed (&(ap_q->dequeue_pos));
+        }
+    }
+
+  *app_data = p_cell->p_data;
+  p_cell->p_data = NULL;
+  lfq_store (&(p_cell->seq), pos + ap_q->capacity);
+  return true;
+}
+
+/* Park the calling thread on 'ap_wq' until the other side signals progress.
+   Returns early (without sleeping) if the operation succeeds on the last
+   re-check. */
+static bool
+park (tiz_lfqueue_t * ap_q, tiz_lfqueue_waitq_t * ap_wq,
+      bool (*apf_try) (tiz_lfqueue_t *, OMX_PTR *), OMX_PTR * app_data)
+{
+  bool done = false;
+  const uint32_t val = lfq_load (&(ap_wq->futex));
+  (void) __atomic_add_fetch (&(ap_wq->waiters), 1, __ATOMIC_RELAXED);
+  lfq_fence ();
+  done = apf_try (ap_q, app_data);
+  if (!done)
+    {
+      futex_wait (&(ap_wq->futex), val);
+    }
+  (void) __atomic_sub_fetch (&(ap_wq->waiters), 1, __ATOMIC_RELAXED);
+  return done;
+}
+
+static bool
+try_enqueue_adapter (tiz_lfqueue_t * ap_q, OMX_PTR * app_data)
+{
+  return try_enqueue (ap_q, *app_data);
+}
+
+static OMX_S32
+round_up_pow2 (OMX_S32 a_val)
+{
+  OMX_S32 pow2 = 1;
+  while (pow2 < a_val)
+    {
+      pow2 <<= 1;
+    }
+  return pow2;
+}
+
+OMX_ERRORTYPE
+tiz_lfqueue_init (tiz_lfqueue_ptr_t * app_q, OMX_S32 a_capacity)
+{
+  tiz_lfqueue_t * p_q = NULL;
+  OMX_S32 i = 0;
+
+  assert (app_q);
+  assert (a_capacity > 0);
+
+  /* Slot indexes are computed with a mask, so that position counters can
+     wrap around safely */
+  a_capacity = round_up_pow2 (a_capacity);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "queue capacity [%d]", a_capacity);
+
+  p_q = (tiz_lfqueue_t *) tiz_mem_calloc (1, sizeof (tiz_lfqueue_t));
+  if (!p_q)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "OMX_ErrorInsufficientResources: "
+               "Could not instantiate queue struct.");
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_q->p_cells = (tiz_lfqueue_cell_t *) tiz_mem_calloc (
+    a_capacity, sizeof (tiz_lfqueue_cell_t));
+  if (!p_q->p_cells)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR,
+               "[OMX_ErrorInsufficientResources]: "
+               "Could not instantiate queue cells.");
+      tiz_mem_free (p_q);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  for (i = 0; i < a_capacity; ++i)
+    {
+      p_q->p_cells[i].seq = i;
+    }
+
+  p_q->capacity = a_capacity;
+  p_q->mask = (size_t) a_capacity - 1;
+  p_q->spin_count = sysconf (_SC_NPROCESSORS_ONLN) > 1 ? LFQ_SPIN_COUNT : 0;
+  *app_q = p_q;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "queue created [%p]", p_q);
+
+  return OMX_ErrorNone;
+}
+
+void
+tiz_lfqueue_destroy (tiz_lfqueue_t * p_q)
+{
+  if (p_q)
+    {
+      tiz_mem_free (p_q->p_cells);
+      tiz_mem_free (p_q);
+    }
+}
+
+OMX_ERRORTYPE
+tiz_lfqueue_send (tiz_lfqueue_t * p_q, OMX_PTR ap_data)
+{
+  int spin = 0;
+
+  assert (p_q);
+  assert (ap_data);
+
+  while (!try_enqueue (p_q, ap_data))
+    {
+      if (spin++ < p_q->spin_count)
+        {
+          cpu_relax ();
+        }
+      else if (park (p_q, &(p_q->not_full), try_enqueue_adapter, &ap_data))
+        {
+          break;
+        }
+    }
+
+  wake_if_parked (&(p_q->not_empty));
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_lfqueue_receive (tiz_lfqueue_t * p_q, OMX_PTR * app_data)
+{
+  int spin = 0;
+
+  assert (p_q);
+  assert (app_data);
+
+  while (!try_dequeue (p_q, app_data))
+    {
+      if (spin++ < p_q->spin_count)
+        {
+          cpu_relax ();
+        }
+      else if (park (p_q, &(p_q->not_empty), try_dequeue, app_data))
+        {
+          break;
+        }
+    }
+
+  assert (*app_data);
+
+  wake_if_parked (&(p_q->not_full));
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_lfqueue_try_send (tiz_lfqueue_t * p_q, OMX_PTR ap_data)
+{
+  assert (p_q);
+  assert (ap_data);
+
+  if (!try_enqueue (p_q, ap_data))
+    {
+      return OMX_ErrorNotReady;
+    }
+
+  wake_if_parked (&(p_q->not_empty));
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_lfqueue_try_receive (tiz_lfqueue_t * p_q, OMX_PTR * app_data)
+{
+  assert (p_q);
+  assert (app_data);
+
+  if (!try_dequeue (p_q, app_data))
+    {
+      return OMX_ErrorNotReady;
+    }
+
+  wake_if_parked (&(p_q->not_full));
+
+  return OMX_ErrorNone;
+}
+
+OMX_S32
+tiz_lfqueue_capacity (tiz_lfqueue_t * p_q)
+{
+  assert (p_q);
+  return p_q->capacity;
+}
+
+OMX_S32
+tiz_lfqueue_length (tiz_lfqueue_t * p_q)
+{
+  size_t head = 0;
+  size_t tail = 0;
+  ptrdiff_t length = 0;
+
+  assert (p_q);
+
+  /* Read the consumer position first, so that the difference is not
+     negative unless a concurrent update is in progress */
+  head = lfq_load (&(p_q->dequeue_pos));
+  tail = lfq_load (&(p_q->enqueue_pos));
+  length = (ptrdiff_t) (tail - head);
+
+  if (length < 0)
+    {
+      length = 0;
+    }
+  else if (length > p_q->capacity)
+    {
+      length = p_q->capacity;
+    }
+
+  return (OMX_S32) length;
+}
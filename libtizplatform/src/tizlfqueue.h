@@ -0,0 +1,147 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizlfqueue.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free bounded message queue
+ *
+ *
+ */
+
+#ifndef TIZLFQUEUE_H
+#define TIZLFQUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizlfqueue Lock-free bounded message queue
+ *
+ * Bounded multi-producer, multi-consumer FIFO queue. Items are exchanged
+ * through a ring of sequenced slots without taking any locks. Producers and consumers only
+ * enter the kernel (futex) when they actually need to park, i.e. when the
+ * queue is full or empty; a wake-up is only issued when there is someone
+ * parked on the other side. The API mirrors the one in @ref tizqueue.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * Lock-free queue opaque structure.
+ * @ingroup tizlfqueue
+ */
+typedef struct tiz_lfqueue tiz_lfqueue_t;
+typedef /*@null@ */ tiz_lfqueue_t * tiz_lfqueue_ptr_t;
+
+/**
+ * Initialize a new empty lock-free queue.
+ *
+ * @ingroup tizlfqueue
+ *
+ * @param a_capacity Maximum number of items that can be send into the queue.
+ * This is rounded up to the next power of two (see tiz_lfqueue_capacity).
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_lfqueue_init (/*@out@*/ tiz_lfqueue_ptr_t * app_q, OMX_S32 a_capacity);
+
+/**
+ * Destroy a queue. If ap_q is NULL, no operation is performed.
+ *
+ * @ingroup tizlfqueue
+ *
+ */
+void
+tiz_lfqueue_destroy (/*@null@ */ tiz_lfqueue_t * ap_q);
+
+/**
+ * Add an item onto the end of the queue. If the queue is full, it blocks
+ * until a space becomes available. Safe to be called concurrently from
+ * multiple threads.
+ *
+ * @ingroup tizlfqueue
+ *
+ */
+OMX_ERRORTYPE
+tiz_lfqueue_send (tiz_lfqueue_t * ap_q, OMX_PTR ap_data);
+
+/**
+ * Retrieve an item from the head of the queue. If the queue is empty, it
+ * blocks until an item becomes available.
+ *
+ * @ingroup tizlfqueue
+ *
+ */
+OMX_ERRORTYPE
+tiz_lfqueue_receive (tiz_lfqueue_t * ap_q, OMX_PTR * app_data);
+
+/**
+ * Add an item onto the end of the queue, without blocking.
+ *
+ * @ingroup tizlfqueue
+ *
+ * @return OMX_ErrorNone if the item was added, OMX_ErrorNotReady if the queue
+ * is full.
+ */
+OMX_ERRORTYPE
+tiz_lfqueue_try_send (tiz_lfqueue_t * ap_q, OMX_PTR ap_data);
+
+/**
+ * Retrieve an item from the head of the queue, without blocking.
+ *
+ * @ingroup tizlfqueue
+ *
+ * @return OMX_ErrorNone if an item was retrieved, OMX_ErrorNotReady if the
+ * queue is empty.
+ */
+OMX_ERRORTYPE
+tiz_lfqueue_try_receive (tiz_lfqueue_t * ap_q, OMX_PTR * app_data);
+
+/**
+ * Retrieve the maximum number of items that can be stored in the queue.
+ *
+ * @ingroup tizlfqueue
+ *
+ */
+OMX_S32
+tiz_lfqueue_capacity (tiz_lfqueue_t * ap_q);
+
+/**
+ * Retrieve the number of items currently stored in the queue. This is a
+ * snapshot; the value may be stale by the time it is returned if other
+ * threads are using the queue concurrently.
+ *
+ * @ingroup tizlfqueue
+ *
+ */
+OMX_S32
+tiz_lfqueue_length (tiz_lfqueue_t * ap_q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZLFQUEUE_H */
@@ -17,12 +17,27 @@
  * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 /**
- * @file   tizlog.h
+ * @file   tizlog.c
  * @author Juan A. Rubio <juan.rubio@aratelia.com>
  *
  * @brief  Tizonia Platform - Logging API implementation
  *
+ * When the asynchronous mode is enabled (see 'log-async' in tizonia.conf),
+ * tiz_log does not format anything on the caller's thread. Each thread owns
+ * a single-producer/single-consumer ring of records. A record is a fixed
+ * header (location, category, priority, thread id and time stamp, plus the
+ * pointer to the format string) followed by the raw arguments, which are
+ * captured by walking the conversion specifications of the format string;
+ * strings are copied, as they may not outlive the call. A background thread
+ * drains the rings, formats the messages and hands them over to log4c.
+ *
+ * Errors and warnings wake the logging thread up straight away; other
+ * records are written out within LOG_FLUSH_INTERVAL_MS, or as soon as the
+ * ring is a quarter full. When a ring is full, errors and warnings wait for
+ * the logging thread to make room; less severe records are dropped, and the
+ * logging thread reports how many were lost.
  *
  */
 
@@ -33,19 +48,185 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <sys/syscall.h>
+#include <linux/futex.h>
 #include <time.h>
-#include <alloca.h>
 
 #include <log4c.h>
 #include <log4c/appender.h>
 #include <log4c/appender_type_rollingfile.h>
 #include <log4c/rollingpolicy.h>
 
-#include "tizlog.h"
+#include "tizplatform.h"
+#include "tizplatform_internal.h"
+
+/* Must be at least as large as the components' log buffer (see TIZ_CBUF) */
+#define LOG_MAX_MSG 4096
+
+#ifndef WITHOUT_LOG4C
+
+/* Per-thread ring size; must be a power of two */
+#define LOG_RING_SIZE (64 * 1024)
+#define LOG_CACHE_LINE_SIZE 64
+#define LOG_ALIGN 16
+#define LOG_ALIGN_UP(n) (((n) + (LOG_ALIGN - 1)) & ~((size_t) LOG_ALIGN - 1))
+/* Longest file or function name kept in a record */
+#define LOG_MAX_LOC 256
+/* Upper bound of the size of a record, header included */
+#define LOG_MAX_RECORD (LOG_MAX_MSG + 4 * LOG_MAX_LOC)
+/* The longest "%flags width .precision" prefix that is captured */
+#define LOG_MAX_SPEC 24
+/* How often the logging thread looks for messages that nobody woke it up
+   for */
+#define LOG_FLUSH_INTERVAL_MS 100
+/* Number of slots of the category cache; must be a power of two */
+#define LOG_CATEGORY_CACHE_SIZE 128
+
+#define LOG_RECORD_PAD 0x1   /* filler up to the end of the ring */
+#define LOG_RECORD_TEXT 0x2  /* the message has been formatted already */
+#define LOG_RECORD_CNAME 0x4 /* the record carries a component name */
+
+/* A record does not point to any of the caller's strings: the file and
+   function names, and the format string, may live in a plugin that is
+   unloaded before the record is written out. They are copied after the
+   header, followed by the component name (LOG_RECORD_CNAME), and then either
+   the format string and the captured arguments, or the formatted message
+   (LOG_RECORD_TEXT). */
+
+#define log_load(p) __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define log_store(p, v) __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#define log_fence() __atomic_thread_fence (__ATOMIC_SEQ_CST)
+
+typedef struct log_record log_record_t;
+struct log_record
+{
+  uint32_t size;
+  uint32_t flags;
+  int priority;
+  int line;
+  int tid;
+  const log4c_category_t * p_category;
+  struct timeval timestamp;
+};
+
+#define LOG_RECORD_HDR_SIZE LOG_ALIGN_UP (sizeof (log_record_t))
+
+/* One captured argument; strings are followed by their bytes */
+typedef union log_arg log_arg_t;
+union log_arg
+{
+  long long i;
+  long double d;
+  const void * p;
+  size_t len;
+};
+
+typedef struct log_ring log_ring_t;
+struct log_ring
+{
+  log_ring_t * p_next;
+  unsigned char * p_data;
+  int tid;
+  bool orphaned;        /* the owner thread has exited */
+  uint64_t dropped;     /* written by the producer only */
+  uint64_t reported;    /* written by the consumer only */
+  char pad0[LOG_CACHE_LINE_SIZE];
+  uint64_t head;        /* written by the producer only */
+  char pad1[LOG_CACHE_LINE_SIZE - sizeof (uint64_t)];
+  uint64_t tail;        /* written by the consumer only */
+  char pad2[LOG_CACHE_LINE_SIZE - sizeof (uint64_t)];
+};
+
+typedef struct log_async log_async_t;
+struct log_async
+{
+  pthread_mutex_t mutex; /* protects the list of rings */
+  pthread_t thread;
+  pthread_key_t key;
+  log_ring_t * p_rings;
+  uint32_t generation; /* bumped every time the backend is stopped */
+  bool running;
+  bool stop;
+  uint32_t futex;    /* bumped to wake up the logging thread */
+  uint32_t sleeping; /* the logging thread is about to park, or parked */
+  char msg[LOG_MAX_MSG];
+  char cbuf[LOG_MAX_MSG];
+};
+
+typedef struct log_category_slot log_category_slot_t;
+struct log_category_slot
+{
+  const char * p_name;
+  const log4c_category_t * p_category;
+};
+
+typedef enum log_arg_class log_arg_class_t;
+enum log_arg_class
+{
+  ELogArgInt,
+  ELogArgUInt,
+  ELogArgChar,
+  ELogArgDouble,
+  ELogArgString,
+  ELogArgPointer,
+  ELogArgUnsupported
+};
+
+typedef enum log_arg_length log_arg_length_t;
+enum log_arg_length
+{
+  ELogLenNone,
+  ELogLenChar,     /* hh */
+  ELogLenShort,    /* h */
+  ELogLenLong,     /* l */
+  ELogLenLongLong, /* ll, q, L */
+  ELogLenIntMax,   /* j */
+  ELogLenSize,     /* z, Z */
+  ELogLenPtrDiff   /* t */
+};
+
+typedef struct log_spec log_spec_t;
+struct log_spec
+{
+  const char * p_end;  /* first character after the conversion */
+  size_t prefix_len;   /* length of the "%flags width .precision" prefix */
+  int nstars;          /* '*' width and/or precision */
+  bool star_precision; /* the last '*' is the precision */
+  long precision;      /* literal precision, or -1 */
+  log_arg_length_t length;
+  log_arg_class_t cls;
+  char conv;
+};
+
+typedef struct log_writer log_writer_t;
+struct log_writer
+{
+  unsigned char * p_cur;
+  unsigned char * p_end;
+};
+
+static log_async_t g_log = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+static log_category_slot_t g_categories[LOG_CATEGORY_CACHE_SIZE];
+static pthread_mutex_t g_categories_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_atfork_once = PTHREAD_ONCE_INIT;
+static int g_pid;
+
+static __thread log_ring_t * tp_ring;
+static __thread uint32_t t_ring_generation;
+static __thread int t_tid;
+
+#endif /* WITHOUT_LOG4C */
 
 typedef struct user_locinfo user_locinfo_t;
 struct user_locinfo
@@ -54,6 +235,9 @@ struct user_locinfo
   int tid;
   const char * cname;
   char * cbuf;
+  /* When not NULL, the time the message was logged (as opposed to the time
+     it is written out) */
+  const struct timeval * p_timestamp;
 };
 
 static const char *
@@ -70,8 +254,10 @@ log_layout_format (const log4c_layout_t * a_layout,
   if (a_event->evt_loc->loc_data)
     {
       struct tm tm;
-      gmtime_r (&a_event->evt_timestamp.tv_sec, &tm);
+      const struct timeval * p_ts = NULL;
       uloc = (user_locinfo_t *) a_event->evt_loc->loc_data;
+      p_ts = uloc->p_timestamp ? uloc->p_timestamp : &a_event->evt_timestamp;
+      gmtime_r (&p_ts->tv_sec, &tm);
 
       if (NULL == uloc->cname)
         {
@@ -79,7 +265,7 @@ log_layout_format (const log4c_layout_t * a_layout,
                     "%02d-%02d-%04d %02d:%02d:%02d.%03ld - "
                     "[PID:%i][TID:%i] [%s] [%s] [%s:%s:%i] --- %s\n",
                     tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900, tm.tm_hour,
-                    tm.tm_min, tm.tm_sec, a_event->evt_timestamp.tv_usec / 1000,
+                    tm.tm_min, tm.tm_sec, (long) p_ts->tv_usec / 1000,
                     uloc->pid, uloc->tid,
                     log4c_priority_to_string (a_event->evt_priority),
                     a_event->evt_category, a_event->evt_loc->loc_file,
@@ -94,7 +280,7 @@ log_layout_format (const log4c_layout_t * a_layout,
                     "%02d-%02d-%04d %02d:%02d:%02d.%03ld - "
                     "[PID:%i][TID:%i] [%s] [%s] [%s:%s:%i] --- %s\n",
                     tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900, tm.tm_hour,
-                    tm.tm_min, tm.tm_sec, a_event->evt_timestamp.tv_usec / 1000,
+                    tm.tm_min, tm.tm_sec, (long) p_ts->tv_usec / 1000,
                     uloc->pid, uloc->tid,
                     log4c_priority_to_string (a_event->evt_priority),
                     uloc->cname, a_event->evt_loc->loc_file,
@@ -139,12 +325,1043 @@ log_formatters_init (void)
   return rc;
 }
 
+#ifndef WITHOUT_LOG4C
+
+/*
+ * Category cache. The category names are expected to be string literals
+ * (see TIZ_LOG_CATEGORY_NAME), so their addresses are used as keys. Lookups
+ * are lock-free; insertions are serialised with a mutex. A literal in a
+ * plugin that has been unloaded may have the same address as a different
+ * name in the next plugin loaded, so hits are confirmed against the name of
+ * the category, which log4c owns.
+ */
+
+static inline bool
+log_category_matches (const log4c_category_t * ap_category,
+                      const char * ap_name)
+{
+  return ap_category
+         && 0 == strcmp (log4c_category_get_name (ap_category), ap_name);
+}
+
+static const log4c_category_t *
+log_category_insert (const char * ap_name, size_t a_idx)
+{
+  const log4c_category_t * p_category = NULL;
+  size_t i = 0;
+
+  (void) pthread_mutex_lock (&g_categories_mutex);
+  for (i = 0; i < LOG_CATEGORY_CACHE_SIZE; ++i)
+    {
+      log_category_slot_t * p_slot
+        = &g_categories[(a_idx + i) & (LOG_CATEGORY_CACHE_SIZE - 1)];
+      if (p_slot->p_name == ap_name)
+        {
+          p_category = p_slot->p_category;
+          if (!log_category_matches (p_category, ap_name))
+            {
+              /* Stale: the name belonged to an unloaded plugin */
+              p_category = log4c_category_get (ap_name);
+              log_store (&p_slot->p_category, p_category);
+            }
+          break;
+        }
+      if (NULL == p_slot->p_name)
+        {
+          p_category = log4c_category_get (ap_name);
+          log_store (&p_slot->p_category, p_category);
+          log_store (&p_slot->p_name, ap_name);
+          break;
+        }
+    }
+  (void) pthread_mutex_unlock (&g_categories_mutex);
+
+  /* The cache is full: fall back to a regular lookup */
+  return p_category ? p_category : log4c_category_get (ap_name);
+}
+
+static inline const log4c_category_t *
+log_category_get (const char * ap_name)
+{
+  const size_t idx = (size_t) (((uintptr_t) ap_name >> 3) * 2654435761u)
+                     & (LOG_CATEGORY_CACHE_SIZE - 1);
+  size_t i = 0;
+
+  for (i = 0; i < LOG_CATEGORY_CACHE_SIZE; ++i)
+    {
+      const log_category_slot_t * p_slot
+        = &g_categories[(idx + i) & (LOG_CATEGORY_CACHE_SIZE - 1)];
+      const char * p_name = log_load (&p_slot->p_name);
+      if (p_name == ap_name)
+        {
+          const log4c_category_t * p_category = log_load (&p_slot->p_category);
+          if (log_category_matches (p_category, ap_name))
+            {
+              return p_category;
+            }
+          break;
+        }
+      if (NULL == p_name)
+        {
+          break;
+        }
+    }
+
+  return log_category_insert (ap_name, idx);
+}
+
+static void
+log_category_cache_clear (void)
+{
+  (void) pthread_mutex_lock (&g_categories_mutex);
+  memset (g_categories, 0, sizeof (g_categories));
+  (void) pthread_mutex_unlock (&g_categories_mutex);
+}
+
+static inline int
+log_pid (void)
+{
+  if (0 == g_pid)
+    {
+      g_pid = getpid ();
+    }
+  return g_pid;
+}
+
+static inline int
+log_tid (void)
+{
+  if (0 == t_tid)
+    {
+      t_tid = syscall (SYS_gettid);
+    }
+  return t_tid;
+}
+
+/*
+ * Format string parsing, shared by the producers (to capture the arguments)
+ * and the logging thread (to replay them).
+ */
+
+static const char *
+log_parse_spec (const char * ap_spec, log_spec_t * ap_out)
+{
+  const char * p = ap_spec + 1;
+
+  assert (ap_spec && '%' == *ap_spec);
+  assert (ap_out);
+
+  ap_out->nstars = 0;
+  ap_out->star_precision = false;
+  ap_out->precision = -1;
+  ap_out->length = ELogLenNone;
+  ap_out->cls = ELogArgUnsupported;
+
+  p += strspn (p, "-+ #0'I");
+  if ('*' == *p)
+    {
+      ++ap_out->nstars;
+      ++p;
+    }
+  else
+    {
+      p += strspn (p, "0123456789");
+    }
+
+  if ('.' == *p)
+    {
+      ++p;
+      if ('*' == *p)
+        {
+          ++ap_out->nstars;
+          ap_out->star_precision = true;
+          ++p;
+        }
+      else
+        {
+          ap_out->precision = strtol (p, NULL, 10);
+          p += strspn (p, "0123456789");
+        }
+    }
+
+  ap_out->prefix_len = p - ap_spec;
+
+  switch (*p)
+    {
+      case 'h':
+        ap_out->length = ('h' == p[1]) ? ELogLenChar : ELogLenShort;
+        p += ('h' == p[1]) ? 2 : 1;
+        break;
+      case 'l':
+        ap_out->length = ('l' == p[1]) ? ELogLenLongLong : ELogLenLong;
+        p += ('l' == p[1]) ? 2 : 1;
+        break;
+      case 'q':
+      case 'L':
+        ap_out->length = ELogLenLongLong;
+        ++p;
+        break;
+      case 'j':
+        ap_out->length = ELogLenIntMax;
+        ++p;
+        break;
+      case 'z':
+      case 'Z':
+        ap_out->length = ELogLenSize;
+        ++p;
+        break;
+      case 't':
+        ap_out->length = ELogLenPtrDiff;
+        ++p;
+        break;
+      default:
+        break;
+    };
+
+  ap_out->conv = *p;
+  switch (*p)
+    {
+      case 'd':
+      case 'i':
+        ap_out->cls = ELogArgInt;
+        break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        ap_out->cls = ELogArgUInt;
+        break;
+      case 'c':
+        ap_out->cls
+          = (ELogLenNone == ap_out->length) ? ELogArgChar : ELogArgUnsupported;
+        break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        ap_out->cls = ELogArgDouble;
+        break;
+      case 's':
+        /* Wide strings are not captured */
+        ap_out->cls = (ELogLenNone == ap_out->length) ? ELogArgString
+                                                       : ELogArgUnsupported;
+        break;
+      case 'p':
+        ap_out->cls = ELogArgPointer;
+        break;
+      default:
+        /* '%n', '%m', positional arguments, etc */
+        break;
+    };
+
+  if (ap_out->prefix_len > LOG_MAX_SPEC)
+    {
+      ap_out->cls = ELogArgUnsupported;
+    }
+
+  ap_out->p_end = ('\0' == *p) ? p : p + 1;
+  return ap_out->p_end;
+}
+
+static inline void *
+log_put (log_writer_t * ap_w, size_t a_size)
+{
+  unsigned char * p = ap_w->p_cur;
+  a_size = LOG_ALIGN_UP (a_size);
+  if (a_size > (size_t) (ap_w->p_end - p))
+    {
+      return NULL;
+    }
+  ap_w->p_cur += a_size;
+  return p;
+}
+
+static const char *
+log_put_cstr (log_writer_t * ap_w, const char * ap_str, size_t a_max)
+{
+  const size_t len = ap_str ? strnlen (ap_str, a_max - 1) : 0;
+  char * p_str = log_put (ap_w, len + 1);
+  if (p_str)
+    {
+      memcpy (p_str, ap_str ? ap_str : "", len);
+      p_str[len] = '\0';
+    }
+  return p_str;
+}
+
+static inline const unsigned char *
+log_get_cstr (const unsigned char * ap_payload, const char ** app_str)
+{
+  *app_str = (const char *) ap_payload;
+  return ap_payload + LOG_ALIGN_UP (strlen (*app_str) + 1);
+}
+
+static bool
+log_put_string (log_writer_t * ap_w, const char * ap_str, long a_max)
+{
+  log_arg_t * p_arg = log_put (ap_w, sizeof (log_arg_t));
+  char * p_str = NULL;
+  size_t len = 0;
+
+  if (NULL == p_arg)
+    {
+      return false;
+    }
+
+  if (NULL == ap_str)
+    {
+      /* glibc prints this, unless the precision is too short for it */
+      ap_str = "(null)";
+    }
+
+  /* Honour the precision: the string is not necessarily terminated */
+  len = (a_max >= 0) ? strnlen (ap_str, a_max) : strlen (ap_str);
+  p_arg->len = len;
+  if (NULL == (p_str = log_put (ap_w, len + 1)))
+    {
+      return false;
+    }
+  memcpy (p_str, ap_str, len);
+  p_str[len] = '\0';
+  return true;
+}
+
+static bool
+log_capture_args (log_writer_t * ap_w, const char * ap_format, va_list a_va)
+{
+  const char * p = ap_format;
+  log_spec_t spec;
+
+  while (NULL != (p = strchr (p, '%')))
+    {
+      log_arg_t * p_arg = NULL;
+      long precision = -1;
+      int i = 0;
+
+      if ('%' == p[1])
+        {
+          p += 2;
+          continue;
+        }
+
+      p = log_parse_spec (p, &spec);
+      if (ELogArgUnsupported == spec.cls)
+        {
+          return false;
+        }
+
+      for (i = 0; i < spec.nstars; ++i)
+        {
+          if (NULL == (p_arg = log_put (ap_w, sizeof (log_arg_t))))
+            {
+              return false;
+            }
+          p_arg->i = va_arg (a_va, int);
+          precision = p_arg->i;
+        }
+      precision = spec.star_precision ? precision : spec.precision;
+
+      if (ELogArgString == spec.cls)
+        {
+          if (!log_put_string (ap_w, va_arg (a_va, const char *), precision))
+            {
+              return false;
+            }
+          continue;
+        }
+
+      if (NULL == (p_arg = log_put (ap_w, sizeof (log_arg_t))))
+        {
+          return false;
+        }
+
+      switch (spec.cls)
+        {
+          case ELogArgInt:
+            {
+              switch (spec.length)
+                {
+                  case ELogLenChar:
+                    p_arg->i = (signed char) va_arg (a_va, int);
+                    break;
+                  case ELogLenShort:
+                    p_arg->i = (short) va_arg (a_va, int);
+                    break;
+                  case ELogLenLong:
+                    p_arg->i = va_arg (a_va, long);
+                    break;
+                  case ELogLenLongLong:
+                    p_arg->i = va_arg (a_va, long long);
+                    break;
+                  case ELogLenIntMax:
+                    p_arg->i = va_arg (a_va, intmax_t);
+                    break;
+                  case ELogLenSize:
+                    p_arg->i = va_arg (a_va, ssize_t);
+                    break;
+                  case ELogLenPtrDiff:
+                    p_arg->i = va_arg (a_va, ptrdiff_t);
+                    break;
+                  default:
+                    p_arg->i = va_arg (a_va, int);
+                    break;
+                };
+            }
+            break;
+          case ELogArgUInt:
+            {
+              switch (spec.length)
+                {
+                  case ELogLenChar:
+                    p_arg->i = (unsigned char) va_arg (a_va, unsigned int);
+                    break;
+                  case ELogLenShort:
+                    p_arg->i = (unsigned short) va_arg (a_va, unsigned int);
+                    break;
+                  case ELogLenLong:
+                    p_arg->i = va_arg (a_va, unsigned long);
+                    break;
+                  case ELogLenLongLong:
+                    p_arg->i = va_arg (a_va, unsigned long long);
+                    break;
+                  case ELogLenIntMax:
+                    p_arg->i = va_arg (a_va, uintmax_t);
+                    break;
+                  case ELogLenSize:
+                    p_arg->i = va_arg (a_va, size_t);
+                    break;
+                  case ELogLenPtrDiff:
+                    p_arg->i = (size_t) va_arg (a_va, ptrdiff_t);
+                    break;
+                  default:
+                    p_arg->i = va_arg (a_va, unsigned int);
+                    break;
+                };
+            }
+            break;
+          case ELogArgChar:
+            p_arg->i = va_arg (a_va, int);
+            break;
+          case ELogArgDouble:
+            p_arg->d = (ELogLenLongLong == spec.length)
+                         ? va_arg (a_va, long double)
+                         : va_arg (a_va, double);
+            break;
+          case ELogArgPointer:
+            p_arg->p = va_arg (a_va, void *);
+            break;
+          default:
+            assert (0);
+            break;
+        };
+    }
+
+  return true;
+}
+
+#define LOG_SNPRINTF(buf, room, fmt, nstars, stars, value)                \
+  (0 == (nstars) ? snprintf ((buf), (room), (fmt), (value))               \
+                 : (1 == (nstars) ? snprintf ((buf), (room), (fmt),       \
+                                              (stars)[0], (value))        \
+                                  : snprintf ((buf), (room), (fmt),       \
+                                              (stars)[0], (stars)[1],     \
+                                              (value))))
+
+static void
+log_format_args (const char * ap_format, const unsigned char * ap_args,
+                 char * ap_buf, size_t a_size)
+{
+  const char * p = ap_format;
+  size_t len = 0;
+  log_spec_t spec;
+
+  assert (a_size > 0);
+
+  while (*p && len < a_size - 1)
+    {
+      const log_arg_t * p_arg = NULL;
+      const char * p_spec = NULL;
+      char fmt[LOG_MAX_SPEC + 4];
+      int stars[2] = {0, 0};
+      int n = 0;
+      int i = 0;
+
+      if ('%' != *p)
+        {
+          size_t lit = strcspn (p, "%");
+          lit = MIN (lit, a_size - 1 - len);
+          memcpy (ap_buf + len, p, lit);
+          len += lit;
+          p += lit;
+          continue;
+        }
+
+      if ('%' == p[1])
+        {
+          ap_buf[len++] = '%';
+          p += 2;
+          continue;
+        }
+
+      p_spec = p;
+      p = log_parse_spec (p, &spec);
+      assert (ELogArgUnsupported != spec.cls);
+
+      for (i = 0; i < spec.nstars; ++i)
+        {
+          stars[i] = (int) ((const log_arg_t *) ap_args)->i;
+          ap_args += sizeof (log_arg_t);
+        }
+      p_arg = (const log_arg_t *) ap_args;
+      ap_args += sizeof (log_arg_t);
+
+      /* Re-build the specification, with the length modifier that matches
+         the type the argument was captured with */
+      memcpy (fmt, p_spec, spec.prefix_len);
+      fmt[spec.prefix_len] = '\0';
+
+      switch (spec.cls)
+        {
+          case ELogArgInt:
+          case ELogArgUInt:
+            {
+              const char conv[4] = {'l', 'l', spec.conv, '\0'};
+              strcat (fmt, conv);
+              n = LOG_SNPRINTF (ap_buf + len, a_size - len, fmt, spec.nstars,
+                                stars, p_arg->i);
+            }
+            break;
+          case ELogArgChar:
+            {
+              const char conv[2] = {spec.conv, '\0'};
+              strcat (fmt, conv);
+              n = LOG_SNPRINTF (ap_buf + len, a_size - len, fmt, spec.nstars,
+                                stars, (int) p_arg->i);
+            }
+            break;
+          case ELogArgDouble:
+            {
+              const char conv[3] = {'L', spec.conv, '\0'};
+              strcat (fmt, conv);
+              n = LOG_SNPRINTF (ap_buf + len, a_size - len, fmt, spec.nstars,
+                                stars, p_arg->d);
+            }
+            break;
+          case ELogArgString:
+            {
+              strcat (fmt, "s");
+              n = LOG_SNPRINTF (ap_buf + len, a_size - len, fmt, spec.nstars,
+                                stars, (const char *) (p_arg + 1));
+              ap_args += LOG_ALIGN_UP (p_arg->len + 1);
+            }
+            break;
+          case ELogArgPointer:
+            {
+              strcat (fmt, "p");
+              n = LOG_SNPRINTF (ap_buf + len, a_size - len, fmt, spec.nstars,
+                                stars, p_arg->p);
+            }
+            break;
+          default:
+            assert (0);
+            break;
+        };
+
+      if (n < 0)
+        {
+          break;
+        }
+      len += MIN ((size_t) n, a_size - 1 - len);
+    }
+
+  ap_buf[len] = '\0';
+}
+
+/*
+ * Per-thread rings
+ */
+
+static inline void
+log_wake_logger (void)
+{
+  if (__atomic_exchange_n (&g_log.sleeping, 0, __ATOMIC_SEQ_CST))
+    {
+      (void) __atomic_add_fetch (&g_log.futex, 1, __ATOMIC_SEQ_CST);
+      (void) syscall (SYS_futex, &g_log.futex, FUTEX_WAKE_PRIVATE, 1, NULL,
+                      NULL, 0);
+    }
+}
+
+static void
+log_ring_release (void * ap_ring)
+{
+  /* Called on thread exit; the logging thread frees the ring once it has
+     drained it */
+  log_store (&((log_ring_t *) ap_ring)->orphaned, true);
+}
+
+static log_ring_t *
+log_thread_ring (void)
+{
+  const uint32_t generation = log_load (&g_log.generation);
+  log_ring_t * p_ring = NULL;
+
+  if (tp_ring && t_ring_generation == generation)
+    {
+      return tp_ring;
+    }
+
+  if (0 != posix_memalign ((void **) &p_ring, LOG_CACHE_LINE_SIZE,
+                           sizeof (log_ring_t) + LOG_RING_SIZE))
+    {
+      return NULL;
+    }
+  memset (p_ring, 0, sizeof (log_ring_t));
+  p_ring->p_data = (unsigned char *) p_ring + sizeof (log_ring_t);
+  p_ring->tid = log_tid ();
+
+  (void) pthread_mutex_lock (&g_log.mutex);
+  if (!g_log.running || generation != g_log.generation)
+    {
+      (void) pthread_mutex_unlock (&g_log.mutex);
+      free (p_ring);
+      return NULL;
+    }
+  p_ring->p_next = g_log.p_rings;
+  g_log.p_rings = p_ring;
+  (void) pthread_setspecific (g_log.key, p_ring);
+  (void) pthread_mutex_unlock (&g_log.mutex);
+
+  tp_ring = p_ring;
+  t_ring_generation = generation;
+  return p_ring;
+}
+
+static log_record_t *
+log_ring_reserve (log_ring_t * ap_ring, int a_priority)
+{
+  for (;;)
+    {
+      const uint64_t head = ap_ring->head;
+      const uint64_t tail = log_load (&ap_ring->tail);
+      const size_t pos = head & (LOG_RING_SIZE - 1);
+      const size_t contig = LOG_RING_SIZE - pos;
+      const size_t needed
+        = LOG_MAX_RECORD + (contig < LOG_MAX_RECORD ? contig : 0);
+
+      if (LOG_RING_SIZE - (head - tail) >= needed)
+        {
+          if (contig < LOG_MAX_RECORD)
+            {
+              /* Records are never split: skip the end of the ring */
+              log_record_t * p_pad = (log_record_t *) (ap_ring->p_data + pos);
+              p_pad->size = contig;
+              p_pad->flags = LOG_RECORD_PAD;
+              log_store (&ap_ring->head, head + contig);
+              return (log_record_t *) ap_ring->p_data;
+            }
+          return (log_record_t *) (ap_ring->p_data + pos);
+        }
+
+      if (a_priority > TIZ_PRIORITY_WARN)
+        {
+          ++ap_ring->dropped;
+          log_wake_logger ();
+          return NULL;
+        }
+
+      /* Errors and warnings are never dropped */
+      log_wake_logger ();
+      (void) sched_yield ();
+    }
+}
+
+static inline void
+log_ring_commit (log_ring_t * ap_ring, const log_record_t * ap_rec)
+{
+  const uint64_t head = ap_ring->head + ap_rec->size;
+  log_store (&ap_ring->head, head);
+  /* Less severe messages are left for the periodic flush, unless the ring is
+     filling up, which saves the wake-up system call in the common case */
+  if (ap_rec->priority <= TIZ_PRIORITY_WARN
+      || head - __atomic_load_n (&ap_ring->tail, __ATOMIC_RELAXED)
+           > LOG_RING_SIZE / 4)
+    {
+      /* Pairs with the fence in the logging thread, before it parks */
+      log_fence ();
+      log_wake_logger ();
+    }
+}
+
+static bool
+log_async (const char * ap_file, int a_line, const char * ap_func,
+           const log4c_category_t * ap_category, int a_priority,
+           const char * ap_cname, const char * ap_format, va_list a_va)
+{
+  log_ring_t * p_ring = log_thread_ring ();
+  log_record_t * p_rec = NULL;
+  unsigned char * p_args = NULL;
+  log_writer_t w;
+  va_list va;
+  bool captured = false;
+
+  if (NULL == p_ring)
+    {
+      return false;
+    }
+
+  if (NULL == (p_rec = log_ring_reserve (p_ring, a_priority)))
+    {
+      /* Dropped */
+      return true;
+    }
+
+  (void) gettimeofday (&p_rec->timestamp, NULL);
+  p_rec->flags = 0;
+  p_rec->priority = a_priority;
+  p_rec->line = a_line;
+  p_rec->tid = p_ring->tid;
+  p_rec->p_category = ap_category;
+
+  w.p_cur = (unsigned char *) p_rec + LOG_RECORD_HDR_SIZE;
+  w.p_end = (unsigned char *) p_rec + LOG_MAX_RECORD;
+
+  (void) log_put_cstr (&w, ap_file, LOG_MAX_LOC);
+  (void) log_put_cstr (&w, ap_func, LOG_MAX_LOC);
+  if (ap_cname)
+    {
+      (void) log_put_cstr (&w, ap_cname, OMX_MAX_STRINGNAME_SIZE);
+      p_rec->flags |= LOG_RECORD_CNAME;
+    }
+
+  p_args = w.p_cur;
+  if (ap_format && log_put_cstr (&w, ap_format, LOG_MAX_MSG))
+    {
+      va_copy (va, a_va);
+      captured = log_capture_args (&w, ap_format, va);
+      va_end (va);
+    }
+
+  if (!captured)
+    {
+      /* Unsupported conversions, or too much data: format the message
+         here */
+      const size_t room = w.p_end - p_args;
+      int len = 0;
+      if (ap_format)
+        {
+          len = vsnprintf ((char *) p_args, room, ap_format, a_va);
+        }
+      len = (len < 0) ? 0 : MIN ((size_t) len, room - 1);
+      p_args[len] = '\0';
+      w.p_cur = p_args + LOG_ALIGN_UP (len + 1);
+      p_rec->flags |= LOG_RECORD_TEXT;
+    }
+
+  p_rec->size = w.p_cur - (unsigned char *) p_rec;
+  log_ring_commit (p_ring, p_rec);
+  return true;
+}
+
+/*
+ * The logging thread
+ */
+
+static void
+log_emit (const log4c_category_t * ap_category, int a_priority, int a_tid,
+          const char * ap_file, int a_line, const char * ap_func,
+          const char * ap_cname, const struct timeval * ap_timestamp,
+          const char * ap_msg)
+{
+  log4c_location_info_t locinfo;
+  user_locinfo_t user_locinfo;
+
+  user_locinfo.pid = log_pid ();
+  user_locinfo.tid = a_tid;
+  user_locinfo.cname = ap_cname;
+  user_locinfo.cbuf = g_log.cbuf;
+  user_locinfo.p_timestamp = ap_timestamp;
+  locinfo.loc_file = ap_file;
+  locinfo.loc_line = a_line;
+  locinfo.loc_function = ap_func;
+  locinfo.loc_data = &user_locinfo;
+
+  log4c_category_log_locinfo (ap_category, &locinfo, a_priority, "%s",
+                              ap_msg);
+}
+
+static void
+log_emit_record (const log_record_t * ap_rec)
+{
+  const unsigned char * p_payload
+    = (const unsigned char *) ap_rec + LOG_RECORD_HDR_SIZE;
+  const char * p_file = NULL;
+  const char * p_func = NULL;
+  const char * p_cname = NULL;
+  const char * p_msg = g_log.msg;
+
+  p_payload = log_get_cstr (p_payload, &p_file);
+  p_payload = log_get_cstr (p_payload, &p_func);
+  if (ap_rec->flags & LOG_RECORD_CNAME)
+    {
+      p_payload = log_get_cstr (p_payload, &p_cname);
+    }
+
+  if (ap_rec->flags & LOG_RECORD_TEXT)
+    {
+      p_msg = (const char *) p_payload;
+    }
+  else
+    {
+      const char * p_format = NULL;
+      p_payload = log_get_cstr (p_payload, &p_format);
+      log_format_args (p_format, p_payload, g_log.msg, sizeof (g_log.msg));
+    }
+
+  log_emit (ap_rec->p_category, ap_rec->priority, ap_rec->tid, p_file,
+            ap_rec->line, p_func, p_cname, &ap_rec->timestamp, p_msg);
+}
+
+static bool
+log_ring_drain (log_ring_t * ap_ring)
+{
+  const uint64_t head = log_load (&ap_ring->head);
+  const uint64_t dropped = __atomic_load_n (&ap_ring->dropped,
+                                            __ATOMIC_RELAXED);
+  uint64_t tail = ap_ring->tail;
+  bool drained = false;
+
+  while (tail != head)
+    {
+      const log_record_t * p_rec
+        = (const log_record_t *) (ap_ring->p_data
+                                  + (tail & (LOG_RING_SIZE - 1)));
+      if (!(p_rec->flags & LOG_RECORD_PAD))
+        {
+          log_emit_record (p_rec);
+        }
+      tail += p_rec->size;
+      /* Make room as soon as possible, a producer may be waiting */
+      log_store (&ap_ring->tail, tail);
+      drained = true;
+    }
+
+  if (dropped != ap_ring->reported)
+    {
+      char msg[64];
+      snprintf (msg, sizeof (msg), "%llu log messages dropped",
+                (unsigned long long) (dropped - ap_ring->reported));
+      log_emit (log_category_get (TIZ_LOG_CATEGORY_NAME), TIZ_PRIORITY_WARN,
+                ap_ring->tid, __FILE__, __LINE__, __FUNCTION__, NULL, NULL,
+                msg);
+      ap_ring->reported = dropped;
+    }
+
+  return drained;
+}
+
+static bool
+log_drain_all (void)
+{
+  log_ring_t ** pp_ring = NULL;
+  bool drained = false;
+
+  (void) pthread_mutex_lock (&g_log.mutex);
+  pp_ring = &g_log.p_rings;
+  while (*pp_ring)
+    {
+      log_ring_t * p_ring = *pp_ring;
+      const bool orphaned = log_load (&p_ring->orphaned);
+      drained |= log_ring_drain (p_ring);
+      if (orphaned)
+        {
+          /* The owner is gone, and nothing else will be written here */
+          *pp_ring = p_ring->p_next;
+          free (p_ring);
+          continue;
+        }
+      pp_ring = &p_ring->p_next;
+    }
+  (void) pthread_mutex_unlock (&g_log.mutex);
+
+  return drained;
+}
+
+static bool
+log_pending (void)
+{
+  log_ring_t * p_ring = NULL;
+  bool pending = false;
+
+  (void) pthread_mutex_lock (&g_log.mutex);
+  for (p_ring = g_log.p_rings; p_ring && !pending; p_ring = p_ring->p_next)
+    {
+      pending = (log_load (&p_ring->head) != p_ring->tail)
+                || log_load (&p_ring->orphaned);
+    }
+  (void) pthread_mutex_unlock (&g_log.mutex);
+
+  return pending;
+}
+
+static void *
+log_thread_func (void * ap_arg)
+{
+  (void) ap_arg;
+
+  for (;;)
+    {
+      uint32_t futex = 0;
+
+      if (log_drain_all ())
+        {
+          continue;
+        }
+
+      if (log_load (&g_log.stop))
+        {
+          break;
+        }
+
+      futex = log_load (&g_log.futex);
+      __atomic_store_n (&g_log.sleeping, 1, __ATOMIC_SEQ_CST);
+      log_fence ();
+      if (!log_pending () && !log_load (&g_log.stop))
+        {
+          const struct timespec timeout
+            = {0, LOG_FLUSH_INTERVAL_MS * 1000000L};
+          (void) syscall (SYS_futex, &g_log.futex, FUTEX_WAIT_PRIVATE, futex,
+                          &timeout, NULL, 0);
+        }
+      __atomic_store_n (&g_log.sleeping, 0, __ATOMIC_SEQ_CST);
+    }
+
+  return NULL;
+}
+
+static void
+log_atfork_child (void)
+{
+  /* Only the forking thread survives, and the logging thread is not one of
+     them: go back to synchronous logging in the child */
+  g_pid = 0;
+  t_tid = 0;
+  tp_ring = NULL;
+  g_log.running = false;
+  g_log.p_rings = NULL;
+  ++g_log.generation;
+  (void) pthread_mutex_init (&g_log.mutex, NULL);
+  (void) pthread_mutex_init (&g_categories_mutex, NULL);
+}
+
+static void
+log_register_atfork (void)
+{
+  (void) pthread_atfork (NULL, NULL, log_atfork_child);
+}
+
+static bool
+log_async_configured (void)
+{
+  const char * p_env = getenv ("TIZONIA_LOG_ASYNC");
+  bool async = false;
+
+  if (p_env)
+    {
+      async = (0 == strcmp (p_env, "true") || 0 == strcmp (p_env, "1"));
+    }
+  else
+    {
+      /* The event loop has not loaded the config file yet */
+      tiz_rcfile_t * p_rcfile = NULL;
+      if (OMX_ErrorNone == tiz_rcfile_init (&p_rcfile) && p_rcfile)
+        {
+          const char * p_value = tiz_rcfile_find_value (p_rcfile, "log-async");
+          async = (p_value && 0 == strcmp (p_value, "true"));
+        }
+      if (p_rcfile)
+        {
+          tiz_rcfile_destroy (p_rcfile);
+        }
+    }
+
+  return async;
+}
+
+static void
+log_async_start (void)
+{
+  (void) pthread_once (&g_atfork_once, log_register_atfork);
+
+  (void) pthread_mutex_lock (&g_log.mutex);
+  if (!g_log.running && 0 == pthread_key_create (&g_log.key, log_ring_release))
+    {
+      g_log.stop = false;
+      g_log.sleeping = 0;
+      if (0 == pthread_create (&g_log.thread, NULL, log_thread_func, NULL))
+        {
+          log_store (&g_log.running, true);
+        }
+      else
+        {
+          (void) pthread_key_delete (g_log.key);
+        }
+    }
+  (void) pthread_mutex_unlock (&g_log.mutex);
+}
+
+static void
+log_async_stop (void)
+{
+  log_ring_t * p_ring = NULL;
+
+  if (!log_load (&g_log.running))
+    {
+      return;
+    }
+
+  /* From now on, the callers log synchronously */
+  (void) pthread_mutex_lock (&g_log.mutex);
+  log_store (&g_log.running, false);
+  (void) __atomic_add_fetch (&g_log.generation, 1, __ATOMIC_SEQ_CST);
+  (void) pthread_mutex_unlock (&g_log.mutex);
+
+  /* The logging thread drains all the rings before exiting */
+  log_store (&g_log.stop, true);
+  (void) __atomic_add_fetch (&g_log.futex, 1, __ATOMIC_SEQ_CST);
+  (void) syscall (SYS_futex, &g_log.futex, FUTEX_WAKE_PRIVATE, 1, NULL, NULL,
+                  0);
+  (void) pthread_join (g_log.thread, NULL);
+
+  (void) pthread_mutex_lock (&g_log.mutex);
+  while (NULL != (p_ring = g_log.p_rings))
+    {
+      g_log.p_rings = p_ring->p_next;
+      free (p_ring);
+    }
+  /* The destructors of the threads that are still alive will not run */
+  (void) pthread_key_delete (g_log.key);
+  (void) pthread_mutex_unlock (&g_log.mutex);
+}
+
+#endif /* WITHOUT_LOG4C */
+
 int
 tiz_log_init (void)
 {
 #ifndef WITHOUT_LOG4C
+  int rc = 0;
   log_formatters_init ();
-  return log4c_init ();
+  rc = log4c_init ();
+  if (log_async_configured ())
+    {
+      log_async_start ();
+    }
+  return rc;
 #else
   return 0;
 #endif
@@ -197,42 +1414,61 @@ int
 tiz_log_deinit (void)
 {
 #ifndef WITHOUT_LOG4C
+  log_async_stop ();
+  log_category_cache_clear ();
   return log4c_fini ();
 #else
   return 0;
 #endif
 }
 
+int
+tiz_log_is_enabled (const char * ap_cat_name, int a_priority)
+{
+#ifndef WITHOUT_LOG4C
+  return log4c_category_is_priority_enabled (log_category_get (ap_cat_name),
+                                             a_priority);
+#else
+  (void) ap_cat_name;
+  (void) a_priority;
+  return 1;
+#endif
+}
+
 void
 tiz_log (const char * ap_file, int a_line, const char * ap_func,
          const char * ap_cat_name, int a_priority, const char * ap_cname,
          char * ap_cbuf, const char * ap_format, ...)
 {
 #ifndef WITHOUT_LOG4C
-  log4c_location_info_t locinfo;
-  user_locinfo_t user_locinfo;
-
-  const log4c_category_t * p_category = log4c_category_get (ap_cat_name);
+  const log4c_category_t * p_category = log_category_get (ap_cat_name);
   if (log4c_category_is_priority_enabled (p_category, a_priority))
     {
-      /* TODO: 4096 - this value should be obtained at config time */
-      char * buffer = alloca (4096);
-      user_locinfo.pid = getpid ();
-      user_locinfo.tid = syscall (SYS_gettid);
-      user_locinfo.cname = ap_cname;
-      user_locinfo.cbuf = ap_cbuf;
-      locinfo.loc_file = ap_file;
-      locinfo.loc_line = a_line;
-      locinfo.loc_function = ap_func;
-      /*          locinfo.loc_data = NULL; */
-      locinfo.loc_data = &user_locinfo;
-
       va_list va;
       va_start (va, ap_format);
-      vsprintf (buffer, ap_format, va);
+      if (!log_load (&g_log.running)
+          || !log_async (ap_file, a_line, ap_func, p_category, a_priority,
+                         ap_cname, ap_format, va))
+        {
+          char buffer[LOG_MAX_MSG];
+          log4c_location_info_t locinfo;
+          user_locinfo_t user_locinfo;
+
+          user_locinfo.pid = log_pid ();
+          user_locinfo.tid = log_tid ();
+          user_locinfo.cname = ap_cname;
+          user_locinfo.cbuf = ap_cbuf;
+          user_locinfo.p_timestamp = NULL;
+          locinfo.loc_file = ap_file;
+          locinfo.loc_line = a_line;
+          locinfo.loc_function = ap_func;
+          locinfo.loc_data = &user_locinfo;
+
+          (void) vsnprintf (buffer, sizeof (buffer), ap_format, va);
+          log4c_category_log_locinfo (p_category, &locinfo, a_priority, "%s",
+                                      buffer);
+        }
       va_end (va);
-      log4c_category_log_locinfo (p_category, &locinfo, a_priority, "%s",
-                                  buffer);
     }
 #else
 
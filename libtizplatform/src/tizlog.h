@@ -41,10 +41,6 @@ extern "C" {
 
 /* #define WITHOUT_LOG4C 1 */
 
-#define TIZ_LOG(priority, format, args...)                                    \
-  tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME, priority, \
-           NULL, NULL, format, ##args);
-
 #ifndef WITHOUT_LOG4C
 #define TIZ_PRIORITY_ERROR LOG4C_PRIORITY_ERROR
 #define TIZ_PRIORITY_WARN LOG4C_PRIORITY_WARN
@@ -59,6 +55,33 @@ extern "C" {
 #define TIZ_PRIORITY_TRACE 5
 #endif
 
+/* Least severe priority that is compiled in. E.g. build with
+   -DTIZ_LOG_COMPILE_PRIORITY=TIZ_PRIORITY_DEBUG to remove all the trace
+   messages (including the evaluation of their arguments) from the
+   binaries */
+#ifndef TIZ_LOG_COMPILE_PRIORITY
+#define TIZ_LOG_COMPILE_PRIORITY TIZ_PRIORITY_TRACE
+#endif
+
+#define TIZ_LOG_ENABLED(priority) ((priority) <= TIZ_LOG_COMPILE_PRIORITY)
+
+/* The arguments are only evaluated when the priority is enabled, both at
+   compile time and in the log4c configuration */
+#define TIZ_LOG_IF(priority, cname, cbuf, format, args...)                   \
+  do                                                                         \
+    {                                                                        \
+      if (TIZ_LOG_ENABLED (priority)                                         \
+          && tiz_log_is_enabled (TIZ_LOG_CATEGORY_NAME, priority))           \
+        {                                                                    \
+          tiz_log (__FILE__, __LINE__, __FUNCTION__, TIZ_LOG_CATEGORY_NAME,  \
+                   priority, cname, cbuf, format, ##args);                   \
+        }                                                                    \
+    }                                                                        \
+  while (0)
+
+#define TIZ_LOG(priority, format, args...) \
+  TIZ_LOG_IF (priority, NULL, NULL, format, ##args);
+
 int
 tiz_log_init (void);
 void
@@ -66,6 +89,8 @@ tiz_log_set_unique_rolling_file (const char * ap_logdir,
                                  const char * ap_file_prefix);
 int
 tiz_log_deinit (void);
+int
+tiz_log_is_enabled (const char * __p_cat_name, int __priority);
 void
 tiz_log (const char * __p_file, int __line, const char * __p_func,
          const char * __p_cat_name, int __priority,
@@ -653,6 +653,10 @@ static const tiz_idx_str_t tiz_idx_to_str_tbl[] = {
    (const OMX_STRING) "OMX_TizoniaIndexParamAudioDeezerSession"},
   {OMX_TizoniaIndexParamAudioDeezerPlaylist,
    (const OMX_STRING) "OMX_TizoniaIndexParamAudioDeezerPlaylist"},
+  {OMX_TizoniaIndexConfigPerfCounters,
+   (const OMX_STRING) "OMX_TizoniaIndexConfigPerfCounters"},
+  {OMX_TizoniaIndexConfigNextContentURI,
+   (const OMX_STRING) "OMX_TizoniaIndexConfigNextContentURI"},
   {OMX_IndexKhronosExtensions, (const OMX_STRING) "OMX_IndexKhronosExtensions"},
   {OMX_IndexVendorStartUnused, (const OMX_STRING) "OMX_IndexVendorStartUnused"},
   {OMX_IndexMax, (const OMX_STRING) "OMX_IndexMax"}};
@@ -0,0 +1,1195 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizpcm.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM sample processing kernels
+ *
+ * The 16-bit and float kernels have SSE2, AVX2 (x86) and NEON (ARM)
+ * versions; the x86 versions are picked at run time. Interleaving has SSE2
+ * and NEON versions for stereo, the common case; other channel counts, and
+ * packed 24-bit output, use the scalar code. 24 and 32-bit integer
+ * gain is computed in double precision by the scalar code, as single
+ * precision floats would truncate the samples. Float-to-integer conversions
+ * truncate in all versions, so that they all produce the same output.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TIZ_PCM_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TIZ_PCM_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.pcm"
+#endif
+
+#define PCM_S16_MIN -32768.0f
+#define PCM_S16_MAX 32767.0f
+#define PCM_S24_MIN -8388608.0
+#define PCM_S24_MAX 8388607.0
+#define PCM_S32_MIN -2147483648.0
+#define PCM_S32_MAX 2147483647.0
+
+typedef void (*pcm_gain_f) (void * ap_buf, size_t a_n, float a_gain);
+typedef void (*pcm_unary_f) (void * ap_buf, size_t a_n);
+typedef void (*pcm_ilv2_s32_f) (void * ap_to, const int32_t * ap_l,
+                                const int32_t * ap_r, size_t a_n, int a_shift);
+typedef void (*pcm_ilv2_i2f_f) (float * ap_to, const int32_t * ap_l,
+                                const int32_t * ap_r, size_t a_n,
+                                float a_scale);
+typedef void (*pcm_ilv2_f32_f) (float * ap_to, const float * ap_l,
+                                const float * ap_r, size_t a_n);
+
+typedef struct pcm_kernels pcm_kernels_t;
+struct pcm_kernels
+{
+  pcm_gain_f pf_gain_s16;
+  pcm_gain_f pf_gain_f32;
+  pcm_unary_f pf_clip_f32;
+  pcm_unary_f pf_swap16;
+  pcm_unary_f pf_swap32;
+  pcm_ilv2_s32_f pf_ilv2_s16;
+  pcm_ilv2_s32_f pf_ilv2_s32;
+  pcm_ilv2_i2f_f pf_ilv2_i2f;
+  pcm_ilv2_f32_f pf_ilv2_f32;
+};
+
+static pthread_once_t g_pcm_once = PTHREAD_ONCE_INIT;
+static tiz_pcm_isa_t g_pcm_isa = ETIZPcmIsaScalar;
+static pcm_kernels_t g_pcm
+  = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+
+static const char * pcm_isa_names[] = {"scalar", "sse2", "avx2", "neon"};
+
+static inline float
+clampf (const float a_val, const float a_min, const float a_max)
+{
+  return a_val < a_min ? a_min : (a_val > a_max ? a_max : a_val);
+}
+
+static inline double
+clampd (const double a_val, const double a_min, const double a_max)
+{
+  return a_val < a_min ? a_min : (a_val > a_max ? a_max : a_val);
+}
+
+/*
+ * Scalar kernels
+ */
+
+static void
+gain_s16_scalar (void * ap_buf, size_t a_n, float a_gain)
+{
+  int16_t * p = ap_buf;
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      p[i] = (int16_t) clampf ((float) p[i] * a_gain, PCM_S16_MIN, PCM_S16_MAX);
+    }
+}
+
+static void
+gain_f32_scalar (void * ap_buf, size_t a_n, float a_gain)
+{
+  float * p = ap_buf;
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      p[i] = clampf (p[i] * a_gain, -1.0f, 1.0f);
+    }
+}
+
+static void
+clip_f32_scalar (void * ap_buf, size_t a_n)
+{
+  float * p = ap_buf;
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      p[i] = clampf (p[i], -1.0f, 1.0f);
+    }
+}
+
+static void
+swap16_scalar (void * ap_buf, size_t a_n)
+{
+  uint16_t * p = ap_buf;
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      p[i] = __builtin_bswap16 (p[i]);
+    }
+}
+
+static void
+swap32_scalar (void * ap_buf, size_t a_n)
+{
+  uint32_t * p = ap_buf;
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      p[i] = __builtin_bswap32 (p[i]);
+    }
+}
+
+static void
+swap24 (void * ap_buf, size_t a_n)
+{
+  uint8_t * p = ap_buf;
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i, p += 3)
+    {
+      const uint8_t b = p[0];
+      p[0] = p[2];
+      p[2] = b;
+    }
+}
+
+static inline int32_t
+load_s24 (const uint8_t * ap_sample)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  const uint32_t u = ((uint32_t) ap_sample[0] << 24)
+                     | ((uint32_t) ap_sample[1] << 16)
+                     | ((uint32_t) ap_sample[2] << 8);
+#else
+  const uint32_t u = ((uint32_t) ap_sample[2] << 24)
+                     | ((uint32_t) ap_sample[1] << 16)
+                     | ((uint32_t) ap_sample[0] << 8);
+#endif
+  return ((int32_t) u) >> 8;
+}
+
+static inline void
+store_s24 (uint8_t * ap_sample, const int32_t a_val)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  ap_sample[0] = (uint8_t) (a_val >> 16);
+  ap_sample[1] = (uint8_t) (a_val >> 8);
+  ap_sample[2] = (uint8_t) a_val;
+#else
+  ap_sample[0] = (uint8_t) a_val;
+  ap_sample[1] = (uint8_t) (a_val >> 8);
+  ap_sample[2] = (uint8_t) (a_val >> 16);
+#endif
+}
+
+static void
+gain_s24 (void * ap_buf, size_t a_n, float a_gain)
+{
+  uint8_t * p = ap_buf;
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i, p += 3)
+    {
+      store_s24 (p, (int32_t) clampd ((double) load_s24 (p) * a_gain,
+                                      PCM_S24_MIN, PCM_S24_MAX));
+    }
+}
+
+static void
+gain_s32 (void * ap_buf, size_t a_n, float a_gain)
+{
+  int32_t * p = ap_buf;
+  size_t i = 0;
+  for (i = 0; i < a_n; ++i)
+    {
+      p[i] = (int32_t) clampd ((double) p[i] * a_gain, PCM_S32_MIN,
+                               PCM_S32_MAX);
+    }
+}
+
+/*
+ * Interleaving (any number of channels). A positive shift moves the
+ * significant bits of the source samples up, a negative one down.
+ */
+
+static inline int32_t
+shift_s32 (const int32_t a_val, const int a_shift)
+{
+  return a_shift >= 0 ? (int32_t) ((uint32_t) a_val << a_shift)
+                      : a_val >> -a_shift;
+}
+
+static void
+ilv_s16 (void * ap_to, const int32_t * const * app_from, size_t a_nch,
+         size_t a_first, size_t a_n, int a_shift)
+{
+  int16_t * p = ap_to;
+  size_t i = 0;
+  size_t c = 0;
+  for (i = a_first; i < a_first + a_n; ++i)
+    {
+      for (c = 0; c < a_nch; ++c)
+        {
+          *p++ = (int16_t) shift_s32 (app_from[c][i], a_shift);
+        }
+    }
+}
+
+static void
+ilv_s24 (void * ap_to, const int32_t * const * app_from, size_t a_nch,
+         size_t a_first, size_t a_n, int a_shift)
+{
+  uint8_t * p = ap_to;
+  size_t i = 0;
+  size_t c = 0;
+  for (i = a_first; i < a_first + a_n; ++i)
+    {
+      for (c = 0; c < a_nch; ++c, p += 3)
+        {
+          store_s24 (p, shift_s32 (app_from[c][i], a_shift));
+        }
+    }
+}
+
+static void
+ilv_s32 (void * ap_to, const int32_t * const * app_from, size_t a_nch,
+         size_t a_first, size_t a_n, int a_shift)
+{
+  int32_t * p = ap_to;
+  size_t i = 0;
+  size_t c = 0;
+  for (i = a_first; i < a_first + a_n; ++i)
+    {
+      for (c = 0; c < a_nch; ++c)
+        {
+          *p++ = shift_s32 (app_from[c][i], a_shift);
+        }
+    }
+}
+
+static void
+ilv_i2f (float * ap_to, const int32_t * const * app_from, size_t a_nch,
+         size_t a_first, size_t a_n, float a_scale)
+{
+  float * p = ap_to;
+  size_t i = 0;
+  size_t c = 0;
+  for (i = a_first; i < a_first + a_n; ++i)
+    {
+      for (c = 0; c < a_nch; ++c)
+        {
+          *p++ = (float) app_from[c][i] * a_scale;
+        }
+    }
+}
+
+static void
+ilv_f32 (float * ap_to, const float * const * app_from, size_t a_nch,
+         size_t a_first, size_t a_n)
+{
+  float * p = ap_to;
+  size_t i = 0;
+  size_t c = 0;
+  for (i = a_first; i < a_first + a_n; ++i)
+    {
+      for (c = 0; c < a_nch; ++c)
+        {
+          *p++ = app_from[c][i];
+        }
+    }
+}
+
+static void
+ilv2_s16_scalar (void * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+                 size_t a_n, int a_shift)
+{
+  const int32_t * from[2] = {ap_l, ap_r};
+  ilv_s16 (ap_to, from, 2, 0, a_n, a_shift);
+}
+
+static void
+ilv2_s32_scalar (void * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+                 size_t a_n, int a_shift)
+{
+  const int32_t * from[2] = {ap_l, ap_r};
+  ilv_s32 (ap_to, from, 2, 0, a_n, a_shift);
+}
+
+static void
+ilv2_i2f_scalar (float * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+                 size_t a_n, float a_scale)
+{
+  const int32_t * from[2] = {ap_l, ap_r};
+  ilv_i2f (ap_to, from, 2, 0, a_n, a_scale);
+}
+
+static void
+ilv2_f32_scalar (float * ap_to, const float * ap_l, const float * ap_r,
+                 size_t a_n)
+{
+  const float * from[2] = {ap_l, ap_r};
+  ilv_f32 (ap_to, from, 2, 0, a_n);
+}
+
+/*
+ * SSE2 kernels
+ */
+
+#ifdef TIZ_PCM_X86
+
+__attribute__ ((target ("sse2"))) static void
+gain_s16_sse2 (void * ap_buf, size_t a_n, float a_gain)
+{
+  int16_t * p = ap_buf;
+  const __m128 g = _mm_set1_ps (a_gain);
+  const __m128 lo = _mm_set1_ps (PCM_S16_MIN);
+  const __m128 hi = _mm_set1_ps (PCM_S16_MAX);
+  size_t i = 0;
+
+  for (; i + 8 <= a_n; i += 8)
+    {
+      const __m128i v = _mm_loadu_si128 ((const __m128i *) (p + i));
+      /* Sign-extend to 32 bits */
+      __m128i v0 = _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16);
+      __m128i v1 = _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16);
+      __m128 f0 = _mm_mul_ps (_mm_cvtepi32_ps (v0), g);
+      __m128 f1 = _mm_mul_ps (_mm_cvtepi32_ps (v1), g);
+      f0 = _mm_min_ps (_mm_max_ps (f0, lo), hi);
+      f1 = _mm_min_ps (_mm_max_ps (f1, lo), hi);
+      v0 = _mm_cvttps_epi32 (f0);
+      v1 = _mm_cvttps_epi32 (f1);
+      _mm_storeu_si128 ((__m128i *) (p + i), _mm_packs_epi32 (v0, v1));
+    }
+
+  gain_s16_scalar (p + i, a_n - i, a_gain);
+}
+
+__attribute__ ((target ("sse2"))) static void
+gain_f32_sse2 (void * ap_buf, size_t a_n, float a_gain)
+{
+  float * p = ap_buf;
+  const __m128 g = _mm_set1_ps (a_gain);
+  const __m128 lo = _mm_set1_ps (-1.0f);
+  const __m128 hi = _mm_set1_ps (1.0f);
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4)
+    {
+      const __m128 f = _mm_mul_ps (_mm_loadu_ps (p + i), g);
+      _mm_storeu_ps (p + i, _mm_min_ps (_mm_max_ps (f, lo), hi));
+    }
+
+  gain_f32_scalar (p + i, a_n - i, a_gain);
+}
+
+__attribute__ ((target ("sse2"))) static void
+clip_f32_sse2 (void * ap_buf, size_t a_n)
+{
+  float * p = ap_buf;
+  const __m128 lo = _mm_set1_ps (-1.0f);
+  const __m128 hi = _mm_set1_ps (1.0f);
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4)
+    {
+      const __m128 f = _mm_loadu_ps (p + i);
+      _mm_storeu_ps (p + i, _mm_min_ps (_mm_max_ps (f, lo), hi));
+    }
+
+  clip_f32_scalar (p + i, a_n - i);
+}
+
+__attribute__ ((target ("sse2"))) static void
+swap16_sse2 (void * ap_buf, size_t a_n)
+{
+  uint16_t * p = ap_buf;
+  size_t i = 0;
+
+  for (; i + 8 <= a_n; i += 8)
+    {
+      const __m128i v = _mm_loadu_si128 ((const __m128i *) (p + i));
+      _mm_storeu_si128 ((__m128i *) (p + i),
+                        _mm_or_si128 (_mm_slli_epi16 (v, 8),
+                                      _mm_srli_epi16 (v, 8)));
+    }
+
+  swap16_scalar (p + i, a_n - i);
+}
+
+__attribute__ ((target ("sse2"))) static void
+swap32_sse2 (void * ap_buf, size_t a_n)
+{
+  uint32_t * p = ap_buf;
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (p + i));
+      /* Swap the bytes in each 16-bit half, then swap the halves */
+      v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+      v = _mm_shufflelo_epi16 (v, _MM_SHUFFLE (2, 3, 0, 1));
+      v = _mm_shufflehi_epi16 (v, _MM_SHUFFLE (2, 3, 0, 1));
+      _mm_storeu_si128 ((__m128i *) (p + i), v);
+    }
+
+  swap32_scalar (p + i, a_n - i);
+}
+
+__attribute__ ((target ("sse2"))) static inline __m128i
+shift_epi32_sse2 (const __m128i a_v, const int a_shift)
+{
+  return a_shift >= 0 ? _mm_sll_epi32 (a_v, _mm_cvtsi32_si128 (a_shift))
+                      : _mm_sra_epi32 (a_v, _mm_cvtsi32_si128 (-a_shift));
+}
+
+__attribute__ ((target ("sse2"))) static void
+ilv2_s16_sse2 (void * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+               size_t a_n, int a_shift)
+{
+  int16_t * p = ap_to;
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4, p += 8)
+    {
+      const __m128i l = shift_epi32_sse2 (
+        _mm_loadu_si128 ((const __m128i *) (ap_l + i)), a_shift);
+      const __m128i r = shift_epi32_sse2 (
+        _mm_loadu_si128 ((const __m128i *) (ap_r + i)), a_shift);
+      _mm_storeu_si128 ((__m128i *) p,
+                        _mm_packs_epi32 (_mm_unpacklo_epi32 (l, r),
+                                         _mm_unpackhi_epi32 (l, r)));
+    }
+
+  ilv2_s16_scalar (p, ap_l + i, ap_r + i, a_n - i, a_shift);
+}
+
+__attribute__ ((target ("sse2"))) static void
+ilv2_s32_sse2 (void * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+               size_t a_n, int a_shift)
+{
+  int32_t * p = ap_to;
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4, p += 8)
+    {
+      const __m128i l = shift_epi32_sse2 (
+        _mm_loadu_si128 ((const __m128i *) (ap_l + i)), a_shift);
+      const __m128i r = shift_epi32_sse2 (
+        _mm_loadu_si128 ((const __m128i *) (ap_r + i)), a_shift);
+      _mm_storeu_si128 ((__m128i *) p, _mm_unpacklo_epi32 (l, r));
+      _mm_storeu_si128 ((__m128i *) (p + 4), _mm_unpackhi_epi32 (l, r));
+    }
+
+  ilv2_s32_scalar (p, ap_l + i, ap_r + i, a_n - i, a_shift);
+}
+
+__attribute__ ((target ("sse2"))) static void
+ilv2_i2f_sse2 (float * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+               size_t a_n, float a_scale)
+{
+  float * p = ap_to;
+  const __m128 g = _mm_set1_ps (a_scale);
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4, p += 8)
+    {
+      const __m128 l = _mm_mul_ps (
+        _mm_cvtepi32_ps (_mm_loadu_si128 ((const __m128i *) (ap_l + i))), g);
+      const __m128 r = _mm_mul_ps (
+        _mm_cvtepi32_ps (_mm_loadu_si128 ((const __m128i *) (ap_r + i))), g);
+      _mm_storeu_ps (p, _mm_unpacklo_ps (l, r));
+      _mm_storeu_ps (p + 4, _mm_unpackhi_ps (l, r));
+    }
+
+  ilv2_i2f_scalar (p, ap_l + i, ap_r + i, a_n - i, a_scale);
+}
+
+__attribute__ ((target ("sse2"))) static void
+ilv2_f32_sse2 (float * ap_to, const float * ap_l, const float * ap_r,
+               size_t a_n)
+{
+  float * p = ap_to;
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4, p += 8)
+    {
+      const __m128 l = _mm_loadu_ps (ap_l + i);
+      const __m128 r = _mm_loadu_ps (ap_r + i);
+      _mm_storeu_ps (p, _mm_unpacklo_ps (l, r));
+      _mm_storeu_ps (p + 4, _mm_unpackhi_ps (l, r));
+    }
+
+  ilv2_f32_scalar (p, ap_l + i, ap_r + i, a_n - i);
+}
+
+/*
+ * AVX2 kernels
+ */
+
+__attribute__ ((target ("avx2"))) static void
+gain_s16_avx2 (void * ap_buf, size_t a_n, float a_gain)
+{
+  int16_t * p = ap_buf;
+  const __m256 g = _mm256_set1_ps (a_gain);
+  const __m256 lo = _mm256_set1_ps (PCM_S16_MIN);
+  const __m256 hi = _mm256_set1_ps (PCM_S16_MAX);
+  size_t i = 0;
+
+  for (; i + 16 <= a_n; i += 16)
+    {
+      const __m256i v = _mm256_loadu_si256 ((const __m256i *) (p + i));
+      __m256i v0 = _mm256_cvtepi16_epi32 (_mm256_castsi256_si128 (v));
+      __m256i v1 = _mm256_cvtepi16_epi32 (_mm256_extracti128_si256 (v, 1));
+      __m256 f0 = _mm256_mul_ps (_mm256_cvtepi32_ps (v0), g);
+      __m256 f1 = _mm256_mul_ps (_mm256_cvtepi32_ps (v1), g);
+      f0 = _mm256_min_ps (_mm256_max_ps (f0, lo), hi);
+      f1 = _mm256_min_ps (_mm256_max_ps (f1, lo), hi);
+      v0 = _mm256_cvttps_epi32 (f0);
+      v1 = _mm256_cvttps_epi32 (f1);
+      /* packs works on 128-bit lanes; restore the sample order */
+      _mm256_storeu_si256 (
+        (__m256i *) (p + i),
+        _mm256_permute4x64_epi64 (_mm256_packs_epi32 (v0, v1),
+                                  _MM_SHUFFLE (3, 1, 2, 0)));
+    }
+
+  gain_s16_sse2 (p + i, a_n - i, a_gain);
+}
+
+__attribute__ ((target ("avx2"))) static void
+gain_f32_avx2 (void * ap_buf, size_t a_n, float a_gain)
+{
+  float * p = ap_buf;
+  const __m256 g = _mm256_set1_ps (a_gain);
+  const __m256 lo = _mm256_set1_ps (-1.0f);
+  const __m256 hi = _mm256_set1_ps (1.0f);
+  size_t i = 0;
+
+  for (; i + 8 <= a_n; i += 8)
+    {
+      const __m256 f = _mm256_mul_ps (_mm256_loadu_ps (p + i), g);
+      _mm256_storeu_ps (p + i, _mm256_min_ps (_mm256_max_ps (f, lo), hi));
+    }
+
+  gain_f32_sse2 (p + i, a_n - i, a_gain);
+}
+
+__attribute__ ((target ("avx2"))) static void
+clip_f32_avx2 (void * ap_buf, size_t a_n)
+{
+  float * p = ap_buf;
+  const __m256 lo = _mm256_set1_ps (-1.0f);
+  const __m256 hi = _mm256_set1_ps (1.0f);
+  size_t i = 0;
+
+  for (; i + 8 <= a_n; i += 8)
+    {
+      const __m256 f = _mm256_loadu_ps (p + i);
+      _mm256_storeu_ps (p + i, _mm256_min_ps (_mm256_max_ps (f, lo), hi));
+    }
+
+  clip_f32_sse2 (p + i, a_n - i);
+}
+
+__attribute__ ((target ("avx2"))) static void
+swap16_avx2 (void * ap_buf, size_t a_n)
+{
+  uint16_t * p = ap_buf;
+  const __m256i mask = _mm256_setr_epi8 (
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7,
+    6, 9, 8, 11, 10, 13, 12, 15, 14);
+  size_t i = 0;
+
+  for (; i + 16 <= a_n; i += 16)
+    {
+      const __m256i v = _mm256_loadu_si256 ((const __m256i *) (p + i));
+      _mm256_storeu_si256 ((__m256i *) (p + i), _mm256_shuffle_epi8 (v, mask));
+    }
+
+  swap16_sse2 (p + i, a_n - i);
+}
+
+__attribute__ ((target ("avx2"))) static void
+swap32_avx2 (void * ap_buf, size_t a_n)
+{
+  uint32_t * p = ap_buf;
+  const __m256i mask = _mm256_setr_epi8 (
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5,
+    4, 11, 10, 9, 8, 15, 14, 13, 12);
+  size_t i = 0;
+
+  for (; i + 8 <= a_n; i += 8)
+    {
+      const __m256i v = _mm256_loadu_si256 ((const __m256i *) (p + i));
+      _mm256_storeu_si256 ((__m256i *) (p + i), _mm256_shuffle_epi8 (v, mask));
+    }
+
+  swap32_sse2 (p + i, a_n - i);
+}
+
+#endif /* TIZ_PCM_X86 */
+
+/*
+ * NEON kernels
+ */
+
+#ifdef TIZ_PCM_NEON
+
+static void
+gain_s16_neon (void * ap_buf, size_t a_n, float a_gain)
+{
+  int16_t * p = ap_buf;
+  const float32x4_t lo = vdupq_n_f32 (PCM_S16_MIN);
+  const float32x4_t hi = vdupq_n_f32 (PCM_S16_MAX);
+  size_t i = 0;
+
+  for (; i + 8 <= a_n; i += 8)
+    {
+      const int16x8_t v = vld1q_s16 (p + i);
+      float32x4_t f0 = vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (v)));
+      float32x4_t f1 = vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (v)));
+      f0 = vminq_f32 (vmaxq_f32 (vmulq_n_f32 (f0, a_gain), lo), hi);
+      f1 = vminq_f32 (vmaxq_f32 (vmulq_n_f32 (f1, a_gain), lo), hi);
+      vst1q_s16 (p + i, vcombine_s16 (vqmovn_s32 (vcvtq_s32_f32 (f0)),
+                                      vqmovn_s32 (vcvtq_s32_f32 (f1))));
+    }
+
+  gain_s16_scalar (p + i, a_n - i, a_gain);
+}
+
+static void
+gain_f32_neon (void * ap_buf, size_t a_n, float a_gain)
+{
+  float * p = ap_buf;
+  const float32x4_t lo = vdupq_n_f32 (-1.0f);
+  const float32x4_t hi = vdupq_n_f32 (1.0f);
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4)
+    {
+      const float32x4_t f = vmulq_n_f32 (vld1q_f32 (p + i), a_gain);
+      vst1q_f32 (p + i, vminq_f32 (vmaxq_f32 (f, lo), hi));
+    }
+
+  gain_f32_scalar (p + i, a_n - i, a_gain);
+}
+
+static void
+clip_f32_neon (void * ap_buf, size_t a_n)
+{
+  float * p = ap_buf;
+  const float32x4_t lo = vdupq_n_f32 (-1.0f);
+  const float32x4_t hi = vdupq_n_f32 (1.0f);
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4)
+    {
+      vst1q_f32 (p + i, vminq_f32 (vmaxq_f32 (vld1q_f32 (p + i), lo), hi));
+    }
+
+  clip_f32_scalar (p + i, a_n - i);
+}
+
+static void
+swap16_neon (void * ap_buf, size_t a_n)
+{
+  uint16_t * p = ap_buf;
+  size_t i = 0;
+
+  for (; i + 8 <= a_n; i += 8)
+    {
+      const uint8x16_t v = vld1q_u8 ((const uint8_t *) (p + i));
+      vst1q_u8 ((uint8_t *) (p + i), vrev16q_u8 (v));
+    }
+
+  swap16_scalar (p + i, a_n - i);
+}
+
+static void
+swap32_neon (void * ap_buf, size_t a_n)
+{
+  uint32_t * p = ap_buf;
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4)
+    {
+      const uint8x16_t v = vld1q_u8 ((const uint8_t *) (p + i));
+      vst1q_u8 ((uint8_t *) (p + i), vrev32q_u8 (v));
+    }
+
+  swap32_scalar (p + i, a_n - i);
+}
+
+static void
+ilv2_s16_neon (void * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+               size_t a_n, int a_shift)
+{
+  int16_t * p = ap_to;
+  const int32x4_t sh = vdupq_n_s32 (a_shift);
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4, p += 8)
+    {
+      int16x4x2_t lr;
+      lr.val[0] = vqmovn_s32 (vshlq_s32 (vld1q_s32 (ap_l + i), sh));
+      lr.val[1] = vqmovn_s32 (vshlq_s32 (vld1q_s32 (ap_r + i), sh));
+      vst2_s16 (p, lr);
+    }
+
+  ilv2_s16_scalar (p, ap_l + i, ap_r + i, a_n - i, a_shift);
+}
+
+static void
+ilv2_s32_neon (void * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+               size_t a_n, int a_shift)
+{
+  int32_t * p = ap_to;
+  const int32x4_t sh = vdupq_n_s32 (a_shift);
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4, p += 8)
+    {
+      int32x4x2_t lr;
+      lr.val[0] = vshlq_s32 (vld1q_s32 (ap_l + i), sh);
+      lr.val[1] = vshlq_s32 (vld1q_s32 (ap_r + i), sh);
+      vst2q_s32 (p, lr);
+    }
+
+  ilv2_s32_scalar (p, ap_l + i, ap_r + i, a_n - i, a_shift);
+}
+
+static void
+ilv2_i2f_neon (float * ap_to, const int32_t * ap_l, const int32_t * ap_r,
+               size_t a_n, float a_scale)
+{
+  float * p = ap_to;
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4, p += 8)
+    {
+      float32x4x2_t lr;
+      lr.val[0] = vmulq_n_f32 (vcvtq_f32_s32 (vld1q_s32 (ap_l + i)), a_scale);
+      lr.val[1] = vmulq_n_f32 (vcvtq_f32_s32 (vld1q_s32 (ap_r + i)), a_scale);
+      vst2q_f32 (p, lr);
+    }
+
+  ilv2_i2f_scalar (p, ap_l + i, ap_r + i, a_n - i, a_scale);
+}
+
+static void
+ilv2_f32_neon (float * ap_to, const float * ap_l, const float * ap_r,
+               size_t a_n)
+{
+  float * p = ap_to;
+  size_t i = 0;
+
+  for (; i + 4 <= a_n; i += 4, p += 8)
+    {
+      float32x4x2_t lr;
+      lr.val[0] = vld1q_f32 (ap_l + i);
+      lr.val[1] = vld1q_f32 (ap_r + i);
+      vst2q_f32 (p, lr);
+    }
+
+  ilv2_f32_scalar (p, ap_l + i, ap_r + i, a_n - i);
+}
+
+#endif /* TIZ_PCM_NEON */
+
+static bool
+isa_supported (const tiz_pcm_isa_t a_isa)
+{
+  switch (a_isa)
+    {
+      case ETIZPcmIsaScalar:
+        return true;
+#ifdef TIZ_PCM_X86
+      case ETIZPcmIsaSse2:
+        return __builtin_cpu_supports ("sse2");
+      case ETIZPcmIsaAvx2:
+        return __builtin_cpu_supports ("avx2");
+#endif
+#ifdef TIZ_PCM_NEON
+      case ETIZPcmIsaNeon:
+        return true;
+#endif
+      default:
+        break;
+    };
+  return false;
+}
+
+static void
+select_isa (const tiz_pcm_isa_t a_isa)
+{
+  pcm_kernels_t k
+    = {gain_s16_scalar, gain_f32_scalar, clip_f32_scalar, swap16_scalar,
+       swap32_scalar,   ilv2_s16_scalar, ilv2_s32_scalar, ilv2_i2f_scalar,
+       ilv2_f32_scalar};
+
+  switch (a_isa)
+    {
+#ifdef TIZ_PCM_X86
+      case ETIZPcmIsaSse2:
+        {
+          pcm_kernels_t sse2
+            = {gain_s16_sse2, gain_f32_sse2, clip_f32_sse2, swap16_sse2,
+               swap32_sse2,   ilv2_s16_sse2, ilv2_s32_sse2, ilv2_i2f_sse2,
+               ilv2_f32_sse2};
+          k = sse2;
+        }
+        break;
+      case ETIZPcmIsaAvx2:
+        {
+          /* Interleaving is memory bound; the SSE2 versions will do */
+          pcm_kernels_t avx2
+            = {gain_s16_avx2, gain_f32_avx2, clip_f32_avx2, swap16_avx2,
+               swap32_avx2,   ilv2_s16_sse2, ilv2_s32_sse2, ilv2_i2f_sse2,
+               ilv2_f32_sse2};
+          k = avx2;
+        }
+        break;
+#endif
+#ifdef TIZ_PCM_NEON
+      case ETIZPcmIsaNeon:
+        {
+          pcm_kernels_t neon
+            = {gain_s16_neon, gain_f32_neon, clip_f32_neon, swap16_neon,
+               swap32_neon,   ilv2_s16_neon, ilv2_s32_neon, ilv2_i2f_neon,
+               ilv2_f32_neon};
+          k = neon;
+        }
+        break;
+#endif
+      default:
+        break;
+    };
+
+  g_pcm = k;
+  g_pcm_isa = a_isa;
+}
+
+static void
+init_kernels (void)
+{
+  tiz_pcm_isa_t isa = ETIZPcmIsaScalar;
+
+#ifdef TIZ_PCM_X86
+  __builtin_cpu_init ();
+#endif
+
+  if (isa_supported (ETIZPcmIsaAvx2))
+    {
+      isa = ETIZPcmIsaAvx2;
+    }
+  else if (isa_supported (ETIZPcmIsaSse2))
+    {
+      isa = ETIZPcmIsaSse2;
+    }
+  else if (isa_supported (ETIZPcmIsaNeon))
+    {
+      isa = ETIZPcmIsaNeon;
+    }
+
+  select_isa (isa);
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Using [%s] pcm kernels",
+           tiz_pcm_isa_to_str (isa));
+}
+
+static inline const pcm_kernels_t *
+get_kernels (void)
+{
+  (void) pthread_once (&g_pcm_once, init_kernels);
+  return &g_pcm;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_fmt_from_pcmmode (const OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode,
+                          tiz_pcm_fmt_t * ap_fmt)
+{
+  assert (ap_pcmmode);
+  assert (ap_fmt);
+
+  switch (ap_pcmmode->nBitPerSample)
+    {
+      case 16:
+        *ap_fmt = ETIZPcmFmtS16;
+        break;
+      case 24:
+        *ap_fmt = ETIZPcmFmtS24;
+        break;
+      case 32:
+        *ap_fmt = ETIZPcmFmtF32;
+        break;
+      default:
+        return OMX_ErrorUnsupportedSetting;
+    };
+
+  return OMX_ErrorNone;
+}
+
+OMX_BOOL
+tiz_pcm_is_native_endian (const OMX_ENDIANTYPE a_endian)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return OMX_EndianBig == a_endian ? OMX_TRUE : OMX_FALSE;
+#else
+  return OMX_EndianLittle == a_endian ? OMX_TRUE : OMX_FALSE;
+#endif
+}
+
+size_t
+tiz_pcm_fmt_size (const tiz_pcm_fmt_t a_fmt)
+{
+  static const size_t sizes[] = {2, 3, 4, 4};
+  assert (a_fmt < ETIZPcmFmtMax);
+  return sizes[a_fmt];
+}
+
+float
+tiz_pcm_db_to_gain (const float a_db)
+{
+  return powf (10.0f, a_db / 20.0f);
+}
+
+void
+tiz_pcm_gain (void * ap_buf, const size_t a_nsamples, const tiz_pcm_fmt_t a_fmt,
+              const float a_gain)
+{
+  const pcm_kernels_t * p_k = get_kernels ();
+
+  assert (ap_buf || 0 == a_nsamples);
+  assert (a_fmt < ETIZPcmFmtMax);
+
+  switch (a_fmt)
+    {
+      case ETIZPcmFmtS16:
+        p_k->pf_gain_s16 (ap_buf, a_nsamples, a_gain);
+        break;
+      case ETIZPcmFmtS24:
+        gain_s24 (ap_buf, a_nsamples, a_gain);
+        break;
+      case ETIZPcmFmtS32:
+        gain_s32 (ap_buf, a_nsamples, a_gain);
+        break;
+      case ETIZPcmFmtF32:
+        p_k->pf_gain_f32 (ap_buf, a_nsamples, a_gain);
+        break;
+      default:
+        break;
+    };
+}
+
+void
+tiz_pcm_clip (void * ap_buf, const size_t a_nsamples,
+              const tiz_pcm_fmt_t a_fmt)
+{
+  assert (ap_buf || 0 == a_nsamples);
+  assert (a_fmt < ETIZPcmFmtMax);
+
+  if (ETIZPcmFmtF32 == a_fmt)
+    {
+      get_kernels ()->pf_clip_f32 (ap_buf, a_nsamples);
+    }
+}
+
+void
+tiz_pcm_swap (void * ap_buf, const size_t a_nsamples,
+              const tiz_pcm_fmt_t a_fmt)
+{
+  const pcm_kernels_t * p_k = get_kernels ();
+
+  assert (ap_buf || 0 == a_nsamples);
+  assert (a_fmt < ETIZPcmFmtMax);
+
+  switch (a_fmt)
+    {
+      case ETIZPcmFmtS16:
+        p_k->pf_swap16 (ap_buf, a_nsamples);
+        break;
+      case ETIZPcmFmtS24:
+        swap24 (ap_buf, a_nsamples);
+        break;
+      case ETIZPcmFmtS32:
+      case ETIZPcmFmtF32:
+        p_k->pf_swap32 (ap_buf, a_nsamples);
+        break;
+      default:
+        break;
+    };
+}
+
+void
+tiz_pcm_interleave_s32 (void * ap_to, const tiz_pcm_fmt_t a_fmt,
+                        const int32_t * const * app_from,
+                        const size_t a_nchannels, const size_t a_first,
+                        const size_t a_nframes, const unsigned int a_bits)
+{
+  const pcm_kernels_t * p_k = get_kernels ();
+  const bool stereo = (2 == a_nchannels);
+
+  assert (ap_to || 0 == a_nframes);
+  assert (app_from);
+  assert (a_nchannels > 0);
+  assert (a_bits > 0 && a_bits <= 32);
+  assert (a_fmt < ETIZPcmFmtMax);
+
+  switch (a_fmt)
+    {
+      case ETIZPcmFmtS16:
+        {
+          const int shift = 16 - (int) a_bits;
+          if (stereo)
+            {
+              p_k->pf_ilv2_s16 (ap_to, app_from[0] + a_first,
+                                app_from[1] + a_first, a_nframes, shift);
+            }
+          else
+            {
+              ilv_s16 (ap_to, app_from, a_nchannels, a_first, a_nframes,
+                       shift);
+            }
+        }
+        break;
+      case ETIZPcmFmtS24:
+        {
+          ilv_s24 (ap_to, app_from, a_nchannels, a_first, a_nframes,
+                   24 - (int) a_bits);
+        }
+        break;
+      case ETIZPcmFmtS32:
+        {
+          const int shift = 32 - (int) a_bits;
+          if (stereo)
+            {
+              p_k->pf_ilv2_s32 (ap_to, app_from[0] + a_first,
+                                app_from[1] + a_first, a_nframes, shift);
+            }
+          else
+            {
+              ilv_s32 (ap_to, app_from, a_nchannels, a_first, a_nframes,
+                       shift);
+            }
+        }
+        break;
+      case ETIZPcmFmtF32:
+        {
+          const float scale = (float) ldexp (1.0, 1 - (int) a_bits);
+          if (stereo)
+            {
+              p_k->pf_ilv2_i2f (ap_to, app_from[0] + a_first,
+                                app_from[1] + a_first, a_nframes, scale);
+            }
+          else
+            {
+              ilv_i2f (ap_to, app_from, a_nchannels, a_first, a_nframes,
+                       scale);
+            }
+        }
+        break;
+      default:
+        break;
+    };
+}
+
+void
+tiz_pcm_interleave_f32 (float * ap_to, const float * const * app_from,
+                        const size_t a_nchannels, const size_t a_first,
+                        const size_t a_nframes)
+{
+  assert (ap_to || 0 == a_nframes);
+  assert (app_from);
+  assert (a_nchannels > 0);
+
+  if (2 == a_nchannels)
+    {
+      get_kernels ()->pf_ilv2_f32 (ap_to, app_from[0] + a_first,
+                                   app_from[1] + a_first, a_nframes);
+    }
+  else
+    {
+      ilv_f32 (ap_to, app_from, a_nchannels, a_first, a_nframes);
+    }
+}
+
+void
+tiz_pcm_vorbis_to_wave_order (const float ** app_to,
+                              const float * const * app_from,
+                              const size_t a_nchannels)
+{
+  /* For each WAVE position, the Vorbis channel that goes there */
+  static const uint8_t vorbis_to_wave[8][8] = {
+    {0},                      /* mono */
+    {0, 1},                   /* L R */
+    {0, 2, 1},                /* L C R -> L R C */
+    {0, 1, 2, 3},             /* L R BL BR */
+    {0, 2, 1, 3, 4},          /* L C R BL BR -> L R C BL BR */
+    {0, 2, 1, 5, 3, 4},       /* L C R BL BR LFE -> L R C LFE BL BR */
+    {0, 2, 1, 6, 5, 3, 4},    /* L C R SL SR BC LFE -> L R C LFE BC SL SR */
+    {0, 2, 1, 7, 5, 6, 3, 4}, /* L C R SL SR BL BR LFE
+                                 -> L R C LFE BL BR SL SR */
+  };
+  size_t i = 0;
+
+  assert (app_to);
+  assert (app_from);
+
+  for (i = 0; i < a_nchannels; ++i)
+    {
+      app_to[i] = (a_nchannels <= 8)
+                    ? app_from[vorbis_to_wave[a_nchannels - 1][i]]
+                    : app_from[i];
+    }
+}
+
+tiz_pcm_isa_t
+tiz_pcm_get_isa (void)
+{
+  (void) get_kernels ();
+  return g_pcm_isa;
+}
+
+OMX_ERRORTYPE
+tiz_pcm_set_isa (const tiz_pcm_isa_t a_isa)
+{
+  (void) get_kernels ();
+  if (a_isa >= ETIZPcmIsaMax || !isa_supported (a_isa))
+    {
+      return OMX_ErrorUnsupportedSetting;
+    }
+  select_isa (a_isa);
+  return OMX_ErrorNone;
+}
+
+const char *
+tiz_pcm_isa_to_str (const tiz_pcm_isa_t a_isa)
+{
+  return a_isa < ETIZPcmIsaMax ? pcm_isa_names[a_isa] : "unknown";
+}
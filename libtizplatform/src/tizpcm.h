@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizpcm.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM sample processing kernels
+ *
+ *
+ */
+
+#ifndef TIZPCM_H
+#define TIZPCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizpcm PCM sample processing kernels
+ *
+ * Gain, saturation and byte-order conversion of interleaved PCM samples,
+ * and interleaving of planar decoder output. Kernels work on any number of
+ * channels. The fastest implementation available on the running CPU (AVX2,
+ * SSE2, NEON or plain C) is selected the first time a kernel is used.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+#include <OMX_Audio.h>
+
+/**
+ * Sample formats. Integer formats are signed. All kernels, except
+ * tiz_pcm_swap, expect samples in host byte order.
+ * @ingroup tizpcm
+ */
+typedef enum tiz_pcm_fmt {
+  ETIZPcmFmtS16 = 0, /**< 16-bit integer */
+  ETIZPcmFmtS24,     /**< 24-bit integer, packed in 3 bytes */
+  ETIZPcmFmtS32,     /**< 32-bit integer */
+  ETIZPcmFmtF32,     /**< 32-bit float, nominal range [-1.0, 1.0] */
+  ETIZPcmFmtMax
+} tiz_pcm_fmt_t;
+
+/**
+ * Kernel implementations.
+ * @ingroup tizpcm
+ */
+typedef enum tiz_pcm_isa {
+  ETIZPcmIsaScalar = 0,
+  ETIZPcmIsaSse2,
+  ETIZPcmIsaAvx2,
+  ETIZPcmIsaNeon,
+  ETIZPcmIsaMax
+} tiz_pcm_isa_t;
+
+/**
+ * Retrieve the sample format described by an OpenMAX IL PCM mode
+ * structure. 32-bit streams are taken to be float, as produced by the
+ * Vorbis and Opus decoders.
+ *
+ * @ingroup tizpcm
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorUnsupportedSetting if the
+ * sample size is not supported.
+ */
+OMX_ERRORTYPE
+tiz_pcm_fmt_from_pcmmode (const OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode,
+                          tiz_pcm_fmt_t * ap_fmt);
+
+/**
+ * Whether the given byte order is the host's.
+ *
+ * @ingroup tizpcm
+ */
+OMX_BOOL
+tiz_pcm_is_native_endian (const OMX_ENDIANTYPE a_endian);
+
+/**
+ * Size in bytes of one sample of the given format.
+ *
+ * @ingroup tizpcm
+ */
+size_t
+tiz_pcm_fmt_size (const tiz_pcm_fmt_t a_fmt);
+
+/**
+ * Convert a gain in dB into a linear factor.
+ *
+ * @ingroup tizpcm
+ */
+float
+tiz_pcm_db_to_gain (const float a_db);
+
+/**
+ * Multiply samples by a linear gain factor, saturating the results to the
+ * range of the format.
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_buf The samples (updated in place).
+ *
+ * @param a_nsamples The number of samples (i.e. frames * channels).
+ */
+void
+tiz_pcm_gain (void * ap_buf, const size_t a_nsamples, const tiz_pcm_fmt_t a_fmt,
+              const float a_gain);
+
+/**
+ * Saturate samples to the nominal range of the format. Only has an effect
+ * on float samples; integer samples are always within range.
+ *
+ * @ingroup tizpcm
+ */
+void
+tiz_pcm_clip (void * ap_buf, const size_t a_nsamples,
+              const tiz_pcm_fmt_t a_fmt);
+
+/**
+ * Reverse the byte order of the samples.
+ *
+ * @ingroup tizpcm
+ */
+void
+tiz_pcm_swap (void * ap_buf, const size_t a_nsamples,
+              const tiz_pcm_fmt_t a_fmt);
+
+/**
+ * Interleave planar integer samples (e.g. libFLAC's decoder output) into
+ * samples of the given format. The significant bits of the source are
+ * scaled to the destination format: e.g. 20-bit samples are shifted up 4
+ * bits into a 24-bit destination, and integer samples become floats in the
+ * range [-1.0, 1.0).
+ *
+ * @ingroup tizpcm
+ *
+ * @param ap_to The destination; room for a_nframes * a_nchannels samples.
+ * @param a_fmt The destination format.
+ * @param app_from One array of samples per channel.
+ * @param a_nchannels The number of channels.
+ * @param a_first The index of the first frame to take from each channel.
+ * @param a_nframes The number of frames to interleave.
+ * @param a_bits The number of significant bits in the source samples
+ * (1 to 32).
+ */
+void
+tiz_pcm_interleave_s32 (void * ap_to, const tiz_pcm_fmt_t a_fmt,
+                        const int32_t * const * app_from,
+                        const size_t a_nchannels, const size_t a_first,
+                        const size_t a_nframes, const unsigned int a_bits);
+
+/**
+ * Interleave planar float samples (e.g. libvorbis' decoder output).
+ *
+ * @ingroup tizpcm
+ *
+ * @see tiz_pcm_interleave_s32
+ */
+void
+tiz_pcm_interleave_f32 (float * ap_to, const float * const * app_from,
+                        const size_t a_nchannels, const size_t a_first,
+                        const size_t a_nframes);
+
+/**
+ * Reorder the channels of a Vorbis I stream (e.g. the planes of libvorbis'
+ * decoder output) into the WAVE channel order, which is also FLAC's, and
+ * the one the audio renderers expect. Only the plane pointers are
+ * reordered. Vorbis I leaves the order of more than 8 channels to the
+ * application, so those are not reordered.
+ *
+ * @ingroup tizpcm
+ *
+ * @param app_to The planes in WAVE order (a_nchannels entries).
+ * @param app_from The planes in Vorbis order (a_nchannels entries).
+ * @param a_nchannels The number of channels.
+ */
+void
+tiz_pcm_vorbis_to_wave_order (const float ** app_to,
+                              const float * const * app_from,
+                              const size_t a_nchannels);
+
+/**
+ * Retrieve the implementation currently in use.
+ *
+ * @ingroup tizpcm
+ */
+tiz_pcm_isa_t
+tiz_pcm_get_isa (void);
+
+/**
+ * Force a particular implementation. Mostly useful for testing and
+ * benchmarking.
+ *
+ * @ingroup tizpcm
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorUnsupportedSetting if the
+ * implementation is not available on this CPU or build.
+ */
+OMX_ERRORTYPE
+tiz_pcm_set_isa (const tiz_pcm_isa_t a_isa);
+
+/**
+ * Retrieve the name of an implementation.
+ *
+ * @ingroup tizpcm
+ */
+const char *
+tiz_pcm_isa_to_str (const tiz_pcm_isa_t a_isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZPCM_H */
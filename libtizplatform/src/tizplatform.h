@@ -40,11 +40,16 @@
 #include "tizlog.h"
 #include "tizmem.h"
 #include "tizqueue.h"
+#include "tizlfqueue.h"
 #include "tizpqueue.h"
 #include "tizbuffer.h"
+#include "tizpcm.h"
 #include "tizvector.h"
 #include "tizsync.h"
 #include "tizthread.h"
+#include "tizwpool.h"
+#include "tizaio.h"
+#include "tizbufpool.h"
 #include "tizuuid.h"
 #include "tizomxutils.h"
 #include "tizrc.h"
@@ -94,6 +94,18 @@ tiz_rcfile_init (tiz_rcfile_t ** rcfile);
 void
 tiz_rcfile_destroy (tiz_rcfile_t * rcfile);
 
+/**
+ * Retrieve the value of a key straight from a config file data structure,
+ * i.e. without going through the handle owned by the event loop. Only
+ * useful while the event loop is being initialised.
+ *
+ * @private
+ *
+ * @return The value or NULL if the key is not found.
+ */
+const char *
+tiz_rcfile_find_value (const tiz_rcfile_t * ap_rc, const char * ap_key);
+
 /**
  * Retrieve the config file handle from the event loop thread
  *
@@ -606,6 +606,19 @@ tiz_rcfile_get_value (const char * ap_section, const char * ap_key)
   return NULL;
 }
 
+const char *
+tiz_rcfile_find_value (const tiz_rcfile_t * ap_rc, const char * ap_key)
+{
+  keyval_t * p_kv = NULL;
+
+  assert (ap_rc);
+  assert (ap_key);
+  assert (is_list (ap_key) == false);
+
+  p_kv = find_node (ap_rc, ap_key);
+  return (p_kv && p_kv->p_value_list) ? p_kv->p_value_list->p_value : NULL;
+}
+
 char **
 tiz_rcfile_get_value_list (const char * ap_section, const char * ap_key,
                            unsigned long * ap_length)
@@ -22,7 +22,17 @@
  * @author Juan A. Rubio <juan.rubio@aratelia.com>
  *
  * @brief  Tizonia Platform - Small object allocation
+ * @brief  Tizonia Platform - Small object allocation
+ *
+ * Slices are carved out of chunks. Each chunk serves a single size class
+ * and keeps its own list of free slices; chunks with free slices are
+ * linked from their class. A chunk that becomes completely free is given
+ * back to the heap, unless it is the only free chunk of its class (this
+ * avoids thrashing when a single object is allocated and freed in a loop).
  *
+ * Shared allocators are protected by a mutex, and each thread keeps a small
+ * magazine of free slices per class for the last shared allocator it used,
+ * so that most allocations and frees do not take the lock.
  *
  */
 
@@ -33,6 +43,8 @@
 #include "tizplatform.h"
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -41,10 +53,14 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.platform.soa"
 #endif
 
-#define SOA_MAX_SLICE_SIZE 256
+#define SOA_SMALL_SLICE_SIZE 256
+#define SOA_MAX_SLICE_SIZE 4096
 #define SOA_SLICE_ALIGN 8
-#define SOA_CHUNK_SZ 4096
+#define SOA_LARGE_GRANULE 128
+#define SOA_MAGAZINE_SIZE 32
 
+/* Indexed by slice size / SOA_SLICE_ALIGN, for slices up to
+   SOA_SMALL_SLICE_SIZE bytes */
 static const int32_t chunk_class_tbl[] = {
   0, 0, 0, 0, 0,                                 /* 32 bytes */
   1, 1, 1, 1,                                    /* 64 bytes */
@@ -53,28 +69,100 @@ static const int32_t chunk_class_tbl[] = {
   4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4 /* 256 bytes */
 };
 
+/* Indexed by (slice size - 1) / SOA_LARGE_GRANULE, for slices up to
+   SOA_MAX_SLICE_SIZE bytes */
+static const int32_t large_chunk_class_tbl[] = {
+  -1, -1,                 /* handled by chunk_class_tbl */
+  5,                      /* 384 bytes */
+  6,                      /* 512 bytes */
+  7, 7,                   /* 768 bytes */
+  8, 8,                   /* 1024 bytes */
+  9, 9, 9, 9,             /* 1536 bytes */
+  10, 10, 10, 10,         /* 2048 bytes */
+  11, 11, 11, 11, 11, 11, 11, 11, /* 3072 bytes */
+  12, 12, 12, 12, 12, 12, 12, 12  /* 4096 bytes */
+};
+
 static const size_t slice_sz_tbl[TIZ_SOA_NUM_CHUNK_CLASSES]
-  = {32, 64, 96, 128, 256};
+  = {32, 64, 96, 128, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096};
 
+/* Bigger classes use bigger chunks, so that every chunk holds at least 16
+   slices */
+static const size_t chunk_sz_tbl[TIZ_SOA_NUM_CHUNK_CLASSES]
+  = {4096,  4096,  4096,  4096,  4096,  8192, 8192,
+     16384, 16384, 32768, 32768, 65536, 65536};
+
+typedef struct slice slice_t;
 typedef struct chunk chunk_t;
+
 struct chunk
 {
-  chunk_t * p_next;
+  chunk_t * p_next; /* all chunks */
+  chunk_t * p_prev;
+  chunk_t * p_next_partial; /* chunks of this class with free slices */
+  chunk_t * p_prev_partial;
   tiz_soa_t * p_soa;
+  slice_t * p_free;
   int32_t n_allocated_slices;
+  int32_t n_slices;
   int32_t class;
-  uint8_t data[SOA_CHUNK_SZ];
+  int32_t in_partial;
+  uint8_t data[]; /* 8-byte aligned, as the fields above */
 };
 
-typedef struct slice slice_t;
 struct slice
 {
   size_t size;
-  chunk_t * p_chunk;
+  chunk_t * p_chunk; /* NULL for objects allocated from the heap */
   slice_t * p_next_free;
 };
 #define SLICE_PREAMBLE_SZ (sizeof (size_t) + sizeof (chunk_t *))
 
+typedef struct soa_class soa_class_t;
+struct soa_class
+{
+  chunk_t * p_partial;
+  int32_t n_empty;
+};
+
+struct tiz_soa
+{
+  soa_class_t classes[TIZ_SOA_NUM_CHUNK_CLASSES];
+  chunk_t * p_chunk_lst;
+  int32_t n_chunks;
+  int32_t n_allocated_objects;
+  int32_t n_large_objects;
+  int32_t n_reclaimed_chunks;
+  uint64_t hits;
+  uint64_t misses;
+  /* Shared allocators only */
+  bool shared;
+  uint32_t id;
+  tiz_mutex_t mutex;
+  tiz_soa_t * p_next_shared;
+};
+
+/* Per-thread magazines, bound to one shared allocator at a time */
+typedef struct soa_tcache soa_tcache_t;
+struct soa_tcache
+{
+  tiz_soa_t * p_soa;
+  uint32_t soa_id;
+  slice_t * p_mag[TIZ_SOA_NUM_CHUNK_CLASSES];
+  int32_t mag_count[TIZ_SOA_NUM_CHUNK_CLASSES];
+  uint64_t hits;
+};
+
+static __thread soa_tcache_t t_cache;
+static pthread_once_t g_tcache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_tcache_key;
+
+/* Live shared allocators. Magazines of threads that outlive their
+   allocator are simply dropped */
+static pthread_mutex_t g_shared_mutex = PTHREAD_MUTEX_INITIALIZER;
+static tiz_soa_t * gp_shared_lst = NULL;
+static uint32_t g_next_shared_id = 1;
+
 static inline uint8_t *
 get_usr_ptr (slice_t * p_slice)
 {
@@ -87,61 +175,376 @@ get_slice_ptr (void * p_usr)
   return ((slice_t *) ((uint8_t *) p_usr - SLICE_PREAMBLE_SZ));
 }
 
-struct tiz_soa
+static inline size_t
+get_alloc_sz (size_t a_size)
 {
-  slice_t * p_slice_store[TIZ_SOA_NUM_CHUNK_CLASSES];
-  slice_t * p_pending_chain;
-  chunk_t * p_chunk_lst;
-  int32_t n_chunks;
-  int32_t n_allocated_objects;
-};
+  return ((a_size + SOA_SLICE_ALIGN - 1) & ~(SOA_SLICE_ALIGN - 1))
+         + SLICE_PREAMBLE_SZ;
+}
 
-/*@null@*/ static slice_t *
+static inline int32_t
+get_chunk_class (size_t a_alloc_sz)
+{
+  assert (a_alloc_sz <= SOA_MAX_SLICE_SIZE);
+  return a_alloc_sz <= SOA_SMALL_SLICE_SIZE
+           ? chunk_class_tbl[a_alloc_sz / SOA_SLICE_ALIGN]
+           : large_chunk_class_tbl[(a_alloc_sz - 1) / SOA_LARGE_GRANULE];
+}
+
+static void
+add_to_partial (tiz_soa_t * p_soa, chunk_t * p_chunk)
+{
+  soa_class_t * p_class = &(p_soa->classes[p_chunk->class]);
+  assert (!p_chunk->in_partial);
+  p_chunk->p_prev_partial = NULL;
+  p_chunk->p_next_partial = p_class->p_partial;
+  if (p_class->p_partial)
+    {
+      p_class->p_partial->p_prev_partial = p_chunk;
+    }
+  p_class->p_partial = p_chunk;
+  p_chunk->in_partial = 1;
+}
+
+static void
+remove_from_partial (tiz_soa_t * p_soa, chunk_t * p_chunk)
+{
+  soa_class_t * p_class = &(p_soa->classes[p_chunk->class]);
+  assert (p_chunk->in_partial);
+  if (p_chunk->p_prev_partial)
+    {
+      p_chunk->p_prev_partial->p_next_partial = p_chunk->p_next_partial;
+    }
+  else
+    {
+      p_class->p_partial = p_chunk->p_next_partial;
+    }
+  if (p_chunk->p_next_partial)
+    {
+      p_chunk->p_next_partial->p_prev_partial = p_chunk->p_prev_partial;
+    }
+  p_chunk->p_next_partial = p_chunk->p_prev_partial = NULL;
+  p_chunk->in_partial = 0;
+}
+
+/*@null@*/ static chunk_t *
 alloc_chunk (tiz_soa_t * p_soa, int32_t chunk_class)
 {
-  slice_t * p_slice = NULL;
-  int32_t num_slices = 0;
-  size_t slice_sz = 0;
   chunk_t * p_new_chunk = NULL;
+  const size_t slice_sz = slice_sz_tbl[chunk_class];
+  const size_t chunk_sz = chunk_sz_tbl[chunk_class];
 
   TIZ_LOG (TIZ_PRIORITY_TRACE, "chunk_class [%d] ", chunk_class);
 
   assert (p_soa != NULL);
   assert (chunk_class < TIZ_SOA_NUM_CHUNK_CLASSES);
 
-  slice_sz = slice_sz_tbl[chunk_class];
-
-  if ((p_new_chunk = tiz_mem_calloc (1, sizeof (chunk_t))))
+  if ((p_new_chunk = tiz_mem_calloc (1, sizeof (chunk_t) + chunk_sz)))
     {
+      int32_t i = 0;
       p_new_chunk->p_soa = p_soa;
-      p_new_chunk->p_next = p_soa->p_chunk_lst;
-      p_new_chunk->n_allocated_slices = 0;
       p_new_chunk->class = chunk_class;
-      p_soa->p_chunk_lst = p_new_chunk;
-      p_soa->n_chunks += 1;
-      num_slices = SOA_CHUNK_SZ / slice_sz - 2;
-      p_soa->p_slice_store[chunk_class] = p_slice
-        = (slice_t *) (p_new_chunk->data + slice_sz);
-      do
+      p_new_chunk->n_slices = chunk_sz / slice_sz;
+
+      /* Free list in address order */
+      for (i = p_new_chunk->n_slices - 1; i >= 0; --i)
         {
-          slice_t * p_next = (slice_t *) ((uint8_t *) p_slice + slice_sz);
+          slice_t * p_slice = (slice_t *) (p_new_chunk->data + i * slice_sz);
           p_slice->p_chunk = p_new_chunk;
           p_slice->size = 0;
-          p_slice->p_next_free = p_next;
-          p_slice = p_next;
+          p_slice->p_next_free = p_new_chunk->p_free;
+          p_new_chunk->p_free = p_slice;
+        }
+
+      p_new_chunk->p_next = p_soa->p_chunk_lst;
+      if (p_soa->p_chunk_lst)
+        {
+          p_soa->p_chunk_lst->p_prev = p_new_chunk;
         }
-      while (--num_slices != 0);
+      p_soa->p_chunk_lst = p_new_chunk;
+      p_soa->n_chunks += 1;
+      p_soa->classes[chunk_class].n_empty += 1;
+      add_to_partial (p_soa, p_new_chunk);
+    }
+
+  return p_new_chunk;
+}
+
+static void
+release_chunk (tiz_soa_t * p_soa, chunk_t * p_chunk)
+{
+  assert (0 == p_chunk->n_allocated_slices);
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "chunk_class [%d] ", p_chunk->class);
 
-      p_slice->p_chunk = p_new_chunk;
-      p_slice->size = 0;
-      p_slice->p_next_free = NULL;
-      p_slice = (slice_t *) p_new_chunk->data;
-      p_slice->p_chunk = p_new_chunk;
+  if (p_chunk->in_partial)
+    {
+      remove_from_partial (p_soa, p_chunk);
+    }
+  if (p_chunk->p_prev)
+    {
+      p_chunk->p_prev->p_next = p_chunk->p_next;
+    }
+  else
+    {
+      p_soa->p_chunk_lst = p_chunk->p_next;
+    }
+  if (p_chunk->p_next)
+    {
+      p_chunk->p_next->p_prev = p_chunk->p_prev;
     }
+  p_soa->n_chunks -= 1;
+  p_soa->n_reclaimed_chunks += 1;
+  tiz_mem_free (p_chunk);
+}
+
+/* Take a slice from the chunks. The caller holds the lock, if any */
+/*@null@*/ static slice_t *
+depot_alloc (tiz_soa_t * p_soa, int32_t chunk_class)
+{
+  chunk_t * p_chunk = p_soa->classes[chunk_class].p_partial;
+  slice_t * p_slice = NULL;
 
+  if (p_chunk)
+    {
+      p_soa->hits += 1;
+    }
+  else
+    {
+      (void) __atomic_add_fetch (&(p_soa->misses), 1, __ATOMIC_RELAXED);
+      if (!(p_chunk = alloc_chunk (p_soa, chunk_class)))
+        {
+          return NULL;
+        }
+    }
+
+  p_slice = p_chunk->p_free;
+  assert (p_slice);
+  p_chunk->p_free = p_slice->p_next_free;
+  if (0 == p_chunk->n_allocated_slices)
+    {
+      p_soa->classes[chunk_class].n_empty -= 1;
+    }
+  p_chunk->n_allocated_slices += 1;
+  if (!p_chunk->p_free)
+    {
+      remove_from_partial (p_soa, p_chunk);
+    }
+  p_soa->n_allocated_objects += 1;
   return p_slice;
 }
 
+/* Give a slice back to its chunk. The caller holds the lock, if any */
+static void
+depot_free (tiz_soa_t * p_soa, slice_t * p_slice)
+{
+  chunk_t * p_chunk = p_slice->p_chunk;
+  soa_class_t * p_class = NULL;
+
+  assert (p_chunk != NULL);
+  assert (p_chunk->p_soa == p_soa);
+  assert (p_chunk->n_allocated_slices > 0);
+
+  p_class = &(p_soa->classes[p_chunk->class]);
+  if (!p_chunk->p_free)
+    {
+      add_to_partial (p_soa, p_chunk);
+    }
+  p_slice->p_next_free = p_chunk->p_free;
+  p_chunk->p_free = p_slice;
+  p_chunk->n_allocated_slices -= 1;
+  p_soa->n_allocated_objects -= 1;
+
+  if (0 == p_chunk->n_allocated_slices)
+    {
+      if (p_class->n_empty > 0)
+        {
+          release_chunk (p_soa, p_chunk);
+        }
+      else
+        {
+          p_class->n_empty += 1;
+        }
+    }
+}
+
+/*@null@*/ static slice_t *
+heap_alloc (tiz_soa_t * p_soa, size_t a_alloc_sz)
+{
+  slice_t * p_slice = tiz_mem_calloc (1, a_alloc_sz);
+  if (p_slice)
+    {
+      p_slice->p_chunk = NULL;
+      (void) __atomic_add_fetch (&(p_soa->n_large_objects), 1,
+                                 __ATOMIC_RELAXED);
+    }
+  (void) __atomic_add_fetch (&(p_soa->misses), 1, __ATOMIC_RELAXED);
+  return p_slice;
+}
+
+static void
+heap_free (tiz_soa_t * p_soa, slice_t * p_slice)
+{
+  (void) __atomic_sub_fetch (&(p_soa->n_large_objects), 1, __ATOMIC_RELAXED);
+  tiz_mem_free (p_slice);
+}
+
+static inline void
+soa_lock (tiz_soa_t * p_soa)
+{
+  if (p_soa->shared)
+    {
+      (void) tiz_mutex_lock (&(p_soa->mutex));
+    }
+}
+
+static inline void
+soa_unlock (tiz_soa_t * p_soa)
+{
+  if (p_soa->shared)
+    {
+      (void) tiz_mutex_unlock (&(p_soa->mutex));
+    }
+}
+
+/*
+ * Magazines
+ */
+
+static bool
+is_shared_alive (const tiz_soa_t * p_soa, uint32_t a_id)
+{
+  const tiz_soa_t * p_cur = gp_shared_lst;
+  while (p_cur && !(p_cur == p_soa && p_cur->id == a_id))
+    {
+      p_cur = p_cur->p_next_shared;
+    }
+  return NULL != p_cur;
+}
+
+static void
+unbind_tcache (soa_tcache_t * p_tc)
+{
+  if (p_tc->p_soa)
+    {
+      (void) pthread_mutex_lock (&g_shared_mutex);
+      if (is_shared_alive (p_tc->p_soa, p_tc->soa_id))
+        {
+          tiz_soa_t * p_soa = p_tc->p_soa;
+          int32_t i = 0;
+          (void) tiz_mutex_lock (&(p_soa->mutex));
+          for (i = 0; i < TIZ_SOA_NUM_CHUNK_CLASSES; ++i)
+            {
+              while (p_tc->p_mag[i])
+                {
+                  slice_t * p_slice = p_tc->p_mag[i];
+                  p_tc->p_mag[i] = p_slice->p_next_free;
+                  depot_free (p_soa, p_slice);
+                }
+            }
+          p_soa->hits += p_tc->hits;
+          (void) tiz_mutex_unlock (&(p_soa->mutex));
+        }
+      (void) pthread_mutex_unlock (&g_shared_mutex);
+    }
+  (void) tiz_mem_set (p_tc, 0, sizeof (soa_tcache_t));
+}
+
+static void
+tcache_destructor (void * ap_tc)
+{
+  unbind_tcache (ap_tc);
+}
+
+static void
+create_tcache_key (void)
+{
+  (void) pthread_key_create (&g_tcache_key, tcache_destructor);
+}
+
+static inline soa_tcache_t *
+bind_tcache (tiz_soa_t * p_soa)
+{
+  soa_tcache_t * p_tc = &t_cache;
+  if (p_tc->p_soa != p_soa || p_tc->soa_id != p_soa->id)
+    {
+      unbind_tcache (p_tc);
+      (void) pthread_once (&g_tcache_once, create_tcache_key);
+      /* So that the magazines are emptied when the thread exits */
+      (void) pthread_setspecific (g_tcache_key, p_tc);
+      p_tc->p_soa = p_soa;
+      p_tc->soa_id = p_soa->id;
+    }
+  return p_tc;
+}
+
+/*@null@*/ static slice_t *
+tcache_alloc (tiz_soa_t * p_soa, int32_t chunk_class)
+{
+  soa_tcache_t * p_tc = bind_tcache (p_soa);
+  slice_t * p_slice = p_tc->p_mag[chunk_class];
+
+  if (p_slice)
+    {
+      p_tc->hits += 1;
+    }
+  else
+    {
+      /* Refill half a magazine */
+      int32_t i = 0;
+      (void) tiz_mutex_lock (&(p_soa->mutex));
+      for (i = 0; i < SOA_MAGAZINE_SIZE / 2; ++i)
+        {
+          slice_t * p_new = depot_alloc (p_soa, chunk_class);
+          if (!p_new)
+            {
+              break;
+            }
+          p_new->p_next_free = p_tc->p_mag[chunk_class];
+          p_tc->p_mag[chunk_class] = p_new;
+          p_tc->mag_count[chunk_class] += 1;
+        }
+      (void) tiz_mutex_unlock (&(p_soa->mutex));
+      p_slice = p_tc->p_mag[chunk_class];
+    }
+
+  if (p_slice)
+    {
+      p_tc->p_mag[chunk_class] = p_slice->p_next_free;
+      p_tc->mag_count[chunk_class] -= 1;
+    }
+  return p_slice;
+}
+
+static void
+tcache_free (tiz_soa_t * p_soa, slice_t * p_slice)
+{
+  const int32_t chunk_class = p_slice->p_chunk->class;
+  soa_tcache_t * p_tc = bind_tcache (p_soa);
+
+  if (p_tc->mag_count[chunk_class] >= SOA_MAGAZINE_SIZE)
+    {
+      /* Flush half a magazine */
+      int32_t i = 0;
+      (void) tiz_mutex_lock (&(p_soa->mutex));
+      for (i = 0; i < SOA_MAGAZINE_SIZE / 2; ++i)
+        {
+          slice_t * p_old = p_tc->p_mag[chunk_class];
+          p_tc->p_mag[chunk_class] = p_old->p_next_free;
+          depot_free (p_soa, p_old);
+        }
+      (void) tiz_mutex_unlock (&(p_soa->mutex));
+      p_tc->mag_count[chunk_class] -= SOA_MAGAZINE_SIZE / 2;
+    }
+
+  p_slice->p_next_free = p_tc->p_mag[chunk_class];
+  p_tc->p_mag[chunk_class] = p_slice;
+  p_tc->mag_count[chunk_class] += 1;
+}
+
+/*
+ * API
+ */
+
 OMX_ERRORTYPE
 tiz_soa_init (/*@null@ */ tiz_soa_ptr_t * app_soa)
 {
@@ -160,15 +563,45 @@ tiz_soa_init (/*@null@ */ tiz_soa_ptr_t * app_soa)
   return rc;
 }
 
+OMX_ERRORTYPE
+tiz_soa_init_shared (/*@null@ */ tiz_soa_ptr_t * app_soa)
+{
+  tiz_soa_t * p_soa = NULL;
+
+  assert (app_soa);
+
+  tiz_check_omx (tiz_soa_init (&p_soa));
+  if (OMX_ErrorNone != tiz_mutex_init (&(p_soa->mutex)))
+    {
+      tiz_mem_free (p_soa);
+      *app_soa = NULL;
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_soa->shared = true;
+  (void) pthread_mutex_lock (&g_shared_mutex);
+  p_soa->id = g_next_shared_id++;
+  p_soa->p_next_shared = gp_shared_lst;
+  gp_shared_lst = p_soa;
+  (void) pthread_mutex_unlock (&g_shared_mutex);
+
+  *app_soa = p_soa;
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE
 tiz_soa_reserve_chunk (tiz_soa_t * p_soa, int32_t chunk_class)
 {
+  chunk_t * p_chunk = NULL;
+
   assert (p_soa != NULL);
   assert (chunk_class < TIZ_SOA_NUM_CHUNK_CLASSES);
 
-  return alloc_chunk (p_soa, chunk_class) == NULL
-           ? OMX_ErrorInsufficientResources
-           : OMX_ErrorNone;
+  soa_lock (p_soa);
+  p_chunk = alloc_chunk (p_soa, chunk_class);
+  soa_unlock (p_soa);
+
+  return p_chunk == NULL ? OMX_ErrorInsufficientResources : OMX_ErrorNone;
 }
 
 void
@@ -179,6 +612,26 @@ tiz_soa_destroy (tiz_soa_t * p_soa)
       chunk_t * p_chunk = NULL;
       chunk_t * p_next = NULL;
 
+      if (p_soa->shared)
+        {
+          tiz_soa_t ** pp_cur = &gp_shared_lst;
+          (void) pthread_mutex_lock (&g_shared_mutex);
+          while (*pp_cur && *pp_cur != p_soa)
+            {
+              pp_cur = &((*pp_cur)->p_next_shared);
+            }
+          if (*pp_cur)
+            {
+              *pp_cur = p_soa->p_next_shared;
+            }
+          (void) pthread_mutex_unlock (&g_shared_mutex);
+          if (t_cache.p_soa == p_soa)
+            {
+              (void) tiz_mem_set (&t_cache, 0, sizeof (soa_tcache_t));
+            }
+          (void) tiz_mutex_destroy (&(p_soa->mutex));
+        }
+
       p_chunk = p_soa->p_chunk_lst;
 
       while (p_chunk != NULL)
@@ -195,38 +648,39 @@ tiz_soa_destroy (tiz_soa_t * p_soa)
 /*@null@*/ void *
 tiz_soa_calloc (tiz_soa_t * p_soa, size_t size)
 {
-  size_t alloc_sz = ((size + SOA_SLICE_ALIGN - 1) & ~(SOA_SLICE_ALIGN - 1))
-                    + SLICE_PREAMBLE_SZ;
+  const size_t alloc_sz = get_alloc_sz (size);
+  slice_t * p_slice = NULL;
   uint8_t * p_usr = NULL;
 
   assert (p_soa);
   assert (alloc_sz > 0);
-  assert (alloc_sz <= SOA_MAX_SLICE_SIZE);
-
-  {
-    int32_t chunk_class = chunk_class_tbl[alloc_sz / SOA_SLICE_ALIGN];
-    slice_t * p_slice = NULL;
-
-    p_slice = p_soa->p_slice_store[chunk_class];
-
-    if (NULL == p_slice)
-      {
-        p_slice = alloc_chunk (p_soa, chunk_class);
-      }
-    else
-      {
-        p_soa->p_slice_store[chunk_class] = p_slice->p_next_free;
-      }
-
-    if (p_slice)
-      {
-        p_slice->p_chunk->n_allocated_slices += 1;
-        p_soa->n_allocated_objects += 1;
-        p_slice->size = alloc_sz;
-        p_usr = get_usr_ptr (p_slice);
-        (void) tiz_mem_set (p_usr, 0, size);
-      }
-  }
+
+  if (alloc_sz > SOA_MAX_SLICE_SIZE)
+    {
+      /* Too big for a slice; heap memory is already zeroed */
+      if ((p_slice = heap_alloc (p_soa, alloc_sz)))
+        {
+          p_slice->size = alloc_sz;
+          p_usr = get_usr_ptr (p_slice);
+        }
+      return p_usr;
+    }
+
+  if (p_soa->shared)
+    {
+      p_slice = tcache_alloc (p_soa, get_chunk_class (alloc_sz));
+    }
+  else
+    {
+      p_slice = depot_alloc (p_soa, get_chunk_class (alloc_sz));
+    }
+
+  if (p_slice)
+    {
+      p_slice->size = alloc_sz;
+      p_usr = get_usr_ptr (p_slice);
+      (void) tiz_mem_set (p_usr, 0, size);
+    }
 
   return p_usr;
 }
@@ -241,25 +695,27 @@ tiz_soa_free (tiz_soa_t * p_soa, void * p_addr)
       slice_t * p_slice = get_slice_ptr (p_addr);
 
       assert (p_slice != NULL);
-      assert (p_slice->size <= SOA_MAX_SLICE_SIZE);
-      {
-        chunk_t * p_chunk = p_slice->p_chunk;
-        int32_t chunk_class = chunk_class_tbl[p_slice->size / SOA_SLICE_ALIGN];
-
-        assert (p_chunk != NULL);
 
-        p_slice->p_chunk->n_allocated_slices -= 1;
-        p_soa->n_allocated_objects -= 1;
-        p_slice->p_next_free = p_soa->p_slice_store[chunk_class];
-        p_soa->p_slice_store[chunk_class] = p_slice;
-      }
+      if (!p_slice->p_chunk)
+        {
+          assert (p_slice->size > SOA_MAX_SLICE_SIZE);
+          heap_free (p_soa, p_slice);
+        }
+      else if (p_soa->shared)
+        {
+          tcache_free (p_soa, p_slice);
+        }
+      else
+        {
+          assert (p_slice->size <= SOA_MAX_SLICE_SIZE);
+          depot_free (p_soa, p_slice);
+        }
     }
 }
 
 void
 tiz_soa_info (tiz_soa_t * p_soa, tiz_soa_info_t * p_info)
 {
-  int32_t i = 0;
   chunk_t * p_chunk = NULL;
 
   assert (p_soa != NULL);
@@ -267,20 +723,30 @@ tiz_soa_info (tiz_soa_t * p_soa, tiz_soa_info_t * p_info)
 
   (void) tiz_mem_set (p_info, 0, sizeof (tiz_soa_info_t));
 
-  p_info->chunks = p_soa->n_chunks;
-  p_chunk = p_soa->p_chunk_lst;
+  soa_lock (p_soa);
 
-  for (i = p_soa->n_chunks; i > 0; --i)
+  for (p_chunk = p_soa->p_chunk_lst; p_chunk; p_chunk = p_chunk->p_next)
     {
-      p_info->slices[p_chunk->class] = p_chunk->n_allocated_slices;
-      p_chunk = p_chunk->p_next;
+      p_info->slices[p_chunk->class] += p_chunk->n_allocated_slices;
     }
 
-  assert (p_chunk == NULL);
-
   p_info->chunks = p_soa->n_chunks;
   p_info->objects = p_soa->n_allocated_objects;
+  p_info->large_objects
+    = __atomic_load_n (&(p_soa->n_large_objects), __ATOMIC_RELAXED);
+  p_info->reclaimed_chunks = p_soa->n_reclaimed_chunks;
+  p_info->hits = p_soa->hits;
+  if (t_cache.p_soa == p_soa && t_cache.soa_id == p_soa->id)
+    {
+      /* Other threads' magazine hits are added when they unbind */
+      p_info->hits += t_cache.hits;
+    }
+  p_info->misses = __atomic_load_n (&(p_soa->misses), __ATOMIC_RELAXED);
+
+  soa_unlock (p_soa);
 
-  TIZ_LOG (TIZ_PRIORITY_TRACE, "objects [%d] chunks [%d]", p_info->objects,
-           p_info->chunks);
+  TIZ_LOG (TIZ_PRIORITY_TRACE,
+           "objects [%d] chunks [%d] hits [%llu] misses [%llu]",
+           p_info->objects, p_info->chunks, (unsigned long long) p_info->hits,
+           (unsigned long long) p_info->misses);
 }
@@ -39,14 +39,22 @@ extern "C" {
 #include <OMX_Types.h>
 #include <OMX_Core.h>
 
-#define TIZ_SOA_NUM_CHUNK_CLASSES 5
+/* Slices of up to 4 KiB (including an internal 16-byte preamble); bigger
+   objects are served from the heap */
+#define TIZ_SOA_NUM_CHUNK_CLASSES 13
 
 typedef struct tiz_soa tiz_soa_t;
 typedef /*@null@ */ tiz_soa_t * tiz_soa_ptr_t;
 
+/* An allocator for use by one thread at a time */
 OMX_ERRORTYPE
 tiz_soa_init (/*@null@ */ tiz_soa_ptr_t * app_soa);
 
+/* A thread-safe allocator. Each thread keeps a magazine of free slices per
+   class for the last shared allocator it used */
+OMX_ERRORTYPE
+tiz_soa_init_shared (/*@null@ */ tiz_soa_ptr_t * app_soa);
+
 void
 tiz_soa_destroy (tiz_soa_t * p_soa);
 
@@ -68,8 +76,19 @@ struct tiz_soa_info
   int32_t objects;
   /* Number of slices currently in use in each chunk class */
   int32_t slices[TIZ_SOA_NUM_CHUNK_CLASSES];
+  /* Number of objects currently allocated from the heap, as they are too
+     big for a slice */
+  int32_t large_objects;
+  /* Total number of chunks given back to the heap after becoming free */
+  int32_t reclaimed_chunks;
+  /* Allocations served from existing slices */
+  uint64_t hits;
+  /* Allocations that needed a new chunk or heap memory */
+  uint64_t misses;
 };
 
+/* In shared allocators, slices held in the per-thread magazines are counted
+   as in use */
 void
 tiz_soa_info (tiz_soa_t * p_soa, tiz_soa_info_t * p_info);
 
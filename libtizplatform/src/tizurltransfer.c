@@ -32,6 +32,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -165,6 +166,26 @@ struct httpsrc_curl_state_id_str
   const char * str;
 };
 
+/* The DNS cache and the TLS session cache are shared by all the transfers in
+   the process. A transfer to a host that another transfer (possibly from a
+   different component) has recently visited can then skip name resolution
+   and resume the TLS session with an abbreviated handshake. The share handle
+   is created with the first transfer object and then lives for the rest of
+   the process, so that the caches survive the destruction of the components
+   that filled them (e.g. when the player moves on to the next playlist and
+   rebuilds its graph). Connections are not shared: each transfer runs its
+   own multi handle on its component's thread, and libcurl does not support
+   sharing a connection cache among threads. */
+typedef struct tiz_urltrans_share tiz_urltrans_share_t;
+struct tiz_urltrans_share
+{
+  CURLSH * p_share;
+  pthread_mutex_t locks[CURL_LOCK_DATA_LAST];
+};
+
+static pthread_mutex_t g_curl_share_mutex = PTHREAD_MUTEX_INITIALIZER;
+static tiz_urltrans_share_t g_curl_share;
+
 static const httpsrc_curl_state_id_str_t httpsrc_curl_state_id_str_tbl[]
   = {{ECurlStateStopped, (const OMX_STRING) "ECurlStateStopped"},
      {ECurlStateConnecting, (const OMX_STRING) "ECurlStateConnecting"},
@@ -193,10 +214,13 @@ struct tiz_urltrans
   tiz_event_timer_t * p_ev_reconnect_timer_;
   bool awaiting_reconnect_timer_ev_;
   tiz_buffer_t * p_store_;
+  size_t ring_bytes_; /* capacity of p_store_, or 0 if not a ring buffer */
   int internal_buffer_size_;
   int internal_buffer_size_initial_;
   CURL * p_curl_;        /* curl easy */
   CURLM * p_curl_multi_; /* curl multi */
+  CURLSH * p_curl_share_; /* process-wide curl share, or NULL */
+  bool http2_;
   struct curl_slist * p_http_ok_aliases_;
   struct curl_slist * p_http_headers_;
   httpsrc_curl_state_id_t curl_state_;
@@ -362,6 +386,16 @@ start_curl (tiz_urltrans_t * ap_trans)
   bail_on_curl_error (curl_easy_setopt (ap_trans->p_curl_, CURLOPT_HTTPHEADER,
                                         ap_trans->p_http_headers_));
 
+#if LIBCURL_VERSION_NUM >= 0x072f00
+  if (ap_trans->http2_)
+    {
+      /* Negotiated via ALPN, i.e. only over TLS. Plain HTTP (e.g. Icecast
+         and SHOUTcast streams) stays on HTTP/1.x */
+      bail_on_curl_error (curl_easy_setopt (
+        ap_trans->p_curl_, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS));
+    }
+#endif
+
   /* #ifdef _DEBUG */
   curl_easy_setopt (ap_trans->p_curl_, CURLOPT_VERBOSE, 1);
   curl_easy_setopt (ap_trans->p_curl_, CURLOPT_DEBUGDATA, ap_trans);
@@ -546,7 +580,10 @@ kickstart_curl_socket (tiz_urltrans_t * ap_trans, int * ap_running_handles)
       on_curl_multi_error_ret_omx_oom (curl_multi_socket_action (
         ap_trans->p_curl_multi_, CURL_SOCKET_TIMEOUT, 0, ap_running_handles));
     }
-  while (0 == ap_trans->curl_timeout_);
+  /* NOTE: A short response (e.g. from a nearby server, or over a connection
+     that this multi handle has kept alive) may complete within this loop;
+     libcurl does not necessarily update the timer after that */
+  while (0 == ap_trans->curl_timeout_ && *ap_running_handles > 0);
 
   return OMX_ErrorNone;
 }
@@ -728,10 +765,15 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
 
           if (nbytes > 0)
             {
+              size_t room = 0;
+              void * p_dst
+                = tiz_buffer_write_span (p_trans->p_store_, nbytes, &room);
               if (tiz_buffer_available (p_trans->p_store_)
-                  > (2 * p_trans->internal_buffer_size_))
+                    > (2 * p_trans->internal_buffer_size_)
+                  || room < nbytes)
                 {
-                  /* This is to pause curl */
+                  /* This is to pause curl; it will deliver the same data
+                     again once resumed */
                   TIZ_PRINTF_DBG_GRN ("Pausing curl - cache size [%d]",
                                       tiz_buffer_available (p_trans->p_store_));
                   rc = CURL_WRITEFUNC_PAUSE;
@@ -742,16 +784,8 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
                 }
               else
                 {
-                  int nbytes_available = 0;
-                  if ((nbytes_available
-                       = tiz_buffer_push (p_trans->p_store_, ptr, nbytes))
-                      < nbytes)
-                    {
-                      TIZ_LOG (TIZ_PRIORITY_ERROR,
-                               "Unable to store all the data (wanted %d, "
-                               "stored %d).",
-                               nbytes, nbytes_available);
-                    }
+                  memcpy (p_dst, ptr, nbytes);
+                  (void) tiz_buffer_commit (p_trans->p_store_, nbytes);
                 }
             }
         }
@@ -899,6 +933,82 @@ curl_timer_cback (CURLM * multi, long timeout_ms, void * userp)
   return 0;
 }
 
+static void
+curl_share_lock_cback (CURL * ap_curl, curl_lock_data a_data,
+                       curl_lock_access a_access, void * ap_userp)
+{
+  tiz_urltrans_share_t * p_share = ap_userp;
+  (void) ap_curl;
+  (void) a_access;
+  assert (p_share);
+  assert (a_data < CURL_LOCK_DATA_LAST);
+  (void) pthread_mutex_lock (&(p_share->locks[a_data]));
+}
+
+static void
+curl_share_unlock_cback (CURL * ap_curl, curl_lock_data a_data,
+                         void * ap_userp)
+{
+  tiz_urltrans_share_t * p_share = ap_userp;
+  (void) ap_curl;
+  assert (p_share);
+  assert (a_data < CURL_LOCK_DATA_LAST);
+  (void) pthread_mutex_unlock (&(p_share->locks[a_data]));
+}
+
+static CURLSH *
+create_curl_share (tiz_urltrans_share_t * ap_share)
+{
+  CURLSH * p_sh = NULL;
+  int i = 0;
+
+  assert (ap_share);
+
+  if ((p_sh = curl_share_init ()))
+    {
+      for (i = 0; i < CURL_LOCK_DATA_LAST; ++i)
+        {
+          (void) pthread_mutex_init (&(ap_share->locks[i]), NULL);
+        }
+      (void) curl_share_setopt (p_sh, CURLSHOPT_LOCKFUNC,
+                                curl_share_lock_cback);
+      (void) curl_share_setopt (p_sh, CURLSHOPT_UNLOCKFUNC,
+                                curl_share_unlock_cback);
+      (void) curl_share_setopt (p_sh, CURLSHOPT_USERDATA, ap_share);
+      (void) curl_share_setopt (p_sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+      (void) curl_share_setopt (p_sh, CURLSHOPT_SHARE,
+                                CURL_LOCK_DATA_SSL_SESSION);
+    }
+  return p_sh;
+}
+
+static CURLSH *
+acquire_curl_share (void)
+{
+  CURLSH * p_sh = NULL;
+
+  if (0 == tiz_rcfile_compare_value ("ilcore", "http-cache-sharing",
+                                     "false"))
+    {
+      return NULL;
+    }
+
+  (void) pthread_mutex_lock (&g_curl_share_mutex);
+  if (!g_curl_share.p_share)
+    {
+      /* The share keeps its own reference to libcurl's global state, as it
+         outlives the transfer objects */
+      if (CURLE_OK == curl_global_init (CURL_GLOBAL_ALL))
+        {
+          g_curl_share.p_share = create_curl_share (&g_curl_share);
+        }
+    }
+  p_sh = g_curl_share.p_share;
+  (void) pthread_mutex_unlock (&g_curl_share_mutex);
+
+  return p_sh;
+}
+
 static OMX_ERRORTYPE
 allocate_curl_global_resources (tiz_urltrans_t * ap_trans)
 {
@@ -910,16 +1020,61 @@ end:
   return rc;
 }
 
+/* The store never needs to hold more than twice the internal buffer size,
+   plus one write callback's worth of data; see curl_write_cback */
+static size_t
+ring_bytes_needed (const tiz_urltrans_t * ap_trans)
+{
+  assert (ap_trans);
+  return MAX (ap_trans->store_bytes_,
+              2 * (size_t) ap_trans->internal_buffer_size_)
+         + CURL_MAX_WRITE_SIZE;
+}
+
 static OMX_ERRORTYPE
 allocate_temp_data_store (tiz_urltrans_t * ap_trans)
 {
   assert (ap_trans);
   assert (ap_trans->p_store_ == NULL);
-  tiz_check_omx (
-    tiz_buffer_init (&(ap_trans->p_store_), ap_trans->store_bytes_));
+  /* A ring buffer avoids compacting the store on every write callback and
+     caps its memory use. Fall back to a dynamic buffer if the platform
+     does not support it. */
+  if (OMX_ErrorNone
+      == tiz_buffer_ring_init (&(ap_trans->p_store_),
+                               ring_bytes_needed (ap_trans)))
+    {
+      ap_trans->ring_bytes_ = ring_bytes_needed (ap_trans);
+    }
+  else
+    {
+      ap_trans->ring_bytes_ = 0;
+      tiz_check_omx (
+        tiz_buffer_init (&(ap_trans->p_store_), ap_trans->store_bytes_));
+    }
   return OMX_ErrorNone;
 }
 
+static void
+resize_temp_data_store (tiz_urltrans_t * ap_trans)
+{
+  tiz_buffer_t * p_new_store = NULL;
+  assert (ap_trans);
+  assert (ap_trans->p_store_);
+
+  if (ap_trans->ring_bytes_ > 0
+      && ap_trans->ring_bytes_ < ring_bytes_needed (ap_trans)
+      && OMX_ErrorNone
+           == tiz_buffer_ring_init (&p_new_store,
+                                    ring_bytes_needed (ap_trans)))
+    {
+      (void) tiz_buffer_push (p_new_store, tiz_buffer_get (ap_trans->p_store_),
+                              tiz_buffer_available (ap_trans->p_store_));
+      tiz_buffer_destroy (ap_trans->p_store_);
+      ap_trans->p_store_ = p_new_store;
+      ap_trans->ring_bytes_ = ring_bytes_needed (ap_trans);
+    }
+}
+
 static inline void
 destroy_temp_data_store (
   /*@special@ */ tiz_urltrans_t * ap_trans)
@@ -986,10 +1141,20 @@ allocate_curl_resources (tiz_urltrans_t * ap_trans)
   if (p_version_info)
     {
       ap_trans->curl_version_ = p_version_info->version_num;
+      ap_trans->http2_
+        = ((p_version_info->features & CURL_VERSION_HTTP2)
+           && 0 != tiz_rcfile_compare_value ("ilcore", "http2", "false"));
     }
 
   /* Init the curl easy handle */
   tiz_check_null_ret_oom ((ap_trans->p_curl_ = curl_easy_init ()) != NULL);
+  /* Hook it up to the process-wide DNS and TLS session caches; transfers
+     still work (only slower to start) without them */
+  if ((ap_trans->p_curl_share_ = acquire_curl_share ()))
+    {
+      bail_on_curl_error (curl_easy_setopt (ap_trans->p_curl_, CURLOPT_SHARE,
+                                            ap_trans->p_curl_share_));
+    }
   /* Now init the curl multi handle */
   bail_on_oom ((ap_trans->p_curl_multi_ = curl_multi_init ()));
   /* this is to ask libcurl to accept ICY OK headers*/
@@ -1025,6 +1190,8 @@ destroy_curl_resources (tiz_urltrans_t * ap_trans)
   ap_trans->p_curl_multi_ = NULL;
   curl_easy_cleanup (ap_trans->p_curl_);
   ap_trans->p_curl_ = NULL;
+  /* Not owned */
+  ap_trans->p_curl_share_ = NULL;
 }
 
 OMX_ERRORTYPE
@@ -1076,10 +1243,13 @@ tiz_urltrans_init (tiz_urltrans_ptr_t * app_trans, void * ap_parent,
           p_trans->p_ev_reconnect_timer_ = NULL;
           p_trans->awaiting_reconnect_timer_ev_ = false;
           p_trans->p_store_ = NULL;
+          p_trans->ring_bytes_ = 0;
           p_trans->internal_buffer_size_ = 0;
           p_trans->internal_buffer_size_initial_ = 0;
           p_trans->p_curl_ = NULL;
           p_trans->p_curl_multi_ = NULL;
+          p_trans->p_curl_share_ = NULL;
+          p_trans->http2_ = false;
           p_trans->p_http_ok_aliases_ = NULL;
           p_trans->p_http_headers_ = NULL;
           p_trans->curl_state_ = ECurlStateStopped;
@@ -1116,6 +1286,7 @@ tiz_urltrans_destroy (tiz_urltrans_t * ap_trans)
       destroy_events (ap_trans);
       destroy_curl_resources (ap_trans);
       curl_global_cleanup ();
+      free (ap_trans);
     }
 }
 
@@ -1147,6 +1318,7 @@ tiz_urltrans_set_internal_buffer_size (tiz_urltrans_t * ap_trans,
   URLTRANS_LOG_API_START (ap_trans);
   ap_trans->internal_buffer_size_ = ap_trans->internal_buffer_size_initial_
     = a_nbytes;
+  resize_temp_data_store (ap_trans);
 }
 
 OMX_ERRORTYPE
@@ -1162,6 +1334,12 @@ tiz_urltrans_start (tiz_urltrans_t * ap_trans)
       assert (ap_trans->p_curl_multi_);
       /* Kickstart curl to get one or more callbacks called. */
       tiz_check_omx (kickstart_curl_socket (ap_trans, &running_handles));
+      if (!running_handles)
+        {
+          /* Short responses may complete right here, without a single io
+             event */
+          report_connection_lost_event (ap_trans);
+        }
     }
   URLTRANS_LOG_API_END (ap_trans);
   ASSERT_ASYNC_EVENTS (ap_trans);
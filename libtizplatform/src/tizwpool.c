@@ -0,0 +1,369 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizwpool.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Work-stealing worker thread pool
+ *
+ * Run queues are tiz_lfqueue instances. A worker looks for work in its own
+ * queue first, then in the injection queue and finally in the other
+ * workers' queues. Workers with nothing to do park on a condition variable;
+ * submitters only take the pool mutex when at least one worker is parked.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "tizplatform.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.wpool"
+#endif
+
+#define WPOOL_LOCAL_QUEUE_CAPACITY 256
+#define WPOOL_GLOBAL_QUEUE_CAPACITY 1024
+
+typedef struct tiz_wpool_worker tiz_wpool_worker_t;
+struct tiz_wpool_worker
+{
+  tiz_thread_t thread;
+  tiz_lfqueue_t * p_local;
+  tiz_wpool_t * p_pool;
+  OMX_S32 index;
+};
+
+struct tiz_wpool
+{
+  tiz_wpool_worker_t * p_workers; /* max_threads entries */
+  OMX_S32 nthreads;               /* workers started so far */
+  OMX_S32 base_threads;
+  OMX_S32 max_threads;
+  tiz_lfqueue_t * p_global;
+  tiz_mutex_t mutex;
+  tiz_cond_t cond;
+  uint32_t idle;
+  uint32_t blocked;
+  bool stopping;
+};
+
+static __thread tiz_wpool_worker_t * tp_worker = NULL;
+
+static inline OMX_S32
+get_nthreads (tiz_wpool_t * ap_pool)
+{
+  return __atomic_load_n (&(ap_pool->nthreads), __ATOMIC_ACQUIRE);
+}
+
+static inline tiz_wpool_worker_t *
+current_worker (tiz_wpool_t * ap_pool)
+{
+  return (tp_worker && tp_worker->p_pool == ap_pool) ? tp_worker : NULL;
+}
+
+static tiz_wpool_task_t *
+find_task (tiz_wpool_t * ap_pool, tiz_wpool_worker_t * ap_worker)
+{
+  OMX_PTR p_task = NULL;
+  const OMX_S32 nthreads = get_nthreads (ap_pool);
+  OMX_S32 i = 0;
+
+  if (OMX_ErrorNone == tiz_lfqueue_try_receive (ap_worker->p_local, &p_task)
+      || OMX_ErrorNone == tiz_lfqueue_try_receive (ap_pool->p_global, &p_task))
+    {
+      return p_task;
+    }
+
+  /* Steal, starting with the next worker to spread the contention */
+  for (i = 1; i < nthreads; ++i)
+    {
+      tiz_wpool_worker_t * p_victim
+        = &(ap_pool->p_workers[(ap_worker->index + i) % nthreads]);
+      if (OMX_ErrorNone
+          == tiz_lfqueue_try_receive (p_victim->p_local, &p_task))
+        {
+          return p_task;
+        }
+    }
+
+  return NULL;
+}
+
+static void *
+worker_thread_func (void * ap_arg)
+{
+  tiz_wpool_worker_t * p_worker = ap_arg;
+  tiz_wpool_t * p_pool = NULL;
+  tiz_wpool_task_t * p_task = NULL;
+  char name[16];
+
+  assert (p_worker);
+  p_pool = p_worker->p_pool;
+  assert (p_pool);
+
+  tp_worker = p_worker;
+  snprintf (name, sizeof (name), "wpool-%ld", (long) p_worker->index);
+  (void) tiz_thread_setname (&(p_worker->thread), name);
+
+  for (;;)
+    {
+      if (!(p_task = find_task (p_pool, p_worker)))
+        {
+          (void) tiz_mutex_lock (&(p_pool->mutex));
+          if (p_pool->stopping)
+            {
+              (void) tiz_mutex_unlock (&(p_pool->mutex));
+              break;
+            }
+          (void) __atomic_add_fetch (&(p_pool->idle), 1, __ATOMIC_RELAXED);
+          /* Pairs with the fence in tiz_wpool_submit */
+          __atomic_thread_fence (__ATOMIC_SEQ_CST);
+          if (!(p_task = find_task (p_pool, p_worker)))
+            {
+              (void) tiz_cond_wait (&(p_pool->cond), &(p_pool->mutex));
+            }
+          (void) __atomic_sub_fetch (&(p_pool->idle), 1, __ATOMIC_RELAXED);
+          (void) tiz_mutex_unlock (&(p_pool->mutex));
+        }
+
+      if (p_task)
+        {
+          p_task->pf_run (p_task->p_arg);
+        }
+    }
+
+  tp_worker = NULL;
+  return NULL;
+}
+
+static OMX_ERRORTYPE
+start_worker (tiz_wpool_t * ap_pool)
+{
+  const OMX_S32 index = ap_pool->nthreads;
+  tiz_wpool_worker_t * p_worker = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (index < ap_pool->max_threads);
+
+  p_worker = &(ap_pool->p_workers[index]);
+  p_worker->p_pool = ap_pool;
+  p_worker->index = index;
+  tiz_check_omx (
+    tiz_lfqueue_init (&(p_worker->p_local), WPOOL_LOCAL_QUEUE_CAPACITY));
+
+  if (OMX_ErrorNone
+      != (rc = tiz_thread_create (&(p_worker->thread), 0, 0,
+                                  worker_thread_func, p_worker)))
+    {
+      tiz_lfqueue_destroy (p_worker->p_local);
+      p_worker->p_local = NULL;
+    }
+  else
+    {
+      /* Make the new worker's queue visible to thieves */
+      __atomic_store_n (&(ap_pool->nthreads), index + 1, __ATOMIC_RELEASE);
+    }
+
+  return rc;
+}
+
+OMX_ERRORTYPE
+tiz_wpool_init (tiz_wpool_ptr_t * app_pool, OMX_S32 a_nthreads,
+                OMX_S32 a_max_threads)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  tiz_wpool_t * p_pool = NULL;
+  OMX_S32 i = 0;
+
+  assert (app_pool);
+
+  if (a_nthreads <= 0)
+    {
+      a_nthreads = sysconf (_SC_NPROCESSORS_ONLN);
+      a_nthreads = a_nthreads > 0 ? a_nthreads : 1;
+    }
+
+  if (a_max_threads < a_nthreads)
+    {
+      a_max_threads = a_nthreads;
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "worker pool threads [%ld] max [%ld]",
+           (long) a_nthreads, (long) a_max_threads);
+
+  if (!(p_pool = tiz_mem_calloc (1, sizeof (tiz_wpool_t))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_pool->base_threads = a_nthreads;
+  p_pool->max_threads = a_max_threads;
+
+  if (!(p_pool->p_workers
+        = tiz_mem_calloc (a_max_threads, sizeof (tiz_wpool_worker_t))))
+    {
+      tiz_mem_free (p_pool);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  if (OMX_ErrorNone != (rc = tiz_mutex_init (&(p_pool->mutex)))
+      || OMX_ErrorNone != (rc = tiz_cond_init (&(p_pool->cond)))
+      || OMX_ErrorNone != (rc = tiz_lfqueue_init (
+                             &(p_pool->p_global), WPOOL_GLOBAL_QUEUE_CAPACITY)))
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : while initialising the pool",
+               tiz_err_to_str (rc));
+    }
+
+  for (i = 0; i < a_nthreads && OMX_ErrorNone == rc; ++i)
+    {
+      rc = start_worker (p_pool);
+    }
+
+  if (OMX_ErrorNone != rc)
+    {
+      tiz_wpool_destroy (p_pool);
+      p_pool = NULL;
+    }
+
+  *app_pool = p_pool;
+  return rc;
+}
+
+void
+tiz_wpool_destroy (tiz_wpool_t * ap_pool)
+{
+  if (ap_pool)
+    {
+      OMX_PTR p_result = NULL;
+      OMX_S32 i = 0;
+
+      (void) tiz_mutex_lock (&(ap_pool->mutex));
+      ap_pool->stopping = true;
+      (void) tiz_cond_broadcast (&(ap_pool->cond));
+      (void) tiz_mutex_unlock (&(ap_pool->mutex));
+
+      /* Workers may still be stealing from each other's queues until they
+         have all exited */
+      for (i = 0; i < ap_pool->nthreads; ++i)
+        {
+          (void) tiz_thread_join (&(ap_pool->p_workers[i].thread), &p_result);
+        }
+
+      for (i = 0; i < ap_pool->nthreads; ++i)
+        {
+          tiz_lfqueue_destroy (ap_pool->p_workers[i].p_local);
+        }
+
+      tiz_lfqueue_destroy (ap_pool->p_global);
+      (void) tiz_cond_destroy (&(ap_pool->cond));
+      (void) tiz_mutex_destroy (&(ap_pool->mutex));
+      tiz_mem_free (ap_pool->p_workers);
+      tiz_mem_free (ap_pool);
+    }
+}
+
+OMX_ERRORTYPE
+tiz_wpool_submit (tiz_wpool_t * ap_pool, tiz_wpool_task_t * ap_task)
+{
+  tiz_wpool_worker_t * p_worker = NULL;
+
+  assert (ap_pool);
+  assert (ap_task);
+  assert (ap_task->pf_run);
+
+  /* Tasks submitted from a worker stay local, unless stolen */
+  if (!(p_worker = current_worker (ap_pool))
+      || OMX_ErrorNone != tiz_lfqueue_try_send (p_worker->p_local, ap_task))
+    {
+      tiz_check_omx (tiz_lfqueue_send (ap_pool->p_global, ap_task));
+    }
+
+  /* Pairs with the fence in worker_thread_func */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (__atomic_load_n (&(ap_pool->idle), __ATOMIC_RELAXED) > 0)
+    {
+      tiz_check_omx (tiz_mutex_lock (&(ap_pool->mutex)));
+      (void) tiz_cond_signal (&(ap_pool->cond));
+      tiz_check_omx (tiz_mutex_unlock (&(ap_pool->mutex)));
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_S32
+tiz_wpool_nthreads (tiz_wpool_t * ap_pool)
+{
+  assert (ap_pool);
+  return get_nthreads (ap_pool);
+}
+
+OMX_BOOL
+tiz_wpool_is_worker (tiz_wpool_t * ap_pool)
+{
+  assert (ap_pool);
+  return current_worker (ap_pool) ? OMX_TRUE : OMX_FALSE;
+}
+
+void
+tiz_wpool_block_begin (tiz_wpool_t * ap_pool)
+{
+  assert (ap_pool);
+
+  if (current_worker (ap_pool))
+    {
+      const uint32_t blocked
+        = __atomic_add_fetch (&(ap_pool->blocked), 1, __ATOMIC_ACQ_REL);
+
+      /* Keep at least 'base_threads' workers able to run tasks */
+      if (__atomic_load_n (&(ap_pool->idle), __ATOMIC_RELAXED) == 0)
+        {
+          (void) tiz_mutex_lock (&(ap_pool->mutex));
+          if (!ap_pool->stopping
+              && ap_pool->nthreads - (OMX_S32) blocked < ap_pool->base_threads
+              && ap_pool->nthreads < ap_pool->max_threads)
+            {
+              TIZ_LOG (TIZ_PRIORITY_TRACE, "starting spare worker [%ld]",
+                       (long) ap_pool->nthreads);
+              (void) start_worker (ap_pool);
+            }
+          (void) tiz_mutex_unlock (&(ap_pool->mutex));
+        }
+    }
+}
+
+void
+tiz_wpool_block_end (tiz_wpool_t * ap_pool)
+{
+  assert (ap_pool);
+
+  if (current_worker (ap_pool))
+    {
+      (void) __atomic_sub_fetch (&(ap_pool->blocked), 1, __ATOMIC_ACQ_REL);
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizwpool.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Work-stealing worker thread pool
+ *
+ *
+ */
+
+#ifndef TIZWPOOL_H
+#define TIZWPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup tizwpool Work-stealing worker thread pool
+ *
+ * A fixed pool of worker threads that execute tasks submitted by any
+ * thread. Each worker owns a local run queue; tasks submitted from inside a
+ * worker go to that worker's queue, and idle workers steal from the others.
+ * Tasks submitted from outside the pool go to a shared injection queue.
+ *
+ * Workers that are about to block (e.g. waiting for a reply from another
+ * task) must bracket the wait with tiz_wpool_block_begin and
+ * tiz_wpool_block_end, so that the pool can start a spare worker and keep
+ * making progress.
+ *
+ * @ingroup libtizplatform
+ */
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * Worker pool opaque structure.
+ * @ingroup tizwpool
+ */
+typedef struct tiz_wpool tiz_wpool_t;
+typedef /*@null@ */ tiz_wpool_t * tiz_wpool_ptr_t;
+
+/**
+ * Task execution function.
+ * @ingroup tizwpool
+ */
+typedef void (*tiz_wpool_task_f) (void * ap_arg);
+
+/**
+ * A unit of work. Tasks are owned by the submitter, and must remain valid
+ * until they have been executed. A task must not be submitted again before
+ * its previous execution has started.
+ * @ingroup tizwpool
+ */
+typedef struct tiz_wpool_task tiz_wpool_task_t;
+struct tiz_wpool_task
+{
+  tiz_wpool_task_f pf_run;
+  void * p_arg;
+};
+
+/**
+ * Create a worker pool.
+ *
+ * @ingroup tizwpool
+ *
+ * @param app_pool The new pool (output).
+ *
+ * @param a_nthreads Number of worker threads. If zero or less, the number of
+ * online processors is used.
+ *
+ * @param a_max_threads Upper bound for the number of threads, including the
+ * spare workers started while other workers are blocked. If smaller than
+ * the number of worker threads, no spare workers are started.
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorInsufficientResources otherwise.
+ */
+OMX_ERRORTYPE
+tiz_wpool_init (/*@out@*/ tiz_wpool_ptr_t * app_pool, OMX_S32 a_nthreads,
+                OMX_S32 a_max_threads);
+
+/**
+ * Stop and join all worker threads and destroy the pool. Tasks that have not
+ * started yet are discarded.
+ *
+ * @ingroup tizwpool
+ */
+void
+tiz_wpool_destroy (/*@null@ */ tiz_wpool_t * ap_pool);
+
+/**
+ * Submit a task for execution.
+ *
+ * @ingroup tizwpool
+ */
+OMX_ERRORTYPE
+tiz_wpool_submit (tiz_wpool_t * ap_pool, tiz_wpool_task_t * ap_task);
+
+/**
+ * Retrieve the number of worker threads currently running in the pool.
+ *
+ * @ingroup tizwpool
+ */
+OMX_S32
+tiz_wpool_nthreads (tiz_wpool_t * ap_pool);
+
+/**
+ * Whether the calling thread is one of the pool's workers.
+ *
+ * @ingroup tizwpool
+ */
+OMX_BOOL
+tiz_wpool_is_worker (tiz_wpool_t * ap_pool);
+
+/**
+ * Notify the pool that the calling worker is about to block. No-op if the
+ * caller is not a worker of this pool.
+ *
+ * @ingroup tizwpool
+ */
+void
+tiz_wpool_block_begin (tiz_wpool_t * ap_pool);
+
+/**
+ * Notify the pool that the calling worker is no longer blocked.
+ *
+ * @ingroup tizwpool
+ */
+void
+tiz_wpool_block_end (tiz_wpool_t * ap_pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZWPOOL_H */
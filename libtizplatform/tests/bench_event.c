@@ -0,0 +1,226 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_event.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Micro-benchmark: event loop dispatch latency
+ *
+ * Measures p50/p99 latency between a file descriptor becoming readable and
+ * its io watcher's callback being invoked, with N concurrent watchers. Each
+ * watcher is level-triggered and 'once', so it is re-armed from its callback,
+ * like the watchers of the http source components. The number of event loop
+ * shards is taken from the 'event-loop-shards' key in tizonia.conf (use
+ * TIZONIA_RC_FILE to point to a different file). Usage:
+ *
+ *   bench_event [rounds] [max-watchers]
+ *
+ */
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/tizplatform.h"
+
+#define BENCH_DEFAULT_ROUNDS 2000
+#define BENCH_DEFAULT_WATCHERS 256
+
+typedef struct bench_watcher bench_watcher_t;
+struct bench_watcher
+{
+  tiz_event_io_t * p_ev_io;
+  int fds[2];
+  uint32_t id;
+  uint64_t * p_lat;
+  long nlat;
+};
+
+typedef struct bench_state bench_state_t;
+struct bench_state
+{
+  tiz_mutex_t mutex;
+  tiz_sem_t sem;
+  int nwatchers;
+  int ndone;
+};
+
+static bench_state_t g_state;
+
+static inline uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static int
+cmp_u64 (const void * ap_a, const void * ap_b)
+{
+  const uint64_t a = *(const uint64_t *) ap_a;
+  const uint64_t b = *(const uint64_t *) ap_b;
+  return (a > b) - (a < b);
+}
+
+static void
+io_cback (void * ap_arg0, tiz_event_io_t * ap_ev_io, void * ap_arg1,
+          const uint32_t a_id, int a_fd, int a_events)
+{
+  bench_watcher_t * p_w = ap_arg0;
+  uint64_t sent_ns = 0;
+
+  assert (p_w);
+  if (sizeof (sent_ns) == read (a_fd, &sent_ns, sizeof (sent_ns)))
+    {
+      p_w->p_lat[p_w->nlat++] = now_ns () - sent_ns;
+    }
+
+  (void) tiz_event_io_start (ap_ev_io, ++p_w->id);
+
+  (void) tiz_mutex_lock (&(g_state.mutex));
+  if (++g_state.ndone == g_state.nwatchers)
+    {
+      (void) tiz_sem_post (&(g_state.sem));
+    }
+  (void) tiz_mutex_unlock (&(g_state.mutex));
+}
+
+static void
+run_one (const int a_nwatchers, const long a_nrounds)
+{
+  const long total = a_nwatchers * a_nrounds;
+  bench_watcher_t * p_ws = calloc (a_nwatchers, sizeof (bench_watcher_t));
+  uint64_t * p_lat = calloc (total, sizeof (uint64_t));
+  uint64_t start = 0;
+  uint64_t elapsed = 0;
+  long r = 0;
+  int i = 0;
+
+  assert (p_ws && p_lat);
+
+  g_state.nwatchers = a_nwatchers;
+  for (i = 0; i < a_nwatchers; ++i)
+    {
+      bench_watcher_t * p_w = &p_ws[i];
+      if (0 != pipe (p_w->fds))
+        {
+          perror ("pipe");
+          exit (EXIT_FAILURE);
+        }
+      (void) fcntl (p_w->fds[0], F_SETFL, O_NONBLOCK);
+      p_w->p_lat = p_lat + i * a_nrounds;
+      /* The watcher itself is the key used to pick its shard */
+      (void) tiz_event_io_init (&(p_w->p_ev_io), p_w, io_cback, NULL);
+      tiz_event_io_set (p_w->p_ev_io, p_w->fds[0], TIZ_EVENT_READ, true);
+      (void) tiz_event_io_start (p_w->p_ev_io, ++p_w->id);
+    }
+
+  start = now_ns ();
+  for (r = 0; r < a_nrounds; ++r)
+    {
+      (void) tiz_mutex_lock (&(g_state.mutex));
+      g_state.ndone = 0;
+      (void) tiz_mutex_unlock (&(g_state.mutex));
+
+      for (i = 0; i < a_nwatchers; ++i)
+        {
+          const uint64_t sent_ns = now_ns ();
+          if (sizeof (sent_ns)
+              != write (p_ws[i].fds[1], &sent_ns, sizeof (sent_ns)))
+            {
+              perror ("write");
+              exit (EXIT_FAILURE);
+            }
+        }
+      (void) tiz_sem_wait (&(g_state.sem));
+    }
+  elapsed = now_ns () - start;
+
+  for (i = 0; i < a_nwatchers; ++i)
+    {
+      (void) tiz_event_io_stop (p_ws[i].p_ev_io);
+      tiz_event_io_destroy (p_ws[i].p_ev_io);
+    }
+  /* Give the loops a chance to process the destroy requests before the
+     pipes go away */
+  usleep (100000);
+
+  for (i = 0; i < a_nwatchers; ++i)
+    {
+      close (p_ws[i].fds[0]);
+      close (p_ws[i].fds[1]);
+    }
+
+  qsort (p_lat, total, sizeof (uint64_t), cmp_u64);
+  printf ("shards %2u watchers %4d : %12.0f events/sec  p50 %8.2f us  p99 "
+          "%8.2f us\n",
+          tiz_event_loop_shards (), a_nwatchers,
+          (double) total * 1e9 / elapsed, p_lat[total / 2] / 1e3,
+          p_lat[(total * 99) / 100] / 1e3);
+
+  free (p_lat);
+  free (p_ws);
+}
+
+int
+main (int argc, char ** argv)
+{
+  const long nrounds = argc > 1 ? atol (argv[1]) : BENCH_DEFAULT_ROUNDS;
+  const int max_watchers
+    = argc > 2 ? atoi (argv[2]) : BENCH_DEFAULT_WATCHERS;
+  int nwatchers = 0;
+
+  tiz_log_init ();
+
+  if (OMX_ErrorNone != tiz_event_loop_init ())
+    {
+      fprintf (stderr, "Unable to start the event loop (is tizonia.conf "
+                       "available?)\n");
+      return EXIT_FAILURE;
+    }
+
+  (void) tiz_mutex_init (&(g_state.mutex));
+  (void) tiz_sem_init (&(g_state.sem), 0);
+
+  for (nwatchers = 1; nwatchers <= max_watchers; nwatchers *= 4)
+    {
+      run_one (nwatchers, nrounds);
+    }
+
+  tiz_event_loop_destroy ();
+  (void) tiz_sem_destroy (&(g_state.sem));
+  (void) tiz_mutex_destroy (&(g_state.mutex));
+
+  tiz_log_deinit ();
+
+  return EXIT_SUCCESS;
+}
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
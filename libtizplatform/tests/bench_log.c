@@ -0,0 +1,142 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_log.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Micro-benchmark: cost of a log call on the caller's thread
+ *
+ * N threads log M messages each, with a format string typical of the
+ * components' trace messages, and the average time spent in each call is
+ * reported. Which messages are written out (and where) depends on the log4c
+ * configuration (see LOG4C_RCPATH). The asynchronous backend is selected with
+ * TIZONIA_LOG_ASYNC=true, or the 'log-async' key in tizonia.conf. Usage:
+ *
+ *   bench_log [messages-per-thread] [max-threads]
+ *
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/tizplatform.h"
+
+#define BENCH_DEFAULT_MESSAGES 100000
+#define BENCH_DEFAULT_THREADS 8
+
+typedef struct bench_thread bench_thread_t;
+struct bench_thread
+{
+  pthread_t thread;
+  long nmsgs;
+  int priority;
+  uint64_t elapsed_ns;
+};
+
+static inline uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void *
+bench_thread_func (void * ap_arg)
+{
+  bench_thread_t * p_t = ap_arg;
+  const uint64_t start = now_ns ();
+  long i = 0;
+
+  assert (p_t);
+  for (i = 0; i < p_t->nmsgs; ++i)
+    {
+      TIZ_LOG (p_t->priority, "[OMX.Aratelia.bench] : HEADER [%p] nFilledLen "
+                              "[%u] nOffset [%u] nFlags [%x] ts [%lld] - %s",
+               (void *) p_t, (unsigned) i, 0u, 0x10u, (long long) i * 1000,
+               "ok");
+    }
+  p_t->elapsed_ns = now_ns () - start;
+  return NULL;
+}
+
+static void
+run_one (const int a_nthreads, const long a_nmsgs, const int a_priority,
+         const char * ap_label)
+{
+  bench_thread_t * p_ts = calloc (a_nthreads, sizeof (bench_thread_t));
+  uint64_t total_ns = 0;
+  int i = 0;
+
+  assert (p_ts);
+  for (i = 0; i < a_nthreads; ++i)
+    {
+      p_ts[i].nmsgs = a_nmsgs;
+      p_ts[i].priority = a_priority;
+      if (0 != pthread_create (&(p_ts[i].thread), NULL, bench_thread_func,
+                               &p_ts[i]))
+        {
+          perror ("pthread_create");
+          exit (EXIT_FAILURE);
+        }
+    }
+
+  for (i = 0; i < a_nthreads; ++i)
+    {
+      (void) pthread_join (p_ts[i].thread, NULL);
+      total_ns += p_ts[i].elapsed_ns;
+    }
+
+  printf ("%-6s threads %2d : %10.1f ns/call\n", ap_label, a_nthreads,
+          (double) total_ns / ((double) a_nthreads * a_nmsgs));
+
+  free (p_ts);
+}
+
+int
+main (int argc, char ** argv)
+{
+  const long nmsgs = argc > 1 ? atol (argv[1]) : BENCH_DEFAULT_MESSAGES;
+  const int max_threads = argc > 2 ? atoi (argv[2]) : BENCH_DEFAULT_THREADS;
+  int nthreads = 0;
+
+  tiz_log_init ();
+
+  for (nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+    {
+      run_one (nthreads, nmsgs, TIZ_PRIORITY_TRACE, "trace");
+      run_one (nthreads, nmsgs, TIZ_PRIORITY_ERROR, "error");
+    }
+
+  tiz_log_deinit ();
+
+  return EXIT_SUCCESS;
+}
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -0,0 +1,174 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_pcm.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Micro-benchmark: PCM processing kernels
+ *
+ * Measures the throughput (samples/sec) of the gain, clip and byte swap
+ * kernels, for each sample format and each implementation available on this
+ * CPU. Buffers are sized like a typical renderer buffer. Usage:
+ *
+ *   bench_pcm [iterations]
+ *
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/tizplatform.h"
+
+#define BENCH_PCM_NSAMPLES 8192 /* e.g. 4096 stereo frames */
+#define BENCH_PCM_DEFAULT_ITERATIONS 20000
+
+typedef enum bench_pcm_op bench_pcm_op_t;
+enum bench_pcm_op
+{
+  EBenchPcmGain = 0,
+  EBenchPcmClip,
+  EBenchPcmSwap,
+  EBenchPcmInterleave
+};
+
+static const char *op_names[] = {"gain", "clip", "swap", "ilv"};
+
+/* Planar 24-bit stereo source for the interleaving runs */
+static int32_t g_planar[2][BENCH_PCM_NSAMPLES / 2];
+static const char *fmt_names[] = {"s16", "s24", "s32", "f32"};
+
+static inline uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void
+fill (void *ap_buf, tiz_pcm_fmt_t a_fmt)
+{
+  size_t i;
+  if (ETIZPcmFmtF32 == a_fmt)
+    {
+      float *p = ap_buf;
+      for (i = 0; i < BENCH_PCM_NSAMPLES; i++)
+        {
+          p[i] = ((float) (i % 200) - 100.0f) / 100.0f;
+        }
+    }
+  else
+    {
+      uint8_t *p = ap_buf;
+      for (i = 0; i < BENCH_PCM_NSAMPLES * tiz_pcm_fmt_size (a_fmt); i++)
+        {
+          p[i] = (uint8_t) (i * 31);
+        }
+    }
+}
+
+static void
+fill_planar (void)
+{
+  size_t i;
+  for (i = 0; i < BENCH_PCM_NSAMPLES / 2; i++)
+    {
+      g_planar[0][i] = (int32_t) ((i * 7919) % 0x1000000) - 0x800000;
+      g_planar[1][i] = -g_planar[0][i];
+    }
+}
+
+static void
+run (void *ap_buf, bench_pcm_op_t a_op, tiz_pcm_fmt_t a_fmt, long a_iters)
+{
+  uint64_t start, elapsed;
+  long i;
+
+  fill (ap_buf, a_fmt);
+  start = now_ns ();
+  for (i = 0; i < a_iters; i++)
+    {
+      switch (a_op)
+        {
+          case EBenchPcmGain:
+            /* Alternate so that samples neither vanish nor stay saturated */
+            tiz_pcm_gain (ap_buf, BENCH_PCM_NSAMPLES, a_fmt,
+                          (i & 1) ? 1.25f : 0.8f);
+            break;
+          case EBenchPcmClip:
+            tiz_pcm_clip (ap_buf, BENCH_PCM_NSAMPLES, a_fmt);
+            break;
+          case EBenchPcmSwap:
+            tiz_pcm_swap (ap_buf, BENCH_PCM_NSAMPLES, a_fmt);
+            break;
+          case EBenchPcmInterleave:
+            {
+              const int32_t *from[2] = {g_planar[0], g_planar[1]};
+              tiz_pcm_interleave_s32 (ap_buf, a_fmt, from, 2, 0,
+                                      BENCH_PCM_NSAMPLES / 2, 24);
+            }
+            break;
+        };
+    }
+  elapsed = now_ns () - start;
+
+  printf ("%-6s %-4s %-4s : %14.0f samples/sec\n",
+          tiz_pcm_isa_to_str (tiz_pcm_get_isa ()), op_names[a_op],
+          fmt_names[a_fmt],
+          (double) BENCH_PCM_NSAMPLES * a_iters * 1e9 / (double) elapsed);
+}
+
+int
+main (int argc, char **argv)
+{
+  const long iters = argc > 1 ? atol (argv[1]) : BENCH_PCM_DEFAULT_ITERATIONS;
+  void *p_buf = malloc (BENCH_PCM_NSAMPLES * sizeof (int32_t));
+  int isa, fmt;
+
+  if (!p_buf || iters <= 0)
+    {
+      fprintf (stderr, "usage: %s [iterations]\n", argv[0]);
+      free (p_buf);
+      return EXIT_FAILURE;
+    }
+
+  fill_planar ();
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; isa++)
+    {
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+      for (fmt = ETIZPcmFmtS16; fmt < ETIZPcmFmtMax; fmt++)
+        {
+          run (p_buf, EBenchPcmGain, fmt, iters);
+          run (p_buf, EBenchPcmSwap, fmt, iters);
+          run (p_buf, EBenchPcmInterleave, fmt, iters);
+        }
+      run (p_buf, EBenchPcmClip, ETIZPcmFmtF32, iters);
+    }
+
+  free (p_buf);
+  return EXIT_SUCCESS;
+}
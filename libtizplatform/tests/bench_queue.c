@@ -0,0 +1,234 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_queue.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Micro-benchmark: tiz_queue vs tiz_lfqueue
+ *
+ * Measures throughput (msgs/sec) and p50/p99 enqueue-to-dispatch latency
+ * with N producers and a single consumer, which is the access pattern of the
+ * component scheduler's message queue. Usage:
+ *
+ *   bench_queue [messages-per-producer] [max-producers]
+ *
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/tizplatform.h"
+
+#define BENCH_QUEUE_CAPACITY 32 /* same as the scheduler queue */
+#define BENCH_DEFAULT_MSGS 200000
+#define BENCH_DEFAULT_PRODUCERS 4
+
+typedef struct bench_msg bench_msg_t;
+struct bench_msg
+{
+  uint64_t sent_ns;
+};
+
+typedef struct bench_ops bench_ops_t;
+struct bench_ops
+{
+  const char *p_name;
+  OMX_ERRORTYPE (*pf_init) (void **, OMX_S32);
+  void (*pf_destroy) (void *);
+  OMX_ERRORTYPE (*pf_send) (void *, OMX_PTR);
+  OMX_ERRORTYPE (*pf_receive) (void *, OMX_PTR *);
+};
+
+typedef struct bench_producer bench_producer_t;
+struct bench_producer
+{
+  const bench_ops_t *p_ops;
+  void *p_queue;
+  bench_msg_t *p_msgs;
+  long nmsgs;
+};
+
+static inline uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static OMX_ERRORTYPE
+q_init (void **app_q, OMX_S32 a_capacity)
+{
+  return tiz_queue_init ((tiz_queue_t **) app_q, a_capacity);
+}
+
+static void
+q_destroy (void *ap_q)
+{
+  tiz_queue_destroy (ap_q);
+}
+
+static OMX_ERRORTYPE
+q_send (void *ap_q, OMX_PTR ap_data)
+{
+  return tiz_queue_send (ap_q, ap_data);
+}
+
+static OMX_ERRORTYPE
+q_receive (void *ap_q, OMX_PTR * app_data)
+{
+  return tiz_queue_receive (ap_q, app_data);
+}
+
+static OMX_ERRORTYPE
+lfq_init (void **app_q, OMX_S32 a_capacity)
+{
+  return tiz_lfqueue_init ((tiz_lfqueue_t **) app_q, a_capacity);
+}
+
+static void
+lfq_destroy (void *ap_q)
+{
+  tiz_lfqueue_destroy (ap_q);
+}
+
+static OMX_ERRORTYPE
+lfq_send (void *ap_q, OMX_PTR ap_data)
+{
+  return tiz_lfqueue_send (ap_q, ap_data);
+}
+
+static OMX_ERRORTYPE
+lfq_receive (void *ap_q, OMX_PTR * app_data)
+{
+  return tiz_lfqueue_receive (ap_q, app_data);
+}
+
+static const bench_ops_t g_queues[] = {
+  {"tiz_queue", q_init, q_destroy, q_send, q_receive},
+  {"tiz_lfqueue", lfq_init, lfq_destroy, lfq_send, lfq_receive},
+};
+
+static int
+cmp_u64 (const void *ap_a, const void *ap_b)
+{
+  const uint64_t a = *(const uint64_t *) ap_a;
+  const uint64_t b = *(const uint64_t *) ap_b;
+  return (a > b) - (a < b);
+}
+
+static void *
+producer_thread (void *ap_arg)
+{
+  bench_producer_t *p_prod = ap_arg;
+  long i;
+
+  for (i = 0; i < p_prod->nmsgs; ++i)
+    {
+      p_prod->p_msgs[i].sent_ns = now_ns ();
+      (void) p_prod->p_ops->pf_send (p_prod->p_queue, &(p_prod->p_msgs[i]));
+    }
+
+  return NULL;
+}
+
+static void
+run_one (const bench_ops_t *ap_ops, const int a_nproducers, const long a_nmsgs)
+{
+  const long total = a_nmsgs * a_nproducers;
+  bench_producer_t prods[a_nproducers];
+  tiz_thread_t threads[a_nproducers];
+  uint64_t *p_lat = calloc (total, sizeof (uint64_t));
+  bench_msg_t *p_msgs = calloc (total, sizeof (bench_msg_t));
+  void *p_queue = NULL;
+  void *p_result = NULL;
+  uint64_t start = 0;
+  uint64_t elapsed = 0;
+  long i = 0;
+
+  assert (p_lat && p_msgs);
+  (void) ap_ops->pf_init (&p_queue, BENCH_QUEUE_CAPACITY);
+
+  start = now_ns ();
+  for (i = 0; i < a_nproducers; ++i)
+    {
+      prods[i].p_ops = ap_ops;
+      prods[i].p_queue = p_queue;
+      prods[i].p_msgs = p_msgs + i * a_nmsgs;
+      prods[i].nmsgs = a_nmsgs;
+      (void) tiz_thread_create (&threads[i], 0, 0, producer_thread,
+                                &prods[i]);
+    }
+
+  for (i = 0; i < total; ++i)
+    {
+      OMX_PTR p_data = NULL;
+      (void) ap_ops->pf_receive (p_queue, &p_data);
+      p_lat[i] = now_ns () - ((bench_msg_t *) p_data)->sent_ns;
+    }
+  elapsed = now_ns () - start;
+
+  for (i = 0; i < a_nproducers; ++i)
+    {
+      (void) tiz_thread_join (&threads[i], &p_result);
+    }
+
+  qsort (p_lat, total, sizeof (uint64_t), cmp_u64);
+  printf ("%-12s producers %2d : %12.0f msgs/sec  p50 %8.2f us  p99 %8.2f us\n",
+          ap_ops->p_name, a_nproducers, (double) total * 1e9 / elapsed,
+          p_lat[total / 2] / 1e3, p_lat[(total * 99) / 100] / 1e3);
+
+  ap_ops->pf_destroy (p_queue);
+  free (p_msgs);
+  free (p_lat);
+}
+
+int
+main (int argc, char **argv)
+{
+  const long nmsgs = argc > 1 ? atol (argv[1]) : BENCH_DEFAULT_MSGS;
+  const int max_producers = argc > 2 ? atoi (argv[2]) : BENCH_DEFAULT_PRODUCERS;
+  int nproducers = 0;
+  size_t q = 0;
+
+  tiz_log_init ();
+
+  for (nproducers = 1; nproducers <= max_producers; nproducers *= 2)
+    {
+      for (q = 0; q < sizeof (g_queues) / sizeof (g_queues[0]); ++q)
+        {
+          run_one (&g_queues[q], nproducers, nmsgs);
+        }
+    }
+
+  tiz_log_deinit ();
+
+  return EXIT_SUCCESS;
+}
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
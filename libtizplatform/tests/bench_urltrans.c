@@ -0,0 +1,496 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_urltrans.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Micro-benchmark: tiz_urltrans time-to-first-byte
+ *
+ * Starts a local HTTP/1.1 server and measures, for a series of transfers,
+ * the time between tiz_urltrans_start and the first byte of the response
+ * body. A new tiz_urltrans object is created for every transfer, as happens
+ * when a source component is re-created. The server waits 'setup-delay-ms'
+ * before answering the first request on each new connection, to stand in
+ * for the TCP and TLS handshakes with a remote server. Connections are not
+ * shared among transfer objects, so every transfer pays that delay; the
+ * DNS and TLS session caches ('http-cache-sharing' in tizonia.conf, see
+ * TIZONIA_RC_FILE) only shorten the set-up against named TLS servers,
+ * which this local plain HTTP server does not stand in for. Usage:
+ *
+ *   bench_urltrans [transfers] [setup-delay-ms]
+ *
+ */
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/tizplatform.h"
+
+#define BENCH_DEFAULT_TRANSFERS 50
+#define BENCH_DEFAULT_SETUP_DELAY_MS 20
+#define BENCH_MAX_CONNECTIONS 64
+#define BENCH_URI_MAX 128
+#define BENCH_RESPONSE                                              \
+  "HTTP/1.1 200 OK\r\nContent-Type: audio/mpeg\r\nContent-Length: " \
+  "16\r\n\r\n0123456789abcdef"
+
+typedef struct bench_conn bench_conn_t;
+struct bench_conn
+{
+  int fd;
+  bool served;
+  char req[4096];
+  size_t req_len;
+};
+
+typedef struct bench_client bench_client_t;
+struct bench_client
+{
+  tiz_mutex_t mutex;
+  tiz_sem_t sem;
+  tiz_urltrans_t * p_trans;
+  uint32_t id;
+  bool io_active;
+  bool timer_active;
+  uint64_t start_ns;
+  uint64_t ttfb_ns;
+};
+
+static bench_client_t g_client;
+static int g_listen_fd = -1;
+static int g_setup_delay_ms = BENCH_DEFAULT_SETUP_DELAY_MS;
+static int g_nconnections = 0;
+
+static inline uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static int
+cmp_u64 (const void * ap_a, const void * ap_b)
+{
+  const uint64_t a = *(const uint64_t *) ap_a;
+  const uint64_t b = *(const uint64_t *) ap_b;
+  return (a > b) - (a < b);
+}
+
+/*
+ * Local HTTP server
+ */
+
+static void
+serve_requests (bench_conn_t * ap_conn)
+{
+  char * p_end = NULL;
+  ap_conn->req[ap_conn->req_len] = '\0';
+  while ((p_end = strstr (ap_conn->req, "\r\n\r\n")))
+    {
+      const size_t used = (p_end + 4) - ap_conn->req;
+      if (!ap_conn->served)
+        {
+          usleep (g_setup_delay_ms * 1000);
+          ap_conn->served = true;
+        }
+      if (write (ap_conn->fd, BENCH_RESPONSE, strlen (BENCH_RESPONSE)) < 0)
+        {
+          perror ("write");
+        }
+      memmove (ap_conn->req, ap_conn->req + used, ap_conn->req_len - used);
+      ap_conn->req_len -= used;
+      ap_conn->req[ap_conn->req_len] = '\0';
+    }
+}
+
+static void *
+server_thread (void * ap_arg)
+{
+  static bench_conn_t conns[BENCH_MAX_CONNECTIONS];
+  struct pollfd pfds[BENCH_MAX_CONNECTIONS + 1];
+  int nconns = 0;
+  int i = 0;
+
+  (void) ap_arg;
+
+  for (;;)
+    {
+      pfds[0].fd = g_listen_fd;
+      pfds[0].events = POLLIN;
+      for (i = 0; i < nconns; ++i)
+        {
+          pfds[i + 1].fd = conns[i].fd;
+          pfds[i + 1].events = POLLIN;
+        }
+
+      if (poll (pfds, nconns + 1, -1) < 0)
+        {
+          break;
+        }
+
+      for (i = nconns - 1; i >= 0; --i)
+        {
+          if (pfds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+              bench_conn_t * p_conn = &conns[i];
+              const ssize_t n
+                = read (p_conn->fd, p_conn->req + p_conn->req_len,
+                        sizeof (p_conn->req) - p_conn->req_len - 1);
+              if (n <= 0)
+                {
+                  close (p_conn->fd);
+                  conns[i] = conns[--nconns];
+                  continue;
+                }
+              p_conn->req_len += n;
+              serve_requests (p_conn);
+            }
+        }
+
+      if ((pfds[0].revents & POLLIN) && nconns < BENCH_MAX_CONNECTIONS)
+        {
+          const int fd = accept (g_listen_fd, NULL, NULL);
+          if (fd >= 0)
+            {
+              conns[nconns].fd = fd;
+              conns[nconns].served = false;
+              conns[nconns].req_len = 0;
+              ++nconns;
+              ++g_nconnections;
+            }
+        }
+    }
+
+  return NULL;
+}
+
+static int
+start_server (void)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof (addr);
+  const int one = 1;
+
+  g_listen_fd = socket (AF_INET, SOCK_STREAM, 0);
+  assert (g_listen_fd >= 0);
+  (void) setsockopt (g_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one,
+                     sizeof (one));
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  if (bind (g_listen_fd, (struct sockaddr *) &addr, sizeof (addr)) < 0
+      || listen (g_listen_fd, 16) < 0
+      || getsockname (g_listen_fd, (struct sockaddr *) &addr, &len) < 0)
+    {
+      perror ("server");
+      exit (EXIT_FAILURE);
+    }
+
+  return ntohs (addr.sin_port);
+}
+
+/*
+ * tiz_urltrans client. The event callbacks of the transfer object are
+ * delivered on the event loop thread; the mutex serialises them with the
+ * calls made from the main thread, as the component's thread would.
+ */
+
+static void
+io_cback (void * ap_arg0, tiz_event_io_t * ap_ev_io, void * ap_arg1,
+          const uint32_t a_id, int a_fd, int a_events)
+{
+  bench_client_t * p_client = ap_arg0;
+  (void) tiz_mutex_lock (&(p_client->mutex));
+  /* 'once' watcher; no longer active */
+  p_client->io_active = false;
+  if (p_client->p_trans)
+    {
+      (void) tiz_urltrans_on_io_ready (p_client->p_trans, ap_ev_io, a_fd,
+                                       a_events);
+    }
+  (void) tiz_mutex_unlock (&(p_client->mutex));
+}
+
+static void
+timer_cback (void * ap_arg0, tiz_event_timer_t * ap_ev_timer, void * ap_arg1,
+             const uint32_t a_id)
+{
+  bench_client_t * p_client = ap_arg0;
+  (void) tiz_mutex_lock (&(p_client->mutex));
+  if (!tiz_event_timer_is_repeat (ap_ev_timer))
+    {
+      p_client->timer_active = false;
+    }
+  if (p_client->p_trans)
+    {
+      (void) tiz_urltrans_on_timer_ready (p_client->p_trans, ap_ev_timer);
+    }
+  (void) tiz_mutex_unlock (&(p_client->mutex));
+}
+
+static OMX_ERRORTYPE
+io_init (void * ap_obj, tiz_event_io_t ** app_ev_io, int a_fd,
+         tiz_event_io_event_t a_event, bool only_once)
+{
+  tiz_check_omx (tiz_event_io_init (app_ev_io, ap_obj, io_cback, NULL));
+  tiz_event_io_set (*app_ev_io, a_fd, a_event, only_once);
+  return OMX_ErrorNone;
+}
+
+static void
+io_destroy (void * ap_obj, tiz_event_io_t * ap_ev_io)
+{
+  tiz_event_io_destroy (ap_ev_io);
+}
+
+static OMX_ERRORTYPE
+io_start (void * ap_obj, tiz_event_io_t * ap_ev_io)
+{
+  bench_client_t * p_client = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  /* Like the servant, ignore requests to start an active watcher */
+  if (!p_client->io_active)
+    {
+      p_client->io_active = true;
+      rc = tiz_event_io_start (ap_ev_io, ++p_client->id);
+    }
+  return rc;
+}
+
+static OMX_ERRORTYPE
+io_stop (void * ap_obj, tiz_event_io_t * ap_ev_io)
+{
+  bench_client_t * p_client = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  if (p_client->io_active)
+    {
+      p_client->io_active = false;
+      rc = tiz_event_io_stop (ap_ev_io);
+    }
+  return rc;
+}
+
+static OMX_ERRORTYPE
+timer_init (void * ap_obj, tiz_event_timer_t ** app_ev_timer)
+{
+  return tiz_event_timer_init (app_ev_timer, ap_obj, timer_cback, NULL);
+}
+
+static void
+timer_destroy (void * ap_obj, tiz_event_timer_t * ap_ev_timer)
+{
+  tiz_event_timer_destroy (ap_ev_timer);
+}
+
+static OMX_ERRORTYPE
+timer_start (void * ap_obj, tiz_event_timer_t * ap_ev_timer,
+             const double a_after, const double a_repeat)
+{
+  bench_client_t * p_client = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  if (!p_client->timer_active)
+    {
+      p_client->timer_active = true;
+      tiz_event_timer_set (ap_ev_timer, a_after, a_repeat);
+      rc = tiz_event_timer_start (ap_ev_timer, ++p_client->id);
+    }
+  return rc;
+}
+
+static OMX_ERRORTYPE
+timer_stop (void * ap_obj, tiz_event_timer_t * ap_ev_timer)
+{
+  bench_client_t * p_client = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  if (p_client->timer_active)
+    {
+      p_client->timer_active = false;
+      rc = tiz_event_timer_stop (ap_ev_timer);
+    }
+  return rc;
+}
+
+static OMX_ERRORTYPE
+timer_restart (void * ap_obj, tiz_event_timer_t * ap_ev_timer)
+{
+  bench_client_t * p_client = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  if (p_client->timer_active)
+    {
+      rc = tiz_event_timer_restart (ap_ev_timer, ++p_client->id);
+    }
+  return rc;
+}
+
+static OMX_BUFFERHEADERTYPE *
+buffer_emptied (OMX_PTR ap_arg)
+{
+  /* No buffers: data is left in the transfer's internal store */
+  return NULL;
+}
+
+static void
+buffer_filled (OMX_BUFFERHEADERTYPE * ap_hdr, OMX_PTR ap_arg)
+{
+}
+
+static void
+header_available (OMX_PTR ap_arg, const void * ap_ptr, const size_t a_nbytes)
+{
+}
+
+static bool
+data_available (OMX_PTR ap_arg, const void * ap_ptr, const size_t a_nbytes)
+{
+  bench_client_t * p_client = ap_arg;
+  if (0 == p_client->ttfb_ns)
+    {
+      p_client->ttfb_ns = now_ns () - p_client->start_ns;
+    }
+  return false;
+}
+
+static bool
+connection_lost (OMX_PTR ap_arg)
+{
+  /* The response is complete; the connection is now idle and may be handed
+     over to the next transfer */
+  bench_client_t * p_client = ap_arg;
+  (void) tiz_sem_post (&(p_client->sem));
+  return false;
+}
+
+static uint64_t
+run_one (OMX_PARAM_CONTENTURITYPE * ap_uri)
+{
+  const tiz_urltrans_buffer_cbacks_t buffer_cbacks
+    = {buffer_filled, buffer_emptied};
+  const tiz_urltrans_info_cbacks_t info_cbacks
+    = {header_available, data_available, connection_lost};
+  const tiz_urltrans_event_io_cbacks_t io_cbacks
+    = {io_init, io_destroy, io_start, io_stop};
+  const tiz_urltrans_event_timer_cbacks_t timer_cbacks
+    = {timer_init, timer_destroy, timer_start, timer_stop, timer_restart};
+  tiz_urltrans_t * p_trans = NULL;
+
+  (void) tiz_mutex_lock (&(g_client.mutex));
+  if (OMX_ErrorNone
+      != tiz_urltrans_init (&p_trans, &g_client, ap_uri, "bench_urltrans",
+                            64 * 1024, 1.0, buffer_cbacks, info_cbacks,
+                            io_cbacks, timer_cbacks))
+    {
+      fprintf (stderr, "tiz_urltrans_init failed\n");
+      exit (EXIT_FAILURE);
+    }
+  tiz_urltrans_set_internal_buffer_size (p_trans, 64 * 1024);
+  g_client.p_trans = p_trans;
+  g_client.ttfb_ns = 0;
+  g_client.start_ns = now_ns ();
+  (void) tiz_urltrans_start (p_trans);
+  (void) tiz_mutex_unlock (&(g_client.mutex));
+
+  (void) tiz_sem_wait (&(g_client.sem));
+
+  (void) tiz_mutex_lock (&(g_client.mutex));
+  g_client.p_trans = NULL;
+  tiz_urltrans_cancel (p_trans);
+  tiz_urltrans_destroy (p_trans);
+  g_client.io_active = false;
+  g_client.timer_active = false;
+  (void) tiz_mutex_unlock (&(g_client.mutex));
+
+  return g_client.ttfb_ns;
+}
+
+int
+main (int argc, char ** argv)
+{
+  const int ntransfers = argc > 1 ? atoi (argv[1]) : BENCH_DEFAULT_TRANSFERS;
+  OMX_PARAM_CONTENTURITYPE * p_uri = NULL;
+  tiz_thread_t server;
+  uint64_t * p_ttfb = NULL;
+  uint64_t sum = 0;
+  int i = 0;
+
+  g_setup_delay_ms = argc > 2 ? atoi (argv[2]) : BENCH_DEFAULT_SETUP_DELAY_MS;
+
+  tiz_log_init ();
+
+  if (OMX_ErrorNone != tiz_event_loop_init ())
+    {
+      fprintf (stderr, "Unable to start the event loop (is tizonia.conf "
+                       "available?)\n");
+      return EXIT_FAILURE;
+    }
+
+  p_uri = calloc (1, sizeof (OMX_PARAM_CONTENTURITYPE) + BENCH_URI_MAX);
+  p_ttfb = calloc (ntransfers, sizeof (uint64_t));
+  assert (p_uri && p_ttfb && ntransfers > 0);
+  p_uri->nSize = sizeof (OMX_PARAM_CONTENTURITYPE) + BENCH_URI_MAX;
+  snprintf ((char *) p_uri->contentURI, BENCH_URI_MAX,
+            "http://127.0.0.1:%d/stream.mp3", start_server ());
+
+  (void) tiz_thread_create (&server, 0, 0, server_thread, NULL);
+  (void) tiz_mutex_init (&(g_client.mutex));
+  (void) tiz_sem_init (&(g_client.sem), 0);
+
+  for (i = 0; i < ntransfers; ++i)
+    {
+      p_ttfb[i] = run_one (p_uri);
+      sum += p_ttfb[i];
+    }
+
+  qsort (p_ttfb, ntransfers, sizeof (uint64_t), cmp_u64);
+  printf ("cache sharing %-3s transfers %4d connections %4d : "
+          "ttfb mean %8.2f ms  p50 %8.2f ms  p99 %8.2f ms\n",
+          0 == tiz_rcfile_compare_value ("ilcore", "http-cache-sharing",
+                                         "false")
+            ? "off"
+            : "on",
+          ntransfers, g_nconnections, (double) sum / ntransfers / 1e6,
+          p_ttfb[ntransfers / 2] / 1e6, p_ttfb[(ntransfers * 99) / 100] / 1e6);
+
+  free (p_ttfb);
+  free (p_uri);
+
+  /* The server thread is left blocked in poll () */
+  tiz_log_deinit ();
+
+  return EXIT_SUCCESS;
+}
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -0,0 +1,167 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_aio.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Asynchronous I/O API unit tests
+ *
+ *
+ */
+
+#define AIO_TEST_BLOCKS 64
+#define AIO_TEST_BLOCK_SIZE 4096
+#define AIO_TEST_DEPTH 8
+
+static int
+aio_test_open_tmp (void)
+{
+  char name[] = "/tmp/check_aio_XXXXXX";
+  int fd = mkstemp (name);
+  fail_if (fd < 0);
+  (void) unlink (name);
+  return fd;
+}
+
+static void
+aio_test_wait (tiz_aio_t *p_aio)
+{
+  fd_set rfds;
+  FD_ZERO (&rfds);
+  FD_SET (tiz_aio_get_fd (p_aio), &rfds);
+  fail_if (select (tiz_aio_get_fd (p_aio) + 1, &rfds, NULL, NULL, NULL) < 0);
+}
+
+START_TEST (test_aio_init_and_destroy)
+{
+  tiz_aio_t *p_aio = NULL;
+
+  fail_if (OMX_ErrorNone != tiz_aio_init (&p_aio, 2, AIO_TEST_DEPTH));
+  fail_if (NULL == p_aio);
+  fail_if (tiz_aio_get_fd (p_aio) < 0);
+  fail_if (0 != tiz_aio_pending (p_aio));
+  fail_if (NULL != tiz_aio_reap (p_aio));
+  tiz_aio_destroy (p_aio);
+}
+END_TEST
+
+START_TEST (test_aio_write_and_read)
+{
+  tiz_aio_t *p_aio = NULL;
+  tiz_aio_req_t reqs[AIO_TEST_DEPTH];
+  unsigned char *p_data = NULL;
+  unsigned char *p_copy = NULL;
+  const size_t total = AIO_TEST_BLOCKS * AIO_TEST_BLOCK_SIZE;
+  int fd = aio_test_open_tmp ();
+  int op = 0;
+  size_t i = 0;
+
+  p_data = tiz_mem_alloc (total);
+  p_copy = tiz_mem_calloc (1, total);
+  fail_if (NULL == p_data || NULL == p_copy);
+  for (i = 0; i < total; ++i)
+    {
+      p_data[i] = (unsigned char) (i * 7 + i / AIO_TEST_BLOCK_SIZE);
+    }
+
+  fail_if (OMX_ErrorNone != tiz_aio_init (&p_aio, 4, AIO_TEST_DEPTH));
+
+  /* Write the whole thing, then read it back, keeping the queue full */
+  for (op = ETIZAioOpWrite; op >= ETIZAioOpRead; --op)
+    {
+      size_t submitted = 0;
+      size_t reaped = 0;
+      while (reaped < AIO_TEST_BLOCKS)
+        {
+          tiz_aio_req_t *p_req = NULL;
+          while (submitted < AIO_TEST_BLOCKS && !tiz_aio_is_full (p_aio))
+            {
+              p_req = &(reqs[submitted % AIO_TEST_DEPTH]);
+              p_req->op = op;
+              p_req->fd = fd;
+              p_req->offset = submitted * AIO_TEST_BLOCK_SIZE;
+              p_req->p_buf = (op == ETIZAioOpWrite ? p_data : p_copy)
+                             + submitted * AIO_TEST_BLOCK_SIZE;
+              p_req->len = AIO_TEST_BLOCK_SIZE;
+              p_req->p_data = (void *) submitted;
+              fail_if (OMX_ErrorNone != tiz_aio_submit (p_aio, p_req));
+              submitted++;
+            }
+
+          if (tiz_aio_is_full (p_aio))
+            {
+              /* Pending requests only go away when reaped */
+              fail_if (OMX_ErrorNoMore != tiz_aio_submit (p_aio, &(reqs[0])));
+            }
+
+          aio_test_wait (p_aio);
+          while ((p_req = tiz_aio_reap (p_aio)))
+            {
+              /* Always in submission order */
+              fail_if ((size_t) p_req->p_data != reaped);
+              fail_if (p_req->result != AIO_TEST_BLOCK_SIZE);
+              reaped++;
+            }
+        }
+    }
+
+  fail_if (0 != memcmp (p_data, p_copy, total));
+
+  /* Reads past the end of file are short */
+  reqs[0].op = ETIZAioOpRead;
+  reqs[0].fd = fd;
+  reqs[0].offset = total - 100;
+  reqs[0].p_buf = p_copy;
+  reqs[0].len = AIO_TEST_BLOCK_SIZE;
+  fail_if (OMX_ErrorNone != tiz_aio_submit (p_aio, &(reqs[0])));
+  tiz_aio_drain (p_aio);
+  fail_if (&(reqs[0]) != tiz_aio_reap (p_aio));
+  fail_if (100 != reqs[0].result);
+  fail_if (0 != tiz_aio_pending (p_aio));
+
+  tiz_aio_destroy (p_aio);
+  (void) close (fd);
+  tiz_mem_free (p_data);
+  tiz_mem_free (p_copy);
+}
+END_TEST
+
+START_TEST (test_aio_error)
+{
+  tiz_aio_t *p_aio = NULL;
+  tiz_aio_req_t req;
+  char buf[16];
+
+  fail_if (OMX_ErrorNone != tiz_aio_init (&p_aio, 1, 1));
+
+  req.op = ETIZAioOpRead;
+  req.fd = -1;
+  req.offset = 0;
+  req.p_buf = buf;
+  req.len = sizeof (buf);
+  fail_if (OMX_ErrorNone != tiz_aio_submit (p_aio, &req));
+  aio_test_wait (p_aio);
+  fail_if (&req != tiz_aio_reap (p_aio));
+  fail_if (-1 != req.result);
+  fail_if (EBADF != req.error);
+
+  tiz_aio_destroy (p_aio);
+}
+END_TEST
@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_buffer.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tests for the dynamic and ring buffer API
+ *
+ *
+ */
+
+START_TEST (test_buffer_push_and_advance)
+{
+  tiz_buffer_t * p_buf = NULL;
+  unsigned char data[100];
+  int i = 0;
+
+  for (i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = i;
+    }
+
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 16));
+
+  /* The buffer grows as needed */
+  fail_if (sizeof (data) != tiz_buffer_push (p_buf, data, sizeof (data)));
+  fail_if (sizeof (data) != tiz_buffer_available (p_buf));
+  fail_if (0 != memcmp (tiz_buffer_get (p_buf), data, sizeof (data)));
+
+  fail_if (40 != tiz_buffer_advance (p_buf, 40));
+  fail_if (60 != tiz_buffer_available (p_buf));
+  fail_if (0 != memcmp (tiz_buffer_get (p_buf), data + 40, 60));
+
+  tiz_buffer_clear (p_buf);
+  fail_if (0 != tiz_buffer_available (p_buf));
+
+  tiz_buffer_destroy (p_buf);
+}
+END_TEST
+
+START_TEST (test_buffer_ring_wrap_around)
+{
+  tiz_buffer_t * p_buf = NULL;
+  const long pg_sz = sysconf (_SC_PAGESIZE);
+  unsigned char * p_data = NULL;
+  unsigned char * p_out = NULL;
+  int i = 0;
+
+  fail_if (pg_sz <= 0);
+  p_data = tiz_mem_alloc (pg_sz);
+  fail_if (!p_data);
+  for (i = 0; i < pg_sz; ++i)
+    {
+      p_data[i] = i % 251;
+    }
+
+  fail_if (OMX_ErrorNone != tiz_buffer_ring_init (&p_buf, pg_sz / 2));
+
+  /* Rings do not grow: the capacity is one page */
+  fail_if (pg_sz != tiz_buffer_push (p_buf, p_data, pg_sz));
+  fail_if (0 != tiz_buffer_push (p_buf, p_data, 1));
+
+  /* Move the read position to the middle of the ring and refill it, so that
+     the data wraps around the end of the ring */
+  fail_if (pg_sz / 2 + 10 != tiz_buffer_advance (p_buf, pg_sz / 2 + 10));
+  fail_if (pg_sz / 2 + 10 != tiz_buffer_push (p_buf, p_data, pg_sz));
+  fail_if (pg_sz != tiz_buffer_available (p_buf));
+
+  /* The wrapped data is still contiguous */
+  p_out = tiz_buffer_get (p_buf);
+  fail_if (0 != memcmp (p_out, p_data + pg_sz / 2 + 10, pg_sz / 2 - 10));
+  fail_if (0 != memcmp (p_out + pg_sz / 2 - 10, p_data, pg_sz / 2 + 10));
+
+  /* Rings are always non-seekable */
+  fail_if (-1 != tiz_buffer_seek_mode (p_buf, TIZ_BUFFER_SEEKABLE));
+  fail_if (-1 != tiz_buffer_seek (p_buf, 0, TIZ_BUFFER_SEEK_SET));
+
+  tiz_buffer_destroy (p_buf);
+  tiz_mem_free (p_data);
+}
+END_TEST
+
+START_TEST (test_buffer_write_span)
+{
+  tiz_buffer_t * p_buf = NULL;
+  const long pg_sz = sysconf (_SC_PAGESIZE);
+  unsigned char * p_span = NULL;
+  size_t avail = 0;
+
+  fail_if (pg_sz <= 0);
+  fail_if (OMX_ErrorNone != tiz_buffer_ring_init (&p_buf, pg_sz));
+
+  /* Leave the read position close to the end of the ring */
+  fail_if (pg_sz - 8 != tiz_buffer_commit (p_buf, pg_sz - 8));
+  fail_if (pg_sz - 8 != tiz_buffer_advance (p_buf, pg_sz - 8));
+
+  /* The whole ring can be written in one go, across its end */
+  p_span = tiz_buffer_write_span (p_buf, pg_sz, &avail);
+  fail_if (!p_span);
+  fail_if (pg_sz != avail);
+  memset (p_span, 0xab, pg_sz);
+  fail_if (pg_sz != tiz_buffer_commit (p_buf, pg_sz));
+  fail_if (pg_sz != tiz_buffer_available (p_buf));
+  fail_if (0xab != ((unsigned char *) tiz_buffer_get (p_buf))[pg_sz - 1]);
+
+  /* Full */
+  fail_if (NULL != tiz_buffer_write_span (p_buf, 1, &avail));
+  fail_if (0 != avail);
+  tiz_buffer_destroy (p_buf);
+
+  /* Dynamic buffers grow to fit the requested span */
+  fail_if (OMX_ErrorNone != tiz_buffer_init (&p_buf, 16));
+  p_span = tiz_buffer_write_span (p_buf, 1000, &avail);
+  fail_if (!p_span);
+  fail_if (avail < 1000);
+  fail_if (1000 != tiz_buffer_commit (p_buf, 1000));
+  fail_if (1000 != tiz_buffer_available (p_buf));
+  tiz_buffer_destroy (p_buf);
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
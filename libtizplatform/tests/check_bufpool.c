@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_bufpool.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Buffer pool API unit tests
+ *
+ *
+ */
+
+#define BUFPOOL_TEST_NBUFS 8
+#define BUFPOOL_TEST_BUF_SIZE 1000
+
+START_TEST (test_bufpool_get_and_put)
+{
+  tiz_bufpool_t *p_pool = NULL;
+  OMX_U8 *bufs[BUFPOOL_TEST_NBUFS];
+  OMX_U8 *p_buf = NULL;
+  OMX_U8 local = 0;
+  size_t j = 0;
+  int i = 0;
+
+  fail_if (OMX_ErrorBadParameter
+           != tiz_bufpool_init (&p_pool, 0, BUFPOOL_TEST_BUF_SIZE, 0, 0));
+  fail_if (OMX_ErrorBadParameter
+           != tiz_bufpool_init (&p_pool, BUFPOOL_TEST_NBUFS,
+                                BUFPOOL_TEST_BUF_SIZE, 48, 0));
+
+  fail_if (OMX_ErrorNone
+           != tiz_bufpool_init (&p_pool, BUFPOOL_TEST_NBUFS,
+                                BUFPOOL_TEST_BUF_SIZE, 0,
+                                ETIZBufPoolFlagPrefault));
+  fail_if (BUFPOOL_TEST_NBUFS != tiz_bufpool_count (p_pool));
+  fail_if (BUFPOOL_TEST_NBUFS != tiz_bufpool_available (p_pool));
+  fail_if (BUFPOOL_TEST_BUF_SIZE != tiz_bufpool_buf_size (p_pool));
+
+  for (i = 0; i < BUFPOOL_TEST_NBUFS; ++i)
+    {
+      bufs[i] = tiz_bufpool_get (p_pool);
+      fail_if (NULL == bufs[i]);
+      /* Cache line alignment */
+      fail_if (0 != ((uintptr_t) bufs[i] & 63));
+      fail_if (!tiz_bufpool_owns (p_pool, bufs[i]));
+      for (j = 0; j < BUFPOOL_TEST_BUF_SIZE; ++j)
+        {
+          fail_if (0 != bufs[i][j]);
+        }
+      /* Buffers don't overlap */
+      fail_if (i > 0 && bufs[i] < bufs[i - 1] + BUFPOOL_TEST_BUF_SIZE);
+      (void) memset (bufs[i], 0xAA, BUFPOOL_TEST_BUF_SIZE);
+    }
+
+  fail_if (0 != tiz_bufpool_available (p_pool));
+  fail_if (NULL != tiz_bufpool_get (p_pool));
+  fail_if (tiz_bufpool_owns (p_pool, &local));
+
+  /* The last buffer returned is the first one handed out again, and it is
+     zero-filled */
+  tiz_bufpool_put (p_pool, bufs[3]);
+  tiz_bufpool_put (p_pool, bufs[5]);
+  fail_if (2 != tiz_bufpool_available (p_pool));
+  p_buf = tiz_bufpool_get (p_pool);
+  fail_if (bufs[5] != p_buf);
+  for (j = 0; j < BUFPOOL_TEST_BUF_SIZE; ++j)
+    {
+      fail_if (0 != p_buf[j]);
+    }
+  bufs[5] = p_buf;
+  bufs[3] = tiz_bufpool_get (p_pool);
+
+  for (i = 0; i < BUFPOOL_TEST_NBUFS; ++i)
+    {
+      tiz_bufpool_put (p_pool, bufs[i]);
+    }
+  fail_if (BUFPOOL_TEST_NBUFS != tiz_bufpool_available (p_pool));
+
+  tiz_bufpool_destroy (p_pool);
+}
+END_TEST
+
+START_TEST (test_bufpool_huge_and_numa)
+{
+  tiz_bufpool_t *p_pool = NULL;
+  OMX_U8 *p_buf = NULL;
+  const size_t buf_size = 512 * 1024;
+  const OMX_U32 nbufs = 8;
+  OMX_U32 i = 0;
+
+  /* Huge pages may or may not be available; either way the pool must be
+     usable */
+  fail_if (OMX_ErrorNone
+           != tiz_bufpool_init (&p_pool, nbufs, buf_size, 4096,
+                                ETIZBufPoolFlagPrefault
+                                  | ETIZBufPoolFlagHugePages
+                                  | ETIZBufPoolFlagNumaLocal));
+  for (i = 0; i < nbufs; ++i)
+    {
+      p_buf = tiz_bufpool_get (p_pool);
+      fail_if (NULL == p_buf);
+      fail_if (0 != ((uintptr_t) p_buf & 4095));
+      p_buf[0] = 1;
+      p_buf[buf_size - 1] = 1;
+    }
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "huge [%s]",
+           tiz_bufpool_is_huge (p_pool) ? "YES" : "NO");
+  tiz_bufpool_destroy (p_pool);
+}
+END_TEST
@@ -54,6 +54,10 @@ static int g_restart_count = 2;
 static bool g_timer_restarted = false;
 static bool g_file_status_changed = false;
 
+#define CHECK_SHARDS_NTIMERS 16
+static tiz_mutex_t g_shards_mutex;
+static int g_shards_fired = 0;
+
 static void
 check_event_io_cback (OMX_HANDLETYPE p_hdl, tiz_event_io_t * ap_ev_io, void *ap_arg1,
                       const uint32_t a_id, int fd, int events)
@@ -166,6 +170,17 @@ check_event_stat_cback (OMX_HANDLETYPE p_hdl, tiz_event_stat_t * ap_ev_stat,
   fail_if (OMX_ErrorNone != error);
 }
 
+static void
+check_event_shards_cback (OMX_HANDLETYPE p_hdl,
+                          tiz_event_timer_t * ap_ev_timer, void * ap_arg,
+                          const uint32_t a_id)
+{
+  fail_if (NULL == ap_ev_timer);
+  fail_if (OMX_ErrorNone != tiz_mutex_lock (&g_shards_mutex));
+  ++g_shards_fired;
+  fail_if (OMX_ErrorNone != tiz_mutex_unlock (&g_shards_mutex));
+}
+
 /* TESTS */
 
 START_TEST (test_event_loop_init_and_destroy)
@@ -341,6 +356,57 @@ START_TEST (test_event_stat)
 }
 END_TEST
 
+START_TEST (test_event_shards)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_event_timer_t * timers[CHECK_SHARDS_NTIMERS];
+  /* Fake component handles, so that the timers get spread over the
+     shards */
+  char hdls[CHECK_SHARDS_NTIMERS][64];
+  int sleep_count = 50;
+  int fired = 0;
+  int i = 0;
+
+  error = tiz_event_loop_init ();
+  fail_if (error != OMX_ErrorNone);
+
+  /* The test config file asks for several shards */
+  fail_if (tiz_event_loop_shards () < 2);
+
+  error = tiz_mutex_init (&g_shards_mutex);
+  fail_if (error != OMX_ErrorNone);
+
+  for (i = 0; i < CHECK_SHARDS_NTIMERS; ++i)
+    {
+      error = tiz_event_timer_init (&timers[i], hdls[i],
+                                    check_event_shards_cback, NULL);
+      fail_if (error != OMX_ErrorNone);
+      tiz_event_timer_set (timers[i], 0.05, 0.);
+      error = tiz_event_timer_start (timers[i], i + 1);
+      fail_if (error != OMX_ErrorNone);
+    }
+
+  do
+    {
+      usleep (100000);
+      fail_if (OMX_ErrorNone != tiz_mutex_lock (&g_shards_mutex));
+      fired = g_shards_fired;
+      fail_if (OMX_ErrorNone != tiz_mutex_unlock (&g_shards_mutex));
+    }
+  while (fired < CHECK_SHARDS_NTIMERS && --sleep_count > 0);
+
+  fail_if (CHECK_SHARDS_NTIMERS != fired);
+
+  for (i = 0; i < CHECK_SHARDS_NTIMERS; ++i)
+    {
+      tiz_event_timer_destroy (timers[i]);
+    }
+
+  tiz_event_loop_destroy ();
+  (void) tiz_mutex_destroy (&g_shards_mutex);
+}
+END_TEST
+
 /* Local Variables: */
 /* c-default-style: gnu */
 /* fill-column: 79 */
@@ -0,0 +1,163 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_lfqueue.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lock-free queue API unit tests
+ *
+ *
+ */
+
+#define LFQUEUE_TEST_PRODUCERS 4
+#define LFQUEUE_TEST_ITEMS_PER_PRODUCER 10000
+
+static tiz_lfqueue_t *gp_lfqueue = NULL;
+
+static void *
+lfqueue_producer_thread (void *ap_arg)
+{
+  const intptr_t id = (intptr_t) ap_arg;
+  intptr_t i;
+
+  for (i = 1; i <= LFQUEUE_TEST_ITEMS_PER_PRODUCER; i++)
+    {
+      /* Encode the producer id and the sequence number in the pointer */
+      (void) tiz_lfqueue_send (gp_lfqueue,
+                               (OMX_PTR) ((id << 16) | i));
+    }
+
+  return NULL;
+}
+
+START_TEST (test_lfqueue_init_and_destroy)
+{
+
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_lfqueue_t *p_queue = NULL;
+
+  error = tiz_lfqueue_init (&p_queue, 10);
+
+  fail_if (error != OMX_ErrorNone);
+  fail_if (16 != tiz_lfqueue_capacity (p_queue));
+  fail_if (0 != tiz_lfqueue_length (p_queue));
+
+  tiz_lfqueue_destroy (p_queue);
+
+}
+END_TEST
+
+START_TEST (test_lfqueue_send_and_receive)
+{
+
+  OMX_U32 i;
+  OMX_PTR p_received = NULL;
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  int *p_item = NULL;
+  tiz_lfqueue_t *p_queue = NULL;;
+
+  error = tiz_lfqueue_init (&p_queue, 16);
+
+  fail_if (error != OMX_ErrorNone);
+
+  for (i = 0; i < 16; i++)
+    {
+      p_item = (int *) tiz_mem_alloc (sizeof (int));
+      fail_if (p_item == NULL);
+      *p_item = i;
+      error = tiz_lfqueue_send (p_queue, p_item);
+      fail_if (error != OMX_ErrorNone);
+    }
+
+  fail_if (16 != tiz_lfqueue_length (p_queue));
+
+  for (i = 0; i < 16; i++)
+    {
+      error = tiz_lfqueue_receive (p_queue, &p_received);
+      fail_if (error != OMX_ErrorNone);
+      fail_if (p_received == NULL);
+      p_item = (int *) p_received;
+      fail_if (*p_item != i);
+      tiz_mem_free (p_received);
+    }
+
+  fail_if (0 != tiz_lfqueue_length (p_queue));
+
+  tiz_lfqueue_destroy (p_queue);
+
+}
+END_TEST
+
+START_TEST (test_lfqueue_multiple_producers)
+{
+
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_thread_t threads[LFQUEUE_TEST_PRODUCERS];
+  intptr_t last_seq[LFQUEUE_TEST_PRODUCERS];
+  OMX_PTR p_received = NULL;
+  void *p_result = NULL;
+  intptr_t i;
+
+  /* A small queue forces both producers and consumer to park */
+  error = tiz_lfqueue_init (&gp_lfqueue, 4);
+  fail_if (error != OMX_ErrorNone);
+
+  for (i = 0; i < LFQUEUE_TEST_PRODUCERS; i++)
+    {
+      last_seq[i] = 0;
+      error = tiz_thread_create (&threads[i], 0, 0, lfqueue_producer_thread,
+                                 (OMX_PTR) (i + 1));
+      fail_if (error != OMX_ErrorNone);
+    }
+
+  for (i = 0;
+       i < LFQUEUE_TEST_PRODUCERS * LFQUEUE_TEST_ITEMS_PER_PRODUCER; i++)
+    {
+      intptr_t item, id, seq;
+      error = tiz_lfqueue_receive (gp_lfqueue, &p_received);
+      fail_if (error != OMX_ErrorNone);
+      item = (intptr_t) p_received;
+      id = (item >> 16) - 1;
+      seq = item & 0xffff;
+      fail_if (id < 0 || id >= LFQUEUE_TEST_PRODUCERS);
+      /* Per-producer FIFO order must be preserved */
+      fail_if (seq != last_seq[id] + 1);
+      last_seq[id] = seq;
+    }
+
+  for (i = 0; i < LFQUEUE_TEST_PRODUCERS; i++)
+    {
+      tiz_thread_join (&threads[i], &p_result);
+    }
+
+  fail_if (0 != tiz_lfqueue_length (gp_lfqueue));
+
+  tiz_lfqueue_destroy (gp_lfqueue);
+  gp_lfqueue = NULL;
+
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
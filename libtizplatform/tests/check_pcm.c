@@ -0,0 +1,320 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_pcm.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM kernels unit tests
+ *
+ *
+ */
+
+/* Not a multiple of any vector width, so that the tails get exercised too */
+#define PCM_TEST_NSAMPLES 1027
+
+static void
+pcm_fill_s16 (int16_t *ap_buf, size_t a_n)
+{
+  size_t i;
+  for (i = 0; i < a_n; i++)
+    {
+      ap_buf[i] = (int16_t) ((i * 7919) & 0xFFFF);
+    }
+}
+
+static void
+pcm_fill_f32 (float *ap_buf, size_t a_n)
+{
+  size_t i;
+  for (i = 0; i < a_n; i++)
+    {
+      ap_buf[i] = ((float) (i % 201) - 100.0f) / 80.0f;
+    }
+}
+
+START_TEST (test_pcm_gain_s16)
+{
+  int16_t buf[4] = { 1000, -1000, 30000, -30000 };
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+  tiz_pcm_gain (buf, 4, ETIZPcmFmtS16, 2.0f);
+
+  fail_if (2000 != buf[0]);
+  fail_if (-2000 != buf[1]);
+  fail_if (32767 != buf[2]);
+  fail_if (-32768 != buf[3]);
+}
+END_TEST
+
+START_TEST (test_pcm_gain_s24)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint8_t buf[6];
+  int32_t v;
+
+  /* 0x100000 and -0x100000, in host byte order (this test assumes a
+     little-endian host) */
+  memset (buf, 0, sizeof (buf));
+  v = 0x100000;
+  memcpy (buf, &v, 3);
+  v = -0x100000;
+  memcpy (buf + 3, &v, 3);
+
+  tiz_pcm_gain (buf, 2, ETIZPcmFmtS24, 16.0f);
+
+  v = 0;
+  memcpy (&v, buf, 3);
+  fail_if (0x7FFFFF != v);
+  v = -1;
+  memcpy (&v, buf + 3, 3);
+  fail_if (-0x800000 != v);
+#endif
+}
+END_TEST
+
+START_TEST (test_pcm_isas_agree)
+{
+  int16_t ref16[PCM_TEST_NSAMPLES], buf16[PCM_TEST_NSAMPLES];
+  float ref32[PCM_TEST_NSAMPLES], buf32[PCM_TEST_NSAMPLES];
+  int isa;
+
+  /* Every implementation available must produce the scalar results */
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+  pcm_fill_s16 (ref16, PCM_TEST_NSAMPLES);
+  tiz_pcm_gain (ref16, PCM_TEST_NSAMPLES, ETIZPcmFmtS16, 1.7f);
+  pcm_fill_f32 (ref32, PCM_TEST_NSAMPLES);
+  tiz_pcm_gain (ref32, PCM_TEST_NSAMPLES, ETIZPcmFmtF32, 0.9f);
+
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; isa++)
+    {
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "Checking [%s]", tiz_pcm_isa_to_str (isa));
+
+      pcm_fill_s16 (buf16, PCM_TEST_NSAMPLES);
+      tiz_pcm_gain (buf16, PCM_TEST_NSAMPLES, ETIZPcmFmtS16, 1.7f);
+      fail_if (0 != memcmp (ref16, buf16, sizeof (ref16)));
+
+      pcm_fill_f32 (buf32, PCM_TEST_NSAMPLES);
+      tiz_pcm_gain (buf32, PCM_TEST_NSAMPLES, ETIZPcmFmtF32, 0.9f);
+      fail_if (0 != memcmp (ref32, buf32, sizeof (ref32)));
+
+      /* Clipping leaves samples within the nominal range */
+      pcm_fill_f32 (buf32, PCM_TEST_NSAMPLES);
+      tiz_pcm_clip (buf32, PCM_TEST_NSAMPLES, ETIZPcmFmtF32);
+      fail_if (buf32[0] != -1.0f);
+      fail_if (buf32[200] != 1.0f);
+      fail_if (buf32[100] != 0.0f);
+    }
+
+  /* Restore the default */
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+}
+END_TEST
+
+START_TEST (test_pcm_swap)
+{
+  int16_t buf16[PCM_TEST_NSAMPLES], ref16[PCM_TEST_NSAMPLES];
+  uint32_t buf32[PCM_TEST_NSAMPLES];
+  uint8_t buf24[6] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+  int isa;
+  size_t i;
+
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; isa++)
+    {
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+
+      pcm_fill_s16 (ref16, PCM_TEST_NSAMPLES);
+      memcpy (buf16, ref16, sizeof (buf16));
+      tiz_pcm_swap (buf16, PCM_TEST_NSAMPLES, ETIZPcmFmtS16);
+      for (i = 0; i < PCM_TEST_NSAMPLES; i++)
+        {
+          fail_if ((uint16_t) buf16[i]
+                   != __builtin_bswap16 ((uint16_t) ref16[i]));
+        }
+
+      for (i = 0; i < PCM_TEST_NSAMPLES; i++)
+        {
+          buf32[i] = (uint32_t) i * 0x01020304u;
+        }
+      tiz_pcm_swap (buf32, PCM_TEST_NSAMPLES, ETIZPcmFmtS32);
+      for (i = 0; i < PCM_TEST_NSAMPLES; i++)
+        {
+          fail_if (buf32[i] != __builtin_bswap32 ((uint32_t) i * 0x01020304u));
+        }
+    }
+
+  tiz_pcm_swap (buf24, 2, ETIZPcmFmtS24);
+  fail_if (buf24[0] != 0x03 || buf24[1] != 0x02 || buf24[2] != 0x01);
+  fail_if (buf24[3] != 0x06 || buf24[4] != 0x05 || buf24[5] != 0x04);
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+}
+END_TEST
+
+START_TEST (test_pcm_interleave)
+{
+  int32_t l[3] = { 1, -2, 0x7FF }, r[3] = { -1, 2, -0x800 };
+  int32_t c[3] = { 5, 6, 7 };
+  const int32_t *lr[2] = { l, r };
+  const int32_t *lcr[3] = { l, c, r };
+  int16_t out16[9];
+  int32_t out32[6];
+  float outf[6];
+  uint8_t out24[9];
+  int32_t v;
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+
+  /* 12-bit samples are scaled up to the 16-bit range */
+  tiz_pcm_interleave_s32 (out16, ETIZPcmFmtS16, lr, 2, 0, 3, 12);
+  fail_if (16 != out16[0] || -16 != out16[1]);
+  fail_if (-32 != out16[2] || 32 != out16[3]);
+  fail_if (0x7FF0 != out16[4] || -0x8000 != out16[5]);
+
+  /* Any number of channels, starting at any frame */
+  tiz_pcm_interleave_s32 (out16, ETIZPcmFmtS16, lcr, 3, 1, 2, 16);
+  fail_if (-2 != out16[0] || 6 != out16[1] || 2 != out16[2]);
+  fail_if (0x7FF != out16[3] || 7 != out16[4] || -0x800 != out16[5]);
+
+  tiz_pcm_interleave_s32 (out32, ETIZPcmFmtS32, lr, 2, 0, 3, 24);
+  fail_if (256 != out32[0] || -256 != out32[1]);
+
+  tiz_pcm_interleave_s32 (outf, ETIZPcmFmtF32, lr, 2, 0, 3, 12);
+  fail_if (outf[4] != 2047.0f / 2048.0f || outf[5] != -1.0f);
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  /* 20-bit samples into packed 24-bit ones */
+  tiz_pcm_interleave_s32 (out24, ETIZPcmFmtS24, lcr, 3, 0, 1, 20);
+  v = 0;
+  memcpy (&v, out24, 3);
+  fail_if (16 != v);
+  memcpy (&v, out24 + 3, 3);
+  fail_if (80 != v);
+  v = -1;
+  memcpy (&v, out24 + 6, 3);
+  fail_if (-16 != v);
+#else
+  (void) out24;
+  (void) v;
+#endif
+}
+END_TEST
+
+START_TEST (test_pcm_interleave_isas_agree)
+{
+  int32_t l[PCM_TEST_NSAMPLES], r[PCM_TEST_NSAMPLES];
+  float lf[PCM_TEST_NSAMPLES], rf[PCM_TEST_NSAMPLES];
+  const int32_t *lr[2] = { l, r };
+  const float *lrf[2] = { lf, rf };
+  static int32_t ref32[2 * PCM_TEST_NSAMPLES], buf32[2 * PCM_TEST_NSAMPLES];
+  static int16_t ref16[2 * PCM_TEST_NSAMPLES], buf16[2 * PCM_TEST_NSAMPLES];
+  static float reff[2 * PCM_TEST_NSAMPLES], buff[2 * PCM_TEST_NSAMPLES];
+  static float refi[2 * PCM_TEST_NSAMPLES], bufi[2 * PCM_TEST_NSAMPLES];
+  const size_t n = PCM_TEST_NSAMPLES - 3;
+  int isa;
+  size_t i;
+
+  for (i = 0; i < PCM_TEST_NSAMPLES; i++)
+    {
+      l[i] = (int32_t) ((i * 7919) % 0x1000000) - 0x800000;
+      r[i] = 0x7FFFFF - (int32_t) ((i * 104729) % 0x1000000);
+    }
+  pcm_fill_f32 (lf, PCM_TEST_NSAMPLES);
+  pcm_fill_f32 (rf, PCM_TEST_NSAMPLES);
+  for (i = 0; i < PCM_TEST_NSAMPLES; i++)
+    {
+      rf[i] = -rf[i];
+    }
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+  tiz_pcm_interleave_s32 (ref16, ETIZPcmFmtS16, lr, 2, 3, n, 24);
+  tiz_pcm_interleave_s32 (ref32, ETIZPcmFmtS32, lr, 2, 3, n, 24);
+  tiz_pcm_interleave_s32 (refi, ETIZPcmFmtF32, lr, 2, 3, n, 24);
+  tiz_pcm_interleave_f32 (reff, lrf, 2, 3, n);
+
+  for (i = 0; i < n; i++)
+    {
+      fail_if (ref32[2 * i] != (int32_t) ((uint32_t) l[i + 3] << 8));
+      fail_if (reff[2 * i + 1] != rf[i + 3]);
+    }
+
+  for (isa = ETIZPcmIsaScalar; isa < ETIZPcmIsaMax; isa++)
+    {
+      if (OMX_ErrorNone != tiz_pcm_set_isa (isa))
+        {
+          continue;
+        }
+
+      tiz_pcm_interleave_s32 (buf16, ETIZPcmFmtS16, lr, 2, 3, n, 24);
+      fail_if (0 != memcmp (ref16, buf16, 2 * n * sizeof (int16_t)));
+      tiz_pcm_interleave_s32 (buf32, ETIZPcmFmtS32, lr, 2, 3, n, 24);
+      fail_if (0 != memcmp (ref32, buf32, 2 * n * sizeof (int32_t)));
+      tiz_pcm_interleave_s32 (bufi, ETIZPcmFmtF32, lr, 2, 3, n, 24);
+      fail_if (0 != memcmp (refi, bufi, 2 * n * sizeof (float)));
+      tiz_pcm_interleave_f32 (buff, lrf, 2, 3, n);
+      fail_if (0 != memcmp (reff, buff, 2 * n * sizeof (float)));
+    }
+
+  fail_if (OMX_ErrorNone != tiz_pcm_set_isa (ETIZPcmIsaScalar));
+}
+END_TEST
+
+START_TEST (test_pcm_vorbis_to_wave_order)
+{
+  /* 5.1, in Vorbis order: L C R BL BR LFE */
+  const float l[2] = { 1.0f, 11.0f }, c[2] = { 2.0f, 12.0f };
+  const float r[2] = { 3.0f, 13.0f }, bl[2] = { 4.0f, 14.0f };
+  const float br[2] = { 5.0f, 15.0f }, lfe[2] = { 6.0f, 16.0f };
+  const float *vorbis[6] = { l, c, r, bl, br, lfe };
+  /* WAVE order: L R C LFE BL BR */
+  const float expected[12] = { 1.0f, 3.0f, 2.0f, 6.0f, 4.0f, 5.0f,
+                               11.0f, 13.0f, 12.0f, 16.0f, 14.0f, 15.0f };
+  const float *wave[6];
+  float out[12];
+  size_t i;
+
+  tiz_pcm_vorbis_to_wave_order (wave, vorbis, 6);
+  fail_if (l != wave[0] || r != wave[1] || c != wave[2]);
+  fail_if (lfe != wave[3] || bl != wave[4] || br != wave[5]);
+
+  tiz_pcm_interleave_f32 (out, wave, 6, 0, 2);
+  for (i = 0; i < 12; ++i)
+    {
+      fail_if (expected[i] != out[i]);
+    }
+
+  /* Stereo and quad are the same in both orders */
+  tiz_pcm_vorbis_to_wave_order (wave, vorbis, 2);
+  fail_if (l != wave[0] || c != wave[1]);
+  tiz_pcm_vorbis_to_wave_order (wave, vorbis, 4);
+  fail_if (l != wave[0] || c != wave[1] || r != wave[2] || bl != wave[3]);
+
+  /* 3.0: L C R -> L R C */
+  tiz_pcm_vorbis_to_wave_order (wave, vorbis, 3);
+  fail_if (l != wave[0] || r != wave[1] || c != wave[2]);
+}
+END_TEST
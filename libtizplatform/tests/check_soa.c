@@ -255,6 +255,172 @@ START_TEST (test_soa_reserve_life_cycle)
 }
 END_TEST
 
+START_TEST (test_soa_large_classes)
+{
+  tiz_soa_t *p_soa = NULL;
+  size_t sizes[] = { 300, 480, 700, 1000, 1500, 2000, 3000, 4000 };
+  void *objs[8];
+  void *p_big = NULL;
+  size_t i = 0;
+  tiz_soa_info_t info;
+
+  fail_if (tiz_soa_init (&p_soa) != OMX_ErrorNone);
+
+  for (i = 0; i < 8; i++)
+    {
+      fail_if (NULL == (objs[i] = tiz_soa_calloc (p_soa, sizes[i])));
+      memset (objs[i], 0xAB, sizes[i]);
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 8);
+  fail_if (info.objects != 8);
+  fail_if (info.misses != 8);
+  for (i = 5; i < TIZ_SOA_NUM_CHUNK_CLASSES; i++)
+    {
+      fail_if (info.slices[i] != 1);
+    }
+
+  /* Too big for a slice */
+  fail_if (NULL == (p_big = tiz_soa_calloc (p_soa, 64 * 1024)));
+  memset (p_big, 0xAB, 64 * 1024);
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 8);
+  fail_if (info.large_objects != 1);
+  fail_if (info.misses != 9);
+  tiz_soa_free (p_soa, p_big);
+
+  /* Slices are zeroed on reuse */
+  tiz_soa_free (p_soa, objs[7]);
+  fail_if (NULL == (objs[7] = tiz_soa_calloc (p_soa, sizes[7])));
+  for (i = 0; i < sizes[7]; i++)
+    {
+      fail_if (0 != ((unsigned char *) objs[7])[i]);
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.large_objects != 0);
+  fail_if (info.hits != 1);
+
+  for (i = 0; i < 8; i++)
+    {
+      tiz_soa_free (p_soa, objs[i]);
+    }
+
+  tiz_soa_destroy (p_soa);
+}
+END_TEST
+
+START_TEST (test_soa_chunk_reclaim)
+{
+  tiz_soa_t *p_soa = NULL;
+  void *class0_objs[3 * MAX_CLASS0_OBJS];
+  int i = 0;
+  tiz_soa_info_t info;
+
+  fail_if (tiz_soa_init (&p_soa) != OMX_ErrorNone);
+
+  for (i = 0; i < 3 * MAX_CLASS0_OBJS; i++)
+    {
+      fail_if (NULL == (class0_objs[i] = tiz_soa_calloc (p_soa, 8)));
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 3);
+  fail_if (info.slices[0] != 3 * MAX_CLASS0_OBJS);
+
+  for (i = 0; i < 3 * MAX_CLASS0_OBJS; i++)
+    {
+      tiz_soa_free (p_soa, class0_objs[i]);
+    }
+
+  /* One free chunk is kept around */
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 1);
+  fail_if (info.reclaimed_chunks != 2);
+  fail_if (info.objects != 0);
+
+  /* Steady state: no new chunks */
+  for (i = 0; i < 1000; i++)
+    {
+      void *p_obj = tiz_soa_calloc (p_soa, 8);
+      fail_if (NULL == p_obj);
+      tiz_soa_free (p_soa, p_obj);
+    }
+
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.chunks != 1);
+  fail_if (info.reclaimed_chunks != 2);
+
+  tiz_soa_destroy (p_soa);
+}
+END_TEST
+
+#define SOA_SHARED_THREADS 4
+#define SOA_SHARED_ITERATIONS (64 * 320)
+
+static void *
+soa_shared_thread_func (void *ap_arg)
+{
+  tiz_soa_t *p_soa = ap_arg;
+  void *objs[64];
+  int i = 0;
+  int j = 0;
+
+  for (i = 0; i < SOA_SHARED_ITERATIONS; i++)
+    {
+      const size_t size = 8 + (i % 7) * 100;
+      objs[i % 64] = tiz_soa_calloc (p_soa, size);
+      fail_if (NULL == objs[i % 64]);
+      fail_if (0 != ((unsigned char *) objs[i % 64])[size - 1]);
+      memset (objs[i % 64], 0xCD, size);
+      if (63 == i % 64)
+        {
+          for (j = 0; j < 64; j++)
+            {
+              tiz_soa_free (p_soa, objs[j]);
+            }
+        }
+    }
+  return NULL;
+}
+
+START_TEST (test_soa_shared)
+{
+  tiz_soa_t *p_soa = NULL;
+  tiz_thread_t threads[SOA_SHARED_THREADS];
+  void *p_result = NULL;
+  void *p_obj = NULL;
+  int i = 0;
+  tiz_soa_info_t info;
+
+  fail_if (tiz_soa_init_shared (&p_soa) != OMX_ErrorNone);
+
+  fail_if (NULL == (p_obj = tiz_soa_calloc (p_soa, 100)));
+
+  for (i = 0; i < SOA_SHARED_THREADS; i++)
+    {
+      fail_if (OMX_ErrorNone
+               != tiz_thread_create (&threads[i], 0, 0,
+                                     soa_shared_thread_func, p_soa));
+    }
+  tiz_soa_free (p_soa, p_obj);
+  for (i = 0; i < SOA_SHARED_THREADS; i++)
+    {
+      fail_if (OMX_ErrorNone != tiz_thread_join (&threads[i], &p_result));
+    }
+
+  /* Exiting threads have emptied their magazines; this one still has some
+     slices in its own */
+  tiz_soa_info (p_soa, &info);
+  fail_if (info.objects > TIZ_SOA_NUM_CHUNK_CLASSES * 32);
+  fail_if (info.hits + info.misses < SOA_SHARED_THREADS);
+  fail_if (info.hits < info.misses);
+
+  tiz_soa_destroy (p_soa);
+}
+END_TEST
+
 /* Local Variables: */
 /* c-default-style: gnu */
 /* fill-column: 79 */
@@ -27,7 +27,10 @@
  */
 
 
+#include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include <signal.h>
 #include <unistd.h>
@@ -44,8 +47,14 @@
 #include "./check_sem.c"
 #include "./check_mutex.c"
 #include "./check_queue.c"
+#include "./check_lfqueue.c"
+#include "./check_wpool.c"
+#include "./check_aio.c"
+#include "./check_bufpool.c"
+#include "./check_pcm.c"
 #include "./check_pqueue.c"
 #include "./check_vector.c"
+#include "./check_buffer.c"
 #include "./check_rc.c"
 #include "./check_soa.c"
 #include "./check_event.c"
@@ -106,6 +115,95 @@ platform_queue_suite (void)
   suite_add_tcase (s, tc_queue);
 
   return s;
+
+}
+
+Suite *
+platform_lfqueue_suite (void)
+{
+  TCase *tc_lfqueue = NULL;
+  Suite *s = suite_create ("Lock-free FIFO queue");
+
+  /* lock-free queue API test case */
+  tc_lfqueue = tcase_create ("lfqueue");
+  tcase_add_test (tc_lfqueue, test_lfqueue_init_and_destroy);
+  tcase_add_test (tc_lfqueue, test_lfqueue_send_and_receive);
+  tcase_add_test (tc_lfqueue, test_lfqueue_multiple_producers);
+  suite_add_tcase (s, tc_lfqueue);
+
+  return s;
+
+}
+
+Suite *
+platform_wpool_suite (void)
+{
+  TCase *tc_wpool = NULL;
+  Suite *s = suite_create ("Worker thread pool");
+
+  /* worker pool API test case */
+  tc_wpool = tcase_create ("wpool");
+  tcase_add_test (tc_wpool, test_wpool_init_and_destroy);
+  tcase_add_test (tc_wpool, test_wpool_submit);
+  tcase_add_test (tc_wpool, test_wpool_block);
+  suite_add_tcase (s, tc_wpool);
+
+  return s;
+
+}
+
+Suite *
+platform_aio_suite (void)
+{
+  TCase *tc_aio = NULL;
+  Suite *s = suite_create ("Asynchronous file I/O");
+
+  /* aio API test case */
+  tc_aio = tcase_create ("aio");
+  tcase_add_test (tc_aio, test_aio_init_and_destroy);
+  tcase_add_test (tc_aio, test_aio_write_and_read);
+  tcase_add_test (tc_aio, test_aio_error);
+  suite_add_tcase (s, tc_aio);
+
+  return s;
+
+}
+
+Suite *
+platform_bufpool_suite (void)
+{
+  TCase *tc_bufpool = NULL;
+  Suite *s = suite_create ("Buffer pools");
+
+  /* bufpool API test case */
+  tc_bufpool = tcase_create ("bufpool");
+  tcase_add_test (tc_bufpool, test_bufpool_get_and_put);
+  tcase_add_test (tc_bufpool, test_bufpool_huge_and_numa);
+  suite_add_tcase (s, tc_bufpool);
+
+  return s;
+
+}
+
+Suite *
+platform_pcm_suite (void)
+{
+  TCase *tc_pcm = NULL;
+  Suite *s = suite_create ("PCM processing kernels");
+
+  /* pcm kernels test case */
+  tc_pcm = tcase_create ("pcm");
+  tcase_add_test (tc_pcm, test_pcm_gain_s16);
+  tcase_add_test (tc_pcm, test_pcm_gain_s24);
+  tcase_add_test (tc_pcm, test_pcm_isas_agree);
+  tcase_add_test (tc_pcm, test_pcm_swap);
+  tcase_add_test (tc_pcm, test_pcm_interleave);
+  tcase_add_test (tc_pcm, test_pcm_interleave_isas_agree);
+  tcase_add_test (tc_pcm, test_pcm_vorbis_to_wave_order);
+  suite_add_tcase (s, tc_pcm);
+
+  return s;
+
 }
 
 Suite *
@@ -128,6 +226,22 @@ platform_pqueue_suite (void)
   return s;
 }
 
+Suite *
+platform_buffer_suite (void)
+{
+  TCase *tc_buffer = NULL;
+  Suite *s = suite_create ("Dynamic and ring buffers");
+
+  /* buffer API test case */
+  tc_buffer = tcase_create ("buffer");
+  tcase_add_test (tc_buffer, test_buffer_push_and_advance);
+  tcase_add_test (tc_buffer, test_buffer_ring_wrap_around);
+  tcase_add_test (tc_buffer, test_buffer_write_span);
+  suite_add_tcase (s, tc_buffer);
+
+  return s;
+}
+
 Suite *
 platform_vector_suite (void)
 {
@@ -173,6 +287,9 @@ platform_soa_suite (void)
   tc_soa = tcase_create ("soa");
   tcase_add_test (tc_soa, test_soa_basic_life_cycle);
   tcase_add_test (tc_soa, test_soa_reserve_life_cycle);
+  tcase_add_test (tc_soa, test_soa_large_classes);
+  tcase_add_test (tc_soa, test_soa_chunk_reclaim);
+  tcase_add_test (tc_soa, test_soa_shared);
   suite_add_tcase (s, tc_soa);
 
   return s;
@@ -191,6 +308,7 @@ platform_event_suite (void)
   tcase_add_test (tc_event, test_event_io);
   tcase_add_test (tc_event, test_event_timer);
   tcase_add_test (tc_event, test_event_stat);
+  tcase_add_test (tc_event, test_event_shards);
   suite_add_tcase (s, tc_event);
 
   return s;
@@ -240,8 +358,14 @@ main (void)
   sr = srunner_create (platform_mem_suite ());
   srunner_add_suite (sr, platform_sync_suite ());
   srunner_add_suite (sr, platform_queue_suite ());
+  srunner_add_suite (sr, platform_lfqueue_suite ());
+  srunner_add_suite (sr, platform_wpool_suite ());
+  srunner_add_suite (sr, platform_aio_suite ());
+  srunner_add_suite (sr, platform_bufpool_suite ());
+  srunner_add_suite (sr, platform_pcm_suite ());
   srunner_add_suite (sr, platform_pqueue_suite ());
   srunner_add_suite (sr, platform_vector_suite ());
+  srunner_add_suite (sr, platform_buffer_suite ());
   srunner_add_suite (sr, platform_rcfile_suite ());
   srunner_add_suite (sr, platform_soa_suite ());
   srunner_add_suite (sr, platform_http_parser_suite ());
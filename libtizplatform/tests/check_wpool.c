@@ -0,0 +1,149 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_wpool.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Worker pool API unit tests
+ *
+ *
+ */
+
+#define WPOOL_TEST_TASKS 2000
+
+typedef struct wpool_test_ctx wpool_test_ctx_t;
+struct wpool_test_ctx
+{
+  tiz_wpool_t *p_pool;
+  tiz_sem_t done;
+  int count;
+  int nested;
+};
+
+static void
+wpool_count_task (void *ap_arg)
+{
+  wpool_test_ctx_t *p_ctx = ap_arg;
+  if (WPOOL_TEST_TASKS
+      == __atomic_add_fetch (&(p_ctx->count), 1, __ATOMIC_SEQ_CST))
+    {
+      (void) tiz_sem_post (&(p_ctx->done));
+    }
+}
+
+static void
+wpool_reply_task (void *ap_arg)
+{
+  wpool_test_ctx_t *p_ctx = ap_arg;
+  (void) tiz_sem_post (&(p_ctx->done));
+}
+
+static void
+wpool_blocking_task (void *ap_arg)
+{
+  wpool_test_ctx_t *p_ctx = ap_arg;
+  tiz_wpool_task_t reply = { wpool_reply_task, NULL };
+  wpool_test_ctx_t reply_ctx;
+
+  fail_if (OMX_TRUE != tiz_wpool_is_worker (p_ctx->p_pool));
+
+  /* Submit a task from inside the pool and wait for it. With a single base
+     worker, this only completes if the pool starts a spare worker */
+  fail_if (OMX_ErrorNone != tiz_sem_init (&(reply_ctx.done), 0));
+  reply.p_arg = &reply_ctx;
+  fail_if (OMX_ErrorNone != tiz_wpool_submit (p_ctx->p_pool, &reply));
+  tiz_wpool_block_begin (p_ctx->p_pool);
+  (void) tiz_sem_wait (&(reply_ctx.done));
+  tiz_wpool_block_end (p_ctx->p_pool);
+  (void) tiz_sem_destroy (&(reply_ctx.done));
+
+  p_ctx->nested = 1;
+  (void) tiz_sem_post (&(p_ctx->done));
+}
+
+START_TEST (test_wpool_init_and_destroy)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  tiz_wpool_t *p_pool = NULL;
+
+  error = tiz_wpool_init (&p_pool, 2, 2);
+
+  fail_if (error != OMX_ErrorNone);
+  fail_if (2 != tiz_wpool_nthreads (p_pool));
+  fail_if (OMX_FALSE != tiz_wpool_is_worker (p_pool));
+
+  tiz_wpool_destroy (p_pool);
+}
+END_TEST
+
+START_TEST (test_wpool_submit)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  wpool_test_ctx_t ctx;
+  tiz_wpool_task_t *p_tasks = NULL;
+  int i;
+
+  memset (&ctx, 0, sizeof (ctx));
+  fail_if (OMX_ErrorNone != tiz_sem_init (&(ctx.done), 0));
+  error = tiz_wpool_init (&(ctx.p_pool), 4, 4);
+  fail_if (error != OMX_ErrorNone);
+
+  p_tasks = tiz_mem_calloc (WPOOL_TEST_TASKS, sizeof (tiz_wpool_task_t));
+  fail_if (NULL == p_tasks);
+
+  for (i = 0; i < WPOOL_TEST_TASKS; i++)
+    {
+      p_tasks[i].pf_run = wpool_count_task;
+      p_tasks[i].p_arg = &ctx;
+      error = tiz_wpool_submit (ctx.p_pool, &(p_tasks[i]));
+      fail_if (error != OMX_ErrorNone);
+    }
+
+  (void) tiz_sem_wait (&(ctx.done));
+  fail_if (WPOOL_TEST_TASKS != ctx.count);
+
+  tiz_wpool_destroy (ctx.p_pool);
+  tiz_mem_free (p_tasks);
+  (void) tiz_sem_destroy (&(ctx.done));
+}
+END_TEST
+
+START_TEST (test_wpool_block)
+{
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  wpool_test_ctx_t ctx;
+  tiz_wpool_task_t task = { wpool_blocking_task, NULL };
+
+  memset (&ctx, 0, sizeof (ctx));
+  fail_if (OMX_ErrorNone != tiz_sem_init (&(ctx.done), 0));
+  error = tiz_wpool_init (&(ctx.p_pool), 1, 2);
+  fail_if (error != OMX_ErrorNone);
+
+  task.p_arg = &ctx;
+  fail_if (OMX_ErrorNone != tiz_wpool_submit (ctx.p_pool, &task));
+
+  (void) tiz_sem_wait (&(ctx.done));
+  fail_if (1 != ctx.nested);
+  fail_if (2 != tiz_wpool_nthreads (ctx.p_pool));
+
+  tiz_wpool_destroy (ctx.p_pool);
+  (void) tiz_sem_destroy (&(ctx.done));
+}
+END_TEST
@@ -131,6 +131,31 @@ void graph::mp3decops::do_configure ()
   }
 }
 
+// MP3 frames are self-contained, so the decoder can go from one stream to the
+// next without a reset, as long as the output format does not change (any
+// tags in between are skipped as junk).
+bool graph::mp3decops::is_gapless_compatible (
+    const tizprobe_ptr_t &next_probe_ptr) const
+{
+  assert (probe_ptr_);
+  assert (next_probe_ptr);
+
+  if (OMX_AUDIO_CodingMP3 != next_probe_ptr->get_audio_coding_type ())
+  {
+    return false;
+  }
+
+  OMX_AUDIO_PARAM_PCMMODETYPE cur_pcmtype;
+  OMX_AUDIO_PARAM_PCMMODETYPE next_pcmtype;
+  TIZ_INIT_OMX_PORT_STRUCT (cur_pcmtype, 0);
+  TIZ_INIT_OMX_PORT_STRUCT (next_pcmtype, 0);
+  probe_ptr_->get_pcm_codec_info (cur_pcmtype);
+  next_probe_ptr->get_pcm_codec_info (next_pcmtype);
+
+  return (cur_pcmtype.nSamplingRate == next_pcmtype.nSamplingRate
+          && cur_pcmtype.nChannels == next_pcmtype.nChannels);
+}
+
 void graph::mp3decops::get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype)
 {
   OMX_U32 dec_port_id = 1;
@@ -0,0 +1,298 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizdirscan.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Directory walker used to assemble playlists
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/thread.hpp>
+
+#include <tizplatform.h>
+
+#include "tizdirscan.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.dirscan"
+#endif
+
+namespace  // unnamed namespace
+{
+  // Upper bound on the number of threads that walk a directory tree
+  const unsigned int SCAN_MAX_THREADS = 8;
+
+  // Size of the buffer that receives each batch of directory entries
+  const size_t SCAN_DIRENT_BATCH_SIZE = 64 * 1024;
+
+  // The record returned by the getdents64 system call
+  struct linux_dirent64_t
+  {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+  };
+
+  // Shared state of a directory walk. Directories waiting to be read are
+  // queued in 'pending_'; the walk is over when the queue is empty and no
+  // worker is reading a directory (which could queue more).
+  struct dir_scan
+  {
+    dir_scan (const file_extension_lst_t &extension_list, const bool recurse)
+      : extension_list_ (extension_list),
+        recurse_ (recurse),
+        pending_ (),
+        nbusy_ (0),
+        nentries_ (0),
+        found_ (),
+        mutex_ (),
+        cond_ ()
+    {
+    }
+
+    const file_extension_lst_t &extension_list_;
+    const bool recurse_;
+    std::deque< std::string > pending_;
+    unsigned int nbusy_;
+    size_t nentries_;
+    uri_lst_t found_;
+    boost::mutex mutex_;
+    boost::condition_variable cond_;
+  };
+
+  // Reads a directory in batches with getdents64. The entry type reported by
+  // the file system is used whenever available, so there is no stat per
+  // entry. Symlinks to directories are not followed (same as
+  // boost::filesystem::recursive_directory_iterator).
+  size_t read_dir (const std::string &dir,
+                   const file_extension_lst_t &extension_list,
+                   uri_lst_t &files, std::vector< std::string > &subdirs)
+  {
+    size_t nentries = 0;
+    const int fd = open (dir.c_str (), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : %s", dir.c_str (),
+               strerror (errno));
+      return 0;
+    }
+
+    std::string prefix (dir);
+    if (prefix.empty () || prefix[prefix.size () - 1] != '/')
+    {
+      prefix.push_back ('/');
+    }
+
+    std::vector< char > batch (SCAN_DIRENT_BATCH_SIZE);
+    long nread = 0;
+    while ((nread = syscall (SYS_getdents64, fd, &batch[0], batch.size ())) > 0)
+    {
+      long pos = 0;
+      while (pos < nread)
+      {
+        const linux_dirent64_t *p_ent
+            = reinterpret_cast< const linux_dirent64_t * >(&batch[pos]);
+        const char *p_name = p_ent->d_name;
+        unsigned char type = p_ent->d_type;
+        pos += p_ent->d_reclen;
+
+        if ('.' == p_name[0]
+            && ('\0' == p_name[1] || ('.' == p_name[1] && '\0' == p_name[2])))
+        {
+          continue;
+        }
+
+        if (!tiz::dirscan::entry_type (fd, p_name, type))
+        {
+          continue;
+        }
+
+        if (DT_DIR == type)
+        {
+          subdirs.push_back (prefix + p_name);
+        }
+        else
+        {
+          ++nentries;
+          if ((DT_REG == type || DT_LNK == type)
+              && tiz::dirscan::is_known_media (extension_list, p_name))
+          {
+            files.push_back (prefix + p_name);
+          }
+        }
+      }
+    }
+
+    if (nread < 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s] : %s", dir.c_str (),
+               strerror (errno));
+    }
+
+    close (fd);
+    return nentries;
+  }
+
+  struct scan_worker
+  {
+    scan_worker (dir_scan &scan) : scan_ (scan)
+    {
+    }
+
+    void operator()()
+    {
+      uri_lst_t files;
+      std::vector< std::string > subdirs;
+      for (;;)
+      {
+        std::string dir;
+        {
+          boost::unique_lock< boost::mutex > lock (scan_.mutex_);
+          while (scan_.pending_.empty () && scan_.nbusy_ > 0)
+          {
+            scan_.cond_.wait (lock);
+          }
+          if (scan_.pending_.empty ())
+          {
+            break;
+          }
+          dir.swap (scan_.pending_.front ());
+          scan_.pending_.pop_front ();
+          ++scan_.nbusy_;
+        }
+
+        files.clear ();
+        subdirs.clear ();
+        const size_t nentries
+            = read_dir (dir, scan_.extension_list_, files, subdirs);
+
+        {
+          boost::lock_guard< boost::mutex > lock (scan_.mutex_);
+          scan_.nentries_ += nentries;
+          scan_.found_.insert (scan_.found_.end (), files.begin (),
+                               files.end ());
+          if (scan_.recurse_)
+          {
+            scan_.pending_.insert (scan_.pending_.end (), subdirs.begin (),
+                                   subdirs.end ());
+          }
+          else
+          {
+            scan_.nentries_ += subdirs.size ();
+          }
+          --scan_.nbusy_;
+        }
+        scan_.cond_.notify_all ();
+      }
+    }
+
+    dir_scan &scan_;
+  };
+}  // unnamed namespace
+
+//
+// dirscan
+//
+unsigned int tiz::dirscan::scan (const std::string &dir,
+                                 const file_extension_lst_t &extension_list,
+                                 const bool recurse, uri_lst_t &files,
+                                 size_t &nentries)
+{
+  dir_scan scan (extension_list, recurse);
+  boost::thread_group workers;
+  const unsigned int nworkers
+      = recurse ? std::min (std::max (boost::thread::hardware_concurrency (),
+                                      1U),
+                            SCAN_MAX_THREADS)
+                : 1;
+
+  scan.pending_.push_back (dir);
+  for (unsigned int i = 0; i < nworkers; ++i)
+  {
+    workers.create_thread (scan_worker (scan));
+  }
+  workers.join_all ();
+
+  nentries = scan.nentries_;
+  files.insert (files.end (), scan.found_.begin (), scan.found_.end ());
+  return nworkers;
+}
+
+bool tiz::dirscan::entry_type (const int dir_fd, const char *p_name,
+                               unsigned char &type)
+{
+  if (DT_UNKNOWN == type)
+  {
+    struct stat st;
+    if (0 != fstatat (dir_fd, p_name, &st, AT_SYMLINK_NOFOLLOW))
+    {
+      return false;
+    }
+    type = S_ISDIR (st.st_mode)
+               ? DT_DIR
+               : (S_ISREG (st.st_mode)
+                      ? DT_REG
+                      : (S_ISLNK (st.st_mode) ? DT_LNK : DT_UNKNOWN));
+  }
+  return true;
+}
+
+// Takes the extension from the string directly, without constructing a path
+// object per uri
+std::string tiz::dirscan::lower_extension (const std::string &uri)
+{
+  const std::string::size_type slash = uri.rfind ('/');
+  const std::string::size_type dot = uri.rfind ('.');
+  std::string extension;
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+  {
+    extension.assign (uri, dot, std::string::npos);
+    boost::algorithm::to_lower (extension);
+  }
+  return extension;
+}
+
+bool tiz::dirscan::is_known_media (const file_extension_lst_t &extension_list,
+                                   const std::string &uri)
+{
+  return extension_list.find (lower_extension (uri)) != extension_list.end ();
+}
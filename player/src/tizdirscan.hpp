@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizdirscan.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Directory walker used to assemble playlists
+ *
+ *
+ */
+
+#ifndef TIZDIRSCAN_HPP
+#define TIZDIRSCAN_HPP
+
+#include <string>
+
+#include "tizgraphtypes.hpp"
+
+namespace tiz
+{
+  class dirscan
+  {
+
+  public:
+    /**
+     * Walks a directory (and, if 'recurse' is set, its sub-directories) with
+     * a pool of threads, appending to 'files' the regular files and symlinks
+     * whose extension is in 'extension_list'. The files are appended in no
+     * particular order.
+     *
+     * 'nentries' receives the number of entries seen, media or not, other
+     * than the directories that have been descended into. That is, when not
+     * recursing, sub-directories count as entries.
+     *
+     * @return The number of threads used.
+     */
+    static unsigned int scan (const std::string &dir,
+                              const file_extension_lst_t &extension_list,
+                              const bool recurse, uri_lst_t &files,
+                              size_t &nentries);
+
+    /**
+     * Resolves the type of a directory entry. Types reported by the file
+     * system (d_type) are returned as they are; when the file system reports
+     * DT_UNKNOWN, the type is obtained with fstatat, without following
+     * symlinks.
+     *
+     * @return false if the entry could not be stat'ed.
+     */
+    static bool entry_type (const int dir_fd, const char *p_name,
+                            unsigned char &type);
+
+    /**
+     * Same as boost::filesystem::path (uri).extension (), in lower case.
+     */
+    static std::string lower_extension (const std::string &uri);
+
+    static bool is_known_media (const file_extension_lst_t &extension_list,
+                                const std::string &uri);
+  };
+}  // namespace tiz
+
+#endif  // TIZDIRSCAN_HPP
@@ -164,9 +164,9 @@ graph::graph::pause ()
 }
 
 OMX_ERRORTYPE
-graph::graph::seek ()
+graph::graph::seek (const int jump_secs)
 {
-  return post_cmd (new tiz::graph::cmd (tiz::graph::seek_evt ()));
+  return post_cmd (new tiz::graph::cmd (tiz::graph::seek_evt (jump_secs)));
 }
 
 OMX_ERRORTYPE
@@ -193,6 +193,12 @@ graph::graph::mute ()
   return post_cmd (new tiz::graph::cmd (tiz::graph::mute_evt ()));
 }
 
+OMX_ERRORTYPE
+graph::graph::print_stats ()
+{
+  return post_cmd (new tiz::graph::cmd (tiz::graph::stats_evt ()));
+}
+
 OMX_ERRORTYPE
 graph::graph::stop ()
 {
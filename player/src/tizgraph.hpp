@@ -71,11 +71,12 @@ namespace tiz
       OMX_ERRORTYPE load ();
       OMX_ERRORTYPE execute (const tizgraphconfig_ptr_t config);
       OMX_ERRORTYPE pause ();
-      OMX_ERRORTYPE seek ();
+      OMX_ERRORTYPE seek (const int jump_secs);
       OMX_ERRORTYPE skip (const int jump);
       OMX_ERRORTYPE volume_step (const int step);
       OMX_ERRORTYPE volume (const double vol);
       OMX_ERRORTYPE mute ();
+      OMX_ERRORTYPE print_stats ();
       OMX_ERRORTYPE stop ();
       void unload ();
       void deinit ();
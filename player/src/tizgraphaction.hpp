@@ -87,6 +87,32 @@ namespace tiz
       }
     };
 
+    struct do_preroll_next
+    {
+      template < class FSM, class EVT, class SourceState, class TargetState >
+      void operator()(EVT const& evt, FSM& fsm, SourceState&, TargetState&)
+      {
+        G_ACTION_LOG ();
+        if (fsm.pp_ops_ && *(fsm.pp_ops_))
+        {
+          (*(fsm.pp_ops_))->do_preroll_next ();
+        }
+      }
+    };
+
+    struct do_gapless_advance
+    {
+      template < class FSM, class EVT, class SourceState, class TargetState >
+      void operator()(EVT const& evt, FSM& fsm, SourceState&, TargetState&)
+      {
+        G_ACTION_LOG ();
+        if (fsm.pp_ops_ && *(fsm.pp_ops_))
+        {
+          (*(fsm.pp_ops_))->do_gapless_advance ();
+        }
+      }
+    };
+
     struct do_skip
     {
       template < class FSM, class EVT, class SourceState, class TargetState >
@@ -331,12 +357,12 @@ namespace tiz
     struct do_seek
     {
       template < class FSM, class EVT, class SourceState, class TargetState >
-      void operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+      void operator()(EVT const& evt, FSM& fsm, SourceState&, TargetState&)
       {
         G_ACTION_LOG ();
         if (fsm.pp_ops_ && *(fsm.pp_ops_))
         {
-          (*(fsm.pp_ops_))->do_seek ();
+          (*(fsm.pp_ops_))->do_seek (evt.jump_secs_);
         }
       }
     };
@@ -393,6 +419,19 @@ namespace tiz
       }
     };
 
+    struct do_print_stats
+    {
+      template < class FSM, class EVT, class SourceState, class TargetState >
+      void operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+      {
+        G_ACTION_LOG ();
+        if (fsm.pp_ops_ && *(fsm.pp_ops_))
+        {
+          (*(fsm.pp_ops_))->do_print_stats ();
+        }
+      }
+    };
+
     struct do_exe2pause
     {
       template < class FSM, class EVT, class SourceState, class TargetState >
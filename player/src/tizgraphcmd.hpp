@@ -91,6 +91,7 @@ namespace tiz
                     else INJECT_EVENT (volume_step_evt)
                       else INJECT_EVENT (volume_evt)
                         else INJECT_EVENT (mute_evt)
+                        else INJECT_EVENT (stats_evt)
                           else INJECT_EVENT (pause_evt)
                             else INJECT_EVENT (omx_evt)
                               else INJECT_EVENT (omx_eos_evt)
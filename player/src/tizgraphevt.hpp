@@ -97,6 +97,10 @@ namespace tiz
 
     struct seek_evt
     {
+      seek_evt (const int jump_secs) : jump_secs_ (jump_secs)
+      {
+      }
+      const int jump_secs_;
     };
 
     struct volume_step_evt
@@ -119,6 +123,10 @@ namespace tiz
     {
     };
 
+    struct stats_evt
+    {
+    };
+
     struct pause_evt
     {
     };
@@ -305,7 +305,8 @@ namespace tiz
                                   ::conf_exit>, configured_evt , executing               , boost::msm::front::ActionSequence_<
                                                                                              boost::mpl::vector<
                                                                                                do_retrieve_metadata,
-                                                                                               do_ack_execd> >                            >,
+                                                                                               do_ack_execd,
+                                                                                               do_preroll_next> >                         >,
         boost::msm::front::Row < configuring
                                  ::exit_pt
                                  <configuring_
@@ -320,6 +321,7 @@ namespace tiz
         boost::msm::front::Row < executing   , volume_step_evt , boost::msm::front::none , do_volume_step                                 >,
         boost::msm::front::Row < executing   , volume_evt      , boost::msm::front::none , do_volume                                      >,
         boost::msm::front::Row < executing   , mute_evt        , boost::msm::front::none , do_mute                                        >,
+        boost::msm::front::Row < executing   , stats_evt       , boost::msm::front::none , do_print_stats                                 >,
         boost::msm::front::Row < executing   , pause_evt       , exe2pause               , do_exe2pause                               >,
         boost::msm::front::Row < executing   , stop_evt        , exe2idle                , boost::msm::front::ActionSequence_<
                                                                                              boost::mpl::vector<
@@ -329,6 +331,7 @@ namespace tiz
         boost::msm::front::Row < executing   , omx_err_evt     , skipping                , boost::msm::front::none                        >,
         boost::msm::front::Row < executing   , omx_err_evt     , skipping                , do_record_fatal_error   , is_fatal_error       >,
         boost::msm::front::Row < executing   , omx_eos_evt     , skipping                , boost::msm::front::none , is_last_eos          >,
+        boost::msm::front::Row < executing   , omx_index_setting_evt, boost::msm::front::none, do_gapless_advance , is_next_uri_started >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         boost::msm::front::Row < skipping
                                  ::exit_pt
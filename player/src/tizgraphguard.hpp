@@ -300,6 +300,21 @@ namespace tiz
       }
     };
 
+    struct is_next_uri_started
+    {
+      template < class EVT, class FSM, class SourceState, class TargetState >
+      bool operator()(EVT const& evt, FSM& fsm, SourceState&, TargetState&)
+      {
+        bool rc = false;
+        if (fsm.pp_ops_ && *(fsm.pp_ops_))
+        {
+          rc = (*(fsm.pp_ops_))->is_next_uri_started (evt.handle_, evt.index_);
+        }
+        G_GUARD_LOG (rc);
+        return rc;
+      }
+    };
+
     template<OMX_INDEXTYPE param_or_config_idx>
     struct is_setting_changed
     {
@@ -225,6 +225,12 @@ graphmgr::mgr::mute ()
   return post_cmd (new graphmgr::cmd (graphmgr::mute_evt ()));
 }
 
+OMX_ERRORTYPE
+graphmgr::mgr::print_stats ()
+{
+  return post_cmd (new graphmgr::cmd (graphmgr::stats_evt ()));
+}
+
 OMX_ERRORTYPE
 graphmgr::mgr::pause ()
 {
@@ -180,6 +180,17 @@ namespace tiz
        */
       OMX_ERRORTYPE mute ();
 
+      /**
+       * Print the performance counters of the components in the current
+       * graph.
+       *
+       * @pre init() has been called on this manager.
+       *
+       * @return OMX_ErrorInsuficientResources if OOM. OMX_ErrorNone in case of
+       * success.
+       */
+      OMX_ERRORTYPE print_stats ();
+
       /**
        * Pause the processing of the current item in the playlist.
        *
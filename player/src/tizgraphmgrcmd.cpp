@@ -86,6 +86,7 @@ void graphmgr::cmd::inject (fsm& machine) const
             else INJECT_EVENT (vol_down_evt)
               else INJECT_EVENT (vol_evt)
                 else INJECT_EVENT (mute_evt)
+                else INJECT_EVENT (stats_evt)
                   else INJECT_EVENT (pause_evt)
                     else INJECT_EVENT (stop_evt)
                       else INJECT_EVENT (quit_evt)
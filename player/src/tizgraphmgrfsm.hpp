@@ -94,6 +94,7 @@ namespace tiz
       const double vol_;
     };
     struct mute_evt {};
+    struct stats_evt {};
     struct pause_evt {};
     struct stop_evt {};
     struct quit_evt {};
@@ -598,6 +599,19 @@ namespace tiz
         }
       };
 
+      struct do_print_stats
+      {
+        template <class FSM,class EVT,class SourceState,class TargetState>
+        void operator()(EVT const& ,FSM& fsm, SourceState& , TargetState&)
+        {
+          GMGR_FSM_LOG ();
+          if (fsm.pp_ops_ && *(fsm.pp_ops_))
+            {
+              (*(fsm.pp_ops_))->do_print_stats ();
+            }
+        }
+      };
+
       struct do_pause
       {
         template <class FSM,class EVT,class SourceState,class TargetState>
@@ -766,6 +780,7 @@ namespace tiz
         bmf::Row < running               , vol_down_evt     , bmf::none   , do_vol_down                                 >,
         bmf::Row < running               , vol_evt          , bmf::none   , do_vol                                      >,
         bmf::Row < running               , mute_evt         , bmf::none   , do_mute                                     >,
+        bmf::Row < running               , stats_evt        , bmf::none   , do_print_stats                              >,
         bmf::Row < running               , pause_evt        , bmf::none   , do_pause                                    >,
         bmf::Row < running               , graph_paused_evt , bmf::none   , do_update_control_ifcs<tc::Paused>          >,
         bmf::Row < running               , graph_unpaused_evt, bmf::none  , do_update_control_ifcs<tc::Playing>         >,
@@ -228,12 +228,16 @@ void graphmgr::ops::do_prev ()
 
 void graphmgr::ops::do_fwd ()
 {
-  // TODO:
+  GMGR_OPS_BAIL_IF_ERROR (p_managed_graph_,
+                          p_managed_graph_->seek (SEEK_STEP_SECS),
+                          "Unable to seek forward.");
 }
 
 void graphmgr::ops::do_rwd ()
 {
-  // TODO:
+  GMGR_OPS_BAIL_IF_ERROR (p_managed_graph_,
+                          p_managed_graph_->seek (-SEEK_STEP_SECS),
+                          "Unable to seek backwards.");
 }
 
 void graphmgr::ops::do_vol_up ()
@@ -260,6 +264,12 @@ void graphmgr::ops::do_mute ()
                           "Unable to mute/unmute.");
 }
 
+void graphmgr::ops::do_print_stats ()
+{
+  GMGR_OPS_BAIL_IF_ERROR (p_managed_graph_, p_managed_graph_->print_stats (),
+                          "Unable to print the performance counters.");
+}
+
 void graphmgr::ops::do_pause ()
 {
   GMGR_OPS_BAIL_IF_ERROR (p_managed_graph_, p_managed_graph_->pause (),
@@ -79,6 +79,9 @@ namespace tiz
       typedef boost::function< void(OMX_ERRORTYPE, std::string) >
           termination_callback_t;
 
+      // The number of seconds that fwd and rwd move the playback position by
+      static const int SEEK_STEP_SECS = 10;
+
     public:
       ops (mgr *p_mgr, const tizplaylist_ptr_t &playlist,
            const termination_callback_t &termination_cback);
@@ -100,6 +103,7 @@ namespace tiz
       virtual void do_vol_down ();
       virtual void do_vol (const double vol);
       virtual void do_mute ();
+      virtual void do_print_stats ();
       virtual void do_pause ();
       virtual void do_report_fatal_error (const OMX_ERRORTYPE error,
                                           const std::string &msg);
@@ -40,6 +40,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/assign/list_of.hpp>
 
+#include <OMX_TizoniaExt.h>
 #include <tizplatform.h>
 #include <tizmacros.h>
 
@@ -64,6 +65,12 @@ graph::ops::ops (graph *p_graph, const omx_comp_name_lst_t &comp_lst,
                  const omx_comp_role_lst_t &role_lst)
   : p_graph_ (p_graph),
     probe_ptr_ (),
+    next_probe_ptr_ (),
+    gapless_ (0 == tiz_rcfile_compare_value ("tizonia", "gapless-playback",
+                                             "true")),
+    probe_graph_id_ (),
+    probe_graph_action_ (),
+    probe_dump_f_ (NULL),
     comp_lst_ (comp_lst),
     role_lst_ (role_lst),
     handles_ (),
@@ -423,9 +430,29 @@ void graph::ops::do_idle2loaded_comp (const int comp_id)
   }
 }
 
-void graph::ops::do_seek ()
+/**
+ * Default implementation of do_seek () operation. It moves the playback
+ * position of the first element of the graph (the file reader or the
+ * demuxer) forwards or backwards. Sources that are unable to seek simply
+ * carry on playing.
+ *
+ * @param jump_secs The number of seconds to move forwards (if positive) or
+ * backwards (negative).
+ */
+void graph::ops::do_seek (const int jump_secs)
 {
-  // TODO
+  if (last_op_succeeded () && 0 != jump_secs)
+  {
+    OMX_U32 output_port = 0;
+    OMX_ERRORTYPE rc = OMX_ErrorNone;
+    assert (!handles_.empty ());
+    if (OMX_ErrorNone
+        != (rc = util::apply_time_seek (handles_[0], output_port, jump_secs)))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : Unable to seek",
+               tiz_err_to_str (rc));
+    }
+  }
 }
 
 void graph::ops::do_skip ()
@@ -521,6 +548,25 @@ void graph::ops::do_mute ()
   }
 }
 
+/**
+ * Default implementation of do_print_stats () operation. It prints the
+ * performance counters of every component in the graph.
+ *
+ */
+void graph::ops::do_print_stats ()
+{
+  for (size_t i = 0; i < handles_.size () && i < comp_lst_.size (); ++i)
+  {
+    // This is informational only; failures must not disturb playback
+    OMX_ERRORTYPE rc = util::dump_perf_counters (handles_[i], comp_lst_[i]);
+    if (OMX_ErrorNone != rc)
+    {
+      TIZ_LOG (TIZ_PRIORITY_WARN, "[%s] : [%s] performance counters",
+               tiz_err_to_str (rc), comp_lst_[i].c_str ());
+    }
+  }
+}
+
 void graph::ops::do_error ()
 {
   if (p_graph_)
@@ -580,6 +626,62 @@ void graph::ops::do_retrieve_metadata ()
   // To be overriden in child classes when needed.
 }
 
+/**
+ * Gapless playback: once the graph is executing, the next item in the
+ * playlist is probed and, when the graph can decode it as it is, its uri is
+ * queued on the source component. The source then carries on with it at the
+ * end of the current one, without an end-of-stream, and the graph stays in
+ * OMX_StateExecuting.
+ */
+void graph::ops::do_preroll_next ()
+{
+  next_probe_ptr_.reset ();
+  if (!gapless_ || !last_op_succeeded () || !playlist_ || !probe_ptr_
+      || handles_.empty ())
+  {
+    return;
+  }
+
+  const int next_index = playlist_->next_index ();
+  if (next_index < 0)
+  {
+    return;
+  }
+
+  const std::string &uri = playlist_->get_uri_list ()[next_index];
+  const bool quiet_probing = true;
+  tizprobe_ptr_t next_probe_ptr
+      = boost::make_shared< tiz::probe >(uri, quiet_probing);
+  if (next_probe_ptr
+      && next_probe_ptr->get_omx_domain () == probe_ptr_->get_omx_domain ()
+      && is_gapless_compatible (next_probe_ptr))
+  {
+    if (OMX_ErrorNone
+        == tiz::graph::util::set_next_content_uri (handles_[0], uri))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Next uri queued [%s]", uri.c_str ());
+      next_probe_ptr_ = next_probe_ptr;
+    }
+  }
+}
+
+void graph::ops::do_gapless_advance ()
+{
+  if (!next_probe_ptr_ || !playlist_)
+  {
+    return;
+  }
+
+  // The source component has moved on to the uri queued in do_preroll_next
+  playlist_->skip (SKIP_DEFAULT_VALUE);
+  probe_ptr_ = next_probe_ptr_;
+  next_probe_ptr_.reset ();
+  announce_stream ();
+
+  // And now queue the one after
+  do_preroll_next ();
+}
+
 void graph::ops::do_reset_internal_error ()
 {
   error_code_ = OMX_ErrorNone;
@@ -772,6 +874,14 @@ bool graph::ops::is_probing_result_ok () const
   return rc;
 }
 
+bool graph::ops::is_next_uri_started (const OMX_HANDLETYPE handle,
+                                      const OMX_INDEXTYPE index) const
+{
+  return (next_probe_ptr_ && is_first_component (handle)
+          && static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexConfigNextContentURI)
+                 == index);
+}
+
 std::string graph::ops::handle2name (const OMX_HANDLETYPE handle) const
 {
   const omx_hdl2name_map_t::const_iterator it = h2n_.find (handle);
@@ -927,16 +1037,15 @@ graph::ops::probe_stream (const OMX_PORTDOMAINTYPE omx_domain,
     }
     else
     {
+      // Remembered, so that a track that starts without a graph
+      // reconfiguration (see do_gapless_advance) is announced in the same way
+      probe_graph_id_ = graph_id;
+      probe_graph_action_ = graph_action;
+      probe_dump_f_ = stream_info_dump_f;
+
       if (!quiet)
       {
-        tiz::graph::util::dump_graph_info (graph_id.c_str (),
-                                           graph_action.c_str (), uri);
-        probe_ptr_->dump_stream_metadata ();
-        boost::bind (boost::mem_fn (stream_info_dump_f), probe_ptr_)();
-
-        metadata_ = boost::assign::map_list_of ("trackid", "1")
-                        .convert_to_container< track_metadata_map_t > ();
-        do_ack_metadata ();
+        announce_stream ();
       }
 
       // Everything went well..
@@ -954,6 +1063,33 @@ bool graph::ops::probe_stream_hook ()
   return true;
 }
 
+bool graph::ops::is_gapless_compatible (
+    const tizprobe_ptr_t & /* next_probe_ptr */) const
+{
+  // Default implementation. Graphs that can decode the next stream without
+  // being reconfigured (i.e. same coding type and the same output format)
+  // override this.
+  return false;
+}
+
+void graph::ops::announce_stream ()
+{
+  assert (probe_ptr_);
+  assert (playlist_);
+  tiz::graph::util::dump_graph_info (probe_graph_id_.c_str (),
+                                     probe_graph_action_.c_str (),
+                                     playlist_->get_current_uri ());
+  probe_ptr_->dump_stream_metadata ();
+  if (probe_dump_f_)
+  {
+    boost::bind (boost::mem_fn (probe_dump_f_), probe_ptr_)();
+  }
+
+  metadata_ = boost::assign::map_list_of ("trackid", "1")
+                  .convert_to_container< track_metadata_map_t > ();
+  do_ack_metadata ();
+}
+
 OMX_ERRORTYPE
 graph::ops::transition_source (const OMX_STATETYPE to_state)
 {
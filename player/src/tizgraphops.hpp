@@ -116,13 +116,14 @@ namespace tiz
       virtual void do_exe2idle_comp (const int comp_id);
       virtual void do_idle2loaded ();
       virtual void do_idle2loaded_comp (const int comp_id);
-      virtual void do_seek ();
+      virtual void do_seek (const int jump_secs);
       virtual void do_skip ();
       virtual void do_store_skip (const int jump);
       virtual void do_volume_step (const int step);
       virtual void do_volume (const double vol);
       virtual void do_restore_volume ();
       virtual void do_mute ();
+      virtual void do_print_stats ();
       virtual void do_error ();
       virtual void do_end_of_play ();
       virtual void do_tear_down_tunnels ();
@@ -132,6 +133,8 @@ namespace tiz
       virtual void do_record_destination (
           const OMX_STATETYPE destination_state);
       virtual void do_retrieve_metadata ();
+      virtual void do_preroll_next ();
+      virtual void do_gapless_advance ();
       virtual void do_reset_internal_error ();
       virtual void do_record_fatal_error (const OMX_HANDLETYPE handle,
                                           const OMX_ERRORTYPE error,
@@ -163,6 +166,8 @@ namespace tiz
       bool last_op_succeeded () const;
       bool is_end_of_play () const;
       bool is_probing_result_ok () const;
+      bool is_next_uri_started (const OMX_HANDLETYPE handle,
+                                const OMX_INDEXTYPE index) const;
 
       std::string handle2name (const OMX_HANDLETYPE handle) const;
 
@@ -194,6 +199,9 @@ namespace tiz
           stream_info_dump_func_t stream_info_dump_f, const bool quiet = false);
 
       virtual bool probe_stream_hook ();
+      virtual bool is_gapless_compatible (
+          const tizprobe_ptr_t &next_probe_ptr) const;
+      void announce_stream ();
       virtual OMX_ERRORTYPE transition_source (const OMX_STATETYPE to_state);
       virtual OMX_ERRORTYPE transition_comp (const int comp_id,
                                              const OMX_STATETYPE to_state);
@@ -213,6 +221,11 @@ namespace tiz
     protected:
       graph *p_graph_;
       tizprobe_ptr_t probe_ptr_;
+      tizprobe_ptr_t next_probe_ptr_;
+      bool gapless_;
+      std::string probe_graph_id_;
+      std::string probe_graph_action_;
+      stream_info_dump_func_t probe_dump_f_;
       omx_comp_name_lst_t comp_lst_;
       omx_comp_role_lst_t role_lst_;
       omx_comp_handle_lst_t handles_;
@@ -467,6 +467,22 @@ bool graph::util::verify_transition_one (const OMX_HANDLETYPE handle,
   return transition_verified;
 }
 
+OMX_ERRORTYPE
+graph::util::apply_time_seek (const OMX_HANDLETYPE handle, const OMX_U32 pid,
+                              const int jump_secs)
+{
+  OMX_TIME_CONFIG_TIMESTAMPTYPE position;
+  TIZ_INIT_OMX_PORT_STRUCT (position, pid);
+  tiz_check_omx (
+      OMX_GetConfig (handle, OMX_IndexConfigTimePosition, &position));
+  position.nTimestamp += static_cast< OMX_TICKS >(jump_secs) * 1000000;
+  if (position.nTimestamp < 0)
+  {
+    position.nTimestamp = 0;
+  }
+  return OMX_SetConfig (handle, OMX_IndexConfigTimePosition, &position);
+}
+
 OMX_ERRORTYPE
 graph::util::apply_volume_step (const OMX_HANDLETYPE handle, const OMX_U32 pid,
                                 const int step, int &vol)
@@ -601,39 +617,60 @@ graph::util::enable_tunnel (const omx_comp_handle_lst_t &hdl_list,
   return modify_tunnel (hdl_list, tunnel_id, OMX_CommandPortEnable);
 }
 
-OMX_ERRORTYPE
-graph::util::set_content_uri (const OMX_HANDLETYPE handle,
-                              const std::string &uri)
+namespace  // Unnamed namespace
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_ERRORTYPE set_uri (const OMX_HANDLETYPE handle, const std::string &uri,
+                         const OMX_INDEXTYPE index, const bool is_config)
+  {
+    OMX_ERRORTYPE rc = OMX_ErrorNone;
 
-  // Set the URI
-  OMX_PARAM_CONTENTURITYPE *p_uritype = NULL;
-  const long pathname_max = tiz_pathname_max (uri.c_str ());
-  const int uri_len = uri.length ();
+    // Set the URI
+    OMX_PARAM_CONTENTURITYPE *p_uritype = NULL;
+    const long pathname_max = tiz_pathname_max (uri.c_str ());
+    const int uri_len = uri.length ();
 
-  if (NULL == (p_uritype = (OMX_PARAM_CONTENTURITYPE *)tiz_mem_calloc (
-                   1, sizeof(OMX_PARAM_CONTENTURITYPE) + uri_len + 1))
-      || (pathname_max > 0 && uri_len > pathname_max))
-  {
-    rc = OMX_ErrorInsufficientResources;
-  }
-  else
-  {
-    p_uritype->nSize = sizeof(OMX_PARAM_CONTENTURITYPE) + uri_len + 1;
-    p_uritype->nVersion.nVersion = OMX_VERSION;
+    if (NULL == (p_uritype = (OMX_PARAM_CONTENTURITYPE *)tiz_mem_calloc (
+                     1, sizeof(OMX_PARAM_CONTENTURITYPE) + uri_len + 1))
+        || (pathname_max > 0 && uri_len > pathname_max))
+    {
+      rc = OMX_ErrorInsufficientResources;
+    }
+    else
+    {
+      p_uritype->nSize = sizeof(OMX_PARAM_CONTENTURITYPE) + uri_len + 1;
+      p_uritype->nVersion.nVersion = OMX_VERSION;
 
-    const size_t uri_offset = offsetof (OMX_PARAM_CONTENTURITYPE, contentURI);
-    strncpy ((char *)p_uritype + uri_offset, uri.c_str (), uri_len);
-    p_uritype->contentURI[uri_len] = '\0';
+      const size_t uri_offset
+          = offsetof (OMX_PARAM_CONTENTURITYPE, contentURI);
+      strncpy ((char *)p_uritype + uri_offset, uri.c_str (), uri_len);
+      p_uritype->contentURI[uri_len] = '\0';
 
-    rc = OMX_SetParameter (handle, OMX_IndexParamContentURI, p_uritype);
+      rc = is_config ? OMX_SetConfig (handle, index, p_uritype)
+                     : OMX_SetParameter (handle, index, p_uritype);
+    }
+
+    tiz_mem_free (p_uritype);
+    p_uritype = NULL;
+
+    return rc;
   }
+}
 
-  tiz_mem_free (p_uritype);
-  p_uritype = NULL;
+OMX_ERRORTYPE
+graph::util::set_content_uri (const OMX_HANDLETYPE handle,
+                              const std::string &uri)
+{
+  return set_uri (handle, uri, OMX_IndexParamContentURI, false);
+}
 
-  return rc;
+OMX_ERRORTYPE
+graph::util::set_next_content_uri (const OMX_HANDLETYPE handle,
+                                   const std::string &uri)
+{
+  // An empty uri cancels the one previously queued
+  return set_uri (handle, uri, static_cast< OMX_INDEXTYPE >(
+                                   OMX_TizoniaIndexConfigNextContentURI),
+                  true);
 }
 
 OMX_ERRORTYPE
@@ -795,6 +832,39 @@ void graph::util::dump_graph_info (const char *ap_coding_type_str,
            ap_graph_type_str, uri.c_str ());
 }
 
+OMX_ERRORTYPE
+graph::util::dump_perf_counters (const OMX_HANDLETYPE handle,
+                                 const std::string &comp_name)
+{
+  const char *servant_names[OMX_TIZONIA_ServantMax] = {"fsm", "kernel",
+                                                       "processor"};
+  OMX_TIZONIA_CONFIG_PERFCOUNTERSTYPE perf;
+  TIZ_INIT_OMX_STRUCT (perf);
+  perf.nPortIndex = OMX_ALL;
+  tiz_check_omx (OMX_GetConfig (
+      handle, static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexConfigPerfCounters),
+      &perf));
+
+  TIZ_PRINTF_GRN ("[%s]\n", comp_name.c_str ());
+  TIZ_PRINTF_CYN (
+      "   buffers in/out [%llu/%llu] bytes in/out [%llu/%llu] "
+      "buffers_ready [%llu calls, %llu us]\n",
+      (unsigned long long) perf.nBuffersIn,
+      (unsigned long long) perf.nBuffersOut, (unsigned long long) perf.nBytesIn,
+      (unsigned long long) perf.nBytesOut,
+      (unsigned long long) perf.nBuffersReadyCalls,
+      (unsigned long long) perf.nBuffersReadyTimeUs);
+  for (int i = 0; i < OMX_TIZONIA_ServantMax; ++i)
+  {
+    TIZ_PRINTF_CYN (
+        "   %-9s : msgs [%llu] time [%llu us] queue high-water [%u]\n",
+        servant_names[i], (unsigned long long) perf.sServants[i].nMessages,
+        (unsigned long long) perf.sServants[i].nTimeUs,
+        (unsigned int) perf.sServants[i].nQueueHighWater);
+  }
+  return OMX_ErrorNone;
+}
+
 bool graph::util::is_fatal_error (const OMX_ERRORTYPE error)
 {
   bool rc = false;
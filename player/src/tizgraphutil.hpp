@@ -105,6 +105,10 @@ namespace tiz
       static bool verify_transition_one (const OMX_HANDLETYPE handle,
                                          const OMX_STATETYPE to);
 
+      static OMX_ERRORTYPE apply_time_seek (const OMX_HANDLETYPE handle,
+                                            const OMX_U32 pid,
+                                            const int jump_secs);
+
       static OMX_ERRORTYPE apply_volume_step (const OMX_HANDLETYPE handle,
                                               const OMX_U32 pid, const int step,
                                               int &volume);
@@ -158,6 +162,9 @@ namespace tiz
       static OMX_ERRORTYPE set_content_uri (const OMX_HANDLETYPE handle,
                                             const std::string &uri);
 
+      static OMX_ERRORTYPE set_next_content_uri (const OMX_HANDLETYPE handle,
+                                                 const std::string &uri);
+
       static OMX_ERRORTYPE set_pcm_mode (
           const OMX_HANDLETYPE handle, const OMX_U32 port_id,
           boost::function< void(OMX_AUDIO_PARAM_PCMMODETYPE &pcmmode) > getter);
@@ -185,6 +192,9 @@ namespace tiz
                                    const char *ap_graph_type_str,
                                    const std::string &uri);
 
+      static OMX_ERRORTYPE dump_perf_counters (const OMX_HANDLETYPE handle,
+                                               const std::string &comp_name);
+
       static bool is_fatal_error (const OMX_ERRORTYPE error);
 
       static std::string get_default_pcm_renderer ();
@@ -53,6 +53,7 @@
 #include "tizgraphtypes.hpp"
 #include "tizgraphmgr.hpp"
 #include "tizomxutil.hpp"
+#include "tizprobecache.hpp"
 #include "decoders/tizdecgraphmgr.hpp"
 #include "httpserv/tizhttpservconfig.hpp"
 #include "httpserv/tizhttpservmgr.hpp"
@@ -159,13 +160,11 @@ namespace
             return ETIZPlayUserQuit;
 
           case 68:  // key left
-            // seek
-            // printf ("Seek (left key) - not implemented\n");
+            mgr_ptr->rwd ();
             break;
 
           case 67:  // key right
-            // seek
-            // printf ("Seek (right key) - not implemented\n");
+            mgr_ptr->fwd ();
             break;
 
           case 65:  // key up
@@ -186,6 +185,10 @@ namespace
             mgr_ptr->mute ();
             break;
 
+          case 's':
+            mgr_ptr->print_stats ();
+            break;
+
           case 'n':
             mgr_ptr->next ();
             break;
@@ -234,6 +237,10 @@ namespace
             mgr_ptr->mute ();
             break;
 
+          case 's':
+            mgr_ptr->print_stats ();
+            break;
+
           case '-':
             mgr_ptr->volume (-1);
             break;
@@ -523,6 +530,12 @@ tiz::playapp::decode_local ()
     }
   }
 
+  tiz::probecache::init ();
+  if (popts_.rebuild_probe_cache ())
+  {
+    tiz::probecache::rebuild (file_list);
+  }
+
   (void)daemonize_if_requested ();
 
   tizplaylist_ptr_t playlist
@@ -546,6 +559,8 @@ tiz::playapp::decode_local ()
   p_mgr->quit ();
   p_mgr->deinit ();
 
+  tiz::probecache::deinit ();
+
   return rc;
 }
 
@@ -585,6 +600,12 @@ tiz::playapp::serve_stream ()
     }
   }
 
+  tiz::probecache::init ();
+  if (popts_.rebuild_probe_cache ())
+  {
+    tiz::probecache::rebuild (file_list);
+  }
+
   (void)daemonize_if_requested ();
 
   // Retrieve the hostname
@@ -640,6 +661,8 @@ tiz::playapp::serve_stream ()
   p_mgr->quit ();
   p_mgr->deinit ();
 
+  tiz::probecache::deinit ();
+
   return rc;
 }
 
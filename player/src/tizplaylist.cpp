@@ -38,6 +38,7 @@
 
 #include <tizplatform.h>
 
+#include "tizdirscan.hpp"
 #include "tizplaylist.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
@@ -47,95 +48,47 @@
 
 namespace  // unnamed namespace
 {
-  struct pathname_of
-  {
-    pathname_of (uri_lst_t &uri_list) : uri_list_ (uri_list)
-    {
-    }
-
-    void operator()(const boost::filesystem::directory_entry &p) const
-    {
-      uri_list_.push_back (p.path ().string ());
-    }
-    uri_lst_t &uri_list_;
-  };
-
   void add_to_extension_list (file_extension_lst_t &list, const std::string &extension)
   {
     list.insert (list.end (), extension);
   }
 
   OMX_ERRORTYPE
-  process_base_uri (const std::string &uri, uri_lst_t &uri_list,
-                    bool recurse = false)
+  process_base_uri (const std::string &uri,
+                    const file_extension_lst_t &extension_list,
+                    uri_lst_t &uri_list, bool recurse = false)
   {
     if (boost::filesystem::exists (uri)
         && boost::filesystem::is_regular_file (uri))
     {
-      uri_list.push_back (uri);
+      if (tiz::dirscan::is_known_media (extension_list, uri))
+      {
+        uri_list.push_back (uri);
+      }
       return OMX_ErrorNone;
     }
 
     if (boost::filesystem::exists (uri)
         && boost::filesystem::is_directory (uri))
     {
-      if (!recurse)
-      {
-        std::for_each (boost::filesystem::directory_iterator (
-                           boost::filesystem::path (uri)),
-                       boost::filesystem::directory_iterator (),
-                       pathname_of (uri_list));
-        return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
-      }
-      else
-      {
-        std::for_each (boost::filesystem::recursive_directory_iterator (
-                           boost::filesystem::path (uri)),
-                       boost::filesystem::recursive_directory_iterator (),
-                       pathname_of (uri_list));
-        return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
-      }
+      size_t nentries = 0;
+      const size_t nfound = uri_list.size ();
+      const unsigned int nthreads = tiz::dirscan::scan (
+          uri, extension_list, recurse, uri_list, nentries);
+
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "[%s] : [%lu] entries, [%lu] media files, [%u] threads",
+               uri.c_str (), (unsigned long)nentries,
+               (unsigned long)(uri_list.size () - nfound), nthreads);
+
+      return (uri_list.empty () && 0 == nentries)
+                 ? OMX_ErrorContentURIError
+                 : OMX_ErrorNone;
     }
 
     return OMX_ErrorContentURIError;
   }
 
-  OMX_ERRORTYPE
-  filter_unknown_media (const file_extension_lst_t &extension_list,
-                        uri_lst_t &uri_list,
-                        file_extension_lst_t &extension_list_filtered)
-  {
-    uri_lst_t::iterator it (uri_list.begin ());
-    std::vector< uri_lst_t::iterator > iter_list;
-    file_extension_lst_t ext_lst_cpy (extension_list);
-    uri_lst_t filtered_uri_list;
-
-    while (it != uri_list.end ())
-    {
-      std::string extension (
-          boost::filesystem::path (*it).extension ().string ());
-      boost::algorithm::to_lower (extension);
-      file_extension_lst_t::const_iterator low = std::lower_bound (
-          ext_lst_cpy.begin (), ext_lst_cpy.end (), extension);
-
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "ext [%s] it [%s]", extension.c_str (),
-               (*it).c_str ());
-
-      if (!(low == ext_lst_cpy.end ()) && boost::iequals ((*low), extension))
-      {
-        TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] added to playlist low [%s]",
-                 (*it).c_str (), (*low).c_str ());
-        filtered_uri_list.push_back (*it);
-        extension_list_filtered.insert (extension);
-      }
-      ++it;
-    }
-
-    uri_list = filtered_uri_list;
-    TIZ_LOG (TIZ_PRIORITY_TRACE, "%d elements in playlist", uri_list.size ());
-    return uri_list.empty () ? OMX_ErrorContentURIError : OMX_ErrorNone;
-  }
-
 }  // unnamed namespace
 
 //
@@ -150,7 +103,8 @@ tiz::playlist::playlist (const uri_lst_t &uri_list /* = uri_lst_t () */,
     current_sub_list_ (-1),
     shuffle_ (shuffle),
     extension_list_ (),
-    single_format_ (Unknown)
+    single_format_ (Unknown),
+    scanned_ (false)
 {
   const int list_size = uri_list_.size ();
   if (list_size)
@@ -159,7 +113,6 @@ tiz::playlist::playlist (const uri_lst_t &uri_list /* = uri_lst_t () */,
     TIZ_LOG (TIZ_PRIORITY_TRACE, "last list [%s]",
              uri_list_[uri_list_.size () - 1].c_str ());
   }
-  scan_list ();
 }
 
 tiz::playlist::playlist (const playlist &copy_from)
@@ -170,7 +123,8 @@ tiz::playlist::playlist (const playlist &copy_from)
     current_sub_list_ (copy_from.current_sub_list_),
     shuffle_ (copy_from.shuffle_),
     extension_list_ (copy_from.extension_list_),
-    single_format_ (copy_from.single_format_)
+    single_format_ (copy_from.single_format_),
+    scanned_ (copy_from.scanned_)
 {
   const int list_size = uri_list_.size ();
   TIZ_LOG (TIZ_PRIORITY_TRACE, "uri list size [%d]", list_size);
@@ -182,13 +136,17 @@ tiz::playlist::playlist (const playlist &copy_from)
   }
 }
 
+// The list is complete when this returns; playback does not start until the
+// whole tree has been walked. Handing the first directory's files to the
+// graph while the walk goes on would not work: the graph manager gives each
+// graph a copy of a sub-list, looped when the list is single-format, so files
+// appended afterwards would never be reached.
 bool tiz::playlist::assemble_play_list (
     const std::string &base_uri, const bool shuffle_playlist,
     const bool recurse, const file_extension_lst_t &extension_list,
     uri_lst_t &uri_list, std::string &error_msg)
 {
   bool list_assembled = false;
-  file_extension_lst_t extension_list_filtered;
 
   try
   {
@@ -207,14 +165,15 @@ bool tiz::playlist::assemble_play_list (
       goto end;
     }
 
-    if (OMX_ErrorNone != process_base_uri (canonical_base_uri, uri_list, recurse))
+    // Files with unknown extensions are filtered out during the walk
+    if (OMX_ErrorNone != process_base_uri (canonical_base_uri, extension_list,
+                                           uri_list, recurse))
     {
       error_msg.assign ("File not found.");
       goto end;
     }
 
-    if (OMX_ErrorNone != filter_unknown_media (extension_list, uri_list,
-                                               extension_list_filtered))
+    if (uri_list.empty ())
     {
       error_msg.assign ("No supported media types found.");
       goto end;
@@ -354,6 +313,19 @@ int tiz::playlist::current_index () const
   return current_index_;
 }
 
+// Returns the index that a skip (1) would move to, or -1 if that would be
+// past the end of the list
+int tiz::playlist::next_index () const
+{
+  const int list_size = uri_list_.size ();
+  int next = current_index_ + 1;
+  if (next >= list_size)
+  {
+    next = (loop_playback () && list_size > 0) ? 0 : -1;
+  }
+  return next;
+}
+
 int tiz::playlist::size () const
 {
   return uri_list_.size ();
@@ -366,44 +338,9 @@ bool tiz::playlist::empty () const
 
 bool tiz::playlist::single_format () const
 {
-  if (!uri_list_.empty ())
-  {
-    if (Unknown == single_format_)
-    {
-      single_format_ = Yes;
-      try
-      {
-        const int list_size = uri_list_.size ();
-        std::string current_extension (
-            boost::filesystem::path (uri_list_[0]).extension ().string ());
-        boost::algorithm::to_lower (current_extension);
-
-        for (int i = 0; i < list_size; ++i)
-        {
-          std::string extension (
-              boost::filesystem::path (uri_list_[i]).extension ().string ());
-          boost::algorithm::to_lower (extension);
-          if (extension.compare (current_extension) != 0)
-          {
-            single_format_ = No;
-            break;
-          }
-        }
-        assert (Yes == single_format_ || No == single_format_);
-
-        TIZ_LOG (TIZ_PRIORITY_TRACE, "Is single format? [%s]",
-                 single_format_ == Yes ? "YES" : "NO");
-      }
-      catch (std::exception const &e)
-      {
-        TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s]", e.what ());
-      }
-      catch (...)
-      {
-        TIZ_LOG (TIZ_PRIORITY_ERROR, "[Unknown exception]");
-      }
-    }
-  }
+  scan_list ();
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Is single format? [%s]",
+           single_format_ == Yes ? "YES" : "NO");
   return (single_format_ == Yes);
 }
 
@@ -477,66 +414,45 @@ void tiz::playlist::erase_uri (const int index)
   }
 }
 
-void tiz::playlist::scan_list ()
+// Splits the list into runs of files with the same extension, in a single
+// pass. This only happens the first time the sub-lists or the format of the
+// list are needed, not on every copy of the list.
+void tiz::playlist::scan_list () const
 {
-  if (!uri_list_.empty ())
+  if (scanned_)
   {
-    int index = 0;
-    while (index < size ())
-    {
-      TIZ_LOG (TIZ_PRIORITY_TRACE, "new sub list at index [%d]", index);
-      sub_list_indexes_.push_back (index);
-      index = find_next_sub_list (index);
-    }
-    // For convenience, push one more index, a "last" index...
-    sub_list_indexes_.push_back (uri_list_.size ());
-
-    // Find out whether this is a single-format playlist.
-    (void)single_format ();
+    return;
   }
-}
 
-int tiz::playlist::find_next_sub_list (const int index) const
-{
-  const int list_size = uri_list_.size ();
-  int cur_idx = index;
-  assert (cur_idx < list_size);
-
-  try
+  scanned_ = true;
+  sub_list_indexes_.clear ();
+  if (!uri_list_.empty ())
   {
-    std::string current_extension (
-        boost::filesystem::path (uri_list_[cur_idx]).extension ().string ());
-    boost::algorithm::to_lower (current_extension);
-
-    add_to_extension_list (extension_list_, current_extension);
-
-    for (; cur_idx < list_size; ++cur_idx)
+    const int list_size = uri_list_.size ();
+    std::string current_extension;
+    for (int index = 0; index < list_size; ++index)
     {
       std::string extension (
-          boost::filesystem::path (uri_list_[cur_idx]).extension ().string ());
-      boost::algorithm::to_lower (extension);
-      if (!extension.compare (current_extension) == 0)
+          tiz::dirscan::lower_extension (uri_list_[index]));
+      if (0 == index || extension.compare (current_extension) != 0)
       {
-        break;
+        TIZ_LOG (TIZ_PRIORITY_TRACE, "new sub list at index [%d]", index);
+        sub_list_indexes_.push_back (index);
+        add_to_extension_list (extension_list_, extension);
+        current_extension.swap (extension);
       }
     }
-  }
-  catch (std::exception const &e)
-  {
-    cur_idx = list_size;
-    TIZ_LOG (TIZ_PRIORITY_ERROR, "[%s]", e.what ());
-  }
-  catch (...)
-  {
-    cur_idx = list_size;
-    TIZ_LOG (TIZ_PRIORITY_ERROR, "[Unknown exception]");
-  }
+    // For convenience, push one more index, a "last" index...
+    sub_list_indexes_.push_back (list_size);
 
-  return cur_idx;
+    // A single run means a single-format playlist
+    single_format_ = (2 == sub_list_indexes_.size ()) ? Yes : No;
+  }
 }
 
 void tiz::playlist::print_info ()
 {
+  scan_list ();
   TIZ_PRINTF_BLU ("Playlist length: %lu. File extensions in playlist: %s\n",
                   (long)uri_list_.size (),
                   boost::algorithm::join (extension_list_, ", ").c_str ());
@@ -60,6 +60,7 @@ namespace tiz
     uri_lst_t get_sublist (const int from, const int to) const;
     const uri_lst_t &get_uri_list () const;
     int current_index () const;
+    int next_index () const;
     int size () const;
     bool empty () const;
     bool single_format () const;
@@ -84,19 +85,19 @@ namespace tiz
 
   private:
 
-    void scan_list ();
-    int find_next_sub_list (const int index) const;
+    void scan_list () const;
 
     // TODO: Possibly use a shared pointer here to make copy a less expensive
     // operation
     uri_lst_t uri_list_;
     int current_index_;
     bool loop_playback_;
-    std::vector<size_t> sub_list_indexes_;
+    mutable std::vector<size_t> sub_list_indexes_;
     int current_sub_list_;
     bool shuffle_;
     mutable file_extension_lst_t extension_list_;
     mutable single_format_t single_format_;
+    mutable bool scanned_;
   };
 }  // namespace tiz
 
@@ -102,7 +102,6 @@ namespace  // unnamed
   }
 
   void obtain_stream_title_and_genre (MediaInfoLib::MediaInfo &mi,
-                                      const bool quiet,
                                       std::string &stream_title,
                                       std::string &stream_genre)
   {
@@ -111,8 +110,6 @@ namespace  // unnamed
     std::string title (mi_stream_general_info_to_std_string (mi, L"Track"));
     std::string album (mi_stream_general_info_to_std_string (mi, L"Album"));
     std::string genre (mi_stream_general_info_to_std_string (mi, L"Genre"));
-    std::string full_track_name (
-        mi_stream_general_info_to_std_string (mi, L"CompleteName"));
 
     stream_title.assign (artist);
     if (!album.empty ())
@@ -127,15 +124,6 @@ namespace  // unnamed
       stream_title.append (title);
     }
     stream_genre.assign (genre);
-
-    if (!quiet)
-    {
-      if (stream_title.empty ())
-      {
-        stream_title.assign (full_track_name);
-      }
-      boost::replace_all (stream_title, "_", " ");
-    }
   }
 
   OMX_AUDIO_CODINGTYPE obtain_codec_id (MediaInfoLib::MediaInfo &mi)
@@ -252,7 +240,10 @@ tiz::probe::probe (const std::string &uri, const bool quiet)
     vorbistype_ (),
     aactype_ (),
     vp8type_ (),
-    meta_file_ (uri.c_str ()),
+    meta_file_ (),
+    meta_file_opened_ (false),
+    cached_ (false),
+    cached_info_ (),
     stream_title_ (),
     stream_genre_ (),
     stream_is_cbr_ (false)
@@ -357,6 +348,10 @@ tiz::probe::probe (const std::string &uri, const bool quiet)
   vp8type_.eLevel = OMX_VIDEO_VP8Level_Version0;
   vp8type_.nDCTPartitions = 0; /* 1 DCP partitiion */
   vp8type_.bErrorResilientMode = OMX_FALSE;
+
+  // A warm cache means that neither MediaInfo nor TagLib need to open the
+  // file
+  cached_ = tiz::probecache::lookup (uri_, cached_info_);
 }
 
 std::string tiz::probe::get_uri () const
@@ -406,77 +401,132 @@ tiz::probe::get_container_type ()
 }
 
 void tiz::probe::probe_stream ()
+{
+  if (!cached_)
+  {
+    probe_info info;
+    if (!probe_media_info (info))
+    {
+      return;
+    }
+    probe_tags (info);
+    tiz::probecache::store (uri_, info);
+    cached_info_ = info;
+    cached_ = true;
+  }
+  apply_probe_info (cached_info_);
+}
+
+bool tiz::probe::probe_media_info (probe_info &info) const
 {
   MediaInfoLib::MediaInfo mi;
 
-  if (open_media (uri_, mi))
+  if (!open_media (uri_, mi))
   {
-    OMX_U32 samplerate = 48000;
-    OMX_U32 bitrate = 0;
-    OMX_U32 nchannels = 2;
-    OMX_U32 bitdepth = 16;
-    OMX_ENDIANTYPE endianness = OMX_EndianLittle;
-    OMX_NUMERICALDATATYPE sign = OMX_NumericalDataSigned;
+    return false;
+  }
 
-    // Get an idea of the container format
-    container_type_ = obtain_container_format (mi);
+  // Get an idea of the container format
+  info.container = obtain_container_format (mi);
 
-    // Get the codec type
-    const OMX_AUDIO_CODINGTYPE codec_id = obtain_codec_id (mi);
+  // Get the codec type
+  info.codec_id = obtain_codec_id (mi);
 
-    // Get the stream title and genre
-    obtain_stream_title_and_genre (mi, quiet_, stream_title_, stream_genre_);
+  // Get the stream title and genre
+  obtain_stream_title_and_genre (mi, info.stream_title, info.stream_genre);
 
-    TIZ_PRINTF_DBG_RED ("uri [%s] codec_id [%0x]\n", uri_.c_str (), codec_id);
+  TIZ_PRINTF_DBG_RED ("uri [%s] codec_id [%0x]\n", uri_.c_str (),
+                      info.codec_id);
 
-    // Grab the sample rate, bitrate, num channels, and sample format (when
-    // available), and cbr flag
-    obtain_stream_properties (mi, samplerate, bitrate, nchannels, bitdepth,
-                              endianness, sign, stream_is_cbr_);
+  // Grab the sample rate, bitrate, num channels, and sample format (when
+  // available), and cbr flag
+  obtain_stream_properties (mi, info.samplerate, info.bitrate, info.nchannels,
+                            info.bitdepth, info.endianness, info.sign,
+                            info.stream_is_cbr);
 
-    if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingMP2)
-    {
-      set_mp2_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingMP3)
-    {
-      set_mp3_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingAAC)
-    {
-      set_aac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingFLAC)
-    {
-      set_flac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                           sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingVORBIS)
-    {
-      set_vorbis_codec_info (samplerate, bitrate, nchannels, bitdepth,
-                             endianness, sign);
-    }
-    else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingOPUS)
-    {
-      set_opus_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                           sign);
-    }
-    else if (is_pcm_codec (codec_id))
+  mi.Close ();
+  return true;
+}
+
+void tiz::probe::probe_tags (probe_info &info) const
+{
+  const TagLib::FileRef &file = meta_file ();
+  info.title = retrieve_meta_data_str (&TagLib::Tag::title);
+  info.artist = retrieve_meta_data_str (&TagLib::Tag::artist);
+  info.album = retrieve_meta_data_str (&TagLib::Tag::album);
+  info.comment = retrieve_meta_data_str (&TagLib::Tag::comment);
+  info.genre = retrieve_meta_data_str (&TagLib::Tag::genre);
+  info.year = retrieve_meta_data_uint (&TagLib::Tag::year);
+  info.track = retrieve_meta_data_uint (&TagLib::Tag::track);
+  info.length = (!file.isNull () && file.audioProperties ())
+                    ? file.audioProperties ()->length ()
+                    : -1;
+}
+
+void tiz::probe::apply_probe_info (const probe_info &info)
+{
+  const OMX_AUDIO_CODINGTYPE codec_id = info.codec_id;
+  const OMX_U32 samplerate = info.samplerate;
+  const OMX_U32 bitrate = info.bitrate;
+  const OMX_U32 nchannels = info.nchannels;
+  const OMX_U32 bitdepth = info.bitdepth;
+  const OMX_ENDIANTYPE endianness = info.endianness;
+  const OMX_NUMERICALDATATYPE sign = info.sign;
+
+  container_type_ = info.container;
+  stream_is_cbr_ = info.stream_is_cbr;
+  stream_title_ = info.stream_title;
+  stream_genre_ = info.stream_genre;
+
+  if (!quiet_)
+  {
+    if (stream_title_.empty ())
     {
-      domain_ = OMX_PortDomainAudio;
-      audio_coding_type_
-          = static_cast< OMX_AUDIO_CODINGTYPE >(OMX_AUDIO_CodingPCM);
-      pcmtype_.nSamplingRate = samplerate;
-      pcmtype_.nChannels = nchannels;
-      pcmtype_.nBitPerSample = bitdepth;
-      pcmtype_.eEndian = endianness;
-      pcmtype_.eNumData = sign;
+      stream_title_.assign (uri_);
     }
+    boost::replace_all (stream_title_, "_", " ");
+  }
 
-    mi.Close ();
+  if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingMP2)
+  {
+    set_mp2_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingMP3)
+  {
+    set_mp3_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingAAC)
+  {
+    set_aac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingFLAC)
+  {
+    set_flac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                         sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingVORBIS)
+  {
+    set_vorbis_codec_info (samplerate, bitrate, nchannels, bitdepth,
+                           endianness, sign);
+  }
+  else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingOPUS)
+  {
+    set_opus_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                         sign);
+  }
+  else if (is_pcm_codec (codec_id))
+  {
+    domain_ = OMX_PortDomainAudio;
+    audio_coding_type_
+        = static_cast< OMX_AUDIO_CODINGTYPE >(OMX_AUDIO_CodingPCM);
+    pcmtype_.nSamplingRate = samplerate;
+    pcmtype_.nChannels = nchannels;
+    pcmtype_.nBitPerSample = bitdepth;
+    pcmtype_.eEndian = endianness;
+    pcmtype_.eNumData = sign;
   }
 }
 
@@ -592,7 +642,8 @@ void tiz::probe::set_flac_codec_info (const OMX_U32 samplerate,
     pcmtype_.bInterleaved = OMX_FALSE;
   }
 
-  pcmtype_.nBitPerSample = bitdepth;
+  // The flac decoder outputs 16-bit, packed 24-bit or float containers
+  pcmtype_.nBitPerSample = bitdepth <= 16 ? 16 : bitdepth <= 24 ? 24 : 32;
   pcmtype_.eEndian = endianness;
   pcmtype_.eNumData = sign;
 }
@@ -747,13 +798,24 @@ bool tiz::probe::is_cbr_stream ()
   return stream_is_cbr_;
 }
 
+const TagLib::FileRef &tiz::probe::meta_file () const
+{
+  if (!meta_file_opened_)
+  {
+    meta_file_ = TagLib::FileRef (uri_.c_str ());
+    meta_file_opened_ = true;
+  }
+  return meta_file_;
+}
+
 std::string tiz::probe::retrieve_meta_data_str (
     TagLib::String (TagLib::Tag::*TagFunction)() const) const
 {
   assert (TagFunction);
-  if (!meta_file_.isNull () && meta_file_.tag ())
+  const TagLib::FileRef &file = meta_file ();
+  if (!file.isNull () && file.tag ())
   {
-    TagLib::Tag *tag = meta_file_.tag ();
+    TagLib::Tag *tag = file.tag ();
     return (tag->*TagFunction)().stripWhiteSpace ().to8Bit ();
   }
   return std::string ();
@@ -763,9 +825,10 @@ unsigned int tiz::probe::retrieve_meta_data_uint (
     TagLib::uint (TagLib::Tag::*TagFunction)() const) const
 {
   assert (TagFunction);
-  if (!meta_file_.isNull () && meta_file_.tag ())
+  const TagLib::FileRef &file = meta_file ();
+  if (!file.isNull () && file.tag ())
   {
-    TagLib::Tag *tag = meta_file_.tag ();
+    TagLib::Tag *tag = file.tag ();
     return (tag->*TagFunction)();
   }
   return 0;
@@ -773,50 +836,65 @@ unsigned int tiz::probe::retrieve_meta_data_uint (
 
 std::string tiz::probe::title () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::title);
+  return cached_ ? cached_info_.title
+                 : retrieve_meta_data_str (&TagLib::Tag::title);
 }
 
 std::string tiz::probe::artist () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::artist);
+  return cached_ ? cached_info_.artist
+                 : retrieve_meta_data_str (&TagLib::Tag::artist);
 }
 
 std::string tiz::probe::album () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::album);
+  return cached_ ? cached_info_.album
+                 : retrieve_meta_data_str (&TagLib::Tag::album);
 }
 
 std::string tiz::probe::year () const
 {
   return boost::lexical_cast< std::string >(
-      retrieve_meta_data_uint (&TagLib::Tag::year));
+      cached_ ? cached_info_.year
+              : retrieve_meta_data_uint (&TagLib::Tag::year));
 }
 
 std::string tiz::probe::comment () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::comment);
+  return cached_ ? cached_info_.comment
+                 : retrieve_meta_data_str (&TagLib::Tag::comment);
 }
 
 std::string tiz::probe::track () const
 {
   return boost::lexical_cast< std::string >(
-      retrieve_meta_data_uint (&TagLib::Tag::track));
+      cached_ ? cached_info_.track
+              : retrieve_meta_data_uint (&TagLib::Tag::track));
 }
 
 std::string tiz::probe::genre () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::genre);
+  return cached_ ? cached_info_.genre
+                 : retrieve_meta_data_str (&TagLib::Tag::genre);
 }
 
 std::string tiz::probe::stream_length () const
 {
   std::string length_str;
+  int length = cached_info_.length;
+
+  if (!cached_)
+  {
+    const TagLib::FileRef &file = meta_file ();
+    length = (!file.isNull () && file.audioProperties ())
+                 ? file.audioProperties ()->length ()
+                 : -1;
+  }
 
-  if (!meta_file_.isNull () && meta_file_.audioProperties ())
+  if (length >= 0)
   {
-    TagLib::AudioProperties *properties = meta_file_.audioProperties ();
-    int seconds = properties->length () % 60;
-    int minutes = (properties->length () - seconds) / 60;
+    int seconds = length % 60;
+    int minutes = (length - seconds) / 60;
     int hours = 0;
     if (minutes >= 60)
     {
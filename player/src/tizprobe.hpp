@@ -41,6 +41,8 @@
 #include <OMX_Video.h>
 #include <OMX_TizoniaExt.h>
 
+#include "tizprobecache.hpp"
+
 namespace tiz
 {
   class probe
@@ -92,6 +94,10 @@ namespace tiz
 
   private:
     void probe_stream ();
+    bool probe_media_info (probe_info &info) const;
+    void probe_tags (probe_info &info) const;
+    void apply_probe_info (const probe_info &info);
+    const TagLib::FileRef &meta_file () const;
     void set_mp2_codec_info (const OMX_U32 samplerate, const OMX_U32 bitrate,
                              const OMX_U32 nchannels, const OMX_U32 bitdepth,
                              const OMX_ENDIANTYPE endianness,
@@ -137,7 +143,10 @@ namespace tiz
     OMX_AUDIO_PARAM_VORBISTYPE vorbistype_;
     OMX_AUDIO_PARAM_AACPROFILETYPE aactype_;
     OMX_VIDEO_PARAM_VP8TYPE vp8type_;
-    TagLib::FileRef meta_file_;
+    mutable TagLib::FileRef meta_file_;  // opened on demand
+    mutable bool meta_file_opened_;
+    bool cached_;  // tags are served from cached_info_
+    probe_info cached_info_;
     std::string stream_title_;
     std::string stream_genre_;
     bool stream_is_cbr_;
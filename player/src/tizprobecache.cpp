@@ -0,0 +1,682 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizprobecache.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Persistent cache of stream probing results
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+#include <tizplatform.h>
+
+#include "tizprobe.hpp"
+#include "tizprobecache.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.probecache"
+#endif
+
+namespace  // unnamed namespace
+{
+  // On-disk layout: a header, an array of fixed-size records sorted by path
+  // hash (then path), and a blob with all the strings. Everything is in host
+  // byte order; a cache file is not meant to be shared across machines.
+  const char CACHE_MAGIC[8] = {'T', 'I', 'Z', 'P', 'R', 'B', 'C', '\0'};
+  const uint32_t CACHE_VERSION = 1;
+
+  // Number of new results that triggers a rewrite of the cache file
+  const size_t CACHE_FLUSH_THRESHOLD = 256;
+
+  enum cache_string_t
+  {
+    StrPath,
+    StrStreamTitle,
+    StrStreamGenre,
+    StrTitle,
+    StrArtist,
+    StrAlbum,
+    StrComment,
+    StrGenre,
+    StrMax
+  };
+
+  struct cache_header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+  };
+
+  struct cache_record
+  {
+    uint64_t path_hash;
+    uint64_t size;
+    int64_t mtime_ns;
+    uint32_t codec_id;
+    uint32_t container;
+    uint32_t samplerate;
+    uint32_t bitrate;
+    uint32_t nchannels;
+    uint32_t bitdepth;
+    uint32_t endianness;
+    uint32_t sign;
+    uint32_t stream_is_cbr;
+    uint32_t year;
+    uint32_t track;
+    int32_t length;
+    uint32_t str_offset[StrMax];
+    uint32_t str_len[StrMax];
+  };
+
+  struct cache_entry
+  {
+    uint64_t size;
+    int64_t mtime_ns;
+    tiz::probe_info info;
+  };
+
+  typedef std::map< std::string, cache_entry > cache_journal_t;
+
+  struct cache_state
+  {
+    cache_state ()
+      : enabled (false),
+        file_path (),
+        p_map (NULL),
+        map_len (0),
+        journal (),
+        mutex ()
+    {
+    }
+
+    bool enabled;
+    std::string file_path;
+    void *p_map;
+    size_t map_len;
+    cache_journal_t journal;
+    boost::mutex mutex;
+  };
+
+  cache_state &get_state ()
+  {
+    static cache_state state;
+    return state;
+  }
+
+  uint64_t hash_path (const std::string &path)
+  {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::string::const_iterator it = path.begin (); it != path.end ();
+         ++it)
+    {
+      hash ^= static_cast< unsigned char >(*it);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  bool stat_file (const std::string &path, uint64_t &size, int64_t &mtime_ns)
+  {
+    struct stat st;
+    if (stat (path.c_str (), &st) != 0 || !S_ISREG (st.st_mode))
+    {
+      return false;
+    }
+    size = st.st_size;
+    mtime_ns = static_cast< int64_t >(st.st_mtim.tv_sec) * 1000000000LL
+               + st.st_mtim.tv_nsec;
+    return true;
+  }
+
+  bool is_cache_enabled ()
+  {
+    const char *p_enabled
+        = tiz_rcfile_get_value ("tizonia", "probe-cache-enabled");
+    return !(p_enabled && std::string (p_enabled).compare ("false") == 0);
+  }
+
+  std::string get_cache_file_path ()
+  {
+    const char *p_file = tiz_rcfile_get_value ("tizonia", "probe-cache-file");
+    if (p_file && strlen (p_file) > 0)
+    {
+      return std::string (p_file);
+    }
+
+    std::string cache_dir;
+    const char *p_xdg = getenv ("XDG_CACHE_HOME");
+    const char *p_home = getenv ("HOME");
+    if (p_xdg && strlen (p_xdg) > 0)
+    {
+      cache_dir.assign (p_xdg);
+    }
+    else if (p_home && strlen (p_home) > 0)
+    {
+      cache_dir.assign (p_home);
+      cache_dir.append ("/.cache");
+    }
+    else
+    {
+      return std::string ();
+    }
+    cache_dir.append ("/tizonia/probe.cache");
+    return cache_dir;
+  }
+
+  const cache_header *mapped_header (const cache_state &state)
+  {
+    return static_cast< const cache_header * >(state.p_map);
+  }
+
+  const cache_record *mapped_records (const cache_state &state)
+  {
+    return reinterpret_cast< const cache_record * >(
+        static_cast< const char * >(state.p_map) + sizeof (cache_header));
+  }
+
+  std::string mapped_string (const cache_state &state,
+                             const cache_record &record,
+                             const cache_string_t which)
+  {
+    const cache_header *p_hdr = mapped_header (state);
+    if (static_cast< uint64_t >(record.str_offset[which])
+            + record.str_len[which]
+        > p_hdr->strings_size)
+    {
+      return std::string ();
+    }
+    const char *p_strings
+        = static_cast< const char * >(state.p_map) + p_hdr->strings_offset;
+    return std::string (p_strings + record.str_offset[which],
+                        record.str_len[which]);
+  }
+
+  void unmap_cache_file (cache_state &state)
+  {
+    if (state.p_map)
+    {
+      (void)munmap (state.p_map, state.map_len);
+      state.p_map = NULL;
+      state.map_len = 0;
+    }
+  }
+
+  void map_cache_file (cache_state &state)
+  {
+    struct stat st;
+    const cache_header *p_hdr = NULL;
+    void *p_map = NULL;
+    int fd = open (state.file_path.c_str (), O_RDONLY | O_CLOEXEC);
+
+    unmap_cache_file (state);
+
+    if (fd < 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_DEBUG, "No probe cache at [%s]",
+               state.file_path.c_str ());
+      return;
+    }
+
+    if (fstat (fd, &st) != 0
+        || st.st_size < static_cast< off_t >(sizeof (cache_header)))
+    {
+      (void)close (fd);
+      return;
+    }
+
+    p_map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    (void)close (fd);
+    if (MAP_FAILED == p_map)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to map [%s]",
+               state.file_path.c_str ());
+      return;
+    }
+
+    p_hdr = static_cast< const cache_header * >(p_map);
+    if (memcmp (p_hdr->magic, CACHE_MAGIC, sizeof (CACHE_MAGIC)) != 0
+        || p_hdr->version != CACHE_VERSION
+        || sizeof (cache_header)
+                   + static_cast< uint64_t >(p_hdr->count)
+                         * sizeof (cache_record)
+               > p_hdr->strings_offset
+        || p_hdr->strings_offset > static_cast< uint64_t >(st.st_size)
+        || p_hdr->strings_size
+               > static_cast< uint64_t >(st.st_size) - p_hdr->strings_offset)
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Ignoring invalid probe cache [%s]",
+               state.file_path.c_str ());
+      (void)munmap (p_map, st.st_size);
+      return;
+    }
+
+    state.p_map = p_map;
+    state.map_len = st.st_size;
+    TIZ_LOG (TIZ_PRIORITY_NOTICE, "Mapped probe cache [%s] - [%u] entries",
+             state.file_path.c_str (), p_hdr->count);
+  }
+
+  const cache_record *find_record (const cache_state &state,
+                                   const std::string &path,
+                                   const uint64_t hash)
+  {
+    if (!state.p_map)
+    {
+      return NULL;
+    }
+
+    const cache_record *p_first = mapped_records (state);
+    const cache_record *p_last = p_first + mapped_header (state)->count;
+
+    // Binary search for the first record with this hash
+    while (p_first < p_last)
+    {
+      const cache_record *p_mid = p_first + (p_last - p_first) / 2;
+      if (p_mid->path_hash < hash)
+      {
+        p_first = p_mid + 1;
+      }
+      else
+      {
+        p_last = p_mid;
+      }
+    }
+
+    p_last = mapped_records (state) + mapped_header (state)->count;
+    for (; p_first < p_last && p_first->path_hash == hash; ++p_first)
+    {
+      if (mapped_string (state, *p_first, StrPath) == path)
+      {
+        return p_first;
+      }
+    }
+    return NULL;
+  }
+
+  void record_to_info (const cache_state &state, const cache_record &record,
+                       tiz::probe_info &info)
+  {
+    info.codec_id = static_cast< OMX_AUDIO_CODINGTYPE >(record.codec_id);
+    info.container
+        = static_cast< OMX_MEDIACONTAINER_FORMATTYPE >(record.container);
+    info.samplerate = record.samplerate;
+    info.bitrate = record.bitrate;
+    info.nchannels = record.nchannels;
+    info.bitdepth = record.bitdepth;
+    info.endianness = static_cast< OMX_ENDIANTYPE >(record.endianness);
+    info.sign = static_cast< OMX_NUMERICALDATATYPE >(record.sign);
+    info.stream_is_cbr = record.stream_is_cbr != 0;
+    info.stream_title = mapped_string (state, record, StrStreamTitle);
+    info.stream_genre = mapped_string (state, record, StrStreamGenre);
+    info.title = mapped_string (state, record, StrTitle);
+    info.artist = mapped_string (state, record, StrArtist);
+    info.album = mapped_string (state, record, StrAlbum);
+    info.comment = mapped_string (state, record, StrComment);
+    info.genre = mapped_string (state, record, StrGenre);
+    info.year = record.year;
+    info.track = record.track;
+    info.length = record.length;
+  }
+
+  void append_string (std::string &blob, cache_record &record,
+                      const cache_string_t which, const std::string &str)
+  {
+    record.str_offset[which] = blob.size ();
+    record.str_len[which] = str.size ();
+    blob.append (str);
+  }
+
+  void entry_to_record (const std::string &path, const cache_entry &entry,
+                        cache_record &record, std::string &blob)
+  {
+    const tiz::probe_info &info = entry.info;
+    memset (&record, 0, sizeof (record));
+    record.path_hash = hash_path (path);
+    record.size = entry.size;
+    record.mtime_ns = entry.mtime_ns;
+    record.codec_id = info.codec_id;
+    record.container = info.container;
+    record.samplerate = info.samplerate;
+    record.bitrate = info.bitrate;
+    record.nchannels = info.nchannels;
+    record.bitdepth = info.bitdepth;
+    record.endianness = info.endianness;
+    record.sign = info.sign;
+    record.stream_is_cbr = info.stream_is_cbr ? 1 : 0;
+    record.year = info.year;
+    record.track = info.track;
+    record.length = info.length;
+    append_string (blob, record, StrPath, path);
+    append_string (blob, record, StrStreamTitle, info.stream_title);
+    append_string (blob, record, StrStreamGenre, info.stream_genre);
+    append_string (blob, record, StrTitle, info.title);
+    append_string (blob, record, StrArtist, info.artist);
+    append_string (blob, record, StrAlbum, info.album);
+    append_string (blob, record, StrComment, info.comment);
+    append_string (blob, record, StrGenre, info.genre);
+  }
+
+  bool record_less (const cache_record &a, const cache_record &b)
+  {
+    return a.path_hash < b.path_hash;
+  }
+
+  // Merge the journal with the mapped file and atomically replace the
+  // latter. Must be called with the state mutex held.
+  void write_cache_file (cache_state &state)
+  {
+    std::vector< cache_record > records;
+    std::string blob;
+    cache_record record;
+
+    if (state.journal.empty () || state.file_path.empty ())
+    {
+      return;
+    }
+
+    // Entries already in the file, unless superseded by the journal
+    if (state.p_map)
+    {
+      const cache_record *p_rec = mapped_records (state);
+      const uint32_t count = mapped_header (state)->count;
+      for (uint32_t i = 0; i < count; ++i, ++p_rec)
+      {
+        const std::string path (mapped_string (state, *p_rec, StrPath));
+        if (state.journal.find (path) == state.journal.end ())
+        {
+          cache_entry entry;
+          entry.size = p_rec->size;
+          entry.mtime_ns = p_rec->mtime_ns;
+          record_to_info (state, *p_rec, entry.info);
+          entry_to_record (path, entry, record, blob);
+          records.push_back (record);
+        }
+      }
+    }
+
+    for (cache_journal_t::const_iterator it = state.journal.begin ();
+         it != state.journal.end (); ++it)
+    {
+      entry_to_record (it->first, it->second, record, blob);
+      records.push_back (record);
+    }
+
+    std::stable_sort (records.begin (), records.end (), record_less);
+
+    cache_header hdr;
+    memset (&hdr, 0, sizeof (hdr));
+    memcpy (hdr.magic, CACHE_MAGIC, sizeof (CACHE_MAGIC));
+    hdr.version = CACHE_VERSION;
+    hdr.count = records.size ();
+    hdr.strings_offset
+        = sizeof (cache_header) + records.size () * sizeof (cache_record);
+    hdr.strings_size = blob.size ();
+
+    boost::system::error_code ec;
+    boost::filesystem::create_directories (
+        boost::filesystem::path (state.file_path).parent_path (), ec);
+
+    const std::string tmp_path (state.file_path + ".tmp");
+    FILE *p_file = fopen (tmp_path.c_str (), "wb");
+    if (!p_file)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to create [%s]", tmp_path.c_str ());
+      return;
+    }
+
+    bool written
+        = (fwrite (&hdr, sizeof (hdr), 1, p_file) == 1
+           && (records.empty ()
+               || fwrite (&records[0], sizeof (cache_record), records.size (),
+                          p_file) == records.size ())
+           && (blob.empty ()
+               || fwrite (blob.data (), blob.size (), 1, p_file) == 1));
+    written = (fclose (p_file) == 0) && written;
+
+    if (!written || rename (tmp_path.c_str (), state.file_path.c_str ()) != 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to write [%s]",
+               state.file_path.c_str ());
+      (void)unlink (tmp_path.c_str ());
+      return;
+    }
+
+    TIZ_LOG (TIZ_PRIORITY_NOTICE, "Wrote probe cache [%s] - [%u] entries",
+             state.file_path.c_str (), hdr.count);
+    state.journal.clear ();
+    map_cache_file (state);
+  }
+
+  // Probes the files of a list, as many in parallel as there are workers.
+  struct rebuild_worker
+  {
+    rebuild_worker (const uri_lst_t &uri_list, size_t &next,
+                    boost::mutex &mutex)
+      : uri_list_ (uri_list), next_ (next), mutex_ (mutex)
+    {
+    }
+
+    void operator()()
+    {
+      for (;;)
+      {
+        size_t index = 0;
+        {
+          boost::lock_guard< boost::mutex > lock (mutex_);
+          index = next_++;
+        }
+        if (index >= uri_list_.size ())
+        {
+          break;
+        }
+        tiz::probe p (uri_list_[index], /* quiet = */ true);
+        (void)p.get_omx_domain ();
+      }
+    }
+
+    const uri_lst_t &uri_list_;
+    size_t &next_;
+    boost::mutex &mutex_;
+  };
+}  // unnamed namespace
+
+//
+// probe_info
+//
+tiz::probe_info::probe_info ()
+  : codec_id (OMX_AUDIO_CodingUnused),
+    container (OMX_FORMATMax),
+    samplerate (48000),
+    bitrate (0),
+    nchannels (2),
+    bitdepth (16),
+    endianness (OMX_EndianLittle),
+    sign (OMX_NumericalDataSigned),
+    stream_is_cbr (false),
+    stream_title (),
+    stream_genre (),
+    title (),
+    artist (),
+    album (),
+    comment (),
+    genre (),
+    year (0),
+    track (0),
+    length (-1)
+{
+}
+
+//
+// probecache
+//
+void tiz::probecache::init ()
+{
+  cache_state &state = get_state ();
+  boost::lock_guard< boost::mutex > lock (state.mutex);
+  state.enabled = is_cache_enabled ();
+  state.file_path = get_cache_file_path ();
+  if (state.file_path.empty ())
+  {
+    state.enabled = false;
+  }
+  if (state.enabled)
+  {
+    map_cache_file (state);
+  }
+}
+
+void tiz::probecache::deinit ()
+{
+  cache_state &state = get_state ();
+  boost::lock_guard< boost::mutex > lock (state.mutex);
+  if (state.enabled)
+  {
+    write_cache_file (state);
+  }
+  unmap_cache_file (state);
+  state.journal.clear ();
+  state.enabled = false;
+}
+
+bool tiz::probecache::lookup (const std::string &path, probe_info &info)
+{
+  cache_state &state = get_state ();
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+
+  if (!state.enabled || !stat_file (path, size, mtime_ns))
+  {
+    return false;
+  }
+
+  boost::lock_guard< boost::mutex > lock (state.mutex);
+  cache_journal_t::const_iterator it = state.journal.find (path);
+  if (it != state.journal.end ())
+  {
+    if (it->second.size == size && it->second.mtime_ns == mtime_ns)
+    {
+      info = it->second.info;
+      return true;
+    }
+    return false;
+  }
+
+  const cache_record *p_rec = find_record (state, path, hash_path (path));
+  if (p_rec && p_rec->size == size && p_rec->mtime_ns == mtime_ns)
+  {
+    record_to_info (state, *p_rec, info);
+    return true;
+  }
+  return false;
+}
+
+void tiz::probecache::store (const std::string &path, const probe_info &info)
+{
+  cache_state &state = get_state ();
+  cache_entry entry;
+
+  if (!state.enabled || !stat_file (path, entry.size, entry.mtime_ns))
+  {
+    return;
+  }
+
+  entry.info = info;
+  boost::lock_guard< boost::mutex > lock (state.mutex);
+  state.journal[path] = entry;
+  if (state.journal.size () >= CACHE_FLUSH_THRESHOLD)
+  {
+    write_cache_file (state);
+  }
+}
+
+void tiz::probecache::rebuild (const uri_lst_t &uri_list,
+                               const unsigned int nthreads)
+{
+  cache_state &state = get_state ();
+  unsigned int nworkers = nthreads;
+  size_t next = 0;
+  boost::mutex mutex;
+  boost::thread_group workers;
+
+  if (!state.enabled)
+  {
+    return;
+  }
+
+  {
+    boost::lock_guard< boost::mutex > lock (state.mutex);
+    unmap_cache_file (state);
+    state.journal.clear ();
+  }
+
+  if (0 == nworkers)
+  {
+    nworkers = std::max (boost::thread::hardware_concurrency (), 1U);
+  }
+  nworkers = std::min< size_t >(nworkers, uri_list.size ());
+
+  TIZ_LOG (TIZ_PRIORITY_NOTICE, "Probing [%lu] files with [%u] threads",
+           (unsigned long)uri_list.size (), nworkers);
+
+  for (unsigned int i = 0; i < nworkers; ++i)
+  {
+    workers.create_thread (rebuild_worker (uri_list, next, mutex));
+  }
+  workers.join_all ();
+
+  flush ();
+}
+
+void tiz::probecache::flush ()
+{
+  cache_state &state = get_state ();
+  boost::lock_guard< boost::mutex > lock (state.mutex);
+  if (state.enabled)
+  {
+    write_cache_file (state);
+  }
+}
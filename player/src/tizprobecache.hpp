@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizprobecache.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Persistent cache of stream probing results
+ *
+ *
+ */
+
+#ifndef TIZPROBECACHE_HPP
+#define TIZPROBECACHE_HPP
+
+#include <string>
+
+#include <OMX_Core.h>
+#include <OMX_Audio.h>
+#include <OMX_TizoniaExt.h>
+
+#include "tizgraphtypes.hpp"
+
+namespace tiz
+{
+  // What tiz::probe learns about a local media file from MediaInfo and
+  // TagLib.
+  struct probe_info
+  {
+    probe_info ();
+
+    OMX_AUDIO_CODINGTYPE codec_id;
+    OMX_MEDIACONTAINER_FORMATTYPE container;
+    OMX_U32 samplerate;
+    OMX_U32 bitrate;
+    OMX_U32 nchannels;
+    OMX_U32 bitdepth;
+    OMX_ENDIANTYPE endianness;
+    OMX_NUMERICALDATATYPE sign;
+    bool stream_is_cbr;
+    std::string stream_title;
+    std::string stream_genre;
+    // Tags
+    std::string title;
+    std::string artist;
+    std::string album;
+    std::string comment;
+    std::string genre;
+    unsigned int year;
+    unsigned int track;
+    int length;  // in seconds, or -1 if unknown
+  };
+
+  // The probe cache maps (path, size, mtime) to the probing results of a
+  // local file. It is stored in a single file under the user's cache
+  // directory (~/.cache/tizonia/probe.cache by default), which is mapped
+  // read-only at init time. New results are kept in memory and merged into a
+  // fresh copy of the file every now and then, and at deinit time.
+  class probecache
+  {
+
+  public:
+    static void init ();
+    static void deinit ();
+
+    static bool lookup (const std::string &path, probe_info &info);
+    static void store (const std::string &path, const probe_info &info);
+
+    // Discard all cached results and probe again the files in the list,
+    // using one thread per core (when nthreads is zero). The new cache is
+    // written out before returning.
+    static void rebuild (const uri_lst_t &uri_list,
+                         const unsigned int nthreads = 0);
+
+    static void flush ();
+  };
+}  // namespace tiz
+
+#endif  // TIZPROBECACHE_HPP
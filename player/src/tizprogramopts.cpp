@@ -277,6 +277,7 @@ tiz::programopts::programopts (int argc, char *argv[])
     recurse_ (false),
     shuffle_ (false),
     daemon_ (false),
+    rebuild_probe_cache_ (false),
     log_dir_ (),
     debug_info_ (false),
     comp_name_ (),
@@ -504,8 +505,10 @@ void tiz::programopts::print_usage_keyboard () const
   printf ("   [p] skip to previous file.\n");
   printf ("   [n] skip to next file.\n");
   printf ("   [SPACE] pause playback.\n");
+  printf ("   [LEFT/RIGHT] seek backwards/forward (local files).\n");
   printf ("   [+/-] increase/decrease volume.\n");
   printf ("   [m] mute.\n");
+  printf ("   [s] print performance counters.\n");
   printf ("   [q] quit.\n");
   printf ("\n");
 }
@@ -561,6 +564,11 @@ bool tiz::programopts::daemon () const
   return daemon_;
 }
 
+bool tiz::programopts::rebuild_probe_cache () const
+{
+  return rebuild_probe_cache_;
+}
+
 const std::string &tiz::programopts::log_dir () const
 {
   return log_dir_;
@@ -1084,12 +1092,18 @@ void tiz::programopts::init_global_options ()
       ("daemon,d", po::bool_switch (&daemon_)->default_value (false),
        "Run in the background.")
       /* TIZ_CLASS_COMMENT: */
+      ("rebuild-probe-cache",
+       po::bool_switch (&rebuild_probe_cache_)->default_value (false),
+       "Probe all the local files in the playlist again, using all cores, and "
+       "rewrite the probe cache.")
+      /* TIZ_CLASS_COMMENT: */
       ;
   register_consume_function (&tiz::programopts::consume_global_options);
   // TODO: help and version are not included. These should be moved out of
   // "global" and into its own category: "info"
   all_global_options_
-      = boost::assign::list_of ("recurse") ("shuffle") ("daemon")
+      = boost::assign::list_of ("recurse") ("shuffle") ("daemon") (
+            "rebuild-probe-cache")
             .convert_to_container< std::vector< std::string > > ();
 }
 
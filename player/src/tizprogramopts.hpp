@@ -61,6 +61,7 @@ namespace tiz
     bool shuffle () const;
     bool recurse () const;
     bool daemon () const;
+    bool rebuild_probe_cache () const;
     const std::string &log_dir () const;
     bool debug_info () const;
     const std::string &component_name () const;
@@ -174,6 +175,7 @@ namespace tiz
     bool recurse_;
     bool shuffle_;
     bool daemon_;
+    bool rebuild_probe_cache_;
     std::string log_dir_;
     bool debug_info_;
     std::string comp_name_;
@@ -0,0 +1,361 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_tizdirscan.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia player - directory walker unit tests
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+
+#include <check.h>
+
+#include <tizplatform.h>
+
+#include "tizdirscan.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.check"
+#endif
+
+#define DIRSCAN_TEST_TIMEOUT 60
+
+namespace  // unnamed namespace
+{
+  // Number of files needed for a directory not to fit in a single
+  // getdents64 batch
+  const int LARGE_DIR_NFILES = 4000;
+
+  std::string g_root;
+
+  void make_file (const std::string &path)
+  {
+    FILE *p_file = fopen (path.c_str (), "w");
+    fail_if (NULL == p_file);
+    fclose (p_file);
+  }
+
+  void make_dir (const std::string &path)
+  {
+    fail_if (0 != mkdir (path.c_str (), 0755));
+  }
+
+  void remove_tree (const std::string &path)
+  {
+    DIR *p_dir = opendir (path.c_str ());
+    if (p_dir)
+    {
+      struct dirent *p_ent = NULL;
+      while ((p_ent = readdir (p_dir)) != NULL)
+      {
+        const std::string name (p_ent->d_name);
+        if (name != "." && name != "..")
+        {
+          const std::string child (path + "/" + name);
+          struct stat st;
+          if (0 == lstat (child.c_str (), &st) && S_ISDIR (st.st_mode))
+          {
+            remove_tree (child);
+          }
+          else
+          {
+            unlink (child.c_str ());
+          }
+        }
+      }
+      closedir (p_dir);
+      rmdir (path.c_str ());
+    }
+  }
+
+  file_extension_lst_t extensions ()
+  {
+    file_extension_lst_t extension_list;
+    extension_list.insert (".mp3");
+    extension_list.insert (".flac");
+    return extension_list;
+  }
+
+  uri_lst_t scan (const std::string &dir, const bool recurse,
+                  size_t &nentries)
+  {
+    uri_lst_t files;
+    const unsigned int nthreads = tiz::dirscan::scan (dir, extensions (),
+                                                      recurse, files, nentries);
+    fail_if (0 == nthreads);
+    fail_if (!recurse && 1 != nthreads);
+    std::sort (files.begin (), files.end ());
+    return files;
+  }
+
+  //   root/
+  //     a.mp3
+  //     b.txt
+  //     C.FLAC
+  //     link.mp3 -> a.mp3
+  //     album.mp3/           (a directory, not a file)
+  //       d.mp3
+  //     sub/
+  //       e.flac
+  //       deeper/
+  //         f.mp3
+  //     sublink -> sub       (not followed)
+  void make_tree ()
+  {
+    make_file (g_root + "/a.mp3");
+    make_file (g_root + "/b.txt");
+    make_file (g_root + "/C.FLAC");
+    fail_if (0 != symlink ("a.mp3", (g_root + "/link.mp3").c_str ()));
+    make_dir (g_root + "/album.mp3");
+    make_file (g_root + "/album.mp3/d.mp3");
+    make_dir (g_root + "/sub");
+    make_file (g_root + "/sub/e.flac");
+    make_dir (g_root + "/sub/deeper");
+    make_file (g_root + "/sub/deeper/f.mp3");
+    fail_if (0 != symlink ("sub", (g_root + "/sublink").c_str ()));
+  }
+}  // unnamed namespace
+
+static void setup (void)
+{
+  char tmpl[] = "/tmp/check_tizdirscan.XXXXXX";
+  fail_if (NULL == mkdtemp (tmpl));
+  g_root.assign (tmpl);
+}
+
+static void teardown (void)
+{
+  remove_tree (g_root);
+  g_root.clear ();
+}
+
+START_TEST (test_dirscan_entry_type_known)
+{
+  const int fd = open (g_root.c_str (), O_RDONLY | O_DIRECTORY);
+  unsigned char type = DT_REG;
+
+  fail_if (fd < 0);
+  make_dir (g_root + "/dir");
+
+  // A type reported by the file system is not second-guessed (no stat), not
+  // even for entries that are not there
+  fail_if (!tiz::dirscan::entry_type (fd, "dir", type));
+  fail_if (DT_REG != type);
+  type = DT_DIR;
+  fail_if (!tiz::dirscan::entry_type (fd, "missing", type));
+  fail_if (DT_DIR != type);
+
+  close (fd);
+}
+END_TEST
+
+START_TEST (test_dirscan_entry_type_unknown_falls_back_to_stat)
+{
+  int fd = -1;
+  unsigned char type = DT_UNKNOWN;
+
+  make_file (g_root + "/file.mp3");
+  make_dir (g_root + "/dir");
+  fail_if (0 != symlink ("dir", (g_root + "/link").c_str ()));
+  fail_if (0 != mkfifo ((g_root + "/fifo").c_str (), 0644));
+  fd = open (g_root.c_str (), O_RDONLY | O_DIRECTORY);
+  fail_if (fd < 0);
+
+  fail_if (!tiz::dirscan::entry_type (fd, "file.mp3", type));
+  fail_if (DT_REG != type);
+
+  type = DT_UNKNOWN;
+  fail_if (!tiz::dirscan::entry_type (fd, "dir", type));
+  fail_if (DT_DIR != type);
+
+  // Symlinks are not followed, even to directories
+  type = DT_UNKNOWN;
+  fail_if (!tiz::dirscan::entry_type (fd, "link", type));
+  fail_if (DT_LNK != type);
+
+  // Anything else stays unknown (i.e. counted, but never media)
+  type = DT_UNKNOWN;
+  fail_if (!tiz::dirscan::entry_type (fd, "fifo", type));
+  fail_if (DT_UNKNOWN != type);
+
+  // Entries that went away since the directory was read are skipped
+  type = DT_UNKNOWN;
+  fail_if (tiz::dirscan::entry_type (fd, "missing", type));
+
+  close (fd);
+}
+END_TEST
+
+START_TEST (test_dirscan_non_recursive)
+{
+  size_t nentries = 0;
+  uri_lst_t files;
+
+  make_tree ();
+  files = scan (g_root, false, nentries);
+
+  // a.mp3, b.txt, C.FLAC, link.mp3, sublink, and the two directories, which
+  // are counted but not descended into
+  fail_if (7 != nentries);
+  fail_if (3 != files.size ());
+  fail_if (files[0] != g_root + "/C.FLAC");
+  fail_if (files[1] != g_root + "/a.mp3");
+  fail_if (files[2] != g_root + "/link.mp3");
+}
+END_TEST
+
+START_TEST (test_dirscan_non_recursive_only_subdirs)
+{
+  size_t nentries = 0;
+  uri_lst_t files;
+
+  make_dir (g_root + "/sub");
+  make_file (g_root + "/sub/a.mp3");
+  files = scan (g_root, false, nentries);
+
+  // Not an empty directory, even though there is nothing to play in it
+  fail_if (1 != nentries);
+  fail_if (!files.empty ());
+}
+END_TEST
+
+START_TEST (test_dirscan_recursive)
+{
+  size_t nentries = 0;
+  uri_lst_t files;
+
+  make_tree ();
+  files = scan (g_root, true, nentries);
+
+  // Directories are not counted when descended into
+  fail_if (8 != nentries);
+  fail_if (6 != files.size ());
+  fail_if (files[0] != g_root + "/C.FLAC");
+  fail_if (files[1] != g_root + "/a.mp3");
+  fail_if (files[2] != g_root + "/album.mp3/d.mp3");
+  fail_if (files[3] != g_root + "/link.mp3");
+  fail_if (files[4] != g_root + "/sub/deeper/f.mp3");
+  fail_if (files[5] != g_root + "/sub/e.flac");
+}
+END_TEST
+
+START_TEST (test_dirscan_large_directory)
+{
+  size_t nentries = 0;
+  uri_lst_t files;
+  char name[64];
+  int i = 0;
+
+  for (i = 0; i < LARGE_DIR_NFILES; ++i)
+  {
+    snprintf (name, sizeof (name), "/a_somewhat_long_file_name_%05d.%s", i,
+              (i % 2) ? "mp3" : "txt");
+    make_file (g_root + name);
+  }
+
+  files = scan (g_root, true, nentries);
+
+  fail_if (LARGE_DIR_NFILES != nentries);
+  fail_if (LARGE_DIR_NFILES / 2 != files.size ());
+  for (i = 0; i < LARGE_DIR_NFILES / 2; ++i)
+  {
+    snprintf (name, sizeof (name), "/a_somewhat_long_file_name_%05d.mp3",
+              2 * i + 1);
+    fail_if (files[i] != g_root + name);
+  }
+}
+END_TEST
+
+START_TEST (test_dirscan_missing_directory)
+{
+  size_t nentries = 1;
+  uri_lst_t files;
+
+  files = scan (g_root + "/missing", true, nentries);
+  fail_if (0 != nentries);
+  fail_if (!files.empty ());
+}
+END_TEST
+
+START_TEST (test_dirscan_lower_extension)
+{
+  fail_if (".mp3" != tiz::dirscan::lower_extension ("/a/b/c.MP3"));
+  fail_if (".flac" != tiz::dirscan::lower_extension ("c.d.Flac"));
+  fail_if ("" != tiz::dirscan::lower_extension ("/a.dir/c"));
+  fail_if ("" != tiz::dirscan::lower_extension ("/a/b/c"));
+  fail_if ("." != tiz::dirscan::lower_extension ("/a/b/c."));
+  fail_if (!tiz::dirscan::is_known_media (extensions (), "/a.dir/C.MP3"));
+  fail_if (tiz::dirscan::is_known_media (extensions (), "/a.mp3/c"));
+}
+END_TEST
+
+Suite *dirscan_suite (void)
+{
+  TCase *tc_dirscan;
+  Suite *s = suite_create ("tizonia player");
+
+  tc_dirscan = tcase_create ("dirscan");
+  tcase_add_checked_fixture (tc_dirscan, setup, teardown);
+  tcase_set_timeout (tc_dirscan, DIRSCAN_TEST_TIMEOUT);
+  tcase_add_test (tc_dirscan, test_dirscan_entry_type_known);
+  tcase_add_test (tc_dirscan, test_dirscan_entry_type_unknown_falls_back_to_stat);
+  tcase_add_test (tc_dirscan, test_dirscan_non_recursive);
+  tcase_add_test (tc_dirscan, test_dirscan_non_recursive_only_subdirs);
+  tcase_add_test (tc_dirscan, test_dirscan_recursive);
+  tcase_add_test (tc_dirscan, test_dirscan_large_directory);
+  tcase_add_test (tc_dirscan, test_dirscan_missing_directory);
+  tcase_add_test (tc_dirscan, test_dirscan_lower_extension);
+  suite_add_tcase (s, tc_dirscan);
+
+  return s;
+}
+
+int main (void)
+{
+  int number_failed = 0;
+  SRunner *sr = srunner_create (dirscan_suite ());
+
+  tiz_log_init ();
+
+  srunner_run_all (sr, CK_VERBOSE);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+
+  tiz_log_deinit ();
+
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
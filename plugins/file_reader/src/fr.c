@@ -31,6 +31,7 @@
 #endif
 
 #include <assert.h>
+#include <stdbool.h>
 #include <string.h>
 
 #include <OMX_Core.h>
@@ -64,6 +65,42 @@
 
 static OMX_VERSIONTYPE file_reader_version = {{1, 0, 0, 0}};
 
+static bool
+is_mmap_mode_enabled (void)
+{
+  return (0 == tiz_rcfile_compare_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                                         ARATELIA_FILE_READER_MMAP_MODE_KEY,
+                                         "true"));
+}
+
+static OMX_BUFFERSUPPLIERTYPE
+buffer_supplier_preference (void)
+{
+  /* In mmap mode, prefer to supply the buffers, so that headers can be
+     pointed at the mapped file instead of copying into them */
+  return is_mmap_mode_enabled () ? OMX_BufferSupplyOutput
+                                 : ARATELIA_FILE_READER_PORT_SUPPLIERPREF;
+}
+
+static OMX_U8 *
+port_alloc_hook (OMX_U32 * ap_size, OMX_PTR * app_port_priv, void * ap_args)
+{
+  OMX_U8 * p = NULL;
+  assert (ap_size);
+  assert (app_port_priv);
+  p = tiz_mem_calloc ((size_t) * ap_size, sizeof (OMX_U8));
+  /* Remember the allocated buffer; the header's pBuffer may be pointing at
+     the mapped file by the time the buffer is freed (see frprc.c) */
+  *app_port_priv = p;
+  return p;
+}
+
+static void
+port_free_hook (OMX_PTR ap_buf, OMX_PTR ap_port_priv, void * ap_args)
+{
+  tiz_mem_free (ap_port_priv ? ap_port_priv : ap_buf);
+}
+
 static OMX_PTR
 instantiate_audio_port (OMX_HANDLETYPE ap_hdl)
 {
@@ -74,7 +111,7 @@ instantiate_audio_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_FILE_READER_PORT_MIN_BUF_SIZE,
     ARATELIA_FILE_READER_PORT_NONCONTIGUOUS,
     ARATELIA_FILE_READER_PORT_ALIGNMENT,
-    ARATELIA_FILE_READER_PORT_SUPPLIERPREF,
+    buffer_supplier_preference (),
     {ARATELIA_FILE_READER_PORT_INDEX, NULL, NULL, NULL},
     -1 /* use -1 for now */
   };
@@ -92,7 +129,7 @@ instantiate_video_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_FILE_READER_PORT_MIN_BUF_SIZE,
     ARATELIA_FILE_READER_PORT_NONCONTIGUOUS,
     ARATELIA_FILE_READER_PORT_ALIGNMENT,
-    ARATELIA_FILE_READER_PORT_SUPPLIERPREF,
+    buffer_supplier_preference (),
     {ARATELIA_FILE_READER_PORT_INDEX, NULL, NULL, NULL},
     -1 /* use -1 for now */
   };
@@ -110,7 +147,7 @@ instantiate_image_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_FILE_READER_PORT_MIN_BUF_SIZE,
     ARATELIA_FILE_READER_PORT_NONCONTIGUOUS,
     ARATELIA_FILE_READER_PORT_ALIGNMENT,
-    ARATELIA_FILE_READER_PORT_SUPPLIERPREF,
+    buffer_supplier_preference (),
     {ARATELIA_FILE_READER_PORT_INDEX, NULL, NULL, NULL},
     -1 /* use -1 for now */
   };
@@ -128,7 +165,7 @@ instantiate_other_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_FILE_READER_PORT_MIN_BUF_SIZE,
     ARATELIA_FILE_READER_PORT_NONCONTIGUOUS,
     ARATELIA_FILE_READER_PORT_ALIGNMENT,
-    ARATELIA_FILE_READER_PORT_SUPPLIERPREF,
+    buffer_supplier_preference (),
     {ARATELIA_FILE_READER_PORT_INDEX, NULL, NULL, NULL},
     -1 /* use -1 for now */
   };
@@ -140,7 +177,7 @@ static OMX_PTR
 instantiate_config_port (OMX_HANDLETYPE ap_hdl)
 {
   /* Instantiate the config port */
-  return factory_new (tiz_get_type (ap_hdl, "tizuricfgport"),
+  return factory_new (tiz_get_type (ap_hdl, "tizdemuxercfgport"),
                       NULL, /* this port does not take options */
                       ARATELIA_FILE_READER_COMPONENT_NAME, file_reader_version);
 }
@@ -162,6 +199,9 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
     = {&audio_role, &video_role, &image_role, &other_role};
   tiz_type_factory_t frprc_type;
   const tiz_type_factory_t * tf_list[] = {&frprc_type};
+  const tiz_alloc_hooks_t new_hooks
+    = {ARATELIA_FILE_READER_PORT_INDEX, port_alloc_hook, port_free_hook, NULL};
+  tiz_alloc_hooks_t old_hooks = {0, NULL, NULL, NULL};
 
   strcpy ((OMX_STRING) audio_role.role, ARATELIA_FILE_READER_AUDIO_READER_ROLE);
   audio_role.pf_cport = instantiate_config_port;
@@ -202,5 +242,9 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
   /* Register the various roles */
   tiz_check_omx (tiz_comp_register_roles (ap_hdl, rf_list, 4));
 
+  /* Register the buffer allocation hooks */
+  tiz_check_omx (
+    tiz_comp_register_alloc_hooks (ap_hdl, &new_hooks, &old_hooks));
+
   return OMX_ErrorNone;
 }
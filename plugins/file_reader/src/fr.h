@@ -48,6 +48,15 @@ extern "C" {
 #define ARATELIA_FILE_READER_PORT_ALIGNMENT 0
 #define ARATELIA_FILE_READER_PORT_SUPPLIERPREF OMX_BufferSupplyInput
 
+/* Config file key to enable the mmap mode (true|false) */
+#define ARATELIA_FILE_READER_MMAP_MODE_KEY \
+  "OMX.Aratelia.file_reader.binary.mmap_mode"
+
+/* Config file key to set the number of asynchronous reads kept in flight (0
+   means synchronous reads) */
+#define ARATELIA_FILE_READER_AIO_DEPTH_KEY \
+  "OMX.Aratelia.file_reader.binary.aio_depth"
+
 #ifdef __cplusplus
 }
 #endif
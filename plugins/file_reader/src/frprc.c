@@ -31,16 +31,24 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <OMX_Core.h>
+#include <OMX_TizoniaExt.h>
 
 #include <tizplatform.h>
 
 #include <tizkernel.h>
+#include <tizport-macros.h>
 
 #include "fr.h"
 #include "frprc_decls.h"
@@ -51,19 +59,264 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.file_reader.prc"
 #endif
 
+/* A read that takes longer than this is counted as stalled */
+#define FR_STALL_THRESHOLD_US 5000
+
+/* How far ahead of the current position the kernel is asked to read in mmap
+   mode */
+#define FR_READAHEAD_BYTES (512 * 1024)
+
+/* Maximum number of pages checked for residency before each buffer */
+#define FR_MINCORE_MAX_PAGES 64
+
+/* aio mode: number of I/O threads and maximum number of reads in flight */
+#define FR_AIO_THREADS 2
+#define FR_AIO_MAX_DEPTH 64
+
+/* Maximum number of buffers filled per call in synchronous mode */
+#define FR_MAX_BATCH 16
+
 /* Forward declarations */
 static OMX_ERRORTYPE
 fr_prc_deallocate_resources (void *);
+static OMX_ERRORTYPE
+read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr);
+
+static inline OMX_U64
+now_us (void)
+{
+  struct timespec ts;
+  (void) clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (OMX_U64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void
+release_old_map (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->p_old_map_)
+    {
+      (void) munmap (ap_prc->p_old_map_, ap_prc->old_map_len_);
+      ap_prc->p_old_map_ = NULL;
+      ap_prc->old_map_len_ = 0;
+      ap_prc->old_direct_out_ = 0;
+    }
+}
+
+static void
+unmap_file (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->p_map_)
+    {
+      (void) munmap (ap_prc->p_map_, ap_prc->map_len_);
+      ap_prc->p_map_ = NULL;
+      ap_prc->map_len_ = 0;
+      ap_prc->map_offset_ = 0;
+    }
+  ap_prc->direct_out_ = 0;
+  release_old_map (ap_prc);
+}
+
+static void
+retire_map (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  /* Buffers that point into the current mapping may still be held
+     downstream; in that case the mapping is kept until they have all come
+     back. No zero-copy buffers are handed out while an old mapping is
+     around, so there is never more than one */
+  if (ap_prc->p_map_ && ap_prc->direct_out_ > 0 && !ap_prc->p_old_map_)
+    {
+      ap_prc->p_old_map_ = ap_prc->p_map_;
+      ap_prc->old_map_len_ = ap_prc->map_len_;
+      ap_prc->old_direct_out_ = ap_prc->direct_out_;
+      ap_prc->p_map_ = NULL;
+      ap_prc->map_len_ = 0;
+      ap_prc->map_offset_ = 0;
+      ap_prc->direct_out_ = 0;
+    }
+  else if (ap_prc->p_map_)
+    {
+      (void) munmap (ap_prc->p_map_, ap_prc->map_len_);
+      ap_prc->p_map_ = NULL;
+      ap_prc->map_len_ = 0;
+      ap_prc->map_offset_ = 0;
+      ap_prc->direct_out_ = 0;
+    }
+}
+
+static void
+map_file (fr_prc_t * ap_prc)
+{
+  struct stat st;
+  void * p_map = NULL;
+  int fd = -1;
+
+  assert (ap_prc);
+  assert (ap_prc->p_file_);
+  assert (!ap_prc->p_map_);
+
+  fd = fileno (ap_prc->p_file_);
+  if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || 0 == st.st_size)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "Not a regular file, using reads");
+      return;
+    }
+
+  /* Private and writable, so that a downstream component that modifies its
+     input in place only ever touches its own copy of the page */
+  p_map = mmap (NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (MAP_FAILED == p_map)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "mmap failed (%s), using reads",
+                  strerror (errno));
+      return;
+    }
+
+  (void) madvise (p_map, st.st_size, MADV_SEQUENTIAL);
+  ap_prc->p_map_ = p_map;
+  ap_prc->map_len_ = st.st_size;
+  ap_prc->map_offset_ = 0;
+  TIZ_NOTICE (handleOf (ap_prc), "Mapped [%lu] bytes",
+              (unsigned long) ap_prc->map_len_);
+}
+
+static inline OMX_ERRORTYPE
+start_io_watcher (fr_prc_t * ap_prc)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (ap_prc);
+  assert (ap_prc->p_ev_io_);
+  if (!ap_prc->awaiting_io_ev_)
+    {
+      rc = tiz_srv_io_watcher_start (ap_prc, ap_prc->p_ev_io_);
+    }
+  ap_prc->awaiting_io_ev_ = true;
+  return rc;
+}
+
+static inline void
+stop_io_watcher (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->p_ev_io_ && ap_prc->awaiting_io_ev_)
+    {
+      (void) tiz_srv_io_watcher_stop (ap_prc, ap_prc->p_ev_io_);
+    }
+  ap_prc->awaiting_io_ev_ = false;
+}
+
+static OMX_ERRORTYPE
+setup_aio (fr_prc_t * ap_prc)
+{
+  struct stat st;
+  const char * p_depth = NULL;
+
+  assert (ap_prc);
+  assert (ap_prc->p_file_);
+  assert (!ap_prc->p_aio_);
+
+  p_depth = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                                  ARATELIA_FILE_READER_AIO_DEPTH_KEY);
+  ap_prc->aio_depth_ = p_depth ? strtoul (p_depth, NULL, 10) : 0;
+  ap_prc->aio_depth_ = MIN (ap_prc->aio_depth_, FR_AIO_MAX_DEPTH);
+  if (0 == ap_prc->aio_depth_)
+    {
+      return OMX_ErrorNone;
+    }
+
+  if (fstat (fileno (ap_prc->p_file_), &st) != 0 || !S_ISREG (st.st_mode)
+      || 0 == st.st_size)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "Not a regular file, using sync reads");
+      return OMX_ErrorNone;
+    }
+
+  ap_prc->file_len_ = st.st_size;
+  tiz_check_omx (
+    tiz_aio_init (&(ap_prc->p_aio_), FR_AIO_THREADS, ap_prc->aio_depth_));
+  tiz_check_null_ret_oom (
+    ap_prc->p_reqs_
+    = tiz_mem_calloc (ap_prc->aio_depth_, sizeof (tiz_aio_req_t)));
+  tiz_check_omx (tiz_srv_io_watcher_init (ap_prc, &(ap_prc->p_ev_io_),
+                                          tiz_aio_get_fd (ap_prc->p_aio_),
+                                          TIZ_EVENT_READ, true));
+  TIZ_NOTICE (handleOf (ap_prc), "Async reads - depth [%u]",
+              ap_prc->aio_depth_);
+  return OMX_ErrorNone;
+}
+
+static void
+teardown_aio (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  stop_io_watcher (ap_prc);
+  if (ap_prc->p_ev_io_)
+    {
+      tiz_srv_io_watcher_destroy (ap_prc, ap_prc->p_ev_io_);
+      ap_prc->p_ev_io_ = NULL;
+    }
+  /* Joins the I/O threads, so the file can be closed afterwards */
+  tiz_aio_destroy (ap_prc->p_aio_);
+  ap_prc->p_aio_ = NULL;
+  tiz_mem_free (ap_prc->p_reqs_);
+  ap_prc->p_reqs_ = NULL;
+}
+
+static void
+close_next_file (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->p_next_file_)
+    {
+      fclose (ap_prc->p_next_file_);
+      ap_prc->p_next_file_ = NULL;
+    }
+  tiz_mem_free (ap_prc->p_next_uri_param_);
+  ap_prc->p_next_uri_param_ = NULL;
+  ap_prc->next_file_len_ = 0;
+}
+
+static void
+destroy_seekidx (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  fr_seekidx_destroy (ap_prc->p_seekidx_);
+  ap_prc->p_seekidx_ = NULL;
+  ap_prc->seekidx_failed_ = false;
+}
 
 static inline void
 close_file (fr_prc_t * ap_prc)
 {
   assert (ap_prc);
+  destroy_seekidx (ap_prc);
+  teardown_aio (ap_prc);
+  unmap_file (ap_prc);
   if (ap_prc->p_file_)
     {
       fclose (ap_prc->p_file_);
       ap_prc->p_file_ = NULL;
     }
+  close_next_file (ap_prc);
+}
+
+static void
+report_stats (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (!ap_prc->stats_reported_ && ap_prc->start_us_ > 0)
+    {
+      const OMX_U64 elapsed_us = now_us () - ap_prc->start_us_;
+      const double secs = elapsed_us > 0 ? elapsed_us / 1000000.0 : 1e-6;
+      TIZ_NOTICE (handleOf (ap_prc),
+                  "Read [%u] bytes in [%.3f] s ([%.0f] bytes/s) - "
+                  "stalled reads [%u] - zero-copy buffers [%u]",
+                  ap_prc->counter_, secs, ap_prc->counter_ / secs,
+                  ap_prc->stalled_reads_, ap_prc->direct_bufs_);
+      ap_prc->stats_reported_ = true;
+    }
 }
 
 static inline void
@@ -80,6 +333,13 @@ reset_stream_parameters (fr_prc_t * ap_prc)
   assert (ap_prc);
   ap_prc->counter_ = 0;
   ap_prc->eos_ = false;
+  ap_prc->map_offset_ = 0;
+  ap_prc->start_us_ = 0;
+  ap_prc->stalled_reads_ = 0;
+  ap_prc->direct_bufs_ = 0;
+  ap_prc->stats_reported_ = false;
+  ap_prc->nsubmitted_ = 0;
+  ap_prc->read_offset_ = 0;
   if (ap_prc->p_file_)
     {
       rewind (ap_prc->p_file_);
@@ -129,6 +389,242 @@ obtain_uri (fr_prc_t * ap_prc)
   return rc;
 }
 
+static OMX_ERRORTYPE
+open_next_file (fr_prc_t * ap_prc)
+{
+  const long pathname_max = PATH_MAX + NAME_MAX;
+  OMX_PARAM_CONTENTURITYPE * p_uri = NULL;
+  FILE * p_file = NULL;
+  struct stat st;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+
+  /* A new value always replaces the file queued so far */
+  close_next_file (ap_prc);
+
+  tiz_check_null_ret_oom (
+    p_uri
+    = tiz_mem_calloc (1, sizeof (OMX_PARAM_CONTENTURITYPE) + pathname_max + 1));
+  p_uri->nSize = sizeof (OMX_PARAM_CONTENTURITYPE) + pathname_max + 1;
+  p_uri->nVersion.nVersion = OMX_VERSION;
+
+  if (OMX_ErrorNone
+      != (rc = tiz_api_GetConfig (tiz_get_krn (handleOf (ap_prc)),
+                                  handleOf (ap_prc),
+                                  OMX_TizoniaIndexConfigNextContentURI, p_uri)))
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[%s] : Error retrieving the next URI from port",
+                 tiz_err_to_str (rc));
+    }
+  else if ('\0' != p_uri->contentURI[0])
+    {
+      /* The file is opened now, so that the switch costs no more than a
+         regular read. Should anything go wrong, the current stream simply
+         ends as usual */
+      if (!(p_file = fopen ((const char *) p_uri->contentURI, "r")))
+        {
+          TIZ_NOTICE (handleOf (ap_prc), "Unable to open next URI [%s] (%s)",
+                      p_uri->contentURI, strerror (errno));
+        }
+      else if (fstat (fileno (p_file), &st) != 0 || !S_ISREG (st.st_mode)
+               || 0 == st.st_size)
+        {
+          TIZ_NOTICE (handleOf (ap_prc), "Next URI [%s] is not a regular file",
+                      p_uri->contentURI);
+          fclose (p_file);
+        }
+      else
+        {
+          TIZ_NOTICE (handleOf (ap_prc), "Next URI [%s]", p_uri->contentURI);
+          ap_prc->p_next_file_ = p_file;
+          ap_prc->next_file_len_ = st.st_size;
+          ap_prc->p_next_uri_param_ = p_uri;
+          p_uri = NULL;
+        }
+    }
+
+  tiz_mem_free (p_uri);
+  return OMX_ErrorNone;
+}
+
+static bool
+switch_to_next_file (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+
+  if (!ap_prc->p_next_file_)
+    {
+      return false;
+    }
+
+  report_stats (ap_prc);
+  retire_map (ap_prc);
+  destroy_seekidx (ap_prc);
+  fclose (ap_prc->p_file_);
+  delete_uri (ap_prc);
+
+  ap_prc->p_file_ = ap_prc->p_next_file_;
+  ap_prc->p_uri_param_ = ap_prc->p_next_uri_param_;
+  ap_prc->file_len_ = ap_prc->next_file_len_;
+  ap_prc->p_next_file_ = NULL;
+  ap_prc->p_next_uri_param_ = NULL;
+  ap_prc->next_file_len_ = 0;
+  reset_stream_parameters (ap_prc);
+
+  if (ap_prc->mmap_mode_ && !ap_prc->p_aio_)
+    {
+      map_file (ap_prc);
+    }
+  if (!ap_prc->p_map_)
+    {
+      (void) posix_fadvise (fileno (ap_prc->p_file_), 0, 0,
+                            POSIX_FADV_SEQUENTIAL);
+    }
+
+  TIZ_NOTICE (handleOf (ap_prc), "Switched to URI [%s]",
+              ap_prc->p_uri_param_->contentURI);
+
+  /* Let the IL client know that the stream now carries the next URI */
+  tiz_srv_issue_event ((OMX_PTR) ap_prc, OMX_EventIndexSettingChanged,
+                       ARATELIA_FILE_READER_PORT_INDEX,
+                       OMX_TizoniaIndexConfigNextContentURI, /* the index of
+                                                                the struct
+                                                                that has
+                                                                been
+                                                                modified */
+                       NULL);
+  return true;
+}
+
+static bool
+pages_resident (const fr_prc_t * ap_prc, const OMX_U8 * ap_addr,
+                const size_t a_len)
+{
+  unsigned char vec[FR_MINCORE_MAX_PAGES];
+  const uintptr_t mask = ~((uintptr_t) ap_prc->page_size_ - 1);
+  OMX_U8 * p_start = (OMX_U8 *) ((uintptr_t) ap_addr & mask);
+  size_t len = MIN (a_len + (ap_addr - p_start),
+                    FR_MINCORE_MAX_PAGES * ap_prc->page_size_);
+  size_t npages = (len + ap_prc->page_size_ - 1) / ap_prc->page_size_;
+  size_t i = 0;
+
+  if (mincore (p_start, len, vec) != 0)
+    {
+      return true;
+    }
+
+  for (i = 0; i < npages; ++i)
+    {
+      if (!(vec[i] & 1))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+static void
+read_ahead (const fr_prc_t * ap_prc)
+{
+  const uintptr_t mask = ~((uintptr_t) ap_prc->page_size_ - 1);
+  const size_t offset = ap_prc->map_offset_ & mask;
+  const size_t len = MIN (FR_READAHEAD_BYTES, ap_prc->map_len_ - offset);
+  if (len > 0)
+    {
+      (void) madvise (ap_prc->p_map_ + offset, len, MADV_WILLNEED);
+    }
+}
+
+static bool
+may_point_at_map (const fr_prc_t * ap_prc, const OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  /* Only when this port supplies the buffers, i.e. the original buffer is
+     owned by this component and can be restored when the header comes
+     back (the alloc hooks in fr.c keep it in pOutputPortPrivate) */
+  return (ap_hdr->pOutputPortPrivate && !ap_prc->p_old_map_
+          && TIZ_PORT_IS_TUNNELED_AND_SUPPLIER (
+               tiz_krn_get_port (tiz_get_krn (handleOf (ap_prc)),
+                                 ARATELIA_FILE_READER_PORT_INDEX)));
+}
+
+static void
+restore_buffer (fr_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  if ((ap_prc->p_map_ || ap_prc->p_old_map_) && ap_hdr->pOutputPortPrivate
+      && ap_hdr->pBuffer != ap_hdr->pOutputPortPrivate)
+    {
+      if (ap_prc->p_old_map_ && ap_hdr->pBuffer >= ap_prc->p_old_map_
+          && ap_hdr->pBuffer < ap_prc->p_old_map_ + ap_prc->old_map_len_)
+        {
+          if (0 == --ap_prc->old_direct_out_)
+            {
+              release_old_map (ap_prc);
+            }
+        }
+      else if (ap_prc->direct_out_ > 0)
+        {
+          ap_prc->direct_out_--;
+        }
+      ap_hdr->pBuffer = ap_hdr->pOutputPortPrivate;
+    }
+}
+
+static OMX_ERRORTYPE
+map_into_buffer (fr_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * p_hdr)
+{
+  const size_t remaining = ap_prc->map_len_ - ap_prc->map_offset_;
+  OMX_U8 * p_src = ap_prc->p_map_ + ap_prc->map_offset_;
+  size_t len = MIN (remaining, p_hdr->nAllocLen);
+
+  if (0 == len)
+    {
+      if (switch_to_next_file (ap_prc))
+        {
+          return read_into_buffer (ap_prc, p_hdr);
+        }
+      TIZ_NOTICE (handleOf (ap_prc), "End of file reached EOS in HEADER [%p]",
+                  p_hdr);
+      p_hdr->nFlags |= OMX_BUFFERFLAG_EOS;
+      ap_prc->eos_ = true;
+      return OMX_ErrorNone;
+    }
+
+  if (!pages_resident (ap_prc, p_src, len))
+    {
+      ap_prc->stalled_reads_++;
+    }
+
+  if (len == p_hdr->nAllocLen && may_point_at_map (ap_prc, p_hdr))
+    {
+      /* Zero-copy: the consumer reads straight from the page cache. Only
+         full buffers are handed out this way, so that nAllocLen bytes are
+         always backed by the mapping */
+      p_hdr->pBuffer = p_src;
+      ap_prc->direct_bufs_++;
+      ap_prc->direct_out_++;
+    }
+  else
+    {
+      memcpy (p_hdr->pBuffer, p_src, len);
+    }
+
+  ap_prc->map_offset_ += len;
+  read_ahead (ap_prc);
+
+  p_hdr->nFilledLen = len;
+  ap_prc->counter_ += len;
+
+  TIZ_TRACE (handleOf (ap_prc),
+             "Mapping into HEADER [%p]...nFilledLen[%d] "
+             "counter [%d] direct [%s]",
+             p_hdr, p_hdr->nFilledLen, ap_prc->counter_,
+             p_hdr->pBuffer == p_src ? "YES" : "NO");
+
+  return OMX_ErrorNone;
+}
+
 static OMX_ERRORTYPE
 read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
 {
@@ -138,10 +634,26 @@ read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
   if (p_prc->p_file_ && !(p_prc->eos_))
     {
       int bytes_read = 0;
+      OMX_U64 t0 = now_us ();
+
+      if (0 == p_prc->start_us_)
+        {
+          p_prc->start_us_ = t0;
+        }
+
+      if (p_prc->p_map_)
+        {
+          return map_into_buffer (p_prc, p_hdr);
+        }
+
       if (!(bytes_read
             = fread (p_hdr->pBuffer, 1, p_hdr->nAllocLen, p_prc->p_file_)))
         {
-          if (feof (p_prc->p_file_))
+          if (feof (p_prc->p_file_) && switch_to_next_file (p_prc))
+            {
+              return read_into_buffer (p_prc, p_hdr);
+            }
+          else if (feof (p_prc->p_file_))
             {
               TIZ_NOTICE (
                 handleOf (p_prc),
@@ -157,6 +669,11 @@ read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
             }
         }
 
+      if (now_us () - t0 > FR_STALL_THRESHOLD_US)
+        {
+          p_prc->stalled_reads_++;
+        }
+
       p_hdr->nFilledLen = bytes_read;
       p_prc->counter_ += p_hdr->nFilledLen;
 
@@ -169,6 +686,277 @@ read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+send_eos (fr_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+
+  assert (ap_prc);
+
+  tiz_check_omx (tiz_krn_claim_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                       ARATELIA_FILE_READER_PORT_INDEX, 0,
+                                       &p_hdr));
+  if (p_hdr)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "End of file reached EOS in HEADER [%p]",
+                  p_hdr);
+      p_hdr->nOffset = 0;
+      p_hdr->nFilledLen = 0;
+      p_hdr->nFlags |= OMX_BUFFERFLAG_EOS;
+      ap_prc->eos_ = true;
+      report_stats (ap_prc);
+      tiz_check_omx (
+        tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                ARATELIA_FILE_READER_PORT_INDEX, p_hdr));
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+submit_reads (fr_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+
+  assert (ap_prc);
+  assert (ap_prc->p_aio_);
+
+  while (!ap_prc->eos_ && ap_prc->read_offset_ < ap_prc->file_len_
+         && !tiz_aio_is_full (ap_prc->p_aio_))
+    {
+      tiz_aio_req_t * p_req = NULL;
+      tiz_check_omx (tiz_krn_claim_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                           ARATELIA_FILE_READER_PORT_INDEX, 0,
+                                           &p_hdr));
+      if (!p_hdr)
+        {
+          break;
+        }
+
+      if (0 == ap_prc->start_us_)
+        {
+          ap_prc->start_us_ = now_us ();
+        }
+
+      p_hdr->nOffset = 0;
+      p_hdr->nFilledLen = 0;
+
+      /* Requests are reaped in submission order, so slots are reused in
+         the same order */
+      p_req = &(ap_prc->p_reqs_[ap_prc->nsubmitted_++ % ap_prc->aio_depth_]);
+      p_req->op = ETIZAioOpRead;
+      p_req->fd = fileno (ap_prc->p_file_);
+      p_req->offset = ap_prc->read_offset_;
+      p_req->p_buf = p_hdr->pBuffer;
+      p_req->len
+        = MIN (p_hdr->nAllocLen, ap_prc->file_len_ - ap_prc->read_offset_);
+      p_req->p_data = p_hdr;
+      tiz_check_omx (tiz_aio_submit (ap_prc->p_aio_, p_req));
+      ap_prc->read_offset_ += p_req->len;
+
+      TIZ_TRACE (handleOf (ap_prc), "Submitted HEADER [%p] offset [%llu]",
+                 p_hdr, (unsigned long long) p_req->offset);
+    }
+
+  if (tiz_aio_pending (ap_prc->p_aio_) > 0)
+    {
+      return start_io_watcher (ap_prc);
+    }
+
+  if (!ap_prc->eos_ && ap_prc->read_offset_ >= ap_prc->file_len_)
+    {
+      /* All the reads of this file have completed, but the end of the stream
+         has not been signalled: either there is a file queued or it was
+         cancelled after the last read went out */
+      if (switch_to_next_file (ap_prc))
+        {
+          return submit_reads (ap_prc);
+        }
+      return send_eos (ap_prc);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+complete_read (fr_prc_t * ap_prc, tiz_aio_req_t * ap_req)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+  assert (ap_req);
+
+  p_hdr = ap_req->p_data;
+  assert (p_hdr);
+
+  if (ap_req->result < 0)
+    {
+      TIZ_ERROR (handleOf (ap_prc), "An error occurred while reading (%s)",
+                 strerror (ap_req->error));
+      p_hdr->nFilledLen = 0;
+      rc = OMX_ErrorInsufficientResources;
+    }
+  else
+    {
+      p_hdr->nFilledLen = ap_req->result;
+      ap_prc->counter_ += ap_req->result;
+      /* With a file queued, the switch happens in submit_reads, once all the
+         reads of this one have completed */
+      if (!ap_prc->eos_ && !ap_prc->p_next_file_
+          && (ap_req->offset + ap_req->result >= ap_prc->file_len_
+              || (size_t) ap_req->result < ap_req->len))
+        {
+          TIZ_NOTICE (handleOf (ap_prc),
+                      "End of file reached EOS in HEADER [%p]", p_hdr);
+          p_hdr->nFlags |= OMX_BUFFERFLAG_EOS;
+          ap_prc->eos_ = true;
+          report_stats (ap_prc);
+        }
+      TIZ_TRACE (handleOf (ap_prc),
+                 "Completed HEADER [%p]...nFilledLen[%d] counter [%d]", p_hdr,
+                 p_hdr->nFilledLen, ap_prc->counter_);
+    }
+
+  tiz_check_omx (tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                         ARATELIA_FILE_READER_PORT_INDEX,
+                                         p_hdr));
+  return rc;
+}
+
+static OMX_ERRORTYPE
+return_pending_reads (fr_prc_t * ap_prc)
+{
+  tiz_aio_req_t * p_req = NULL;
+  bool rewound = false;
+
+  assert (ap_prc);
+
+  if (ap_prc->p_aio_)
+    {
+      stop_io_watcher (ap_prc);
+      tiz_aio_drain (ap_prc->p_aio_);
+      while ((p_req = tiz_aio_reap (ap_prc->p_aio_)))
+        {
+          OMX_BUFFERHEADERTYPE * p_hdr = p_req->p_data;
+          if (!rewound)
+            {
+              /* This data never made it out; read it again next time */
+              ap_prc->read_offset_ = p_req->offset;
+              rewound = true;
+            }
+          p_hdr->nOffset = 0;
+          p_hdr->nFilledLen = 0;
+          tiz_check_omx (
+            tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                    ARATELIA_FILE_READER_PORT_INDEX, p_hdr));
+        }
+    }
+  return OMX_ErrorNone;
+}
+
+static fr_seekidx_t *
+obtain_seekidx (fr_prc_t * ap_prc)
+{
+  struct stat st;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+
+  if (!ap_prc->p_seekidx_ && !ap_prc->seekidx_failed_ && ap_prc->p_file_)
+    {
+      const OMX_U64 t0 = now_us ();
+      if (fstat (fileno (ap_prc->p_file_), &st) != 0 || !S_ISREG (st.st_mode))
+        {
+          rc = OMX_ErrorFormatNotDetected;
+        }
+      else
+        {
+          rc = fr_seekidx_init (&(ap_prc->p_seekidx_),
+                                fileno (ap_prc->p_file_), st.st_size);
+        }
+
+      if (OMX_ErrorNone != rc)
+        {
+          /* Not an MP3 or FLAC file; don't try again */
+          TIZ_NOTICE (handleOf (ap_prc), "[%s] : Unable to seek in this file",
+                      tiz_err_to_str (rc));
+          ap_prc->seekidx_failed_ = true;
+        }
+      else
+        {
+          TIZ_NOTICE (handleOf (ap_prc),
+                      "Seek index built in [%llu] us - duration [%lld] us",
+                      (unsigned long long) (now_us () - t0),
+                      (long long) fr_seekidx_duration (ap_prc->p_seekidx_));
+        }
+    }
+  return ap_prc->p_seekidx_;
+}
+
+static OMX_U64
+current_offset (const fr_prc_t * ap_prc)
+{
+  off_t offset = 0;
+  assert (ap_prc);
+  if (ap_prc->p_map_)
+    {
+      return ap_prc->map_offset_;
+    }
+  if (ap_prc->p_aio_)
+    {
+      return ap_prc->read_offset_;
+    }
+  offset = ftello (ap_prc->p_file_);
+  return offset > 0 ? offset : 0;
+}
+
+static OMX_ERRORTYPE
+apply_seek (fr_prc_t * ap_prc)
+{
+  fr_seekidx_t * p_idx = NULL;
+  OMX_TICKS actual = 0;
+  OMX_U64 offset = 0;
+
+  assert (ap_prc);
+
+  if (!ap_prc->seek_pending_ || !ap_prc->p_file_)
+    {
+      return OMX_ErrorNone;
+    }
+  ap_prc->seek_pending_ = false;
+
+  if (!(p_idx = obtain_seekidx (ap_prc)))
+    {
+      return OMX_ErrorNone;
+    }
+
+  offset = fr_seekidx_offset (p_idx, ap_prc->seek_target_, &actual);
+
+  /* Reads already in flight are for the old position */
+  tiz_check_omx (return_pending_reads (ap_prc));
+
+  if (ap_prc->p_map_)
+    {
+      ap_prc->map_offset_ = MIN (offset, ap_prc->map_len_);
+      read_ahead (ap_prc);
+    }
+  else if (ap_prc->p_aio_)
+    {
+      ap_prc->read_offset_ = MIN (offset, ap_prc->file_len_);
+    }
+  else if (fseeko (ap_prc->p_file_, offset, SEEK_SET) != 0)
+    {
+      TIZ_ERROR (handleOf (ap_prc), "Unable to seek to offset [%llu] (%s)",
+                 (unsigned long long) offset, strerror (errno));
+      return OMX_ErrorNone;
+    }
+
+  ap_prc->eos_ = false;
+  TIZ_NOTICE (handleOf (ap_prc), "Seek to [%lld] us - at [%lld] us offset [%llu]",
+              (long long) ap_prc->seek_target_, (long long) actual,
+              (unsigned long long) offset);
+  return OMX_ErrorNone;
+}
+
 /*
  * frprc
  */
@@ -180,6 +968,27 @@ fr_prc_ctor (void * ap_obj, va_list * app)
   assert (p_prc);
   p_prc->p_file_ = NULL;
   p_prc->p_uri_param_ = NULL;
+  p_prc->mmap_mode_ = false;
+  p_prc->p_map_ = NULL;
+  p_prc->map_len_ = 0;
+  p_prc->page_size_ = sysconf (_SC_PAGESIZE);
+  p_prc->direct_out_ = 0;
+  p_prc->p_old_map_ = NULL;
+  p_prc->old_map_len_ = 0;
+  p_prc->old_direct_out_ = 0;
+  p_prc->p_aio_ = NULL;
+  p_prc->p_reqs_ = NULL;
+  p_prc->p_ev_io_ = NULL;
+  p_prc->awaiting_io_ev_ = false;
+  p_prc->aio_depth_ = 0;
+  p_prc->file_len_ = 0;
+  p_prc->p_next_file_ = NULL;
+  p_prc->p_next_uri_param_ = NULL;
+  p_prc->next_file_len_ = 0;
+  p_prc->p_seekidx_ = NULL;
+  p_prc->seekidx_failed_ = false;
+  p_prc->seek_pending_ = false;
+  p_prc->seek_target_ = 0;
   reset_stream_parameters (p_prc);
   return p_prc;
 }
@@ -214,6 +1023,22 @@ fr_prc_allocate_resources (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
       return OMX_ErrorInsufficientResources;
     }
 
+  p_prc->mmap_mode_
+    = (0 == tiz_rcfile_compare_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                                      ARATELIA_FILE_READER_MMAP_MODE_KEY,
+                                      "true"));
+  if (p_prc->mmap_mode_)
+    {
+      map_file (p_prc);
+    }
+
+  if (!p_prc->p_map_)
+    {
+      (void) posix_fadvise (fileno (p_prc->p_file_), 0, 0,
+                            POSIX_FADV_SEQUENTIAL);
+      tiz_check_omx (setup_aio (p_prc));
+    }
+
   return OMX_ErrorNone;
 }
 
@@ -241,7 +1066,78 @@ fr_prc_transfer_and_process (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
 static OMX_ERRORTYPE
 fr_prc_stop_and_return (void * ap_obj)
 {
-  return OMX_ErrorNone;
+  report_stats (ap_obj);
+  return return_pending_reads (ap_obj);
+}
+
+/*
+ * from tiz_api class
+ */
+
+static OMX_ERRORTYPE
+fr_prc_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                  OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  fr_prc_t * p_prc = (fr_prc_t *) ap_obj;
+  assert (p_prc);
+  assert (ap_struct);
+
+  if (OMX_IndexConfigTimePosition == a_index)
+    {
+      OMX_TIME_CONFIG_TIMESTAMPTYPE * p_pos = ap_struct;
+      fr_seekidx_t * p_idx = obtain_seekidx (p_prc);
+      if (!p_idx)
+        {
+          return OMX_ErrorUnsupportedSetting;
+        }
+      /* The position of the data handed out so far */
+      p_pos->nTimestamp
+        = p_prc->seek_pending_
+            ? p_prc->seek_target_
+            : fr_seekidx_time (p_idx, current_offset (p_prc));
+      return OMX_ErrorNone;
+    }
+  else if (OMX_IndexConfigTimeSeekMode == a_index)
+    {
+      OMX_TIME_CONFIG_SEEKMODETYPE * p_mode = ap_struct;
+      /* Seeks land on a frame boundary at or before the requested time */
+      p_mode->eType = OMX_TIME_SeekModeFast;
+      return OMX_ErrorNone;
+    }
+
+  return super_GetConfig (typeOf (ap_obj, "frprc"), ap_obj, ap_hdl, a_index,
+                          ap_struct);
+}
+
+static OMX_ERRORTYPE
+fr_prc_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                  OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  fr_prc_t * p_prc = (fr_prc_t *) ap_obj;
+  assert (p_prc);
+  assert (ap_struct);
+
+  if (OMX_IndexConfigTimePosition == a_index)
+    {
+      const OMX_TIME_CONFIG_TIMESTAMPTYPE * p_pos = ap_struct;
+      /* This is called twice, first by the config port and then by the
+         kernel. The seek is carried out once, when the resulting config change
+         reaches the processor (or the next time buffers are ready, whichever
+         happens first) */
+      p_prc->seek_target_ = MAX (0, p_pos->nTimestamp);
+      p_prc->seek_pending_ = true;
+    }
+  else if (OMX_IndexConfigTimeSeekMode == a_index)
+    {
+      const OMX_TIME_CONFIG_SEEKMODETYPE * p_mode = ap_struct;
+      if (OMX_TIME_SeekModeFast != p_mode->eType)
+        {
+          return OMX_ErrorUnsupportedSetting;
+        }
+    }
+
+  return super_SetConfig (typeOf (ap_obj, "frprc"), ap_obj, ap_hdl, a_index,
+                          ap_struct);
 }
 
 /*
@@ -255,28 +1151,110 @@ fr_prc_buffers_ready (const void * ap_obj)
 
   assert (ap_obj);
 
-  if (!p_prc->eos_)
+  tiz_check_omx (apply_seek ((fr_prc_t *) p_prc));
+
+  if (p_prc->p_aio_)
+    {
+      return submit_reads ((fr_prc_t *) p_prc);
+    }
+
+  {
+    /* Fill as many buffers as are available, and return them in one go */
+    OMX_BUFFERHEADERTYPE * hdrs[FR_MAX_BATCH];
+    OMX_U32 nhdrs = 0;
+    OMX_ERRORTYPE rc = OMX_ErrorNone;
+    OMX_ERRORTYPE release_rc = OMX_ErrorNone;
+    while (OMX_ErrorNone == rc && !p_prc->eos_ && nhdrs < FR_MAX_BATCH)
+      {
+        OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+        rc = tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)),
+                                   ARATELIA_FILE_READER_PORT_INDEX, 0, &p_hdr);
+        if (OMX_ErrorNone != rc || !p_hdr)
+          {
+            break;
+          }
+        TIZ_TRACE (handleOf (p_prc), "Claimed HEADER [%p]...nFilledLen [%d]",
+                   p_hdr, p_hdr->nFilledLen);
+        restore_buffer ((fr_prc_t *) p_prc, p_hdr);
+        p_hdr->nOffset = 0;
+        p_hdr->nFilledLen = 0;
+        hdrs[nhdrs++] = p_hdr;
+        rc = read_into_buffer (p_prc, p_hdr);
+        if (p_prc->eos_)
+          {
+            report_stats ((fr_prc_t *) p_prc);
+          }
+      }
+    /* All the headers claimed go back, even after a failed read; otherwise
+       the port would never be able to leave Executing */
+    release_rc = tiz_krn_release_buffers (tiz_get_krn (handleOf (p_prc)),
+                                          ARATELIA_FILE_READER_PORT_INDEX,
+                                          hdrs, nhdrs);
+    tiz_check_omx (rc);
+    tiz_check_omx (release_rc);
+  }
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+fr_prc_io_ready (void * ap_obj, tiz_event_io_t * ap_ev_io, int a_fd,
+                 int a_events)
+{
+  fr_prc_t * p_prc = ap_obj;
+  tiz_aio_req_t * p_req = NULL;
+
+  assert (p_prc);
+
+  p_prc->awaiting_io_ev_ = false;
+  if (p_prc->p_aio_)
     {
-      OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-      tiz_check_omx (tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)),
-                                               ARATELIA_FILE_READER_PORT_INDEX,
-                                               0, &p_hdr));
-      if (p_hdr)
+      while ((p_req = tiz_aio_reap (p_prc->p_aio_)))
         {
-          TIZ_TRACE (handleOf (p_prc), "Claimed HEADER [%p]...nFilledLen [%d]",
-                     p_hdr, p_hdr->nFilledLen);
-          p_hdr->nOffset = 0;
-          p_hdr->nFilledLen = 0;
-          tiz_check_omx (read_into_buffer (p_prc, p_hdr));
-          tiz_check_omx (
-            tiz_krn_release_buffer (tiz_get_krn (handleOf (p_prc)),
-                                    ARATELIA_FILE_READER_PORT_INDEX, p_hdr));
+          tiz_check_omx (complete_read (p_prc, p_req));
         }
+      tiz_check_omx (submit_reads (p_prc));
     }
-
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+fr_prc_config_change (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid),
+                      OMX_INDEXTYPE a_config_idx)
+{
+  fr_prc_t * p_prc = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (p_prc);
+
+  if (OMX_TizoniaIndexConfigNextContentURI == a_config_idx && p_prc->p_file_)
+    {
+      rc = open_next_file (p_prc);
+    }
+  else if (OMX_IndexConfigTimePosition == a_config_idx)
+    {
+      rc = apply_seek (p_prc);
+      if (OMX_ErrorNone == rc && p_prc->p_aio_)
+        {
+          /* The buffers returned by the pending reads need refilling */
+          rc = submit_reads (p_prc);
+        }
+    }
+  return rc;
+}
+
+static OMX_ERRORTYPE
+fr_prc_port_flush (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
+{
+  return return_pending_reads ((fr_prc_t *) ap_obj);
+}
+
+static OMX_ERRORTYPE
+fr_prc_port_disable (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
+{
+  return return_pending_reads ((fr_prc_t *) ap_obj);
+}
+
 /*
  * fr_prc_class
  */
@@ -334,7 +1312,19 @@ fr_prc_init (void * ap_tos, void * ap_hdl)
      /* TIZ_CLASS_COMMENT: */
      tiz_srv_stop_and_return, fr_prc_stop_and_return,
      /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetConfig, fr_prc_GetConfig,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_SetConfig, fr_prc_SetConfig,
+     /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, fr_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_io_ready, fr_prc_io_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_flush, fr_prc_port_flush,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_disable, fr_prc_port_disable,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, fr_prc_config_change,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
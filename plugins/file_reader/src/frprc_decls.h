@@ -34,9 +34,13 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
 
+#include <tizplatform.h>
 #include <tizprc_decls.h>
 
+#include "frseekidx.h"
+
 typedef struct fr_prc fr_prc_t;
 struct fr_prc
 {
@@ -46,6 +50,39 @@ struct fr_prc
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   OMX_U32 counter_;
   bool eos_;
+  /* mmap mode */
+  bool mmap_mode_;
+  OMX_U8 * p_map_;
+  size_t map_len_;
+  size_t map_offset_;
+  size_t page_size_;
+  OMX_U32 direct_out_;
+  OMX_U8 * p_old_map_;
+  size_t old_map_len_;
+  OMX_U32 old_direct_out_;
+  /* aio mode */
+  tiz_aio_t * p_aio_;
+  tiz_aio_req_t * p_reqs_;
+  tiz_event_io_t * p_ev_io_;
+  bool awaiting_io_ev_;
+  OMX_U32 aio_depth_;
+  OMX_U32 nsubmitted_;
+  OMX_U64 file_len_;
+  OMX_U64 read_offset_;
+  /* gapless mode: the file queued to follow the current one */
+  FILE * p_next_file_;
+  OMX_PARAM_CONTENTURITYPE * p_next_uri_param_;
+  OMX_U64 next_file_len_;
+  /* Seeking: the index is built on first use */
+  fr_seekidx_t * p_seekidx_;
+  bool seekidx_failed_;
+  bool seek_pending_;
+  OMX_TICKS seek_target_;
+  /* Stats */
+  OMX_U64 start_us_;
+  OMX_U32 stalled_reads_;
+  OMX_U32 direct_bufs_;
+  bool stats_reported_;
 };
 
 typedef struct fr_prc_class fr_prc_class_t;
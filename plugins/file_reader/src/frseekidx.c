@@ -0,0 +1,904 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   frseekidx.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Binary file reader's time to byte offset index
+ *
+ * The index is a table of (media time, byte offset) pairs, sorted by both,
+ * that is built once per file and then searched with a binary search.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <tizplatform.h>
+
+#include "frseekidx.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.file_reader.seekidx"
+#endif
+
+/* Minimum distance between two entries obtained from a frame scan */
+#define FR_SEEKIDX_STEP_US 250000
+
+/* A FLAC SEEKTABLE is only used if its points are at most this far apart;
+   otherwise, the frames are scanned */
+#define FR_SEEKIDX_MAX_GAP_US 1000000
+
+#define FR_SEEKIDX_INITIAL_ENTRIES 1024
+
+typedef struct fr_seekidx_entry fr_seekidx_entry_t;
+struct fr_seekidx_entry
+{
+  OMX_TICKS time;
+  OMX_U64 offset;
+};
+
+struct fr_seekidx
+{
+  fr_seekidx_entry_t * p_entries;
+  size_t nentries;
+  size_t capacity;
+  OMX_TICKS duration;
+  OMX_U64 data_end;
+  /* When the entries are far apart (e.g. those of an MP3 Xing table of
+     contents), offsets are interpolated between them. Otherwise every entry
+     is the start of a frame, and seeks land on those */
+  bool interpolate;
+};
+
+typedef struct fr_mp3_hdr fr_mp3_hdr_t;
+struct fr_mp3_hdr
+{
+  OMX_U32 len;
+  OMX_U32 samples;
+  OMX_U32 rate;
+  OMX_U8 version;
+  OMX_U8 layer;
+  bool mono;
+};
+
+/* kbps, indexed by [MPEG-1 ? 0 : 1][3 - layer][bitrate index] */
+static const OMX_U16 mp3_bitrates[2][3][16]
+  = {{{0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0},
+      {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0},
+      {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448,
+       0}},
+     {{0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0},
+      {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0},
+      {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0}}};
+
+/* Hz, indexed by [version][sample rate index] (version 1 is reserved) */
+static const OMX_U32 mp3_rates[4][3] = {{11025, 12000, 8000},
+                                        {0, 0, 0},
+                                        {22050, 24000, 16000},
+                                        {44100, 48000, 32000}};
+
+static inline OMX_U32
+be16 (const OMX_U8 * p)
+{
+  return ((OMX_U32) p[0] << 8) | p[1];
+}
+
+static inline OMX_U32
+be24 (const OMX_U8 * p)
+{
+  return ((OMX_U32) p[0] << 16) | ((OMX_U32) p[1] << 8) | p[2];
+}
+
+static inline OMX_U32
+be32 (const OMX_U8 * p)
+{
+  return ((OMX_U32) p[0] << 24) | ((OMX_U32) p[1] << 16)
+         | ((OMX_U32) p[2] << 8) | p[3];
+}
+
+static inline OMX_U64
+be64 (const OMX_U8 * p)
+{
+  return ((OMX_U64) be32 (p) << 32) | be32 (p + 4);
+}
+
+static inline OMX_TICKS
+samples_to_us (const OMX_U64 a_samples, const OMX_U32 a_rate)
+{
+  return (OMX_TICKS) (a_samples / a_rate * 1000000
+                      + a_samples % a_rate * 1000000 / a_rate);
+}
+
+static bool
+add_entry (fr_seekidx_t * ap_idx, const OMX_TICKS a_time, const OMX_U64 a_offset)
+{
+  assert (ap_idx);
+
+  if (ap_idx->nentries > 0)
+    {
+      const fr_seekidx_entry_t * p_last
+        = &(ap_idx->p_entries[ap_idx->nentries - 1]);
+      /* Both columns must be sorted for the lookups to work */
+      if (a_time <= p_last->time || a_offset <= p_last->offset)
+        {
+          return true;
+        }
+    }
+
+  if (ap_idx->nentries == ap_idx->capacity)
+    {
+      const size_t capacity = ap_idx->capacity > 0
+                                ? ap_idx->capacity * 2
+                                : FR_SEEKIDX_INITIAL_ENTRIES;
+      fr_seekidx_entry_t * p_entries = tiz_mem_realloc (
+        ap_idx->p_entries, capacity * sizeof (fr_seekidx_entry_t));
+      if (!p_entries)
+        {
+          return false;
+        }
+      ap_idx->p_entries = p_entries;
+      ap_idx->capacity = capacity;
+    }
+
+  ap_idx->p_entries[ap_idx->nentries].time = a_time;
+  ap_idx->p_entries[ap_idx->nentries].offset = a_offset;
+  ap_idx->nentries++;
+  return true;
+}
+
+static OMX_U64
+skip_id3v2 (const OMX_U8 * ap_data, const OMX_U64 a_len)
+{
+  OMX_U64 pos = 0;
+  /* There may be more than one tag */
+  while (pos + 10 <= a_len && 0 == memcmp (ap_data + pos, "ID3", 3))
+    {
+      const OMX_U8 * p = ap_data + pos;
+      const OMX_U64 size = ((OMX_U64) (p[6] & 0x7f) << 21)
+                           | ((p[7] & 0x7f) << 14) | ((p[8] & 0x7f) << 7)
+                           | (p[9] & 0x7f);
+      pos += 10 + size + ((p[5] & 0x10) ? 10 : 0);
+    }
+  return MIN (pos, a_len);
+}
+
+/*
+ * MP3
+ */
+
+static bool
+parse_mp3_hdr (const OMX_U8 * p, fr_mp3_hdr_t * ap_hdr)
+{
+  OMX_U32 bitrate = 0;
+  OMX_U8 br_idx = 0;
+  OMX_U8 sr_idx = 0;
+  OMX_U32 pad = 0;
+
+  if (0xff != p[0] || 0xe0 != (p[1] & 0xe0))
+    {
+      return false;
+    }
+
+  ap_hdr->version = (p[1] >> 3) & 0x03;
+  ap_hdr->layer = 4 - ((p[1] >> 1) & 0x03);
+  br_idx = p[2] >> 4;
+  sr_idx = (p[2] >> 2) & 0x03;
+  pad = (p[2] >> 1) & 0x01;
+
+  if (1 == ap_hdr->version || 4 == ap_hdr->layer || 0 == br_idx
+      || 15 == br_idx || 3 == sr_idx)
+    {
+      return false;
+    }
+
+  bitrate
+    = mp3_bitrates[3 == ap_hdr->version ? 0 : 1][3 - ap_hdr->layer][br_idx]
+      * 1000;
+  ap_hdr->rate = mp3_rates[ap_hdr->version][sr_idx];
+  ap_hdr->mono = (3 == (p[3] >> 6));
+
+  if (1 == ap_hdr->layer)
+    {
+      ap_hdr->len = (12 * bitrate / ap_hdr->rate + pad) * 4;
+      ap_hdr->samples = 384;
+    }
+  else if (2 == ap_hdr->layer || 3 == ap_hdr->version)
+    {
+      ap_hdr->len = 144 * bitrate / ap_hdr->rate + pad;
+      ap_hdr->samples = 1152;
+    }
+  else
+    {
+      ap_hdr->len = 72 * bitrate / ap_hdr->rate + pad;
+      ap_hdr->samples = 576;
+    }
+
+  return ap_hdr->len > 4;
+}
+
+/* A frame header is only trusted when the next one is where it says, and
+   looks the same */
+static bool
+is_mp3_frame (const OMX_U8 * ap_data, const OMX_U64 a_pos,
+              const OMX_U64 a_end, fr_mp3_hdr_t * ap_hdr)
+{
+  fr_mp3_hdr_t next;
+  if (a_pos + 4 > a_end || !parse_mp3_hdr (ap_data + a_pos, ap_hdr))
+    {
+      return false;
+    }
+  if (a_pos + ap_hdr->len + 4 > a_end)
+    {
+      return a_pos + ap_hdr->len <= a_end;
+    }
+  return (parse_mp3_hdr (ap_data + a_pos + ap_hdr->len, &next)
+          && next.version == ap_hdr->version && next.layer == ap_hdr->layer
+          && next.rate == ap_hdr->rate);
+}
+
+static OMX_U64
+find_mp3_frame (const OMX_U8 * ap_data, OMX_U64 a_pos, const OMX_U64 a_end,
+                fr_mp3_hdr_t * ap_hdr)
+{
+  while (a_pos + 4 <= a_end)
+    {
+      const OMX_U8 * p
+        = memchr (ap_data + a_pos, 0xff, (size_t) (a_end - a_pos - 3));
+      if (!p)
+        {
+          break;
+        }
+      a_pos = p - ap_data;
+      if (is_mp3_frame (ap_data, a_pos, a_end, ap_hdr))
+        {
+          return a_pos;
+        }
+      a_pos++;
+    }
+  return a_end;
+}
+
+static bool
+index_mp3_xing (fr_seekidx_t * ap_idx, const OMX_U8 * ap_data,
+                const OMX_U64 a_first, const fr_mp3_hdr_t * ap_hdr)
+{
+  const OMX_U32 side_info
+    = 3 == ap_hdr->version ? (ap_hdr->mono ? 17 : 32) : (ap_hdr->mono ? 9 : 17);
+  const OMX_U8 * p = ap_data + a_first + 4 + side_info;
+  OMX_U32 flags = 0;
+  OMX_U32 frames = 0;
+  OMX_U64 bytes = ap_idx->data_end - a_first;
+  int i = 0;
+
+  if (a_first + 4 + side_info + 120 > ap_idx->data_end
+      || (0 != memcmp (p, "Xing", 4) && 0 != memcmp (p, "Info", 4)))
+    {
+      return false;
+    }
+
+  flags = be32 (p + 4);
+  p += 8;
+  /* Both the number of frames and the table of contents are needed */
+  if (!(flags & 0x01) || !(flags & 0x04))
+    {
+      return false;
+    }
+  frames = be32 (p);
+  p += 4;
+  if (flags & 0x02)
+    {
+      bytes = MIN (be32 (p), bytes);
+      p += 4;
+    }
+  if (0 == frames || 0 == bytes)
+    {
+      return false;
+    }
+
+  ap_idx->duration
+    = samples_to_us ((OMX_U64) frames * ap_hdr->samples, ap_hdr->rate);
+  for (i = 0; i < 100; ++i)
+    {
+      if (!add_entry (ap_idx, ap_idx->duration * i / 100,
+                      a_first + p[i] * bytes / 256))
+        {
+          return false;
+        }
+    }
+  ap_idx->interpolate = true;
+  return true;
+}
+
+static bool
+index_mp3_vbri (fr_seekidx_t * ap_idx, const OMX_U8 * ap_data,
+                const OMX_U64 a_first, const fr_mp3_hdr_t * ap_hdr)
+{
+  const OMX_U8 * p = ap_data + a_first + 4 + 32;
+  OMX_U32 frames = 0;
+  OMX_U32 nentries = 0;
+  OMX_U32 scale = 0;
+  OMX_U32 entry_size = 0;
+  OMX_U32 frames_per_entry = 0;
+  OMX_U64 offset = a_first;
+  OMX_U32 i = 0;
+
+  if (a_first + 4 + 32 + 26 > ap_idx->data_end || 0 != memcmp (p, "VBRI", 4))
+    {
+      return false;
+    }
+
+  frames = be32 (p + 14);
+  nentries = be16 (p + 18);
+  scale = be16 (p + 20);
+  entry_size = be16 (p + 22);
+  frames_per_entry = be16 (p + 24);
+  p += 26;
+
+  if (0 == frames || 0 == nentries || 0 == frames_per_entry || entry_size < 1
+      || entry_size > 4
+      || p + (OMX_U64) nentries * entry_size > ap_data + ap_idx->data_end)
+    {
+      return false;
+    }
+
+  ap_idx->duration
+    = samples_to_us ((OMX_U64) frames * ap_hdr->samples, ap_hdr->rate);
+  for (i = 0; i <= nentries; ++i)
+    {
+      const OMX_U64 frame = (OMX_U64) i * frames_per_entry;
+      if (frame >= frames)
+        {
+          break;
+        }
+      if (!add_entry (ap_idx,
+                      samples_to_us (frame * ap_hdr->samples, ap_hdr->rate),
+                      offset))
+        {
+          return false;
+        }
+      if (i < nentries)
+        {
+          OMX_U32 size = 0;
+          OMX_U32 j = 0;
+          for (j = 0; j < entry_size; ++j)
+            {
+              size = (size << 8) | p[j];
+            }
+          offset += (OMX_U64) size * scale;
+          p += entry_size;
+        }
+    }
+  ap_idx->interpolate = true;
+  return true;
+}
+
+static bool
+index_mp3_frames (fr_seekidx_t * ap_idx, const OMX_U8 * ap_data,
+                  OMX_U64 a_pos)
+{
+  fr_mp3_hdr_t hdr;
+  OMX_U64 samples = 0;
+  OMX_U32 rate = 0;
+  OMX_TICKS next = 0;
+
+  while ((a_pos = find_mp3_frame (ap_data, a_pos, ap_idx->data_end, &hdr))
+         < ap_idx->data_end)
+    {
+      if (0 == rate)
+        {
+          rate = hdr.rate;
+        }
+      /* Frames are contiguous; resync only when that stops being true */
+      do
+        {
+          const OMX_TICKS time = samples_to_us (samples, rate);
+          if (time >= next)
+            {
+              if (!add_entry (ap_idx, time, a_pos))
+                {
+                  return false;
+                }
+              next = time + FR_SEEKIDX_STEP_US;
+            }
+          samples += hdr.samples;
+          a_pos += hdr.len;
+        }
+      while (a_pos + 4 <= ap_idx->data_end
+             && parse_mp3_hdr (ap_data + a_pos, &hdr) && hdr.rate == rate);
+    }
+
+  ap_idx->duration = rate > 0 ? samples_to_us (samples, rate) : 0;
+  return ap_idx->nentries > 0;
+}
+
+static bool
+index_mp3 (fr_seekidx_t * ap_idx, const OMX_U8 * ap_data, const OMX_U64 a_len)
+{
+  fr_mp3_hdr_t hdr;
+  OMX_U64 first = 0;
+  const OMX_U64 start = skip_id3v2 (ap_data, a_len);
+
+  /* Other containers may well have something that looks like a couple of MP3
+     frames near the start */
+  if (a_len >= 4
+      && (0 == memcmp (ap_data, "RIFF", 4) || 0 == memcmp (ap_data, "OggS", 4)))
+    {
+      return false;
+    }
+
+  ap_idx->data_end = a_len;
+  if (a_len >= 128 && 0 == memcmp (ap_data + a_len - 128, "TAG", 3))
+    {
+      ap_idx->data_end -= 128;
+    }
+
+  /* The first frame must be close to the start, or this is not an MP3 file */
+  first = find_mp3_frame (ap_data, start, MIN (start + 64 * 1024,
+                                               ap_idx->data_end),
+                          &hdr);
+  if (first >= ap_idx->data_end || !is_mp3_frame (ap_data, first,
+                                                  ap_idx->data_end, &hdr))
+    {
+      return false;
+    }
+
+  return (index_mp3_xing (ap_idx, ap_data, first, &hdr)
+          || index_mp3_vbri (ap_idx, ap_data, first, &hdr)
+          || index_mp3_frames (ap_idx, ap_data, first));
+}
+
+/*
+ * FLAC
+ */
+
+typedef struct fr_flac_info fr_flac_info_t;
+struct fr_flac_info
+{
+  OMX_U32 rate;
+  OMX_U32 max_blocksize;
+  OMX_U32 min_framesize;
+  OMX_U64 total_samples;
+  OMX_U64 first_frame;
+  const OMX_U8 * p_seektable;
+  OMX_U32 npoints;
+};
+
+static OMX_U8
+crc8 (const OMX_U8 * p, size_t len)
+{
+  OMX_U8 crc = 0;
+  while (len--)
+    {
+      int i = 0;
+      crc ^= *p++;
+      for (i = 0; i < 8; ++i)
+        {
+          crc = (crc & 0x80) ? (OMX_U8) ((crc << 1) ^ 0x07) : (OMX_U8) (crc << 1);
+        }
+    }
+  return crc;
+}
+
+/* Parses a frame header, checking its CRC. Returns the header length, or 0 if
+   there is no frame header at this position */
+static size_t
+parse_flac_hdr (const OMX_U8 * p, const OMX_U64 a_avail,
+                const fr_flac_info_t * ap_info, OMX_U64 * ap_sample)
+{
+  OMX_U8 bs_code = 0;
+  OMX_U8 sr_code = 0;
+  OMX_U64 number = 0;
+  size_t len = 4;
+  size_t nbytes = 0;
+  size_t i = 0;
+
+  if (a_avail < 16 || 0xff != p[0] || 0xf8 != (p[1] & 0xfe))
+    {
+      return 0;
+    }
+
+  bs_code = p[2] >> 4;
+  sr_code = p[2] & 0x0f;
+  if (0 == bs_code || 15 == sr_code || (p[3] >> 4) > 10
+      || 3 == ((p[3] >> 1) & 0x07) || (p[3] & 0x01))
+    {
+      return 0;
+    }
+
+  /* The frame or sample number, UTF-8 coded */
+  if (!(p[4] & 0x80))
+    {
+      number = p[4];
+      nbytes = 1;
+    }
+  else
+    {
+      OMX_U8 mask = 0x40;
+      while ((p[4] & mask) && nbytes < 7)
+        {
+          mask >>= 1;
+          nbytes++;
+        }
+      if (nbytes < 1 || nbytes > 6)
+        {
+          return 0;
+        }
+      number = p[4] & (mask - 1);
+      for (i = 1; i <= nbytes; ++i)
+        {
+          if (0x80 != (p[4 + i] & 0xc0))
+            {
+              return 0;
+            }
+          number = (number << 6) | (p[4 + i] & 0x3f);
+        }
+      nbytes++;
+    }
+  len += nbytes;
+
+  /* Uncommon block sizes and sample rates follow */
+  len += (6 == bs_code ? 1 : 7 == bs_code ? 2 : 0);
+  len += (12 == sr_code ? 1 : (13 == sr_code || 14 == sr_code) ? 2 : 0);
+
+  if (crc8 (p, len) != p[len])
+    {
+      return 0;
+    }
+
+  /* With a fixed block size, the number is the frame number */
+  *ap_sample = (p[1] & 0x01) ? number : number * ap_info->max_blocksize;
+  return len + 1;
+}
+
+static bool
+parse_flac_metadata (const OMX_U8 * ap_data, const OMX_U64 a_len,
+                     fr_flac_info_t * ap_info)
+{
+  OMX_U64 pos = skip_id3v2 (ap_data, a_len);
+  bool last = false;
+
+  if (pos + 4 > a_len || 0 != memcmp (ap_data + pos, "fLaC", 4))
+    {
+      return false;
+    }
+  pos += 4;
+
+  while (!last && pos + 4 <= a_len)
+    {
+      const OMX_U8 type = ap_data[pos] & 0x7f;
+      const OMX_U32 len = be24 (ap_data + pos + 1);
+      const OMX_U8 * p = ap_data + pos + 4;
+
+      last = (ap_data[pos] & 0x80);
+      pos += 4 + len;
+      if (pos > a_len)
+        {
+          return false;
+        }
+
+      if (0 == type && len >= 34)
+        {
+          ap_info->max_blocksize = be16 (p + 2);
+          ap_info->min_framesize = be24 (p + 4);
+          ap_info->rate = (p[10] << 12) | (p[11] << 4) | (p[12] >> 4);
+          ap_info->total_samples
+            = ((OMX_U64) (p[13] & 0x0f) << 32) | be32 (p + 14);
+        }
+      else if (3 == type)
+        {
+          ap_info->p_seektable = p;
+          ap_info->npoints = len / 18;
+        }
+    }
+
+  ap_info->first_frame = pos;
+  return last && ap_info->rate > 0;
+}
+
+static bool
+index_flac_seektable (fr_seekidx_t * ap_idx, const fr_flac_info_t * ap_info)
+{
+  const OMX_U64 placeholder = ~((OMX_U64) 0);
+  OMX_TICKS prev = 0;
+  OMX_U32 i = 0;
+
+  if (!ap_info->p_seektable || 0 == ap_info->npoints
+      || 0 == ap_info->total_samples)
+    {
+      return false;
+    }
+
+  /* Sparse tables (e.g. the default of one point every 10 seconds) are too
+     coarse for short relative seeks */
+  for (i = 0; i < ap_info->npoints; ++i)
+    {
+      const OMX_U8 * p = ap_info->p_seektable + i * 18;
+      const OMX_U64 sample = be64 (p);
+      OMX_TICKS time = 0;
+      if (placeholder == sample)
+        {
+          break;
+        }
+      time = samples_to_us (sample, ap_info->rate);
+      if (time - prev > FR_SEEKIDX_MAX_GAP_US)
+        {
+          ap_idx->nentries = 0;
+          return false;
+        }
+      if (!add_entry (ap_idx, time, ap_info->first_frame + be64 (p + 8)))
+        {
+          return false;
+        }
+      prev = time;
+    }
+
+  if (ap_idx->nentries < 2 || ap_idx->duration - prev > FR_SEEKIDX_MAX_GAP_US)
+    {
+      ap_idx->nentries = 0;
+      return false;
+    }
+  return true;
+}
+
+static bool
+index_flac_frames (fr_seekidx_t * ap_idx, const OMX_U8 * ap_data,
+                   const fr_flac_info_t * ap_info)
+{
+  OMX_U64 pos = ap_info->first_frame;
+  OMX_U64 sample = 0;
+  OMX_U64 last_sample = 0;
+  OMX_TICKS next = 0;
+
+  while (pos + 16 <= ap_idx->data_end)
+    {
+      const OMX_U8 * p
+        = memchr (ap_data + pos, 0xff, (size_t) (ap_idx->data_end - pos - 1));
+      size_t hdr_len = 0;
+      if (!p)
+        {
+          break;
+        }
+      pos = p - ap_data;
+      if ((hdr_len = parse_flac_hdr (p, ap_idx->data_end - pos, ap_info,
+                                     &sample))
+          && sample >= last_sample)
+        {
+          const OMX_TICKS time = samples_to_us (sample, ap_info->rate);
+          if (time >= next)
+            {
+              if (!add_entry (ap_idx, time, pos))
+                {
+                  return false;
+                }
+              next = time + FR_SEEKIDX_STEP_US;
+            }
+          last_sample = sample;
+          /* No frame is shorter than this */
+          pos += MAX (hdr_len, ap_info->min_framesize);
+        }
+      else
+        {
+          pos++;
+        }
+    }
+
+  if (0 == ap_idx->duration)
+    {
+      ap_idx->duration = samples_to_us (last_sample + ap_info->max_blocksize,
+                                        ap_info->rate);
+    }
+  return ap_idx->nentries > 0;
+}
+
+static bool
+index_flac (fr_seekidx_t * ap_idx, const OMX_U8 * ap_data, const OMX_U64 a_len)
+{
+  fr_flac_info_t info;
+
+  memset (&info, 0, sizeof (info));
+  if (!parse_flac_metadata (ap_data, a_len, &info))
+    {
+      return false;
+    }
+
+  ap_idx->data_end = a_len;
+  ap_idx->duration = samples_to_us (info.total_samples, info.rate);
+
+  return (index_flac_seektable (ap_idx, &info)
+          || index_flac_frames (ap_idx, ap_data, &info));
+}
+
+/* Returns the last entry at or before the given time (or offset) */
+static size_t
+find_entry (const fr_seekidx_t * ap_idx, const OMX_TICKS a_time,
+            const OMX_U64 a_offset, const bool a_by_time)
+{
+  size_t lo = 0;
+  size_t hi = ap_idx->nentries;
+
+  assert (ap_idx->nentries > 0);
+
+  while (hi - lo > 1)
+    {
+      const size_t mid = lo + (hi - lo) / 2;
+      const fr_seekidx_entry_t * p_entry = &(ap_idx->p_entries[mid]);
+      if (a_by_time ? p_entry->time <= a_time : p_entry->offset <= a_offset)
+        {
+          lo = mid;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+  return lo;
+}
+
+/*
+ * API
+ */
+
+OMX_ERRORTYPE
+fr_seekidx_init (fr_seekidx_t ** app_idx, int a_fd, OMX_U64 a_file_len)
+{
+  fr_seekidx_t * p_idx = NULL;
+  OMX_U8 * p_data = NULL;
+  bool found = false;
+
+  assert (app_idx);
+  assert (a_fd >= 0);
+
+  if (0 == a_file_len || a_file_len > SIZE_MAX)
+    {
+      return OMX_ErrorFormatNotDetected;
+    }
+
+  /* A separate read-only mapping, so that the reader's own position and
+     (in mmap mode) its mapping are left untouched */
+  p_data = mmap (NULL, a_file_len, PROT_READ, MAP_PRIVATE, a_fd, 0);
+  if (MAP_FAILED == p_data)
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+  (void) madvise (p_data, a_file_len, MADV_SEQUENTIAL);
+
+  if (!(p_idx = tiz_mem_calloc (1, sizeof (fr_seekidx_t))))
+    {
+      (void) munmap (p_data, a_file_len);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  found = (index_flac (p_idx, p_data, a_file_len)
+           || index_mp3 (p_idx, p_data, a_file_len));
+
+  (void) munmap (p_data, a_file_len);
+
+  if (!found || 0 == p_idx->nentries)
+    {
+      fr_seekidx_destroy (p_idx);
+      return OMX_ErrorFormatNotDetected;
+    }
+
+  *app_idx = p_idx;
+  return OMX_ErrorNone;
+}
+
+void
+fr_seekidx_destroy (fr_seekidx_t * ap_idx)
+{
+  if (ap_idx)
+    {
+      tiz_mem_free (ap_idx->p_entries);
+      tiz_mem_free (ap_idx);
+    }
+}
+
+OMX_U64
+fr_seekidx_offset (const fr_seekidx_t * ap_idx, OMX_TICKS a_time,
+                   OMX_TICKS * ap_actual)
+{
+  const fr_seekidx_entry_t * p_entry = NULL;
+  OMX_U64 offset = 0;
+  size_t i = 0;
+
+  assert (ap_idx);
+
+  a_time = MAX (0, MIN (a_time, ap_idx->duration));
+  i = find_entry (ap_idx, a_time, 0, true);
+  p_entry = &(ap_idx->p_entries[i]);
+  offset = p_entry->offset;
+
+  if (!ap_idx->interpolate)
+    {
+      a_time = p_entry->time;
+    }
+  else
+    {
+      const OMX_TICKS t1 = i + 1 < ap_idx->nentries
+                             ? ap_idx->p_entries[i + 1].time
+                             : ap_idx->duration;
+      const OMX_U64 o1 = i + 1 < ap_idx->nentries
+                           ? ap_idx->p_entries[i + 1].offset
+                           : ap_idx->data_end;
+      if (t1 > p_entry->time && o1 > offset)
+        {
+          offset += (OMX_U64) ((double) (o1 - offset) * (a_time - p_entry->time)
+                               / (t1 - p_entry->time));
+        }
+    }
+
+  if (ap_actual)
+    {
+      *ap_actual = a_time;
+    }
+  return offset;
+}
+
+OMX_TICKS
+fr_seekidx_time (const fr_seekidx_t * ap_idx, OMX_U64 a_offset)
+{
+  const fr_seekidx_entry_t * p_entry = NULL;
+  OMX_TICKS t1 = 0;
+  OMX_U64 o1 = 0;
+  size_t i = 0;
+
+  assert (ap_idx);
+
+  if (a_offset >= ap_idx->data_end)
+    {
+      return ap_idx->duration;
+    }
+
+  i = find_entry (ap_idx, 0, a_offset, false);
+  p_entry = &(ap_idx->p_entries[i]);
+  if (a_offset <= p_entry->offset)
+    {
+      return p_entry->time;
+    }
+
+  t1 = i + 1 < ap_idx->nentries ? ap_idx->p_entries[i + 1].time
+                                : ap_idx->duration;
+  o1 = i + 1 < ap_idx->nentries ? ap_idx->p_entries[i + 1].offset
+                                : ap_idx->data_end;
+  if (o1 <= p_entry->offset || t1 <= p_entry->time)
+    {
+      return p_entry->time;
+    }
+  return p_entry->time
+         + (OMX_TICKS) ((double) (t1 - p_entry->time)
+                        * (a_offset - p_entry->offset)
+                        / (o1 - p_entry->offset));
+}
+
+OMX_TICKS
+fr_seekidx_duration (const fr_seekidx_t * ap_idx)
+{
+  assert (ap_idx);
+  return ap_idx->duration;
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   frseekidx.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief Tizonia - Binary file reader's time to byte offset index
+ *
+ *
+ */
+
+#ifndef FRSEEKIDX_H
+#define FRSEEKIDX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+typedef struct fr_seekidx fr_seekidx_t;
+
+/**
+ * Build the seek index of an MP3 or FLAC file. The index is taken from the
+ * Xing/VBRI header of an MP3 file or the SEEKTABLE block of a FLAC file, when
+ * they are good enough; otherwise the file's frames are scanned.
+ *
+ * @param app_idx The new index (output).
+ * @param a_fd The file descriptor of the file (its position is not modified).
+ * @param a_file_len The size of the file in bytes.
+ *
+ * @return OMX_ErrorNone, OMX_ErrorFormatNotDetected if the file is neither
+ * MP3 nor FLAC, or OMX_ErrorInsufficientResources.
+ */
+OMX_ERRORTYPE
+fr_seekidx_init (fr_seekidx_t ** app_idx, int a_fd, OMX_U64 a_file_len);
+
+void
+fr_seekidx_destroy (fr_seekidx_t * ap_idx);
+
+/**
+ * The byte offset where decoding must resume to play from a given time.
+ *
+ * @param ap_idx The index.
+ * @param a_time The media time, in microseconds.
+ * @param ap_actual The media time at the returned offset (optional output).
+ *
+ * @return The byte offset.
+ */
+OMX_U64
+fr_seekidx_offset (const fr_seekidx_t * ap_idx, OMX_TICKS a_time,
+                   OMX_TICKS * ap_actual);
+
+/**
+ * The media time, in microseconds, of a given byte offset.
+ */
+OMX_TICKS
+fr_seekidx_time (const fr_seekidx_t * ap_idx, OMX_U64 a_offset);
+
+/**
+ * The duration of the stream, in microseconds.
+ */
+OMX_TICKS
+fr_seekidx_duration (const fr_seekidx_t * ap_idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRSEEKIDX_H */
@@ -48,6 +48,11 @@ extern "C" {
 #define ARATELIA_FILE_WRITER_PORT_ALIGNMENT 0
 #define ARATELIA_FILE_WRITER_PORT_SUPPLIERPREF OMX_BufferSupplyInput
 
+/* Config file key to set the number of asynchronous writes kept in flight (0
+   means synchronous writes) */
+#define ARATELIA_FILE_WRITER_AIO_DEPTH_KEY \
+  "OMX.Aratelia.file_writer.binary.aio_depth"
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
@@ -52,6 +53,90 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.file_writer.prc"
 #endif
 
+/* aio mode: number of I/O threads and maximum number of writes in flight */
+#define FW_AIO_THREADS 2
+#define FW_AIO_MAX_DEPTH 64
+
+/* Maximum number of buffers written per call in synchronous mode */
+#define FW_MAX_BATCH 16
+
+static inline OMX_ERRORTYPE
+start_io_watcher (fw_prc_t * ap_prc)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (ap_prc);
+  assert (ap_prc->p_ev_io_);
+  if (!ap_prc->awaiting_io_ev_)
+    {
+      rc = tiz_srv_io_watcher_start (ap_prc, ap_prc->p_ev_io_);
+    }
+  ap_prc->awaiting_io_ev_ = true;
+  return rc;
+}
+
+static inline void
+stop_io_watcher (fw_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->p_ev_io_ && ap_prc->awaiting_io_ev_)
+    {
+      (void) tiz_srv_io_watcher_stop (ap_prc, ap_prc->p_ev_io_);
+    }
+  ap_prc->awaiting_io_ev_ = false;
+}
+
+static OMX_ERRORTYPE
+setup_aio (fw_prc_t * ap_prc)
+{
+  const char * p_depth = NULL;
+
+  assert (ap_prc);
+  assert (ap_prc->p_file_);
+  assert (!ap_prc->p_aio_);
+
+  /* The file has just been (re)created; writes start from its beginning */
+  ap_prc->nsubmitted_ = 0;
+  ap_prc->write_offset_ = 0;
+
+  p_depth = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                                  ARATELIA_FILE_WRITER_AIO_DEPTH_KEY);
+  ap_prc->aio_depth_ = p_depth ? strtoul (p_depth, NULL, 10) : 0;
+  ap_prc->aio_depth_ = MIN (ap_prc->aio_depth_, FW_AIO_MAX_DEPTH);
+  if (0 == ap_prc->aio_depth_)
+    {
+      return OMX_ErrorNone;
+    }
+
+  tiz_check_omx (
+    tiz_aio_init (&(ap_prc->p_aio_), FW_AIO_THREADS, ap_prc->aio_depth_));
+  tiz_check_null_ret_oom (
+    ap_prc->p_reqs_
+    = tiz_mem_calloc (ap_prc->aio_depth_, sizeof (tiz_aio_req_t)));
+  tiz_check_omx (tiz_srv_io_watcher_init (ap_prc, &(ap_prc->p_ev_io_),
+                                          tiz_aio_get_fd (ap_prc->p_aio_),
+                                          TIZ_EVENT_READ, true));
+  TIZ_NOTICE (handleOf (ap_prc), "Async writes - depth [%u]",
+              ap_prc->aio_depth_);
+  return OMX_ErrorNone;
+}
+
+static void
+teardown_aio (fw_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  stop_io_watcher (ap_prc);
+  if (ap_prc->p_ev_io_)
+    {
+      tiz_srv_io_watcher_destroy (ap_prc, ap_prc->p_ev_io_);
+      ap_prc->p_ev_io_ = NULL;
+    }
+  /* Lets the writes being carried out finish, and joins the I/O threads */
+  tiz_aio_destroy (ap_prc->p_aio_);
+  ap_prc->p_aio_ = NULL;
+  tiz_mem_free (ap_prc->p_reqs_);
+  ap_prc->p_reqs_ = NULL;
+}
+
 static OMX_ERRORTYPE
 obtain_uri (fw_prc_t * ap_prc)
 {
@@ -108,6 +193,13 @@ fw_proc_ctor (void * ap_obj, va_list * app)
   p_prc->p_uri_param_ = NULL;
   p_prc->counter_ = 0;
   p_prc->eos_ = false;
+  p_prc->p_aio_ = NULL;
+  p_prc->p_reqs_ = NULL;
+  p_prc->p_ev_io_ = NULL;
+  p_prc->awaiting_io_ev_ = false;
+  p_prc->aio_depth_ = 0;
+  p_prc->nsubmitted_ = 0;
+  p_prc->write_offset_ = 0;
   return p_prc;
 }
 
@@ -117,6 +209,8 @@ fw_proc_dtor (void * ap_obj)
   fw_prc_t * p_prc = ap_obj;
   assert (p_prc);
 
+  teardown_aio (p_prc);
+
   if (p_prc->p_file_)
     {
       fclose (p_prc->p_file_);
@@ -161,6 +255,113 @@ fw_proc_write_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+submit_writes (fw_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+
+  assert (ap_prc);
+  assert (ap_prc->p_aio_);
+
+  while (!tiz_aio_is_full (ap_prc->p_aio_))
+    {
+      tiz_aio_req_t * p_req = NULL;
+      tiz_check_omx (tiz_krn_claim_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                           ARATELIA_FILE_WRITER_PORT_INDEX, 0,
+                                           &p_hdr));
+      if (!p_hdr)
+        {
+          break;
+        }
+
+      /* Empty buffers are submitted too, so that EOS is seen in order.
+         Requests are reaped in submission order, so slots are reused in the
+         same order */
+      p_req = &(ap_prc->p_reqs_[ap_prc->nsubmitted_++ % ap_prc->aio_depth_]);
+      p_req->op = ETIZAioOpWrite;
+      p_req->fd = fileno (ap_prc->p_file_);
+      p_req->offset = ap_prc->write_offset_;
+      p_req->p_buf = p_hdr->pBuffer + p_hdr->nOffset;
+      p_req->len = p_hdr->nFilledLen;
+      p_req->p_data = p_hdr;
+      tiz_check_omx (tiz_aio_submit (ap_prc->p_aio_, p_req));
+      ap_prc->write_offset_ += p_req->len;
+
+      TIZ_TRACE (handleOf (ap_prc), "Submitted HEADER [%p] offset [%llu]",
+                 p_hdr, (unsigned long long) p_req->offset);
+    }
+
+  if (tiz_aio_pending (ap_prc->p_aio_) > 0)
+    {
+      return start_io_watcher (ap_prc);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+complete_write (fw_prc_t * ap_prc, tiz_aio_req_t * ap_req)
+{
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+  assert (ap_req);
+
+  p_hdr = ap_req->p_data;
+  assert (p_hdr);
+
+  if (ap_req->result < 0 || (size_t) ap_req->result != ap_req->len)
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "written [%ld] nFilledLen [%d]: "
+                 "An error occurred while writing (%s)",
+                 (long) ap_req->result, p_hdr->nFilledLen,
+                 strerror (ap_req->error));
+      rc = OMX_ErrorInsufficientResources;
+    }
+  else
+    {
+      ap_prc->counter_ += ap_req->result;
+      TIZ_TRACE (handleOf (ap_prc),
+                 "Completed HEADER [%p]...nFilledLen [%d] counter [%d]", p_hdr,
+                 p_hdr->nFilledLen, ap_prc->counter_);
+      if (p_hdr->nFlags & OMX_BUFFERFLAG_EOS)
+        {
+          TIZ_DEBUG (handleOf (ap_prc), "OMX_BUFFERFLAG_EOS in HEADER [%p]",
+                     p_hdr);
+          tiz_srv_issue_event ((OMX_PTR) ap_prc, OMX_EventBufferFlag,
+                               ARATELIA_FILE_WRITER_PORT_INDEX, p_hdr->nFlags,
+                               NULL);
+        }
+    }
+
+  p_hdr->nFilledLen = 0;
+  tiz_check_omx (tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                         ARATELIA_FILE_WRITER_PORT_INDEX,
+                                         p_hdr));
+  return rc;
+}
+
+static OMX_ERRORTYPE
+complete_pending_writes (fw_prc_t * ap_prc)
+{
+  tiz_aio_req_t * p_req = NULL;
+
+  assert (ap_prc);
+
+  if (ap_prc->p_aio_)
+    {
+      /* Data already accepted is not discarded */
+      stop_io_watcher (ap_prc);
+      tiz_aio_drain (ap_prc->p_aio_);
+      while ((p_req = tiz_aio_reap (ap_prc->p_aio_)))
+        {
+          tiz_check_omx (complete_write (ap_prc, p_req));
+        }
+    }
+  return OMX_ErrorNone;
+}
+
 /*
  * from tiz_srv class
  */
@@ -182,7 +383,7 @@ fw_proc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
       return OMX_ErrorInsufficientResources;
     }
 
-  return OMX_ErrorNone;
+  return setup_aio (p_prc);
 }
 
 static OMX_ERRORTYPE
@@ -191,6 +392,8 @@ fw_proc_deallocate_resources (void * ap_obj)
   fw_prc_t * p_prc = ap_obj;
   assert (ap_obj);
 
+  teardown_aio (p_prc);
+
   if (p_prc->p_file_)
     {
       fclose (p_prc->p_file_);
@@ -226,7 +429,7 @@ fw_proc_transfer_and_process (void * ap_obj, OMX_U32 a_pid)
 static OMX_ERRORTYPE
 fw_proc_stop_and_return (void * ap_obj)
 {
-  return OMX_ErrorNone;
+  return complete_pending_writes (ap_obj);
 }
 
 /*
@@ -238,17 +441,28 @@ fw_proc_buffers_ready (const void * ap_obj)
 {
   const fw_prc_t * p_prc = ap_obj;
 
+  if (p_prc->p_aio_)
+    {
+      return submit_writes ((fw_prc_t *) p_prc);
+    }
+
   if (!p_prc->eos_)
     {
-      OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-      tiz_check_omx (tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)),
-                                               ARATELIA_FILE_WRITER_PORT_INDEX,
-                                               0, &p_hdr));
-      if (p_hdr)
+      /* Write all the buffers available, and return them in one go */
+      OMX_BUFFERHEADERTYPE * hdrs[FW_MAX_BATCH];
+      OMX_U32 nhdrs = 0;
+      OMX_U32 i = 0;
+      OMX_ERRORTYPE rc = OMX_ErrorNone;
+      OMX_ERRORTYPE release_rc = OMX_ErrorNone;
+      rc = tiz_krn_claim_buffers (tiz_get_krn (handleOf (p_prc)),
+                                  ARATELIA_FILE_WRITER_PORT_INDEX, hdrs,
+                                  FW_MAX_BATCH, &nhdrs);
+      for (i = 0; i < nhdrs && OMX_ErrorNone == rc; ++i)
         {
+          OMX_BUFFERHEADERTYPE * p_hdr = hdrs[i];
           TIZ_TRACE (handleOf (p_prc), "Claimed HEADER [%p]...", p_hdr);
-          tiz_check_omx (fw_proc_write_buffer (p_prc, p_hdr));
-          if (p_hdr->nFlags & OMX_BUFFERFLAG_EOS)
+          rc = fw_proc_write_buffer (p_prc, p_hdr);
+          if (OMX_ErrorNone == rc && (p_hdr->nFlags & OMX_BUFFERFLAG_EOS))
             {
               TIZ_DEBUG (handleOf (p_prc), "OMX_BUFFERFLAG_EOS in HEADER [%p]",
                          p_hdr);
@@ -256,15 +470,52 @@ fw_proc_buffers_ready (const void * ap_obj)
                                    ARATELIA_FILE_WRITER_PORT_INDEX,
                                    p_hdr->nFlags, NULL);
             }
-          tiz_check_omx (
-            tiz_krn_release_buffer (tiz_get_krn (handleOf (p_prc)),
-                                    ARATELIA_FILE_WRITER_PORT_INDEX, p_hdr));
         }
+      /* All the headers claimed go back, even after a failed claim or write;
+         otherwise the port would never be able to leave Executing */
+      release_rc = tiz_krn_release_buffers (tiz_get_krn (handleOf (p_prc)),
+                                            ARATELIA_FILE_WRITER_PORT_INDEX,
+                                            hdrs, nhdrs);
+      tiz_check_omx (rc);
+      tiz_check_omx (release_rc);
     }
 
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+fw_proc_io_ready (void * ap_obj, tiz_event_io_t * ap_ev_io, int a_fd,
+                  int a_events)
+{
+  fw_prc_t * p_prc = ap_obj;
+  tiz_aio_req_t * p_req = NULL;
+
+  assert (p_prc);
+
+  p_prc->awaiting_io_ev_ = false;
+  if (p_prc->p_aio_)
+    {
+      while ((p_req = tiz_aio_reap (p_prc->p_aio_)))
+        {
+          tiz_check_omx (complete_write (p_prc, p_req));
+        }
+      tiz_check_omx (submit_writes (p_prc));
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+fw_proc_port_flush (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
+{
+  return complete_pending_writes ((fw_prc_t *) ap_obj);
+}
+
+static OMX_ERRORTYPE
+fw_proc_port_disable (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
+{
+  return complete_pending_writes ((fw_prc_t *) ap_obj);
+}
+
 /*
  * fw_prc_class
  */
@@ -323,6 +574,12 @@ fw_prc_init (void * ap_tos, void * ap_hdl)
      tiz_srv_stop_and_return, fw_proc_stop_and_return,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, fw_proc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_io_ready, fw_proc_io_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_flush, fw_proc_port_flush,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_disable, fw_proc_port_disable,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
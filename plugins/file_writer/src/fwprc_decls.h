@@ -35,6 +35,8 @@ extern "C" {
 
 #include <stdbool.h>
 
+#include <tizplatform.h>
+
 #include "fwprc.h"
 #include "tizprc_decls.h"
 
@@ -47,6 +49,14 @@ struct fw_prc
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   OMX_U32 counter_;
   bool eos_;
+  /* aio mode */
+  tiz_aio_t * p_aio_;
+  tiz_aio_req_t * p_reqs_;
+  tiz_event_io_t * p_ev_io_;
+  bool awaiting_io_ev_;
+  OMX_U32 aio_depth_;
+  OMX_U32 nsubmitted_;
+  OMX_U64 write_offset_;
 };
 
 typedef struct fw_prc_class fw_prc_class_t;
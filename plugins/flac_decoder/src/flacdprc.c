@@ -47,6 +47,10 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.flac_decoder.prc"
 #endif
 
+/* The output carry-over store must be able to hold the largest possible
+   FLAC block (output samples are at most 4 bytes wide) */
+#define FLACD_SPILL_MIN_SIZE (FLAC__MAX_BLOCK_SIZE * FLAC__MAX_CHANNELS * 4)
+
 /* Forward declarations */
 static OMX_ERRORTYPE
 flacd_prc_deallocate_resources (void *);
@@ -83,6 +87,43 @@ dealloc_temp_data_store (/*@special@ */ flacd_prc_t * ap_prc)
   ap_prc->store_offset_ = 0;
 }
 
+static OMX_ERRORTYPE
+alloc_spill (flacd_prc_t * ap_prc)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  TIZ_INIT_OMX_PORT_STRUCT (port_def, ARATELIA_FLAC_DECODER_OUTPUT_PORT_INDEX);
+
+  assert (ap_prc);
+  assert (!ap_prc->p_spill_);
+
+  tiz_check_omx (
+    tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
+                          OMX_IndexParamPortDefinition, &port_def));
+  /* The unit (the PCM frame size) is set as frames are decoded */
+  return tiz_filter_spill_init (
+    &(ap_prc->p_spill_), MAX (port_def.nBufferSize, FLACD_SPILL_MIN_SIZE), 1);
+}
+
+static void
+dealloc_spill (flacd_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->p_spill_)
+    {
+      tiz_filter_spill_stats_t stats;
+      tiz_filter_spill_get_stats (ap_prc->p_spill_, &stats);
+      TIZ_DEBUG (handleOf (ap_prc),
+                 "spill : capacity [%zu] high water [%zu] carry-overs [%u] "
+                 "spilled [%llu] drained [%llu] dropped [%llu]",
+                 stats.capacity, stats.high_water, stats.nspills,
+                 (unsigned long long) stats.nbytes_spilled,
+                 (unsigned long long) stats.nbytes_drained,
+                 (unsigned long long) stats.nbytes_dropped);
+      tiz_filter_spill_destroy (ap_prc->p_spill_);
+      ap_prc->p_spill_ = NULL;
+    }
+}
+
 static inline OMX_U8 **
 get_store_ptr (flacd_prc_t * ap_prc)
 {
@@ -198,6 +239,35 @@ release_header (flacd_prc_t * ap_prc, const OMX_U32 a_pid)
   *pp_hdr = NULL;
 }
 
+static void
+release_output_header (flacd_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_out = ap_prc->p_out_hdr_;
+  assert (p_out);
+  if (ap_prc->eos_ && 0 == ap_prc->store_offset_
+      && 0 == tiz_filter_spill_available (ap_prc->p_spill_))
+    {
+      /* Propagate EOS flag to output */
+      p_out->nFlags |= OMX_BUFFERFLAG_EOS;
+      ap_prc->eos_ = false;
+    }
+  release_header (ap_prc, ARATELIA_FLAC_DECODER_OUTPUT_PORT_INDEX);
+}
+
+static void
+drain_spill (flacd_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_out = NULL;
+  assert (ap_prc);
+  while (tiz_filter_spill_available (ap_prc->p_spill_) > 0
+         && (p_out = get_header (ap_prc,
+                                 ARATELIA_FLAC_DECODER_OUTPUT_PORT_INDEX)))
+    {
+      (void) tiz_filter_spill_scatter (ap_prc->p_spill_, &p_out, 1, NULL, 0);
+      release_output_header (ap_prc);
+    }
+}
+
 static int
 store_data (flacd_prc_t * ap_prc, const OMX_U8 * ap_data, OMX_U32 a_nbytes)
 {
@@ -318,6 +388,10 @@ static inline OMX_ERRORTYPE
 do_flush (flacd_prc_t * ap_prc)
 {
   TIZ_TRACE (handleOf (ap_prc), "do_flush");
+  if (ap_prc->p_spill_)
+    {
+      tiz_filter_spill_clear (ap_prc->p_spill_);
+    }
   /* Release any buffers held  */
   return release_all_headers (ap_prc, OMX_ALL);
 }
@@ -332,10 +406,13 @@ transform_stream (const flacd_prc_t * ap_prc)
   assert (p_prc);
   assert (p_prc->p_flac_dec_);
 
+  /* Decoded PCM carried over from the previous run goes out first */
+  drain_spill (p_prc);
+
   TIZ_TRACE (handleOf (ap_prc), "output buffers avail [%s]",
              output_buffers_available (p_prc) ? "YES" : "NO");
-  while (decode_ok > 0 && input_data_available (p_prc)
-         && output_buffers_available (p_prc))
+  while (decode_ok > 0 && 0 == tiz_filter_spill_available (p_prc->p_spill_)
+         && input_data_available (p_prc) && output_buffers_available (p_prc))
     {
       TIZ_TRACE (handleOf (ap_prc), "decoding");
       decode_ok = FLAC__stream_decoder_process_single (p_prc->p_flac_dec_);
@@ -348,6 +425,7 @@ transform_stream (const flacd_prc_t * ap_prc)
           rc = OMX_ErrorStreamCorrupt;
           break;
         }
+      drain_spill (p_prc);
     }
 
   return rc;
@@ -422,60 +500,72 @@ read_cb (const FLAC__StreamDecoder * ap_decoder, FLAC__byte buffer[],
   return rc;
 }
 
-static void
-write_pcm_block_8 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
-                   const unsigned int a_nsamples,
-                   const unsigned int a_nchannels)
+static inline tiz_pcm_fmt_t
+output_fmt (const unsigned int a_bps)
 {
-  size_t i = 0;
-  size_t j = 0;
-  for (i = 0; i < a_nsamples; i += 2, ++j)
-    {
-      FLAC__int8 * out = (FLAC__int8 *) (ap_to) + i;
-      int k;
-      for (k = 0; k < a_nchannels; ++k)
-        {
-          out[k] = (FLAC__int8) ap_buffer[k][j];
-        }
-    }
+  /* Samples go out in the smallest container that the renderers know:
+     8 and 12-bit streams become 16-bit, 20-bit streams 24-bit, and 32-bit
+     streams float (see the pcm renderers) */
+  return a_bps <= 16 ? ETIZPcmFmtS16
+                     : (a_bps <= 24 ? ETIZPcmFmtS24 : ETIZPcmFmtF32);
 }
 
 static void
-write_pcm_block_16 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
-                    const unsigned int a_nsamples,
-                    const unsigned int a_nchannels)
-{
-  size_t i = 0;
-  size_t j = 0;
-  for (i = 0; i < a_nsamples; i += 2, ++j)
+set_channel_mapping (OMX_AUDIO_CHANNELTYPE * ap_map, const unsigned int a_nch)
+{
+  /* FLAC's channel order (which is also WAVEFORMATEXTENSIBLE's) */
+  static const OMX_AUDIO_CHANNELTYPE maps[FLAC__MAX_CHANNELS]
+                                         [FLAC__MAX_CHANNELS]
+    = {{OMX_AUDIO_ChannelCF},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelLR,
+        OMX_AUDIO_ChannelRR},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLFE, OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLFE, OMX_AUDIO_ChannelCS, OMX_AUDIO_ChannelLS,
+        OMX_AUDIO_ChannelRS},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLFE, OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR,
+        OMX_AUDIO_ChannelLS, OMX_AUDIO_ChannelRS}};
+  unsigned int i = 0;
+  assert (ap_map);
+  assert (a_nch > 0 && a_nch <= FLAC__MAX_CHANNELS);
+  for (i = 0; i < OMX_AUDIO_MAXCHANNELS; ++i)
     {
-      FLAC__int16 * out = (FLAC__int16 *) (ap_to) + i;
-      int k;
-      for (k = 0; k < a_nchannels; ++k)
-        {
-          out[k] = (FLAC__int16) ap_buffer[k][j];
-        }
+      ap_map[i] = i < a_nch ? maps[a_nch - 1][i] : OMX_AUDIO_ChannelNone;
     }
 }
 
 static void
-write_pcm_block_24 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
-                    const unsigned int a_nsamples,
-                    const unsigned int a_nchannels)
+update_pcm_mode (flacd_prc_t * ap_prc)
 {
-  size_t i = 0;
-  size_t j = 0;
-  for (i = 0; i < a_nsamples; i += 2, ++j)
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmmode;
+  assert (ap_prc);
+
+  TIZ_INIT_OMX_PORT_STRUCT (pcmmode, ARATELIA_FLAC_DECODER_OUTPUT_PORT_INDEX);
+  if (OMX_ErrorNone
+      == tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)),
+                               handleOf (ap_prc), OMX_IndexParamAudioPcm,
+                               &pcmmode))
     {
-      unsigned char * out = (unsigned char *) (ap_to) + (i * 3);
-      int k;
-      for (k = 0; k < a_nchannels; ++k)
-        {
-          unsigned long word32 = (unsigned long) ap_buffer[k][j];
-          *out++ = (unsigned char) (word32 >> 0);
-          *out++ = (unsigned char) (word32 >> 8);
-          *out++ = (unsigned char) (word32 >> 16);
-        }
+      pcmmode.nChannels = ap_prc->channels_;
+      pcmmode.nSamplingRate = ap_prc->sample_rate_;
+      pcmmode.nBitPerSample
+        = tiz_pcm_fmt_size (output_fmt (ap_prc->bps_)) * 8;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      pcmmode.eEndian = OMX_EndianBig;
+#else
+      pcmmode.eEndian = OMX_EndianLittle;
+#endif
+      pcmmode.bInterleaved = OMX_TRUE;
+      set_channel_mapping (pcmmode.eChannelMapping, ap_prc->channels_);
+      (void) tiz_krn_SetParameter_internal (
+        tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
+        OMX_IndexParamAudioPcm, &pcmmode);
     }
 }
 
@@ -496,69 +586,66 @@ write_cb (const FLAC__StreamDecoder * ap_decoder, const FLAC__Frame * ap_frame,
              ap_frame->header.blocksize, ap_frame->header.channels,
              ap_frame->header.bits_per_sample);
 
-  if (p_prc->channels_ > 2 || (ap_frame->header.bits_per_sample != 8
-                               && ap_frame->header.bits_per_sample != 16
-                               && ap_frame->header.bits_per_sample != 24))
+  if (0 == ap_frame->header.channels
+      || ap_frame->header.channels > FLAC__MAX_CHANNELS
+      || 0 == ap_frame->header.bits_per_sample
+      || ap_frame->header.bits_per_sample > 32)
     {
       TIZ_ERROR (handleOf (p_prc),
-                 "Only stereo streams are supported"
-                 "at 8, 16, or 24 bits per sample.");
+                 "Unsupported frame : [%u] channels [%u] bits per sample.",
+                 ap_frame->header.channels, ap_frame->header.bits_per_sample);
       /* TODO: Signal client */
       rc = FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
     }
   else
     {
       /* write decoded PCM samples */
-      size_t nsamples = ap_frame->header.blocksize * p_prc->channels_;
+      const unsigned int nchannels = ap_frame->header.channels;
+      const unsigned int bps = ap_frame->header.bits_per_sample;
+      const tiz_pcm_fmt_t fmt = output_fmt (bps);
+      const size_t frame_len = nchannels * tiz_pcm_fmt_size (fmt);
+      const size_t nframes = ap_frame->header.blocksize;
+      size_t nframes_out = 0;
       OMX_BUFFERHEADERTYPE * p_out
         = get_header (p_prc, ARATELIA_FLAC_DECODER_OUTPUT_PORT_INDEX);
-      assert (p_out);
 
-      if (nsamples * (p_prc->bps_ / 8) > p_out->nAllocLen)
+      tiz_filter_spill_set_unit (p_prc->p_spill_, frame_len);
+
+      if (p_out)
         {
-          nsamples = p_out->nAllocLen / (p_prc->bps_ / 8);
+          /* Anything carried over goes first */
+          (void) tiz_filter_spill_scatter (p_prc->p_spill_, &p_out, 1, NULL,
+                                           0);
+          if (0 == tiz_filter_spill_available (p_prc->p_spill_))
+            {
+              nframes_out
+                = MIN (nframes, TIZ_OMX_BUF_AVAIL (p_out) / frame_len);
+              tiz_pcm_interleave_s32 (
+                TIZ_OMX_BUF_PTR (p_out) + p_out->nFilledLen, fmt, ap_buffer,
+                nchannels, 0, nframes_out, bps);
+              p_out->nFilledLen += nframes_out * frame_len;
+            }
         }
-      assert (nsamples <= p_out->nAllocLen);
 
-      {
-        uint8_t * p_to = p_out->pBuffer + p_out->nOffset;
-
-        switch (ap_frame->header.bits_per_sample)
-          {
-            case 8:
-              {
-                write_pcm_block_8 (p_to, ap_buffer, nsamples,
-                                   ap_frame->header.channels);
-              }
-              break;
-            case 16:
-              {
-                write_pcm_block_16 (p_to, ap_buffer, nsamples,
-                                    ap_frame->header.channels);
-              }
-              break;
-            case 24:
-              {
-                write_pcm_block_24 (p_to, ap_buffer, nsamples,
-                                    ap_frame->header.channels);
-              }
-              break;
-            default:
-              {
-                assert (0);
-              }
-              break;
-          };
-
-        p_out->nFilledLen = nsamples * (p_prc->bps_ / 8);
-        if ((p_prc->eos_ && p_prc->store_offset_ == 0))
-          {
-            /* Propagate EOS flag to output */
-            p_out->nFlags |= OMX_BUFFERFLAG_EOS;
-            p_prc->eos_ = false;
-          }
-        release_header (p_prc, ARATELIA_FLAC_DECODER_OUTPUT_PORT_INDEX);
-      }
+      if (nframes_out < nframes)
+        {
+          /* Interleave the rest straight into the carry-over store, until an
+           * omx buffer is available */
+          size_t avail = 0;
+          void * p_span = tiz_filter_spill_reserve (
+            p_prc->p_spill_, (nframes - nframes_out) * frame_len, &avail);
+          if (p_span)
+            {
+              tiz_pcm_interleave_s32 (p_span, fmt, ap_buffer, nchannels,
+                                      nframes_out, avail / frame_len, bps);
+              (void) tiz_filter_spill_commit (p_prc->p_spill_, avail);
+            }
+        }
+
+      if (p_out)
+        {
+          release_output_header (p_prc);
+        }
     }
 
   return rc;
@@ -588,6 +675,10 @@ metadata_cb (const FLAC__StreamDecoder * ap_decoder,
       TIZ_TRACE (handleOf (p_prc), "bits per sample : [%u]", p_prc->bps_);
       TIZ_TRACE (handleOf (p_prc), "total samples   : [%llu]",
                  p_prc->total_samples_);
+      if (p_prc->channels_ > 0 && p_prc->channels_ <= FLAC__MAX_CHANNELS)
+        {
+          update_pcm_mode (p_prc);
+        }
     }
 }
 
@@ -630,6 +721,7 @@ flacd_prc_ctor (void * ap_obj, va_list * app)
   p_prc->p_store_ = NULL;
   p_prc->store_offset_ = 0;
   p_prc->store_size_ = 0;
+  p_prc->p_spill_ = NULL;
   reset_stream_parameters (p_prc);
   return p_prc;
 }
@@ -652,6 +744,7 @@ flacd_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
   assert (p_prc);
 
   tiz_check_omx (alloc_temp_data_store (p_prc));
+  tiz_check_omx (alloc_spill (p_prc));
 
   if (NULL == (p_prc->p_flac_dec_ = FLAC__stream_decoder_new ()))
     {
@@ -675,6 +768,7 @@ flacd_prc_deallocate_resources (void * ap_obj)
       p_prc->p_flac_dec_ = NULL;
     }
   dealloc_temp_data_store (p_prc);
+  dealloc_spill (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -705,6 +799,7 @@ flacd_prc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
 
   reset_stream_parameters (p_prc);
   p_prc->store_offset_ = 0;
+  tiz_filter_spill_clear (p_prc->p_spill_);
   return OMX_ErrorNone;
 }
 
@@ -37,6 +37,7 @@ extern "C" {
 #include <FLAC/all.h> /* flac header */
 
 #include "tizprc_decls.h"
+#include "tizfilterprc.h"
 
 typedef struct flacd_prc flacd_prc_t;
 struct flacd_prc
@@ -56,6 +57,7 @@ struct flacd_prc
   OMX_U8 * p_store_;
   OMX_U32 store_offset_;
   OMX_U32 store_size_;
+  tiz_filter_spill_t * p_spill_;
 };
 
 typedef struct flacd_prc_class flacd_prc_class_t;
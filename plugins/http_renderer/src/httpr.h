@@ -52,12 +52,26 @@ extern "C" {
 #define ICE_INITIAL_BURST_SIZE 128000
 #define ICE_MAX_CLIENTS_PER_MOUNTPOINT 10
 #define ICE_DEFAULT_HEADER_TIMEOUT 10
-#define ICE_LISTEN_QUEUE 5
+#define ICE_LISTEN_QUEUE 64
 #define ICE_MIN_BURST_SIZE 1400
 #define ICE_MEDIUM_BURST_SIZE 2800 /* Not used for now */
 #define ICE_MAX_BURST_SIZE 4200    /* Not used for now */
 #define ICE_LISTENER_BUF_SIZE \
   (ICE_MAX_BURST_SIZE + OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE)
+#define ICE_SEGMENT_SIZE 16384
+#define ICE_MIN_SEGMENTS 4
+#define ICE_DEFAULT_BACKLOG_SIZE (512 * 1024)
+#define ICE_MAX_IOV 16
+
+/* Config file key to set the size of the stream backlog shared by all the
+   listeners, in bytes */
+#define ARATELIA_HTTP_RENDERER_BACKLOG_SIZE_KEY \
+  "OMX.Aratelia.audio_renderer.http.backlog_size"
+
+/* Config file key to select what happens to a listener that falls behind the
+   backlog (drop|skip) */
+#define ARATELIA_HTTP_RENDERER_SLOW_CLIENT_POLICY_KEY \
+  "OMX.Aratelia.audio_renderer.http.slow_client_policy"
 
 #define ICE_SOCK_ERROR (int) -1
 
@@ -33,6 +33,8 @@
 #endif
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <OMX_Core.h>
 
@@ -148,6 +150,33 @@ retrieve_mountpoint_settings (const void * ap_prc,
   return OMX_ErrorNone;
 }
 
+static void
+set_backlog_settings (httpr_prc_t * ap_prc)
+{
+  const char * p_backlog = NULL;
+  const char * p_policy = NULL;
+  OMX_U32 backlog_size = 0;
+  bool drop_slow_clients = true;
+
+  assert (ap_prc);
+
+  /* Stream backlog shared by all the listeners, and what to do with those
+     that fall behind it (see tizonia.conf) */
+  p_backlog = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                                    ARATELIA_HTTP_RENDERER_BACKLOG_SIZE_KEY);
+  backlog_size = p_backlog ? strtoul (p_backlog, NULL, 10) : 0;
+
+  p_policy = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                                   ARATELIA_HTTP_RENDERER_SLOW_CLIENT_POLICY_KEY);
+  if (p_policy && 0 == strncmp (p_policy, "skip", strlen ("skip")))
+    {
+      drop_slow_clients = false;
+    }
+
+  httpr_srv_set_backlog_settings (ap_prc->p_server_, backlog_size,
+                                  drop_slow_clients);
+}
+
 /*
  * httprprc
  */
@@ -186,7 +215,7 @@ httpr_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
     tiz_get_krn (handleOf (p_prc)), handleOf (p_prc),
     OMX_TizoniaIndexParamHttpServer, &p_prc->server_info_));
 
-  return httpr_srv_init (
+  tiz_check_omx (httpr_srv_init (
     &(p_prc->p_server_), p_prc, p_prc->server_info_.cBindAddress, /* if this is
                                                             * null, the
                                                             * server will
@@ -194,7 +223,10 @@ httpr_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
                                                             * all
                                                             * interfaces. */
     p_prc->server_info_.nListeningPort, p_prc->server_info_.nMaxClients,
-    buffer_emptied, buffer_needed, p_prc);
+    buffer_emptied, buffer_needed, p_prc));
+
+  set_backlog_settings (p_prc);
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
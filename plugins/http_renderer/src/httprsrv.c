@@ -23,9 +23,13 @@
  *
  * @brief Tizonia - HTTP renderer's networking functions
  *
- * NOTE: This is work in progress!!!!
- *
- * TODO: Better flow control
+ * The stream is copied once into a ring of fixed-size segments that is shared
+ * by all the listeners. Each listener reads from the ring at its own offset,
+ * and the data (with the ICY metadata blocks interleaved) is sent with
+ * scatter-gather I/O, without per-listener copies. A single timer paces the
+ * stream for everybody. Listeners that fall more than the ring's backlog
+ * behind are either dropped or moved forward, depending on the configured
+ * policy.
  *
  */
 
@@ -41,6 +45,7 @@
 #include <netinet/tcp.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <string.h>
 #include <errno.h>
@@ -70,12 +75,13 @@ typedef struct httpr_connection httpr_connection_t;
 typedef struct httpr_listener httpr_listener_t;
 typedef struct httpr_listener_buffer httpr_listener_buffer_t;
 typedef struct httpr_mount httpr_mount_t;
+typedef struct httpr_segment httpr_segment_t;
+typedef struct httpr_ring httpr_ring_t;
+typedef struct httpr_metadata httpr_metadata_t;
 
 struct httpr_listener_buffer
 {
   unsigned int len;
-  unsigned int metadata_offset;
-  unsigned int metadata_bytes;
   char * p_data;
 };
 
@@ -92,21 +98,52 @@ struct httpr_mount
   OMX_U32 max_clients;
 };
 
+/* A fixed-size slot of the stream ring. 'seq' is the number of the segment
+   currently stored in the slot (i.e. the slot holds the stream bytes [seq *
+   ICE_SEGMENT_SIZE, seq * ICE_SEGMENT_SIZE + len)), and 'nreaders' the number
+   of listeners whose read position maps to this slot. */
+struct httpr_segment
+{
+  uint64_t seq;
+  size_t len;
+  unsigned int nreaders;
+  char * p_data;
+};
+
+/* The stream, encoded once and shared by all listeners. Positions are
+   absolute stream offsets: 'start' is the oldest byte still available, 'end'
+   the next byte to be written, and 'live' the current position of the paced
+   stream. */
+struct httpr_ring
+{
+  httpr_segment_t * p_segs;
+  char * p_data;
+  unsigned int nsegs;
+  uint64_t start;
+  uint64_t end;
+  uint64_t live;
+  OMX_U32 max_lead;
+};
+
+/* An ICY metadata block, shared by all listeners that are due to receive it
+   and released once the last one has sent it. */
+struct httpr_metadata
+{
+  unsigned int refs;
+  size_t len;
+  char data[1];
+};
+
 struct httpr_connection
 {
   httpr_listener_t * p_lstnr;
   time_t con_time;
   uint64_t sent_total;
-  unsigned int sent_last;
-  unsigned int burst_bytes;
-  OMX_S32 initial_burst_bytes;
-  bool metadata_delivered;
   int sockfd;
   char * p_host;
   char * p_ip;
   unsigned short port;
   tiz_event_io_t * p_ev_io;
-  tiz_event_timer_t * p_ev_timer;
 };
 
 struct httpr_listener
@@ -114,13 +151,22 @@ struct httpr_listener
   httpr_server_t * p_server;
   httpr_connection_t * p_con;
   int respcode;
-  long intro_offset;
-  unsigned long pos;
+  uint64_t pos;
+  uint64_t seg;
+  OMX_U32 lead;
   httpr_listener_buffer_t buf;
   tiz_http_parser_t * p_parser;
   bool need_response;
-  bool timer_started;
+  bool attached;
+  bool blocked;
+  bool dropped;
   bool want_metadata;
+  size_t metadata_period;
+  size_t audio_to_metadata;
+  bool in_metadata;
+  size_t metadata_off;
+  httpr_metadata_t * p_metadata;
+  unsigned int metadata_serial;
 };
 
 struct httpr_server
@@ -129,8 +175,9 @@ struct httpr_server
   int lstn_sockfd;
   char * p_ip;
   tiz_event_io_t * p_srv_ev_io;
-  OMX_U32 max_clients; /* In future, more than one will be allowed;
-                          only one allowed at the moment. */
+  tiz_event_timer_t * p_srv_ev_timer;
+  bool timer_started;
+  OMX_U32 max_clients;
   tiz_map_t * p_lstnrs;
   OMX_BUFFERHEADERTYPE * p_hdr;
   httpr_srv_release_buffer_f pf_release_buf;
@@ -146,8 +193,15 @@ struct httpr_server
   double wait_time;
   double pkts_per_sec;
   httpr_mount_t mountpoint;
+  httpr_ring_t ring;
+  OMX_U32 backlog_size;
+  bool drop_slow_clients;
+  httpr_metadata_t * p_metadata;
+  unsigned int metadata_serial;
 };
 
+static char g_empty_metadata = 0;
+
 static void
 srv_destroy_listener (httpr_listener_t * ap_lstnr);
 
@@ -233,15 +287,19 @@ srv_get_listeners_count (const httpr_server_t * ap_server)
   return rc;
 }
 
-static httpr_listener_t *
-srv_get_first_listener (const httpr_server_t * ap_server)
+static inline OMX_U32
+srv_get_max_clients (const httpr_server_t * ap_server)
 {
-  httpr_listener_t * p_lstnr = NULL;
-  if (srv_get_listeners_count (ap_server) > 0)
+  OMX_U32 max_clients = 0;
+  assert (ap_server);
+  max_clients = ap_server->max_clients;
+  if (ap_server->mountpoint.max_clients > 0)
     {
-      p_lstnr = tiz_map_value_at (ap_server->p_lstnrs, 0);
+      max_clients = (max_clients > 0
+                       ? MIN (max_clients, ap_server->mountpoint.max_clients)
+                       : ap_server->mountpoint.max_clients);
     }
-  return p_lstnr;
+  return max_clients;
 }
 
 static int
@@ -482,46 +540,135 @@ srv_start_listener_io_watcher (httpr_listener_t * ap_lstnr)
 }
 
 static OMX_ERRORTYPE
-srv_stop_listener_io_watcher (httpr_listener_t * ap_lstnr)
+srv_start_server_timer_watcher (httpr_server_t * ap_server)
 {
-  assert (ap_lstnr);
-  assert (ap_lstnr->p_con);
-  return tiz_srv_io_watcher_stop (ap_lstnr->p_server->p_parent,
-                                  ap_lstnr->p_con->p_ev_io);
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (ap_server);
+  if (!ap_server->timer_started)
+    {
+      tiz_check_omx (tiz_srv_timer_watcher_start (
+        ap_server->p_parent, ap_server->p_srv_ev_timer, ap_server->wait_time,
+        ap_server->wait_time));
+      ap_server->timer_started = true;
+    }
+  return rc;
 }
 
 static OMX_ERRORTYPE
-srv_start_listener_timer_watcher (httpr_listener_t * ap_lstnr,
-                                  const double a_wait_time)
+srv_stop_server_timer_watcher (httpr_server_t * ap_server)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert (ap_lstnr);
-  if (!ap_lstnr->timer_started)
+  assert (ap_server);
+  if (ap_server->timer_started)
     {
-      assert (ap_lstnr->p_server);
-      assert (ap_lstnr->p_con);
-      tiz_check_omx (tiz_srv_timer_watcher_start (
-        ap_lstnr->p_server->p_parent, ap_lstnr->p_con->p_ev_timer, a_wait_time,
-        a_wait_time));
-      ap_lstnr->timer_started = true;
+      tiz_check_omx (tiz_srv_timer_watcher_stop (ap_server->p_parent,
+                                                 ap_server->p_srv_ev_timer));
+      ap_server->timer_started = false;
     }
   return rc;
 }
 
+static void
+srv_metadata_unref (httpr_metadata_t * ap_metadata)
+{
+  if (ap_metadata && 0 == --ap_metadata->refs)
+    {
+      tiz_mem_free (ap_metadata);
+    }
+}
+
+static inline httpr_segment_t *
+srv_ring_slot (const httpr_ring_t * ap_ring, const uint64_t a_seq)
+{
+  assert (ap_ring);
+  assert (ap_ring->nsegs > 0);
+  return &(ap_ring->p_segs[a_seq % ap_ring->nsegs]);
+}
+
+static void
+srv_ring_free (httpr_ring_t * ap_ring)
+{
+  assert (ap_ring);
+  tiz_mem_free (ap_ring->p_segs);
+  tiz_mem_free (ap_ring->p_data);
+  tiz_mem_set (ap_ring, 0, sizeof (httpr_ring_t));
+}
+
 static OMX_ERRORTYPE
-srv_stop_listener_timer_watcher (httpr_listener_t * ap_lstnr)
+srv_ring_alloc (httpr_server_t * ap_server)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  httpr_ring_t * p_ring = NULL;
+  size_t capacity = 0;
+  unsigned int i = 0;
+
+  assert (ap_server);
+  p_ring = &(ap_server->ring);
+  srv_ring_free (p_ring);
+
+  /* The ring must at least hold one initial burst behind the live position
+     (for new listeners), and another one ahead of it (the lead of the
+     listeners that are still bursting). */
+  capacity = MAX (ap_server->backlog_size,
+                  2 * ap_server->mountpoint.initial_burst_size
+                    + ICE_MIN_SEGMENTS * ICE_SEGMENT_SIZE);
+  p_ring->nsegs = (capacity + ICE_SEGMENT_SIZE - 1) / ICE_SEGMENT_SIZE;
+  p_ring->p_segs = (httpr_segment_t *) tiz_mem_calloc (
+    p_ring->nsegs, sizeof (httpr_segment_t));
+  p_ring->p_data = (char *) tiz_mem_alloc (p_ring->nsegs * ICE_SEGMENT_SIZE);
+  if (!p_ring->p_segs || !p_ring->p_data)
+    {
+      srv_ring_free (p_ring);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  for (i = 0; i < p_ring->nsegs; ++i)
+    {
+      p_ring->p_segs[i].seq = i;
+      p_ring->p_segs[i].p_data = p_ring->p_data + i * ICE_SEGMENT_SIZE;
+    }
+
+  TIZ_TRACE (handleOf (ap_server->p_parent),
+             "Stream ring : [%u] segments of [%d] bytes", p_ring->nsegs,
+             ICE_SEGMENT_SIZE);
+  return OMX_ErrorNone;
+}
+
+static void
+srv_ring_reset (httpr_ring_t * ap_ring)
+{
+  unsigned int i = 0;
+  assert (ap_ring);
+  for (i = 0; i < ap_ring->nsegs; ++i)
+    {
+      assert (0 == ap_ring->p_segs[i].nreaders);
+      ap_ring->p_segs[i].seq = i;
+      ap_ring->p_segs[i].len = 0;
+    }
+  ap_ring->start = 0;
+  ap_ring->end = 0;
+  ap_ring->live = 0;
+  ap_ring->max_lead = 0;
+}
+
+static void
+srv_listener_seek (httpr_listener_t * ap_lstnr, const uint64_t a_pos)
+{
+  httpr_ring_t * p_ring = NULL;
+  uint64_t seg = 0;
+
   assert (ap_lstnr);
-  if (ap_lstnr->timer_started)
+  assert (ap_lstnr->p_server);
+  assert (ap_lstnr->attached);
+
+  p_ring = &(ap_lstnr->p_server->ring);
+  seg = a_pos / ICE_SEGMENT_SIZE;
+  if (seg != ap_lstnr->seg)
     {
-      assert (ap_lstnr->p_server);
-      assert (ap_lstnr->p_con);
-      tiz_check_omx (tiz_srv_timer_watcher_stop (
-        ap_lstnr->p_server->p_parent, ap_lstnr->p_con->p_ev_timer));
-      ap_lstnr->timer_started = false;
+      srv_ring_slot (p_ring, ap_lstnr->seg)->nreaders--;
+      srv_ring_slot (p_ring, seg)->nreaders++;
+      ap_lstnr->seg = seg;
     }
-  return rc;
+  ap_lstnr->pos = a_pos;
 }
 
 static void
@@ -538,8 +685,6 @@ srv_destroy_connection (httpr_connection_t * ap_con)
       assert (ap_con->p_lstnr && ap_con->p_lstnr->p_server);
       tiz_srv_io_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
                                   ap_con->p_ev_io);
-      tiz_srv_timer_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
-                                     ap_con->p_ev_timer);
       tiz_mem_free (ap_con);
     }
 }
@@ -549,7 +694,12 @@ srv_destroy_listener (httpr_listener_t * ap_lstnr)
 {
   if (ap_lstnr)
     {
-      srv_stop_listener_timer_watcher (ap_lstnr);
+      if (ap_lstnr->attached)
+        {
+          srv_ring_slot (&(ap_lstnr->p_server->ring), ap_lstnr->seg)
+            ->nreaders--;
+        }
+      srv_metadata_unref (ap_lstnr->p_metadata);
       if (ap_lstnr->p_parser)
         {
           tiz_http_parser_destroy (ap_lstnr->p_parser);
@@ -586,7 +736,7 @@ srv_remove_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 static httpr_connection_t *
 srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
                        const int connected_sockfd, char * ap_ip,
-                       const unsigned short ap_port, const double a_wait_time)
+                       const unsigned short ap_port)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   httpr_connection_t * p_con = NULL;
@@ -604,15 +754,11 @@ srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
   p_con->p_lstnr = ap_lstnr;
   p_con->con_time = 0; /* time (NULL); */
   p_con->sent_total = 0;
-  p_con->sent_last = 0;
-  p_con->burst_bytes = 0;
-  p_con->initial_burst_bytes = ap_server->mountpoint.initial_burst_size;
   p_con->sockfd = connected_sockfd;
   p_con->p_host = NULL;
   p_con->p_ip = ap_ip;
   p_con->port = ap_port;
   p_con->p_ev_io = NULL;
-  p_con->p_ev_timer = NULL;
 
   /* We are interested in knowing when a listener socket is available for
    * writing */
@@ -620,9 +766,6 @@ srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
                                 p_con->sockfd, TIZ_EVENT_WRITE, true);
   goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's io event");
 
-  rc = tiz_srv_timer_watcher_init (ap_server->p_parent, &(p_con->p_ev_timer));
-  goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's timer event");
-
 end:
   if (OMX_ErrorNone != rc)
     {
@@ -655,22 +798,29 @@ srv_create_listener (httpr_server_t * ap_server, httpr_listener_t ** app_lstnr,
   goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the listener structure");
 
   p_con = srv_create_connection (ap_server, p_lstnr, a_connected_sockfd, ap_ip,
-                                 ap_port, ap_server->wait_time);
+                                 ap_port);
   rc = p_con ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
   goto_end_on_omx_error (rc, p_hdl, "Unable to init the listener's connection");
 
   p_lstnr->p_server = ap_server;
   p_lstnr->p_con = p_con;
   p_lstnr->respcode = 200;
-  p_lstnr->intro_offset = 0;
   p_lstnr->pos = 0;
+  p_lstnr->seg = 0;
+  p_lstnr->lead = 0;
   p_lstnr->buf.len = ICE_LISTENER_BUF_SIZE;
-  p_lstnr->buf.metadata_offset = 0;
-  p_lstnr->buf.metadata_bytes = 0;
   p_lstnr->p_parser = NULL;
   p_lstnr->need_response = true;
-  p_lstnr->timer_started = false;
+  p_lstnr->attached = false;
+  p_lstnr->blocked = false;
+  p_lstnr->dropped = false;
   p_lstnr->want_metadata = false;
+  p_lstnr->metadata_period = 0;
+  p_lstnr->audio_to_metadata = 0;
+  p_lstnr->in_metadata = false;
+  p_lstnr->metadata_off = 0;
+  p_lstnr->p_metadata = NULL;
+  p_lstnr->metadata_serial = 0;
 
   p_lstnr->buf.p_data = (char *) tiz_mem_alloc (ICE_LISTENER_BUF_SIZE);
   rc = p_lstnr->buf.p_data ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
@@ -945,7 +1095,8 @@ srv_handle_listeners_request (httpr_server_t * ap_server,
   assert (ap_lstnr->p_con);
   assert (ap_lstnr->p_parser);
 
-  some_error = (srv_get_listeners_count (ap_server) > ap_server->max_clients);
+  some_error
+    = (srv_get_listeners_count (ap_server) > srv_get_max_clients (ap_server));
   bail_on_request_error (some_error, 400, "Client limit reached");
 
   /*   some_error */
@@ -1008,40 +1159,14 @@ end:
   return rc;
 }
 
-static OMX_S32
-srv_remove_existing_listener (OMX_PTR ap_key, OMX_PTR ap_value, OMX_PTR ap_arg)
-{
-  httpr_server_t * p_server = ap_arg;
-  httpr_listener_t * p_lstnr = NULL;
-
-  assert (p_server);
-  assert (ap_key);
-  assert (ap_value);
-
-  p_lstnr = (httpr_listener_t *) ap_value;
-
-  srv_remove_listener (p_server, p_lstnr);
-
-  return 0;
-}
-
-inline static void
-srv_release_empty_buffer (httpr_server_t * ap_server,
-                          httpr_listener_t * ap_lstnr,
-                          OMX_BUFFERHEADERTYPE ** app_hdr)
+static void
+srv_release_empty_buffer (httpr_server_t * ap_server)
 {
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-
   assert (ap_server);
-  assert (ap_lstnr);
-  assert (app_hdr);
+  assert (ap_server->p_hdr);
 
-  p_hdr = *app_hdr;
-
-  ap_lstnr->pos = 0;
-  p_hdr->nFilledLen = 0;
-  ap_server->pf_release_buf (p_hdr, ap_server->p_arg);
-  *app_hdr = NULL;
+  ap_server->p_hdr->nFilledLen = 0;
+  ap_server->pf_release_buf (ap_server->p_hdr, ap_server->p_arg);
   ap_server->p_hdr = NULL;
 }
 
@@ -1079,344 +1204,473 @@ srv_is_listener_ready (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
   return lstnr_ready;
 }
 
-static inline bool
-srv_is_time_to_send_metadata (httpr_server_t * ap_server,
-                              httpr_listener_t * ap_lstnr)
+static void
+srv_ring_evict (httpr_server_t * ap_server, const uint64_t a_seq)
 {
-  if (ap_lstnr->p_con->sent_total == 0)
+  httpr_ring_t * p_ring = NULL;
+  const uint64_t new_start = (a_seq + 1) * ICE_SEGMENT_SIZE;
+  int i = 0;
+
+  assert (ap_server);
+  p_ring = &(ap_server->ring);
+
+  if (srv_ring_slot (p_ring, a_seq)->nreaders > 0)
     {
-      return false;
+      /* Some listeners are still reading from the segment that is about to be
+         overwritten; they have fallen more than a backlog behind */
+      for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
+        {
+          httpr_listener_t * p_lstnr
+            = tiz_map_value_at (ap_server->p_lstnrs, i);
+          assert (p_lstnr);
+          if (!p_lstnr->attached || p_lstnr->dropped
+              || p_lstnr->pos >= new_start)
+            {
+              continue;
+            }
+
+          if (ap_server->drop_slow_clients)
+            {
+              TIZ_NOTICE (handleOf (ap_server->p_parent),
+                          "Dropping slow client [%s:%u] fd [%d]",
+                          p_lstnr->p_con->p_ip, p_lstnr->p_con->port,
+                          p_lstnr->p_con->sockfd);
+              /* The listener is removed from the map on the next flush */
+              p_lstnr->dropped = true;
+            }
+          else
+            {
+              TIZ_NOTICE (handleOf (ap_server->p_parent),
+                          "Client [%s:%u] fd [%d] skips [%llu] bytes",
+                          p_lstnr->p_con->p_ip, p_lstnr->p_con->port,
+                          p_lstnr->p_con->sockfd,
+                          (unsigned long long) (new_start - p_lstnr->pos));
+              srv_listener_seek (p_lstnr, new_start);
+            }
+        }
     }
 
-  if (((ap_lstnr->p_con->sent_total + ap_server->burst_size)
-       % ap_server->mountpoint.metadata_period)
-      <= ap_server->burst_size)
+  p_ring->start = new_start;
+}
+
+static void
+srv_ring_write (httpr_server_t * ap_server, const OMX_U8 * ap_data,
+                size_t a_len)
+{
+  httpr_ring_t * p_ring = NULL;
+
+  assert (ap_server);
+  assert (ap_data);
+  p_ring = &(ap_server->ring);
+
+  while (a_len > 0)
     {
-      return true;
-    }
+      const uint64_t seq = p_ring->end / ICE_SEGMENT_SIZE;
+      const size_t offset = p_ring->end % ICE_SEGMENT_SIZE;
+      const size_t len = MIN (a_len, ICE_SEGMENT_SIZE - offset);
+      httpr_segment_t * p_seg = srv_ring_slot (p_ring, seq);
 
-  return false;
+      if (p_seg->seq != seq)
+        {
+          /* The slot is recycled; its current segment leaves the ring */
+          srv_ring_evict (ap_server, p_seg->seq);
+          p_seg->seq = seq;
+          p_seg->len = 0;
+        }
+
+      memcpy (p_seg->p_data + offset, ap_data, len);
+      p_seg->len = offset + len;
+      p_ring->end += len;
+      ap_data += len;
+      a_len -= len;
+    }
 }
 
-static inline size_t
-srv_get_metadata_offset (const httpr_server_t * ap_server,
-                         const httpr_listener_t * ap_lstnr)
+static void
+srv_ring_fill (httpr_server_t * ap_server)
 {
-  size_t offset = 0;
-  if (ap_lstnr->p_con->sent_total != 0)
+  httpr_ring_t * p_ring = NULL;
+  uint64_t target = 0;
+
+  assert (ap_server);
+  p_ring = &(ap_server->ring);
+
+  /* Keep enough data ahead of the live position for the next pacing period
+     and for the listeners that are still in their initial burst. The OMX
+     buffers are copied to the ring only once, and released as soon as they
+     have been copied, whatever the number of listeners. */
+  target = p_ring->live + ap_server->burst_size + p_ring->max_lead;
+
+  while (p_ring->end < target)
     {
-      offset = (ap_server->mountpoint.metadata_period
-                * ((ap_lstnr->p_con->sent_total + ap_server->burst_size)
-                   / ap_server->mountpoint.metadata_period))
-               - ap_lstnr->p_con->sent_total;
+      OMX_BUFFERHEADERTYPE * p_hdr = ap_server->p_hdr;
+      size_t len = 0;
+
+      if (!p_hdr)
+        {
+          if (NULL == (p_hdr = ap_server->pf_acquire_buf (ap_server->p_arg)))
+            {
+              /* no more buffers available at the moment */
+              ap_server->need_more_data = true;
+              break;
+            }
+          ap_server->p_hdr = p_hdr;
+        }
+      ap_server->need_more_data = false;
+
+      len = MIN (p_hdr->nFilledLen, target - p_ring->end);
+      srv_ring_write (ap_server, p_hdr->pBuffer + p_hdr->nOffset, len);
+      p_hdr->nFilledLen -= len;
+      p_hdr->nOffset += len;
+
+      if (0 == p_hdr->nFilledLen)
+        {
+          /* Buffer emptied */
+          srv_release_empty_buffer (ap_server);
+        }
     }
+}
 
-  return offset;
+static inline httpr_metadata_t *
+srv_get_next_metadata (const httpr_server_t * ap_server,
+                       const httpr_listener_t * ap_lstnr)
+{
+  /* The stream title is delivered once after each change; an empty metadata
+     block is sent otherwise */
+  return ((ap_server->p_metadata
+           && ap_lstnr->metadata_serial != ap_server->metadata_serial)
+            ? ap_server->p_metadata
+            : NULL);
+}
+
+static inline char *
+srv_get_metadata_data (httpr_metadata_t * ap_metadata)
+{
+  return ap_metadata ? ap_metadata->data : &g_empty_metadata;
 }
 
 static inline size_t
-srv_get_metadata_length (const httpr_server_t * ap_server,
-                         const httpr_listener_t * ap_lstnr)
+srv_get_metadata_length (const httpr_metadata_t * ap_metadata)
 {
-  if (ap_lstnr->p_con->sent_total == 0 || ap_lstnr->p_con->metadata_delivered)
+  return ap_metadata ? ap_metadata->len : 1;
+}
+
+static void
+srv_begin_metadata (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (!ap_lstnr->in_metadata);
+  assert (!ap_lstnr->p_metadata);
+
+  ap_lstnr->p_metadata = srv_get_next_metadata (ap_server, ap_lstnr);
+  if (ap_lstnr->p_metadata)
     {
-      return 0;
+      ap_lstnr->p_metadata->refs++;
+      ap_lstnr->metadata_serial = ap_server->metadata_serial;
     }
-
-  return strnlen ((char *) ap_server->mountpoint.stream_title,
-                  OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
+  ap_lstnr->in_metadata = true;
+  ap_lstnr->metadata_off = 0;
 }
 
 static void
-srv_arrange_metadata (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                      OMX_U8 ** app_buffer, size_t * ap_len)
+srv_end_metadata (httpr_listener_t * ap_lstnr)
 {
-  size_t len = 0;
-  httpr_listener_buffer_t * p_lstnr_buf = NULL;
+  assert (ap_lstnr);
+  assert (ap_lstnr->in_metadata);
+
+  srv_metadata_unref (ap_lstnr->p_metadata);
+  ap_lstnr->p_metadata = NULL;
+  ap_lstnr->in_metadata = false;
+  ap_lstnr->metadata_off = 0;
+  ap_lstnr->audio_to_metadata = ap_lstnr->metadata_period;
+}
+
+static int
+srv_build_iov (const httpr_server_t * ap_server,
+               const httpr_listener_t * ap_lstnr, const uint64_t a_limit,
+               struct iovec * ap_iov, bool * ap_is_metadata)
+{
+  const httpr_ring_t * p_ring = NULL;
+  uint64_t pos = 0;
+  uint64_t audio_end = 0;
+  int niov = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (app_buffer);
-  assert (ap_len);
+  assert (ap_iov);
+  assert (ap_is_metadata);
+
+  p_ring = &(ap_server->ring);
+  pos = ap_lstnr->pos;
+  audio_end = a_limit;
+
+  /* The rest of a metadata block that could not be sent in one go */
+  if (ap_lstnr->in_metadata)
+    {
+      ap_iov[niov].iov_base = srv_get_metadata_data (ap_lstnr->p_metadata)
+                              + ap_lstnr->metadata_off;
+      ap_iov[niov].iov_len = srv_get_metadata_length (ap_lstnr->p_metadata)
+                             - ap_lstnr->metadata_off;
+      ap_is_metadata[niov++] = true;
+    }
+
+  if (ap_lstnr->want_metadata)
+    {
+      audio_end
+        = MIN (audio_end,
+               pos + (ap_lstnr->in_metadata ? ap_lstnr->metadata_period
+                                            : ap_lstnr->audio_to_metadata));
+    }
 
-  len = *ap_len;
-  p_lstnr_buf = &ap_lstnr->buf;
+  /* The audio, straight from the ring's segments. One slot of the vector is
+     reserved for the metadata block that may follow. */
+  while (pos < audio_end && niov < ICE_MAX_IOV - 1)
+    {
+      const uint64_t seq = pos / ICE_SEGMENT_SIZE;
+      const size_t offset = pos % ICE_SEGMENT_SIZE;
+      const size_t len = MIN (audio_end - pos, ICE_SEGMENT_SIZE - offset);
+      httpr_segment_t * p_seg = srv_ring_slot (p_ring, seq);
+
+      assert (p_seg->seq == seq);
+      assert (offset + len <= p_seg->len);
+      ap_iov[niov].iov_base = p_seg->p_data + offset;
+      ap_iov[niov].iov_len = len;
+      ap_is_metadata[niov++] = false;
+      pos += len;
+    }
 
-  if (0 == len || !ap_lstnr->want_metadata
-      || 0 == ap_server->mountpoint.metadata_period
-      || !srv_is_time_to_send_metadata (ap_server, ap_lstnr))
+  /* The metadata block that is interleaved every 'metadata_period' bytes */
+  if (ap_lstnr->want_metadata && pos < a_limit && pos == audio_end)
     {
-      /* p_lstnr_buf->metadata_bytes = 0; */
-      return;
+      httpr_metadata_t * p_metadata
+        = srv_get_next_metadata (ap_server, ap_lstnr);
+      ap_iov[niov].iov_base = srv_get_metadata_data (p_metadata);
+      ap_iov[niov].iov_len = srv_get_metadata_length (p_metadata);
+      ap_is_metadata[niov++] = true;
     }
 
-  {
-    OMX_U8 * p_buffer = *app_buffer;
-    size_t metadata_offset = srv_get_metadata_offset (ap_server, ap_lstnr);
-
-    if (metadata_offset < len && 0 == p_lstnr_buf->metadata_bytes)
-      {
-        OMX_U8 * p_dest = NULL;
-        OMX_U8 * p_src = NULL;
-        size_t metadata_len = srv_get_metadata_length (ap_server, ap_lstnr);
-        size_t metadata_total = 0;
-        size_t metadata_byte = 0;
-
-        if (metadata_len > 0)
-          {
-            metadata_byte = metadata_len / 16;
-            if (metadata_len % 16)
-              {
-                metadata_byte++;
-              }
-          }
-        else
-          {
-            metadata_byte = 0;
-          }
-
-        metadata_total = (metadata_byte * 16) + 1;
-        p_dest = p_buffer + metadata_offset + metadata_total;
-        p_src = p_buffer + metadata_offset;
-
-        /* Move content to make space for the metadata */
-        memmove (p_dest, p_src, len - metadata_offset);
-
-        p_lstnr_buf->metadata_bytes += metadata_total;
-        p_lstnr_buf->metadata_offset += metadata_offset;
-
-        if (metadata_len)
-          {
-            snprintf ((char *) p_src, metadata_total, "%c%s",
-                      (int) metadata_byte,
-                      (char *) ap_server->mountpoint.stream_title);
-            ap_lstnr->p_con->metadata_delivered = true;
-          }
-        else
-          {
-            p_src[0] = metadata_byte;
-          }
-
-        len += metadata_total;
-        p_lstnr_buf->len = len;
-
-        *ap_len = len;
-        *app_buffer = p_buffer;
-      }
-  }
+  return niov;
 }
 
 static void
-srv_arrange_data (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                  OMX_U8 ** app_buffer, size_t * ap_len)
+srv_consume_iov (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
+                 const struct iovec * ap_iov, const bool * ap_is_metadata,
+                 const int a_niov, size_t a_sent)
 {
-  OMX_U8 * p_buffer = NULL;
-  size_t len = 0;
-  httpr_listener_buffer_t * p_lstnr_buf = NULL;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  int i = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (app_buffer);
-  assert (ap_len);
-
-  p_lstnr_buf = &ap_lstnr->buf;
-  p_hdr = ap_server->p_hdr;
+  assert (ap_iov);
+  assert (ap_is_metadata);
 
-  if (p_hdr && p_hdr->pBuffer && p_hdr->nFilledLen > 0)
+  for (i = 0; i < a_niov && a_sent > 0; ++i)
     {
-      int to_copy = 0;
-      if (ap_server->burst_size > p_lstnr_buf->len)
+      const size_t len = MIN (a_sent, ap_iov[i].iov_len);
+      if (ap_is_metadata[i])
         {
-          to_copy = ap_server->burst_size - p_lstnr_buf->len;
+          assert (ap_lstnr->in_metadata);
+          ap_lstnr->metadata_off += len;
+          if (ap_lstnr->metadata_off
+              == srv_get_metadata_length (ap_lstnr->p_metadata))
+            {
+              srv_end_metadata (ap_lstnr);
+            }
         }
-      if (to_copy > p_hdr->nFilledLen)
+      else
         {
-          to_copy = p_hdr->nFilledLen;
+          srv_listener_seek (ap_lstnr, ap_lstnr->pos + len);
+          ap_lstnr->p_con->sent_total += len;
+          if (ap_lstnr->want_metadata
+              && 0 == (ap_lstnr->audio_to_metadata -= len))
+            {
+              srv_begin_metadata (ap_server, ap_lstnr);
+            }
         }
-      memcpy (p_lstnr_buf->p_data + p_lstnr_buf->len,
-              p_hdr->pBuffer + p_hdr->nOffset, to_copy);
-      p_lstnr_buf->len += to_copy;
-      p_hdr->nFilledLen -= to_copy;
-      p_hdr->nOffset += to_copy;
+      a_sent -= len;
     }
-
-  p_buffer = (OMX_U8 *) p_lstnr_buf->p_data;
-  len = p_lstnr_buf->len;
-
-  srv_arrange_metadata (ap_server, ap_lstnr, &p_buffer, &len);
-
-  *ap_len = len;
-  *app_buffer = p_buffer;
 }
 
 static OMX_ERRORTYPE
-srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                       const void * ap_buffer, const size_t a_buf_len,
-                       int * a_bytes_written)
+srv_flush_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  int bytes = 0;
+  struct iovec iov[ICE_MAX_IOV];
+  bool is_metadata[ICE_MAX_IOV];
+  httpr_ring_t * p_ring = NULL;
   httpr_connection_t * p_con = NULL;
-  int sock = ICE_SOCK_ERROR;
+  uint64_t limit = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (ap_buffer);
-  assert (a_bytes_written);
+  assert (ap_lstnr->attached);
+  assert (ap_lstnr->p_con);
 
+  p_ring = &(ap_server->ring);
   p_con = ap_lstnr->p_con;
-  sock = p_con->sockfd;
-  *a_bytes_written = 0;
-  errno = 0;
-
-  bytes = send (sock, (const void *) ap_buffer, a_buf_len, MSG_NOSIGNAL);
+  limit = MIN (p_ring->end, p_ring->live + ap_lstnr->lead);
 
-  if (bytes < 0)
+  while (ap_lstnr->pos < limit || ap_lstnr->in_metadata)
     {
-      if (!srv_is_recoverable_error (ap_server, sock, errno))
+      struct msghdr msg;
+      size_t total = 0;
+      ssize_t sent = 0;
+      int niov = 0;
+      int i = 0;
+
+      niov = srv_build_iov (ap_server, ap_lstnr, limit, iov, is_metadata);
+      assert (niov > 0);
+      for (i = 0; i < niov; ++i)
         {
-          TIZ_PRINTF_DBG_RED (
-            "Non-recoverable error while writing to the socket (will destroy "
-            "listener)\n");
-          /* Mark the listener as failed, so that it will get removed */
-          rc = OMX_ErrorNoMore;
+          total += iov[i].iov_len;
         }
-      else
+
+      tiz_mem_set (&msg, 0, sizeof (msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = niov;
+
+      errno = 0;
+      sent = sendmsg (p_con->sockfd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (sent < 0)
+        {
+          if (!srv_is_recoverable_error (ap_server, p_con->sockfd, errno))
+            {
+              TIZ_PRINTF_DBG_RED (
+                "Non-recoverable error while writing to the socket (will "
+                "destroy listener)\n");
+              /* Mark the listener as failed, so that it will get removed */
+              ap_lstnr->dropped = true;
+              return OMX_ErrorNoMore;
+            }
+          sent = 0;
+        }
+
+      srv_consume_iov (ap_server, ap_lstnr, iov, is_metadata, niov, sent);
+
+      if ((size_t) sent < total)
         {
-          TIZ_PRINTF_DBG_RED (
-            "Recoverable error while writing to the socket"
-            "(re-starting io watcher)\n");
+          /* The socket's send buffer is full. Stop feeding this listener until
+             the socket becomes writable again */
+          ap_lstnr->blocked = true;
           (void) srv_start_listener_io_watcher (ap_lstnr);
-          (void) srv_stop_listener_timer_watcher (ap_lstnr);
-          rc = OMX_ErrorNotReady;
+          return OMX_ErrorNotReady;
         }
     }
-  else
-    {
-      *a_bytes_written = bytes;
-    }
-  return rc;
+
+  return OMX_ErrorNone;
 }
 
-static OMX_ERRORTYPE
-srv_write_omx_buffer (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+static void
+srv_flush_listeners (httpr_server_t * ap_server)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  httpr_connection_t * p_con = NULL;
-  int sock = ICE_SOCK_ERROR;
+  OMX_U32 max_lead = 0;
+  int nattached = 0;
+  int i = 0;
 
   assert (ap_server);
-  assert (ap_lstnr);
-  assert (ap_lstnr->p_con);
 
-  p_con = ap_lstnr->p_con;
-  sock = p_con->sockfd;
-
-  p_con->sent_last = 0;
-
-  if (!srv_is_valid_socket (sock))
-    {
-      TIZ_WARN (handleOf (ap_server->p_parent),
-                "Will destroy listener "
-                "(Invalid listener socket fd [%d])",
-                sock);
-      /* The socket is not valid anymore. The listener will be removed. */
-      rc = OMX_ErrorNoMore;
-    }
-  else
+  /* Iterate backwards, so that listeners can be removed on the way */
+  for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
     {
-      httpr_listener_buffer_t * p_lstnr_buf = &ap_lstnr->buf;
-      OMX_U8 * p_buffer = NULL;
-      size_t len = 0;
-      int bytes = 0;
+      httpr_listener_t * p_lstnr = tiz_map_value_at (ap_server->p_lstnrs, i);
+      assert (p_lstnr);
 
-      /* Obtain a pointer to the data and the amount of data to be written */
-      srv_arrange_data (ap_server, ap_lstnr, &p_buffer, &len);
+      if (p_lstnr->attached && !p_lstnr->blocked && !p_lstnr->dropped)
+        {
+          (void) srv_flush_listener (ap_server, p_lstnr);
+        }
 
-      if (len > 0)
+      if (p_lstnr->dropped)
+        {
+          srv_remove_listener (ap_server, p_lstnr);
+        }
+      else if (p_lstnr->attached)
         {
-          int metadata_sent = 0;
-          tiz_check_omx (
-            srv_write_to_listener (ap_server, ap_lstnr, p_buffer, len, &bytes));
-          assert (bytes >= 0);
+          max_lead = MAX (max_lead, p_lstnr->lead);
+          ++nattached;
+        }
+    }
 
-          p_lstnr_buf->len
-            = bytes > p_lstnr_buf->len ? 0 : (p_lstnr_buf->len - bytes);
+  ap_server->ring.max_lead = max_lead;
 
-          if (p_lstnr_buf->len > 0)
-            {
-              memmove (p_lstnr_buf->p_data, p_lstnr_buf->p_data + bytes,
-                       p_lstnr_buf->len);
-            }
+  if (0 == nattached)
+    {
+      /* Nobody to stream to; let the buffers queue up in the port until a
+         listener connects */
+      (void) srv_stop_server_timer_watcher (ap_server);
+    }
+}
 
-          if (bytes > p_lstnr_buf->metadata_offset)
-            {
-              metadata_sent = MIN ((bytes - p_lstnr_buf->metadata_offset),
-                                   p_lstnr_buf->metadata_bytes);
-            }
+static OMX_ERRORTYPE
+srv_attach_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  httpr_ring_t * p_ring = NULL;
+  OMX_U32 burst = 0;
+  uint64_t pos = 0;
 
-          if (p_con->initial_burst_bytes > 0)
-            {
-              p_con->initial_burst_bytes -= (bytes - metadata_sent);
-            }
-          else
-            {
-              if (p_con->con_time == 0)
-                {
-                  p_con->con_time = time (NULL);
-                }
-            }
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (!ap_lstnr->attached);
+
+  p_ring = &(ap_server->ring);
+  burst = ap_server->mountpoint.initial_burst_size;
+
+  /* The initial burst is served from the backlog as far as possible. The
+     remainder is sent ahead of the live position. */
+  pos = p_ring->live > burst ? p_ring->live - burst : 0;
+  pos = MAX (pos, p_ring->start);
+  assert (p_ring->live - pos <= burst);
+
+  ap_lstnr->pos = pos;
+  ap_lstnr->seg = pos / ICE_SEGMENT_SIZE;
+  srv_ring_slot (p_ring, ap_lstnr->seg)->nreaders++;
+  ap_lstnr->lead = burst - (OMX_U32) (p_ring->live - pos);
+  ap_lstnr->attached = true;
+  p_ring->max_lead = MAX (p_ring->max_lead, ap_lstnr->lead);
+
+  ap_lstnr->want_metadata
+    = (ap_lstnr->want_metadata && ap_server->mountpoint.metadata_period > 0);
+  ap_lstnr->metadata_period = ap_server->mountpoint.metadata_period;
+  ap_lstnr->audio_to_metadata = ap_lstnr->metadata_period;
+  ap_lstnr->p_con->con_time = time (NULL);
+
+  TIZ_TRACE (handleOf (ap_server->p_parent),
+             "Listener fd [%d] attached at [%llu] lead [%u] live [%llu]",
+             ap_lstnr->p_con->sockfd, (unsigned long long) pos,
+             (unsigned int) ap_lstnr->lead,
+             (unsigned long long) p_ring->live);
+
+  return srv_start_server_timer_watcher (ap_server);
+}
 
-          p_con->sent_total += (bytes - metadata_sent);
-          p_con->sent_last = (bytes - metadata_sent);
-          p_con->burst_bytes += (bytes - metadata_sent);
-
-          {
-            time_t t = time (NULL);
-            double d = difftime (t, p_con->con_time);
-            uint64_t rate = d ? p_con->sent_total / (uint64_t) d : 0;
-            TIZ_PRINTF_DBG_BLU (
-              "total [%lld] last [%d] burst [%d] time [%f] rate [%lld] "
-              "server burst [%d] bytes [%d]\n",
-              p_con->sent_total, p_con->sent_last, p_con->burst_bytes, d, rate,
-              ap_server->burst_size, bytes);
-          }
-
-          TIZ_PRINTF_DBG_GRN (
-            "metadata_bytes [%u] < metadata_offset [%u] metadata_sent [%u]\n",
-            p_lstnr_buf->metadata_bytes, p_lstnr_buf->metadata_offset,
-            metadata_sent);
-
-          p_lstnr_buf->metadata_bytes -= metadata_sent;
-          if (p_lstnr_buf->metadata_offset > 0 && p_lstnr_buf->metadata_bytes)
-            {
-              p_lstnr_buf->metadata_offset -= ((unsigned int) bytes);
-            }
-          else
-            {
-              p_lstnr_buf->metadata_offset = 0;
-            }
+static OMX_ERRORTYPE
+srv_serve_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
 
-          if (bytes < len)
-            {
-              TIZ_PRINTF_DBG_RED (
-                "NEED TO STOP bytes [%d] < len [%u] p_lstnr_buf->len [%u]\n",
-                bytes, len, p_lstnr_buf->len);
-              (void) srv_start_listener_io_watcher (ap_lstnr);
-              (void) srv_stop_listener_timer_watcher (ap_lstnr);
-              rc = OMX_ErrorNotReady;
-            }
-          else
-            {
-              if ((p_con->initial_burst_bytes <= 0)
-                  && (p_con->burst_bytes >= ap_server->burst_size))
-                {
-                  rc = srv_start_listener_timer_watcher (ap_lstnr,
-                                                         ap_server->wait_time);
-                }
-            }
+  assert (ap_server);
+  assert (ap_lstnr);
+
+  if (ap_lstnr->need_response)
+    {
+      if (!srv_is_listener_ready (ap_server, ap_lstnr))
+        {
+          return OMX_ErrorNotReady;
         }
+      tiz_check_omx (srv_attach_listener (ap_server, ap_lstnr));
+      srv_ring_fill (ap_server);
+    }
+
+  ap_lstnr->blocked = false;
+  if (!ap_lstnr->dropped)
+    {
+      rc = srv_flush_listener (ap_server, ap_lstnr);
+    }
+
+  if (ap_lstnr->dropped)
+    {
+      srv_remove_listener (ap_server, ap_lstnr);
+      rc = OMX_ErrorNoMore;
     }
 
   return rc;
@@ -1436,13 +1690,6 @@ srv_accept_connection (httpr_server_t * ap_server)
   assert (ap_server);
   p_hdl = handleOf (ap_server->p_parent);
 
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      /* This is a simple solution to prevent more than one connection at
-       * a time. One day this could be a multi-client renderer */
-      tiz_map_for_each (ap_server->p_lstnrs, srv_remove_existing_listener,
-                        ap_server);
-    }
 
   if ((p_ip = (char *) tiz_mem_alloc (ICE_RENDERER_MAX_ADDR_LEN)))
     {
@@ -1512,7 +1759,7 @@ end:
         "\tburst [%d] sample rate [%u] bitrate [%u] "
         "burst_size [%u] bytes per frame [%u] wait_time [%f] "
         "pkts/s [%f].\n",
-        (unsigned int) p_con->initial_burst_bytes,
+        (unsigned int) ap_server->mountpoint.initial_burst_size,
         (unsigned int) ap_server->sample_rate,
         (unsigned int) ap_server->bitrate, (unsigned int) ap_server->burst_size,
         (unsigned int) ap_server->bytes_per_frame, ap_server->wait_time,
@@ -1525,115 +1772,6 @@ end:
   return rc;
 }
 
-static OMX_ERRORTYPE
-srv_write (httpr_server_t * ap_server)
-{
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-  httpr_listener_t * p_lstnr = NULL;
-  httpr_connection_t * p_con = NULL;
-
-  assert (ap_server);
-
-  if (srv_get_listeners_count (ap_server) <= 0)
-    {
-      return OMX_ErrorNoMore;
-    }
-
-  /* Until support for multiple listeners gets implemented, there will only be
-     one listener in the map */
-  p_lstnr = srv_get_first_listener (ap_server);
-  assert (p_lstnr);
-  p_con = p_lstnr->p_con;
-  assert (p_con);
-
-  srv_stop_listener_io_watcher (p_lstnr);
-  if (!srv_is_listener_ready (ap_server, p_lstnr))
-    {
-      return OMX_ErrorNotReady;
-    }
-
-  srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
-
-  if (p_con->initial_burst_bytes <= 0)
-    {
-      p_con->burst_bytes = 0;
-    }
-
-  while (1)
-    {
-      if (NULL == p_hdr)
-        {
-          if (NULL == (p_hdr = ap_server->pf_acquire_buf (ap_server->p_arg)))
-            {
-              /* no more buffers available at the moment */
-              ap_server->need_more_data = true;
-              srv_stop_listener_timer_watcher (p_lstnr);
-              rc = OMX_ErrorNone;
-              break;
-            }
-          ap_server->need_more_data = false;
-          ap_server->p_hdr = p_hdr;
-        }
-
-      rc = srv_write_omx_buffer (ap_server, p_lstnr);
-
-      if (OMX_ErrorNoMore == rc)
-        {
-          (void) srv_remove_listener (ap_server, p_lstnr);
-          break;
-        }
-
-      if (OMX_ErrorNotReady == rc
-          || ((p_con->initial_burst_bytes <= 0)
-              && (p_con->burst_bytes >= ap_server->burst_size)))
-        {
-          rc = OMX_ErrorNotReady;
-          break;
-        }
-
-      /*       if (p_lstnr->pos == ap_server->p_hdr->nFilledLen) */
-      if (0 == ap_server->p_hdr->nFilledLen)
-        {
-          /* Buffer emptied */
-          (void) srv_release_empty_buffer (ap_server, p_lstnr, &p_hdr);
-        }
-    };
-
-  return rc;
-}
-
-static OMX_ERRORTYPE
-srv_stream_to_client (httpr_server_t * ap_server)
-{
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert (ap_server);
-
-  rc = srv_write (ap_server);
-  switch (rc)
-    {
-      case OMX_ErrorNone:
-      case OMX_ErrorNoMore:
-      /* Socket not ready, send buffer is full, or the burst limit has been
-         reached */
-      case OMX_ErrorNotReady:
-        {
-          /* No connected clients just yet */
-          rc = OMX_ErrorNone;
-        }
-        break;
-
-      default:
-        {
-          TIZ_ERROR (handleOf (ap_server->p_parent), "[%s]",
-                     tiz_err_to_str (rc));
-          assert (0);
-        }
-        break;
-    };
-  return rc;
-}
-
 static int
 srv_get_descriptor (const httpr_server_t * ap_server)
 {
@@ -1651,6 +1789,8 @@ httpr_srv_destroy (httpr_server_t * ap_server)
   if (ap_server)
     {
       srv_destroy_server_io_watcher (ap_server);
+      tiz_srv_timer_watcher_destroy (ap_server->p_parent,
+                                     ap_server->p_srv_ev_timer);
       if (ICE_SOCK_ERROR != ap_server->lstn_sockfd)
         {
           close (ap_server->lstn_sockfd);
@@ -1662,6 +1802,8 @@ httpr_srv_destroy (httpr_server_t * ap_server)
           tiz_map_clear (ap_server->p_lstnrs);
           tiz_map_destroy (ap_server->p_lstnrs);
         }
+      srv_ring_free (&(ap_server->ring));
+      srv_metadata_unref (ap_server->p_metadata);
       tiz_mem_free (ap_server);
     }
 }
@@ -1690,6 +1832,8 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   p_server->lstn_sockfd = ICE_SOCK_ERROR;
   p_server->p_ip = NULL;
   p_server->p_srv_ev_io = NULL;
+  p_server->p_srv_ev_timer = NULL;
+  p_server->timer_started = false;
   p_server->max_clients = a_max_clients;
   p_server->p_lstnrs = NULL;
   p_server->p_hdr = NULL;
@@ -1712,6 +1856,11 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   p_server->mountpoint.metadata_period = ICE_DEFAULT_METADATA_INTERVAL;
   p_server->mountpoint.initial_burst_size = ICE_INITIAL_BURST_SIZE;
   p_server->mountpoint.max_clients = 1;
+  tiz_mem_set (&(p_server->ring), 0, sizeof (httpr_ring_t));
+  p_server->backlog_size = ICE_DEFAULT_BACKLOG_SIZE;
+  p_server->drop_slow_clients = true;
+  p_server->p_metadata = NULL;
+  p_server->metadata_serial = 0;
 
   if (a_address)
     {
@@ -1735,6 +1884,11 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   goto_end_on_omx_error (rc, handleOf (ap_parent),
                          "Unable to alloc the server's io event");
 
+  rc = tiz_srv_timer_watcher_init (p_server->p_parent,
+                                   &(p_server->p_srv_ev_timer));
+  goto_end_on_omx_error (rc, handleOf (ap_parent),
+                         "Unable to alloc the server's timer event");
+
   /* All good so far */
   all_ok = true;
 
@@ -1768,6 +1922,9 @@ httpr_srv_start (httpr_server_t * ap_server)
   rc = srv_set_non_blocking (ap_server->lstn_sockfd);
   goto_end_on_omx_error (rc, p_hdl, "Unable to set socket as non-blocking");
 
+  rc = srv_ring_alloc (ap_server);
+  goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the stream ring");
+
   rc = srv_start_server_io_watcher (ap_server);
   goto_end_on_omx_error (rc, p_hdl, "Unable to start the server io watcher");
 
@@ -1786,21 +1943,19 @@ end:
 OMX_ERRORTYPE
 httpr_srv_stop (httpr_server_t * ap_server)
 {
-  httpr_listener_t * p_lstnr = NULL;
   assert (ap_server);
   (void) srv_stop_server_io_watcher (ap_server);
+  (void) srv_stop_server_timer_watcher (ap_server);
   if (ap_server->p_lstnrs)
     {
-      /* Until support for multiple listeners gets implemented, there will only
-         be one listener in the map */
-      p_lstnr = srv_get_first_listener (ap_server);
-      if (p_lstnr)
+      int i = 0;
+      for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
         {
-          (void) srv_stop_listener_io_watcher (p_lstnr);
-          (void) srv_stop_listener_timer_watcher (p_lstnr);
-          (void) srv_remove_listener (ap_server, p_lstnr);
+          srv_remove_listener (ap_server,
+                               tiz_map_value_at (ap_server->p_lstnrs, i));
         }
     }
+  srv_ring_reset (&(ap_server->ring));
   ap_server->running = false;
   ap_server->need_more_data = false;
   return OMX_ErrorNone;
@@ -1838,12 +1993,11 @@ httpr_srv_set_mp3_settings (httpr_server_t * ap_server, const OMX_U32 a_bitrate,
 
   ap_server->wait_time = (1 / ap_server->pkts_per_sec);
 
-  if (srv_get_listeners_count (ap_server) > 0)
+  if (ap_server->timer_started)
     {
-      httpr_listener_t * p_lstnr = srv_get_first_listener (ap_server);
-      assert (p_lstnr);
-      srv_stop_listener_timer_watcher (p_lstnr);
-      srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
+      /* Re-start the pacing timer with the new period */
+      (void) srv_stop_server_timer_watcher (ap_server);
+      (void) srv_start_server_timer_watcher (ap_server);
     }
 
   TIZ_PRINTF_DBG_MAG (
@@ -1909,6 +2063,9 @@ httpr_srv_set_stream_title (httpr_server_t * ap_server,
                             OMX_U8 * ap_stream_title)
 {
   httpr_mount_t * p_mount = NULL;
+  httpr_metadata_t * p_metadata = NULL;
+  size_t len = 0;
+  size_t nblocks = 0;
 
   assert (ap_server);
   assert (ap_stream_title);
@@ -1921,26 +2078,59 @@ httpr_srv_set_stream_title (httpr_server_t * ap_server,
            OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
   p_mount->stream_title[OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE - 1] = '\000';
 
-  if (srv_get_listeners_count (ap_server) > 0)
+  /* Build the metadata block once; all listeners send this same copy. The
+     listeners that are in the middle of sending the previous block keep their
+     reference to it. */
+  len = strnlen ((char *) p_mount->stream_title,
+                 OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
+  nblocks = MIN ((len + 15) / 16, 255);
+  if (nblocks > 0)
     {
-      httpr_listener_t * p_lstnr = srv_get_first_listener (ap_server);
-      assert (p_lstnr);
-      assert (p_lstnr->p_con);
-      p_lstnr->p_con->metadata_delivered = false;
-      p_lstnr->p_con->initial_burst_bytes
-        = ap_server->mountpoint.initial_burst_size * 0.1;
-      srv_stop_listener_timer_watcher (p_lstnr);
-      srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
+      p_metadata = (httpr_metadata_t *) tiz_mem_calloc (
+        1, sizeof (httpr_metadata_t) + nblocks * 16);
     }
+
+  srv_metadata_unref (ap_server->p_metadata);
+  ap_server->p_metadata = p_metadata;
+  ap_server->metadata_serial++;
+
+  if (p_metadata)
+    {
+      p_metadata->refs = 1;
+      p_metadata->len = 1 + nblocks * 16;
+      p_metadata->data[0] = (char) nblocks;
+      memcpy (p_metadata->data + 1, p_mount->stream_title,
+              MIN (len, nblocks * 16));
+    }
+}
+
+void
+httpr_srv_set_backlog_settings (httpr_server_t * ap_server,
+                                const OMX_U32 a_backlog_size,
+                                const bool a_drop_slow_clients)
+{
+  assert (ap_server);
+  ap_server->backlog_size
+    = (a_backlog_size > 0 ? a_backlog_size : ICE_DEFAULT_BACKLOG_SIZE);
+  ap_server->drop_slow_clients = a_drop_slow_clients;
+  TIZ_NOTICE (handleOf (ap_server->p_parent),
+              "Backlog [%u] bytes - slow clients are [%s]",
+              (unsigned int) ap_server->backlog_size,
+              (a_drop_slow_clients ? "dropped" : "skipped"));
 }
 
 OMX_ERRORTYPE
 httpr_srv_buffer_event (httpr_server_t * ap_server)
 {
   assert (ap_server);
-  return ((ap_server->running && ap_server->need_more_data)
-            ? srv_stream_to_client (ap_server)
-            : OMX_ErrorNone);
+  /* New data is only pulled when there is someone to stream to */
+  if (ap_server->running && ap_server->need_more_data
+      && ap_server->timer_started)
+    {
+      srv_ring_fill (ap_server);
+      srv_flush_listeners (ap_server);
+    }
+  return OMX_ErrorNone;
 }
 
 OMX_ERRORTYPE
@@ -1961,8 +2151,13 @@ httpr_srv_io_event (httpr_server_t * ap_server, const int a_fd)
         }
       else
         {
-          /* The client socket is ready */
-          rc = srv_stream_to_client (ap_server);
+          /* A client socket is ready */
+          httpr_listener_t * p_lstnr
+            = tiz_map_find (ap_server->p_lstnrs, (OMX_PTR) &a_fd);
+          if (p_lstnr)
+            {
+              (void) srv_serve_listener (ap_server, p_lstnr);
+            }
         }
     }
   return rc;
@@ -1972,5 +2167,14 @@ OMX_ERRORTYPE
 httpr_srv_timer_event (httpr_server_t * ap_server)
 {
   assert (ap_server);
-  return ap_server->running ? srv_stream_to_client (ap_server) : OMX_ErrorNone;
+  if (ap_server->running)
+    {
+      /* Advance the live position by one burst, and bring all the listeners
+         up to date */
+      httpr_ring_t * p_ring = &(ap_server->ring);
+      srv_ring_fill (ap_server);
+      p_ring->live = MIN (p_ring->live + ap_server->burst_size, p_ring->end);
+      srv_flush_listeners (ap_server);
+    }
+  return OMX_ErrorNone;
 }
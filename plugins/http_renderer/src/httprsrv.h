@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+
 #include <OMX_Core.h>
 #include <OMX_Types.h>
 
@@ -76,6 +78,11 @@ void
 httpr_srv_set_stream_title (httpr_server_t * ap_server,
                             OMX_U8 * ap_stream_title);
 
+void
+httpr_srv_set_backlog_settings (httpr_server_t * ap_server,
+                                const OMX_U32 a_backlog_size,
+                                const bool a_drop_slow_clients);
+
 OMX_ERRORTYPE
 httpr_srv_buffer_event (httpr_server_t * ap_server);
 OMX_ERRORTYPE
@@ -0,0 +1,244 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_mp3eseg.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Benchmark: segment-parallel mp3 encoding
+ *
+ * Encodes a generated stereo signal (a sine sweep over a bed of noise, 44.1
+ * KHz, 128 kbps, same lame settings as the component) with a single
+ * continuous lame encoder, and then with the segment-parallel encoder for an
+ * increasing number of threads. PCM is fed in chunks the size of the
+ * component's input buffers. Reports the realtime factor (seconds of audio
+ * encoded per second of wall time) and the speed-up over the continuous
+ * encoder. Usage:
+ *
+ *   bench_mp3eseg [seconds of audio] [max threads]
+ *
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <tizplatform.h>
+
+#include "mp3e.h"
+#include "mp3eseg.h"
+
+#define BENCH_MP3_RATE 44100
+#define BENCH_MP3_CHANNELS 2
+#define BENCH_MP3_BRATE 128
+#define BENCH_MP3_DEFAULT_SECS 120
+#define BENCH_MP3_DEFAULT_MAX_THREADS 8
+/* Sample frames per input buffer */
+#define BENCH_MP3_CHUNK \
+  (ARATELIA_MP3_ENCODER_PORT_MIN_INPUT_BUF_SIZE / (2 * BENCH_MP3_CHANNELS))
+
+static inline uint64_t
+now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static short *
+generate (size_t a_nsamples)
+{
+  short *p_pcm = malloc (a_nsamples * BENCH_MP3_CHANNELS * sizeof (short));
+  double phase = 0.0;
+  uint32_t seed = 22222;
+  size_t i;
+
+  if (p_pcm)
+    {
+      for (i = 0; i < a_nsamples; i++)
+        {
+          /* 50 Hz - 15 KHz sweep every 10 seconds */
+          const double t = (double) (i % (10 * BENCH_MP3_RATE)) / BENCH_MP3_RATE;
+          const double freq = 50.0 * pow (300.0, t / 10.0);
+          double noise;
+          phase += 2.0 * M_PI * freq / BENCH_MP3_RATE;
+          seed = seed * 1664525u + 1013904223u;
+          noise = ((double) (seed >> 16) / 32768.0 - 1.0) * 0.1;
+          p_pcm[2 * i] = (short) (16000.0 * (0.7 * sin (phase) + noise));
+          p_pcm[2 * i + 1] = (short) (16000.0 * (0.7 * cos (phase) - noise));
+        }
+    }
+  return p_pcm;
+}
+
+static lame_t
+new_lame (void)
+{
+  lame_t p_lame = lame_init ();
+  assert (p_lame);
+  (void) lame_set_num_channels (p_lame, BENCH_MP3_CHANNELS);
+  (void) lame_set_in_samplerate (p_lame, BENCH_MP3_RATE);
+  (void) lame_set_brate (p_lame, BENCH_MP3_BRATE);
+  (void) lame_set_mode (p_lame, JOINT_STEREO);
+  (void) lame_set_quality (p_lame, 2);
+  return p_lame;
+}
+
+static void
+report (const char *ap_name, const size_t a_nsamples, const size_t a_nbytes,
+        const uint64_t a_elapsed, const double a_base_rtf)
+{
+  const double rtf = (double) a_nsamples * 1e9
+                     / ((double) BENCH_MP3_RATE * (double) a_elapsed);
+  printf ("%-12s : %8.2f x realtime  %6.2f x speed-up  %10zu bytes\n", ap_name,
+          rtf, a_base_rtf > 0.0 ? rtf / a_base_rtf : 1.0, a_nbytes);
+}
+
+static double
+run_continuous (short *ap_pcm, const size_t a_nsamples)
+{
+  const size_t mp3_len = 5 * BENCH_MP3_CHUNK / 4 + 7200;
+  unsigned char *p_mp3 = malloc (mp3_len);
+  lame_t p_lame = new_lame ();
+  size_t nbytes = 0;
+  size_t pos = 0;
+  uint64_t start, elapsed;
+  int rc = 0;
+
+  assert (p_mp3);
+  rc = lame_init_params (p_lame);
+  assert (-1 != rc);
+
+  start = now_ns ();
+  for (pos = 0; pos < a_nsamples; pos += BENCH_MP3_CHUNK)
+    {
+      const size_t n = MIN (BENCH_MP3_CHUNK, a_nsamples - pos);
+      rc = lame_encode_buffer_interleaved (
+        p_lame, ap_pcm + pos * BENCH_MP3_CHANNELS, (int) n, p_mp3,
+        (int) mp3_len);
+      assert (rc >= 0);
+      nbytes += rc;
+    }
+  rc = lame_encode_flush (p_lame, p_mp3, (int) mp3_len);
+  assert (rc >= 0);
+  nbytes += rc;
+  elapsed = now_ns () - start;
+
+  lame_close (p_lame);
+  free (p_mp3);
+
+  report ("continuous", a_nsamples, nbytes, elapsed, 0.0);
+  return (double) a_nsamples * 1e9
+         / ((double) BENCH_MP3_RATE * (double) elapsed);
+}
+
+static void
+run_segmented (const short *ap_pcm, const size_t a_nsamples,
+               const OMX_S32 a_nthreads, const double a_base_rtf)
+{
+  mp3e_seg_t *p_seg = NULL;
+  lame_t p_lame = new_lame ();
+  size_t nbytes = 0;
+  size_t pos = 0;
+  uint64_t start, elapsed;
+  char name[32];
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  (void) lame_init_params (p_lame);
+  rc = mp3e_seg_init (&p_seg, p_lame, a_nthreads, 0);
+  assert (OMX_ErrorNone == rc);
+  lame_close (p_lame);
+
+  start = now_ns ();
+  for (pos = 0; pos < a_nsamples; pos += BENCH_MP3_CHUNK)
+    {
+      const size_t n = MIN (BENCH_MP3_CHUNK, a_nsamples - pos);
+      rc = mp3e_seg_feed (p_seg, ap_pcm + pos * BENCH_MP3_CHANNELS, n);
+      assert (OMX_ErrorNone == rc);
+      if (mp3e_seg_batch_ready (p_seg))
+        {
+          rc = mp3e_seg_encode (p_seg, false);
+          assert (OMX_ErrorNone == rc);
+          nbytes += mp3e_seg_output_available (p_seg);
+          mp3e_seg_output_consume (p_seg,
+                                   mp3e_seg_output_available (p_seg));
+        }
+    }
+  rc = mp3e_seg_encode (p_seg, true);
+  assert (OMX_ErrorNone == rc);
+  nbytes += mp3e_seg_output_available (p_seg);
+  elapsed = now_ns () - start;
+
+  mp3e_seg_destroy (p_seg);
+
+  snprintf (name, sizeof (name), "%d thread%s", (int) a_nthreads,
+            a_nthreads > 1 ? "s" : "");
+  report (name, a_nsamples, nbytes, elapsed, a_base_rtf);
+}
+
+int
+main (int argc, char **argv)
+{
+  long secs = BENCH_MP3_DEFAULT_SECS;
+  long max_threads = BENCH_MP3_DEFAULT_MAX_THREADS;
+  size_t nsamples = 0;
+  short *p_pcm = NULL;
+  double base_rtf = 0.0;
+  long nthreads = 0;
+
+  if (argc > 3)
+    {
+      fprintf (stderr, "usage: %s [seconds] [max threads]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  if (argc > 1)
+    {
+      secs = MAX (1, strtol (argv[1], NULL, 10));
+    }
+  if (argc > 2)
+    {
+      max_threads = MAX (1, strtol (argv[2], NULL, 10));
+    }
+
+  tiz_log_init ();
+
+  nsamples = (size_t) secs * BENCH_MP3_RATE;
+  if (!(p_pcm = generate (nsamples)))
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf ("lame [%s] - %ld secs, %d Hz, %d ch, %d kbps, %d frames/segment\n",
+          get_lame_version (), secs, BENCH_MP3_RATE, BENCH_MP3_CHANNELS,
+          BENCH_MP3_BRATE, MP3E_SEG_DEFAULT_FRAMES);
+
+  base_rtf = run_continuous (p_pcm, nsamples);
+  for (nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+    {
+      run_segmented (p_pcm, nsamples, (OMX_S32) nthreads, base_rtf);
+    }
+
+  free (p_pcm);
+  tiz_log_deinit ();
+  return EXIT_SUCCESS;
+}
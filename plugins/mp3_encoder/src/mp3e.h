@@ -50,6 +50,11 @@ extern "C"
 #define ARATELIA_MP3_ENCODER_PORT_NONCONTIGUOUS       OMX_FALSE
 #define ARATELIA_MP3_ENCODER_PORT_ALIGNMENT           0
 #define ARATELIA_MP3_ENCODER_PORT_SUPPLIERPREF        OMX_BufferSupplyInput
+/* Config file key to set the number of threads used to encode a stream. With
+   two or more, the stream is encoded in segments, in parallel (see
+   mp3eseg.h) */
+#define ARATELIA_MP3_ENCODER_THREADS_KEY \
+  "OMX.Aratelia.audio_encoder.mp3.encoder_threads"
 
 #ifdef __cplusplus
 }
@@ -32,6 +32,7 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <tizplatform.h>
@@ -48,6 +49,13 @@
 #endif
 
 #define TIZ_LAME_MP3_ENC_MIN_BUFFER_SIZE 7200
+#define MP3E_MAX_THREADS 32
+
+/* Forward declarations */
+static bool
+claim_input (const void *ap_obj);
+static bool
+claim_output (const void *ap_obj);
 
 static OMX_ERRORTYPE
 release_buffers (const void *ap_obj)
@@ -73,6 +81,10 @@ release_buffers (const void *ap_obj)
     }
 
   p_obj->frame_size_ = 0;
+  if (p_obj->p_seg_)
+    {
+      mp3e_seg_reset (p_obj->p_seg_);
+    }
   if (!p_obj->lame_flushed_)
     {
       if (p_obj->lame_)
@@ -192,6 +204,153 @@ encode_buffer (const void *ap_obj)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+release_output (mp3e_prc_t *ap_prc)
+{
+  assert (ap_prc);
+  assert (ap_prc->p_outhdr_);
+  ap_prc->p_outhdr_->nOffset = 0;
+  tiz_check_omx (tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                         ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX,
+                                         ap_prc->p_outhdr_));
+  ap_prc->p_outhdr_ = NULL;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+write_segmented_output (mp3e_prc_t *ap_prc)
+{
+  size_t avail = 0;
+
+  assert (ap_prc);
+  assert (ap_prc->p_seg_);
+
+  while ((avail = mp3e_seg_output_available (ap_prc->p_seg_)) > 0
+         && (ap_prc->p_outhdr_ || claim_output (ap_prc)))
+    {
+      OMX_BUFFERHEADERTYPE *p_out = ap_prc->p_outhdr_;
+      const OMX_U8 *p_mp3 = mp3e_seg_output (ap_prc->p_seg_);
+      const size_t room = p_out->nAllocLen - p_out->nFilledLen;
+      size_t nbytes = 0;
+      size_t len = 0;
+
+      /* Output buffers only carry whole frames */
+      while (nbytes < avail
+             && (len = mp3e_seg_frame_len (p_mp3 + nbytes, avail - nbytes)) > 0
+             && nbytes + len <= room)
+        {
+          nbytes += len;
+        }
+
+      if (0 == nbytes && 0 == p_out->nFilledLen)
+        {
+          TIZ_ERROR (handleOf (ap_prc), "[OMX_ErrorInsufficientResources] : "
+                     "mp3 frame does not fit in an output buffer (%u bytes)",
+                     p_out->nAllocLen);
+          return OMX_ErrorInsufficientResources;
+        }
+
+      memcpy (p_out->pBuffer + p_out->nFilledLen, p_mp3, nbytes);
+      p_out->nFilledLen += nbytes;
+      mp3e_seg_output_consume (ap_prc->p_seg_, nbytes);
+
+      if (nbytes < avail)
+        {
+          /* The next frame doesn't fit */
+          tiz_check_omx (release_output (ap_prc));
+        }
+    }
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+feed_segmented_input (mp3e_prc_t *ap_prc)
+{
+  OMX_BUFFERHEADERTYPE *p_in = NULL;
+
+  assert (ap_prc);
+  assert (ap_prc->p_inhdr_);
+
+  p_in = ap_prc->p_inhdr_;
+  if ((p_in->nFlags & OMX_BUFFERFLAG_EOS) != 0)
+    {
+      ap_prc->eos_ = true;
+    }
+
+  tiz_check_omx (mp3e_seg_feed
+                 (ap_prc->p_seg_,
+                  (const short *) (p_in->pBuffer + p_in->nOffset),
+                  p_in->nFilledLen / (ap_prc->pcmmode_.nChannels
+                                      * sizeof (short))));
+
+  p_in->nFilledLen = 0;
+  p_in->nOffset = 0;
+  tiz_check_omx (tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                         ARATELIA_MP3_ENCODER_INPUT_PORT_INDEX,
+                                         p_in));
+  ap_prc->p_inhdr_ = NULL;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+buffers_ready_segmented (mp3e_prc_t *ap_prc)
+{
+  mp3e_seg_t *p_seg = NULL;
+
+  assert (ap_prc);
+  assert (ap_prc->p_seg_);
+  p_seg = ap_prc->p_seg_;
+
+  /* Input buffers are returned as soon as their PCM is staged. A batch is
+     encoded when a full one is staged (or at EOS), and only once the output
+     of the previous one has gone out */
+  while (1)
+    {
+      tiz_check_omx (write_segmented_output (ap_prc));
+      if (mp3e_seg_output_available (p_seg) > 0)
+        {
+          /* No more output buffers at the moment */
+          break;
+        }
+
+      if (mp3e_seg_batch_ready (p_seg))
+        {
+          tiz_check_omx (mp3e_seg_encode (p_seg, false));
+          continue;
+        }
+
+      if (ap_prc->eos_)
+        {
+          if (mp3e_seg_pending (p_seg) > 0)
+            {
+              tiz_check_omx (mp3e_seg_encode (p_seg, true));
+              continue;
+            }
+          break;
+        }
+
+      if (!ap_prc->p_inhdr_ && !claim_input (ap_prc))
+        {
+          break;
+        }
+      tiz_check_omx (feed_segmented_input (ap_prc));
+    }
+
+  if (ap_prc->eos_ && 0 == mp3e_seg_pending (p_seg)
+      && 0 == mp3e_seg_output_available (p_seg)
+      && (ap_prc->p_outhdr_ || claim_output (ap_prc)))
+    {
+      TIZ_TRACE (handleOf (ap_prc),
+                 "p_prc->eos OUTPUT HEADER [%p]...", ap_prc->p_outhdr_);
+      ap_prc->p_outhdr_->nFlags |= OMX_BUFFERFLAG_EOS;
+      tiz_check_omx (release_output (ap_prc));
+      ap_prc->eos_ = false;
+    }
+
+  return OMX_ErrorNone;
+}
+
 static void
 lame_debugf (const char *format, va_list ap)
 {
@@ -355,6 +514,64 @@ set_lame_mp3_settings (void *ap_obj, OMX_HANDLETYPE ap_hdl, void *ap_krn)
   return ret_val;
 }
 
+static void
+destroy_segmented_encoder (mp3e_prc_t *ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->p_seg_)
+    {
+      mp3e_seg_stats_t stats;
+      mp3e_seg_get_stats (ap_prc->p_seg_, &stats);
+      TIZ_DEBUG (handleOf (ap_prc),
+                 "segments [%u] batches [%u] samples in [%llu] "
+                 "frames out [%llu] bytes out [%llu]",
+                 stats.nsegments, stats.nbatches,
+                 (unsigned long long) stats.nsamples_in,
+                 (unsigned long long) stats.nframes_out,
+                 (unsigned long long) stats.nbytes_out);
+      mp3e_seg_destroy (ap_prc->p_seg_);
+      ap_prc->p_seg_ = NULL;
+    }
+}
+
+static void
+create_segmented_encoder (mp3e_prc_t *ap_prc)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+  assert (ap_prc->lame_);
+
+  destroy_segmented_encoder (ap_prc);
+
+  if (ap_prc->nthreads_ < 2)
+    {
+      return;
+    }
+
+  if (16 != ap_prc->pcmmode_.nBitPerSample
+      || ap_prc->pcmmode_.nChannels != ap_prc->mp3type_.nChannels)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "Segment-parallel encoding requires "
+                  "16-bit PCM and matching channels; encoding serially");
+      return;
+    }
+
+  /* The (already configured) serial encoder is the template for the
+     encoders of each segment. Any failure here is not fatal; the stream is
+     then encoded serially */
+  if (OMX_ErrorNone != (rc = mp3e_seg_init (&(ap_prc->p_seg_), ap_prc->lame_,
+                                            ap_prc->nthreads_, 0)))
+    {
+      TIZ_WARN (handleOf (ap_prc), "[%s] : Unable to set up segment-parallel "
+                "encoding; encoding serially", tiz_err_to_str (rc));
+      return;
+    }
+
+  TIZ_NOTICE (handleOf (ap_prc), "Segment-parallel encoding - threads [%d]",
+              (int) ap_prc->nthreads_);
+}
+
 /*
  * mp3eprc
  */
@@ -370,6 +587,8 @@ mp3e_proc_ctor (void *ap_obj, va_list * app)
   p_prc->p_outhdr_ = 0;
   p_prc->eos_ = false;
   p_prc->lame_flushed_ = true;
+  p_prc->nthreads_ = 0;
+  p_prc->p_seg_ = NULL;
   return p_prc;
 }
 
@@ -379,6 +598,7 @@ mp3e_proc_dtor (void *ap_obj)
   mp3e_prc_t *p_prc = ap_obj;
   assert (p_prc);
 
+  destroy_segmented_encoder (p_prc);
   if (p_prc->lame_)
     {
       lame_close (p_prc->lame_);
@@ -396,8 +616,14 @@ static OMX_ERRORTYPE
 mp3e_proc_allocate_resources (void *ap_obj, OMX_U32 a_pid)
 {
   mp3e_prc_t *p_prc = ap_obj;
+  const char *p_threads = NULL;
   assert (p_prc);
 
+  p_threads = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                                    ARATELIA_MP3_ENCODER_THREADS_KEY);
+  p_prc->nthreads_ = p_threads ? strtol (p_threads, NULL, 10) : 0;
+  p_prc->nthreads_ = MIN (p_prc->nthreads_, MP3E_MAX_THREADS);
+
   if (NULL == (p_prc->lame_ = lame_init ()))
     {
       TIZ_ERROR (handleOf (p_prc),
@@ -422,6 +648,7 @@ mp3e_proc_deallocate_resources (void *ap_obj)
   mp3e_prc_t *p_prc = ap_obj;
   assert (p_prc);
 
+  destroy_segmented_encoder (p_prc);
   if (p_prc->lame_)
     {
       lame_close (p_prc->lame_);
@@ -466,6 +693,7 @@ mp3e_proc_prepare_to_transfer (void *ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
     }
 
   p_prc->lame_flushed_ = false;
+  create_segmented_encoder (p_prc);
 
   return OMX_ErrorNone;
 }
@@ -492,6 +720,11 @@ mp3e_proc_buffers_ready (const void *ap_obj)
   mp3e_prc_t *p_prc = (mp3e_prc_t *) ap_obj;
   assert (p_prc);
 
+  if (p_prc->p_seg_)
+    {
+      return buffers_ready_segmented (p_prc);
+    }
+
   while (1)
     {
 
@@ -35,6 +35,7 @@ extern "C"
 #endif
 
 #include "mp3eprc.h"
+#include "mp3eseg.h"
 #include "tizprc_decls.h"
 
 #include "OMX_Core.h"
@@ -58,6 +59,8 @@ extern "C"
     OMX_BUFFERHEADERTYPE *p_outhdr_;
     bool eos_;
     bool lame_flushed_;
+    OMX_S32 nthreads_;
+    mp3e_seg_t *p_seg_;
   };
 
   typedef struct mp3e_prc_class mp3e_prc_class_t;
@@ -0,0 +1,567 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mp3eseg.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Mp3 Encoder segment-parallel encoding
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <tizplatform.h>
+
+#include "mp3eseg.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.mp3_encoder.seg"
+#endif
+
+/* Worst case estimate recommended by lame for lame_encode_buffer*, plus room
+   for the flush */
+#define MP3E_SEG_MP3_BUF_SIZE(nsamples) ((5 * (nsamples)) / 4 + 2 * 7200)
+
+typedef struct mp3e_seg_job mp3e_seg_job_t;
+struct mp3e_seg_job
+{
+  mp3e_seg_t * p_seg;
+  tiz_wpool_task_t task;
+  const short * p_pcm;
+  size_t nsamples;   /* sample frames, including pre-roll and post-roll */
+  size_t nskip;      /* pre-roll frames */
+  size_t nkeep;      /* frames kept after the pre-roll; 0 means all */
+  OMX_U8 * p_mp3;
+  size_t mp3_alloc_len;
+  size_t mp3_offset; /* the frames kept */
+  size_t mp3_len;
+  size_t nframes;
+  OMX_ERRORTYPE rc;
+};
+
+struct mp3e_seg
+{
+  /* lame settings */
+  int nchannels;
+  int samplerate;
+  int brate;
+  MPEG_mode mode;
+  int quality;
+  size_t spf;           /* samples per mp3 frame */
+  size_t seg_frames;    /* mp3 frames per segment */
+  tiz_buffer_t * p_pcm; /* staged PCM */
+  size_t nhistory;      /* already encoded sample frames kept as pre-roll */
+  tiz_buffer_t * p_out; /* encoded frames, in stream order */
+  OMX_S32 nthreads;
+  tiz_wpool_t * p_pool;
+  tiz_sem_t sem;
+  mp3e_seg_job_t * p_jobs;
+  mp3e_seg_stats_t stats;
+};
+
+static const int mpeg1_brates[16]
+  = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0};
+static const int mpeg2_brates[16]
+  = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0};
+static const int srates[4][3] = {{11025, 12000, 8000}, /* MPEG 2.5 */
+                                 {0, 0, 0},            /* reserved */
+                                 {22050, 24000, 16000}, /* MPEG 2 */
+                                 {44100, 48000, 32000}}; /* MPEG 1 */
+
+static inline size_t
+frame_bytes (const mp3e_seg_t * ap_seg)
+{
+  return (size_t) ap_seg->nchannels * sizeof (short);
+}
+
+static inline size_t
+staged_samples (const mp3e_seg_t * ap_seg)
+{
+  return tiz_buffer_available (ap_seg->p_pcm) / frame_bytes (ap_seg);
+}
+
+static lame_t
+new_lame (const mp3e_seg_t * ap_seg)
+{
+  lame_t p_lame = lame_init ();
+  if (p_lame)
+    {
+      (void) lame_set_num_channels (p_lame, ap_seg->nchannels);
+      (void) lame_set_in_samplerate (p_lame, ap_seg->samplerate);
+      (void) lame_set_brate (p_lame, ap_seg->brate);
+      (void) lame_set_mode (p_lame, ap_seg->mode);
+      (void) lame_set_quality (p_lame, ap_seg->quality);
+      /* Frames must not borrow bits from the preceding ones, so that
+         segments can be spliced at any frame */
+      (void) lame_set_disable_reservoir (p_lame, 1);
+      (void) lame_set_bWriteVbrTag (p_lame, 0);
+      if (-1 == lame_init_params (p_lame))
+        {
+          lame_close (p_lame);
+          p_lame = NULL;
+        }
+    }
+  return p_lame;
+}
+
+static void
+encode_segment (void * ap_arg)
+{
+  mp3e_seg_job_t * p_job = ap_arg;
+  const mp3e_seg_t * p_seg = NULL;
+  lame_t p_lame = NULL;
+  int nbytes = 0;
+  int nflushed = 0;
+  size_t pos = 0;
+  size_t idx = 0;
+
+  assert (p_job);
+  p_seg = p_job->p_seg;
+  assert (p_seg);
+
+  p_job->mp3_offset = p_job->mp3_len = p_job->nframes = 0;
+  p_job->rc = OMX_ErrorNone;
+
+  if (!(p_lame = new_lame (p_seg)))
+    {
+      p_job->rc = OMX_ErrorInsufficientResources;
+      goto end;
+    }
+
+  /* lame does not modify the PCM, despite the prototypes */
+  nbytes = 2 == p_seg->nchannels
+             ? lame_encode_buffer_interleaved (
+                 p_lame, (short *) p_job->p_pcm, (int) p_job->nsamples,
+                 p_job->p_mp3, (int) p_job->mp3_alloc_len)
+             : lame_encode_buffer (p_lame, p_job->p_pcm, p_job->p_pcm,
+                                   (int) p_job->nsamples, p_job->p_mp3,
+                                   (int) p_job->mp3_alloc_len);
+  if (nbytes >= 0)
+    {
+      nflushed = lame_encode_flush (p_lame, p_job->p_mp3 + nbytes,
+                                    (int) p_job->mp3_alloc_len - nbytes);
+    }
+  lame_close (p_lame);
+
+  if (nbytes < 0 || nflushed < 0)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "lame error [%d] [%d]", nbytes, nflushed);
+      p_job->rc = OMX_ErrorUndefined;
+      goto end;
+    }
+  nbytes += nflushed;
+
+  /* Skip the frames of the pre-roll, and keep those of the segment proper */
+  while (pos < (size_t) nbytes
+         && (0 == p_job->nkeep || idx < p_job->nskip + p_job->nkeep))
+    {
+      const size_t len
+        = mp3e_seg_frame_len (p_job->p_mp3 + pos, (size_t) nbytes - pos);
+      if (0 == len)
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR, "Lost frame sync at [%zu]", pos);
+          p_job->rc = OMX_ErrorUndefined;
+          break;
+        }
+      if (idx == p_job->nskip)
+        {
+          p_job->mp3_offset = pos;
+        }
+      pos += len;
+      ++idx;
+    }
+
+  if (idx > p_job->nskip)
+    {
+      p_job->mp3_len = pos - p_job->mp3_offset;
+      p_job->nframes = idx - p_job->nskip;
+    }
+
+end:
+
+  if (p_job != p_seg->p_jobs)
+    {
+      /* The first job runs on the calling thread */
+      (void) tiz_sem_post (&(p_job->p_seg->sem));
+    }
+}
+
+static OMX_ERRORTYPE
+alloc_jobs (mp3e_seg_t * ap_seg)
+{
+  const size_t seg_samples
+    = (MP3E_SEG_PREROLL_FRAMES + 2 * ap_seg->seg_frames
+       + MP3E_SEG_POSTROLL_FRAMES)
+      * ap_seg->spf;
+  OMX_S32 i = 0;
+
+  tiz_check_null_ret_oom (
+    ap_seg->p_jobs = tiz_mem_calloc (ap_seg->nthreads, sizeof (mp3e_seg_job_t)));
+
+  for (i = 0; i < ap_seg->nthreads; ++i)
+    {
+      mp3e_seg_job_t * p_job = &(ap_seg->p_jobs[i]);
+      p_job->p_seg = ap_seg;
+      p_job->task.pf_run = encode_segment;
+      p_job->task.p_arg = p_job;
+      /* The last segment of a stream may take up to (almost) two segments'
+         worth of PCM */
+      p_job->mp3_alloc_len = MP3E_SEG_MP3_BUF_SIZE (seg_samples);
+      tiz_check_null_ret_oom (
+        p_job->p_mp3 = tiz_mem_alloc (p_job->mp3_alloc_len));
+    }
+  return OMX_ErrorNone;
+}
+
+static void
+dealloc_jobs (mp3e_seg_t * ap_seg)
+{
+  if (ap_seg->p_jobs)
+    {
+      OMX_S32 i = 0;
+      for (i = 0; i < ap_seg->nthreads; ++i)
+        {
+          tiz_mem_free (ap_seg->p_jobs[i].p_mp3);
+        }
+      tiz_mem_free (ap_seg->p_jobs);
+      ap_seg->p_jobs = NULL;
+    }
+}
+
+static OMX_ERRORTYPE
+encode_batch (mp3e_seg_t * ap_seg, const bool a_final)
+{
+  const size_t seg_samples = ap_seg->seg_frames * ap_seg->spf;
+  const size_t preroll = MP3E_SEG_PREROLL_FRAMES * ap_seg->spf;
+  const size_t postroll = MP3E_SEG_POSTROLL_FRAMES * ap_seg->spf;
+  const size_t total = staged_samples (ap_seg);
+  const short * p_pcm = tiz_buffer_get (ap_seg->p_pcm);
+  size_t start = ap_seg->nhistory;
+  size_t consumed = start;
+  OMX_S32 njobs = 0;
+  OMX_S32 i = 0;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  while (njobs < ap_seg->nthreads && start < total)
+    {
+      mp3e_seg_job_t * p_job = &(ap_seg->p_jobs[njobs]);
+      const size_t pre = MIN (preroll, start);
+      size_t end = start + seg_samples;
+      bool is_last = false;
+
+      if (a_final && (end > total || total - end <= postroll))
+        {
+          /* The end of the stream; the post-roll would be too short, so the
+             remaining PCM goes into this segment */
+          end = total;
+          is_last = true;
+        }
+      else if (end + postroll > total)
+        {
+          break;
+        }
+
+      p_job->p_pcm = p_pcm + (start - pre) * ap_seg->nchannels;
+      p_job->nsamples
+        = (is_last ? end : end + postroll) - (start - pre);
+      p_job->nskip = pre / ap_seg->spf;
+      p_job->nkeep = is_last ? 0 : ap_seg->seg_frames;
+      consumed = end;
+      start = end;
+      ++njobs;
+    }
+
+  if (0 == njobs)
+    {
+      return OMX_ErrorNone;
+    }
+
+  for (i = 1; i < njobs && OMX_ErrorNone == rc; ++i)
+    {
+      rc = tiz_wpool_submit (ap_seg->p_pool, &(ap_seg->p_jobs[i].task));
+      if (OMX_ErrorNone != rc)
+        {
+          njobs = i;
+        }
+    }
+
+  /* The calling thread takes the first segment */
+  encode_segment (&(ap_seg->p_jobs[0]));
+
+  for (i = 1; i < njobs; ++i)
+    {
+      (void) tiz_sem_wait (&(ap_seg->sem));
+    }
+  tiz_check_omx (rc);
+
+  /* Reassemble the frames in stream order */
+  for (i = 0; i < njobs; ++i)
+    {
+      const mp3e_seg_job_t * p_job = &(ap_seg->p_jobs[i]);
+      tiz_check_omx (p_job->rc);
+      if (p_job->mp3_len > 0
+          && tiz_buffer_push (ap_seg->p_out, p_job->p_mp3 + p_job->mp3_offset,
+                              p_job->mp3_len)
+               < (int) p_job->mp3_len)
+        {
+          return OMX_ErrorInsufficientResources;
+        }
+      ap_seg->stats.nframes_out += p_job->nframes;
+      ap_seg->stats.nbytes_out += p_job->mp3_len;
+    }
+  ap_seg->stats.nsegments += njobs;
+  ap_seg->stats.nbatches++;
+
+  if (consumed >= total)
+    {
+      /* End of stream */
+      tiz_buffer_clear (ap_seg->p_pcm);
+      ap_seg->nhistory = 0;
+    }
+  else
+    {
+      /* Keep the pre-roll of the next segment */
+      const size_t keep = MIN (preroll, consumed);
+      (void) tiz_buffer_advance (
+        ap_seg->p_pcm, (int) ((consumed - keep) * frame_bytes (ap_seg)));
+      ap_seg->nhistory = keep;
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+mp3e_seg_init (mp3e_seg_ptr_t * app_seg, lame_t ap_lame,
+               const OMX_S32 a_nthreads, const size_t a_seg_frames)
+{
+  mp3e_seg_t * p_seg = NULL;
+  lame_t p_lame = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
+
+  assert (app_seg);
+  assert (ap_lame);
+
+  tiz_check_null_ret_oom (p_seg = tiz_mem_calloc (1, sizeof (mp3e_seg_t)));
+
+  p_seg->nchannels = lame_get_num_channels (ap_lame);
+  p_seg->samplerate = lame_get_in_samplerate (ap_lame);
+  p_seg->brate = lame_get_brate (ap_lame);
+  p_seg->mode = lame_get_mode (ap_lame);
+  p_seg->quality = lame_get_quality (ap_lame);
+  p_seg->seg_frames = a_seg_frames > 0 ? a_seg_frames : MP3E_SEG_DEFAULT_FRAMES;
+  p_seg->nthreads = MAX (1, a_nthreads);
+
+  if (p_seg->nchannels < 1 || p_seg->nchannels > 2)
+    {
+      rc = OMX_ErrorBadParameter;
+      goto end;
+    }
+
+  /* A throwaway encoder validates the settings and gives the frame size */
+  if (!(p_lame = new_lame (p_seg)))
+    {
+      rc = OMX_ErrorBadParameter;
+      goto end;
+    }
+  p_seg->spf = lame_get_framesize (p_lame);
+  lame_close (p_lame);
+  if (0 == p_seg->spf)
+    {
+      rc = OMX_ErrorBadParameter;
+      goto end;
+    }
+
+  if (OMX_ErrorNone
+        != tiz_buffer_init (&(p_seg->p_pcm),
+                            (MP3E_SEG_PREROLL_FRAMES
+                             + p_seg->nthreads * p_seg->seg_frames
+                             + MP3E_SEG_POSTROLL_FRAMES)
+                              * p_seg->spf * frame_bytes (p_seg))
+      || OMX_ErrorNone != tiz_buffer_init (&(p_seg->p_out), 64 * 1024)
+      || OMX_ErrorNone != tiz_sem_init (&(p_seg->sem), 0)
+      || OMX_ErrorNone != alloc_jobs (p_seg))
+    {
+      goto end;
+    }
+
+  if (p_seg->nthreads > 1
+      && OMX_ErrorNone != tiz_wpool_init (&(p_seg->p_pool),
+                                          p_seg->nthreads - 1,
+                                          p_seg->nthreads - 1))
+    {
+      goto end;
+    }
+
+  TIZ_LOG (TIZ_PRIORITY_NOTICE,
+           "threads [%d] frames per segment [%zu] samples per frame [%zu]",
+           (int) p_seg->nthreads, p_seg->seg_frames, p_seg->spf);
+
+  rc = OMX_ErrorNone;
+
+end:
+
+  if (OMX_ErrorNone != rc)
+    {
+      mp3e_seg_destroy (p_seg);
+      p_seg = NULL;
+    }
+  *app_seg = p_seg;
+  return rc;
+}
+
+void
+mp3e_seg_destroy (mp3e_seg_t * ap_seg)
+{
+  if (ap_seg)
+    {
+      /* Destroying the pool joins the workers; no batch is in progress */
+      tiz_wpool_destroy (ap_seg->p_pool);
+      dealloc_jobs (ap_seg);
+      if (ap_seg->sem)
+        {
+          (void) tiz_sem_destroy (&(ap_seg->sem));
+        }
+      tiz_buffer_destroy (ap_seg->p_out);
+      tiz_buffer_destroy (ap_seg->p_pcm);
+      tiz_mem_free (ap_seg);
+    }
+}
+
+void
+mp3e_seg_reset (mp3e_seg_t * ap_seg)
+{
+  assert (ap_seg);
+  tiz_buffer_clear (ap_seg->p_pcm);
+  tiz_buffer_clear (ap_seg->p_out);
+  ap_seg->nhistory = 0;
+}
+
+OMX_ERRORTYPE
+mp3e_seg_feed (mp3e_seg_t * ap_seg, const short * ap_pcm,
+               const size_t a_nsamples)
+{
+  size_t nbytes = 0;
+  assert (ap_seg);
+  nbytes = a_nsamples * frame_bytes (ap_seg);
+  if (nbytes > 0
+      && (size_t) tiz_buffer_push (ap_seg->p_pcm, ap_pcm, nbytes) < nbytes)
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+  ap_seg->stats.nsamples_in += a_nsamples;
+  return OMX_ErrorNone;
+}
+
+size_t
+mp3e_seg_pending (const mp3e_seg_t * ap_seg)
+{
+  assert (ap_seg);
+  return staged_samples (ap_seg) - ap_seg->nhistory;
+}
+
+bool
+mp3e_seg_batch_ready (const mp3e_seg_t * ap_seg)
+{
+  assert (ap_seg);
+  return mp3e_seg_pending (ap_seg)
+         >= (ap_seg->nthreads * ap_seg->seg_frames + MP3E_SEG_POSTROLL_FRAMES)
+              * ap_seg->spf;
+}
+
+OMX_ERRORTYPE
+mp3e_seg_encode (mp3e_seg_t * ap_seg, const bool a_final)
+{
+  assert (ap_seg);
+  if (!a_final)
+    {
+      return encode_batch (ap_seg, false);
+    }
+  while (mp3e_seg_pending (ap_seg) > 0)
+    {
+      tiz_check_omx (encode_batch (ap_seg, true));
+    }
+  return OMX_ErrorNone;
+}
+
+size_t
+mp3e_seg_output_available (const mp3e_seg_t * ap_seg)
+{
+  assert (ap_seg);
+  return tiz_buffer_available (ap_seg->p_out);
+}
+
+const OMX_U8 *
+mp3e_seg_output (const mp3e_seg_t * ap_seg)
+{
+  assert (ap_seg);
+  return tiz_buffer_get (ap_seg->p_out);
+}
+
+void
+mp3e_seg_output_consume (mp3e_seg_t * ap_seg, const size_t a_nbytes)
+{
+  assert (ap_seg);
+  (void) tiz_buffer_advance (ap_seg->p_out, (int) a_nbytes);
+}
+
+size_t
+mp3e_seg_frame_len (const OMX_U8 * ap_data, const size_t a_nbytes)
+{
+  int version = 0;
+  int brate = 0;
+  int srate = 0;
+  size_t len = 0;
+
+  assert (ap_data);
+
+  if (a_nbytes < 4 || 0xFF != ap_data[0] || 0xE0 != (ap_data[1] & 0xE0)
+      || 0x02 != (ap_data[1] & 0x06)) /* Layer III */
+    {
+      return 0;
+    }
+
+  version = (ap_data[1] >> 3) & 0x03;
+  brate = (3 == version ? mpeg1_brates : mpeg2_brates)[ap_data[2] >> 4];
+  srate = (ap_data[2] >> 2) & 0x03;
+  if (1 == version || 0 == brate || 3 == srate)
+    {
+      return 0;
+    }
+  srate = srates[version][srate];
+
+  len = (3 == version ? 144000 : 72000) * brate / srate
+        + ((ap_data[2] >> 1) & 0x01);
+  return len <= a_nbytes ? len : 0;
+}
+
+void
+mp3e_seg_get_stats (const mp3e_seg_t * ap_seg, mp3e_seg_stats_t * ap_stats)
+{
+  assert (ap_seg);
+  assert (ap_stats);
+  *ap_stats = ap_seg->stats;
+}
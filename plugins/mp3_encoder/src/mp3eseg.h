@@ -0,0 +1,158 @@
+/**
+ * Copyright (C) 2011-2017 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mp3eseg.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Mp3 Encoder segment-parallel encoding
+ *
+ * The PCM stream is cut into segments of a fixed number of mp3 frames, and
+ * the segments of a batch are encoded concurrently, each one with its own
+ * lame encoder. The bit reservoir is disabled, so that every frame is
+ * self-contained and segments can be spliced at any frame boundary. Each
+ * segment is encoded with a few frames of the preceding PCM (pre-roll) and
+ * of the following PCM (post-roll). The frames produced from the pre-roll are
+ * discarded, as are those produced from the post-roll and the final
+ * flush. Since all encoders use the same settings, and segments start on
+ * frame boundaries, the frames that are kept line up exactly with those of
+ * a single continuous encode.
+ *
+ */
+
+#ifndef MP3ESEG_H
+#define MP3ESEG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+#include <lame/lame.h>
+
+#define MP3E_SEG_DEFAULT_FRAMES 64 /* ~1.7 secs @ 44.1 KHz */
+#define MP3E_SEG_PREROLL_FRAMES 3
+#define MP3E_SEG_POSTROLL_FRAMES 2
+
+typedef struct mp3e_seg mp3e_seg_t;
+typedef /*@null@ */ mp3e_seg_t * mp3e_seg_ptr_t;
+
+typedef struct mp3e_seg_stats mp3e_seg_stats_t;
+struct mp3e_seg_stats
+{
+  OMX_U64 nsamples_in;  /* sample frames fed */
+  OMX_U64 nframes_out;  /* mp3 frames kept */
+  OMX_U64 nbytes_out;   /* mp3 bytes kept */
+  OMX_U32 nsegments;    /* segments encoded */
+  OMX_U32 nbatches;     /* batches encoded */
+};
+
+/**
+ * Create a segment-parallel encoder.
+ *
+ * @param app_seg The new encoder (output).
+ * @param ap_lame A configured lame encoder, used as a template for the
+ * encoders of each segment (channels, sample rate, bit rate, mode and
+ * quality). It is not modified, and may be destroyed afterwards.
+ * @param a_nthreads The number of segments encoded concurrently. The calling
+ * thread encodes one of them, so a pool of (a_nthreads - 1) workers is
+ * created.
+ * @param a_seg_frames The number of mp3 frames in a segment (0 selects
+ * MP3E_SEG_DEFAULT_FRAMES).
+ * @return OMX_ErrorNone, OMX_ErrorInsufficientResources, or
+ * OMX_ErrorBadParameter if the lame settings are not usable.
+ */
+OMX_ERRORTYPE
+mp3e_seg_init (mp3e_seg_ptr_t * app_seg, lame_t ap_lame,
+               const OMX_S32 a_nthreads, const size_t a_seg_frames);
+void
+mp3e_seg_destroy (mp3e_seg_t * ap_seg);
+
+/**
+ * Drop all the PCM and mp3 data held, and start a new stream.
+ */
+void
+mp3e_seg_reset (mp3e_seg_t * ap_seg);
+
+/**
+ * Stage some interleaved, native-endian, 16-bit PCM.
+ *
+ * @param a_nsamples The number of sample frames (i.e. samples per channel).
+ */
+OMX_ERRORTYPE
+mp3e_seg_feed (mp3e_seg_t * ap_seg, const short * ap_pcm,
+               const size_t a_nsamples);
+
+/**
+ * The number of staged sample frames that have not been encoded yet.
+ */
+size_t
+mp3e_seg_pending (const mp3e_seg_t * ap_seg);
+
+/**
+ * Whether a full batch (one segment per thread, and the post-roll of the
+ * last one) is staged.
+ */
+bool
+mp3e_seg_batch_ready (const mp3e_seg_t * ap_seg);
+
+/**
+ * Encode the next batch of segments, blocking until all of them have been
+ * encoded. The resulting mp3 frames are appended, in stream order, to the
+ * encoder's output.
+ *
+ * @param a_final If false, encode only full segments, and nothing if none is
+ * ready. If true, encode all the staged PCM and flush (i.e. the end of the
+ * stream); the next PCM fed starts a new stream.
+ */
+OMX_ERRORTYPE
+mp3e_seg_encode (mp3e_seg_t * ap_seg, const bool a_final);
+
+/**
+ * The encoded mp3 bytes, always made of whole frames.
+ */
+size_t
+mp3e_seg_output_available (const mp3e_seg_t * ap_seg);
+const OMX_U8 *
+mp3e_seg_output (const mp3e_seg_t * ap_seg);
+void
+mp3e_seg_output_consume (mp3e_seg_t * ap_seg, const size_t a_nbytes);
+
+/**
+ * Retrieve the length of the mp3 frame at the start of some data.
+ *
+ * @return The length of the frame in bytes, or 0 if the data does not start
+ * with a complete Layer III frame.
+ */
+size_t
+mp3e_seg_frame_len (const OMX_U8 * ap_data, const size_t a_nbytes);
+
+void
+mp3e_seg_get_stats (const mp3e_seg_t * ap_seg, mp3e_seg_stats_t * ap_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MP3ESEG_H */
@@ -49,6 +49,11 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.ogg_demuxer.prc"
 #endif
 
+/* Each port's carry-over store holds this many buffers worth of packet data,
+   or at least OGGDMUX_SPILL_MIN_SIZE bytes */
+#define OGGDMUX_SPILL_BUFFERS 4
+#define OGGDMUX_SPILL_MIN_SIZE (1024 * 1024)
+
 #define on_oggz_error_ret_omx_oom(expr)                    \
   do                                                       \
     {                                                      \
@@ -209,10 +214,11 @@ alloc_data_stores (oggdmux_prc_t * ap_prc)
                           OMX_IndexParamPortDefinition, &port_def));
   ap_prc->aud_buf_size_ = port_def.nBufferSize;
 
-  assert (ap_prc->p_aud_store_ == NULL);
-  ap_prc->aud_store_size_ = port_def.nBufferSize;
-  tiz_check_null_ret_oom (
-    (ap_prc->p_aud_store_ = tiz_mem_alloc (ap_prc->aud_store_size_)) != NULL);
+  assert (!ap_prc->p_aud_spill_);
+  tiz_check_omx (tiz_filter_spill_init (
+    &(ap_prc->p_aud_spill_),
+    MAX (OGGDMUX_SPILL_BUFFERS * port_def.nBufferSize, OGGDMUX_SPILL_MIN_SIZE),
+    1));
 
   port_def.nPortIndex = ARATELIA_OGG_DEMUXER_VIDEO_PORT_BASE_INDEX;
   tiz_check_omx (
@@ -220,10 +226,11 @@ alloc_data_stores (oggdmux_prc_t * ap_prc)
                           OMX_IndexParamPortDefinition, &port_def));
   ap_prc->vid_buf_size_ = port_def.nBufferSize;
 
-  assert (ap_prc->p_vid_store_ == NULL);
-  ap_prc->vid_store_size_ = port_def.nBufferSize;
-  tiz_check_null_ret_oom (
-    (ap_prc->p_vid_store_ = tiz_mem_alloc (ap_prc->vid_store_size_)) != NULL);
+  assert (!ap_prc->p_vid_spill_);
+  tiz_check_omx (tiz_filter_spill_init (
+    &(ap_prc->p_vid_spill_),
+    MAX (OGGDMUX_SPILL_BUFFERS * port_def.nBufferSize, OGGDMUX_SPILL_MIN_SIZE),
+    1));
 
   return OMX_ErrorNone;
 }
@@ -234,8 +241,11 @@ alloc_oggz (oggdmux_prc_t * ap_prc)
   assert (ap_prc);
   assert (!ap_prc->p_oggz_);
 
-  /* Allocate the oggz object */
-  tiz_check_null_ret_oom ((ap_prc->p_oggz_ = oggz_new (OGGZ_READ)));
+  /* Allocate the oggz object. With OGGZ_AUTO, liboggz works out the
+     granulepos metrics of the known codecs, which is what makes
+     oggz_seek_units and oggz_tell_units work */
+  tiz_check_null_ret_oom (
+    (ap_prc->p_oggz_ = oggz_new (OGGZ_READ | OGGZ_AUTO)));
 
   /* Allocate a table */
   tiz_check_null_ret_oom ((ap_prc->p_tracks_ = oggz_table_new ()));
@@ -293,57 +303,70 @@ dealloc_uri (/*@special@ */ oggdmux_prc_t * ap_prc)
   ap_prc->p_uri_ = NULL;
 }
 
-static inline void
-dealloc_data_stores (/*@special@ */ oggdmux_prc_t * ap_prc)
-/*@releases ap_prc->p_aud_store_, ap_prc->p_vid_store_ @ */
-/*@ensures isnull ap_prc->p_aud_store_, ap_prc->p_vid_store_ @ */
+static void
+log_spill_stats (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid,
+                 const tiz_filter_spill_t * ap_spill)
 {
+  tiz_filter_spill_stats_t stats;
   assert (ap_prc);
-  tiz_mem_free (ap_prc->p_aud_store_);
-  tiz_mem_free (ap_prc->p_vid_store_);
-  ap_prc->p_aud_store_ = NULL;
-  ap_prc->p_vid_store_ = NULL;
-  ap_prc->aud_store_size_ = 0;
-  ap_prc->vid_store_size_ = 0;
-  ap_prc->aud_store_offset_ = 0;
-  ap_prc->vid_store_offset_ = 0;
+  assert (ap_spill);
+  tiz_filter_spill_get_stats (ap_spill, &stats);
+  TIZ_DEBUG (handleOf (ap_prc),
+             "pid [%d] spill : capacity [%zu] high water [%zu] "
+             "carry-overs [%u] spilled [%llu] drained [%llu] dropped [%llu]",
+             a_pid, stats.capacity, stats.high_water, stats.nspills,
+             (unsigned long long) stats.nbytes_spilled,
+             (unsigned long long) stats.nbytes_drained,
+             (unsigned long long) stats.nbytes_dropped);
 }
 
-static inline OMX_U8 **
-get_store_ptr (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
+static inline void
+dealloc_data_stores (/*@special@ */ oggdmux_prc_t * ap_prc)
+/*@releases ap_prc->p_aud_spill_, ap_prc->p_vid_spill_ @ */
+/*@ensures isnull ap_prc->p_aud_spill_, ap_prc->p_vid_spill_ @ */
 {
-  OMX_U8 ** pp_store = NULL;
   assert (ap_prc);
-  assert (a_pid <= ARATELIA_OGG_DEMUXER_VIDEO_PORT_BASE_INDEX);
-  pp_store = a_pid == ARATELIA_OGG_DEMUXER_AUDIO_PORT_BASE_INDEX
-               ? &(ap_prc->p_aud_store_)
-               : &(ap_prc->p_vid_store_);
-  return pp_store;
+  if (ap_prc->p_aud_spill_)
+    {
+      log_spill_stats (ap_prc, ARATELIA_OGG_DEMUXER_AUDIO_PORT_BASE_INDEX,
+                       ap_prc->p_aud_spill_);
+    }
+  if (ap_prc->p_vid_spill_)
+    {
+      log_spill_stats (ap_prc, ARATELIA_OGG_DEMUXER_VIDEO_PORT_BASE_INDEX,
+                       ap_prc->p_vid_spill_);
+    }
+  tiz_filter_spill_destroy (ap_prc->p_aud_spill_);
+  tiz_filter_spill_destroy (ap_prc->p_vid_spill_);
+  ap_prc->p_aud_spill_ = NULL;
+  ap_prc->p_vid_spill_ = NULL;
 }
 
-static inline OMX_U32 *
-get_store_size_ptr (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
+static inline void
+clear_data_stores (oggdmux_prc_t * ap_prc)
 {
-  OMX_U32 * p_size = NULL;
   assert (ap_prc);
-  assert (a_pid <= ARATELIA_OGG_DEMUXER_VIDEO_PORT_BASE_INDEX);
-  p_size = a_pid == ARATELIA_OGG_DEMUXER_AUDIO_PORT_BASE_INDEX
-             ? &(ap_prc->aud_store_size_)
-             : &(ap_prc->vid_store_size_);
-  return p_size;
+  if (ap_prc->p_aud_spill_)
+    {
+      tiz_filter_spill_clear (ap_prc->p_aud_spill_);
+    }
+  if (ap_prc->p_vid_spill_)
+    {
+      tiz_filter_spill_clear (ap_prc->p_vid_spill_);
+    }
 }
 
-static inline OMX_U32 *
-get_store_offset_ptr (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
+static inline tiz_filter_spill_t *
+get_spill (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
 {
-  OMX_U32 * p_offset = NULL;
+  tiz_filter_spill_t * p_spill = NULL;
   assert (ap_prc);
   assert (a_pid <= ARATELIA_OGG_DEMUXER_VIDEO_PORT_BASE_INDEX);
-  p_offset = a_pid == ARATELIA_OGG_DEMUXER_AUDIO_PORT_BASE_INDEX
-               ? &(ap_prc->aud_store_offset_)
-               : &(ap_prc->vid_store_offset_);
-  assert (p_offset);
-  return p_offset;
+  p_spill = a_pid == ARATELIA_OGG_DEMUXER_AUDIO_PORT_BASE_INDEX
+              ? ap_prc->p_aud_spill_
+              : ap_prc->p_vid_spill_;
+  assert (p_spill);
+  return p_spill;
 }
 
 static inline bool *
@@ -385,129 +408,6 @@ get_eos_ptr (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
   return p_eos;
 }
 
-static int
-store_data (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid, const OMX_U8 * ap_data,
-            OMX_U32 a_nbytes)
-{
-  OMX_U8 ** pp_store = NULL;
-  OMX_U32 * p_offset = NULL;
-  OMX_U32 * p_size = NULL;
-  OMX_U32 nbytes_to_copy = 0;
-  OMX_U32 nbytes_avail = 0;
-
-  assert (ap_prc);
-  assert (a_pid <= ARATELIA_OGG_DEMUXER_VIDEO_PORT_BASE_INDEX);
-  assert (ap_data);
-
-  pp_store = get_store_ptr (ap_prc, a_pid);
-  p_size = get_store_size_ptr (ap_prc, a_pid);
-  p_offset = get_store_offset_ptr (ap_prc, a_pid);
-
-  assert (pp_store && *pp_store);
-  assert (p_size);
-  assert (p_offset);
-
-  nbytes_avail = *p_size - *p_offset;
-
-  if (a_nbytes > nbytes_avail)
-    {
-      /* need to re-alloc */
-      OMX_U8 * p_new_store = NULL;
-      p_new_store = tiz_mem_realloc (*pp_store, *p_offset + a_nbytes);
-      if (p_new_store)
-        {
-          *pp_store = p_new_store;
-          *p_size = *p_offset + a_nbytes;
-          nbytes_avail = *p_size - *p_offset;
-          TIZ_TRACE (handleOf (ap_prc),
-                     "pid [%d] : Realloc'd data store "
-                     "to new size [%d]",
-                     a_pid, *p_size);
-        }
-    }
-  nbytes_to_copy = MIN (nbytes_avail, a_nbytes);
-  memcpy (*pp_store + *p_offset, ap_data, nbytes_to_copy);
-  *p_offset += nbytes_to_copy;
-
-  TIZ_TRACE (handleOf (ap_prc), "pid [%d]: bytes currently stored [%d]", a_pid,
-             *p_offset);
-
-  return a_nbytes - nbytes_to_copy;
-}
-
-static int
-dump_temp_store (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid,
-                 OMX_BUFFERHEADERTYPE * ap_hdr)
-{
-  OMX_U8 * p_store = NULL;
-  OMX_U32 * p_offset = NULL;
-  OMX_U32 nbytes_to_copy = 0;
-  OMX_U32 nbytes_avail = 0;
-
-  assert (ap_prc);
-  assert (a_pid <= ARATELIA_OGG_DEMUXER_VIDEO_PORT_BASE_INDEX);
-  assert (ap_hdr);
-
-  p_store = *(get_store_ptr (ap_prc, a_pid));
-  p_offset = get_store_offset_ptr (ap_prc, a_pid);
-
-  assert (p_store);
-  assert (p_offset);
-  assert (ap_hdr->nAllocLen >= ap_hdr->nFilledLen);
-
-  nbytes_avail = ap_hdr->nAllocLen - ap_hdr->nFilledLen;
-  nbytes_to_copy = MIN (*p_offset, nbytes_avail);
-
-  if (nbytes_to_copy > 0)
-    {
-      memcpy (ap_hdr->pBuffer + ap_hdr->nFilledLen, p_store, nbytes_to_copy);
-      ap_hdr->nFilledLen += nbytes_to_copy;
-      *p_offset -= nbytes_to_copy;
-      if (*p_offset > 0)
-        {
-          memmove (p_store, p_store + nbytes_to_copy, *p_offset);
-        }
-      TIZ_TRACE (handleOf (ap_prc),
-                 "HEADER [%p] pid [%d] nFilledLen [%d] "
-                 "offset [%d]",
-                 ap_hdr, a_pid, ap_hdr->nFilledLen, *p_offset);
-    }
-
-  return *p_offset;
-}
-
-static OMX_U32
-dump_ogg_data (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid,
-               const OMX_U8 * ap_ogg_data, const OMX_U32 a_nbytes,
-               OMX_BUFFERHEADERTYPE * ap_hdr)
-{
-  OMX_U32 nbytes_copied = 0;
-  OMX_U32 nbytes_avail = 0;
-
-  assert (ap_prc);
-  assert (a_pid <= ARATELIA_OGG_DEMUXER_VIDEO_PORT_BASE_INDEX);
-  assert (ap_ogg_data);
-  assert (ap_hdr);
-
-  assert (ap_hdr->nAllocLen >= ap_hdr->nFilledLen);
-
-  nbytes_avail = ap_hdr->nAllocLen - ap_hdr->nFilledLen;
-  nbytes_copied = MIN (a_nbytes, nbytes_avail);
-
-  if (nbytes_copied > 0)
-    {
-      memcpy (ap_hdr->pBuffer + ap_hdr->nFilledLen, ap_ogg_data, nbytes_copied);
-      ap_hdr->nFilledLen += nbytes_copied;
-    }
-
-  TIZ_TRACE (handleOf (ap_prc),
-             "HEADER [%p] pid [%d] nbytes [%d] "
-             "nbytes_copied [%d] nFilledLen [%d]",
-             ap_hdr, a_pid, a_nbytes, nbytes_copied, ap_hdr->nFilledLen);
-
-  return nbytes_copied;
-}
-
 static OMX_BUFFERHEADERTYPE *
 get_header (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
 {
@@ -586,12 +486,10 @@ static int
 flush_temp_store (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
 {
   OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-  OMX_U32 * p_offset = get_store_offset_ptr (ap_prc, a_pid);
-  OMX_U32 ds_offset = *p_offset;
+  tiz_filter_spill_t * p_spill = get_spill (ap_prc, a_pid);
+  OMX_U32 ds_offset = tiz_filter_spill_available (p_spill);
 
-  assert (p_offset);
-
-  if (0 == *p_offset)
+  if (0 == ds_offset)
     {
       /* The temp store is empty */
       return 0;
@@ -599,17 +497,21 @@ flush_temp_store (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid)
 
   while ((p_hdr = get_header (ap_prc, a_pid)))
     {
-      ds_offset = dump_temp_store (ap_prc, a_pid, p_hdr);
+      (void) tiz_filter_spill_scatter (p_spill, &p_hdr, 1, NULL, 0);
+      ds_offset = tiz_filter_spill_available (p_spill);
+      TIZ_TRACE (handleOf (ap_prc),
+                 "HEADER [%p] pid [%d] nFilledLen [%d] "
+                 "offset [%d]",
+                 p_hdr, a_pid, p_hdr->nFilledLen, ds_offset);
 #ifdef _DEBUG
       if (a_pid == ARATELIA_OGG_DEMUXER_AUDIO_PORT_BASE_INDEX)
         {
           g_total_released += p_hdr->nFilledLen;
-          OMX_U32 * p_offset = get_store_offset_ptr (ap_prc, a_pid);
           TIZ_TRACE (handleOf (ap_prc),
                      "total released [%d] "
                      "total read [%d] store [%d] last read [%d] diff [%d]",
-                     g_total_released, g_total_read, *p_offset, g_last_read,
-                     g_total_read - (g_total_released + *p_offset));
+                     g_total_released, g_total_read, ds_offset, g_last_read,
+                     g_total_read - (g_total_released + ds_offset));
         }
 #endif
       if (ap_prc->file_eos_ && 0 == ds_offset)
@@ -638,26 +540,31 @@ flush_ogg_packet (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid,
                   const OMX_U8 * ap_ogg_data, const OMX_U32 nbytes)
 {
   OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  tiz_filter_spill_t * p_spill = get_spill (ap_prc, a_pid);
   OMX_U32 nbytes_remaining = nbytes;
   OMX_U32 nbytes_copied = 0;
   OMX_U32 op_offset = 0;
 
   while ((p_hdr = get_header (ap_prc, a_pid)))
     {
-      nbytes_copied = dump_ogg_data (ap_prc, a_pid, ap_ogg_data + op_offset,
-                                     nbytes_remaining, p_hdr);
+      nbytes_copied = tiz_filter_spill_scatter (
+        p_spill, &p_hdr, 1, ap_ogg_data + op_offset, nbytes_remaining);
       nbytes_remaining -= nbytes_copied;
       op_offset += nbytes_copied;
+      TIZ_TRACE (handleOf (ap_prc),
+                 "HEADER [%p] pid [%d] nbytes [%d] "
+                 "nbytes_copied [%d] nFilledLen [%d]",
+                 p_hdr, a_pid, nbytes, nbytes_copied, p_hdr->nFilledLen);
 #ifdef _DEBUG
       if (a_pid == ARATELIA_OGG_DEMUXER_AUDIO_PORT_BASE_INDEX)
         {
           g_total_released += p_hdr->nFilledLen;
-          OMX_U32 * p_offset = get_store_offset_ptr (ap_prc, a_pid);
           TIZ_TRACE (handleOf (ap_prc),
                      "total released [%d] "
                      "total read [%d] store [%d] last read [%d] "
                      "remaining [%d] diff [%d]",
-                     g_total_released, g_total_read, *p_offset, g_last_read,
+                     g_total_released, g_total_read,
+                     (int) tiz_filter_spill_available (p_spill), g_last_read,
                      nbytes_remaining,
                      g_total_read - (g_total_released + nbytes_remaining));
         }
@@ -676,8 +583,8 @@ flush_ogg_packet (oggdmux_prc_t * ap_prc, const OMX_U32 a_pid,
        * available */
       TIZ_TRACE (handleOf (ap_prc), "Need to store [%d] bytes - pid [%d]",
                  nbytes_remaining, a_pid);
-      nbytes_remaining
-        = store_data (ap_prc, a_pid, ap_ogg_data + op_offset, nbytes_remaining);
+      nbytes_remaining -= tiz_filter_spill_push (
+        p_spill, ap_ogg_data + op_offset, nbytes_remaining);
     }
 
   return nbytes_remaining;
@@ -735,7 +642,7 @@ read_packet (OGGZ * ap_oggz, oggz_packet * ap_zp, long serialno,
   if (0 == op_offset)
     {
       if (*p_eos || !get_header (p_prc, a_pid)
-          || (*get_store_offset_ptr (p_prc, a_pid)) > 0)
+          || tiz_filter_spill_available (get_spill (p_prc, a_pid)) > 0)
         {
           rc = OGGZ_STOP_OK;
         }
@@ -826,8 +733,7 @@ do_flush (oggdmux_prc_t * ap_prc)
   assert (ap_prc);
   TIZ_TRACE (handleOf (ap_prc), "do_flush");
   (void) oggz_purge (ap_prc->p_oggz_);
-  ap_prc->aud_store_offset_ = 0;
-  ap_prc->vid_store_offset_ = 0;
+  clear_data_stores (ap_prc);
   /* Release any buffers held  */
   return release_all_buffers (ap_prc, OMX_ALL);
 }
@@ -1051,9 +957,9 @@ demux_file (oggdmux_prc_t * ap_prc)
       /* Try to empty the temp stores out to an omx buffer */
       remaining = flush_stores (ap_prc);
       TIZ_TRACE (handleOf (ap_prc),
-                 "aud_store_offset [%d] vid_store_offset [%d] - total [%d]",
-                 ap_prc->aud_store_offset_, ap_prc->vid_store_offset_,
-                 remaining);
+                 "aud_store_offset [%zu] vid_store_offset [%zu] - total [%d]",
+                 tiz_filter_spill_available (ap_prc->p_aud_spill_),
+                 tiz_filter_spill_available (ap_prc->p_vid_spill_), remaining);
 
       if (!ap_prc->aud_eos_)
         {
@@ -1070,6 +976,40 @@ demux_file (oggdmux_prc_t * ap_prc)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+apply_seek (oggdmux_prc_t * ap_prc)
+{
+  ogg_int64_t units = 0;
+  assert (ap_prc);
+
+  if (!ap_prc->seek_pending_ || !ap_prc->p_oggz_)
+    {
+      return OMX_ErrorNone;
+    }
+  ap_prc->seek_pending_ = false;
+
+  /* Whatever is waiting in the temp stores belongs to the old position */
+  clear_data_stores (ap_prc);
+
+  /* liboggz bisects the file on the granule positions of its pages; units
+     are milliseconds */
+  if ((units = oggz_seek_units (ap_prc->p_oggz_, ap_prc->seek_target_ / 1000,
+                                SEEK_SET))
+      < 0)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "Unable to seek to [%lld] ms",
+                  (long long) (ap_prc->seek_target_ / 1000));
+      return OMX_ErrorNone;
+    }
+
+  ap_prc->file_eos_ = false;
+  ap_prc->aud_eos_ = false;
+  ap_prc->vid_eos_ = false;
+  TIZ_NOTICE (handleOf (ap_prc), "Seek to [%lld] ms - at [%lld] ms",
+              (long long) (ap_prc->seek_target_ / 1000), (long long) units);
+  return OMX_ErrorNone;
+}
+
 /*
  * oggdmuxprc
  */
@@ -1090,17 +1030,15 @@ oggdmux_prc_ctor (void * ap_obj, va_list * app)
   p_prc->aud_buf_size_ = 0;
   p_prc->vid_buf_size_ = 0;
   p_prc->awaiting_buffers_ = true;
-  p_prc->p_aud_store_ = NULL;
-  p_prc->p_vid_store_ = NULL;
-  p_prc->aud_store_size_ = 0;
-  p_prc->vid_store_size_ = 0;
-  p_prc->aud_store_offset_ = 0;
-  p_prc->vid_store_offset_ = 0;
+  p_prc->p_aud_spill_ = NULL;
+  p_prc->p_vid_spill_ = NULL;
   p_prc->file_eos_ = false;
   p_prc->aud_eos_ = false;
   p_prc->vid_eos_ = false;
   p_prc->aud_port_disabled_ = false;
   p_prc->vid_port_disabled_ = false;
+  p_prc->seek_pending_ = false;
+  p_prc->seek_target_ = 0;
 
   return p_prc;
 }
@@ -1168,6 +1106,71 @@ oggdmux_prc_stop_and_return (void * ap_obj)
   return do_flush (p_prc);
 }
 
+/*
+ * from tizapi class
+ */
+
+static OMX_ERRORTYPE
+oggdmux_prc_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                       OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  oggdmux_prc_t * p_prc = (oggdmux_prc_t *) ap_obj;
+  assert (p_prc);
+  assert (ap_struct);
+
+  if (OMX_IndexConfigTimePosition == a_index)
+    {
+      OMX_TIME_CONFIG_TIMESTAMPTYPE * p_pos = ap_struct;
+      ogg_int64_t units = -1;
+      if (!p_prc->p_oggz_ || (units = oggz_tell_units (p_prc->p_oggz_)) < 0)
+        {
+          return OMX_ErrorUnsupportedSetting;
+        }
+      p_pos->nTimestamp
+        = p_prc->seek_pending_ ? p_prc->seek_target_ : units * 1000;
+      return OMX_ErrorNone;
+    }
+  else if (OMX_IndexConfigTimeSeekMode == a_index)
+    {
+      OMX_TIME_CONFIG_SEEKMODETYPE * p_mode = ap_struct;
+      /* Seeks land on a page boundary at or before the requested time */
+      p_mode->eType = OMX_TIME_SeekModeFast;
+      return OMX_ErrorNone;
+    }
+
+  return super_GetConfig (typeOf (ap_obj, "oggdmuxprc"), ap_obj, ap_hdl,
+                          a_index, ap_struct);
+}
+
+static OMX_ERRORTYPE
+oggdmux_prc_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                       OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  oggdmux_prc_t * p_prc = (oggdmux_prc_t *) ap_obj;
+  assert (p_prc);
+  assert (ap_struct);
+
+  if (OMX_IndexConfigTimePosition == a_index)
+    {
+      const OMX_TIME_CONFIG_TIMESTAMPTYPE * p_pos = ap_struct;
+      /* Called by both the config port and the kernel; the seek itself is
+         carried out once, in the processor's own context */
+      p_prc->seek_target_ = MAX (0, p_pos->nTimestamp);
+      p_prc->seek_pending_ = true;
+    }
+  else if (OMX_IndexConfigTimeSeekMode == a_index)
+    {
+      const OMX_TIME_CONFIG_SEEKMODETYPE * p_mode = ap_struct;
+      if (OMX_TIME_SeekModeFast != p_mode->eType)
+        {
+          return OMX_ErrorUnsupportedSetting;
+        }
+    }
+
+  return super_SetConfig (typeOf (ap_obj, "oggdmuxprc"), ap_obj, ap_hdl,
+                          a_index, ap_struct);
+}
+
 /*
  * from tizprc class
  */
@@ -1178,6 +1181,8 @@ oggdmux_prc_buffers_ready (const void * ap_obj)
   oggdmux_prc_t * p_prc = (oggdmux_prc_t *) ap_obj;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (p_prc);
+
+  tiz_check_omx (apply_seek (p_prc));
   TIZ_TRACE (handleOf (p_prc),
              "awaiting_buffers [%s] aud eos [%s] "
              "vid eos [%s]",
@@ -1241,6 +1246,19 @@ oggdmux_prc_port_enable (const void * ap_obj, OMX_U32 a_pid)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+oggdmux_prc_config_change (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid),
+                           OMX_INDEXTYPE a_config_idx)
+{
+  oggdmux_prc_t * p_prc = ap_obj;
+  assert (p_prc);
+  if (OMX_IndexConfigTimePosition == a_config_idx)
+    {
+      return apply_seek (p_prc);
+    }
+  return OMX_ErrorNone;
+}
+
 /*
  * oggdmux_prc_class
  */
@@ -1298,6 +1316,10 @@ oggdmux_prc_init (void * ap_tos, void * ap_hdl)
      /* TIZ_CLASS_COMMENT: */
      tiz_srv_stop_and_return, oggdmux_prc_stop_and_return,
      /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetConfig, oggdmux_prc_GetConfig,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_SetConfig, oggdmux_prc_SetConfig,
+     /* TIZ_CLASS_COMMENT: */
      tiz_prc_port_flush, oggdmux_prc_port_flush,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_port_disable, oggdmux_prc_port_disable,
@@ -1305,6 +1327,8 @@ oggdmux_prc_init (void * ap_tos, void * ap_hdl)
      tiz_prc_port_enable, oggdmux_prc_port_enable,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, oggdmux_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, oggdmux_prc_config_change,
      /* TIZ_CLASS_COMMENT: stop value*/
      0);
 
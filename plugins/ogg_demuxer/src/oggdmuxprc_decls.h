@@ -37,6 +37,7 @@ extern "C" {
 #include <oggz/oggz.h>
 
 #include <tizprc_decls.h>
+#include <tizfilterprc.h>
 
 typedef struct oggdmux_prc oggdmux_prc_t;
 struct oggdmux_prc
@@ -52,17 +53,15 @@ struct oggdmux_prc
   OMX_U32 aud_buf_size_;
   OMX_U32 vid_buf_size_;
   bool awaiting_buffers_;
-  OMX_U8 * p_aud_store_;
-  OMX_U8 * p_vid_store_;
-  OMX_U32 aud_store_size_;
-  OMX_U32 vid_store_size_;
-  OMX_U32 aud_store_offset_;
-  OMX_U32 vid_store_offset_;
+  tiz_filter_spill_t * p_aud_spill_;
+  tiz_filter_spill_t * p_vid_spill_;
   bool file_eos_;
   bool aud_eos_;
   bool vid_eos_;
   bool aud_port_disabled_;
   bool vid_port_disabled_;
+  bool seek_pending_;
+  OMX_TICKS seek_target_;
 };
 
 typedef struct oggdmux_prc_class oggdmux_prc_class_t;
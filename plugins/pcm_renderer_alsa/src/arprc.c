@@ -32,9 +32,8 @@
 
 #include <assert.h>
 #include <errno.h>
-#include <math.h>
+#include <stdlib.h>
 #include <string.h>
-#include <byteswap.h>
 
 #include <tizplatform.h>
 
@@ -195,14 +194,14 @@ static void verify_alsa_pcm_format_support (
               *ap_snd_pcm_format = SND_PCM_FORMAT_FLOAT_LE;
             }
             break;
-          case SND_PCM_FORMAT_S24:
+          case SND_PCM_FORMAT_S24_3LE:
             {
-              *ap_snd_pcm_format = SND_PCM_FORMAT_S24_BE;
+              *ap_snd_pcm_format = SND_PCM_FORMAT_S24_3BE;
             }
             break;
-          case SND_PCM_FORMAT_S24_BE:
+          case SND_PCM_FORMAT_S24_3BE:
             {
-              *ap_snd_pcm_format = SND_PCM_FORMAT_S24;
+              *ap_snd_pcm_format = SND_PCM_FORMAT_S24_3LE;
             }
             break;
           case SND_PCM_FORMAT_S16:
@@ -237,11 +236,16 @@ static OMX_ERRORTYPE retrieve_alsa_pcm_format (
       tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
                             OMX_IndexParamAudioPcm, &ap_prc->pcmmode));
 
+  /* Anything other than 24 or 32 bits is rendered as S16 (see below) */
+  ap_prc->pcm_fmt_ = ETIZPcmFmtS16;
+  (void)tiz_pcm_fmt_from_pcmmode (&ap_prc->pcmmode, &ap_prc->pcm_fmt_);
+
+  /* 24-bit samples are packed in 3 bytes (e.g. from the flac decoder) */
   if (ap_prc->pcmmode.nBitPerSample == 24)
     {
       *ap_snd_pcm_format = ap_prc->pcmmode.eEndian == OMX_EndianLittle
-                           ? SND_PCM_FORMAT_S24
-                           : SND_PCM_FORMAT_S24_BE;
+                           ? SND_PCM_FORMAT_S24_3LE
+                           : SND_PCM_FORMAT_S24_3BE;
     }
   /* NOTE: this is to allow float pcm streams coming from the the vorbis or
      opusfile decoders */
@@ -304,6 +308,34 @@ static OMX_ERRORTYPE retrieve_alsa_pcm_format (
              : ARATELIA_AUDIO_RENDERER_DEFAULT_ALSA_DEVICE;
 }
 
+static void load_gain (ar_prc_t *ap_prc)
+{
+  const char *p_gain = NULL;
+
+  assert (ap_prc);
+
+  /* Software gain (pre-amp), in dB, applied to every sample before it
+     reaches ALSA; the volume is still set on ALSA's mixer */
+  p_gain = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                                 "OMX.Aratelia.audio_renderer.alsa.pcm.gain");
+  ap_prc->gain_ = p_gain ? strtof (p_gain, NULL)
+                         : ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE;
+  if (ap_prc->gain_ < ARATELIA_AUDIO_RENDERER_MIN_GAIN_VALUE)
+    {
+      ap_prc->gain_ = ARATELIA_AUDIO_RENDERER_MIN_GAIN_VALUE;
+    }
+  else if (ap_prc->gain_ > ARATELIA_AUDIO_RENDERER_MAX_GAIN_VALUE)
+    {
+      ap_prc->gain_ = ARATELIA_AUDIO_RENDERER_MAX_GAIN_VALUE;
+    }
+  ap_prc->gain_factor_ = tiz_pcm_db_to_gain (ap_prc->gain_);
+  if (ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "Software gain [%.2f] dB",
+                  ap_prc->gain_);
+    }
+}
+
 /*@null@*/ static char *get_alsa_mixer (ar_prc_t *ap_prc)
 {
   assert (ap_prc);
@@ -391,73 +423,33 @@ static inline OMX_ERRORTYPE do_flush (ar_prc_t *ap_prc)
   return release_header (ap_prc);
 }
 
-static float sint_to_float (const int a_sample)
-{
-  float f;
-  if (a_sample >= 0)
-    f = a_sample / 32767.0;
-  else
-    f = a_sample / 32768.0;
-  return f;
-}
-
-static int float_to_sint (const float a_sample)
-{
-  float f;
-  f = a_sample * 32767;
-  if (f < -32768)
-    f = -32768;
-  if (f > 32767)
-    f = 32767;
-  return (int)f;
-}
-
-static void adjust_gain (const ar_prc_t *ap_prc, OMX_BUFFERHEADERTYPE *ap_hdr,
-                         const snd_pcm_uframes_t a_samples_per_channel)
+static void adjust_gain (const ar_prc_t *ap_prc, OMX_BUFFERHEADERTYPE *ap_hdr)
 {
   assert (ap_prc);
   assert (ap_hdr);
 
-  if (ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+  /* Only once per buffer; partially rendered buffers have a non-zero offset */
+  if (ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_
+      && !ap_hdr->nOffset)
     {
-      int i;
-      int gainadj = (int)(ap_prc->gain_ * 256.);
-      float gain = pow (10., gainadj / 5120.);
-      /*       gain = 3.1f; */
-      /*       fprintf (stderr, "%f samples %ld\n", gain, a_samples_per_channel); */
-      OMX_S16 *pcm = (OMX_S16 *)(ap_hdr->pBuffer + ap_hdr->nOffset);
-      for (i = 0; i < a_samples_per_channel; i++)
+      OMX_U8 *p_pcm = ap_hdr->pBuffer + ap_hdr->nOffset;
+      const size_t samples
+          = ap_hdr->nFilledLen / tiz_pcm_fmt_size (ap_prc->pcm_fmt_);
+      /* Gain is applied in host byte order */
+      const bool foreign
+          = !tiz_pcm_is_native_endian (ap_prc->pcmmode.eEndian);
+      if (foreign)
+        {
+          tiz_pcm_swap (p_pcm, samples, ap_prc->pcm_fmt_);
+        }
+      tiz_pcm_gain (p_pcm, samples, ap_prc->pcm_fmt_, ap_prc->gain_factor_);
+      if (foreign)
         {
-          float f = sint_to_float (*pcm);
-          f *= gain;
-          int v = float_to_sint (f);
-          *(pcm++) = (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
-          f = sint_to_float (*pcm);
-          f *= gain;
-          v = float_to_sint (f);
-          *(pcm++) = (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
+          tiz_pcm_swap (p_pcm, samples, ap_prc->pcm_fmt_);
         }
     }
 }
 
-static void swap_byte_order_s16 (const ar_prc_t *ap_prc, OMX_BUFFERHEADERTYPE *ap_hdr,
-                                 const int a_samples)
-{
-  assert (ap_prc);
-  assert (ap_hdr);
-  assert (ap_hdr->pBuffer);
-
-  {
-    OMX_S16 *p_pcm = (OMX_S16 *)(ap_hdr->pBuffer + ap_hdr->nOffset);
-    int i = 0;
-    for (i = 0; i < a_samples; ++i)
-      {
-        *p_pcm = bswap_16(*p_pcm);
-        p_pcm++;
-      }
-  }
-}
-
 static void swap_byte_order (const ar_prc_t *ap_prc,
                              OMX_BUFFERHEADERTYPE *ap_hdr)
 {
@@ -466,8 +458,8 @@ static void swap_byte_order (const ar_prc_t *ap_prc,
 
   if (ap_prc->swap_byte_order_ && !ap_hdr->nOffset)
     {
-      const int bytes_per_sample = ap_prc->pcmmode.nBitPerSample / 8;
-      const int samples = ap_hdr->nFilledLen / bytes_per_sample;
+      const int samples
+          = ap_hdr->nFilledLen / tiz_pcm_fmt_size (ap_prc->pcm_fmt_);
       TIZ_DEBUG (handleOf (ap_prc),
                  "nBitPerSample = [%d] "
                  "nFilledLen = [%d] "
@@ -475,19 +467,8 @@ static void swap_byte_order (const ar_prc_t *ap_prc,
                  "nOffset = [%d]",
                  ap_prc->pcmmode.nBitPerSample, ap_hdr->nFilledLen, samples,
                  ap_hdr->nOffset);
-
-      switch (ap_prc->pcmmode.nBitPerSample)
-        {
-        case 16:
-          {
-            swap_byte_order_s16 (ap_prc, ap_hdr, samples);
-          }
-          break;
-        default:
-          {
-          }
-          break;
-        };
+      tiz_pcm_swap (ap_hdr->pBuffer + ap_hdr->nOffset, samples,
+                    ap_prc->pcm_fmt_);
     }
 }
 
@@ -744,7 +725,7 @@ static OMX_ERRORTYPE render_buffer (ar_prc_t *ap_prc,
   assert (ap_hdr->nFilledLen > 0);
   samples_per_channel = ap_hdr->nFilledLen / step;
 
-  adjust_gain (ap_prc, ap_hdr, samples_per_channel);
+  adjust_gain (ap_prc, ap_hdr);
   swap_byte_order (ap_prc, ap_hdr);
 
   while (samples_per_channel > 0 && OMX_ErrorNone == rc)
@@ -884,6 +865,8 @@ static void *ar_prc_ctor (void *ap_prc, va_list *app)
   p_prc->awaiting_io_ev_ = false;
   p_prc->nflags_ = 0;
   p_prc->gain_ = ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE;
+  p_prc->gain_factor_ = tiz_pcm_db_to_gain (p_prc->gain_);
+  p_prc->pcm_fmt_ = ETIZPcmFmtS16;
   p_prc->volume_ = ARATELIA_AUDIO_RENDERER_DEFAULT_VOLUME_VALUE;
   p_prc->ramp_enabled_ = false;
   p_prc->ramp_step_ = 0;
@@ -910,6 +893,7 @@ static OMX_ERRORTYPE ar_prc_allocate_resources (void *ap_prc,
   assert (p_prc);
 
   snd_lib_error_set_handler (alsa_error_handler);
+  load_gain (p_prc);
 
   if (!p_prc->p_pcm_)
     {
@@ -48,6 +48,7 @@ extern "C"
     /* Object */
     const tiz_prc_t _;
     OMX_AUDIO_PARAM_PCMMODETYPE pcmmode;
+    tiz_pcm_fmt_t pcm_fmt_;
     snd_pcm_t *p_pcm_;
     snd_pcm_hw_params_t *p_hw_params_;
     char *p_pcm_name_;
@@ -63,6 +64,7 @@ extern "C"
     bool awaiting_io_ev_;
     OMX_U32 nflags_;
     float gain_;
+    float gain_factor_; /* gain_, as a linear factor */
     long volume_;
     bool ramp_enabled_;
     long ramp_step_;
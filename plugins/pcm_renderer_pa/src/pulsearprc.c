@@ -163,6 +163,61 @@ ready_to_process (pulsear_prc_t * ap_prc)
           && !ap_prc->port_disabled_ && !ap_prc->stopped_);
 }
 
+static void
+load_gain (pulsear_prc_t * ap_prc)
+{
+  const char * p_gain = NULL;
+
+  assert (ap_prc);
+
+  /* Software gain (pre-amp), in dB, applied to every sample before it
+     reaches PulseAudio; the volume is still set on the stream */
+  p_gain = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_renderer.pulseaudio.pcm.gain");
+  ap_prc->gain_ = p_gain ? strtof (p_gain, NULL)
+                         : ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE;
+  if (ap_prc->gain_ < ARATELIA_PCM_RENDERER_MIN_GAIN_VALUE)
+    {
+      ap_prc->gain_ = ARATELIA_PCM_RENDERER_MIN_GAIN_VALUE;
+    }
+  else if (ap_prc->gain_ > ARATELIA_PCM_RENDERER_MAX_GAIN_VALUE)
+    {
+      ap_prc->gain_ = ARATELIA_PCM_RENDERER_MAX_GAIN_VALUE;
+    }
+  ap_prc->gain_factor_ = tiz_pcm_db_to_gain (ap_prc->gain_);
+  if (ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "Software gain [%.2f] dB", ap_prc->gain_);
+    }
+}
+
+static void
+adjust_gain (const pulsear_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  assert (ap_prc);
+  assert (ap_hdr);
+
+  if (ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+    {
+      OMX_U8 * p_pcm = ap_hdr->pBuffer + ap_hdr->nOffset;
+      const size_t samples
+        = ap_hdr->nFilledLen / tiz_pcm_fmt_size (ap_prc->pcm_fmt_);
+      /* PulseAudio takes either byte order, but gain is applied in host
+         byte order */
+      const bool foreign = !tiz_pcm_is_native_endian (ap_prc->pcmmode_.eEndian);
+      if (foreign)
+        {
+          tiz_pcm_swap (p_pcm, samples, ap_prc->pcm_fmt_);
+        }
+      tiz_pcm_gain (p_pcm, samples, ap_prc->pcm_fmt_, ap_prc->gain_factor_);
+      if (foreign)
+        {
+          tiz_pcm_swap (p_pcm, samples, ap_prc->pcm_fmt_);
+        }
+    }
+}
+
 static OMX_BUFFERHEADERTYPE *
 get_header (pulsear_prc_t * ap_prc)
 {
@@ -181,6 +236,7 @@ get_header (pulsear_prc_t * ap_prc)
               TIZ_TRACE (handleOf (ap_prc),
                          "Claimed HEADER [%p]...nFilledLen [%d]",
                          ap_prc->p_inhdr_, ap_prc->p_inhdr_->nFilledLen);
+              adjust_gain (ap_prc, ap_prc->p_inhdr_);
             }
         }
       p_hdr = ap_prc->p_inhdr_;
@@ -545,6 +601,10 @@ init_pulseaudio_sample_spec (pulsear_prc_t * ap_prc, pa_sample_spec * ap_spec)
         ap_prc->pcmmode_.bInterleaved == OMX_TRUE ? "OMX_TRUE" : "OMX_FALSE",
         ap_prc->pcmmode_.ePCMMode);
 
+      /* Anything other than 24 or 32 bits is rendered as S16 (see below) */
+      ap_prc->pcm_fmt_ = ETIZPcmFmtS16;
+      (void) tiz_pcm_fmt_from_pcmmode (&ap_prc->pcmmode_, &ap_prc->pcm_fmt_);
+
       if (ap_prc->pcmmode_.nBitPerSample == 16)
         {
           ap_spec->format = ap_prc->pcmmode_.eEndian == OMX_EndianBig
@@ -975,6 +1035,8 @@ pulsear_prc_ctor (void * ap_prc, va_list * app)
   p_prc->pa_nbytes_ = 0;
   p_prc->p_ev_timer_ = NULL;
   p_prc->gain_ = ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE;
+  p_prc->gain_factor_ = tiz_pcm_db_to_gain (p_prc->gain_);
+  p_prc->pcm_fmt_ = ETIZPcmFmtS16;
   p_prc->volume_ = ARATELIA_PCM_RENDERER_DEFAULT_VOLUME_VALUE;
   p_prc->pending_volume_ = 0;
   p_prc->ramp_enabled_ = false;
@@ -1006,6 +1068,7 @@ pulsear_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
   if (!(p_prc->p_ev_timer_))
     {
       set_volume (ap_prc, p_prc->volume_);
+      load_gain (p_prc);
       tiz_check_omx (tiz_srv_timer_watcher_init (p_prc, &(p_prc->p_ev_timer_)));
       rc = init_pulseaudio (ap_prc);
     }
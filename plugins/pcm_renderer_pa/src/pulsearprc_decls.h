@@ -53,6 +53,7 @@ struct pulsear_prc
   /* Object */
   const tiz_prc_t _;
   OMX_AUDIO_PARAM_PCMMODETYPE pcmmode_;
+  tiz_pcm_fmt_t pcm_fmt_;
   OMX_BUFFERHEADERTYPE *p_inhdr_;
   bool port_disabled_;
   bool paused_;
@@ -65,6 +66,7 @@ struct pulsear_prc
   size_t pa_nbytes_;
   tiz_event_timer_t *p_ev_timer_;
   float gain_;
+  float gain_factor_; /* gain_, as a linear factor */
   long volume_;
   long pending_volume_;
   bool ramp_enabled_;
@@ -50,123 +50,154 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.vorbis_decoder.prc"
 #endif
 
+/* The carry-over store holds this many output buffers worth of PCM, or at
+   least VORBISD_SPILL_MIN_SIZE bytes (enough for a few long Vorbis blocks
+   at 8 channels) */
+#define VORBISD_SPILL_BUFFERS 4
+#define VORBISD_SPILL_MIN_SIZE (256 * 1024)
+
+#define VORBISD_MAX_MAPPED_CHANNELS 8
+
 /* Forward declarations */
 static OMX_ERRORTYPE
 vorbisd_prc_deallocate_resources (void *);
 
 static OMX_ERRORTYPE
-alloc_temp_data_store (vorbisd_prc_t * ap_prc)
+alloc_spill (vorbisd_prc_t * ap_prc)
 {
   OMX_PARAM_PORTDEFINITIONTYPE port_def;
   assert (ap_prc);
-  if (!ap_prc->p_store_)
+  if (!ap_prc->p_spill_)
     {
-      port_def.nSize = (OMX_U32) sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
-      port_def.nVersion.nVersion = OMX_VERSION;
-      port_def.nPortIndex = ARATELIA_VORBIS_DECODER_INPUT_PORT_INDEX;
-
+      TIZ_INIT_OMX_PORT_STRUCT (port_def,
+                                ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX);
       tiz_check_omx (tiz_api_GetParameter (
         tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
         OMX_IndexParamPortDefinition, &port_def));
-
-      assert (ap_prc->p_store_ == NULL);
-      ap_prc->store_size_ = port_def.nBufferSize;
-      tiz_check_null_ret_oom (
-        (ap_prc->p_store_ = tiz_mem_alloc (ap_prc->store_size_)) != NULL);
+      /* The unit (the PCM frame size) is set once the stream info is known */
+      tiz_check_omx (tiz_filter_spill_init (
+        &(ap_prc->p_spill_),
+        MAX (VORBISD_SPILL_BUFFERS * port_def.nBufferSize,
+             VORBISD_SPILL_MIN_SIZE),
+        1));
     }
   return OMX_ErrorNone;
 }
 
-static inline void
-dealloc_temp_data_store (
-  /*@special@ */ vorbisd_prc_t * ap_prc)
-/*@releases ap_prc->p_store_@ */
-/*@ensures isnull ap_prc->p_store_@ */
+static void
+dealloc_spill (vorbisd_prc_t * ap_prc)
 {
   assert (ap_prc);
-  tiz_mem_free (ap_prc->p_store_);
-  ap_prc->p_store_ = NULL;
-  ap_prc->store_size_ = 0;
-  ap_prc->store_offset_ = 0;
+  if (ap_prc->p_spill_)
+    {
+      tiz_filter_spill_stats_t stats;
+      tiz_filter_spill_get_stats (ap_prc->p_spill_, &stats);
+      TIZ_DEBUG (handleOf (ap_prc),
+                 "spill : capacity [%zu] high water [%zu] carry-overs [%u] "
+                 "spilled [%llu] drained [%llu] dropped [%llu]",
+                 stats.capacity, stats.high_water, stats.nspills,
+                 (unsigned long long) stats.nbytes_spilled,
+                 (unsigned long long) stats.nbytes_drained,
+                 (unsigned long long) stats.nbytes_dropped);
+      tiz_filter_spill_destroy (ap_prc->p_spill_);
+      ap_prc->p_spill_ = NULL;
+    }
 }
 
-static inline OMX_U8 **
-get_store_ptr (vorbisd_prc_t * ap_prc)
+static OMX_ERRORTYPE
+release_output_header (vorbisd_prc_t * ap_prc)
 {
+  OMX_BUFFERHEADERTYPE * p_out = NULL;
   assert (ap_prc);
-  return &(ap_prc->p_store_);
+  p_out = tiz_filter_prc_get_header (ap_prc,
+                                     ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX);
+  if (p_out)
+    {
+      /* EOS must wait until all the carried-over PCM has gone out */
+      if (tiz_filter_prc_is_eos (ap_prc)
+          && 0 == tiz_filter_spill_available (ap_prc->p_spill_))
+        {
+          p_out->nFlags |= OMX_BUFFERFLAG_EOS;
+          tiz_filter_prc_update_eos_flag (ap_prc, false);
+          TIZ_TRACE (handleOf (ap_prc), "Propagating EOS flag to output");
+        }
+      return tiz_filter_prc_release_header (
+        ap_prc, ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX);
+    }
+  return OMX_ErrorNone;
 }
 
-static inline OMX_U32 *
-get_store_size_ptr (vorbisd_prc_t * ap_prc)
+static inline size_t
+pcm_frame_len (const vorbisd_prc_t * ap_prc)
 {
   assert (ap_prc);
-  return &(ap_prc->store_size_);
+  return sizeof (float) * MAX (1, ap_prc->fsinfo_.channels);
 }
 
-static inline OMX_U32 *
-get_store_offset_ptr (vorbisd_prc_t * ap_prc)
+/* Output headers are held across decode callbacks (and input buffers) until
+ * they can't take another PCM frame. A partially filled header goes out at
+ * EOS, or when the port is flushed, disabled or stopped. */
+static OMX_ERRORTYPE
+release_output_header_if_full (vorbisd_prc_t * ap_prc)
 {
+  OMX_BUFFERHEADERTYPE * p_out = NULL;
   assert (ap_prc);
-  return &(ap_prc->store_offset_);
+  p_out = tiz_filter_prc_get_header (ap_prc,
+                                     ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX);
+  if (p_out && TIZ_OMX_BUF_AVAIL (p_out) < pcm_frame_len (ap_prc))
+    {
+      return release_output_header (ap_prc);
+    }
+  return OMX_ErrorNone;
 }
 
-static int
-store_data (vorbisd_prc_t * ap_prc, const OMX_U8 * ap_data, OMX_U32 a_nbytes)
+static OMX_ERRORTYPE
+drain_spill (vorbisd_prc_t * ap_prc)
 {
-  OMX_U8 ** pp_store = NULL;
-  OMX_U32 * p_offset = NULL;
-  OMX_U32 * p_size = NULL;
-  OMX_U32 nbytes_to_copy = 0;
-  OMX_U32 nbytes_avail = 0;
-
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_BUFFERHEADERTYPE * p_out = NULL;
   assert (ap_prc);
-  assert (ap_data);
-
-  pp_store = get_store_ptr (ap_prc);
-  p_size = get_store_size_ptr (ap_prc);
-  p_offset = get_store_offset_ptr (ap_prc);
-
-  assert (pp_store && *pp_store);
-  assert (p_size);
-  assert (p_offset);
-
-  nbytes_avail = *p_size - *p_offset;
-
-  if (a_nbytes > nbytes_avail)
+  while (OMX_ErrorNone == rc
+         && tiz_filter_spill_available (ap_prc->p_spill_) > 0
+         && (p_out = tiz_filter_prc_get_header (
+               ap_prc, ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX)))
     {
-      /* need to re-alloc */
-      OMX_U8 * p_new_store = NULL;
-      p_new_store = tiz_mem_realloc (*pp_store, *p_offset + a_nbytes);
-      if (p_new_store)
-        {
-          *pp_store = p_new_store;
-          *p_size = *p_offset + a_nbytes;
-          nbytes_avail = *p_size - *p_offset;
-          TIZ_TRACE (handleOf (ap_prc),
-                     "Realloc'd data store "
-                     "to new size [%d]",
-                     *p_size);
-        }
+      (void) tiz_filter_spill_scatter (ap_prc->p_spill_, &p_out, 1, NULL, 0);
+      rc = release_output_header_if_full (ap_prc);
     }
-  nbytes_to_copy = MIN (nbytes_avail, a_nbytes);
-  memcpy (*pp_store + *p_offset, ap_data, nbytes_to_copy);
-  *p_offset += nbytes_to_copy;
-
-  TIZ_TRACE (handleOf (ap_prc), "bytes currently stored [%d]", *p_offset);
-
-  return a_nbytes - nbytes_to_copy;
+  return rc;
 }
 
-static inline void
-write_frame_float_ilv (float * to, const float * from, const int channels)
+static void
+set_channel_mapping (OMX_AUDIO_CHANNELTYPE * ap_map, const OMX_U32 a_nch)
 {
-  int i = 0;
-  assert (to);
-  assert (from);
-  for (i = 0; i < channels; ++i)
+  /* The decoded channels are reordered from the Vorbis I order into the WAVE
+     order (see tiz_pcm_vorbis_to_wave_order), which is FLAC's, and the one
+     the renderers expect */
+  static const OMX_AUDIO_CHANNELTYPE maps[VORBISD_MAX_MAPPED_CHANNELS]
+                                         [VORBISD_MAX_MAPPED_CHANNELS]
+    = {{OMX_AUDIO_ChannelCF},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelLR,
+        OMX_AUDIO_ChannelRR},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLFE, OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLFE, OMX_AUDIO_ChannelCS, OMX_AUDIO_ChannelLS,
+        OMX_AUDIO_ChannelRS},
+       {OMX_AUDIO_ChannelLF, OMX_AUDIO_ChannelRF, OMX_AUDIO_ChannelCF,
+        OMX_AUDIO_ChannelLFE, OMX_AUDIO_ChannelLR, OMX_AUDIO_ChannelRR,
+        OMX_AUDIO_ChannelLS, OMX_AUDIO_ChannelRS}};
+  OMX_U32 i = 0;
+  assert (ap_map);
+  for (i = 0; i < OMX_AUDIO_MAXCHANNELS; ++i)
     {
-      to[i] = from[i];
+      ap_map[i] = (a_nch <= VORBISD_MAX_MAPPED_CHANNELS && i < a_nch)
+                    ? maps[a_nch - 1][i]
+                    : OMX_AUDIO_ChannelNone;
     }
 }
 
@@ -186,6 +217,7 @@ update_pcm_mode (vorbisd_prc_t * ap_prc, const OMX_U32 a_samplerate,
                  ap_prc->pcmmode_.nChannels, a_channels);
       ap_prc->pcmmode_.nSamplingRate = a_samplerate;
       ap_prc->pcmmode_.nChannels = a_channels;
+      set_channel_mapping (ap_prc->pcmmode_.eChannelMapping, a_channels);
       tiz_check_omx (tiz_krn_SetParameter_internal (
         tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
         OMX_IndexParamAudioPcm, &(ap_prc->pcmmode_)));
@@ -299,78 +331,81 @@ fishsound_decoded_callback (FishSound * ap_fsound, float * app_pcm[],
       p_prc->started_ = true;
       fish_sound_command (p_prc->p_fsnd_, FISH_SOUND_GET_INFO,
                           &(p_prc->fsinfo_), sizeof (FishSoundInfo));
-      if (p_prc->fsinfo_.channels > 2
+      if (p_prc->fsinfo_.channels <= 0
+          || p_prc->fsinfo_.channels > OMX_AUDIO_MAXCHANNELS
           || p_prc->fsinfo_.format != FISH_SOUND_VORBIS)
         {
           TIZ_ERROR (handleOf (p_prc),
-                     "Supported Vorbis "
-                     "streams up tp 2 channels only.");
+                     "Unsupported Vorbis stream : [%d] channels.",
+                     p_prc->fsinfo_.channels);
           rc = FISH_SOUND_STOP_ERR;
           goto end;
         }
       TIZ_NOTICE (handleOf (p_prc), "Channels [%d] sampling rate [%d]",
                   p_prc->fsinfo_.channels, p_prc->fsinfo_.samplerate);
       store_stream_metadata (p_prc);
+      tiz_filter_spill_set_unit (p_prc->p_spill_,
+                                 sizeof (float) * p_prc->fsinfo_.channels);
       (void) update_pcm_mode (p_prc, p_prc->fsinfo_.samplerate,
                               p_prc->fsinfo_.channels);
     }
 
-  p_out = tiz_filter_prc_get_header (p_prc,
-                                     ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX);
-  if (NULL == p_out)
-    {
-      TIZ_TRACE (handleOf (p_prc),
-                 "No more output buffers "
-                 "available at the moment");
-      rc = FISH_SOUND_STOP_OK;
-      goto end;
-    }
-
   {
-    /* write decoded PCM samples */
-    size_t i = 0;
-    size_t frame_len = sizeof (float) * p_prc->fsinfo_.channels;
-    size_t frames_alloc = ((p_out->nAllocLen - p_out->nOffset) / frame_len);
-    size_t frames_to_write = (frames > frames_alloc) ? frames_alloc : frames;
-    size_t bytes_to_write = frames_to_write * frame_len;
-    assert (p_out);
-
-    for (i = 0; i < frames_to_write; ++i)
+    /* write decoded PCM samples, filling as many output headers as are
+       available, and carry over only what does not fit in them */
+    const size_t nchannels = p_prc->fsinfo_.channels;
+    const size_t frame_len = pcm_frame_len (p_prc);
+    const size_t nframes = frames;
+    size_t nframes_out = 0;
+    const float * planes[OMX_AUDIO_MAXCHANNELS];
+
+    tiz_pcm_vorbis_to_wave_order (planes, (const float * const *) app_pcm,
+                                  nchannels);
+
+    while (nframes_out < nframes
+           && (p_out = tiz_filter_prc_get_header (
+                 p_prc, ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX)))
       {
-        size_t frame_offset = i * frame_len;
-        size_t float_offset = i * p_prc->fsinfo_.channels;
-        float * out
-          = (float *) (p_out->pBuffer + p_out->nOffset + frame_offset);
-        write_frame_float_ilv (out, ((float *) app_pcm) + float_offset,
-                               p_prc->fsinfo_.channels);
+        /* Anything carried over goes first */
+        (void) tiz_filter_spill_scatter (p_prc->p_spill_, &p_out, 1, NULL, 0);
+        if (0 == tiz_filter_spill_available (p_prc->p_spill_))
+          {
+            const size_t n = MIN (nframes - nframes_out,
+                                  TIZ_OMX_BUF_AVAIL (p_out) / frame_len);
+            tiz_pcm_interleave_f32 (
+              (float *) (TIZ_OMX_BUF_PTR (p_out) + p_out->nFilledLen), planes,
+              nchannels, nframes_out, n);
+            p_out->nFilledLen += n * frame_len;
+            nframes_out += n;
+          }
+        if (OMX_ErrorNone != release_output_header_if_full (p_prc))
+          {
+            rc = FISH_SOUND_STOP_ERR;
+            goto end;
+          }
       }
-    p_out->nFilledLen += bytes_to_write;
-    p_out->nOffset += bytes_to_write;
 
-    if (frames_to_write < frames)
+    if (nframes_out < nframes)
       {
-        /* Temporarily store the data until an omx buffer is
-         * available */
-        OMX_U32 nbytes_remaining = (frames - frames_to_write) * frame_len;
-        TIZ_TRACE (handleOf (p_prc), "Need to store [%d] bytes",
-                   nbytes_remaining);
-        nbytes_remaining = store_data (
-          p_prc, (OMX_U8 *) (app_pcm[frames_to_write * sizeof (float)]),
-          nbytes_remaining);
+        /* Interleave the rest straight into the carry-over store, until an
+         * omx buffer is available */
+        size_t avail = 0;
+        void * p_span = tiz_filter_spill_reserve (
+          p_prc->p_spill_, (nframes - nframes_out) * frame_len, &avail);
+        TIZ_TRACE (handleOf (p_prc),
+                   "No more output buffers available at the moment - "
+                   "need to store [%zu] bytes",
+                   (nframes - nframes_out) * frame_len);
+        if (p_span)
+          {
+            tiz_pcm_interleave_f32 (p_span, planes, nchannels, nframes_out,
+                                    avail / frame_len);
+            (void) tiz_filter_spill_commit (p_prc->p_spill_, avail);
+          }
       }
 
-    if (tiz_filter_prc_is_eos (p_prc))
-      {
-        /* Propagate EOS flag to output */
-        p_out->nFlags |= OMX_BUFFERFLAG_EOS;
-        tiz_filter_prc_update_eos_flag (p_prc, false);
-        TIZ_TRACE (handleOf (p_prc), "Propagating EOS flag to output");
-      }
-    /* TODO: Shouldn't ignore this rc */
-    (void) tiz_filter_prc_release_header (
-      p_prc, ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX);
-    /* Let's process one input buffer at a time, for now */
-    rc = FISH_SOUND_STOP_OK;
+    /* Keep decoding; the whole input buffer is consumed in one go */
+    rc = FISH_SOUND_CONTINUE;
   }
 
 end:
@@ -388,15 +423,16 @@ init_vorbis_decoder (vorbisd_prc_t * ap_prc)
       ap_prc->p_fsnd_ = fish_sound_new (FISH_SOUND_DECODE, &(ap_prc->fsinfo_));
       tiz_check_null_ret_oom (ap_prc->p_fsnd_ != NULL);
 
-      if (0 != fish_sound_set_interleave (ap_prc->p_fsnd_, 1))
+      /* Decoded channels are interleaved by tiz_pcm_interleave_f32 */
+      if (0 != fish_sound_set_interleave (ap_prc->p_fsnd_, 0))
         {
           TIZ_ERROR (handleOf (ap_prc),
                      "[OMX_ErrorInsufficientResources] : "
-                     "Could not set interleaved.");
+                     "Could not set non-interleaved.");
           goto end;
         }
 
-      if (0 != fish_sound_set_decoded_float_ilv (
+      if (0 != fish_sound_set_decoded_float (
                  ap_prc->p_fsnd_, fishsound_decoded_callback, ap_prc))
         {
           TIZ_ERROR (handleOf (ap_prc),
@@ -447,10 +483,9 @@ transform_buffer (vorbisd_prc_t * ap_prc)
         {
           /* Inmediately propagate EOS flag to output */
           TIZ_TRACE (handleOf (ap_prc), "Let's propagate EOS flag to output");
-          p_out->nFlags |= OMX_BUFFERFLAG_EOS;
+          tiz_filter_prc_update_eos_flag (ap_prc, true);
           p_in->nFlags &= ~(1 << OMX_BUFFERFLAG_EOS);
-          tiz_check_omx (tiz_filter_prc_release_header (
-            ap_prc, ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX));
+          tiz_check_omx (release_output_header (ap_prc));
         }
     }
   /*   raise(SIGTRAP); */
@@ -545,10 +580,9 @@ reset_stream_parameters (vorbisd_prc_t * ap_prc)
       fish_sound_reset (ap_prc->p_fsnd_);
     }
   tiz_mem_set (&(ap_prc->fsinfo_), 0, sizeof (FishSoundInfo));
-  if (ap_prc->p_store_)
+  if (ap_prc->p_spill_)
     {
-      tiz_mem_set (ap_prc->p_store_, 0, ap_prc->store_size_);
-      ap_prc->store_offset_ = 0;
+      tiz_filter_spill_clear (ap_prc->p_spill_);
     }
 }
 
@@ -576,9 +610,7 @@ vorbisd_prc_ctor (void * ap_obj, va_list * app)
   assert (p_prc);
   p_prc->p_fsnd_ = NULL;
   p_prc->started_ = false;
-  p_prc->p_store_ = NULL;
-  p_prc->store_size_ = 0;
-  p_prc->store_offset_ = 0;
+  p_prc->p_spill_ = NULL;
   return p_prc;
 }
 
@@ -596,7 +628,7 @@ vorbisd_prc_dtor (void * ap_obj)
 static OMX_ERRORTYPE
 vorbisd_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
 {
-  tiz_check_omx (alloc_temp_data_store (ap_obj));
+  tiz_check_omx (alloc_spill (ap_obj));
   return init_vorbis_decoder (ap_obj);
 }
 
@@ -610,7 +642,7 @@ vorbisd_prc_deallocate_resources (void * ap_obj)
       fish_sound_delete (p_prc->p_fsnd_);
       p_prc->p_fsnd_ = NULL;
     }
-  dealloc_temp_data_store (p_prc);
+  dealloc_spill (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -658,22 +690,24 @@ vorbisd_prc_buffers_ready (const void * ap_obj)
   TIZ_TRACE (handleOf (p_prc), "eos [%s] avail [%s]",
              tiz_filter_prc_is_eos (p_prc) ? "YES" : "NO",
              tiz_filter_prc_headers_available (p_prc) ? "YES" : "NO");
-  while (tiz_filter_prc_headers_available (p_prc) && OMX_ErrorNone == rc)
+  /* Carried-over PCM goes out before any more input is decoded. Then decode
+     ahead, as long as there are input buffers and room for the PCM in output
+     headers */
+  rc = drain_spill (p_prc);
+  while (OMX_ErrorNone == rc && 0 == tiz_filter_spill_available (p_prc->p_spill_)
+         && tiz_filter_prc_headers_available (p_prc))
     {
       rc = transform_buffer (p_prc);
+      if (OMX_ErrorNone == rc)
+        {
+          rc = drain_spill (p_prc);
+        }
     }
 
-  if (tiz_filter_prc_is_eos (p_prc))
+  if (OMX_ErrorNone == rc && tiz_filter_prc_is_eos (p_prc)
+      && 0 == tiz_filter_spill_available (p_prc->p_spill_))
     {
-      OMX_BUFFERHEADERTYPE * p_out = tiz_filter_prc_get_header (
-        p_prc, ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX);
-      if (p_out)
-        {
-          p_out->nFlags |= OMX_BUFFERFLAG_EOS;
-          tiz_filter_prc_update_eos_flag (p_prc, false);
-          tiz_check_omx (tiz_filter_prc_release_header (
-            p_prc, ARATELIA_VORBIS_DECODER_OUTPUT_PORT_INDEX));
-        }
+      rc = release_output_header (p_prc);
     }
   return rc;
 }
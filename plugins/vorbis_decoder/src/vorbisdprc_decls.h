@@ -48,9 +48,7 @@ struct vorbisd_prc
   FishSoundInfo fsinfo_;
   OMX_AUDIO_PARAM_PCMMODETYPE pcmmode_;
   bool started_;
-  OMX_U8 * p_store_;
-  OMX_U32 store_size_;
-  OMX_U32 store_offset_;
+  tiz_filter_spill_t * p_spill_;
 };
 
 typedef struct vorbisd_prc_class vorbisd_prc_class_t;